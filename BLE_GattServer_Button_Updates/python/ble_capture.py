@@ -0,0 +1,81 @@
+import struct
+import sys
+
+from bluepy import btle
+
+CAPTURE_UUID = btle.UUID('66666666-bc75-4741-8a26-264af75807de')
+COMMAND_UUID = btle.UUID('44444444-bc75-4741-8a26-264af75807de')
+
+# encode_capture_chunk() of lab-utils/sensors/TriggerCapture.h
+SOURCES = {1: 'threshold', 2: 'button', 3: 'command'}
+DESCRIPTOR = struct.Struct('<HBBBBHHIIII')
+
+
+class CaptureDelegate(btle.DefaultDelegate):
+    """Puts the chunks of each burst together and writes it out as a trace.
+
+    The lines are those of ingest/'s capture replay: a burst line, then
+    T,X,Y,Z per sample.
+    """
+
+    def __init__(self, output):
+        btle.DefaultDelegate.__init__(self)
+        self.output = output
+        self.burst = None
+
+    def handleNotification(self, handle, data):
+        index, = struct.unpack_from('<H', data)
+        if index == 0:
+            (_, sequence, source, channels, _, pre, length,
+             requested_us, trigger_us, first_us, period_ns) = DESCRIPTOR.unpack_from(data)
+            self.burst = dict(sequence=sequence, source=SOURCES.get(source, source), channels=channels,
+                              pre=pre, length=length, requested_us=requested_us, trigger_us=trigger_us,
+                              first_us=first_us, period_ns=period_ns, values=[], next=1)
+            return
+        burst = self.burst
+        if burst is None or index != burst['next']:
+            # joined in the middle, or a chunk missing: wait for the next burst
+            print('capture: chunk %u out of place, burst dropped' % index, file=sys.stderr)
+            self.burst = None
+            return
+        burst['next'] += 1
+        burst['values'] += struct.unpack_from('<%dh' % ((len(data) - 2) // 2), data, 2)
+        if len(burst['values']) >= burst['length'] * burst['channels']:
+            self.write(burst)
+            self.burst = None
+
+    def write(self, burst):
+        last_us = burst['first_us'] + (burst['length'] - 1) * burst['period_ns'] // 1000
+        print('burst,%u,%s,%u,%u,%u,%u,%u,%u' % (burst['sequence'], burst['source'], burst['pre'], burst['length'],
+                                                 burst['requested_us'], burst['trigger_us'], burst['first_us'],
+                                                 last_us), file=self.output)
+        channels = burst['channels']
+        for i in range(burst['length']):
+            sample = burst['values'][i * channels:(i + 1) * channels]
+            time_us = burst['first_us'] + i * burst['period_ns'] // 1000
+            print('%u,%s' % (time_us, ','.join(str(v) for v in sample)), file=self.output)
+        self.output.flush()
+        print('capture %u (%s): %u + %u samples' % (burst['sequence'], burst['source'], burst['pre'],
+                                                   burst['length'] - burst['pre']), file=sys.stderr)
+
+
+# Initialisation  -------
+# ble_capture.py [ADDRESS [FILE [--now]]]: bursts to FILE, stdout by
+# default; --now asks for one with a capture command first
+addr = sys.argv[1] if len(sys.argv) > 1 else 'e9:64:4f:e1:21:11'
+output = open(sys.argv[2], 'w') if len(sys.argv) > 2 else sys.stdout
+conn = btle.Peripheral(addr, btle.ADDR_TYPE_RANDOM)
+conn.setMTU(247)
+conn.setDelegate(CaptureDelegate(output))
+
+ch = conn.getCharacteristics(uuid=CAPTURE_UUID)[0]
+conn.writeCharacteristic(ch.getHandle() + 1, b'\x01\x00', withResponse=True)
+commands = conn.getCharacteristics(uuid=COMMAND_UUID)[0]
+
+if len(sys.argv) > 3 and sys.argv[3] == '--now':
+    # sequence 0, one CAPTURE command
+    commands.write(bytes([0, 5]), withResponse=False)
+
+# Main loop --------
+while True:
+    conn.waitForNotifications(1.0)
@@ -0,0 +1,74 @@
+import struct
+import sys
+import time
+
+from bluepy import btle
+
+COMMAND_UUID = btle.UUID('44444444-bc75-4741-8a26-264af75807de')
+
+# opcodes of lab-utils/ble/CommandProtocol.h
+LED, BLINK, PWM, REGISTERS, CAPTURE = 1, 2, 3, 4, 5
+RESULTS = {0: 'ok', 1: 'partial', 2: 'malformed'}
+
+
+def led(index, on):
+    return struct.pack('<BBB', LED, index, 1 if on else 0)
+
+
+def blink(index, on_ms, off_ms, count=0):
+    return struct.pack('<BBBBB', BLINK, index, on_ms // 10, off_ms // 10, count)
+
+
+def pwm(channel, per_mille):
+    return struct.pack('<BBH', PWM, channel, per_mille)
+
+
+def registers(first, values):
+    return struct.pack('<BBB', REGISTERS, first, len(values)) + bytes(values)
+
+
+def capture():
+    # with trigger-capture, see ble_capture.py
+    return struct.pack('<B', CAPTURE)
+
+
+class StatusDelegate(btle.DefaultDelegate):
+    """Prints the status the board answers each packet with."""
+
+    def handleNotification(self, handle, data):
+        sequence, result, applied, failed, error, packets = struct.unpack('<BBBBBH', data)
+        print('packet %u: %s, %u applied, %u taken in all' % (sequence, RESULTS.get(result, result), applied, packets))
+        if result != 0:
+            print('    command %u failed (%u)' % (failed, error))
+
+
+# Initialisation  -------
+addr = sys.argv[1] if len(sys.argv) > 1 else 'e9:64:4f:e1:21:11'
+conn = btle.Peripheral(addr, btle.ADDR_TYPE_RANDOM)
+# a packet holds up to att_mtu - 3 bytes of commands
+mtu = 247
+conn.setMTU(mtu)
+conn.setDelegate(StatusDelegate())
+
+ch = conn.getCharacteristics(uuid=COMMAND_UUID)[0]
+# subscribe to the statuses
+conn.writeCharacteristic(ch.getHandle() + 1, b'\x01\x00', withResponse=True)
+
+# Main loop --------
+# a fade of the PWM LED and LED1 toggling, many commands per write and
+# no round trip per write: the statuses come back as notifications, a
+# newer one replacing one not sent yet
+sequence = 0
+level = 0
+while True:
+    packet = bytearray([sequence])
+    for step in range(8):
+        level = (level + 25) % 1000
+        command = pwm(0, level) + led(0, step % 2)
+        if len(packet) + len(command) > mtu - 3:
+            break
+        packet += command
+    ch.write(bytes(packet), withResponse=False)
+    sequence = (sequence + 1) % 256
+    conn.waitForNotifications(0.05)
+    time.sleep(0.05)
@@ -0,0 +1,27 @@
+import os
+import sys
+import time
+
+from bluepy import btle
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', 'lab-utils', 'metrics'))
+import metrics  # noqa: E402
+
+METRICS_UUID = btle.UUID('33333333-bc75-4741-8a26-264af75807de')
+
+# Initialisation  -------
+addr = sys.argv[1] if len(sys.argv) > 1 else 'e9:64:4f:e1:21:11'
+conn = btle.Peripheral(addr, btle.ADDR_TYPE_RANDOM)
+# the snapshot is up to 244 bytes, more than a default 23 byte MTU read
+conn.setMTU(185)
+
+ch = conn.getCharacteristics(uuid=METRICS_UUID)[0]
+aggregator = metrics.MetricsAggregator()
+
+# Main loop --------
+# one snapshot every 5 s, the device refreshes it once a second
+while True:
+    aggregator.update(addr, metrics.decode(ch.read()))
+    print(aggregator.report())
+    time.sleep(5)
@@ -22,12 +22,31 @@
 #include "events/EventQueue.h"
 #include "ble/BLE.h"
 #include "gatt_server_process.h"
+#include "hal/us_ticker_api.h"
 #include "pretty_printer.h"
 #include <cstdint>
 #include <cstdio>
 #include <mbed.h>
 #include <functional>
 
+#include "BootProfile.h"
+#include "CommandProtocol.h"
+#include "ConnectionManager.h"
+#include "DeferredLog.h"
+#include "GattFanout.h"
+#include "LogThread.h"
+#include "Metrics.h"
+#include "MultiCentralProcess.h"
+
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+#if !defined(TARGET_DISCO_L475VG_IOT01A)
+#error "trigger-capture reads the LSM6DSL of the DISCO_L475VG_IOT01A"
+#endif
+#include "I2cRegisterBus.h"
+#include "Lsm6dslFifo.h"
+#include "TriggerCapture.h"
+#endif
+
 static BufferedSerial serial_port(USBTX, USBRX);
 
 FileHandle *mbed::mbed_override_console(int fd)
@@ -35,9 +54,23 @@ FileHandle *mbed::mbed_override_console(int fd)
     return &serial_port; 
 }
 
+static lab::LogThread log_thread(serial_port);
+
 using mbed::callback;
 using namespace std::literals::chrono_literals;
 
+static lab::Counter button_events("button.events");
+static lab::Counter notify_sent("ble.notify_sent");
+static lab::Counter notify_errors("ble.notify_errors");
+static lab::Counter client_reads("ble.reads");
+static lab::Counter command_packets("cmd.packets");
+static const uint32_t hold_bounds_ms[] = { 100, 300, 1000, 3000 };
+static lab::Histogram<4> button_hold("button.hold_ms", hold_bounds_ms);
+static lab::Gauge link_interval("ble.interval_us");
+static lab::Gauge link_phy("ble.phy");
+static lab::Gauge link_data_length("ble.data_length");
+static lab::Gauge link_mtu("ble.att_mtu");
+
 
 /**
  * A Clock service that demonstrate the GattServer features.
@@ -49,8 +82,18 @@ using namespace std::literals::chrono_literals;
  * A client can subscribe to updates of the clock characteristics and get
  * notified when one of the value is changed. Clients can also change value of
  * the second, minute and hour characteristric.
+ *
+ * The command characteristic takes batches of LED, blink, PWM and
+ * register commands written without response (see CommandProtocol.h)
+ * and answers each packet with one status notification to the writer.
+ *
+ * With trigger-capture the accelerometer runs at 416 Hz into a
+ * TriggerCapture: a shock or a free fall, a button press or a capture
+ * command freezes 256 samples before the event and 768 from it on,
+ * which go out on the capture characteristic in chunks (see
+ * encode_capture_chunk()) while the rest of the service carries on.
  */
-class ButtonService : public ble::GattServer::EventHandler {
+class ButtonService : public ble::GattServer::EventHandler, public lab::CommandTarget {
 public:
     ButtonService() :
         _stu_id_char("12345678-bc75-4741-8a26-264af75807de", *STU_ID),
@@ -61,6 +104,7 @@ public:
                                      sizeof(_stu_id_characteristics[0])
         ),
         _led1(LED1, 1),
+        _pwm(LED2),
         _button(USER_BUTTON, PullUp),
         _button_state("87654321-bc75-4741-8a26-264af75807de", false),
         _button_service(
@@ -79,8 +123,45 @@ public:
         _general_service(
             /* uuid */ "A003",
             /* characteristics */ _general_characteristics,
-            /* numCharacteristics */ 3
+            /* numCharacteristics */ GENERAL_CHARACTERISTICS
+        ),
+        _metrics_char(
+            /* UUID */ "33333333-bc75-4741-8a26-264af75807de",
+            /* Initial value */ _metrics_value,
+            /* Value size */ 0,
+            /* Value capacity */ METRICS_CAPACITY,
+            /* Properties */ GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_READ,
+            /* Descriptors */ nullptr,
+            /* Num descriptors */ 0,
+            /* variable len */ true
+        ),
+        _command_char(
+            /* UUID */ "44444444-bc75-4741-8a26-264af75807de",
+            /* Initial value */ _command_value,
+            /* Value size */ 0,
+            /* Value capacity */ COMMAND_CAPACITY,
+            /* Properties */ GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE |
+                             GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY,
+            /* Descriptors */ nullptr,
+            /* Num descriptors */ 0,
+            /* variable len */ true
         )
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+        ,
+        _capture_char(
+            /* UUID */ "66666666-bc75-4741-8a26-264af75807de",
+            /* Initial value */ _capture_value,
+            /* Value size */ 0,
+            /* Value capacity */ CAPTURE_CHUNK,
+            /* Properties */ GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY,
+            /* Descriptors */ nullptr,
+            /* Num descriptors */ 0,
+            /* variable len */ true
+        ),
+        _imu_i2c(IMU_SDA, IMU_SCL),
+        _imu_bus(_imu_i2c, lab::Lsm6dslFifo::I2C_ADDRESS),
+        _imu_fifo(_imu_bus)
+#endif
     {
         /* update internal pointers (value, descriptors and characteristics array) */
         _stu_id_characteristics[0] = &_stu_id_char;
@@ -91,17 +172,39 @@ public:
         _general_characteristics[0] = &_stu_id_char;
         _general_characteristics[1] = &_button_state;
         _general_characteristics[2] = &_led_state;
+        _general_characteristics[3] = &_metrics_char;
+        _general_characteristics[4] = &_command_char;
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+        _general_characteristics[5] = &_capture_char;
+#endif
         /* setup authorization handlers */
         _led_state.setWriteAuthorizationCallback(this, &ButtonService::led_client_write);
     }
 
+    /** Register with the connection manager and the fanout, before start(). */
+    void attach(lab::ConnectionManager &connections, lab::GattFanout &fanout)
+    {
+        _connections = &connections;
+        _connection_profile = connections.add_service("button", lab::default_connection_policy());
+        _fanout = &fanout;
+        _button_fanout = fanout.add_characteristic(_button_state);
+        _command_fanout = fanout.add_characteristic(_command_char);
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+        // every chunk counts, capture_upload() waits for room instead
+        _capture_fanout = fanout.add_characteristic(_capture_char, false);
+#endif
+    }
+
     void start(BLE &ble, events::EventQueue &event_queue)
     {
         _server = &ble.gattServer();
         _event_queue = &event_queue;
+        // the stack is up, GattServerProcess calls this from its init callback
+        lab::BootProfile::leave("ble-init");
         ble_error_t err;
 
         printf("Registering demo service\r\n");
+        lab::BootProfile::enter("gatt-service");
         // err = _server->addService(_button_service);
         // err = _server->addService(_led_service);
         // err = _server->addService(_stu_id_service);
@@ -112,31 +215,76 @@ public:
             return;
         }
 
-        /* register handlers */
-        _server->setEventHandler(this);
+        /* register handlers, the fanout passes the events on to this */
+        if (_fanout) {
+            _fanout->start();
+        } else {
+            _server->setEventHandler(this);
+        }
+        if (_connections) {
+            _connections->start();
+        }
 
+        lab::BootProfile::leave("gatt-service");
         printf("button service registered\r\n");
+        lab::BootProfile::mark("ready");
+        lab::BootProfile::dump();
         _event_queue->call_every(1000ms, callback(this, &ButtonService::send_std_id));
+        _event_queue->call_every(1000ms, callback(this, &ButtonService::update_metrics));
         // _event_queue->call_every(500ms, this, &ButtonService::blink);
         _button.fall(Callback<void()>(this, &ButtonService::button_pressed));
         _button.rise(Callback<void()>(this, &ButtonService::button_released));
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+        capture_start();
+#endif
     }
 
     void updateButtonState(bool newState) {
+        if (_connections) {
+            _connections->activity(_connection_profile);
+        }
+        if (_fanout) {
+            // each central gets it at its own pace
+            uint8_t value = newState;
+            _fanout->notify(_button_fanout, &value, sizeof(value));
+            return;
+        }
         ble_error_t err = _button_state.set(*_server, newState);
         if (err) {
-            printf("write of the second value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the second value returned error %u", err);
+            notify_errors.inc();
+            return;
+        }
+    }
+
+    /**
+     * Snapshot of all the metrics in the binary layout of MetricsRegistry,
+     * refreshed locally once a second; metrics/ble_metrics.py reads it.
+     */
+    void update_metrics(void) {
+        int length = lab::MetricsRegistry::encode(_metrics_value, METRICS_CAPACITY);
+        if (length < 0) {
+            LAB_LOG_WARN("metrics do not fit %u bytes", (unsigned)METRICS_CAPACITY);
             return;
         }
+        _server->write(_metrics_char.getValueHandle(), _metrics_value, length, true);
     }
 
     void button_pressed(void) {
         // updateButtonState(true);
+        button_events.inc();
+        _pressed_us = us_ticker_read();
         _event_queue->call(this, &ButtonService::updateButtonState, true);
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+        // the capture picks the sample of the press once the FIFO has it
+        _event_queue->call(this, &ButtonService::capture_trigger, lab::CAPTURE_BUTTON, _pressed_us);
+#endif
     }
 
     void button_released(void) {
         // updateButtonState(false);
+        button_events.inc();
+        button_hold.record((us_ticker_read() - _pressed_us) / 1000);
         _event_queue->call(this, &ButtonService::updateButtonState, false);
     }
 
@@ -161,7 +309,8 @@ private:
      */
     void onDataSent(const GattDataSentCallbackParams &params) override
     {
-        printf("sent updates\r\n");
+        LAB_LOG_INFO("sent updates on handle %u", params.attHandle);
+        notify_sent.inc();
     }
 
     /**
@@ -169,10 +318,11 @@ private:
      */
     void onDataWritten(const GattWriteCallbackParams &params) override
     {
-        printf("data written:\r\n");
-        printf("connection handle: %u\r\n", params.connHandle);
-        printf("attribute handle: %u", params.handle);
-        printf("\r\n");
+        if (params.handle == _command_char.getValueHandle()) {
+            command_written(params);
+            return;
+        }
+        LAB_LOG_INFO("data written: connection %u attribute %u", params.connHandle, params.handle);
     }
 
     /**
@@ -180,9 +330,8 @@ private:
      */
     void onDataRead(const GattReadCallbackParams &params) override
     {
-        printf("data read:\r\n");
-        printf("connection handle: %u\r\n", params.connHandle);
-        printf("attribute handle: %u", params.handle);
+        LAB_LOG_INFO("data read: connection %u attribute %u", params.connHandle, params.handle);
+        client_reads.inc();
     }
 
     /**
@@ -223,7 +372,7 @@ private:
         const static uint8_t stu_id[10] = "B07901184";
         ble_error_t err = _stu_id_char.set(*_server, stu_id);
         if (err) {
-            printf("write of the second value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the second value returned error %u", err);
             return;
         }
     }
@@ -251,7 +400,209 @@ private:
 
         e->authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS;
     }
-    
+
+    /**
+     * A packet of commands: applied in order on this thread, then one
+     * status back to the client that wrote it. Write commands get no
+     * answer from the stack, a client that wants to know subscribes.
+     */
+    void command_written(const GattWriteCallbackParams &params)
+    {
+        lab::CommandStatus &status = _command_status;
+        lab::apply_commands(params.data, params.len, *this, status);
+        command_packets.inc();
+        if (_connections) {
+            // a client driving the LEDs wants the short interval too
+            _connections->activity(_connection_profile);
+        }
+        LAB_LOG_INFO("commands %u: result %u, %u applied, first failed %u (%u)", status.sequence, status.result,
+                     status.applied, status.failed, status.error);
+
+        uint8_t answer[lab::COMMAND_STATUS_SIZE];
+        lab::encode_command_status(status, answer);
+        if (_fanout) {
+            // a newer status replaces one still queued, packets counts them all
+            _fanout->notify(_command_fanout, params.connHandle, answer, sizeof(answer));
+        }
+    }
+
+    /* lab::CommandTarget */
+    uint8_t apply(const lab::Command &command) override
+    {
+        switch (command.opcode) {
+            case lab::COMMAND_LED:
+                if (command.target != 0) {
+                    return lab::COMMAND_ERROR_TARGET;
+                }
+                stop_blinking();
+                _led1 = command.value;
+                return lab::COMMAND_OK;
+            case lab::COMMAND_BLINK:
+                if (command.target != 0) {
+                    return lab::COMMAND_ERROR_TARGET;
+                }
+                if (!command.on_ms || !command.off_ms) {
+                    return lab::COMMAND_ERROR_VALUE;
+                }
+                stop_blinking();
+                _blink_on_ms = command.on_ms;
+                _blink_off_ms = command.off_ms;
+                // count on and off phases, 0 blinks for ever
+                _blink_left = command.count * 2;
+                _blink_forever = command.count == 0;
+                blink_step();
+                return lab::COMMAND_OK;
+            case lab::COMMAND_PWM:
+                if (command.target != 0) {
+                    return lab::COMMAND_ERROR_TARGET;
+                }
+                if (command.value > 1000) {
+                    return lab::COMMAND_ERROR_VALUE;
+                }
+                _pwm.write(command.value / 1000.0f);
+                return lab::COMMAND_OK;
+            case lab::COMMAND_REGISTERS:
+                if ((size_t)command.target + command.count > REGISTER_COUNT) {
+                    return lab::COMMAND_ERROR_TARGET;
+                }
+                memcpy(&_registers[command.target], command.data, command.count);
+                return lab::COMMAND_OK;
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+            case lab::COMMAND_CAPTURE:
+                return capture_trigger(lab::CAPTURE_COMMAND, us_ticker_read()) ? lab::COMMAND_ERROR_BUSY
+                                                                               : lab::COMMAND_OK;
+#endif
+            default:
+                return lab::COMMAND_ERROR_TARGET;
+        }
+    }
+
+    void blink_step(void)
+    {
+        _blink_event = 0;
+        if (!_blink_forever && !_blink_left) {
+            return;
+        }
+        _blink_left--;
+        _led1 = !_led1;
+        std::chrono::milliseconds delay(_led1 ? _blink_on_ms : _blink_off_ms);
+        _blink_event = _event_queue->call_in(delay, callback(this, &ButtonService::blink_step));
+    }
+
+    void stop_blinking(void)
+    {
+        if (_blink_event) {
+            _event_queue->cancel(_blink_event);
+            _blink_event = 0;
+        }
+    }
+
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+    void capture_start(void)
+    {
+        _imu_i2c.frequency(400000);
+        lab::Lsm6dslFifoConfig fifo_config;
+        fifo_config.odr = lab::LSM6DSL_ODR_416HZ;
+        fifo_config.watermark = 32;
+        fifo_config.accel_scale = lab::LSM6DSL_ACCEL_4G;
+        fifo_config.gyro_scale = lab::LSM6DSL_GYRO_2000DPS;
+        if (_imu_fifo.configure(fifo_config)) {
+            LAB_LOG_WARN("capture: LSM6DSL FIFO init failed");
+            return;
+        }
+
+        // a shock over 2.5 g or a fall under 0.25 g, in LSB of the 4 g scale
+        float mg = _imu_fifo.accel_mg_per_lsb();
+        lab::CaptureConfig config = {};
+        config.pre_samples = CAPTURE_PRE;
+        config.post_samples = CAPTURE_POST;
+        config.magnitude_channel = 0;
+        config.magnitude_high = (uint16_t)(2500 / mg);
+        config.magnitude_low = (uint16_t)(250 / mg);
+        config.hysteresis = (uint16_t)(200 / mg);
+        _capture.configure(config);
+
+        // 416 Hz puts about 8 sets in the FIFO per drain, it holds 340
+        _event_queue->call_every(std::chrono::milliseconds(CAPTURE_DRAIN_MS),
+                                 callback(this, &ButtonService::capture_tick));
+    }
+
+    /** @return 0, -1 while a burst records or goes out. */
+    int capture_trigger(lab::CaptureSource source, uint32_t timestamp_us)
+    {
+        if (_capture.trigger(source, timestamp_us)) {
+            LAB_LOG_INFO("capture: %s while busy, ignored", lab::capture_source_name(source));
+            return -1;
+        }
+        if (_capture.state() == lab::CAPTURE_FROZEN) {
+            capture_frozen();
+        }
+        return 0;
+    }
+
+    void capture_tick(void)
+    {
+        static lab::ImuSample samples[CAPTURE_DRAIN_SETS];
+        lab::ImuBatch batch;
+
+        int count = _imu_fifo.drain(samples, CAPTURE_DRAIN_SETS, us_ticker_read(), batch);
+        if (count < 0) {
+            LAB_LOG_WARN("capture: FIFO read error");
+            return;
+        }
+        if (batch.overrun) {
+            LAB_LOG_WARN("capture: FIFO overrun");
+        }
+        for (int i = 0; i < count; i++) {
+            if (_capture.push(samples[i].accel, batch.timestamp_us(i))) {
+                capture_frozen();
+            }
+        }
+        capture_upload();
+    }
+
+    void capture_frozen(void)
+    {
+        const lab::CaptureBurst &burst = _capture.burst();
+        LAB_LOG_INFO("capture %u (%s): %u + %u samples, trigger at %u us", (unsigned)burst.sequence,
+                     lab::capture_source_name(burst.source), burst.pre, burst.length - burst.pre,
+                     (unsigned)burst.trigger_us);
+        _capture_chunk = 0;
+        if (_connections) {
+            // the upload wants the short interval
+            _connections->activity(_connection_profile);
+        }
+    }
+
+    /**
+     * The chunks of a frozen burst, as many as every subscriber has room
+     * for, keeping room for the button and command notifications; the
+     * burst goes back to the capture once they are all queued.
+     */
+    void capture_upload(void)
+    {
+        if (_capture.state() != lab::CAPTURE_FROZEN) {
+            return;
+        }
+        unsigned sequence = (unsigned)_capture.burst().sequence;
+        if (!_fanout || !_fanout->subscribers(_capture_fanout)) {
+            LAB_LOG_INFO("capture %u: no subscriber, dropped", sequence);
+            _capture.release();
+            return;
+        }
+        size_t chunks = lab::capture_chunk_count(_capture, CAPTURE_CHUNK);
+        while (_capture_chunk < chunks && _fanout->room(_capture_fanout) > CAPTURE_QUEUE_HEADROOM) {
+            int length = lab::encode_capture_chunk(_capture, _capture_chunk, _capture_value, CAPTURE_CHUNK);
+            _fanout->notify(_capture_fanout, _capture_value, (uint16_t)length);
+            _capture_chunk++;
+        }
+        if (_capture_chunk == chunks) {
+            LAB_LOG_INFO("capture %u: sent in %u notifications", sequence, (unsigned)chunks);
+            _capture.release();
+        }
+    }
+#endif
+
 
 
 private:
@@ -387,6 +738,14 @@ private:
 private:
     GattServer *_server = nullptr;
     events::EventQueue *_event_queue = nullptr;
+    lab::ConnectionManager *_connections = nullptr;
+    int _connection_profile = -1;
+    lab::GattFanout *_fanout = nullptr;
+    int _button_fanout = -1;
+    int _command_fanout = -1;
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+    int _capture_fanout = -1;
+#endif
 
     // student id service and characteristic
     uint8_t STU_ID[10] = "B07901184";
@@ -398,6 +757,7 @@ private:
     // button service and characteristic
     InterruptIn _button;
     DigitalOut  _led1;
+    PwmOut _pwm;
     GattService _button_service;
     GattCharacteristic* _button_characteristics[1];
 
@@ -411,23 +771,91 @@ private:
 
     // try to combine three charateristic into one service
     GattService _general_service;
-    GattCharacteristic* _general_characteristics[3];
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+    static const unsigned GENERAL_CHARACTERISTICS = 6;
+#else
+    static const unsigned GENERAL_CHARACTERISTICS = 5;
+#endif
+    GattCharacteristic* _general_characteristics[GENERAL_CHARACTERISTICS];
+
+    // metrics snapshot, see update_metrics(); a 247 byte ATT MTU reads it in one go
+    static const size_t METRICS_CAPACITY = 244;
+    uint8_t _metrics_value[METRICS_CAPACITY] = {};
+    GattCharacteristic _metrics_char;
+    uint32_t _pressed_us = 0;
+
+    // batched commands, see command_written(); 244 bytes is a 247 byte ATT MTU
+    static const size_t COMMAND_CAPACITY = 244;
+    uint8_t _command_value[COMMAND_CAPACITY] = {};
+    GattCharacteristic _command_char;
+    lab::CommandStatus _command_status = {};
+    static const size_t REGISTER_COUNT = 32;
+    uint8_t _registers[REGISTER_COUNT] = {};
+    int _blink_event = 0;
+    uint16_t _blink_on_ms = 0;
+    uint16_t _blink_off_ms = 0;
+    unsigned _blink_left = 0;
+    bool _blink_forever = false;
+
+#if MBED_CONF_APP_TRIGGER_CAPTURE
+    // 0.6 s before the event and 1.8 s from it on at 416 Hz
+    static const uint16_t CAPTURE_PRE = 256;
+    static const uint16_t CAPTURE_POST = 768;
+    static const unsigned CAPTURE_DRAIN_MS = 20;
+    static const size_t CAPTURE_DRAIN_SETS = 64;
+    // a chunk is a notification of the fanout, 5 samples of 3 axes
+    static const size_t CAPTURE_CHUNK = lab::GattFanout::VALUE_MAX;
+    // a button and a command status may still queue behind the chunks
+    static const size_t CAPTURE_QUEUE_HEADROOM = 2;
+    // the internal I2C2 bus of the on-board sensors, at 400 kHz
+    static const PinName IMU_SDA = PB_11;
+    static const PinName IMU_SCL = PB_10;
+    uint8_t _capture_value[CAPTURE_CHUNK] = {};
+    GattCharacteristic _capture_char;
+    mbed::I2C _imu_i2c;
+    lab::I2cRegisterBus _imu_bus;
+    lab::Lsm6dslFifo _imu_fifo;
+    lab::TriggerCapture<CAPTURE_PRE + CAPTURE_POST, 3> _capture;
+    size_t _capture_chunk = 0;
+#endif
 
     
 
 };
 
+static void report_link(const lab::BleLinkState &link)
+{
+    link_interval.set(link.connected ? link.interval_us : 0);
+    link_phy.set(link.connected ? link.tx_phy : 0);
+    link_data_length.set(link.connected ? link.tx_octets : 0);
+    link_mtu.set(link.connected ? link.att_mtu : 0);
+}
+
 int main() {
+    lab::BootProfile::begin();
+
     BLE &ble = BLE::Instance();
     events::EventQueue event_queue;
     ButtonService demo_service;
 
-    /* this process will handle basic ble setup and advertising for us */
-    GattServerProcess ble_process(event_queue, ble);
+    log_thread.start();
+    lab::BootProfile::mark("log");
+
+    /* this process will handle basic ble setup and advertising for us, for up to 4 centrals */
+    lab::MultiCentralProcess<GattServerProcess> ble_process(event_queue, ble);
+
+    /* button notifications queued per central; Gap events go on to ble_process */
+    lab::GattFanout fanout(ble, &ble_process, &demo_service);
+
+    /* short interval while the button streams, long when idle; Gap events go on to the fanout */
+    lab::ConnectionManager connections(ble, event_queue, &fanout);
+    connections.on_change(report_link);
+    demo_service.attach(connections, fanout);
 
     /* once it's done it will let us continue with our demo */
     ble_process.on_init(callback(&demo_service, &ButtonService::start));
 
+    lab::BootProfile::enter("ble-init");
     ble_process.start();
 
     
@@ -22,6 +22,12 @@
 #include "gatt_server_process.h"
 #include <cstdint>
 
+#include "BootProfile.h"
+#include "DeferredLog.h"
+#include "GattFanout.h"
+#include "LogThread.h"
+#include "MultiCentralProcess.h"
+
 static BufferedSerial serial_port(USBTX, USBRX);
 
 FileHandle *mbed::mbed_override_console(int fd)
@@ -29,6 +35,8 @@ FileHandle *mbed::mbed_override_console(int fd)
     return &serial_port; 
 }
 
+static lab::LogThread log_thread(serial_port);
+
 using mbed::callback;
 using namespace std::literals::chrono_literals;
 
@@ -76,12 +84,24 @@ public:
         _second_char.setWriteAuthorizationCallback(this, &ClockService::authorize_client_write);
     }
 
+    /** Send the clock through the fanout, before start(). */
+    void attach(lab::GattFanout &fanout)
+    {
+        _fanout = &fanout;
+        _hour_fanout = fanout.add_characteristic(_hour_char);
+        _minute_fanout = fanout.add_characteristic(_minute_char);
+        _second_fanout = fanout.add_characteristic(_second_char);
+    }
+
     void start(BLE &ble, events::EventQueue &event_queue)
     {
         _server = &ble.gattServer();
         _event_queue = &event_queue;
+        // the stack is up, GattServerProcess calls this from its init callback
+        lab::BootProfile::leave("ble-init");
 
         printf("Registering demo service\r\n");
+        lab::BootProfile::enter("gatt-service");
         ble_error_t err = _server->addService(_clock_service);
 
         if (err) {
@@ -89,15 +109,24 @@ public:
             return;
         }
 
-        /* register handlers */
-        _server->setEventHandler(this);
+        /* register handlers, the fanout passes the events on to this */
+        if (_fanout) {
+            _fanout->start();
+            // it tracks the connections, then hands the Gap events to ble_process
+            ble.gap().setEventHandler(_fanout);
+        } else {
+            _server->setEventHandler(this);
+        }
 
+        lab::BootProfile::leave("gatt-service");
         printf("clock service registered\r\n");
         printf("service handle: %u\r\n", _clock_service.getHandle());
         printf("hour characteristic value handle %u\r\n", _hour_char.getValueHandle());
         printf("minute characteristic value handle %u\r\n", _minute_char.getValueHandle());
         printf("second characteristic value handle %u\r\n", _second_char.getValueHandle());
 
+        lab::BootProfile::mark("ready");
+        lab::BootProfile::dump();
         _event_queue->call_every(1000ms, callback(this, &ClockService::increment_second));
         // _event_queue->call_every(1000ms, callback(this, &ClockService::send_std_id));
 
@@ -110,7 +139,7 @@ private:
      */
     void onDataSent(const GattDataSentCallbackParams &params) override
     {
-        printf("sent updates\r\n");
+        LAB_LOG_INFO("sent updates on handle %u", params.attHandle);
     }
 
     /**
@@ -118,28 +147,42 @@ private:
      */
     void onDataWritten(const GattWriteCallbackParams &params) override
     {
-        printf("data written:\r\n");
-        printf("connection handle: %u\r\n", params.connHandle);
-        printf("attribute handle: %u", params.handle);
-        if (params.handle == _hour_char.getValueHandle()) {
-            printf(" (hour characteristic)\r\n");
-        } else if (params.handle == _minute_char.getValueHandle()) {
-            printf(" (minute characteristic)\r\n");
-        } else if (params.handle == _second_char.getValueHandle()) {
-            printf(" (second characteristic)\r\n");
-        } else {
-            printf("\r\n");
-        }
-        printf("write operation: %u\r\n", params.writeOp);
-        printf("offset: %u\r\n", params.offset);
-        printf("length: %u\r\n", params.len);
-        printf("data: ");
+        LAB_LOG_INFO("data written: connection %u attribute %u%s",
+                      params.connHandle, params.handle, characteristic_name(params.handle));
+        LAB_LOG_INFO("data written: op %u offset %u len %u",
+                      params.writeOp, params.offset, params.len);
+        log_payload(params.data, params.len);
+    }
 
-        for (size_t i = 0; i < params.len; ++i) {
-            printf("%02X", params.data[i]);
-        }
+    static const uint16_t LOGGED_PAYLOAD = 16;
 
-        printf("\r\n");
+    /**
+     * The first LOGGED_PAYLOAD bytes of a write, four to a record: a log
+     * record holds its arguments, not the buffer they point to.
+     */
+    static void log_payload(const uint8_t *data, uint16_t length)
+    {
+        uint16_t logged = length < LOGGED_PAYLOAD ? length : LOGGED_PAYLOAD;
+        for (uint16_t i = 0; i < logged; i += 4) {
+            const uint8_t *bytes = &data[i];
+            switch (logged - i) {
+                case 1:
+                    LAB_LOG_INFO("data written: [%u] %02X", i, bytes[0]);
+                    break;
+                case 2:
+                    LAB_LOG_INFO("data written: [%u] %02X %02X", i, bytes[0], bytes[1]);
+                    break;
+                case 3:
+                    LAB_LOG_INFO("data written: [%u] %02X %02X %02X", i, bytes[0], bytes[1], bytes[2]);
+                    break;
+                default:
+                    LAB_LOG_INFO("data written: [%u] %02X %02X %02X %02X", i, bytes[0], bytes[1], bytes[2], bytes[3]);
+                    break;
+            }
+        }
+        if (length > logged) {
+            LAB_LOG_INFO("data written: %u more bytes", length - logged);
+        }
     }
 
     /**
@@ -147,18 +190,8 @@ private:
      */
     void onDataRead(const GattReadCallbackParams &params) override
     {
-        printf("data read:\r\n");
-        printf("connection handle: %u\r\n", params.connHandle);
-        printf("attribute handle: %u", params.handle);
-        if (params.handle == _hour_char.getValueHandle()) {
-            printf(" (hour characteristic)\r\n");
-        } else if (params.handle == _minute_char.getValueHandle()) {
-            printf(" (minute characteristic)\r\n");
-        } else if (params.handle == _second_char.getValueHandle()) {
-            printf(" (second characteristic)\r\n");
-        } else {
-            printf("\r\n");
-        }
+        LAB_LOG_INFO("data read: connection %u attribute %u%s",
+                      params.connHandle, params.handle, characteristic_name(params.handle));
     }
 
     /**
@@ -194,6 +227,21 @@ private:
     }
 
 private:
+    /**
+     * Name suffix of a clock characteristic, for the log records.
+     */
+    const char *characteristic_name(GattAttribute::Handle_t handle) const
+    {
+        if (handle == _hour_char.getValueHandle()) {
+            return " (hour characteristic)";
+        } else if (handle == _minute_char.getValueHandle()) {
+            return " (minute characteristic)";
+        } else if (handle == _second_char.getValueHandle()) {
+            return " (second characteristic)";
+        }
+        return "";
+    }
+
     /**
      * Handler called when a write request is received.
      *
@@ -230,11 +278,23 @@ private:
         const static uint8_t stu_id[10] = "B07901184";
         ble_error_t err = _second_char.set(*_server, *stu_id);
         if (err) {
-            printf("write of the second value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the second value returned error %u", err);
             return;
         }
     }
 
+    /**
+     * Set a clock value and notify it, to each central at its own pace
+     * when there is a fanout.
+     */
+    ble_error_t publish(const GattCharacteristic &characteristic, int id, uint8_t value)
+    {
+        if (_fanout) {
+            return _fanout->notify(id, &value, sizeof(value)) ? BLE_ERROR_INVALID_PARAM : BLE_ERROR_NONE;
+        }
+        return _server->write(characteristic.getValueHandle(), &value, sizeof(value));
+    }
+
     /**
      * Increment the second counter.
      */
@@ -243,15 +303,15 @@ private:
         uint8_t second = 0;
         ble_error_t err = _second_char.get(*_server, second);
         if (err) {
-            printf("read of the second value returned error %u\r\n", err);
+            LAB_LOG_WARN("read of the second value returned error %u", err);
             return;
         }
 
         second = (second + 1) % 60;
 
-        err = _second_char.set(*_server, second);
+        err = publish(_second_char, _second_fanout, second);
         if (err) {
-            printf("write of the second value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the second value returned error %u", err);
             return;
         }
 
@@ -268,15 +328,15 @@ private:
         uint8_t minute = 0;
         ble_error_t err = _minute_char.get(*_server, minute);
         if (err) {
-            printf("read of the minute value returned error %u\r\n", err);
+            LAB_LOG_WARN("read of the minute value returned error %u", err);
             return;
         }
 
         minute = (minute + 1) % 60;
 
-        err = _minute_char.set(*_server, minute);
+        err = publish(_minute_char, _minute_fanout, minute);
         if (err) {
-            printf("write of the minute value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the minute value returned error %u", err);
             return;
         }
 
@@ -293,15 +353,15 @@ private:
         uint8_t hour = 0;
         ble_error_t err = _hour_char.get(*_server, hour);
         if (err) {
-            printf("read of the hour value returned error %u\r\n", err);
+            LAB_LOG_WARN("read of the hour value returned error %u", err);
             return;
         }
 
         hour = (hour + 1) % 24;
 
-        err = _hour_char.set(*_server, hour);
+        err = publish(_hour_char, _hour_fanout, hour);
         if (err) {
-            printf("write of the hour value returned error %u\r\n", err);
+            LAB_LOG_WARN("write of the hour value returned error %u", err);
             return;
         }
     }
@@ -435,6 +495,10 @@ private:
 private:
     GattServer *_server = nullptr;
     events::EventQueue *_event_queue = nullptr;
+    lab::GattFanout *_fanout = nullptr;
+    int _hour_fanout = -1;
+    int _minute_fanout = -1;
+    int _second_fanout = -1;
 
     // clock service and characteristics
     GattService _clock_service;
@@ -455,16 +519,26 @@ private:
 };
 
 int main() {
+    lab::BootProfile::begin();
+
     BLE &ble = BLE::Instance();
     events::EventQueue event_queue;
     ClockService demo_service;
 
-    /* this process will handle basic ble setup and advertising for us */
-    GattServerProcess ble_process(event_queue, ble);
+    log_thread.start();
+    lab::BootProfile::mark("log");
+
+    /* this process will handle basic ble setup and advertising for us, for up to 4 centrals */
+    lab::MultiCentralProcess<GattServerProcess> ble_process(event_queue, ble);
+
+    /* clock notifications queued per central; Gap events go on to ble_process */
+    lab::GattFanout fanout(ble, &ble_process, &demo_service);
+    demo_service.attach(fanout);
 
     /* once it's done it will let us continue with our demo */
     ble_process.on_init(callback(&demo_service, &ClockService::start));
 
+    lab::BootProfile::enter("ble-init");
     ble_process.start();
 
     return 0;
@@ -1,14 +1,33 @@
 #include "mbed.h"
 
-// Sensors drivers present in the BSP library
-#include "stm32l475e_iot01_tsensor.h"
-#include "stm32l475e_iot01_hsensor.h"
-#include "stm32l475e_iot01_psensor.h"
-#include "stm32l475e_iot01_magneto.h"
-#include "stm32l475e_iot01_gyro.h"
-#include "stm32l475e_iot01_accelero.h"
+// Sensors drivers present in the BSP library, wrapped as scheduler channels
+#include "AcquisitionScheduler.h"
+#include "AcquisitionThread.h"
+#include "DiscoL475Sensors.h"
+
+// Gyroscope and accelerometer go through the LSM6DSL FIFO instead
+#include "BlockPool.h"
+#include "ImuFifoChannel.h"
+#include "Lsm6dslFifo.h"
+#include "SpscRing.h"
+
+// Startup timeline, dumped once the first samples are in
+#include "BootProfile.h"
+
+#if defined(FEATURE_BLE)
+// Decimated IMU frames in advertising, for gateways that scan
+#include "ble/BLE.h"
+#include "LogThread.h"
+#include "SensorBroadcaster.h"
+#endif
+
+using namespace std::chrono;
+
+#define IMU_WATERMARK   64
+#define IMU_BATCH_MAX   128
 
 DigitalOut led(LED1);
+InterruptIn imu_int1(PD_11);
 
 static BufferedSerial serial_port(USBTX, USBRX);
 FileHandle *mbed::mbed_override_console(int fd)
@@ -16,60 +35,212 @@ FileHandle *mbed::mbed_override_console(int fd)
     return &serial_port; 
 }
 
-int main()
+#if defined(FEATURE_BLE)
+// one IMU sample in 64, about 26 Hz, published once a second
+#define BROADCAST_DECIMATION    64
+#define BROADCAST_FRAMES        32
+
+struct BroadcastFrame {
+    uint32_t frame;
+    lab::ImuSample sample;
+};
+
+static lab::LogThread log_thread(serial_port);
+static EventQueue ble_queue(16 * EVENTS_EVENT_SIZE);
+static Thread ble_thread(osPriorityNormal, 4096, nullptr, "ble");
+static lab::SpscRing<BroadcastFrame, BROADCAST_FRAMES> broadcast_frames;
+static lab::SensorBroadcaster broadcaster(BLE::Instance(), ble_queue, lab::default_sensor_broadcast_config(6));
+static uint32_t broadcast_period_us = 0;
+static uint32_t imu_index = 0;
+
+// runs on the BLE thread
+static void publish_broadcast()
 {
-    float sensor_value = 0;
-    int16_t pDataXYZ[3] = {0};
-    float pGyroDataXYZ[3] = {0};
-
-    printf("Start sensor init\n");
-
-    BSP_TSENSOR_Init();
-    BSP_HSENSOR_Init();
-    BSP_PSENSOR_Init();
-
-    BSP_MAGNETO_Init();
-    BSP_GYRO_Init();
-    BSP_ACCELERO_Init();
+    BroadcastFrame frames[BROADCAST_FRAMES];
+    int16_t values[BROADCAST_FRAMES * 6];
+    size_t count = broadcast_frames.pop_batch(frames, BROADCAST_FRAMES);
+    if (!count) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        memcpy(&values[i * 6], frames[i].sample.gyro, sizeof(frames[i].sample.gyro));
+        memcpy(&values[i * 6 + 3], frames[i].sample.accel, sizeof(frames[i].sample.accel));
+    }
+    // a frame lost to a full ring shifts the ones after it; the gateway
+    // sees a gap in the frame numbers between batches instead
+    broadcaster.publish(values, count, frames[0].frame, broadcast_period_us);
+}
 
-    while(1) {
-        printf("\nNew loop, LED1 should blink during sensor read\n");
+static void on_ble_init(BLE::InitializationCompleteCallbackContext *context)
+{
+    if (context->error != BLE_ERROR_NONE) {
+        printf("BLE init failed: %d\n", (int)context->error);
+        return;
+    }
+    if (broadcaster.start() == 0) {
+        ble_queue.call_every(1s, publish_broadcast);
+    }
+}
 
-        led = 1;
+static void schedule_ble_events(BLE::OnEventsToProcessCallbackContext *context)
+{
+    ble_queue.call(callback(&context->ble, &BLE::processEvents));
+}
+#endif
 
-        sensor_value = BSP_TSENSOR_ReadTemp();
-        printf("\nTEMPERATURE = %.2f degC\n", sensor_value);
+static lab::AcquisitionScheduler scheduler;
+static lab::AcquisitionThread acquisition(scheduler);
 
-        sensor_value = BSP_HSENSOR_ReadHumidity();
-        printf("HUMIDITY    = %.2f %%\n", sensor_value);
+static lab::BlockPool<lab::ImuFifoChannel::block_size(IMU_BATCH_MAX), 4> imu_pool;
+static lab::SpscRing<lab::ImuBatch *, 4> imu_batches;
+static lab::Lsm6dslFifo imu_fifo(lab::disco_l475_imu_bus());
+static int imu_channel = -1;
 
-        sensor_value = BSP_PSENSOR_ReadPressure();
-        printf("PRESSURE is = %.2f mBar\n", sensor_value);
+static void on_imu_batch(void *context, lab::ImuBatch *batch);
+static lab::ImuFifoChannel imu(imu_fifo, imu_pool, on_imu_batch, nullptr);
 
-        led = 0;
+// runs on the acquisition thread
+static void on_imu_batch(void *, lab::ImuBatch *batch)
+{
+    if (!imu_batches.push(batch)) {
+        imu.release(batch);
+    }
+}
 
-        ThisThread::sleep_for(1000);
+static void on_imu_watermark()
+{
+    acquisition.trigger(imu_channel);
+}
 
-        led = 1;
+int main()
+{
+    int channels[lab::DISCO_CHANNEL_COUNT];
+    lab::SensorRecord latest[lab::DISCO_CHANNEL_COUNT] = {};
+    uint32_t received[lab::DISCO_CHANNEL_COUNT] = {0};
+    lab::SensorRecord records[32];
+    lab::ImuSample imu_latest = {};
+    uint32_t imu_received = 0;
+    uint32_t imu_period_ns = 0;
+    uint32_t imu_gaps = 0;
+    bool first_data = false;
+
+    lab::BootProfile::begin();
 
-        BSP_MAGNETO_GetXYZ(pDataXYZ);
-        printf("\nMAGNETO_X = %d\n", pDataXYZ[0]);
-        printf("MAGNETO_Y = %d\n", pDataXYZ[1]);
-        printf("MAGNETO_Z = %d\n", pDataXYZ[2]);
+    printf("Start sensor init\n");
 
-        BSP_GYRO_GetXYZ(pGyroDataXYZ);
-        printf("\nGYRO_X = %.2f\n", pGyroDataXYZ[0]);
-        printf("GYRO_Y = %.2f\n", pGyroDataXYZ[1]);
-        printf("GYRO_Z = %.2f\n", pGyroDataXYZ[2]);
+    // every sensor samples at its own rate on the acquisition thread; the
+    // BSP drivers share I2C2 without locking, so they come up one by one
+    lab::DiscoL475Rates rates = lab::disco_l475_default_rates();
+    rates.gyro_us = 0;
+    rates.accelero_us = 0;
+    lab::BootProfile::enter("sensors");
+    lab::disco_l475_add_sensors(scheduler, rates, channels);
+    lab::BootProfile::leave("sensors");
+
+    lab::Lsm6dslFifoConfig imu_config;
+    imu_config.odr = lab::LSM6DSL_ODR_1660HZ;
+    imu_config.watermark = IMU_WATERMARK;
+    imu_config.accel_scale = lab::LSM6DSL_ACCEL_2G;
+    imu_config.gyro_scale = lab::LSM6DSL_GYRO_2000DPS;
+    lab::BootProfile::enter("imu-fifo");
+    int imu_status = imu_fifo.configure(imu_config);
+    lab::BootProfile::leave("imu-fifo");
+    if (imu_status) {
+        printf("LSM6DSL FIFO init failed\n");
+    } else {
+        // INT1 starts the drains, the poll only covers a missed edge
+        uint32_t watermark_us = (uint32_t)(((uint64_t)IMU_WATERMARK * imu_fifo.nominal_period_ns()) / 1000);
+        imu_channel = imu.add_to(scheduler, 3, 2 * watermark_us);
+        imu_int1.rise(on_imu_watermark);
+    }
 
-        BSP_ACCELERO_AccGetXYZ(pDataXYZ);
-        printf("\nACCELERO_X = %d\n", pDataXYZ[0]);
-        printf("ACCELERO_Y = %d\n", pDataXYZ[1]);
-        printf("ACCELERO_Z = %d\n", pDataXYZ[2]);
+    acquisition.start();
+    lab::BootProfile::mark("acquisition");
 
-        led = 0;
+#if defined(FEATURE_BLE)
+    log_thread.start();
+    broadcast_period_us = (uint32_t)(((uint64_t)BROADCAST_DECIMATION * imu_fifo.nominal_period_ns()) / 1000);
+    BLE &ble = BLE::Instance();
+    ble.onEventsToProcess(schedule_ble_events);
+    ble.init(on_ble_init);
+    ble_thread.start(callback(&ble_queue, &EventQueue::dispatch_forever));
+#endif
 
-        ThisThread::sleep_for(1000);
+    Kernel::Clock::time_point report = Kernel::Clock::now() + 1s;
 
+    while(1) {
+        size_t count = acquisition.read(records, sizeof(records) / sizeof(records[0]), 100ms);
+
+        if (count && !first_data) {
+            first_data = true;
+            lab::BootProfile::mark("first-data");
+            lab::BootProfile::dump();
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            for (int s = 0; s < lab::DISCO_CHANNEL_COUNT; s++) {
+                if (channels[s] == records[i].channel) {
+                    latest[s] = records[i];
+                    received[s]++;
+                }
+            }
+        }
+
+        lab::ImuBatch *batch;
+        while (imu_batches.pop(batch)) {
+            if (batch->count) {
+                imu_latest = batch->samples[batch->count - 1];
+            }
+            imu_received += batch->count;
+            imu_period_ns = batch->period_ns;
+            imu_gaps += batch->overrun;
+#if defined(FEATURE_BLE)
+            for (size_t i = 0; i < batch->count; i++, imu_index++) {
+                if (imu_index % BROADCAST_DECIMATION == 0) {
+                    BroadcastFrame frame = { imu_index / BROADCAST_DECIMATION, batch->samples[i] };
+                    broadcast_frames.push(frame);
+                }
+            }
+#endif
+            imu.release(batch);
+        }
+
+        if (Kernel::Clock::now() < report) {
+            continue;
+        }
+        report += 1s;
+        led = !led;
+
+        printf("\nNew report, LED1 toggles every second\n");
+        for (int s = 0; s < lab::DISCO_CHANNEL_COUNT; s++) {
+            if (channels[s] < 0) {
+                continue;
+            }
+            const lab::SensorChannelStats &stats = scheduler.stats(channels[s]);
+            printf("%-11s %3lu/s", scheduler.config(channels[s]).name, (unsigned long)received[s]);
+            for (int v = 0; v < latest[s].count; v++) {
+                printf(" %10.2f", latest[s].value[v]);
+            }
+            printf(" %s (t=%lu us, max latency %lu us, missed %lu)\n",
+                   lab::disco_l475_unit((lab::DiscoL475Channel)s),
+                   (unsigned long)latest[s].timestamp_us, (unsigned long)stats.max_latency_us,
+                   (unsigned long)stats.missed);
+            received[s] = 0;
+        }
+        if (imu_channel >= 0) {
+            float mg = imu_fifo.accel_mg_per_lsb();
+            float mdps = imu_fifo.gyro_mdps_per_lsb();
+            printf("imu-fifo   %4lu/s, period %lu ns, gaps %lu, no buffer %lu\n",
+                   (unsigned long)imu_received, (unsigned long)imu_period_ns,
+                   (unsigned long)imu_gaps, (unsigned long)imu.no_buffer());
+            printf("  gyro  %10.2f %10.2f %10.2f mdps\n",
+                   imu_latest.gyro[0] * mdps, imu_latest.gyro[1] * mdps, imu_latest.gyro[2] * mdps);
+            printf("  accel %10.2f %10.2f %10.2f mg\n",
+                   imu_latest.accel[0] * mg, imu_latest.accel[1] * mg, imu_latest.accel[2] * mg);
+            imu_received = 0;
+        }
+        if (acquisition.dropped()) {
+            printf("%lu records dropped\n", (unsigned long)acquisition.dropped());
+        }
     }
 }
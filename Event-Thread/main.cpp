@@ -4,36 +4,29 @@
 #include "mbed_events.h" 
 #include <cstdio>
 
+#include "InputPipeline.h"
+
 DigitalOut led(LED1);
 InterruptIn button(USER_BUTTON);
-Timeout  press_threhold;
 EventQueue *queue = mbed_event_queue();
+lab::InputPipeline input(*queue);
 
 
-void button_release_detecting()
-{
-    button.enable_irq();
-}
-
-void button_pressed()
-{
-    button.disable_irq();
-    queue->call(printf, "pressed\n");
-    press_threhold.attach(button_release_detecting, 3.0);
-    queue->call(printf, "start timer...\n");
-}
-
-void button_released()
+// Runs in the context of the event queue, never in IRQ context
+void button_events(const lab::InputEvent *events, size_t count)
 {
-    led = !led;
-    queue->call(printf, "released\n");
+    for (size_t i = 0; i < count; i++) {
+        printf("%s at %u us\n", lab::input_event_name(events[i].type), events[i].timestamp_us);
+        if (events[i].type == lab::INPUT_RELEASE) {
+            led = !led;
+        }
+    }
 }
 
 
 int main() {
-    // The 'rise' handler will execute in IRQ context 
-    button.rise(button_released);
-    // The 'fall' handler will execute in the context of thread 't' 
-    button.fall(button_pressed);
+    // Edges are stamped in IRQ context, debounced in the event queue
+    input.attach(button);
+    input.subscribe(button_events);
     queue->dispatch_forever();
-}
\ No newline at end of file
+}
@@ -0,0 +1,237 @@
+#ifndef LAB_BENCH_H
+#define LAB_BENCH_H
+
+/*
+ * Benchmarks are written against the Google Benchmark API:
+ *
+ *     static void BM_Something(benchmark::State &state)
+ *     {
+ *         for (auto _ : state) {
+ *             benchmark::DoNotOptimize(work());
+ *         }
+ *         state.SetItemsProcessed(state.iterations());
+ *     }
+ *     BENCHMARK(BM_Something);
+ *
+ * Host builds with LAB_BENCH_GOOGLE use the library itself. Everywhere
+ * else, the board in particular, the subset below is provided by
+ * MiniBench.cpp: range-for over the state, Pause/ResumeTiming,
+ * Set{Bytes,Items}Processed, named counters, DoNotOptimize and
+ * ClobberMemory. No Args/Ranges: a benchmark is one function.
+ *
+ * The built-in runner measures in ticks of bench_clock(): CPU cycles of
+ * the DWT counter on the board, nanoseconds on the host.
+ */
+
+#if defined(LAB_BENCH_GOOGLE)
+
+#include <benchmark/benchmark.h>
+
+#else
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace benchmark {
+
+class State;
+
+typedef void (*Function)(State &state);
+
+/** Named user counters, state.counters["ratio"] = 2.5. */
+class UserCounters {
+public:
+    static const size_t MAX_COUNTERS = 4;
+
+    UserCounters() : _count(0) {}
+
+    /** Extra names beyond MAX_COUNTERS all share one discarded slot. */
+    double &operator[](const char *name);
+
+    size_t size() const
+    {
+        return _count;
+    }
+
+    const char *name(size_t index) const
+    {
+        return _names[index];
+    }
+
+    double value(size_t index) const
+    {
+        return _values[index];
+    }
+
+private:
+    const char *_names[MAX_COUNTERS];
+    double _values[MAX_COUNTERS + 1];
+    size_t _count;
+};
+
+class State {
+public:
+    struct __attribute__((unused)) Value {};
+
+    class Iterator {
+    public:
+        Iterator(State *state, uint64_t left) : _state(state), _left(left) {}
+
+        Value operator*() const
+        {
+            return Value();
+        }
+
+        Iterator &operator++()
+        {
+            _left--;
+            return *this;
+        }
+
+        bool operator!=(const Iterator &) const
+        {
+            if (_left) {
+                return true;
+            }
+            _state->finish();
+            return false;
+        }
+
+    private:
+        State *_state;
+        uint64_t _left;
+    };
+
+    explicit State(uint64_t iterations);
+
+    Iterator begin();
+
+    Iterator end()
+    {
+        return Iterator(this, 0);
+    }
+
+    void PauseTiming();
+    void ResumeTiming();
+
+    void SetBytesProcessed(int64_t bytes)
+    {
+        _bytes = bytes;
+    }
+
+    void SetItemsProcessed(int64_t items)
+    {
+        _items = items;
+    }
+
+    void SkipWithError(const char *message)
+    {
+        _error = message;
+    }
+
+    int64_t iterations() const
+    {
+        return _iterations;
+    }
+
+    /** Timed ticks of the run, valid after the loop. */
+    uint64_t ticks() const
+    {
+        return _ticks;
+    }
+
+    int64_t bytes_processed() const
+    {
+        return _bytes;
+    }
+
+    int64_t items_processed() const
+    {
+        return _items;
+    }
+
+    const char *error() const
+    {
+        return _error;
+    }
+
+    UserCounters counters;
+
+private:
+    void finish();
+
+    int64_t _iterations;
+    uint64_t _ticks;
+    uint64_t _started;
+    bool _running;
+    int64_t _bytes;
+    int64_t _items;
+    const char *_error;
+};
+
+template<typename T>
+inline void DoNotOptimize(T &&value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void ClobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+namespace internal {
+
+/** Static registration done by BENCHMARK(). */
+class Registration {
+public:
+    Registration(const char *name, Function function);
+};
+
+} // namespace internal
+
+} // namespace benchmark
+
+#define LAB_BENCH_CONCAT2(a, b) a##b
+#define LAB_BENCH_CONCAT(a, b) LAB_BENCH_CONCAT2(a, b)
+#define BENCHMARK(function) \
+    static ::benchmark::internal::Registration LAB_BENCH_CONCAT(bench_registration_, __LINE__)(#function, function)
+
+namespace lab {
+
+struct BenchOptions {
+    /** Ticks a measurement should at least last. */
+    uint64_t min_ticks;
+    /** Substring a benchmark name must contain, nullptr runs all. */
+    const char *filter;
+};
+
+/** Free running clock of the runner, see bench_clock_name(). */
+uint64_t bench_clock();
+
+/** "cycles" or "ns". */
+const char *bench_clock_name();
+
+/** Ticks per second. */
+uint32_t bench_clock_hz();
+
+/**
+ * Run the registered benchmarks and print one line per result:
+ *
+ *     BENCH-BEGIN <unit> <ticks per second>
+ *     BENCH <name> <iterations> <ticks per iteration> <bytes/s> <items/s> [<counter>=<value> ...]
+ *     BENCH-ERROR <name> <message>
+ *     BENCH-END <count>
+ *
+ * bench.py turns these lines into a results file.
+ *
+ * @return number of benchmarks run.
+ */
+int run_benchmarks(const BenchOptions &options, std::FILE *out);
+
+} // namespace lab
+
+#endif // LAB_BENCH_GOOGLE
+
+#endif // LAB_BENCH_H
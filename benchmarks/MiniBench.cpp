@@ -0,0 +1,208 @@
+#include "Bench.h"
+
+#if !defined(LAB_BENCH_GOOGLE)
+
+#include <cstring>
+
+#if defined(__MBED__)
+#include "BootProfile.h"
+#else
+#include <chrono>
+#endif
+
+namespace benchmark {
+
+namespace {
+
+const size_t MAX_BENCHMARKS = 64;
+
+struct Entry {
+    const char *name;
+    Function function;
+};
+
+Entry registry[MAX_BENCHMARKS];
+size_t registered;
+
+} // namespace
+
+double &UserCounters::operator[](const char *name)
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_names[i], name) == 0) {
+            return _values[i];
+        }
+    }
+    if (_count == MAX_COUNTERS) {
+        return _values[MAX_COUNTERS];
+    }
+    _names[_count] = name;
+    _values[_count] = 0;
+    return _values[_count++];
+}
+
+State::State(uint64_t iterations) :
+    _iterations(iterations),
+    _ticks(0),
+    _started(0),
+    _running(false),
+    _bytes(0),
+    _items(0),
+    _error(nullptr)
+{
+}
+
+State::Iterator State::begin()
+{
+    ResumeTiming();
+    return Iterator(this, _iterations);
+}
+
+void State::PauseTiming()
+{
+    if (_running) {
+        _ticks += lab::bench_clock() - _started;
+        _running = false;
+    }
+}
+
+void State::ResumeTiming()
+{
+    if (!_running) {
+        _running = true;
+        _started = lab::bench_clock();
+    }
+}
+
+void State::finish()
+{
+    PauseTiming();
+}
+
+namespace internal {
+
+Registration::Registration(const char *name, Function function)
+{
+    if (registered < MAX_BENCHMARKS) {
+        registry[registered].name = name;
+        registry[registered].function = function;
+        registered++;
+    }
+}
+
+} // namespace internal
+
+} // namespace benchmark
+
+namespace lab {
+
+#if defined(__MBED__)
+
+/* BootProfile::begin() has switched the DWT cycle counter on */
+uint64_t bench_clock()
+{
+    static uint32_t last;
+    static uint64_t high;
+    uint32_t now = BootProfile::cycles();
+    if (now < last) {
+        high += 1ull << 32;
+    }
+    last = now;
+    return high | now;
+}
+
+const char *bench_clock_name()
+{
+    return BootProfile::frequency_hz() == 1000000 ? "us" : "cycles";
+}
+
+uint32_t bench_clock_hz()
+{
+    return BootProfile::frequency_hz();
+}
+
+#else
+
+uint64_t bench_clock()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char *bench_clock_name()
+{
+    return "ns";
+}
+
+uint32_t bench_clock_hz()
+{
+    return 1000000000;
+}
+
+#endif
+
+namespace {
+
+const uint64_t MAX_ITERATIONS = 1000000000;
+
+/*
+ * Same sizing as Google Benchmark: start with one iteration and grow
+ * until a run lasts min_ticks, then report that run.
+ */
+void run_one(const char *name, benchmark::Function function, const BenchOptions &options, std::FILE *out)
+{
+    uint64_t iterations = 1;
+    for (;;) {
+        benchmark::State state(iterations);
+        function(state);
+        if (state.error()) {
+            fprintf(out, "BENCH-ERROR %s %s\n", name, state.error());
+            return;
+        }
+        uint64_t ticks = state.ticks();
+        if (ticks >= options.min_ticks || iterations >= MAX_ITERATIONS) {
+            double seconds = (double)ticks / bench_clock_hz();
+            fprintf(out, "BENCH %s %llu %.3f %.0f %.0f", name, (unsigned long long)iterations,
+                    (double)ticks / iterations,
+                    seconds > 0 ? state.bytes_processed() / seconds : 0.0,
+                    seconds > 0 ? state.items_processed() / seconds : 0.0);
+            for (size_t i = 0; i < state.counters.size(); i++) {
+                fprintf(out, " %s=%g", state.counters.name(i), state.counters.value(i));
+            }
+            fprintf(out, "\n");
+            return;
+        }
+        double multiplier = ticks ? 1.4 * options.min_ticks / ticks : 10;
+        if (multiplier > 10) {
+            multiplier = 10;
+        }
+        uint64_t next = (uint64_t)(iterations * multiplier);
+        iterations = next > iterations ? next : iterations + 1;
+        if (iterations > MAX_ITERATIONS) {
+            iterations = MAX_ITERATIONS;
+        }
+    }
+}
+
+} // namespace
+
+int run_benchmarks(const BenchOptions &options, std::FILE *out)
+{
+    int run = 0;
+    fprintf(out, "BENCH-BEGIN %s %lu\n", bench_clock_name(), (unsigned long)bench_clock_hz());
+    for (size_t i = 0; i < benchmark::registered; i++) {
+        const benchmark::Entry &entry = benchmark::registry[i];
+        if (options.filter && !strstr(entry.name, options.filter)) {
+            continue;
+        }
+        run_one(entry.name, entry.function, options, out);
+        fflush(out);
+        run++;
+    }
+    fprintf(out, "BENCH-END %d\n", run);
+    return run;
+}
+
+} // namespace lab
+
+#endif // !LAB_BENCH_GOOGLE
@@ -0,0 +1,33 @@
+#include "Bench.h"
+
+/*
+ * main() of the host executables when Google Benchmark is not available.
+ * Understands the two flags the suite relies on; others are ignored, so
+ * bench.py can call both kinds of executables the same way.
+ */
+#if !defined(LAB_BENCH_GOOGLE) && !defined(__MBED__)
+
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char **argv)
+{
+    lab::BenchOptions options;
+    options.min_ticks = lab::bench_clock_hz() / 2;
+    options.filter = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char *min_time = "--benchmark_min_time=";
+        const char *filter = "--benchmark_filter=";
+        if (strncmp(argv[i], min_time, strlen(min_time)) == 0) {
+            options.min_ticks = (uint64_t)(atof(argv[i] + strlen(min_time)) * lab::bench_clock_hz());
+        } else if (strncmp(argv[i], filter, strlen(filter)) == 0) {
+            options.filter = argv[i] + strlen(filter);
+        }
+    }
+
+    lab::run_benchmarks(options, stdout);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,251 @@
+#!/usr/bin/env python3
+"""Collect benchmark results and compare them between commits.
+
+    python3 bench.py run build-bench -o host.json
+    python3 bench.py serial /dev/ttyACM0 -o board.json
+    python3 bench.py compare base.json new.json --threshold 0.05
+
+`run` executes every bench_* program of a host build directory, built
+with Google Benchmark or the built-in runner. `serial` triggers a run on
+the board (or reads a capture file) and parses its BENCH lines. Both
+write the same results file:
+
+    {"format": "lab-bench/1", "target": "host", "unit": "ns",
+     "commit": "c2296fd", "date": "...",
+     "benchmarks": {"BM_CounterInc": {"time": 9.1, "iterations": 8206467,
+                                      "bytes_per_second": 0, "items_per_second": 1.1e8,
+                                      "counters": {}}}}
+
+`time` is per iteration in `unit`: ns on the host, cycles on the board.
+`compare` lists every benchmark of both files and exits with 1 when one
+got slower than the threshold allows.
+"""
+
+import argparse
+import datetime
+import glob
+import json
+import os
+import re
+import subprocess
+import sys
+
+FORMAT = 'lab-bench/1'
+LINE = re.compile(r'BENCH (\S+) (\d+) ([\d.]+) ([\d.]+) ([\d.]+)((?: \S+=\S+)*)')
+BEGIN = re.compile(r'BENCH-BEGIN (\S+) (\d+)')
+ERROR = re.compile(r'BENCH-ERROR (\S+) (.*)')
+GOOGLE_FIELDS = ('name', 'run_name', 'run_type', 'repetitions', 'repetition_index', 'threads',
+                 'iterations', 'real_time', 'cpu_time', 'time_unit', 'bytes_per_second',
+                 'items_per_second', 'family_index', 'per_family_instance_index',
+                 'aggregate_name', 'aggregate_unit', 'error_occurred', 'error_message', 'label')
+NS_PER_UNIT = {'ns': 1.0, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+
+def commit():
+    try:
+        here = os.path.dirname(os.path.abspath(__file__))
+        head = subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'], cwd=here, text=True).strip()
+        dirty = subprocess.call(['git', 'diff', '--quiet', 'HEAD'], cwd=here) != 0
+        return head + ('-dirty' if dirty else '')
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def results(target, unit, benchmarks):
+    return {
+        'format': FORMAT,
+        'target': target,
+        'unit': unit,
+        'commit': commit(),
+        'date': datetime.datetime.now().isoformat(timespec='seconds'),
+        'benchmarks': benchmarks,
+    }
+
+
+def parse_lines(lines, errors):
+    """BENCH lines of the built-in runner. @return unit, benchmarks."""
+    unit = None
+    benchmarks = {}
+    for line in lines:
+        begin = BEGIN.search(line)
+        if begin:
+            unit = begin.group(1)
+            continue
+        error = ERROR.search(line)
+        if error:
+            errors.append('%s: %s' % error.groups())
+            continue
+        match = LINE.search(line)
+        if not match:
+            continue
+        name, iterations, time, bytes_rate, items_rate, extra = match.groups()
+        counters = {}
+        for pair in extra.split():
+            key, value = pair.split('=', 1)
+            counters[key] = float(value)
+        benchmarks[name] = {
+            'time': float(time),
+            'iterations': int(iterations),
+            'bytes_per_second': float(bytes_rate),
+            'items_per_second': float(items_rate),
+            'counters': counters,
+        }
+    return unit, benchmarks
+
+
+def parse_google(report, errors):
+    """Google Benchmark JSON output."""
+    benchmarks = {}
+    for entry in report.get('benchmarks', []):
+        if entry.get('run_type', 'iteration') != 'iteration':
+            continue
+        name = entry.get('run_name', entry['name'])
+        if entry.get('error_occurred'):
+            errors.append('%s: %s' % (name, entry.get('error_message', 'error')))
+            continue
+        benchmarks[name] = {
+            'time': entry['cpu_time'] * NS_PER_UNIT[entry.get('time_unit', 'ns')],
+            'iterations': entry['iterations'],
+            'bytes_per_second': entry.get('bytes_per_second', 0),
+            'items_per_second': entry.get('items_per_second', 0),
+            'counters': {k: v for k, v in entry.items() if k not in GOOGLE_FIELDS},
+        }
+    return benchmarks
+
+
+def run(options):
+    programs = sorted(p for p in glob.glob(os.path.join(options.build, 'bench_*'))
+                      if os.access(p, os.X_OK) and not os.path.isdir(p))
+    if not programs:
+        sys.exit('no bench_* programs in %s' % options.build)
+    errors = []
+    benchmarks = {}
+    for program in programs:
+        command = [program, '--benchmark_format=json',
+                   '--benchmark_min_time=%g' % options.min_time]
+        if options.filter:
+            command.append('--benchmark_filter=%s' % options.filter)
+        print(os.path.basename(program), file=sys.stderr)
+        # the fastest of a few runs: noise on a host only ever adds time
+        for _ in range(options.repetitions):
+            output = subprocess.check_output(command, text=True)
+            if output.lstrip().startswith('{'):
+                measured = parse_google(json.loads(output), errors)
+            else:
+                measured = parse_lines(output.splitlines(), errors)[1]
+            for name, result in measured.items():
+                if name not in benchmarks or result['time'] < benchmarks[name]['time']:
+                    benchmarks[name] = result
+    return results('host', 'ns', benchmarks), errors
+
+
+def serial(options):
+    if os.path.exists(options.source) and not options.source.startswith('/dev/'):
+        with open(options.source, errors='replace') as capture:
+            lines = capture.read().splitlines()
+    else:
+        import serial as pyserial
+        port = pyserial.Serial(options.source, options.baud, timeout=options.timeout)
+        port.reset_input_buffer()
+        port.write(b'f%s\n' % options.filter.encode() if options.filter else b'\n')
+        lines = []
+        while True:
+            line = port.readline().decode(errors='replace')
+            if not line:
+                sys.exit('no BENCH-END within %d s' % options.timeout)
+            print(line.rstrip(), file=sys.stderr)
+            lines.append(line)
+            if line.startswith('BENCH-END'):
+                break
+    errors = []
+    unit, benchmarks = parse_lines(lines, errors)
+    if unit is None:
+        sys.exit('no BENCH-BEGIN line')
+    return results(options.target, unit, benchmarks), errors
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    if data.get('format') != FORMAT:
+        sys.exit('%s: not a %s results file' % (path, FORMAT))
+    return data
+
+
+def compare(options):
+    base = load(options.base)
+    new = load(options.new)
+    if (base['target'], base['unit']) != (new['target'], new['unit']):
+        sys.exit('cannot compare %s/%s with %s/%s' % (base['target'], base['unit'], new['target'], new['unit']))
+
+    print('%s %s -> %s, time per iteration in %s' % (new['target'], base['commit'], new['commit'], new['unit']))
+    regressions = []
+    names = sorted(set(base['benchmarks']) | set(new['benchmarks']))
+    width = max([len(name) for name in names] + [9])
+    for name in names:
+        before = base['benchmarks'].get(name)
+        after = new['benchmarks'].get(name)
+        if not before or not after:
+            print('%-*s  %12s  %12s  %s' % (width, name, before and '%.3f' % before['time'] or '-',
+                                            after and '%.3f' % after['time'] or '-',
+                                            'removed' if before else 'new'))
+            continue
+        change = after['time'] / before['time'] - 1 if before['time'] else 0.0
+        flag = ''
+        if change > options.threshold:
+            flag = 'REGRESSION'
+            regressions.append(name)
+        elif change < -options.threshold:
+            flag = 'faster'
+        print('%-*s  %12.3f  %12.3f  %+7.1f%%  %s' % (width, name, before['time'], after['time'],
+                                                     100 * change, flag))
+    if regressions:
+        print('%d regression(s) over %.0f%%: %s' % (len(regressions), 100 * options.threshold,
+                                                     ', '.join(regressions)))
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    command = commands.add_parser('run', help='run the host benchmarks of a build directory')
+    command.add_argument('build')
+    command.add_argument('-o', '--output')
+    command.add_argument('--min-time', type=float, default=0.5, help='seconds per measurement')
+    command.add_argument('--repetitions', type=int, default=5, help='keep the fastest of this many runs')
+    command.add_argument('--filter')
+
+    command = commands.add_parser('serial', help='run the benchmarks on the board')
+    command.add_argument('source', help='serial port or capture file')
+    command.add_argument('-o', '--output')
+    command.add_argument('--baud', type=int, default=115200)
+    command.add_argument('--timeout', type=int, default=120)
+    command.add_argument('--target', default='DISCO_L475VG_IOT01A')
+    command.add_argument('--filter')
+
+    command = commands.add_parser('compare', help='compare two results files')
+    command.add_argument('base')
+    command.add_argument('new')
+    command.add_argument('--threshold', type=float, default=0.05,
+                         help='relative slow-down reported as a regression')
+
+    options = parser.parse_args()
+    if options.command == 'compare':
+        sys.exit(compare(options))
+
+    data, errors = run(options) if options.command == 'run' else serial(options)
+    text = json.dumps(data, indent=1, sort_keys=True)
+    if options.output:
+        with open(options.output, 'w') as f:
+            f.write(text + '\n')
+    else:
+        print(text)
+    for error in errors:
+        print('error: ' + error, file=sys.stderr)
+    sys.exit(1 if errors else 0)
+
+
+if __name__ == '__main__':
+    main()
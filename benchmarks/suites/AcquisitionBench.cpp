@@ -0,0 +1,42 @@
+#include "Bench.h"
+
+#include "AcquisitionScheduler.h"
+#include "SimulatedSensorBus.h"
+
+/*
+ * Scheduling overhead of the acquisition thread, in virtual time: one
+ * iteration is 100 ms of SimulatedSensorBus::run(), every next()
+ * decision of it plus the execute()/complete() of the reads it picks.
+ * The channels are the default B-L475E-IOT01A table of
+ * disco_l475_add_sensors(), on simulated devices that cost nothing but
+ * their bus time and a sine per axis.
+ */
+
+static const uint32_t SLICE_US = 100000;
+
+static void BM_SchedulerDecision(benchmark::State &state)
+{
+    static const lab::SensorChannelConfig channels[] = {
+        { "temperature", 1000000, 1, nullptr, nullptr, 1500 },
+        { "humidity",    1000000, 1, nullptr, nullptr, 1500 },
+        { "pressure",    1000000, 1, nullptr, nullptr, 1500 },
+        { "magneto",     50000,   2, nullptr, nullptr, 1000 },
+        { "gyro",        10000,   3, nullptr, nullptr, 1000 },
+        { "accelero",    10000,   3, nullptr, nullptr, 1000 },
+    };
+    static const uint8_t axes[] = { 1, 1, 1, 3, 3, 3 };
+    lab::AcquisitionScheduler scheduler;
+    lab::SimulatedSensorBus bus;
+    for (size_t i = 0; i < sizeof(channels) / sizeof(channels[0]); i++) {
+        bus.attach(scheduler, channels[i], channels[i].cost_us, axes[i]);
+    }
+
+    scheduler.start(bus.now());
+    int64_t reads = 0;
+    for (auto _ : state) {
+        reads += bus.run(scheduler, SLICE_US).records;
+    }
+    state.SetItemsProcessed(reads);
+    state.counters["reads"] = state.iterations() ? (double)reads / state.iterations() : 0;
+}
+BENCHMARK(BM_SchedulerDecision);
@@ -0,0 +1,48 @@
+#ifndef LAB_BENCH_SIGNALS_H
+#define LAB_BENCH_SIGNALS_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Deterministic test signals, so every run and every target works on the
+ * same data.
+ */
+
+/** xorshift32, never returns 0 for a non-zero state. */
+inline uint32_t bench_random(uint32_t &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+/** Uniform noise in [-amplitude, amplitude]. */
+inline int bench_noise(uint32_t &state, int amplitude)
+{
+    return (int)(bench_random(state) % (2 * amplitude + 1)) - amplitude;
+}
+
+/**
+ * Board lying on a vibrating bench, LSM6DSL raw units at 2 g / 500 dps:
+ * accelerometer X Y Z then gyroscope X Y Z, interleaved. A 60 Hz line at
+ * 1.6 kHz sampling plus a few LSB of noise.
+ */
+inline void bench_imu_frames(int16_t *values, size_t frames, uint32_t seed = 0x1234567)
+{
+    const float two_pi = 6.2831853f;
+    for (size_t f = 0; f < frames; f++) {
+        float vibration = sinf(two_pi * 60.0f * f / 1600.0f);
+        int16_t *frame = values + 6 * f;
+        frame[0] = (int16_t)(120 + 300 * vibration + bench_noise(seed, 12));
+        frame[1] = (int16_t)(-40 + 150 * vibration + bench_noise(seed, 12));
+        frame[2] = (int16_t)(16384 + 80 * vibration + bench_noise(seed, 12));
+        frame[3] = (int16_t)(bench_noise(seed, 6));
+        frame[4] = (int16_t)(3 + bench_noise(seed, 6));
+        frame[5] = (int16_t)(-2 + bench_noise(seed, 6));
+    }
+}
+
+#endif // LAB_BENCH_SIGNALS_H
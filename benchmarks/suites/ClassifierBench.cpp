@@ -0,0 +1,199 @@
+#include "Bench.h"
+
+#include <cstring>
+
+#include "ActivityModelVectors.h"
+#include "Int8Model.h"
+
+/*
+ * The int8 activity classifier of the WiFi example: the packed dot
+ * product against the plain loop, its two layers on their own, and a
+ * whole inference (one window, 64 samples of 3 axes). Every run checks
+ * the logits against the ones int8_model.py computed, and the packed
+ * kernels against the reference ones, byte for byte.
+ */
+
+static lab::Int8Classifier<lab::ACTIVITY_MODEL_ARENA, lab::ACTIVITY_MODEL_WINDOW> classifier;
+
+static bool load(benchmark::State &state)
+{
+    if (!classifier.model().loaded() && classifier.load(lab::activity_model, sizeof(lab::activity_model), 32)) {
+        state.SkipWithError("activity model rejected");
+        return false;
+    }
+    return true;
+}
+
+static void random_bytes(int8_t *values, size_t count, uint32_t seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        values[i] = (int8_t)(seed >> 24);
+    }
+}
+
+template<bool Reference>
+static void dot(benchmark::State &state)
+{
+    static int8_t a[192];
+    static int8_t b[192];
+    random_bytes(a, sizeof(a), 1);
+    random_bytes(b, sizeof(b), 2);
+    int32_t expected = 0;
+    for (size_t i = 0; i < sizeof(a); i++) {
+        expected += a[i] * b[i];
+    }
+    int32_t acc = 0;
+    for (auto _ : state) {
+        if (Reference) {
+            acc = 0;
+            for (size_t i = 0; i < sizeof(a); i++) {
+                acc += (int32_t)a[i] * b[i];
+            }
+        } else {
+            acc = lab::int8_dot(a, b, sizeof(a), 0);
+        }
+        benchmark::DoNotOptimize(acc);
+        benchmark::ClobberMemory();
+    }
+    if (acc != expected) {
+        state.SkipWithError("dot product differs from the plain sum");
+    }
+    state.SetItemsProcessed(state.iterations() * sizeof(a));
+}
+
+static void BM_Int8Dot192(benchmark::State &state)
+{
+    dot<false>(state);
+}
+BENCHMARK(BM_Int8Dot192);
+
+static void BM_Int8Dot192Reference(benchmark::State &state)
+{
+    dot<true>(state);
+}
+BENCHMARK(BM_Int8Dot192Reference);
+
+/** Layer index of the model through the packed kernel, checked against the reference. */
+template<bool Reference>
+static void layer(benchmark::State &state, size_t index)
+{
+    if (!load(state)) {
+        return;
+    }
+    const lab::Int8Layer &layer = classifier.model().layer(index);
+    size_t inputs = (size_t)layer.input_length * layer.input_channels;
+    size_t outputs = (size_t)layer.output_length * layer.output_channels;
+    static int8_t input[lab::ACTIVITY_MODEL_WINDOW];
+    static int8_t output[lab::ACTIVITY_MODEL_ARENA];
+    static int8_t expected[lab::ACTIVITY_MODEL_ARENA];
+    random_bytes(input, inputs, 3);
+
+    bool conv = layer.type == lab::INT8_LAYER_CONV1D;
+    if (conv) {
+        lab::int8_conv1d_reference(input, layer.input_length, layer.input_channels, layer.weights, layer.bias,
+                                   layer.output_channels, layer.kernel, layer.stride, layer.requant, expected);
+    } else {
+        lab::int8_dense_reference(input, inputs, layer.weights, layer.bias, layer.output_channels, layer.requant,
+                                  expected);
+    }
+    for (auto _ : state) {
+        if (conv && Reference) {
+            lab::int8_conv1d_reference(input, layer.input_length, layer.input_channels, layer.weights, layer.bias,
+                                       layer.output_channels, layer.kernel, layer.stride, layer.requant, output);
+        } else if (conv) {
+            lab::int8_conv1d(input, layer.input_length, layer.input_channels, layer.weights, layer.bias,
+                             layer.output_channels, layer.kernel, layer.stride, layer.requant, output);
+        } else if (Reference) {
+            lab::int8_dense_reference(input, inputs, layer.weights, layer.bias, layer.output_channels, layer.requant,
+                                      output);
+        } else {
+            lab::int8_dense(input, inputs, layer.weights, layer.bias, layer.output_channels, layer.requant, output);
+        }
+        benchmark::ClobberMemory();
+    }
+    if (memcmp(output, expected, outputs)) {
+        state.SkipWithError("packed kernel differs from the reference");
+    }
+    state.SetItemsProcessed(state.iterations() * outputs);
+}
+
+static void BM_Int8Conv1d(benchmark::State &state)
+{
+    layer<false>(state, 0);
+}
+BENCHMARK(BM_Int8Conv1d);
+
+static void BM_Int8Conv1dReference(benchmark::State &state)
+{
+    layer<true>(state, 0);
+}
+BENCHMARK(BM_Int8Conv1dReference);
+
+static void BM_Int8Dense(benchmark::State &state)
+{
+    layer<false>(state, 2);
+}
+BENCHMARK(BM_Int8Dense);
+
+template<bool Reference>
+static void inference(benchmark::State &state)
+{
+    if (!load(state)) {
+        return;
+    }
+    const lab::Int8Model &model = classifier.model();
+    alignas(4) static uint8_t arena[lab::ACTIVITY_MODEL_ARENA];
+    size_t vector = 0;
+    size_t mismatches = 0;
+    for (auto _ : state) {
+        const int16_t *window = lab::activity_model_inputs[vector];
+        for (size_t k = 0; k < lab::ACTIVITY_MODEL_WINDOW; k++) {
+            arena[k] = (uint8_t)model.quantize(window[k]);
+        }
+        const int8_t *logits = model.invoke(arena, sizeof(arena), Reference);
+        if (!logits || memcmp(logits, lab::activity_model_logits[vector], model.classes())) {
+            mismatches++;
+        }
+        vector = (vector + 1) % lab::ACTIVITY_MODEL_VECTORS;
+    }
+    if (mismatches) {
+        state.SkipWithError("logits differ from int8_model.py");
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_ActivityInference(benchmark::State &state)
+{
+    inference<false>(state);
+}
+BENCHMARK(BM_ActivityInference);
+
+static void BM_ActivityInferenceReference(benchmark::State &state)
+{
+    inference<true>(state);
+}
+BENCHMARK(BM_ActivityInferenceReference);
+
+/** Sample by sample through the classifier, a window every 32 samples. */
+static void BM_ActivityClassifierPush(benchmark::State &state)
+{
+    if (!load(state)) {
+        return;
+    }
+    classifier.reset();
+    const int16_t *window = lab::activity_model_inputs[2];
+    size_t sample = 0;
+    int windows = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < 32; i++) {
+            windows += classifier.push(window + 3 * (sample++ % 64));
+        }
+    }
+    // the first window fills after two iterations
+    if (windows != (int)state.iterations() - 1) {
+        state.SkipWithError("one window per hop expected");
+    }
+    state.SetItemsProcessed(state.iterations() * 32);
+}
+BENCHMARK(BM_ActivityClassifierPush);
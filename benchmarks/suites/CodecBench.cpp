@@ -0,0 +1,370 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(__MBED__)
+#include <fstream>
+#endif
+
+#include "BenchSignals.h"
+#include "ImuCodec.h"
+
+/*
+ * IMU stream codec: throughput in raw bytes per second and the
+ * compression ratio on the bench signal, lossless and with the two gyro
+ * noise bits dropped.
+ *
+ * The Trace benchmarks do the same on a recording of the WiFi example,
+ * a data/data-*.txt file of client-server/server.py named by
+ * LAB_BENCH_TRACE, and on the bench signal when there is none (always on
+ * the board). BM_ImuRoundTrip encodes and decodes the whole trace and
+ * checks every value: the same bits lossless, from the first key block
+ * on for a decoder joining mid-stream, within half a step with the gyro
+ * shift.
+ */
+
+static const size_t FRAMES = 32;
+static const size_t BLOCKS = 16;
+
+static int16_t samples[BLOCKS * FRAMES * 6];
+
+static const int16_t *signal()
+{
+    static bool ready;
+    if (!ready) {
+        bench_imu_frames(samples, BLOCKS * FRAMES);
+        ready = true;
+    }
+    return samples;
+}
+
+static lab::ImuCodecConfig codec_config(uint8_t gyro_shift, uint16_t key_interval = 16)
+{
+    lab::ImuCodecConfig config = {};
+    config.channels = 6;
+    config.key_interval = key_interval;
+    for (int c = 3; c < 6; c++) {
+        config.quant_shift[c] = gyro_shift;
+    }
+    return config;
+}
+
+static void encode(benchmark::State &state, uint8_t gyro_shift)
+{
+    const int16_t *values = signal();
+    lab::ImuEncoder encoder(codec_config(gyro_shift));
+    static uint8_t block[512];
+    size_t encoded = 0;
+    size_t block_index = 0;
+    for (auto _ : state) {
+        int size = encoder.encode(values + block_index * FRAMES * 6, FRAMES, block, sizeof(block));
+        benchmark::DoNotOptimize(size);
+        benchmark::ClobberMemory();
+        encoded += size;
+        block_index = (block_index + 1) % BLOCKS;
+    }
+    size_t raw = state.iterations() * FRAMES * 6 * sizeof(int16_t);
+    state.SetBytesProcessed(raw);
+    state.counters["ratio"] = encoded ? (double)raw / encoded : 0;
+}
+
+static void BM_ImuEncodeLossless(benchmark::State &state)
+{
+    encode(state, 0);
+}
+BENCHMARK(BM_ImuEncodeLossless);
+
+static void BM_ImuEncodeGyroShift2(benchmark::State &state)
+{
+    encode(state, 2);
+}
+BENCHMARK(BM_ImuEncodeGyroShift2);
+
+static void BM_ImuDecode(benchmark::State &state)
+{
+    const int16_t *values = signal();
+    lab::ImuEncoder encoder(codec_config(0));
+    static uint8_t stream[BLOCKS * 512];
+    size_t offsets[BLOCKS + 1] = { 0 };
+    for (size_t b = 0; b < BLOCKS; b++) {
+        int size = encoder.encode(values + b * FRAMES * 6, FRAMES, stream + offsets[b], 512);
+        offsets[b + 1] = offsets[b] + (size > 0 ? size : 0);
+    }
+
+    lab::ImuDecoder decoder;
+    static int16_t decoded[FRAMES * 6];
+    size_t block_index = 0;
+    size_t last = 0;
+    for (auto _ : state) {
+        int frames = decoder.decode(stream + offsets[block_index], offsets[block_index + 1] - offsets[block_index],
+                                    decoded, FRAMES, nullptr);
+        benchmark::DoNotOptimize(frames);
+        benchmark::ClobberMemory();
+        last = block_index;
+        block_index = (block_index + 1) % BLOCKS;
+    }
+    if (memcmp(decoded, values + last * FRAMES * 6, sizeof(decoded)) != 0) {
+        state.SkipWithError("decoded frames differ from the input");
+    }
+    state.SetBytesProcessed(state.iterations() * FRAMES * 6 * sizeof(int16_t));
+}
+BENCHMARK(BM_ImuDecode);
+
+struct Trace {
+    std::vector<int16_t> values;
+    size_t frames;
+    /** Why the file named by LAB_BENCH_TRACE gave no trace, or null. */
+    const char *error;
+};
+
+#if !defined(__MBED__)
+/* B-L475E-IOT01 BSP: accelerometer in mg, gyroscope in mdps at 2000 dps. */
+static const double GYRO_MDPS_PER_LSB = 70.0;
+
+static int16_t clamp16(double value)
+{
+    long v = lround(value);
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+/** Number after "key": in a JSON line, json.dumps spacing or not. */
+static bool field(const std::string &line, const char *key, double &value)
+{
+    size_t at = line.find(key);
+    if (at == std::string::npos) {
+        return false;
+    }
+    at += strlen(key);
+    while (at < line.size() && line[at] == ' ') {
+        at++;
+    }
+    if (at >= line.size() || line[at] != ':') {
+        return false;
+    }
+    const char *start = line.c_str() + at + 1;
+    char *end;
+    value = strtod(start, &end);
+    return end != start;
+}
+
+/**
+ * Raw samples of a server.py recording, frames of the bench signal
+ * layout: accelerometer X Y Z as sent, gyroscope X Y Z back to LSB. The
+ * feature, metric, snippet and activity lines in between are skipped.
+ */
+static bool load_trace(const char *path, Trace &trace)
+{
+    std::ifstream input(path);
+    if (!input) {
+        return false;
+    }
+    static const char *const keys[6] = { "\"a_x\"", "\"a_y\"", "\"a_z\"", "\"g_x\"", "\"g_y\"", "\"g_z\"" };
+    std::string line;
+    while (std::getline(input, line)) {
+        double values[6];
+        size_t found = 0;
+        while (found < 6 && field(line, keys[found], values[found])) {
+            found++;
+        }
+        if (found < 6) {
+            continue;
+        }
+        for (size_t c = 0; c < 6; c++) {
+            trace.values.push_back(clamp16(c < 3 ? values[c] : values[c] / GYRO_MDPS_PER_LSB));
+        }
+        trace.frames++;
+    }
+    return trace.frames > 0;
+}
+#endif
+
+static const Trace &trace()
+{
+    static Trace trace;
+    static bool ready;
+    if (!ready) {
+        ready = true;
+#if !defined(__MBED__)
+        const char *path = getenv("LAB_BENCH_TRACE");
+        if (path && *path) {
+            if (!load_trace(path, trace)) {
+                trace.error = "LAB_BENCH_TRACE: no samples";
+            }
+            return trace;
+        }
+#endif
+        trace.values.assign(signal(), signal() + BLOCKS * FRAMES * 6);
+        trace.frames = BLOCKS * FRAMES;
+    }
+    return trace;
+}
+
+/** Frames of block b of the trace, the last one may be short. */
+static size_t block_frames(const Trace &trace, size_t b)
+{
+    size_t left = trace.frames - b * FRAMES;
+    return left < FRAMES ? left : FRAMES;
+}
+
+static size_t block_count(const Trace &trace)
+{
+    return (trace.frames + FRAMES - 1) / FRAMES;
+}
+
+static void encode_trace(benchmark::State &state, uint8_t gyro_shift)
+{
+    const Trace &input = trace();
+    if (input.error) {
+        state.SkipWithError(input.error);
+        return;
+    }
+    lab::ImuEncoder encoder(codec_config(gyro_shift));
+    static uint8_t block[512];
+    size_t encoded = 0;
+    size_t raw = 0;
+    size_t block_index = 0;
+    for (auto _ : state) {
+        size_t frames = block_frames(input, block_index);
+        int size = encoder.encode(&input.values[block_index * FRAMES * 6], frames, block, sizeof(block));
+        benchmark::DoNotOptimize(size);
+        benchmark::ClobberMemory();
+        encoded += size;
+        raw += frames * 6 * sizeof(int16_t);
+        block_index = (block_index + 1) % block_count(input);
+    }
+    state.SetBytesProcessed(raw);
+    state.counters["ratio"] = encoded ? (double)raw / encoded : 0;
+    state.counters["frames"] = (double)input.frames;
+}
+
+static void BM_ImuEncodeTrace(benchmark::State &state)
+{
+    encode_trace(state, 0);
+}
+BENCHMARK(BM_ImuEncodeTrace);
+
+static void BM_ImuEncodeTraceGyroShift2(benchmark::State &state)
+{
+    encode_trace(state, 2);
+}
+BENCHMARK(BM_ImuEncodeTraceGyroShift2);
+
+/**
+ * The whole trace as one stream, offsets[b] the start of block b and
+ * offsets.back() the end.
+ *
+ * @return false if a block did not fit.
+ */
+static bool encode_stream(const Trace &input, const lab::ImuCodecConfig &config, std::vector<uint8_t> &stream,
+                          std::vector<size_t> &offsets)
+{
+    lab::ImuEncoder encoder(config);
+    size_t block_size = encoder.max_block_size(FRAMES);
+    stream.resize(block_count(input) * block_size);
+    offsets.assign(1, 0);
+    for (size_t b = 0; b < block_count(input); b++) {
+        int size = encoder.encode(&input.values[b * FRAMES * 6], block_frames(input, b), &stream[offsets[b]],
+                                  block_size);
+        if (size <= 0) {
+            return false;
+        }
+        offsets.push_back(offsets[b] + size);
+    }
+    return true;
+}
+
+/**
+ * Decode a stream from block first on into decoded, each frame where it
+ * is in the input.
+ *
+ * @return frames decoded, the blocks before a key block skipped, or -1
+ * on an error.
+ */
+static long decode_stream(const Trace &input, const std::vector<uint8_t> &stream, const std::vector<size_t> &offsets,
+                          size_t first, std::vector<int16_t> &decoded)
+{
+    lab::ImuDecoder decoder;
+    decoded.assign(input.values.size(), 0);
+    long total = 0;
+    for (size_t b = first; b < block_count(input); b++) {
+        size_t used = 0;
+        int frames = decoder.decode(&stream[offsets[b]], offsets.back() - offsets[b], &decoded[b * FRAMES * 6],
+                                    FRAMES, &used);
+        if (frames == -2 && total == 0) {
+            continue;
+        }
+        if (frames < 0 || (size_t)frames != block_frames(input, b) || used != offsets[b + 1] - offsets[b]) {
+            return -1;
+        }
+        total += frames;
+    }
+    return total;
+}
+
+static bool round_trip_error(const Trace &input, const char *&error)
+{
+    std::vector<uint8_t> stream;
+    std::vector<size_t> offsets;
+    std::vector<int16_t> decoded;
+
+    if (!encode_stream(input, codec_config(0), stream, offsets) ||
+        decode_stream(input, stream, offsets, 0, decoded) != (long)input.frames || decoded != input.values) {
+        error = "lossless round trip differs from the input";
+        return true;
+    }
+
+    // a decoder joining at block 1 waits for the key block 4 and is exact from there
+    const uint16_t KEY_INTERVAL = 4;
+    if (block_count(input) > KEY_INTERVAL) {
+        long expected = (long)(input.frames - KEY_INTERVAL * FRAMES);
+        size_t from = KEY_INTERVAL * FRAMES * 6;
+        if (!encode_stream(input, codec_config(0, KEY_INTERVAL), stream, offsets) ||
+            decode_stream(input, stream, offsets, 1, decoded) != expected ||
+            !std::equal(input.values.begin() + from, input.values.end(), decoded.begin() + from)) {
+            error = "round trip joined mid-stream differs from the input";
+            return true;
+        }
+    }
+
+    if (!encode_stream(input, codec_config(2), stream, offsets) ||
+        decode_stream(input, stream, offsets, 0, decoded) != (long)input.frames) {
+        error = "gyro shift round trip failed";
+        return true;
+    }
+    for (size_t i = 0; i < input.values.size(); i++) {
+        int step = i % 6 < 3 ? 0 : 4;
+        int allowed = input.values[i] > 32767 - step / 2 ? step : step / 2;
+        if (abs(decoded[i] - input.values[i]) > allowed) {
+            error = "gyro shift round trip off by more than half a step";
+            return true;
+        }
+    }
+    return false;
+}
+
+static void BM_ImuRoundTrip(benchmark::State &state)
+{
+    const Trace &input = trace();
+    const char *error = input.error;
+    if (error || round_trip_error(input, error)) {
+        state.SkipWithError(error);
+        return;
+    }
+    std::vector<uint8_t> stream;
+    std::vector<size_t> offsets;
+    std::vector<int16_t> decoded;
+    for (auto _ : state) {
+        encode_stream(input, codec_config(0), stream, offsets);
+        long frames = decode_stream(input, stream, offsets, 0, decoded);
+        benchmark::DoNotOptimize(frames);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * input.values.size() * sizeof(int16_t));
+    state.counters["ratio"] = (double)(input.values.size() * sizeof(int16_t)) / offsets.back();
+}
+BENCHMARK(BM_ImuRoundTrip);
@@ -0,0 +1,92 @@
+#include "Bench.h"
+
+#include "BenchSignals.h"
+#include "FixedRealFft.h"
+#include "VibrationFeatures.h"
+
+/*
+ * Vibration features: the bare fixed-point FFT, and one hop of the WiFi
+ * example analyzer (512 sample window, 256 hop, 3 axes, 3 bands), which
+ * is the whole per-window cost on the device.
+ */
+
+static const size_t SIGNAL_FRAMES = 512;
+
+static int16_t samples[SIGNAL_FRAMES * 6];
+
+static const int16_t *signal()
+{
+    static bool ready;
+    if (!ready) {
+        bench_imu_frames(samples, SIGNAL_FRAMES);
+        ready = true;
+    }
+    return samples;
+}
+
+template<size_t Size>
+static void fft(benchmark::State &state)
+{
+    static lab::FixedRealFft<Size> transform;
+    static int16_t input[Size];
+    static int32_t output[Size + 2];
+    const int16_t *values = signal();
+    for (size_t i = 0; i < Size; i++) {
+        input[i] = values[6 * i];
+    }
+    for (auto _ : state) {
+        transform.forward(input, output);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * Size);
+}
+
+static void BM_FixedRealFft256(benchmark::State &state)
+{
+    fft<256>(state);
+}
+BENCHMARK(BM_FixedRealFft256);
+
+static void BM_FixedRealFft512(benchmark::State &state)
+{
+    fft<512>(state);
+}
+BENCHMARK(BM_FixedRealFft512);
+
+static void BM_VibrationHop(benchmark::State &state)
+{
+    static lab::VibrationAnalyzer<512, 3> analyzer;
+    lab::VibrationConfig config = {};
+    config.sample_rate_hz = 1660.0f;
+    config.hop = 256;
+    config.scale = 0.061f;
+    config.band_count = 3;
+    config.bands[0] = { 10.0f, 100.0f };
+    config.bands[1] = { 100.0f, 300.0f };
+    config.bands[2] = { 300.0f, 830.0f };
+    config.kurtosis_threshold = 6.0f;
+    if (analyzer.configure(config)) {
+        state.SkipWithError("analyzer configuration rejected");
+        return;
+    }
+    analyzer.reset();
+
+    const int16_t *values = signal();
+    uint32_t timestamp_us = 0;
+    size_t frame = 0;
+    /* fill the first window outside the measurement */
+    while (frame < 512) {
+        analyzer.push(values + 6 * (frame++ % SIGNAL_FRAMES), timestamp_us += 602);
+    }
+    int windows = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < 256; i++) {
+            windows += analyzer.push(values + 6 * (frame++ % SIGNAL_FRAMES), timestamp_us += 602);
+        }
+    }
+    if (windows != state.iterations()) {
+        state.SkipWithError("one window per hop expected");
+    }
+    state.SetItemsProcessed(state.iterations() * 256 * 3);
+}
+BENCHMARK(BM_VibrationHop);
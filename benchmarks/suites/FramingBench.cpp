@@ -0,0 +1,79 @@
+#include "Bench.h"
+
+#include <cstdio>
+
+#include "DeferredLog.h"
+
+/*
+ * Log framing: what a LAB_LOG statement costs the caller against the
+ * snprintf it replaced, and what the log thread pays to turn a record
+ * into a binary frame or a text line.
+ */
+
+static void BM_LogRecord(benchmark::State &state)
+{
+    lab::LogRecord record;
+    int sequence = 0;
+    for (auto _ : state) {
+        LAB_LOG_INFO("sample %d: %d mg, %d mg, %d mg", sequence++, 12, -980, 31);
+        lab::log_pop(record);
+        benchmark::DoNotOptimize(record);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogRecord);
+
+static void BM_LogSnprintf(benchmark::State &state)
+{
+    char line[80];
+    int sequence = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(snprintf(line, sizeof(line), "sample %d: %d mg, %d mg, %d mg",
+                                          sequence++, 12, -980, 31));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LogSnprintf);
+
+static lab::LogRecord sample_record()
+{
+    lab::LogRecord record = {};
+    record.format = "sample %d: %d mg, %d mg, %d mg";
+    record.timestamp_us = 123456789;
+    record.level = LAB_LOG_LEVEL_INFO;
+    record.arg_count = 4;
+    record.args[0] = 42;
+    record.args[1] = 12;
+    record.args[2] = (lab::log_arg_t) -980;
+    record.args[3] = 31;
+    return record;
+}
+
+static void BM_LogEncodeFrame(benchmark::State &state)
+{
+    lab::LogRecord record = sample_record();
+    static uint8_t frame[lab::LOG_FRAME_MAX];
+    size_t length = 0;
+    for (auto _ : state) {
+        length = lab::log_encode(record, frame, sizeof(frame));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_LogEncodeFrame);
+
+static void BM_LogFormatLine(benchmark::State &state)
+{
+    lab::LogRecord record = sample_record();
+    static char line[128];
+    size_t length = 0;
+    for (auto _ : state) {
+        length = lab::log_format(record, line, sizeof(line));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_LogFormatLine);
@@ -0,0 +1,77 @@
+#include "Bench.h"
+
+#include "BenchSignals.h"
+#include "ImuCodec.h"
+
+/*
+ * Packing IMU frames into one notification. 244 bytes is the largest
+ * ATT payload with the data length extension (247 byte MTU): 20 raw
+ * frames, against what the codec does with the same 20 frames. The
+ * counter is the notification size.
+ */
+
+static const size_t FRAMES = 20;
+static const size_t PAYLOAD = 244;
+static const size_t WINDOWS = 8;
+
+static int16_t samples[WINDOWS * FRAMES * 6];
+
+static const int16_t *signal()
+{
+    static bool ready;
+    if (!ready) {
+        bench_imu_frames(samples, WINDOWS * FRAMES);
+        ready = true;
+    }
+    return samples;
+}
+
+/* Little endian on the air whatever the CPU. */
+static size_t pack_raw(const int16_t *values, size_t frames, uint8_t *payload)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < frames * 6; i++) {
+        payload[length++] = (uint8_t)values[i];
+        payload[length++] = (uint8_t)((uint16_t)values[i] >> 8);
+    }
+    return length;
+}
+
+static void BM_GattPackRaw(benchmark::State &state)
+{
+    const int16_t *values = signal();
+    static uint8_t payload[PAYLOAD];
+    size_t length = 0;
+    size_t window = 0;
+    for (auto _ : state) {
+        length = pack_raw(values + window * FRAMES * 6, FRAMES, payload);
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+        window = (window + 1) % WINDOWS;
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+    state.counters["bytes"] = length;
+}
+BENCHMARK(BM_GattPackRaw);
+
+static void BM_GattPackEncoded(benchmark::State &state)
+{
+    const int16_t *values = signal();
+    lab::ImuCodecConfig config = {};
+    config.channels = 6;
+    config.key_interval = 8;
+    lab::ImuEncoder encoder(config);
+    static uint8_t payload[PAYLOAD];
+    size_t total = 0;
+    size_t window = 0;
+    for (auto _ : state) {
+        int length = encoder.encode(values + window * FRAMES * 6, FRAMES, payload, sizeof(payload));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+        total += length > 0 ? length : 0;
+        window = (window + 1) % WINDOWS;
+    }
+    state.SetItemsProcessed(state.iterations() * FRAMES);
+    state.counters["bytes"] = (double)total / state.iterations();
+}
+BENCHMARK(BM_GattPackEncoded);
@@ -0,0 +1,80 @@
+#include "Bench.h"
+
+#include <cstdio>
+
+#include "BenchSignals.h"
+
+/*
+ * JSON telemetry as the WiFi example writes it: one raw sample, one
+ * feature frame (3 axes, 4 bands) and a 64 sample anomaly snippet. The
+ * formatting, floats in particular, is what the device pays; parsing is
+ * done by server.py on the host.
+ */
+
+static void BM_JsonSample(benchmark::State &state)
+{
+    char frame[128];
+    int count = 0;
+    int length = 0;
+    for (auto _ : state) {
+        length = snprintf(frame, sizeof(frame),
+                          "{\"a_x\":%d,\"a_y\":%d,\"a_z\":%d,\"g_x\":%.2f,\"g_y\":%.2f,\"g_z\":%.2f,\"s\":%d}",
+                          12, -31, 1002, 175.0f, -8.75f, 35.0f, count++);
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_JsonSample);
+
+static void BM_JsonFeatures(benchmark::State &state)
+{
+    static const float axes[3][8] = {
+        { 18.2f, 3.1f, 60.1f, 12.9f, 1.5f, 88.0f, 4.2f, 0.3f },
+        { 9.1f, 2.9f, 60.0f, 6.4f, 0.7f, 21.9f, 1.1f, 0.1f },
+        { 4.8f, 3.4f, 120.2f, 2.2f, 0.2f, 3.1f, 5.6f, 0.2f },
+    };
+    static char frame[512];
+    int length = 0;
+    uint32_t timestamp_us = 1000000;
+    uint16_t sequence = 0;
+    for (auto _ : state) {
+        length = snprintf(frame, sizeof(frame), "{\"t\":%lu,\"s\":%u,\"an\":%u,\"f\":[",
+                          (unsigned long)timestamp_us, sequence++, 0u);
+        for (int a = 0; a < 3; a++) {
+            const float *axis = axes[a];
+            length += snprintf(frame + length, sizeof(frame) - length, "%s[%.1f,%.2f,%.1f,%.1f",
+                               a ? "," : "", axis[0], axis[1], axis[2], axis[3]);
+            for (int b = 4; b < 8; b++) {
+                length += snprintf(frame + length, sizeof(frame) - length, ",%.1f", axis[b]);
+            }
+            length += snprintf(frame + length, sizeof(frame) - length, "]");
+        }
+        length += snprintf(frame + length, sizeof(frame) - length, "]}");
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+        timestamp_us += 80000;
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_JsonFeatures);
+
+static void BM_JsonSnippet(benchmark::State &state)
+{
+    static int16_t raw[64 * 6];
+    static char frame[512];
+    bench_imu_frames(raw, 64);
+    int length = 0;
+    for (auto _ : state) {
+        length = snprintf(frame, sizeof(frame), "{\"snip\":%d,\"t\":%lu,\"v\":[", 2, 1000000ul);
+        for (size_t i = 0; i < 64; i++) {
+            length += snprintf(frame + length, sizeof(frame) - length, i ? ",%d" : "%d", raw[6 * i + 2]);
+        }
+        length += snprintf(frame + length, sizeof(frame) - length, "]}");
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+    state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_JsonSnippet);
@@ -0,0 +1,93 @@
+#include "Bench.h"
+
+#include "Metrics.h"
+
+/*
+ * Runtime metrics: the update on the hot path and the three exports. The
+ * set mirrors the WiFi example, so the export sizes are the real ones.
+ * Every metric of the image is in the registry, keep them all here.
+ */
+
+static lab::Counter sent_frames("tx.frames");
+static lab::Counter sent_bytes("tx.bytes");
+static lab::Counter send_errors("tx.errors");
+static lab::Counter stored_frames("tx.stored");
+static lab::Counter lost_frames("tx.lost");
+static lab::Counter replayed_frames("tx.replayed");
+static lab::Counter host_connects("net.connects");
+static lab::Gauge tx_queue_depth("tx.queue");
+static lab::Gauge backlog_depth("backlog.pages");
+static lab::Gauge cpu_load("cpu.load_pct");
+static const uint32_t latency_bounds_ms[] = { 10, 20, 50, 100, 200, 500, 1000 };
+static lab::Histogram<7> send_latency("tx.latency_ms", latency_bounds_ms);
+
+static void BM_CounterInc(benchmark::State &state)
+{
+    for (auto _ : state) {
+        sent_frames.inc();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CounterInc);
+
+static void BM_GaugeSet(benchmark::State &state)
+{
+    int32_t depth = 0;
+    for (auto _ : state) {
+        tx_queue_depth.set(depth++ & 7);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_GaugeSet);
+
+static void BM_HistogramRecord(benchmark::State &state)
+{
+    uint32_t latency = 0;
+    for (auto _ : state) {
+        send_latency.record(latency);
+        latency = (latency + 37) % 1500;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HistogramRecord);
+
+static void BM_MetricsText(benchmark::State &state)
+{
+    static char text[512];
+    int length = 0;
+    for (auto _ : state) {
+        length = lab::MetricsRegistry::format_text(text, sizeof(text));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_MetricsText);
+
+static void BM_MetricsJson(benchmark::State &state)
+{
+    static char json[512];
+    int length = 0;
+    for (auto _ : state) {
+        length = lab::MetricsRegistry::format_json(json, sizeof(json));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+}
+BENCHMARK(BM_MetricsJson);
+
+/* The binary snapshot the Button example serves as a characteristic. */
+static void BM_MetricsEncode(benchmark::State &state)
+{
+    static uint8_t snapshot[256];
+    int length = 0;
+    for (auto _ : state) {
+        length = lab::MetricsRegistry::encode(snapshot, sizeof(snapshot));
+        benchmark::DoNotOptimize(length);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * length);
+    state.counters["bytes"] = length;
+}
+BENCHMARK(BM_MetricsEncode);
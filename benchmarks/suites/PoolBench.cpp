@@ -0,0 +1,51 @@
+#include "Bench.h"
+
+#include <cstdlib>
+
+#include "BlockPool.h"
+#include "PoolAllocator.h"
+
+/*
+ * Network buffer allocation: the lock-free block pools and the size
+ * class allocator of the WiFi example, against the heap they replaced.
+ */
+
+static lab::BlockPool<128, 8> frame_pool;
+static lab::BlockPool<512, 8> batch_pool;
+
+static void BM_BlockPoolAllocFree(benchmark::State &state)
+{
+    for (auto _ : state) {
+        void *block = batch_pool.alloc();
+        benchmark::DoNotOptimize(block);
+        batch_pool.free(block);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlockPoolAllocFree);
+
+static void BM_PoolBuffer(benchmark::State &state)
+{
+    static lab::PoolAllocator buffers;
+    if (!buffers.classes()) {
+        buffers.add(frame_pool);
+        buffers.add(batch_pool);
+    }
+    for (auto _ : state) {
+        lab::PoolBuffer frame(buffers, 512);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PoolBuffer);
+
+static void BM_MallocFree(benchmark::State &state)
+{
+    for (auto _ : state) {
+        void *block = malloc(512);
+        benchmark::DoNotOptimize(block);
+        free(block);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MallocFree);
@@ -0,0 +1,44 @@
+#include "Bench.h"
+
+#include <cstdint>
+
+/*
+ * PWM duty ramps as in the pwmout snippet: a 100 us period swept from 0
+ * to 99 % in 1 % steps. The float ramp does what PwmOut::write(float)
+ * does to turn a duty into a compare value for each step; the table ramp
+ * looks the compare values up. Timer writes are not part of it.
+ */
+
+static const uint32_t PERIOD_TICKS = 8000;   // 100 us at 80 MHz
+static const int STEPS = 100;
+
+static uint32_t compare;
+
+static void BM_PwmRampFloat(benchmark::State &state)
+{
+    for (auto _ : state) {
+        for (float duty = 0; duty <= 0.99f; duty += 0.01f) {
+            float clamped = duty < 0 ? 0 : (duty > 1 ? 1 : duty);
+            compare = (uint32_t)(clamped * PERIOD_TICKS);
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * STEPS);
+}
+BENCHMARK(BM_PwmRampFloat);
+
+static void BM_PwmRampTable(benchmark::State &state)
+{
+    static uint16_t table[STEPS];
+    for (int i = 0; i < STEPS; i++) {
+        table[i] = (uint16_t)(PERIOD_TICKS * i / 100);
+    }
+    for (auto _ : state) {
+        for (int i = 0; i < STEPS; i++) {
+            compare = table[i];
+            benchmark::ClobberMemory();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * STEPS);
+}
+BENCHMARK(BM_PwmRampTable);
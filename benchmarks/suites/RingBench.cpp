@@ -0,0 +1,54 @@
+#include "Bench.h"
+
+#include "MpscRing.h"
+#include "SensorRecord.h"
+#include "SpscRing.h"
+
+/*
+ * Lock-free rings between interrupts and threads. Single threaded here:
+ * the numbers are the cost of one push and one pop, not contention.
+ */
+
+static void BM_SpscRingPushPop(benchmark::State &state)
+{
+    static lab::SpscRing<uint32_t, 64> ring;
+    uint32_t value = 0;
+    for (auto _ : state) {
+        ring.push(value++);
+        ring.pop(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpscRingPushPop);
+
+static void BM_SpscRingRecordBatch(benchmark::State &state)
+{
+    static lab::SpscRing<lab::SensorRecord, 32> ring;
+    lab::SensorRecord record = {};
+    lab::SensorRecord batch[16];
+    for (auto _ : state) {
+        for (int i = 0; i < 16; i++) {
+            record.sequence = i;
+            ring.push(record);
+        }
+        benchmark::DoNotOptimize(ring.pop_batch(batch, 16));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * 16);
+    state.SetBytesProcessed(state.iterations() * 16 * sizeof(lab::SensorRecord));
+}
+BENCHMARK(BM_SpscRingRecordBatch);
+
+static void BM_MpscRingPushPop(benchmark::State &state)
+{
+    static lab::MpscRing<uint32_t, 64> ring;
+    uint32_t value = 0;
+    for (auto _ : state) {
+        ring.push(value++);
+        ring.pop(value);
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MpscRingPushPop);
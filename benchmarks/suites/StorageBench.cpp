@@ -0,0 +1,130 @@
+#include "Bench.h"
+
+#include <cstring>
+
+#include "Crc32.h"
+#include "FlashDevice.h"
+#include "FlashRingLog.h"
+
+/*
+ * Flash ring log over a RAM flash: the CPU side of appending and
+ * replaying telemetry records (page CRCs, header scans, copies). The
+ * QSPI program and erase times come on top on the board.
+ */
+
+namespace {
+
+/** NOR flash in RAM: programming clears bits, erasing sets them. */
+class RamFlash : public lab::FlashDevice {
+public:
+    static const uint32_t SIZE = 16 * 1024;
+
+    RamFlash()
+    {
+        memset(_cells, 0xFF, sizeof(_cells));
+    }
+
+    int read(uint32_t address, void *data, size_t length) override
+    {
+        memcpy(data, _cells + address, length);
+        return 0;
+    }
+
+    int program(uint32_t address, const void *data, size_t length) override
+    {
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        for (size_t i = 0; i < length; i++) {
+            _cells[address + i] &= bytes[i];
+        }
+        return 0;
+    }
+
+    int erase(uint32_t address, size_t length) override
+    {
+        memset(_cells + address, 0xFF, length);
+        return 0;
+    }
+
+    size_t page_size() const override
+    {
+        return 256;
+    }
+
+    size_t sector_size() const override
+    {
+        return 4096;
+    }
+
+    uint32_t size() const override
+    {
+        return SIZE;
+    }
+
+private:
+    uint8_t _cells[SIZE];
+};
+
+RamFlash flash;
+lab::FlashRingLog<256> ring_log(flash, 0, RamFlash::SIZE);
+
+/* A telemetry sample frame, the size the WiFi example stores. */
+const char record[] = "{\"a_x\":12,\"a_y\":-31,\"a_z\":1002,\"g_x\":175.00,\"g_y\":-8.75,\"g_z\":35.00,\"s\":1234}";
+
+} // namespace
+
+static void BM_Crc32Page(benchmark::State &state)
+{
+    static uint8_t page[256];
+    for (size_t i = 0; i < sizeof(page); i++) {
+        page[i] = (uint8_t)(i * 7);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lab::crc32(page, sizeof(page)));
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(page));
+}
+BENCHMARK(BM_Crc32Page);
+
+static void BM_FlashRingAppend(benchmark::State &state)
+{
+    if (ring_log.format()) {
+        state.SkipWithError("format failed");
+        return;
+    }
+    for (auto _ : state) {
+        if (ring_log.append(record, sizeof(record))) {
+            state.SkipWithError("append failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(record));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlashRingAppend);
+
+static void BM_FlashRingReplay(benchmark::State &state)
+{
+    if (ring_log.format()) {
+        state.SkipWithError("format failed");
+        return;
+    }
+    char replayed[256];
+    for (auto _ : state) {
+        if (ring_log.empty()) {
+            state.PauseTiming();
+            for (int i = 0; i < 128; i++) {
+                ring_log.append(record, sizeof(record));
+            }
+            ring_log.flush();
+            state.ResumeTiming();
+        }
+        int length = ring_log.peek(replayed, sizeof(replayed));
+        if (length != (int)sizeof(record) || ring_log.consume()) {
+            state.SkipWithError("replay failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(record));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlashRingReplay);
@@ -0,0 +1,55 @@
+#include "mbed.h"
+
+#include "Bench.h"
+#include "BootProfile.h"
+
+/*
+ * The benchmark suites on the board. Every suite in ../suites is linked
+ * in; results are measured in DWT cycles and printed as BENCH lines.
+ * A run starts on any byte received on the console, so bench.py sees it
+ * from its first line; 'f' followed by a name fragment and a newline
+ * runs the matching benchmarks only.
+ */
+
+static BufferedSerial serial_port(USBTX, USBRX);
+FileHandle *mbed::mbed_override_console(int fd)
+{
+    return &serial_port;
+}
+
+static char filter[32];
+
+static const char *read_command()
+{
+    char c;
+    serial_port.read(&c, 1);
+    if (c != 'f') {
+        return nullptr;
+    }
+    size_t length = 0;
+    while (serial_port.read(&c, 1) == 1 && c != '\n' && c != '\r') {
+        if (length + 1 < sizeof(filter)) {
+            filter[length++] = c;
+        }
+    }
+    filter[length] = '\0';
+    return length ? filter : nullptr;
+}
+
+int main()
+{
+    // switches the cycle counter on
+    lab::BootProfile::begin();
+
+    // no deep sleep in between: the clocks stay put from run to run
+    sleep_manager_lock_deep_sleep();
+
+    lab::BenchOptions options;
+    options.min_ticks = lab::bench_clock_hz() / 10;
+
+    for (;;) {
+        printf("BENCH-READY %lu Hz\n", (unsigned long)lab::bench_clock_hz());
+        options.filter = read_command();
+        lab::run_benchmarks(options, stdout);
+    }
+}
@@ -0,0 +1,190 @@
+#include <cstdint>
+#include <cstdio>
+
+#include "AcquisitionScheduler.h"
+#include "Check.h"
+#include "SimulatedSensorBus.h"
+
+/*
+ * AcquisitionScheduler on a SimulatedSensorBus with the six channels of
+ * disco_l475_add_sensors() at their default rates, every transaction as
+ * long as its cost estimate, for seconds of virtual time:
+ *
+ * - gyroscope and accelerometer reads never start later than one
+ *   environmental transaction after they are due, the one of the pair
+ *   going second waiting for the other, never for the slower sensors;
+ * - every channel gets each of its periods, none is skipped;
+ * - the records per second are those of the configured rates;
+ * - the same from 5 s before the 32-bit microsecond counter wraps, and
+ *   with the pressure sensor triggered again by each of its reads, as by
+ *   a data-ready interrupt, so that it is picked ahead of its poll
+ *   whenever it fits, and only then;
+ * - a failed transaction shows in the errors of its channel only.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+/** The table of disco_l475_add_sensors(), which needs the BSP. */
+const uint32_t ENVIRONMENT_US = 1500;
+const uint32_t IMU_US = 1000;
+
+struct Sensor {
+    SensorChannelConfig config;
+    uint8_t axes;
+};
+
+const Sensor SENSORS[] = {
+    { { "temperature", 1000000, 1, nullptr, nullptr, ENVIRONMENT_US }, 1 },
+    { { "humidity",    1000000, 1, nullptr, nullptr, ENVIRONMENT_US }, 1 },
+    { { "pressure",    1000000, 1, nullptr, nullptr, ENVIRONMENT_US }, 1 },
+    { { "magneto",     50000,   2, nullptr, nullptr, 1000 },           3 },
+    { { "gyro",        10000,   3, nullptr, nullptr, IMU_US },         3 },
+    { { "accelero",    10000,   3, nullptr, nullptr, IMU_US },         3 },
+};
+const int CHANNELS = sizeof(SENSORS) / sizeof(SENSORS[0]);
+const int PRESSURE = 2;
+const int GYRO = 4;
+const int ACCELERO = 5;
+const int TEMPERATURE = 0;
+
+const uint32_t RUN_US = 10000000;
+/** Tolerance of the records per second against the configured rates. */
+const double RATE_ERROR = 0.001;
+
+double configured_rate()
+{
+    double rate = 0.0;
+    for (const Sensor &sensor : SENSORS) {
+        rate += 1e6 / sensor.config.period_us;
+    }
+    return rate;
+}
+
+struct Bench {
+    AcquisitionScheduler scheduler;
+    SimulatedSensorBus bus;
+    /**
+     * Channel triggered again by each of its records, as a sensor
+     * converting continuously raises data-ready, -1 for none.
+     */
+    int continuous;
+    uint32_t sunk;
+
+    explicit Bench(uint32_t start_us) :
+        bus(start_us),
+        continuous(-1),
+        sunk(0)
+    {
+        for (const Sensor &sensor : SENSORS) {
+            bus.attach(scheduler, sensor.config, sensor.config.cost_us, sensor.axes);
+        }
+        scheduler.start(bus.now());
+    }
+
+    SimulatedSensorBus::RunStats run(uint32_t duration_us)
+    {
+        return bus.run(scheduler, duration_us, &Bench::sink, this);
+    }
+
+    static void sink(void *context, const SensorRecord &record)
+    {
+        Bench &bench = *static_cast<Bench *>(context);
+        bench.sunk++;
+        if (record.channel == bench.continuous) {
+            bench.scheduler.trigger(bench.continuous);
+        }
+    }
+};
+
+/** IMU latency, every period of every channel, and the records per second of a run of RUN_US. */
+void check_run(const char *name, uint32_t start_us, int continuous)
+{
+    Bench bench(start_us);
+    if (!check(bench.scheduler.channels() == CHANNELS, "%s: %zu channels registered", name,
+               bench.scheduler.channels())) {
+        return;
+    }
+    if (continuous >= 0) {
+        bench.continuous = continuous;
+        bench.scheduler.trigger(continuous);
+    }
+    SimulatedSensorBus::RunStats stats = bench.run(RUN_US);
+
+    const int imu_channels[] = { GYRO, ACCELERO };
+    uint32_t imu_latency_us = 0;
+    for (int channel : imu_channels) {
+        const SensorChannelStats &imu = bench.scheduler.stats(channel);
+        check(imu.max_latency_us < ENVIRONMENT_US, "%s: %s started up to %lu us late", name,
+              SENSORS[channel].config.name, (unsigned long)imu.max_latency_us);
+        imu_latency_us = imu.max_latency_us > imu_latency_us ? imu.max_latency_us : imu_latency_us;
+    }
+
+    uint32_t samples = 0;
+    for (int channel = 0; channel < CHANNELS; channel++) {
+        const SensorChannelStats &channel_stats = bench.scheduler.stats(channel);
+        samples += channel_stats.samples;
+        uint32_t periods = RUN_US / SENSORS[channel].config.period_us;
+        // triggered reads come on top of the polls
+        bool polled = channel != continuous;
+        check(channel_stats.missed == 0 && channel_stats.errors == 0 && channel_stats.samples >= periods &&
+              (!polled || channel_stats.samples <= periods + 1),
+              "%s: %s read %lu times in %lu periods, %lu missed, %lu errors", name, SENSORS[channel].config.name,
+              (unsigned long)channel_stats.samples, (unsigned long)periods, (unsigned long)channel_stats.missed,
+              (unsigned long)channel_stats.errors);
+    }
+    check(stats.records == samples && bench.sunk == samples, "%s: %lu records, %lu sunk, %lu samples", name,
+          (unsigned long)stats.records, (unsigned long)bench.sunk, (unsigned long)samples);
+    check(stats.busy_us + stats.idle_us >= RUN_US, "%s: %llu us busy, %llu us idle in %lu us", name,
+          (unsigned long long)stats.busy_us, (unsigned long long)stats.idle_us, (unsigned long)RUN_US);
+    if (continuous >= 0) {
+        return;
+    }
+
+    double rate = stats.records * 1e6 / RUN_US;
+    double expected = configured_rate();
+    check(rate >= expected * (1.0 - RATE_ERROR) && rate <= expected * (1.0 + RATE_ERROR),
+          "%s: %.1f records/s, %.1f configured", name, rate, expected);
+    printf("acquisition-check: %s: %.1f records/s, bus %.1f %% busy, IMU at most %lu us late\n", name, rate,
+           100.0 * stats.busy_us / (stats.busy_us + stats.idle_us), (unsigned long)imu_latency_us);
+}
+
+void check_errors()
+{
+    Bench bench(0);
+    bench.run(1000000);
+    bench.bus.fail_next(GYRO);
+    bench.bus.fail_next(TEMPERATURE);
+    bench.run(2000000);
+
+    uint32_t samples = 0;
+    for (int channel = 0; channel < CHANNELS; channel++) {
+        const SensorChannelStats &channel_stats = bench.scheduler.stats(channel);
+        samples += channel_stats.samples;
+        uint32_t errors = channel == GYRO || channel == TEMPERATURE ? 1 : 0;
+        check(channel_stats.errors == errors && channel_stats.missed == 0,
+              "fail_next: %s with %lu errors, %lu expected, %lu missed", SENSORS[channel].config.name,
+              (unsigned long)channel_stats.errors, (unsigned long)errors, (unsigned long)channel_stats.missed);
+    }
+    // the failed reads gave no record, and the channels went on
+    uint32_t gyro = bench.scheduler.stats(GYRO).samples;
+    uint32_t periods = 3000000 / SENSORS[GYRO].config.period_us;
+    check(gyro + 1 >= periods && gyro <= periods, "fail_next: gyro read %lu times in %lu periods",
+          (unsigned long)gyro, (unsigned long)periods);
+    check(bench.sunk == samples, "fail_next: %lu records, %lu samples", (unsigned long)bench.sunk,
+          (unsigned long)samples);
+}
+
+} // namespace
+
+int main()
+{
+    check_run("from 0", 0, -1);
+    check_run("across the wrap", 0u - 5000000, -1);
+    check_run("pressure continuous", 0, PRESSURE);
+    check_run("pressure continuous across the wrap", 0u - 5000000, PRESSURE);
+    check_errors();
+    return check_summary("acquisition-check");
+}
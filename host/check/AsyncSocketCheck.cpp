@@ -0,0 +1,369 @@
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <new>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Check.h"
+#include "PosixAsyncSocket.h"
+
+/*
+ * PosixAsyncSocket and PosixAsyncLoop against listeners on 127.0.0.1:
+ *
+ * - connect, refused by a closed port, and timed out by a listener whose
+ *   backlog is full;
+ * - a gathered send of 1 MB in 8 buffers from a small SO_SNDBUF, which
+ *   sendmsg() takes a part at a time, ending inside buffers: the
+ *   completion gets the total, the peer every byte in order;
+ * - recv, a recv timeout from a run_once() asked to wait an hour, and
+ *   ASYNC_CLOSED once the peer closed;
+ * - connect() failing on a socket the full loop could not take;
+ * - a completion destroying a socket the same pass has still to process.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const char *const LOCALHOST = "127.0.0.1";
+/** Bound of every wait for a completion that must come. */
+const uint32_t WAIT_MS = 5000;
+
+struct Result {
+    int calls;
+    int result;
+};
+
+void done(void *context, int result)
+{
+    Result &r = *static_cast<Result *>(context);
+    r.calls++;
+    r.result = result;
+}
+
+uint32_t elapsed_ms(uint32_t start_us)
+{
+    return (PosixAsyncLoop::now_us() - start_us) / 1000;
+}
+
+/** Run the loop until the completion ran or WAIT_MS passed. */
+bool wait_for(PosixAsyncLoop &loop, const Result &result)
+{
+    uint32_t start = PosixAsyncLoop::now_us();
+    while (!result.calls && elapsed_ms(start) < WAIT_MS) {
+        loop.run_once(10);
+    }
+    return result.calls == 1;
+}
+
+/** Listener on 127.0.0.1, port picked by the system. @return fd, or -1. */
+int listen_on(uint16_t &port, int backlog)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) ||
+        listen(fd, backlog) || getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length)) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    port = ntohs(address.sin_port);
+    return fd;
+}
+
+int accept_peer(int listener)
+{
+    pollfd pfd = { listener, POLLIN, 0 };
+    return poll(&pfd, 1, WAIT_MS) == 1 ? accept(listener, nullptr, nullptr) : -1;
+}
+
+/** PosixAsyncSocket with a small send buffer, counting the sends that went out in part. */
+class CountingSocket : public PosixAsyncSocket {
+public:
+    static const int SEND_BUFFER = 4096;
+
+    explicit CountingSocket(PosixAsyncLoop &loop) :
+        PosixAsyncSocket(loop),
+        sends(0),
+        partial_sends(0),
+        inside_buffer(0)
+    {
+    }
+
+    unsigned sends;
+    /** Sends taking less than offered. */
+    unsigned partial_sends;
+    /** Partial sends ending inside a buffer rather than between two. */
+    unsigned inside_buffer;
+
+protected:
+    int io_open() override
+    {
+        int err = PosixAsyncSocket::io_open();
+        if (err == ASYNC_OK) {
+            int size = SEND_BUFFER;
+            setsockopt(fd(), SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        }
+        return err;
+    }
+
+    int io_send(const AsyncBuffer *buffers, size_t count) override
+    {
+        int sent = PosixAsyncSocket::io_send(buffers, count);
+        if (sent <= 0) {
+            return sent;
+        }
+        sends++;
+        size_t offered = 0;
+        bool boundary = false;
+        for (size_t i = 0; i < count; i++) {
+            offered += buffers[i].length;
+            boundary = boundary || offered == (size_t)sent;
+        }
+        if ((size_t)sent < offered) {
+            partial_sends++;
+            inside_buffer += !boundary;
+        }
+        return sent;
+    }
+};
+
+void check_connect_refused()
+{
+    uint16_t port = 0;
+    int listener = listen_on(port, 1);
+    if (!check(listener >= 0, "refused: no listener")) {
+        return;
+    }
+    close(listener);
+
+    PosixAsyncLoop loop;
+    PosixAsyncSocket socket(loop);
+    Result connected = {};
+    check(socket.connect(LOCALHOST, port, WAIT_MS, done, &connected) == ASYNC_OK, "refused: connect not started");
+    check(wait_for(loop, connected) && connected.result == ASYNC_ERROR && !socket.connected(),
+          "refused: %d completions, result %d", connected.calls, connected.result);
+}
+
+void check_connect_timeout()
+{
+    uint16_t port = 0;
+    int listener = listen_on(port, 0);
+    if (!check(listener >= 0, "timeout: no listener")) {
+        return;
+    }
+
+    PosixAsyncLoop loop;
+    // the first takes the one place of the backlog, the SYN of the second is dropped
+    PosixAsyncSocket first(loop);
+    PosixAsyncSocket second(loop);
+    Result first_connected = {};
+    Result second_connected = {};
+    first.connect(LOCALHOST, port, WAIT_MS, done, &first_connected);
+    check(wait_for(loop, first_connected) && first_connected.result == ASYNC_OK, "timeout: first connect %d",
+          first_connected.result);
+
+    const uint32_t TIMEOUT_MS = 200;
+    uint32_t start = PosixAsyncLoop::now_us();
+    second.connect(LOCALHOST, port, TIMEOUT_MS, done, &second_connected);
+    bool completed = wait_for(loop, second_connected);
+    uint32_t took = elapsed_ms(start);
+    check(completed && second_connected.result == ASYNC_TIMEOUT && took >= TIMEOUT_MS && took < TIMEOUT_MS + 500,
+          "timeout: result %d after %lu ms, %lu ms timeout", second_connected.result, (unsigned long)took,
+          (unsigned long)TIMEOUT_MS);
+    close(listener);
+}
+
+uint8_t pattern(size_t offset)
+{
+    return (uint8_t)(offset * 31 + offset / 251);
+}
+
+/**
+ * A gathered send of 1 MB to a peer reading 4 KB at a time between the
+ * passes of the loop.
+ */
+void check_gathered_send(PosixAsyncLoop &loop, CountingSocket &socket, int peer)
+{
+    static uint8_t data[1 << 20];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = pattern(i);
+    }
+    // uneven pieces, so that partial writes end inside them
+    const size_t cuts[] = { 0, 1, 1000, 70000, 70001, 300000, 600000, 999999, sizeof(data) };
+    AsyncBuffer buffers[AsyncSocket::MAX_BUFFERS];
+    for (size_t i = 0; i < AsyncSocket::MAX_BUFFERS; i++) {
+        buffers[i].data = data + cuts[i];
+        buffers[i].length = cuts[i + 1] - cuts[i];
+    }
+
+    Result sent = {};
+    if (!check(socket.send(buffers, AsyncSocket::MAX_BUFFERS, WAIT_MS, done, &sent) == ASYNC_OK,
+               "send: not started")) {
+        return;
+    }
+    size_t received = 0;
+    size_t wrong = sizeof(data);
+    uint32_t start = PosixAsyncLoop::now_us();
+    while (received < sizeof(data) && elapsed_ms(start) < WAIT_MS) {
+        loop.run_once(1);
+        uint8_t chunk[4096];
+        ssize_t length = recv(peer, chunk, sizeof(chunk), MSG_DONTWAIT);
+        for (ssize_t i = 0; i < length; i++, received++) {
+            if (wrong == sizeof(data) && chunk[i] != pattern(received)) {
+                wrong = received;
+            }
+        }
+    }
+    while (!sent.calls && elapsed_ms(start) < WAIT_MS) {
+        loop.run_once(1);
+    }
+    check(sent.calls == 1 && sent.result == (int)sizeof(data), "send: %d completions, result %d", sent.calls,
+          sent.result);
+    check(received == sizeof(data) && wrong == sizeof(data), "send: %zu bytes received, first wrong at %zu",
+          received, wrong);
+    check(socket.partial_sends > 0 && socket.inside_buffer > 0,
+          "send: %u sendmsg calls, %u partial, %u inside a buffer", socket.sends, socket.partial_sends,
+          socket.inside_buffer);
+    printf("async-socket-check: 1 MB in %u sendmsg calls, %u partial, %u ending inside a buffer\n", socket.sends,
+           socket.partial_sends, socket.inside_buffer);
+}
+
+void check_stream()
+{
+    uint16_t port = 0;
+    int listener = listen_on(port, 4);
+    if (!check(listener >= 0, "stream: no listener")) {
+        return;
+    }
+    PosixAsyncLoop loop;
+    CountingSocket socket(loop);
+    Result connected = {};
+    socket.connect(LOCALHOST, port, WAIT_MS, done, &connected);
+    int peer = -1;
+    if (!check(wait_for(loop, connected) && connected.result == ASYNC_OK && socket.connected(),
+               "stream: connect %d", connected.result) ||
+        !check((peer = accept_peer(listener)) >= 0, "stream: no connection accepted")) {
+        close(listener);
+        return;
+    }
+
+    check_gathered_send(loop, socket, peer);
+
+    char buffer[64] = {};
+    Result received = {};
+    send(peer, "ping", 4, 0);
+    socket.recv(buffer, sizeof(buffer), WAIT_MS, done, &received);
+    check(wait_for(loop, received) && received.result == 4 && memcmp(buffer, "ping", 4) == 0,
+          "recv: result %d", received.result);
+
+    // an hour is past INT32_MAX microseconds; the 100 ms deadline still ends the wait
+    const uint32_t HOUR_MS = 3600000;
+    Result timed_out = {};
+    socket.recv(buffer, sizeof(buffer), 100, done, &timed_out);
+    uint32_t start = PosixAsyncLoop::now_us();
+    for (int i = 0; i < 3 && !timed_out.calls; i++) {
+        loop.run_once(HOUR_MS);
+    }
+    check(timed_out.calls == 1 && timed_out.result == ASYNC_TIMEOUT && elapsed_ms(start) < 1000,
+          "run_once(%lu): recv result %d after %lu ms", (unsigned long)HOUR_MS, timed_out.result,
+          (unsigned long)elapsed_ms(start));
+
+    Result closed = {};
+    socket.recv(buffer, sizeof(buffer), WAIT_MS, done, &closed);
+    close(peer);
+    check(wait_for(loop, closed) && closed.result == ASYNC_CLOSED && !socket.connected(),
+          "peer close: result %d, connected %d", closed.result, socket.connected());
+    close(listener);
+}
+
+void check_full_loop()
+{
+    uint16_t port = 0;
+    int listener = listen_on(port, PosixAsyncLoop::MAX_SOCKETS + 1);
+    if (!check(listener >= 0, "full loop: no listener")) {
+        return;
+    }
+    PosixAsyncLoop loop;
+    std::unique_ptr<PosixAsyncSocket> sockets[PosixAsyncLoop::MAX_SOCKETS];
+    for (auto &socket : sockets) {
+        socket.reset(new PosixAsyncSocket(loop));
+    }
+    PosixAsyncSocket extra(loop);
+    Result connected = {};
+    check(extra.connect(LOCALHOST, port, WAIT_MS, done, &connected) == ASYNC_ERROR && connected.calls == 0,
+          "full loop: connect of a socket not in the loop started");
+    check(sockets[PosixAsyncLoop::MAX_SOCKETS - 1]->connect(LOCALHOST, port, WAIT_MS, done, &connected) ==
+          ASYNC_OK && wait_for(loop, connected) && connected.result == ASYNC_OK,
+          "full loop: last socket in the loop, connect %d", connected.result);
+    close(listener);
+}
+
+/** The first socket's recv timeout destroys the second, next in the pass. */
+struct Pair {
+    PosixAsyncSocket *second;
+    Result first_timeout;
+};
+
+void destroy_second(void *context, int result)
+{
+    Pair &pair = *static_cast<Pair *>(context);
+    done(&pair.first_timeout, result);
+    // the storage outlives it, so that a process() on it shows as a completion
+    pair.second->~PosixAsyncSocket();
+}
+
+void check_destroyed_in_pass()
+{
+    uint16_t port = 0;
+    int listener = listen_on(port, 2);
+    if (!check(listener >= 0, "destroyed: no listener")) {
+        return;
+    }
+    PosixAsyncLoop loop;
+    PosixAsyncSocket first(loop);
+    alignas(PosixAsyncSocket) static unsigned char storage[sizeof(PosixAsyncSocket)];
+    Pair pair = { new (storage) PosixAsyncSocket(loop), {} };
+    Result connected[2] = {};
+    first.connect(LOCALHOST, port, WAIT_MS, done, &connected[0]);
+    pair.second->connect(LOCALHOST, port, WAIT_MS, done, &connected[1]);
+    if (!check(wait_for(loop, connected[0]) && wait_for(loop, connected[1]) && connected[0].result == ASYNC_OK &&
+               connected[1].result == ASYNC_OK, "destroyed: connect %d, %d", connected[0].result,
+               connected[1].result)) {
+        pair.second->~PosixAsyncSocket();
+        close(listener);
+        return;
+    }
+
+    char buffers[2][16];
+    Result second_received = {};
+    first.recv(buffers[0], sizeof(buffers[0]), 50, destroy_second, &pair);
+    pair.second->recv(buffers[1], sizeof(buffers[1]), WAIT_MS, done, &second_received);
+    check(wait_for(loop, pair.first_timeout) && pair.first_timeout.result == ASYNC_TIMEOUT,
+          "destroyed: first recv %d", pair.first_timeout.result);
+    loop.run_once(0);
+    check(second_received.calls == 0, "destroyed: %d completions of the destroyed socket", second_received.calls);
+    close(listener);
+}
+
+} // namespace
+
+int main()
+{
+    check_connect_refused();
+    check_connect_timeout();
+    check_stream();
+    check_full_loop();
+    check_destroyed_in_pass();
+    return check_summary("async-socket-check");
+}
@@ -0,0 +1,59 @@
+#ifndef LAB_HOST_CHECK_H
+#define LAB_HOST_CHECK_H
+
+#include <cstdarg>
+#include <cstdio>
+
+/*
+ * The check programs of host/check: each tests one part of lab-utils
+ * against known answers, prints a line per expectation that does not
+ * hold and ends with check_summary(), whose "N checks, 0 failed" line
+ * ctest looks for.
+ */
+
+namespace lab_check {
+
+struct Counts {
+    unsigned checks;
+    unsigned failed;
+};
+
+inline Counts &counts()
+{
+    static Counts counts = { 0, 0 };
+    return counts;
+}
+
+/**
+ * Count one expectation, and print the message when it does not hold.
+ *
+ * @return ok, so that a check can guard the ones depending on it.
+ */
+inline bool check(bool ok, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+inline bool check(bool ok, const char *format, ...)
+{
+    counts().checks++;
+    if (!ok) {
+        counts().failed++;
+        va_list ap;
+        va_start(ap, format);
+        fputs("FAILED: ", stdout);
+        vprintf(format, ap);
+        fputs("\n", stdout);
+        va_end(ap);
+    }
+    return ok;
+}
+
+/** @return exit status of the program, 1 if a check failed. */
+inline int check_summary(const char *name)
+{
+    printf("%s: %u checks, %u failed\n", name, counts().checks, counts().failed);
+    fflush(stdout);
+    return counts().failed ? 1 : 0;
+}
+
+} // namespace lab_check
+
+#endif // LAB_HOST_CHECK_H
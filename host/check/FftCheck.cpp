@@ -0,0 +1,263 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "Check.h"
+#include "FixedRealFft.h"
+#include "VibrationFeatures.h"
+
+/*
+ * FixedRealFft and VibrationAnalyzer against the same computations in
+ * double precision: a plain DFT of the real samples, and the window
+ * moments, Hann spectrum, band energies and interpolated peak done the
+ * way VibrationFeatures.h describes them.
+ *
+ * Each of the log2(n) stages of the FFT, the split included, may lose a
+ * bit and a half to its truncations and 2^-15 of the magnitude to the Q15
+ * twiddles (32767 stands for 1): the bins may be off by that much per
+ * stage, in output LSB and of the largest bin. The features add the
+ * halving of the windowed samples to int16 and float sums, with bounds
+ * of their own further down, about three times the errors measured.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+
+/* FFT error per stage, in output LSB and relative to the largest bin. */
+const double FFT_ERROR_LSB_PER_STAGE = 1.5;
+const double FFT_ERROR_RELATIVE_PER_STAGE = 1.0 / 32768;
+
+uint32_t random_state = 0x2545F491;
+
+/** xorshift32, uniform in [-amplitude, amplitude]. */
+int noise(int amplitude)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return (int)(random_state % (2 * (uint32_t)amplitude + 1)) - amplitude;
+}
+
+int16_t clamp16(double value)
+{
+    long v = lround(value);
+    return (int16_t)(v > 32767 ? 32767 : (v < -32768 ? -32768 : v));
+}
+
+struct Signal {
+    const char *name;
+    std::vector<int16_t> samples;
+};
+
+/** Signals of n samples, full scale or close to it. */
+std::vector<Signal> signals(size_t n)
+{
+    std::vector<Signal> signals;
+    Signal dc = { "dc", std::vector<int16_t>(n, 32767) };
+    Signal impulse = { "impulse", std::vector<int16_t>(n, 0) };
+    impulse.samples[0] = 32767;
+    Signal nyquist = { "nyquist", std::vector<int16_t>(n) };
+    Signal line = { "sine on a bin", std::vector<int16_t>(n) };
+    Signal tones = { "two tones off the bins", std::vector<int16_t>(n) };
+    Signal random = { "noise", std::vector<int16_t>(n) };
+    for (size_t i = 0; i < n; i++) {
+        nyquist.samples[i] = i % 2 ? -32767 : 32767;
+        line.samples[i] = clamp16(30000 * sin(2 * PI * (n / 8) * i / n));
+        tones.samples[i] = clamp16(12000 * sin(2 * PI * 3.3 * i / n) + 9000 * cos(2 * PI * (n / 5.7) * i / n));
+        random.samples[i] = (int16_t)noise(32767);
+    }
+    signals.push_back(dc);
+    signals.push_back(impulse);
+    signals.push_back(nyquist);
+    signals.push_back(line);
+    signals.push_back(tones);
+    signals.push_back(random);
+    return signals;
+}
+
+/** Bins 0 to n / 2 of the DFT of real samples, re and im interleaved. */
+std::vector<double> dft(const std::vector<double> &x)
+{
+    size_t n = x.size();
+    std::vector<double> bins(n + 2);
+    for (size_t k = 0; k <= n / 2; k++) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            // the index product modulo n keeps the angle, and its accuracy, small
+            double angle = 2 * PI * (double)((k * i) % n) / n;
+            re += x[i] * cos(angle);
+            im -= x[i] * sin(angle);
+        }
+        bins[2 * k] = re;
+        bins[2 * k + 1] = im;
+    }
+    return bins;
+}
+
+template<size_t Size>
+void check_fft()
+{
+    static FixedRealFft<Size> fft;
+    const unsigned stages = (unsigned)log2((double)Size);
+    for (const Signal &signal : signals(Size)) {
+        std::vector<int32_t> output(Size + 2);
+        fft.forward(signal.samples.data(), output.data());
+
+        std::vector<double> x(signal.samples.begin(), signal.samples.end());
+        std::vector<double> reference = dft(x);
+        const double scale = (double)(1 << FixedRealFftBase::OUTPUT_SHIFT) / Size;
+        double largest = 0.0, error = 0.0;
+        for (size_t k = 0; k <= Size / 2; k++) {
+            double re = reference[2 * k] * scale, im = reference[2 * k + 1] * scale;
+            largest = fmax(largest, hypot(re, im));
+            error = fmax(error, hypot(output[2 * k] - re, output[2 * k + 1] - im));
+        }
+        double bound = (FFT_ERROR_LSB_PER_STAGE + FFT_ERROR_RELATIVE_PER_STAGE * largest) * stages;
+        check(error <= bound, "fft %zu, %s: bins off by %.1f LSB, bound %.1f", Size, signal.name, error, bound);
+    }
+}
+
+/** What VibrationAnalyzer computes from one window, in double precision. */
+struct ReferenceFeatures {
+    double rms;
+    double kurtosis;
+    double peak_hz;
+    double peak_rms;
+    double band_energy[VIBRATION_MAX_BANDS];
+    double total_energy;
+};
+
+ReferenceFeatures reference_features(const std::vector<int16_t> &window, const VibrationConfig &config)
+{
+    size_t n = window.size();
+    double mean = 0.0;
+    for (int16_t value : window) {
+        mean += value;
+    }
+    mean /= n;
+    double m2 = 0.0, m4 = 0.0;
+    for (int16_t value : window) {
+        double d = value - mean;
+        m2 += d * d;
+        m4 += d * d * d * d;
+    }
+    ReferenceFeatures features = {};
+    double variance = m2 / n;
+    features.rms = sqrt(variance) * config.scale;
+    features.kurtosis = variance > 0.0 ? (m4 / n) / (variance * variance) : 0.0;
+
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] = (window[i] - mean) * (0.5 - 0.5 * cos(2 * PI * i / n));
+    }
+    std::vector<double> bins = dft(x);
+    // one-sided mean square per bin, the Hann window power undone
+    const double unit = 2.0 / ((double)n * n) / 0.375 * config.scale * config.scale;
+    const double bin_hz = config.sample_rate_hz / n;
+    std::vector<double> power(n / 2);
+    size_t peak = 1;
+    for (size_t k = 1; k < n / 2; k++) {
+        power[k] = bins[2 * k] * bins[2 * k] + bins[2 * k + 1] * bins[2 * k + 1];
+        features.total_energy += power[k] * unit;
+        for (size_t b = 0; b < config.band_count; b++) {
+            if (k * bin_hz >= config.bands[b].low_hz && k * bin_hz < config.bands[b].high_hz) {
+                features.band_energy[b] += power[k] * unit;
+            }
+        }
+        if (power[k] > power[peak]) {
+            peak = k;
+        }
+    }
+    double left = power[peak - 1], centre = power[peak], right = peak + 1 < n / 2 ? power[peak + 1] : 0.0;
+    double l = sqrt(left), c = sqrt(centre), r = sqrt(right);
+    double denominator = l - 2.0 * c + r;
+    double offset = denominator != 0.0 ? 0.5 * (l - r) / denominator : 0.0;
+    features.peak_hz = (peak + offset) * bin_hz;
+    features.peak_rms = sqrt((left + centre + right) * unit);
+    return features;
+}
+
+/* Feature bounds, relative to the reference unless said otherwise. */
+const double RMS_ERROR = 1e-5;
+const double KURTOSIS_ERROR = 1e-3;
+/** Of the energy of the whole spectrum, so that near empty bands count little. */
+const double BAND_ERROR = 5e-4;
+const double PEAK_RMS_ERROR = 3e-3;
+/** In bins. */
+const double PEAK_HZ_ERROR = 0.03;
+
+/** A window of three axes of accelerometer-like signals. */
+void check_features()
+{
+    const size_t WINDOW = 512;
+    const size_t AXES = 3;
+    static VibrationAnalyzer<WINDOW, AXES> analyzer;
+    VibrationConfig config = {};
+    config.sample_rate_hz = 1666.0f;
+    config.hop = WINDOW / 2;
+    config.scale = 0.061f;
+    config.band_count = 4;
+    config.bands[0] = { 0.0f, 50.0f };
+    config.bands[1] = { 50.0f, 200.0f };
+    config.bands[2] = { 200.0f, 500.0f };
+    config.bands[3] = { 500.0f, 833.0f };
+    check(analyzer.configure(config) == 0, "features: configure");
+
+    // the hops land mid-window, the ring is not in chronological storage order
+    const size_t FRAMES = WINDOW + 3 * config.hop;
+    std::vector<int16_t> axes[AXES];
+    for (size_t f = 0; f < FRAMES; f++) {
+        double t = f / (double)config.sample_rate_hz;
+        int16_t frame[AXES] = {
+            // a 60 Hz line, a 317.4 Hz one between bins and a knock every 0.2 s on 1 g
+            clamp16(-400 + 6000 * sin(2 * PI * 60 * t) + noise(200)),
+            clamp16(2500 * sin(2 * PI * 317.4 * t) + 1500 * sin(2 * PI * 612 * t) + noise(100)),
+            clamp16(16384 + (f % 333 < 4 ? 12000 : 0) + noise(300)),
+        };
+        for (size_t a = 0; a < AXES; a++) {
+            axes[a].push_back(frame[a]);
+        }
+        if (!analyzer.push(frame, (uint32_t)(t * 1e6))) {
+            continue;
+        }
+
+        const VibrationFeatures &features = analyzer.features();
+        for (size_t a = 0; a < AXES; a++) {
+            std::vector<int16_t> window(axes[a].end() - WINDOW, axes[a].end());
+            ReferenceFeatures reference = reference_features(window, config);
+            const AxisFeatures &got = features.axis[a];
+            const unsigned sequence = features.sequence;
+            check(fabs(got.rms - reference.rms) <= RMS_ERROR * reference.rms,
+                  "features %u axis %zu: rms %g, %g in double", sequence, a, got.rms, reference.rms);
+            check(fabs(got.kurtosis - reference.kurtosis) <= KURTOSIS_ERROR * reference.kurtosis,
+                  "features %u axis %zu: kurtosis %g, %g in double", sequence, a, got.kurtosis, reference.kurtosis);
+            for (size_t b = 0; b < config.band_count; b++) {
+                check(fabs(got.band_energy[b] - reference.band_energy[b]) <= BAND_ERROR * reference.total_energy,
+                      "features %u axis %zu: band %zu energy %g, %g in double", sequence, a, b,
+                      got.band_energy[b], reference.band_energy[b]);
+            }
+            double bin_hz = config.sample_rate_hz / WINDOW;
+            check(fabs(got.peak_hz - reference.peak_hz) <= PEAK_HZ_ERROR * bin_hz,
+                  "features %u axis %zu: peak at %g Hz, %g Hz in double", sequence, a, got.peak_hz, reference.peak_hz);
+            check(fabs(got.peak_rms - reference.peak_rms) <= PEAK_RMS_ERROR * reference.peak_rms,
+                  "features %u axis %zu: peak rms %g, %g in double", sequence, a, got.peak_rms, reference.peak_rms);
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    check_fft<8>();
+    check_fft<64>();
+    check_fft<512>();
+    check_fft<4096>();
+    check_features();
+    return check_summary("fft-check");
+}
@@ -0,0 +1,393 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Check.h"
+#include "FileFlash.h"
+#include "FlashRingLog.h"
+
+/*
+ * FlashRingLog on a FileFlash that loses power part way through a run of
+ * appends, page flushes, replays and sector erases, once for every few
+ * bytes of the run. Remounted on the file the cut left, the log must skip
+ * a torn page by its CRC, redo a torn erase, replay every record of the
+ * pages programmed before the cut in order and intact, a page at most
+ * twice, and go on working: records appended after the recovery replay
+ * after another remount.
+ *
+ * Every run starts from the image of a log that went round the region
+ * one and a half times, its reader a few pages behind, so that the run
+ * erases sectors of consumed pages as it goes.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const char *const FLASH_PATH = "flash-check.bin";
+const uint32_t REGION = 64 * 1024;
+const size_t PAGE = 256;
+const size_t SECTOR = 4096;
+const uint32_t PAGES = REGION / PAGE;
+
+/* 62 bytes with the length, three records to a page */
+const size_t RECORD = 60;
+const uint32_t RECORDS_PER_PAGE = (PAGE - FlashRingLogBase::HEADER_SIZE) / (RECORD + 2);
+
+/** Pages the reader stays behind the writer. */
+const uint32_t BACKLOG_PAGES = 3;
+/** Records of a run, so that it crosses at least one sector. */
+const uint32_t RUN_RECORDS = 48;
+/** Bytes between two power cuts tried. */
+const size_t CUT_STEP = 7;
+
+/** Id then bytes derived from it, never 0xFF: a torn program always leaves an erased cell. */
+void make_record(uint32_t id, uint8_t *record)
+{
+    memcpy(record, &id, sizeof(id));
+    for (size_t i = sizeof(id); i < RECORD; i++) {
+        record[i] = (uint8_t)((id * 7 + i * 13) % 0xFF);
+    }
+}
+
+bool valid_record(const uint8_t *record, int length, uint32_t &id)
+{
+    uint8_t expected[RECORD];
+    if (length != (int)RECORD) {
+        return false;
+    }
+    memcpy(&id, record, sizeof(id));
+    make_record(id, expected);
+    return memcmp(record, expected, RECORD) == 0;
+}
+
+enum CutOperation {
+    CUT_NONE,
+    CUT_PROGRAM,
+    CUT_ERASE,
+};
+
+/** FileFlash telling which operation the power cut stopped, and how far it got. */
+class CutFlash : public FlashDevice {
+public:
+    explicit CutFlash(FileFlash &flash) :
+        _flash(flash),
+        _cut(0),
+        _written(0),
+        _operation(CUT_NONE),
+        _length(0),
+        _done(0)
+    {
+    }
+
+    void cut_power_after(size_t bytes)
+    {
+        _flash.cut_power_after(bytes);
+        _cut = bytes;
+        _written = 0;
+    }
+
+    int read(uint32_t address, void *data, size_t length) override
+    {
+        return _flash.read(address, data, length);
+    }
+
+    int program(uint32_t address, const void *data, size_t length) override
+    {
+        bool powered = _flash.powered();
+        int err = _flash.program(address, data, length);
+        note(powered, CUT_PROGRAM, length);
+        return err;
+    }
+
+    int erase(uint32_t address, size_t length) override
+    {
+        bool powered = _flash.powered();
+        int err = _flash.erase(address, length);
+        note(powered, CUT_ERASE, length);
+        return err;
+    }
+
+    size_t page_size() const override
+    {
+        return _flash.page_size();
+    }
+
+    size_t sector_size() const override
+    {
+        return _flash.sector_size();
+    }
+
+    uint32_t size() const override
+    {
+        return _flash.size();
+    }
+
+    CutOperation operation() const
+    {
+        return _operation;
+    }
+
+    /** Bytes of the stopped operation. */
+    size_t length() const
+    {
+        return _length;
+    }
+
+    /** Bytes it wrote before the cut. */
+    size_t done() const
+    {
+        return _done;
+    }
+
+private:
+    void note(bool powered, CutOperation operation, size_t length)
+    {
+        if (powered && !_flash.powered()) {
+            _operation = operation;
+            _length = length;
+            _done = _cut - _written;
+        }
+        _written += length;
+    }
+
+    FileFlash &_flash;
+    size_t _cut;
+    size_t _written;
+    CutOperation _operation;
+    size_t _length;
+    size_t _done;
+};
+
+/** Where the writer and the reader of the log got to. */
+struct Traffic {
+    /** Next record to append. */
+    uint32_t next_id;
+    /** Next record the reader expects, the ones before were consumed. */
+    uint32_t next_replay;
+};
+
+/**
+ * Append a record, flush every fifth and have the reader consume one
+ * while it is more than BACKLOG_PAGES behind.
+ *
+ * @return 0, or -1 on a flash error.
+ */
+int step(FlashRingLogBase &log, Traffic &traffic)
+{
+    uint8_t record[RECORD];
+    make_record(traffic.next_id, record);
+    if (log.append(record, RECORD)) {
+        return -1;
+    }
+    traffic.next_id++;
+    if (traffic.next_id % 5 == 0 && log.flush()) {
+        return -1;
+    }
+    if (log.backlog_pages() <= BACKLOG_PAGES) {
+        return 0;
+    }
+    int length = log.peek(record, sizeof(record));
+    if (length <= 0) {
+        return -1;
+    }
+    uint32_t id = 0;
+    check(valid_record(record, length, id) && id == traffic.next_replay, "record %lu replayed as %lu",
+          (unsigned long)traffic.next_replay, (unsigned long)id);
+    if (log.consume()) {
+        return -1;
+    }
+    traffic.next_replay++;
+    return 0;
+}
+
+/** Every record left in the log, in replay order. @return false on an invalid record or a flash error. */
+bool replay(FlashRingLogBase &log, std::vector<uint32_t> &ids)
+{
+    uint8_t record[RECORD];
+    int length;
+    while ((length = log.peek(record, sizeof(record))) > 0) {
+        uint32_t id = 0;
+        if (!valid_record(record, length, id) || log.consume()) {
+            return false;
+        }
+        ids.push_back(id);
+    }
+    return length == 0;
+}
+
+/** ids holds first, first + 1, ... up to end, not included. */
+bool contiguous(const std::vector<uint32_t> &ids, uint32_t first, uint32_t end)
+{
+    if (ids.size() != end - first) {
+        return false;
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (ids[i] != first + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct Image {
+    std::vector<uint8_t> bytes;
+    Traffic traffic;
+};
+
+bool write_image(const Image &image)
+{
+    FILE *file = fopen(FLASH_PATH, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = fwrite(image.bytes.data(), 1, image.bytes.size(), file) == image.bytes.size();
+    return fclose(file) == 0 && written;
+}
+
+/** A log one and a half times round the region, all its records programmed. */
+bool make_image(Image &image)
+{
+    remove(FLASH_PATH);
+    Traffic traffic = { 0, 0 };
+    {
+        FileFlash flash(FLASH_PATH, REGION, PAGE, SECTOR);
+        FlashRingLog<PAGE> log(flash, 0, REGION);
+        if (!check(flash.is_open(), "%s: cannot open", FLASH_PATH) || !check(log.format() == 0, "image: format")) {
+            return false;
+        }
+        while (log.stats().pages_written < PAGES * 3 / 2) {
+            if (!check(step(log, traffic) == 0, "image: flash error at record %lu", (unsigned long)traffic.next_id)) {
+                return false;
+            }
+        }
+        if (!check(log.flush() == 0 && log.stats().pages_lost == 0, "image: flush, %lu pages lost",
+                   (unsigned long)log.stats().pages_lost)) {
+            return false;
+        }
+    }
+    image.traffic = traffic;
+    image.bytes.resize(REGION);
+    FILE *file = fopen(FLASH_PATH, "rb");
+    bool read = file && fread(image.bytes.data(), 1, REGION, file) == REGION;
+    if (file) {
+        fclose(file);
+    }
+    return check(read, "image: cannot read %s", FLASH_PATH);
+}
+
+struct CutCounts {
+    unsigned programs;
+    unsigned erases;
+    unsigned marks;
+};
+
+/**
+ * One run from the image, power cut after cut bytes, then the recovery.
+ *
+ * @return false once the run ends before the cut.
+ */
+bool power_cut(const Image &image, size_t cut, CutCounts &counts)
+{
+    if (!check(write_image(image), "cut %zu: cannot write %s", cut, FLASH_PATH)) {
+        return false;
+    }
+
+    Traffic traffic = image.traffic;
+    uint32_t committed_end;
+    CutOperation operation;
+    size_t length, done;
+    {
+        FileFlash file(FLASH_PATH, REGION, PAGE, SECTOR);
+        CutFlash flash(file);
+        FlashRingLog<PAGE> log(flash, 0, REGION);
+        if (!check(log.mount() == 0, "cut %zu: mount of the image", cut)) {
+            return false;
+        }
+        flash.cut_power_after(cut);
+        for (uint32_t i = 0; i < RUN_RECORDS && file.powered(); i++) {
+            step(log, traffic);
+        }
+        if (file.powered()) {
+            return false;
+        }
+        // pages go out in order: the records of the programmed ones are a prefix
+        committed_end = image.traffic.next_id + log.stats().records_appended;
+        operation = flash.operation();
+        length = flash.length();
+        done = flash.done();
+    }
+
+    const char *what = operation == CUT_ERASE ? "erase" : (length == 1 ? "page mark" : "page program");
+    if (operation == CUT_ERASE) {
+        counts.erases++;
+    } else if (length == 1) {
+        counts.marks++;
+    } else {
+        counts.programs++;
+    }
+
+    // reset: a new log on what the cut left
+    FileFlash flash(FLASH_PATH, REGION, PAGE, SECTOR);
+    std::vector<uint32_t> ids;
+    {
+        FlashRingLog<PAGE> log(flash, 0, REGION);
+        if (!check(log.mount() == 0, "cut %zu in a %s: remount", cut, what)) {
+            return true;
+        }
+        if (!check(replay(log, ids), "cut %zu in a %s: replay failed after %zu records", cut, what, ids.size())) {
+            return true;
+        }
+        uint32_t first = ids.empty() ? committed_end : ids.front();
+        check(first <= traffic.next_replay && traffic.next_replay - first <= RECORDS_PER_PAGE,
+              "cut %zu in a %s: replay from %lu, %lu not consumed yet", cut, what, (unsigned long)first,
+              (unsigned long)traffic.next_replay);
+        check(contiguous(ids, first, committed_end), "cut %zu in a %s: %zu records from %lu, %lu committed", cut,
+              what, ids.size(), (unsigned long)first, (unsigned long)committed_end);
+        // a torn page fails its CRC once, a torn erase or mark leaves none
+        uint32_t torn = operation == CUT_PROGRAM && length > 1 && done > 0 ? 1 : 0;
+        check(log.stats().bad_pages == torn && log.stats().pages_lost == 0,
+              "cut %zu in a %s of %zu bytes after %zu: %lu bad pages, %lu lost", cut, what, length, done,
+              (unsigned long)log.stats().bad_pages, (unsigned long)log.stats().pages_lost);
+
+        // past the cut the log works as before, a torn sector erased again
+        for (uint32_t id = committed_end; id < committed_end + RUN_RECORDS; id++) {
+            uint8_t record[RECORD];
+            make_record(id, record);
+            if (!check(log.append(record, RECORD) == 0, "cut %zu in a %s: append %lu after the recovery", cut,
+                       what, (unsigned long)id)) {
+                return true;
+            }
+        }
+        check(log.flush() == 0, "cut %zu in a %s: flush after the recovery", cut, what);
+    }
+
+    ids.clear();
+    FlashRingLog<PAGE> log(flash, 0, REGION);
+    check(log.mount() == 0 && replay(log, ids) && contiguous(ids, committed_end, committed_end + RUN_RECORDS) &&
+          log.stats().bad_pages == 0,
+          "cut %zu in a %s: %zu records after the recovery, %lu bad pages", cut, what, ids.size(),
+          (unsigned long)log.stats().bad_pages);
+    return true;
+}
+
+} // namespace
+
+int main()
+{
+    Image image;
+    if (make_image(image)) {
+        CutCounts counts = {};
+        size_t cut = 0;
+        while (power_cut(image, cut, counts)) {
+            cut += CUT_STEP;
+        }
+        printf("flash-check: %zu bytes, cuts in %u page programs, %u erases, %u page marks\n", cut,
+               counts.programs, counts.erases, counts.marks);
+        check(counts.programs > 0 && counts.erases > 0 && counts.marks > 0, "power cuts of every kind");
+    }
+    remove(FLASH_PATH);
+    return check_summary("flash-check");
+}
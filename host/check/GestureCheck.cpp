@@ -0,0 +1,269 @@
+#include <cstring>
+#include <vector>
+
+#include "mbed.h"
+#include "host/HostRuntime.h"
+
+#include "Check.h"
+#include "GestureDetector.h"
+#include "InputPipeline.h"
+
+/*
+ * Button traces through GestureDetector, then through InputPipeline on
+ * the user button of the shim, checked against the events they must
+ * give: a bouncing click, a glitch, a long press, a double click and two
+ * clicks too far apart for one.
+ *
+ * Every trace runs with the leading-edge and the settled debounce, once
+ * from a small timestamp and once from 150 ms before the 32-bit
+ * microsecond counter wraps, on the virtual clock
+ * (MBED_HOST_CLOCK=virtual): the events carry the times of the edges,
+ * the same in every run. Last, the glitch again with the pass of
+ * InputPipeline held up while it reads the clock and the release coming
+ * in meanwhile.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+struct Step {
+    uint32_t at_us;
+    uint8_t level;
+};
+
+struct Expected {
+    InputEventType type;
+    uint32_t at_us;
+};
+
+struct Trace {
+    const char *name;
+    std::vector<Step> steps;
+    /** Replayed up to then, past every timer of the trace. */
+    uint32_t length_us;
+    std::vector<Expected> leading;
+    std::vector<Expected> settled;
+};
+
+/** Active low like the user buttons, idle high. */
+const std::vector<Trace> &traces()
+{
+    static const std::vector<Trace> traces = {
+        {
+            "bounce",
+            { { 0, 0 }, { 200, 1 }, { 500, 0 }, { 900, 1 }, { 1500, 0 },
+              { 100000, 1 }, { 100300, 0 }, { 100700, 1 } },
+            600000,
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 100000 }, { INPUT_CLICK, 100000 } },
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 100000 }, { INPUT_CLICK, 100000 } },
+        },
+        {
+            // shorter than the debounce: a click for the leading edge, nothing once settled
+            "glitch",
+            { { 0, 0 }, { 5000, 1 } },
+            400000,
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 5000 }, { INPUT_CLICK, 5000 } },
+            {},
+        },
+        {
+            "long-press",
+            { { 0, 0 }, { 1000000, 1 } },
+            1500000,
+            { { INPUT_PRESS, 0 }, { INPUT_LONG_PRESS, 800000 }, { INPUT_RELEASE, 1000000 } },
+            { { INPUT_PRESS, 0 }, { INPUT_LONG_PRESS, 800000 }, { INPUT_RELEASE, 1000000 } },
+        },
+        {
+            "double-click",
+            { { 0, 0 }, { 80000, 1 }, { 200000, 0 }, { 280000, 1 } },
+            800000,
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 80000 }, { INPUT_PRESS, 200000 },
+              { INPUT_RELEASE, 280000 }, { INPUT_DOUBLE_CLICK, 280000 } },
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 80000 }, { INPUT_PRESS, 200000 },
+              { INPUT_RELEASE, 280000 }, { INPUT_DOUBLE_CLICK, 280000 } },
+        },
+        {
+            "two-clicks",
+            { { 0, 0 }, { 80000, 1 }, { 500000, 0 }, { 580000, 1 } },
+            1200000,
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 80000 }, { INPUT_CLICK, 80000 },
+              { INPUT_PRESS, 500000 }, { INPUT_RELEASE, 580000 }, { INPUT_CLICK, 580000 } },
+            { { INPUT_PRESS, 0 }, { INPUT_RELEASE, 80000 }, { INPUT_CLICK, 80000 },
+              { INPUT_PRESS, 500000 }, { INPUT_RELEASE, 580000 }, { INPUT_CLICK, 580000 } },
+        },
+    };
+    return traces;
+}
+
+/** Start of the traces that cross the wrap of the microsecond counter. */
+const uint32_t WRAP_START_US = 0xFFFFFFFFu - 150000 + 1;
+
+GestureConfig config(bool leading_edge)
+{
+    GestureConfig config = default_gesture_config();
+    config.leading_edge = leading_edge;
+    return config;
+}
+
+void compare(const char *where, const Trace &trace, bool leading_edge, uint32_t start_us,
+             const std::vector<InputEvent> &events)
+{
+    const std::vector<Expected> &expected = leading_edge ? trace.leading : trace.settled;
+    bool same = events.size() == expected.size();
+    for (size_t i = 0; same && i < events.size(); i++) {
+        same = events[i].type == expected[i].type && events[i].timestamp_us - start_us == expected[i].at_us;
+    }
+    if (check(same, "%s: %s, %s edge, from %lu us:", where, trace.name, leading_edge ? "leading" : "settled",
+              (unsigned long)start_us)) {
+        return;
+    }
+    for (const Expected &e : expected) {
+        printf("    expected %s at %lu\n", input_event_name(e.type), (unsigned long)e.at_us);
+    }
+    for (const InputEvent &e : events) {
+        printf("    got %s at %lu\n", input_event_name(e.type), (unsigned long)(e.timestamp_us - start_us));
+    }
+}
+
+/** Fire the timers of the detector up to until_us, at their deadlines as InputPipeline does. */
+template<size_t N>
+void run_timers(GestureDetector &detector, uint32_t &now_us, uint32_t until_us, InputBatch<N> &batch)
+{
+    for (int i = 0; i < 64; i++) {
+        int32_t wait = detector.next_deadline(now_us);
+        if (wait < 0 || (uint32_t)wait > until_us - now_us) {
+            break;
+        }
+        now_us += wait;
+        detector.advance(now_us, batch);
+    }
+    now_us = until_us;
+}
+
+void check_detector(const Trace &trace, bool leading_edge, uint32_t start_us)
+{
+    GestureDetector detector(0, config(leading_edge));
+    detector.reset(1, start_us);
+    InputBatch<32> batch;
+    uint32_t now_us = start_us;
+    for (const Step &step : trace.steps) {
+        InputEdge edge = { start_us + step.at_us, step.level };
+        run_timers(detector, now_us, edge.timestamp_us, batch);
+        detector.feed(edge, batch);
+    }
+    run_timers(detector, now_us, start_us + trace.length_us, batch);
+    check(batch.overflow() == 0, "detector: %s overflowed its batch", trace.name);
+    compare("detector", trace, leading_edge, start_us, std::vector<InputEvent>(batch.data(), batch.data() + batch.size()));
+}
+
+std::vector<InputEvent> pipeline_events;
+
+void record(const InputEvent *events, size_t count)
+{
+    pipeline_events.insert(pipeline_events.end(), events, events + count);
+}
+
+/** The events of both lines since start_us against those of the trace. */
+void compare_pipeline(const char *where, const Trace &trace, uint64_t start_us)
+{
+    // the threads take turns on the virtual clock, the queue waits now
+    std::vector<InputEvent> channels[2];
+    for (const InputEvent &event : pipeline_events) {
+        if (check(event.channel < 2, "pipeline: event of channel %u", event.channel)) {
+            channels[event.channel].push_back(event);
+        }
+    }
+    compare(where, trace, true, (uint32_t)start_us, channels[0]);
+    compare(where, trace, false, (uint32_t)start_us, channels[1]);
+}
+
+/**
+ * Play a trace on the user button from start_us of the virtual clock, the
+ * lines of both debounce modes attached to it.
+ */
+void check_pipeline(const Trace &trace, uint64_t start_us)
+{
+    pipeline_events.clear();
+    for (const Step &step : trace.steps) {
+        mbed_host::sleep_until(start_us + step.at_us);
+        mbed_host::pin_input(USER_BUTTON, step.level);
+    }
+    mbed_host::sleep_until(start_us + trace.length_us);
+    compare_pipeline("pipeline", trace, start_us);
+}
+
+uint64_t held_up_start_us;
+
+/** The release of the glitch comes in, the queue thread goes on past the debounce. */
+void hold_up()
+{
+    mbed_host::sleep_until(held_up_start_us + 5000);
+    mbed_host::pin_input(USER_BUTTON, 1);
+    mbed_host::sleep_until(held_up_start_us + 30000);
+}
+
+/**
+ * The glitch, the pass of its press held up where it reads the clock
+ * while the release comes in, as by an interrupt between the drain of
+ * the edges and that read: the settled line must still see a glitch and
+ * report nothing, rather than settle on the press it did not see end.
+ */
+void check_held_up(uint64_t start_us)
+{
+    const Trace *glitch = nullptr;
+    for (const Trace &trace : traces()) {
+        glitch = strcmp(trace.name, "glitch") == 0 ? &trace : glitch;
+    }
+    pipeline_events.clear();
+    held_up_start_us = start_us;
+    mbed_host::sleep_until(start_us);
+    mbed_host::pin_input(USER_BUTTON, 0);
+    // the queue thread reads the ticker next, in the pass of the press
+    mbed_host::before_next_ticker_read(hold_up);
+    mbed_host::sleep_until(start_us + glitch->length_us);
+    compare_pipeline("held up pass", *glitch, start_us);
+}
+
+} // namespace
+
+int main()
+{
+    if (!mbed_host::virtual_clock()) {
+        printf("gesture-check: runs on the virtual clock, MBED_HOST_CLOCK=virtual\n");
+        return 2;
+    }
+
+    for (const Trace &trace : traces()) {
+        for (bool leading_edge : { true, false }) {
+            check_detector(trace, leading_edge, 1000);
+            check_detector(trace, leading_edge, WRAP_START_US);
+        }
+    }
+
+    events::EventQueue queue;
+    rtos::Thread dispatcher(osPriorityAboveNormal, OS_STACK_SIZE, nullptr, "input");
+    InterruptIn leading_line(USER_BUTTON);
+    InterruptIn settled_line(USER_BUTTON);
+    InputPipeline input(queue);
+    check(input.attach(leading_line, config(true)) == 0, "pipeline: attach of the leading-edge line");
+    check(input.attach(settled_line, config(false)) == 1, "pipeline: attach of the settled line");
+    input.subscribe(record);
+    dispatcher.start(callback(&queue, &events::EventQueue::dispatch_forever));
+
+    // one after the other from a second in, then each 150 ms before a wrap
+    uint64_t start_us = 1000000;
+    for (const Trace &trace : traces()) {
+        check_pipeline(trace, start_us);
+        start_us += trace.length_us + 1000000;
+    }
+    uint64_t wrap_us = 0;
+    for (const Trace &trace : traces()) {
+        wrap_us += 1ull << 32;
+        check_pipeline(trace, wrap_us - 150000);
+    }
+    check_held_up(wrap_us + 2000000);
+    check(input.dropped_edges() == 0, "pipeline: %lu edges dropped", (unsigned long)input.dropped_edges());
+
+    return check_summary("gesture-check");
+}
@@ -0,0 +1,256 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Check.h"
+#include "Lsm6dslFifo.h"
+#include "SimulatedLsm6dsl.h"
+
+/*
+ * Lsm6dslFifo draining a SimulatedLsm6dsl in virtual time, the sensor
+ * clock 2 % fast. Every drain is checked sample by sample against the
+ * data sets the model produced, so a lost, repeated or shifted word
+ * shows:
+ *
+ * - at the watermark interrupt, with a varying latency and now and then
+ *   a buffer too small for everything, the batches follow each other
+ *   without a gap and INT1 goes low;
+ * - once the tracking settled, the timestamps come within 700 us of the
+ *   production times with up to 300 us of latency (342 us seen) and the
+ *   period within 0.05 % of the sensor's;
+ * - after an overrun the batch is flagged and holds the newest data sets
+ *   the FIFO kept, the following ones go on from there;
+ * - after a burst read that stopped part way through a data set, drain()
+ *   drops the rest of that set and reads whole sets again, an overrun in
+ *   between or not;
+ * - a bus error loses nothing.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const int32_t CLOCK_ERROR_PPM = 20000;
+const uint16_t WATERMARK = 32;
+const uint16_t WORDS_PER_SET = sizeof(ImuSample) / sizeof(int16_t);
+/** Whole data sets the 2048-word FIFO holds. */
+const uint32_t FIFO_SETS = SimulatedLsm6dsl::FIFO_WORDS / WORDS_PER_SET;
+const size_t CAPACITY = 400;
+/** Virtual time step while waiting for INT1. */
+const uint32_t STEP_US = 20;
+
+/** Interrupt latency, from INT1 to the drain. */
+const uint32_t MAX_LATENCY_US = 300;
+/* Timestamp error in us and relative period error, past the first batches. */
+const double TIMESTAMP_ERROR_US = 700.0;
+const double PERIOD_ERROR = 0.0005;
+const uint32_t SETTLE_BATCHES = 40;
+
+uint32_t random_state = 0x9E3779B9;
+
+uint32_t random_below(uint32_t bound)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state % bound;
+}
+
+struct Bench {
+    SimulatedLsm6dsl sensor;
+    Lsm6dslFifo fifo;
+    uint32_t now_us;
+    /** Index of the next data set the reader expects. */
+    uint32_t next_set;
+    ImuSample samples[CAPACITY];
+    ImuBatch batch;
+
+    Bench() :
+        sensor(CLOCK_ERROR_PPM),
+        fifo(sensor),
+        now_us(1000),
+        next_set(0),
+        batch()
+    {
+    }
+
+    void wait(uint32_t us)
+    {
+        now_us += us;
+        sensor.advance_to(now_us);
+    }
+
+    /** Advance until INT1 rises. @return false if it does not within a second. */
+    bool wait_int1()
+    {
+        for (uint32_t waited = 0; waited < 1000000; waited += STEP_US) {
+            if (sensor.int1()) {
+                return true;
+            }
+            wait(STEP_US);
+        }
+        return false;
+    }
+
+    int drain(size_t capacity = CAPACITY)
+    {
+        return fifo.drain(samples, capacity, now_us, batch);
+    }
+};
+
+/** The batch holds data sets first, first + 1, ... whole and in order. */
+bool sets_follow(const Bench &bench, int count, uint32_t first, const char *where)
+{
+    for (int i = 0; i < count; i++) {
+        const ImuSample &sample = bench.samples[i];
+        const int16_t words[WORDS_PER_SET] = { sample.gyro[0], sample.gyro[1], sample.gyro[2],
+                                               sample.accel[0], sample.accel[1], sample.accel[2] };
+        for (int w = 0; w < WORDS_PER_SET; w++) {
+            if (words[w] != SimulatedLsm6dsl::expected_word(first + i, w)) {
+                return check(false, "%s: sample %d word %d is %d, set %lu expected", where, i, w, words[w],
+                             (unsigned long)(first + i));
+            }
+        }
+    }
+    return true;
+}
+
+/** Largest timestamp error of the batch against the production times. */
+double timestamp_error(const Bench &bench, int count, uint32_t first)
+{
+    double worst = 0.0;
+    for (int i = 0; i < count; i++) {
+        int32_t error = (int32_t)(bench.batch.timestamp_us(i) - bench.sensor.sample_time_us(first + i));
+        worst = abs(error) > worst ? abs(error) : worst;
+    }
+    return worst;
+}
+
+double actual_period_ns()
+{
+    // 1660 Hz is 6664 Hz >> 2 in the model
+    double nominal = 1e9 / (6664 >> 2);
+    return nominal * (1.0 + CLOCK_ERROR_PPM / 1e6);
+}
+
+/** The timestamps and the period once past SETTLE_BATCHES. */
+void check_watermark(Bench &bench, uint32_t batches)
+{
+    double worst = 0.0;
+    for (uint32_t b = 0; b < batches; b++) {
+        if (!check(bench.wait_int1(), "watermark: no INT1 after batch %lu", (unsigned long)b)) {
+            return;
+        }
+        uint32_t available = bench.sensor.produced() - bench.next_set;
+        check(available == WATERMARK, "watermark: INT1 with %lu data sets", (unsigned long)available);
+        bench.wait(20 + random_below(MAX_LATENCY_US - 20));
+
+        // one drain in seven with half the room: the rest stays for the next
+        size_t capacity = b % 7 == 6 ? WATERMARK / 2 : CAPACITY;
+        int count = bench.drain(capacity);
+        uint32_t left = bench.sensor.produced() - bench.next_set - (count > 0 ? count : 0);
+        if (!check(count > 0 && (size_t)count <= capacity && !bench.batch.overrun,
+                   "watermark: batch %lu drained %d", (unsigned long)b, count) ||
+            !sets_follow(bench, count, bench.next_set, "watermark")) {
+            return;
+        }
+        if (b >= SETTLE_BATCHES) {
+            double error = timestamp_error(bench, count, bench.next_set);
+            worst = error > worst ? error : worst;
+        }
+        bench.next_set += count;
+        if (left) {
+            count = bench.drain();
+            check(count == (int)left && sets_follow(bench, count, bench.next_set, "watermark, the rest"),
+                  "watermark: %lu data sets left, %d drained", (unsigned long)left, count);
+            bench.next_set += count > 0 ? count : 0;
+        }
+        check(!bench.sensor.int1(), "watermark: INT1 still high after batch %lu", (unsigned long)b);
+    }
+    if (batches <= SETTLE_BATCHES) {
+        return;
+    }
+    check(worst <= TIMESTAMP_ERROR_US, "watermark: timestamps off by %.0f us, bound %.0f", worst,
+          TIMESTAMP_ERROR_US);
+    double period = bench.batch.period_ns;
+    check(fabs(period / actual_period_ns() - 1.0) <= PERIOD_ERROR, "watermark: period %.0f ns, %.0f ns actual",
+          period, actual_period_ns());
+}
+
+void check_overrun(Bench &bench)
+{
+    uint32_t overruns = bench.fifo.stats().overruns;
+    bench.wait(400000);
+    check(bench.sensor.int1(), "overrun: INT1 low");
+    int count = bench.drain();
+    // continuous mode keeps the newest whole data sets
+    uint32_t first = bench.sensor.produced() - FIFO_SETS;
+    if (check(count == (int)FIFO_SETS && bench.batch.overrun && bench.fifo.stats().overruns == overruns + 1,
+              "overrun: %d data sets, overrun %d, %lu overruns", count, bench.batch.overrun,
+              (unsigned long)bench.fifo.stats().overruns)) {
+        sets_follow(bench, count, first, "overrun");
+    }
+    bench.next_set = first + (count > 0 ? count : 0);
+    check(!bench.sensor.int1(), "overrun: INT1 still high");
+    check_watermark(bench, 10);
+}
+
+void check_alignment(Bench &bench, uint16_t broken_words, bool overrun)
+{
+    bench.wait_int1();
+    // a burst that stopped after broken_words words of a data set
+    uint8_t scratch[2 * WORDS_PER_SET];
+    bench.sensor.read(Lsm6dslFifo::REG_FIFO_DATA_OUT_L, scratch, 2 * broken_words);
+    bench.next_set++;
+    if (overrun) {
+        // the FIFO keeps the tail of the broken data set and as many whole ones after it as fit
+        bench.wait(400000);
+        uint32_t tail = WORDS_PER_SET - broken_words;
+        bench.next_set = bench.sensor.produced() - (SimulatedLsm6dsl::FIFO_WORDS - tail) / WORDS_PER_SET;
+    }
+
+    uint32_t discarded = bench.fifo.stats().discarded_words;
+    int count = bench.drain();
+    uint32_t dropped = bench.fifo.stats().discarded_words - discarded;
+    if (check(count > 0 && dropped == (uint32_t)(WORDS_PER_SET - broken_words) && bench.batch.overrun == overrun,
+              "alignment: %u words read%s, %lu dropped, %d data sets", broken_words, overrun ? ", overrun" : "",
+              (unsigned long)dropped, count)) {
+        sets_follow(bench, count, bench.next_set, overrun ? "alignment after an overrun" : "alignment");
+    }
+    bench.next_set += count > 0 ? count : 0;
+    check_watermark(bench, 4);
+}
+
+void check_bus_error(Bench &bench)
+{
+    uint32_t errors = bench.fifo.stats().bus_errors;
+    bench.wait_int1();
+    bench.sensor.fail_next();
+    check(bench.drain() == -1 && bench.fifo.stats().bus_errors == errors + 1, "bus error: not reported");
+    int count = bench.drain();
+    check(count == (int)(bench.sensor.produced() - bench.next_set) &&
+          sets_follow(bench, count, bench.next_set, "after a bus error"),
+          "bus error: %d data sets drained next", count);
+    bench.next_set += count > 0 ? count : 0;
+    check_watermark(bench, 4);
+}
+
+} // namespace
+
+int main()
+{
+    static Bench bench;
+    Lsm6dslFifoConfig config = { LSM6DSL_ODR_1660HZ, WATERMARK, LSM6DSL_ACCEL_2G, LSM6DSL_GYRO_2000DPS };
+    if (check(bench.fifo.configure(config) == 0, "configure")) {
+        check_watermark(bench, 200);
+        check_overrun(bench);
+        for (uint16_t words = 1; words < WORDS_PER_SET; words++) {
+            check_alignment(bench, words, false);
+            check_alignment(bench, words, true);
+        }
+        check_bus_error(bench);
+    }
+    return check_summary("lsm6dsl-check");
+}
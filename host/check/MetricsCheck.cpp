@@ -0,0 +1,227 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Check.h"
+#include "Metrics.h"
+
+/*
+ * MetricsRegistry exports against the text and JSON they must give, a
+ * decode of the binary snapshot against the metrics it was made of, and
+ * every format into each buffer too small for it. Then the registry is
+ * filled past MAX_METRICS: the metrics beyond are not registered and the
+ * exports hold the first MAX_METRICS only.
+ *
+ * The last binary and JSON snapshots are written to metrics-check.bin and
+ * metrics-check.json, which `metrics.py selftest` decodes and compares
+ * (host_metrics_python).
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const uint32_t LATENCY_BOUNDS[] = { 10, 20, 50 };
+
+Counter frames("tx.frames");
+Gauge queue("tx.queue");
+Histogram<3> latency("tx.latency_ms", LATENCY_BOUNDS);
+Counter wrapped("rx.wrap");
+Gauge idle("rx.idle");
+
+const size_t BUFFER = 4096;
+
+void update()
+{
+    frames.inc(1234);
+    queue.set(5);
+    queue.add(2);
+    queue.add(-5);
+    for (uint32_t value : { 3u, 10u, 11u, 20u, 21u, 50u, 51u, 4000000000u, 4000000000u }) {
+        latency.record(value);
+    }
+    wrapped.inc(0xFFFFFFF0u);
+    wrapped.inc(0x20);
+}
+
+const char *const TEXT =
+    "tx.frames 1234\n"
+    "tx.queue 2 max 7\n"
+    "tx.latency_ms sum 3705032870 le10 2 le20 2 le50 2 inf 3\n"
+    "rx.wrap 16\n"
+    "rx.idle 0 max -2147483648\n";
+
+const char *const JSON =
+    "{\"tx.frames\":1234,\"tx.queue\":[2,7],"
+    "\"tx.latency_ms\":{\"b\":[10,20,50],\"c\":[2,2,2,3],\"s\":3705032870},"
+    "\"rx.wrap\":16,\"rx.idle\":[0,-2147483648]}";
+
+void check_formats()
+{
+    char text[BUFFER];
+    int length = MetricsRegistry::format_text(text, sizeof(text));
+    check(length == (int)strlen(TEXT) && strcmp(text, TEXT) == 0, "text export:\n%s", length >= 0 ? text : "");
+
+    char json[BUFFER];
+    length = MetricsRegistry::format_json(json, sizeof(json));
+    check(length == (int)strlen(JSON) && strcmp(json, JSON) == 0, "json export: %s", length >= 0 ? json : "");
+}
+
+uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/** Compare a binary snapshot with the registry, metric by metric. */
+void check_encoding(const uint8_t *data, int length)
+{
+    if (!check(length >= 3 && data[0] == 'M' && data[1] == 1 && data[2] == MetricsRegistry::count(),
+               "encode: header of %d bytes", length)) {
+        return;
+    }
+    int pos = 3;
+    for (size_t i = 0; i < MetricsRegistry::count(); i++) {
+        const Metric &metric = MetricsRegistry::metric(i);
+        size_t name_length = strlen(metric.name());
+        if (!check(pos + 2 + (int)name_length <= length && data[pos] == metric.type() &&
+                   data[pos + 1] == name_length && memcmp(data + pos + 2, metric.name(), name_length) == 0,
+                   "encode: metric %zu is not %s", i, metric.name())) {
+            return;
+        }
+        pos += 2 + name_length;
+        bool same = false;
+        int size = 0;
+        switch (metric.type()) {
+            case METRIC_COUNTER:
+                size = 4;
+                same = pos + size <= length && get32(data + pos) == static_cast<const Counter &>(metric).value();
+                break;
+            case METRIC_GAUGE: {
+                const Gauge &gauge = static_cast<const Gauge &>(metric);
+                size = 8;
+                same = pos + size <= length && (int32_t)get32(data + pos) == gauge.value() &&
+                       (int32_t)get32(data + pos + 4) == gauge.max();
+                break;
+            }
+            case METRIC_HISTOGRAM: {
+                const HistogramBase &histogram = static_cast<const HistogramBase &>(metric);
+                size = 1 + 4 * (2 * histogram.bound_count() + 2);
+                same = pos + size <= length && data[pos] == histogram.bound_count();
+                const uint8_t *p = data + pos + 1;
+                for (size_t b = 0; same && b < histogram.bound_count(); b++, p += 4) {
+                    same = get32(p) == histogram.bounds()[b];
+                }
+                for (size_t b = 0; same && b < histogram.bucket_count(); b++, p += 4) {
+                    same = get32(p) == histogram.bucket(b);
+                }
+                same = same && get32(p) == histogram.sum();
+                break;
+            }
+        }
+        if (!check(same, "encode: value of %s", metric.name())) {
+            return;
+        }
+        pos += size;
+    }
+    check(pos == length, "encode: %d bytes, %d decoded", length, pos);
+}
+
+/** Each format into every buffer shorter than it needs: -1, nothing past the buffer. */
+void check_small_buffers()
+{
+    static char full[BUFFER];
+    static uint8_t encoded[BUFFER];
+    int text = MetricsRegistry::format_text(full, sizeof(full));
+    int json = MetricsRegistry::format_json(full, sizeof(full));
+    int binary = MetricsRegistry::encode(encoded, sizeof(encoded));
+    if (!check(text > 0 && json > 0 && binary > 0, "exports of the full registry: %d, %d, %d", text, json, binary)) {
+        return;
+    }
+
+    const char GUARD = 0x5A;
+    static char buffer[BUFFER + 1];
+    unsigned wrong = 0;
+    // the text formats need room for the terminating NUL, the binary one does not
+    for (int capacity = 0; capacity <= json + 1; capacity++) {
+        memset(buffer, GUARD, sizeof(buffer));
+        int expected = capacity > text ? text : -1;
+        wrong += MetricsRegistry::format_text(buffer, capacity) != expected || buffer[capacity] != GUARD;
+        memset(buffer, GUARD, sizeof(buffer));
+        expected = capacity > json ? json : -1;
+        wrong += MetricsRegistry::format_json(buffer, capacity) != expected || buffer[capacity] != GUARD;
+        memset(buffer, GUARD, sizeof(buffer));
+        expected = capacity >= binary ? binary : -1;
+        wrong += MetricsRegistry::encode(reinterpret_cast<uint8_t *>(buffer), capacity) != expected ||
+                 buffer[capacity] != GUARD;
+    }
+    check(wrong == 0, "exports into small buffers: %u wrong lengths or overruns", wrong);
+}
+
+/** Fill the registry, then register two more. */
+void check_overflow()
+{
+    static char names[MetricsRegistry::MAX_METRICS + 2][16];
+    size_t registered = MetricsRegistry::count();
+    for (size_t i = registered; i < MetricsRegistry::MAX_METRICS + 2; i++) {
+        snprintf(names[i], sizeof(names[i]), "fill.%zu", i);
+        // registered metrics live as long as the image
+        Counter *counter = new Counter(names[i]);
+        counter->inc(i);
+    }
+    check(MetricsRegistry::count() == MetricsRegistry::MAX_METRICS, "%zu metrics registered, MAX_METRICS is %zu",
+          MetricsRegistry::count(), MetricsRegistry::MAX_METRICS);
+    check(MetricsRegistry::find(names[MetricsRegistry::MAX_METRICS - 1]) != nullptr,
+          "last metric that fits not found");
+    check(MetricsRegistry::find(names[MetricsRegistry::MAX_METRICS]) == nullptr &&
+          MetricsRegistry::find(names[MetricsRegistry::MAX_METRICS + 1]) == nullptr,
+          "metrics past MAX_METRICS found");
+    check(MetricsRegistry::add(frames) == false, "add to the full registry");
+
+    static char text[BUFFER];
+    int length = MetricsRegistry::format_text(text, sizeof(text));
+    std::string exported(text, length > 0 ? length : 0);
+    size_t lines = 0;
+    for (char c : exported) {
+        lines += c == '\n';
+    }
+    check(lines == MetricsRegistry::MAX_METRICS && exported.compare(0, strlen(TEXT), TEXT) == 0 &&
+          exported.find("fill.32") == std::string::npos,
+          "text export of the full registry: %zu lines", lines);
+}
+
+bool write_file(const char *path, const void *data, size_t length)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = fwrite(data, 1, length, file) == length;
+    return fclose(file) == 0 && written;
+}
+
+} // namespace
+
+int main()
+{
+    check(MetricsRegistry::count() == 5, "%zu static metrics registered, 5 expected", MetricsRegistry::count());
+    update();
+    check_formats();
+
+    static uint8_t encoded[BUFFER];
+    check_encoding(encoded, MetricsRegistry::encode(encoded, sizeof(encoded)));
+    check_small_buffers();
+
+    check_overflow();
+    int length = MetricsRegistry::encode(encoded, sizeof(encoded));
+    check_encoding(encoded, length);
+    check_small_buffers();
+
+    static char json[BUFFER];
+    int json_length = MetricsRegistry::format_json(json, sizeof(json));
+    check(length > 0 && json_length > 0 && write_file("metrics-check.bin", encoded, length) &&
+          write_file("metrics-check.json", json, json_length),
+          "cannot write the snapshots");
+    return check_summary("metrics-check");
+}
@@ -0,0 +1,355 @@
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "BlockPool.h"
+#include "Check.h"
+#include "PoolAllocator.h"
+
+/*
+ * The block pools and the size class allocator of the network buffers:
+ *
+ * - a pool of N blocks gives N distinct blocks, then nullptr, each
+ *   failure counted;
+ * - in use and high-water counts follow alloc() and free(), and
+ *   reset_stats() brings the high-water mark down to what is in use;
+ * - PoolAllocator takes the smallest size class that fits, whatever the
+ *   order the pools were added in, goes on to the next class when that one
+ *   is empty and gives nullptr past the largest;
+ * - PoolBuffer and PoolArray give their block back on scope exit, and
+ *   PoolArray constructs and destroys its elements;
+ * - threads allocating and freeing the blocks of one pool never get a
+ *   block another one holds, and leave every block free.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const size_t STRESS_BLOCKS = 6;
+const int STRESS_THREADS = 4;
+const int STRESS_ROUNDS = 200000;
+
+bool check_stats(const char *what, const BlockPoolBase &pool, size_t in_use, size_t high_water, uint32_t failures)
+{
+    PoolStats stats = pool.stats();
+    return check(stats.in_use == in_use && stats.high_water == high_water && stats.failures == failures,
+                 "%s: %zu in use, high water %zu, %lu failures; %zu, %zu, %lu expected", what, stats.in_use,
+                 stats.high_water, (unsigned long)stats.failures, in_use, high_water, (unsigned long)failures);
+}
+
+void check_exhaustion()
+{
+    static BlockPool<24, 5> pool;
+    const size_t count = BlockPool<24, 5>::COUNT;
+    check(pool.capacity() == count && pool.block_size() == 24, "pool: %zu blocks of %zu bytes", pool.capacity(),
+          pool.block_size());
+    check_stats("new pool", pool, 0, 0, 0);
+
+    void *blocks[count];
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = pool.alloc();
+        check(blocks[i] && pool.owns(blocks[i]), "alloc %zu: %p not from the pool", i, blocks[i]);
+        check((uintptr_t)blocks[i] % 8 == 0, "alloc %zu: %p not 8-byte aligned", i, blocks[i]);
+        for (size_t j = 0; j < i; j++) {
+            check(blocks[i] != blocks[j], "alloc %zu: block of alloc %zu again", i, j);
+        }
+        // the whole block is the caller's, the free list must not rely on it
+        if (blocks[i]) {
+            memset(blocks[i], 0xA5, pool.block_size());
+        }
+    }
+    check(pool.alloc() == nullptr, "pool: a block past %zu", count);
+    check(pool.alloc() == nullptr, "pool: a block past %zu", count);
+    check_stats("exhausted", pool, count, count, 2);
+
+    pool.free(blocks[1]);
+    pool.free(blocks[3]);
+    pool.free(nullptr);
+    check_stats("two freed", pool, count - 2, count, 2);
+    void *again[2] = { pool.alloc(), pool.alloc() };
+    check((again[0] == blocks[1] || again[0] == blocks[3]) && (again[1] == blocks[1] || again[1] == blocks[3]) &&
+          again[0] != again[1], "two freed: %p and %p back, %p and %p freed", again[0], again[1], blocks[1], blocks[3]);
+    check(pool.alloc() == nullptr, "two freed: a third block");
+    check_stats("two allocated again", pool, count, count, 3);
+
+    for (size_t i = 0; i < count; i++) {
+        pool.free(blocks[i]);
+    }
+    check_stats("all freed", pool, 0, count, 3);
+    pool.reset_stats();
+    check_stats("reset", pool, 0, 0, 0);
+    void *one = pool.alloc();
+    void *two = pool.alloc();
+    pool.free(one);
+    check_stats("after the reset", pool, 1, 2, 0);
+    pool.reset_stats();
+    check_stats("reset with a block in use", pool, 1, 1, 0);
+    pool.free(two);
+}
+
+void check_size_classes()
+{
+    static BlockPool<512, 2> large;
+    static BlockPool<32, 4> small;
+    static BlockPool<128, 2> medium;
+    PoolAllocator allocator;
+    // out of order, the allocator sorts them
+    check(allocator.add(large) && allocator.add(small) && allocator.add(medium) && allocator.classes() == 3,
+          "allocator: %zu classes", allocator.classes());
+    for (size_t i = 1; i < allocator.classes(); i++) {
+        check(allocator.pool(i - 1).block_size() < allocator.pool(i).block_size(),
+              "allocator: class %zu of %zu bytes after %zu", i, allocator.pool(i).block_size(),
+              allocator.pool(i - 1).block_size());
+    }
+
+    struct Request {
+        size_t size;
+        const BlockPoolBase *pool;
+    };
+    const Request smallest[] = {
+        { 1, &small }, { 32, &small }, { 33, &medium }, { 128, &medium }, { 129, &large }, { 512, &large },
+    };
+    for (const Request &request : smallest) {
+        void *block = allocator.alloc(request.size);
+        check(block && request.pool->owns(block), "%zu bytes: not from the class of %zu", request.size,
+              request.pool->block_size());
+        allocator.free(block);
+    }
+    check(allocator.alloc(513) == nullptr, "513 bytes: a block past the largest class");
+    check_stats("small after the requests", small, 0, 1, 0);
+    check_stats("large after the requests", large, 0, 1, 0);
+
+    // 16 bytes: the four small blocks, then the medium ones, then the large ones
+    std::vector<void *> blocks;
+    const BlockPoolBase *const order[] = { &small, &small, &small, &small, &medium, &medium, &large, &large };
+    for (const BlockPoolBase *pool : order) {
+        void *block = allocator.alloc(16);
+        check(block && pool->owns(block), "16 bytes, %zu taken: not from the class of %zu", blocks.size(),
+              pool->block_size());
+        blocks.push_back(block);
+    }
+    check(allocator.alloc(16) == nullptr, "16 bytes: a block with every class empty");
+    check(allocator.alloc(200) == nullptr, "200 bytes: a block with every class empty");
+    // a failure for each class tried empty, none for those too small
+    check_stats("small exhausted", small, 4, 4, 5);
+    check_stats("medium exhausted", medium, 2, 2, 3);
+    check_stats("large exhausted", large, 2, 2, 2);
+
+    // a small block back: the next small request takes it, not a larger one
+    allocator.free(blocks[2]);
+    check_stats("small block freed", small, 3, 4, 5);
+    void *block = allocator.alloc(8);
+    check(block == blocks[2], "8 bytes: %p, the freed small block %p expected", block, blocks[2]);
+    for (void *b : blocks) {
+        allocator.free(b);
+    }
+    check_stats("small freed", small, 0, 4, 5);
+    check_stats("medium freed", medium, 0, 2, 3);
+    check_stats("large freed", large, 0, 2, 2);
+    allocator.free(nullptr);
+
+    PoolAllocator full;
+    for (size_t i = 0; i < PoolAllocator::MAX_CLASSES; i++) {
+        full.add(small);
+    }
+    check(!full.add(medium) && full.classes() == PoolAllocator::MAX_CLASSES, "allocator: a class past %zu",
+          PoolAllocator::MAX_CLASSES);
+}
+
+struct Counted {
+    static int alive;
+
+    uint32_t value;
+
+    Counted() : value(0x5EED)
+    {
+        alive++;
+    }
+
+    ~Counted()
+    {
+        alive--;
+    }
+};
+
+int Counted::alive = 0;
+
+void check_scoped()
+{
+    static BlockPool<64, 2> frames;
+    static BlockPool<256, 1> batches;
+    PoolAllocator allocator;
+    allocator.add(frames);
+    allocator.add(batches);
+
+    {
+        PoolBuffer frame(allocator, 48);
+        check(frame && frame.size() == 48 && frames.owns(frame.data()), "PoolBuffer: 48 bytes not from the frames");
+        PoolBuffer batch(allocator, 200);
+        check(batch && batches.owns(batch.data()), "PoolBuffer: 200 bytes not from the batches");
+        PoolBuffer none(allocator, 300);
+        check(!none && none.size() == 0 && none.data() == nullptr, "PoolBuffer: 300 bytes from a pool");
+        check_stats("PoolBuffer in scope", frames, 1, 1, 0);
+    }
+    check_stats("PoolBuffer out of scope, frames", frames, 0, 1, 0);
+    check_stats("PoolBuffer out of scope, batches", batches, 0, 1, 0);
+
+    void *kept;
+    {
+        PoolBuffer frame(allocator, 8);
+        kept = frame.release();
+        check(!frame && frame.size() == 0, "PoolBuffer: still holding a block after release()");
+    }
+    check_stats("PoolBuffer released", frames, 1, 1, 0);
+    allocator.free(kept);
+
+    {
+        PoolArray<Counted> values(allocator, 12);
+        check(values && values.size() == 12 && frames.owns(values.data()), "PoolArray: 12 values not from the frames");
+        check(Counted::alive == 12, "PoolArray: %d values constructed", Counted::alive);
+        bool constructed = true;
+        for (size_t i = 0; i < values.size(); i++) {
+            constructed = constructed && values[i].value == 0x5EED;
+        }
+        check(constructed, "PoolArray: a value not constructed");
+        PoolArray<Counted> more(allocator, 60);
+        check(more && batches.owns(more.data()) && Counted::alive == 72, "PoolArray: 60 values, %d alive",
+              Counted::alive);
+        PoolArray<Counted> none(allocator, 100);
+        check(!none && none.size() == 0 && Counted::alive == 72, "PoolArray: 100 values, %d alive", Counted::alive);
+    }
+    check(Counted::alive == 0, "PoolArray out of scope: %d values alive", Counted::alive);
+    check_stats("PoolArray out of scope, frames", frames, 0, 1, 0);
+    check_stats("PoolArray out of scope, batches", batches, 0, 1, 0);
+}
+
+BlockPool<16, STRESS_BLOCKS> stress_pool;
+/** The blocks of the stress pool, and the thread holding each, 0 for none. */
+void *stress_blocks[STRESS_BLOCKS];
+std::atomic<int> holder[STRESS_BLOCKS];
+
+struct Worker {
+    int id;
+    uint32_t taken;
+    uint32_t empty;
+    /** Blocks handed out while another thread held them, or written over in its hands. */
+    uint32_t shared;
+    /** Blocks not of the pool. */
+    uint32_t foreign;
+};
+
+int index_of(void *block)
+{
+    for (size_t i = 0; i < STRESS_BLOCKS; i++) {
+        if (stress_blocks[i] == block) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/** Alloc up to two blocks, fill them with the id, yield, check and free them. */
+void work(Worker *worker)
+{
+    for (int round = 0; round < STRESS_ROUNDS; round++) {
+        void *blocks[2];
+        int indexes[2];
+        int held = 0;
+        for (int i = 0; i < 2; i++) {
+            void *block = stress_pool.alloc();
+            int index = block ? index_of(block) : -1;
+            if (!block) {
+                worker->empty++;
+                continue;
+            }
+            if (index < 0) {
+                worker->foreign++;
+                continue;
+            }
+            int other = holder[index].exchange(worker->id);
+            worker->shared += other != 0;
+            memset(block, worker->id, stress_pool.block_size());
+            blocks[held] = block;
+            indexes[held++] = index;
+            worker->taken++;
+        }
+        if (round % 4 == 0) {
+            std::this_thread::yield();
+        }
+        for (int i = held - 1; i >= 0; i--) {
+            const uint8_t *bytes = static_cast<const uint8_t *>(blocks[i]);
+            bool intact = holder[indexes[i]].exchange(0) == worker->id;
+            for (size_t j = 0; j < stress_pool.block_size(); j++) {
+                intact = intact && bytes[j] == worker->id;
+            }
+            worker->shared += !intact;
+            stress_pool.free(blocks[i]);
+        }
+    }
+}
+
+void check_threads()
+{
+    for (size_t i = 0; i < STRESS_BLOCKS; i++) {
+        stress_blocks[i] = stress_pool.alloc();
+        holder[i].store(0);
+    }
+    // pushed back in reverse, so that the free list is not the storage order
+    for (size_t i = STRESS_BLOCKS; i > 0; i--) {
+        stress_pool.free(stress_blocks[i % STRESS_BLOCKS]);
+    }
+
+    Worker workers[STRESS_THREADS];
+    std::thread threads[STRESS_THREADS];
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        workers[i] = { i + 1, 0, 0, 0, 0 };
+        threads[i] = std::thread(work, &workers[i]);
+    }
+    uint32_t taken = 0;
+    uint32_t empty = 0;
+    for (int i = 0; i < STRESS_THREADS; i++) {
+        threads[i].join();
+        taken += workers[i].taken;
+        empty += workers[i].empty;
+        check(workers[i].shared == 0 && workers[i].foreign == 0,
+              "threads: worker %d got %lu blocks held by another, %lu not of the pool", workers[i].id,
+              (unsigned long)workers[i].shared, (unsigned long)workers[i].foreign);
+    }
+
+    PoolStats stats = stress_pool.stats();
+    check(stats.in_use == 0 && stats.high_water <= STRESS_BLOCKS && stats.failures == empty,
+          "threads: %zu in use, high water %zu, %lu failures, %lu seen", stats.in_use, stats.high_water,
+          (unsigned long)stats.failures, (unsigned long)empty);
+    // every block on the free list once
+    void *blocks[STRESS_BLOCKS];
+    bool distinct = true;
+    for (size_t i = 0; i < STRESS_BLOCKS; i++) {
+        blocks[i] = stress_pool.alloc();
+        distinct = distinct && index_of(blocks[i]) >= 0;
+        for (size_t j = 0; j < i; j++) {
+            distinct = distinct && blocks[i] != blocks[j];
+        }
+    }
+    check(distinct && stress_pool.alloc() == nullptr, "threads: the free list lost or doubled a block");
+    for (void *block : blocks) {
+        stress_pool.free(block);
+    }
+    printf("pool-check: %d threads, %lu blocks taken, %lu times the pool was empty\n", STRESS_THREADS,
+           (unsigned long)taken, (unsigned long)empty);
+}
+
+} // namespace
+
+int main()
+{
+    check_exhaustion();
+    check_size_classes();
+    check_scoped();
+    check_threads();
+    return check_summary("pool-check");
+}
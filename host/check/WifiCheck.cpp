@@ -0,0 +1,236 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "ApCache.h"
+#include "Check.h"
+#include "FileFlash.h"
+#include "SimulatedWifiRadio.h"
+#include "WifiConnector.h"
+
+/*
+ * Boots of a board with WifiConnector on a SimulatedWifiRadio, the
+ * ApCache sector in a FileFlash that outlives them, times in the virtual
+ * milliseconds of the radio:
+ *
+ * - the first boot scans and goes to the strongest AP of the SSID;
+ * - every boot after it goes to the cached AP without a scan, in the
+ *   time of one channel, association and DHCP, and writes no flash;
+ * - with the cached AP off the air a boot pays for the failed attempt,
+ *   scans and caches the next AP, from which the following boot starts;
+ * - maintain() roams to a candidate stronger by the margin, and only
+ *   then, and the next boot starts from there;
+ * - past a sector of cache slots the sector is erased once, and a slot
+ *   torn by a power cut leaves the one before it;
+ * - with no AP of the SSID left, connect() fails.
+ */
+
+using namespace lab;
+using namespace lab_check;
+
+namespace {
+
+const char *const FLASH_PATH = "wifi-check.bin";
+const size_t SECTOR = 4096;
+const char *const SSID = "lab";
+const char *const PASSWORD = "password";
+// nsapi_security_t
+const uint8_t WPA2 = 3;
+
+const ApInfo AP_A = { "lab", { 0x02, 0, 0, 0, 0, 0xA }, 6, WPA2, -60 };
+const ApInfo AP_B = { "lab", { 0x02, 0, 0, 0, 0, 0xB }, 11, WPA2, -48 };
+const ApInfo AP_OTHER = { "guest", { 0x02, 0, 0, 0, 0, 0xC }, 1, WPA2, -35 };
+
+/** What one boot did. */
+struct Boot {
+    /** AP of the cache at boot, nullptr if none. */
+    const ApInfo *loaded;
+    int err;
+    WifiConnectPath path;
+    /** AP connected to as the cache has it, nullptr if none. */
+    const ApInfo *ap;
+    uint32_t ms;
+    uint32_t scans;
+    uint32_t writes;
+};
+
+const ApInfo *known(const ApInfo *ap)
+{
+    const ApInfo *const candidates[] = { &AP_A, &AP_B };
+    for (const ApInfo *candidate : candidates) {
+        if (ap && memcmp(ap->bssid, candidate->bssid, sizeof(ap->bssid)) == 0 && ap->channel == candidate->channel) {
+            return candidate;
+        }
+    }
+    return nullptr;
+}
+
+const char *name(const ApInfo *ap)
+{
+    return ap == &AP_A ? "A" : (ap == &AP_B ? "B" : "none");
+}
+
+const char *path_name(WifiConnectPath path)
+{
+    switch (path) {
+        case WIFI_PATH_CACHED:
+            return "cached";
+        case WIFI_PATH_SCANNED:
+            return "scanned";
+        case WIFI_PATH_BLIND:
+            return "blind";
+        case WIFI_PATH_NONE:
+        default:
+            return "none";
+    }
+}
+
+class Board {
+public:
+    explicit Board(SimulatedWifiRadio &radio) :
+        _radio(radio),
+        _flash(FLASH_PATH, 2 * SECTOR, 256, SECTOR),
+        _writes(0)
+    {
+    }
+
+    bool is_open() const
+    {
+        return _flash.is_open();
+    }
+
+    FileFlash &flash()
+    {
+        return _flash;
+    }
+
+    /** Cache slots written over every boot. */
+    uint32_t writes() const
+    {
+        return _writes;
+    }
+
+    /**
+     * Reset, load the cache and connect.
+     *
+     * @param[in] roam_margin_db if not 0, a maintain() with it after the connect.
+     */
+    Boot boot(uint8_t roam_margin_db = 0)
+    {
+        _radio.disconnect();
+        ApCache cache(_flash, 0);
+        WifiConnector connector(_radio, cache, SSID, PASSWORD);
+        Boot boot = {};
+        boot.loaded = cache.load() ? known(cache.last_good()) : nullptr;
+        uint32_t start_ms = _radio.now_ms();
+        uint32_t scans = _radio.scans();
+        boot.err = connector.connect();
+        boot.ms = _radio.now_ms() - start_ms;
+        if (roam_margin_db && boot.err == 0) {
+            connector.maintain(roam_margin_db);
+        }
+        boot.path = connector.path();
+        boot.ap = connector.connected() ? known(cache.last_good()) : nullptr;
+        boot.scans = _radio.scans() - scans;
+        boot.writes = cache.writes();
+        _writes += boot.writes;
+        return boot;
+    }
+
+private:
+    SimulatedWifiRadio &_radio;
+    FileFlash _flash;
+    uint32_t _writes;
+};
+
+bool expect(const char *what, const Boot &boot, WifiConnectPath path, const ApInfo *ap, uint32_t ms, uint32_t scans,
+            uint32_t writes)
+{
+    return check(boot.err == (ap ? 0 : boot.err) && boot.path == path && boot.ap == ap && boot.ms == ms &&
+                 boot.scans == scans && boot.writes == writes,
+                 "%s: %s to %s in %lu ms, %lu scans, %lu cache writes; %s to %s in %lu ms, %lu, %lu expected", what,
+                 path_name(boot.path), name(boot.ap), (unsigned long)boot.ms, (unsigned long)boot.scans,
+                 (unsigned long)boot.writes, path_name(path), name(ap), (unsigned long)ms, (unsigned long)scans,
+                 (unsigned long)writes);
+}
+
+} // namespace
+
+int main()
+{
+    const WifiTiming timing = SimulatedWifiRadio::default_timing();
+    const uint32_t SCAN_MS = timing.scan_channel_ms * timing.channels;
+    const uint32_t CACHED_MS = timing.scan_channel_ms + timing.associate_ms + timing.dhcp_ms;
+    const uint32_t SCANNED_MS = SCAN_MS + CACHED_MS;
+    const uint32_t FALLBACK_MS = timing.scan_channel_ms + timing.fail_ms + SCANNED_MS;
+
+    remove(FLASH_PATH);
+    SimulatedWifiRadio radio;
+    radio.add_ap(AP_A);
+    radio.add_ap(AP_B);
+    radio.add_ap(AP_OTHER);
+    Board board(radio);
+    if (!check(board.is_open(), "%s: cannot open", FLASH_PATH)) {
+        return check_summary("wifi-check");
+    }
+
+    Boot boot = board.boot();
+    check(boot.loaded == nullptr, "cold boot: cache not empty");
+    expect("cold boot", boot, WIFI_PATH_SCANNED, &AP_B, SCANNED_MS, 1, 1);
+    for (int i = 0; i < 5; i++) {
+        boot = board.boot();
+        check(boot.loaded == &AP_B, "reboot %d: %s cached", i, name(boot.loaded));
+        expect("reboot", boot, WIFI_PATH_CACHED, &AP_B, CACHED_MS, 0, 0);
+    }
+    printf("wifi-check: cold boot %lu ms, reboot from the cache %lu ms\n", (unsigned long)SCANNED_MS,
+           (unsigned long)CACHED_MS);
+
+    radio.set_up(AP_B.bssid, false);
+    expect("cached AP gone", board.boot(), WIFI_PATH_SCANNED, &AP_A, FALLBACK_MS, 1, 1);
+    expect("reboot after the fallback", board.boot(), WIFI_PATH_CACHED, &AP_A, CACHED_MS, 0, 0);
+
+    // B back 12 dB above A: a margin of 16 keeps A, 8 moves to B
+    radio.set_up(AP_B.bssid, true);
+    expect("roam margin not met", board.boot(16), WIFI_PATH_CACHED, &AP_A, CACHED_MS, 1, 0);
+    expect("roam", board.boot(8), WIFI_PATH_SCANNED, &AP_B, CACHED_MS, 1, 1);
+    expect("reboot after the roam", board.boot(), WIFI_PATH_CACHED, &AP_B, CACHED_MS, 0, 0);
+
+    // one AP at a time, a cache write each boot, past a sector of slots
+    const uint32_t SLOTS = SECTOR / ApCache::SLOT_SIZE;
+    const ApInfo *up = &AP_B;
+    for (uint32_t i = 0; i < SLOTS + 8; i++) {
+        const ApInfo *down = up;
+        up = up == &AP_A ? &AP_B : &AP_A;
+        radio.set_up(up->bssid, true);
+        radio.set_up(down->bssid, false);
+        if (!expect("alternating APs", board.boot(), WIFI_PATH_SCANNED, up, FALLBACK_MS, 1, 1)) {
+            break;
+        }
+    }
+    check(board.flash().erase_count(0) == (board.writes() - 1) / SLOTS, "%lu cache writes, %lu sector erases",
+          (unsigned long)board.writes(), (unsigned long)board.flash().erase_count(0));
+
+    // the slot of the next AP torn: the boot connects, the one after finds the AP before it
+    const ApInfo *down = up;
+    up = up == &AP_A ? &AP_B : &AP_A;
+    radio.set_up(up->bssid, true);
+    radio.set_up(down->bssid, false);
+    board.flash().cut_power_after(ApCache::SLOT_SIZE / 2);
+    boot = board.boot();
+    check(boot.err == 0 && boot.path == WIFI_PATH_SCANNED, "torn slot: %s, error %d", path_name(boot.path),
+          boot.err);
+    board.flash().restore_power();
+    radio.set_up(down->bssid, true);
+    boot = board.boot();
+    check(boot.loaded == down, "torn slot: %s cached, %s expected", name(boot.loaded), name(down));
+    expect("after the torn slot", boot, WIFI_PATH_CACHED, down, CACHED_MS, 0, 0);
+
+    radio.set_up(AP_A.bssid, false);
+    radio.set_up(AP_B.bssid, false);
+    boot = board.boot();
+    check(boot.err != 0 && boot.path == WIFI_PATH_NONE && boot.ap == nullptr, "no AP: %s, error %d",
+          path_name(boot.path), boot.err);
+
+    remove(FLASH_PATH);
+    return check_summary("wifi-check");
+}
@@ -0,0 +1,30 @@
+# Run a program twice and fail unless both runs print the same; lines
+# matching IGNORE (real time measurements) are left out. The environment
+# is the caller's, so ctest's ENVIRONMENT reaches the program.
+#
+#   cmake -DPROGRAM=<path> [-DIGNORE=<regex>] -P CompareRuns.cmake
+
+foreach(run 1 2)
+    execute_process(
+        COMMAND ${PROGRAM}
+        OUTPUT_VARIABLE output
+        ERROR_VARIABLE output
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${PROGRAM} exited with ${result}")
+    endif()
+    if(IGNORE)
+        string(REGEX REPLACE "[^\n]*(${IGNORE})[^\n]*\n" "" output "${output}")
+    endif()
+    set(output_${run} "${output}")
+endforeach()
+
+if(NOT output_1 STREQUAL output_2)
+    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/run1.txt "${output_1}")
+    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/run2.txt "${output_2}")
+    message(FATAL_ERROR "The runs differ, see run1.txt and run2.txt in ${CMAKE_CURRENT_BINARY_DIR}")
+endif()
+
+string(LENGTH "${output_1}" length)
+message("Both runs printed the same ${length} bytes")
@@ -0,0 +1,231 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "CommandProtocol.h"
+
+/*
+ * Fuzzing of the command parser of lab-utils/ble/CommandProtocol.h, the
+ * bytes a central writes to the command characteristic.
+ *
+ * LLVMFuzzerTestOneInput() takes one packet and aborts if the parser
+ * broke a rule:
+ *
+ *   - a malformed packet applies nothing
+ *   - a good one applies each command once, in order
+ *   - the commands read back encode to the packet, byte for byte
+ *
+ * Built with clang and LAB_HOST_LIBFUZZER the fuzzer drives it; without
+ * it main() below does: random packets and mutations of good ones from a
+ * fixed seed,
+ *
+ *     command-fuzz [ITERATIONS] [SEED]
+ *
+ * LAB_HOST_SANITIZE adds the checks on the reads.
+ */
+
+namespace {
+
+/** Records the commands it gets, and turns some down. */
+class RecordingTarget : public lab::CommandTarget {
+public:
+    uint8_t apply(const lab::Command &command) override
+    {
+        commands.push_back(command);
+        // register 0xFF and LED 7 are not there, as on a board
+        if (command.opcode == lab::COMMAND_REGISTERS && command.target == 0xFF) {
+            return lab::COMMAND_ERROR_TARGET;
+        }
+        if (command.opcode == lab::COMMAND_LED && command.target == 7) {
+            return lab::COMMAND_ERROR_TARGET;
+        }
+        return lab::COMMAND_OK;
+    }
+
+    std::vector<lab::Command> commands;
+};
+
+void fail(const char *rule, const uint8_t *data, size_t size)
+{
+    fprintf(stderr, "command-fuzz: %s, packet of %zu bytes:", rule, size);
+    for (size_t i = 0; i < size; i++) {
+        fprintf(stderr, " %02x", data[i]);
+    }
+    fputs("\n", stderr);
+    abort();
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    // a copy of exactly size bytes, so a read past the end is one for the sanitizer
+    std::vector<uint8_t> packet(data, data + size);
+    const uint8_t *bytes = packet.empty() ? nullptr : packet.data();
+
+    RecordingTarget target;
+    lab::CommandStatus status = {};
+    lab::apply_commands(bytes, size, target, status);
+    if (status.packets != 1) {
+        fail("packet not counted", data, size);
+    }
+    if (status.result == lab::COMMAND_RESULT_MALFORMED) {
+        if (!target.commands.empty() || status.applied) {
+            fail("malformed packet applied", data, size);
+        }
+        if (size && status.error >= size && status.error != 0xFF) {
+            fail("error offset past the packet", data, size);
+        }
+        return 0;
+    }
+    if (status.sequence != packet[0]) {
+        fail("wrong sequence", data, size);
+    }
+    if (status.applied > target.commands.size() ||
+        (status.result == lab::COMMAND_RESULT_OK) != (status.failed == 0xFF)) {
+        fail("status does not add up", data, size);
+    }
+
+    std::vector<uint8_t> encoded(1, packet[0]);
+    uint8_t command[256];
+    for (const lab::Command &applied : target.commands) {
+        int length = lab::encode_command(applied, command, sizeof(command));
+        if (length <= 0) {
+            fail("command does not encode", data, size);
+        }
+        encoded.insert(encoded.end(), command, command + length);
+    }
+    // LED states other than 0 and 1 read back as 1
+    for (size_t i = 1; i + 2 < packet.size();) {
+        if (packet[i] == lab::COMMAND_LED && packet[i + 2]) {
+            packet[i + 2] = 1;
+        }
+        static const size_t sizes[] = { 0, 3, 5, 4, 0, 1 };
+        i += packet[i] == lab::COMMAND_REGISTERS ? 3 + (size_t)packet[i + 2] : sizes[packet[i]];
+    }
+    if (encoded != packet) {
+        fail("commands do not encode to the packet", data, size);
+    }
+    return 0;
+}
+
+#if !defined(LAB_HOST_LIBFUZZER)
+
+namespace {
+
+uint32_t fuzz_state;
+
+uint32_t fuzz_next()
+{
+    fuzz_state ^= fuzz_state << 13;
+    fuzz_state ^= fuzz_state >> 17;
+    fuzz_state ^= fuzz_state << 5;
+    return fuzz_state;
+}
+
+/** A well formed packet of up to 12 commands. */
+size_t good_packet(uint8_t *packet, size_t capacity)
+{
+    size_t size = 0;
+    packet[size++] = (uint8_t)fuzz_next();
+    unsigned commands = fuzz_next() % 13;
+    uint8_t values[255];
+    for (unsigned i = 0; i < commands; i++) {
+        lab::Command command = {};
+        command.opcode = (uint8_t)(1 + fuzz_next() % 5);
+        command.target = (uint8_t)(fuzz_next() % 4 ? fuzz_next() % 8 : fuzz_next());
+        command.value = (uint16_t)(command.opcode == lab::COMMAND_LED ? fuzz_next() % 2 : fuzz_next() % 1200);
+        command.on_ms = (uint16_t)(fuzz_next() % 256 * 10);
+        command.off_ms = (uint16_t)(fuzz_next() % 256 * 10);
+        command.count = (uint8_t)(1 + fuzz_next() % 40);
+        for (size_t k = 0; k < command.count; k++) {
+            values[k] = (uint8_t)fuzz_next();
+        }
+        command.data = values;
+        int length = lab::encode_command(command, packet + size, capacity - size);
+        if (length < 0) {
+            break;
+        }
+        size += (size_t)length;
+    }
+    return size;
+}
+
+/** Flip, insert, drop or cut some bytes. */
+size_t mutate(uint8_t *packet, size_t size, size_t capacity)
+{
+    unsigned mutations = 1 + fuzz_next() % 4;
+    for (unsigned i = 0; i < mutations; i++) {
+        size_t at = size ? fuzz_next() % size : 0;
+        switch (fuzz_next() % 4) {
+            case 0:
+                if (size) {
+                    packet[at] ^= (uint8_t)(1 << fuzz_next() % 8);
+                }
+                break;
+            case 1:
+                if (size < capacity) {
+                    memmove(packet + at + 1, packet + at, size - at);
+                    packet[at] = (uint8_t)fuzz_next();
+                    size++;
+                }
+                break;
+            case 2:
+                if (size) {
+                    memmove(packet + at, packet + at + 1, size - at - 1);
+                    size--;
+                }
+                break;
+            default:
+                size = at;
+                break;
+        }
+    }
+    return size;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned long iterations = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+    fuzz_state = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 0) : 0x2545F491u;
+    if (!fuzz_state) {
+        fuzz_state = 1;
+    }
+
+    // a write at the 247 byte ATT MTU of the button example
+    uint8_t packet[244];
+    unsigned long malformed = 0;
+    for (unsigned long i = 0; i < iterations; i++) {
+        size_t size;
+        switch (i % 3) {
+            case 0:
+                size = fuzz_next() % sizeof(packet);
+                for (size_t k = 0; k < size; k++) {
+                    packet[k] = (uint8_t)fuzz_next();
+                }
+                break;
+            case 1:
+                size = good_packet(packet, sizeof(packet));
+                break;
+            default:
+                size = mutate(packet, good_packet(packet, sizeof(packet)), sizeof(packet));
+                break;
+        }
+        lab::CommandStatus status = {};
+        RecordingTarget target;
+        lab::apply_commands(packet, size, target, status);
+        malformed += status.result == lab::COMMAND_RESULT_MALFORMED;
+        if (i % 3 == 1 && status.result == lab::COMMAND_RESULT_MALFORMED) {
+            fail("good packet malformed", packet, size);
+        }
+        LLVMFuzzerTestOneInput(packet, size);
+    }
+    printf("command-fuzz: %lu packets, %lu malformed, no rule broken\n", iterations, malformed);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_H
+#define MBED_HOST_STM32L475E_IOT01_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * I2C2 sensor bus helpers of the B-L475E-IOT01 BSP. On the host the
+ * LSM6DSL address reaches a lab::SimulatedLsm6dsl running on the host
+ * clock; other addresses read as zeros.
+ */
+
+void SENSOR_IO_Init(void);
+void SENSOR_IO_Write(uint8_t Addr, uint8_t Reg, uint8_t Value);
+uint8_t SENSOR_IO_Read(uint8_t Addr, uint8_t Reg);
+uint16_t SENSOR_IO_ReadMultiple(uint8_t Addr, uint8_t Reg, uint8_t *Buffer, uint16_t Length);
+void SENSOR_IO_WriteMultiple(uint8_t Addr, uint8_t Reg, uint8_t *Buffer, uint16_t Length);
+void SENSOR_IO_Delay(uint32_t Delay);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_H
@@ -0,0 +1,29 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_ACCELERO_H
+#define MBED_HOST_STM32L475E_IOT01_ACCELERO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    ACCELERO_OK = 0,
+    ACCELERO_ERROR = 1,
+    ACCELERO_TIMEOUT = 2
+} ACCELERO_StatusTypeDef;
+
+ACCELERO_StatusTypeDef BSP_ACCELERO_Init(void);
+void BSP_ACCELERO_DeInit(void);
+void BSP_ACCELERO_LowPower(uint16_t status);
+
+/** LSM6DSL acceleration in mg: gravity on Z plus a 50 Hz vibration of 20 mg. */
+void BSP_ACCELERO_AccGetXYZ(int16_t *pDataXYZ);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_ACCELERO_H
@@ -0,0 +1,29 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_GYRO_H
+#define MBED_HOST_STM32L475E_IOT01_GYRO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    GYRO_OK = 0,
+    GYRO_ERROR = 1,
+    GYRO_TIMEOUT = 2
+} GYRO_StatusTypeDef;
+
+uint8_t BSP_GYRO_Init(void);
+void BSP_GYRO_DeInit(void);
+void BSP_GYRO_LowPower(uint16_t status);
+
+/** LSM6DSL rate in mdps, the same slow turn as the magnetometer. */
+void BSP_GYRO_GetXYZ(float *pfData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_GYRO_H
@@ -0,0 +1,26 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_HSENSOR_H
+#define MBED_HOST_STM32L475E_IOT01_HSENSOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    HSENSOR_OK = 0,
+    HSENSOR_ERROR
+} HSENSOR_Status_TypDef;
+
+uint32_t BSP_HSENSOR_Init(void);
+
+/** HTS221 relative humidity in %: 45 with a slow swing of 2. */
+float BSP_HSENSOR_ReadHumidity(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_HSENSOR_H
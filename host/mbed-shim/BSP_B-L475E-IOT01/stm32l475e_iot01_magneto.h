@@ -0,0 +1,29 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_MAGNETO_H
+#define MBED_HOST_STM32L475E_IOT01_MAGNETO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    MAGNETO_OK = 0,
+    MAGNETO_ERROR = 1,
+    MAGNETO_TIMEOUT = 2
+} MAGNETO_StatusTypeDef;
+
+MAGNETO_StatusTypeDef BSP_MAGNETO_Init(void);
+void BSP_MAGNETO_DeInit(void);
+void BSP_MAGNETO_LowPower(uint16_t status);
+
+/** LIS3MDL field in mGauss, a board turning slowly in the earth field. */
+void BSP_MAGNETO_GetXYZ(int16_t *pDataXYZ);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_MAGNETO_H
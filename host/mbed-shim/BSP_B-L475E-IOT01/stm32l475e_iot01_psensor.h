@@ -0,0 +1,26 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_PSENSOR_H
+#define MBED_HOST_STM32L475E_IOT01_PSENSOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    PSENSOR_OK = 0,
+    PSENSOR_ERROR
+} PSENSOR_Status_TypDef;
+
+uint32_t BSP_PSENSOR_Init(void);
+
+/** LPS22HB pressure in mBar: 1013 with a slow swing of 1. */
+float BSP_PSENSOR_ReadPressure(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_PSENSOR_H
@@ -0,0 +1,26 @@
+#ifndef MBED_HOST_STM32L475E_IOT01_TSENSOR_H
+#define MBED_HOST_STM32L475E_IOT01_TSENSOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32l475e_iot01.h"
+
+typedef enum {
+    TSENSOR_OK = 0,
+    TSENSOR_ERROR
+} TSENSOR_Status_TypDef;
+
+uint32_t BSP_TSENSOR_Init(void);
+
+/** HTS221 temperature in degC: 23.5 with a slow swing of 0.5. */
+float BSP_TSENSOR_ReadTemp(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_STM32L475E_IOT01_TSENSOR_H
@@ -0,0 +1,139 @@
+#ifndef MBED_HOST_BLE_PROCESS_H
+#define MBED_HOST_BLE_PROCESS_H
+
+#include <cstdio>
+
+#include "ble/BLE.h"
+#include "events/EventQueue.h"
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+#include "pretty_printer.h"
+
+/**
+ * BLEProcess of mbed-os-ble-utils: starts the stack, runs its events
+ * from the queue, advertises, and advertises again after a disconnection.
+ * start() dispatches the queue forever.
+ */
+class BLEProcess : private mbed::NonCopyable<BLEProcess>, public ble::Gap::EventHandler {
+public:
+    BLEProcess(events::EventQueue &event_queue, BLE &ble_interface) :
+        _event_queue(event_queue),
+        _ble(ble_interface)
+    {
+    }
+
+    ~BLEProcess()
+    {
+        stop();
+    }
+
+    void start()
+    {
+        printf("Ble process started.\r\n");
+
+        if (_ble.hasInitialized()) {
+            printf("Error: the ble instance has already been initialized.\r\n");
+            return;
+        }
+
+        _ble.gap().setEventHandler(this);
+        _ble.onEventsToProcess(makeFunctionPointer(this, &BLEProcess::schedule_ble_events));
+
+        ble_error_t error = _ble.init(this, &BLEProcess::on_init_complete);
+        if (error) {
+            print_error(error, "Error returned by BLE::init.\r\n");
+            return;
+        }
+
+        _event_queue.dispatch_forever();
+    }
+
+    void stop()
+    {
+        if (_ble.hasInitialized()) {
+            _ble.shutdown();
+            printf("Ble process stopped.\r\n");
+        }
+    }
+
+    /** Called once the stack is up, before advertising starts. */
+    void on_init(mbed::Callback<void(BLE &, events::EventQueue &)> cb)
+    {
+        _post_init_cb = cb;
+    }
+
+protected:
+    template <typename T, typename U>
+    static mbed::Callback<void(U *)> makeFunctionPointer(T *object, void (T::*member)(U *))
+    {
+        return mbed::Callback<void(U *)>(object, member);
+    }
+
+    void on_init_complete(BLE::InitializationCompleteCallbackContext *event)
+    {
+        if (event->error) {
+            print_error(event->error, "Error during the initialisation\r\n");
+            return;
+        }
+
+        printf("Ble instance initialized\r\n");
+
+        if (_post_init_cb) {
+            _post_init_cb(_ble, _event_queue);
+        }
+
+        start_activity();
+    }
+
+    virtual void start_activity()
+    {
+        _event_queue.call([this]() {
+            start_advertising();
+        });
+    }
+
+    virtual const char *get_device_name()
+    {
+        static const char name[] = "BleProcess";
+        return name;
+    }
+
+    /** Connectable legacy advertising; the simulated centrals ignore its content. */
+    virtual void start_advertising()
+    {
+        ble_error_t error = _ble.gap().startAdvertising(ble::LEGACY_ADVERTISING_HANDLE);
+        if (error) {
+            print_error(error, "Gap::startAdvertising() failed");
+            return;
+        }
+
+        printf("Advertising as \"%s\"\r\n", get_device_name());
+    }
+
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override
+    {
+        if (event.getStatus() == BLE_ERROR_NONE) {
+            printf("Client connected, you may now subscribe to updates\r\n");
+        } else {
+            printf("Failed to connect\r\n");
+            start_activity();
+        }
+    }
+
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &) override
+    {
+        printf("Client disconnected, restarting advertising\r\n");
+        start_activity();
+    }
+
+    void schedule_ble_events(BLE::OnEventsToProcessCallbackContext *event)
+    {
+        _event_queue.call(mbed::Callback<void()>(&event->ble, &BLE::processEvents));
+    }
+
+    events::EventQueue &_event_queue;
+    BLE &_ble;
+    mbed::Callback<void(BLE &, events::EventQueue &)> _post_init_cb;
+};
+
+#endif // MBED_HOST_BLE_PROCESS_H
@@ -0,0 +1,21 @@
+#ifndef MBED_HOST_GATT_SERVER_PROCESS_H
+#define MBED_HOST_GATT_SERVER_PROCESS_H
+
+#include "ble_process.h"
+
+/** GattServerProcess of mbed-os-ble-utils: a BLEProcess named "GattServer". */
+class GattServerProcess : public BLEProcess {
+public:
+    GattServerProcess(events::EventQueue &event_queue, BLE &ble_interface) :
+        BLEProcess(event_queue, ble_interface)
+    {
+    }
+
+    const char *get_device_name() override
+    {
+        static const char name[] = "GattServer";
+        return name;
+    }
+};
+
+#endif // MBED_HOST_GATT_SERVER_PROCESS_H
@@ -0,0 +1,21 @@
+#ifndef MBED_HOST_PRETTY_PRINTER_H
+#define MBED_HOST_PRETTY_PRINTER_H
+
+#include <cstdio>
+
+#include "ble/BLE.h"
+
+/* The printing helpers of mbed-os-ble-utils the examples use. */
+
+inline void print_error(ble_error_t error, const char *msg)
+{
+    printf("%s: error %u\r\n", msg, (unsigned)error);
+}
+
+/** Most significant byte first, as people read addresses. */
+inline void print_address(const ble::address_t &addr)
+{
+    printf("%02x:%02x:%02x:%02x:%02x:%02x\r\n", addr[5], addr[4], addr[3], addr[2], addr[1], addr[0]);
+}
+
+#endif // MBED_HOST_PRETTY_PRINTER_H
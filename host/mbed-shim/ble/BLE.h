@@ -0,0 +1,103 @@
+#ifndef MBED_HOST_BLE_H
+#define MBED_HOST_BLE_H
+
+#include <cstdint>
+
+#include "ble/Gap.h"
+#include "ble/GattClient.h"
+#include "ble/GattServer.h"
+#include "ble/common/BLETypes.h"
+#include "platform/Callback.h"
+
+#ifndef MBED_CONF_CORDIO_DESIRED_ATT_MTU
+#define MBED_CONF_CORDIO_DESIRED_ATT_MTU 23
+#endif
+
+#ifndef MBED_CONF_CORDIO_RX_ACL_BUFFER_SIZE
+#define MBED_CONF_CORDIO_RX_ACL_BUFFER_SIZE 70
+#endif
+
+namespace ble {
+
+/**
+ * The BLE stack of the host build: a simulated controller that plays
+ * the centrals of MBED_HOST_BLE, see mbed-shim/README in host/. As with
+ * Cordio, the stack signals onEventsToProcess() and the application
+ * calls processEvents() from its thread, where the event handlers run.
+ */
+class BLE {
+public:
+    typedef unsigned InstanceID_t;
+    static const InstanceID_t DEFAULT_INSTANCE = 0;
+
+    struct InitializationCompleteCallbackContext {
+        BLE &ble;
+        ble_error_t error;
+    };
+
+    struct OnEventsToProcessCallbackContext {
+        BLE &ble;
+    };
+
+    typedef mbed::Callback<void(InitializationCompleteCallbackContext *)> InitializationCompleteCallback_t;
+    typedef mbed::Callback<void(OnEventsToProcessCallbackContext *)> OnEventsToProcessCallback_t;
+
+    static BLE &Instance(InstanceID_t id = DEFAULT_INSTANCE);
+
+    /**
+     * Start the stack; the callback runs from processEvents(). The ATT
+     * MTU and the ACL buffer size are the cordio settings of the
+     * application, as on the board.
+     */
+    ble_error_t init(InitializationCompleteCallback_t completion_cb = nullptr)
+    {
+        return start(completion_cb, MBED_CONF_CORDIO_DESIRED_ATT_MTU, MBED_CONF_CORDIO_RX_ACL_BUFFER_SIZE);
+    }
+
+    template <typename T>
+    ble_error_t init(T *object, void (T::*completion_cb)(InitializationCompleteCallbackContext *context))
+    {
+        return init(InitializationCompleteCallback_t(object, completion_cb));
+    }
+
+    bool hasInitialized() const;
+
+    ble_error_t shutdown();
+
+    Gap &gap()
+    {
+        return _gap;
+    }
+
+    GattServer &gattServer()
+    {
+        return _gatt_server;
+    }
+
+    GattClient &gattClient()
+    {
+        return _gatt_client;
+    }
+
+    void onEventsToProcess(const OnEventsToProcessCallback_t &on_event_processing_callback);
+
+    /** Deliver the events of the stack to the handlers, in the calling thread. */
+    void processEvents();
+
+private:
+    BLE()
+    {
+    }
+
+    ble_error_t start(InitializationCompleteCallback_t completion_cb, uint16_t att_mtu, uint16_t acl_buffer_size);
+
+    Gap _gap;
+    GattServer _gatt_server;
+    GattClient _gatt_client;
+};
+
+} // namespace ble
+
+using ble::BLE;
+
+#endif // MBED_HOST_BLE_H
@@ -0,0 +1,420 @@
+#ifndef MBED_HOST_BLE_GAP_H
+#define MBED_HOST_BLE_GAP_H
+
+#include "ble/common/BLETypes.h"
+#include "platform/Span.h"
+
+#ifndef BLE_FEATURE_EXTENDED_ADVERTISING
+#define BLE_FEATURE_EXTENDED_ADVERTISING 1
+#endif
+
+namespace ble {
+
+/**
+ * Parameters of an advertising set. Of the Mbed OS ones the simulated
+ * controller uses the type, the primary interval and the legacy PDU
+ * flag; connectable advertising is legacy only.
+ */
+class AdvertisingParameters {
+public:
+    static const uint32_t DEFAULT_ADVERTISING_INTERVAL_MIN = 0x400;
+    static const uint32_t DEFAULT_ADVERTISING_INTERVAL_MAX = 0x800;
+
+    AdvertisingParameters(advertising_type_t advType = advertising_type_t::CONNECTABLE_UNDIRECTED,
+                          adv_interval_t minInterval = adv_interval_t(DEFAULT_ADVERTISING_INTERVAL_MIN),
+                          adv_interval_t maxInterval = adv_interval_t(DEFAULT_ADVERTISING_INTERVAL_MAX),
+                          bool useLegacyPDU = true) :
+        _type(advType),
+        _min_interval(minInterval),
+        _max_interval(maxInterval),
+        _legacy_pdu(useLegacyPDU)
+    {
+    }
+
+    AdvertisingParameters &setType(advertising_type_t newAdvType)
+    {
+        _type = newAdvType;
+        return *this;
+    }
+
+    AdvertisingParameters &setPrimaryInterval(adv_interval_t min, adv_interval_t max)
+    {
+        _min_interval = min;
+        _max_interval = max;
+        return *this;
+    }
+
+    AdvertisingParameters &setUseLegacyPDU(bool enable = true)
+    {
+        _legacy_pdu = enable;
+        return *this;
+    }
+
+    advertising_type_t getType() const
+    {
+        return _type;
+    }
+
+    adv_interval_t getMinPrimaryInterval() const
+    {
+        return _min_interval;
+    }
+
+    adv_interval_t getMaxPrimaryInterval() const
+    {
+        return _max_interval;
+    }
+
+    bool getUseLegacyPDU() const
+    {
+        return _legacy_pdu;
+    }
+
+private:
+    advertising_type_t _type;
+    adv_interval_t _min_interval;
+    adv_interval_t _max_interval;
+    bool _legacy_pdu;
+};
+
+class ConnectionCompleteEvent {
+public:
+    ConnectionCompleteEvent(ble_error_t status, connection_handle_t connectionHandle, connection_role_t ownRole,
+                            peer_address_type_t peerAddressType, const address_t &peerAddress,
+                            conn_interval_t connectionInterval, slave_latency_t connectionLatency,
+                            supervision_timeout_t supervisionTimeout) :
+        _status(status),
+        _handle(connectionHandle),
+        _role(ownRole),
+        _peer_address_type(peerAddressType),
+        _peer_address(peerAddress),
+        _interval(connectionInterval),
+        _latency(connectionLatency),
+        _timeout(supervisionTimeout)
+    {
+    }
+
+    ble_error_t getStatus() const
+    {
+        return _status;
+    }
+
+    connection_handle_t getConnectionHandle() const
+    {
+        return _handle;
+    }
+
+    connection_role_t getOwnRole() const
+    {
+        return _role;
+    }
+
+    peer_address_type_t getPeerAddressType() const
+    {
+        return _peer_address_type;
+    }
+
+    const address_t &getPeerAddress() const
+    {
+        return _peer_address;
+    }
+
+    conn_interval_t getConnectionInterval() const
+    {
+        return _interval;
+    }
+
+    slave_latency_t getConnectionLatency() const
+    {
+        return _latency;
+    }
+
+    supervision_timeout_t getSupervisionTimeout() const
+    {
+        return _timeout;
+    }
+
+private:
+    ble_error_t _status;
+    connection_handle_t _handle;
+    connection_role_t _role;
+    peer_address_type_t _peer_address_type;
+    address_t _peer_address;
+    conn_interval_t _interval;
+    slave_latency_t _latency;
+    supervision_timeout_t _timeout;
+};
+
+class DisconnectionCompleteEvent {
+public:
+    DisconnectionCompleteEvent(connection_handle_t connectionHandle, const disconnection_reason_t &reason) :
+        _handle(connectionHandle),
+        _reason(reason)
+    {
+    }
+
+    connection_handle_t getConnectionHandle() const
+    {
+        return _handle;
+    }
+
+    const disconnection_reason_t &getReason() const
+    {
+        return _reason;
+    }
+
+private:
+    connection_handle_t _handle;
+    disconnection_reason_t _reason;
+};
+
+class ConnectionParametersUpdateCompleteEvent {
+public:
+    ConnectionParametersUpdateCompleteEvent(ble_error_t status, connection_handle_t connectionHandle,
+                                            conn_interval_t connectionInterval, slave_latency_t slaveLatency,
+                                            supervision_timeout_t supervisionTimeout) :
+        _status(status),
+        _handle(connectionHandle),
+        _interval(connectionInterval),
+        _latency(slaveLatency),
+        _timeout(supervisionTimeout)
+    {
+    }
+
+    ble_error_t getStatus() const
+    {
+        return _status;
+    }
+
+    connection_handle_t getConnectionHandle() const
+    {
+        return _handle;
+    }
+
+    conn_interval_t getConnectionInterval() const
+    {
+        return _interval;
+    }
+
+    slave_latency_t getSlaveLatency() const
+    {
+        return _latency;
+    }
+
+    supervision_timeout_t getSupervisionTimeout() const
+    {
+        return _timeout;
+    }
+
+private:
+    ble_error_t _status;
+    connection_handle_t _handle;
+    conn_interval_t _interval;
+    slave_latency_t _latency;
+    supervision_timeout_t _timeout;
+};
+
+class UpdateConnectionParametersRequestEvent {
+public:
+    UpdateConnectionParametersRequestEvent(connection_handle_t connectionHandle, conn_interval_t minConnectionInterval,
+                                           conn_interval_t maxConnectionInterval, slave_latency_t slaveLatency,
+                                           supervision_timeout_t supervisionTimeout) :
+        _handle(connectionHandle),
+        _min_interval(minConnectionInterval),
+        _max_interval(maxConnectionInterval),
+        _latency(slaveLatency),
+        _timeout(supervisionTimeout)
+    {
+    }
+
+    connection_handle_t getConnectionHandle() const
+    {
+        return _handle;
+    }
+
+    conn_interval_t getMinConnectionInterval() const
+    {
+        return _min_interval;
+    }
+
+    conn_interval_t getMaxConnectionInterval() const
+    {
+        return _max_interval;
+    }
+
+    slave_latency_t getSlaveLatency() const
+    {
+        return _latency;
+    }
+
+    supervision_timeout_t getSupervisionTimeout() const
+    {
+        return _timeout;
+    }
+
+private:
+    connection_handle_t _handle;
+    conn_interval_t _min_interval;
+    conn_interval_t _max_interval;
+    slave_latency_t _latency;
+    supervision_timeout_t _timeout;
+};
+
+class AdvertisingStartEvent {
+public:
+    explicit AdvertisingStartEvent(advertising_handle_t advHandle) :
+        _handle(advHandle)
+    {
+    }
+
+    advertising_handle_t getAdvHandle() const
+    {
+        return _handle;
+    }
+
+private:
+    advertising_handle_t _handle;
+};
+
+class AdvertisingEndEvent {
+public:
+    AdvertisingEndEvent(advertising_handle_t advHandle, connection_handle_t connection, uint8_t completed_events,
+                        bool connected) :
+        _handle(advHandle),
+        _connection(connection),
+        _completed_events(completed_events),
+        _connected(connected)
+    {
+    }
+
+    advertising_handle_t getAdvHandle() const
+    {
+        return _handle;
+    }
+
+    connection_handle_t getConnection() const
+    {
+        return _connection;
+    }
+
+    uint8_t getCompleted_events() const
+    {
+        return _completed_events;
+    }
+
+    bool isConnected() const
+    {
+        return _connected;
+    }
+
+private:
+    advertising_handle_t _handle;
+    connection_handle_t _connection;
+    uint8_t _completed_events;
+    bool _connected;
+};
+
+/**
+ * Generic access profile of the simulated controller: advertising and
+ * the link layer procedures of a peripheral's connections. Results come
+ * back through the EventHandler, from BLE::processEvents().
+ */
+class Gap {
+public:
+    class EventHandler {
+    public:
+        virtual void onAdvertisingStart(const AdvertisingStartEvent &event)
+        {
+            (void)event;
+        }
+
+        virtual void onAdvertisingEnd(const AdvertisingEndEvent &event)
+        {
+            (void)event;
+        }
+
+        virtual void onConnectionComplete(const ConnectionCompleteEvent &event)
+        {
+            (void)event;
+        }
+
+        virtual void onUpdateConnectionParametersRequest(const UpdateConnectionParametersRequestEvent &event)
+        {
+            (void)event;
+        }
+
+        virtual void onConnectionParametersUpdateComplete(const ConnectionParametersUpdateCompleteEvent &event)
+        {
+            (void)event;
+        }
+
+        virtual void onReadPhy(ble_error_t status, connection_handle_t connectionHandle, phy_t txPhy, phy_t rxPhy)
+        {
+            (void)status;
+            (void)connectionHandle;
+            (void)txPhy;
+            (void)rxPhy;
+        }
+
+        virtual void onPhyUpdateComplete(ble_error_t status, connection_handle_t connectionHandle, phy_t txPhy,
+                                         phy_t rxPhy)
+        {
+            (void)status;
+            (void)connectionHandle;
+            (void)txPhy;
+            (void)rxPhy;
+        }
+
+        virtual void onDataLengthChange(connection_handle_t connectionHandle, uint16_t txSize, uint16_t rxSize)
+        {
+            (void)connectionHandle;
+            (void)txSize;
+            (void)rxSize;
+        }
+
+        virtual void onDisconnectionComplete(const DisconnectionCompleteEvent &event)
+        {
+            (void)event;
+        }
+
+    protected:
+        ~EventHandler() = default;
+    };
+
+    void setEventHandler(EventHandler *handler);
+
+    bool isFeatureSupported(controller_supported_features_t feature);
+
+    /** Advertising sets, the legacy one included. */
+    uint8_t getMaxAdvertisingSetNumber();
+    /** 1650 with extended advertising, 31 without. */
+    uint16_t getMaxAdvertisingDataLength();
+
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    ble_error_t createAdvertisingSet(advertising_handle_t *handle, const AdvertisingParameters &parameters);
+    ble_error_t destroyAdvertisingSet(advertising_handle_t handle);
+#endif
+    ble_error_t setAdvertisingParameters(advertising_handle_t handle, const AdvertisingParameters &params);
+    ble_error_t setAdvertisingPayload(advertising_handle_t handle, mbed::Span<const uint8_t> payload);
+
+    ble_error_t startAdvertising(advertising_handle_t handle);
+    ble_error_t stopAdvertising(advertising_handle_t handle);
+    bool isAdvertisingActive(advertising_handle_t handle);
+
+    ble_error_t updateConnectionParameters(connection_handle_t connectionHandle, conn_interval_t minConnectionInterval,
+                                           conn_interval_t maxConnectionInterval, slave_latency_t slaveLatency,
+                                           supervision_timeout_t supervisionTimeout,
+                                           conn_event_length_t minConnectionEventLength = conn_event_length_t(0),
+                                           conn_event_length_t maxConnectionEventLength = conn_event_length_t(0));
+
+    ble_error_t readPhy(connection_handle_t connection);
+    ble_error_t setPreferredPhys(const phy_set_t *txPhys, const phy_set_t *rxPhys);
+    ble_error_t setPhy(connection_handle_t connection, const phy_set_t *txPhys, const phy_set_t *rxPhys,
+                       coded_symbol_per_bit_t codedSymbol);
+
+    ble_error_t disconnect(connection_handle_t connectionHandle, disconnection_reason_t reason);
+};
+
+} // namespace ble
+
+#endif // MBED_HOST_BLE_GAP_H
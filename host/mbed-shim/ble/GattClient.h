@@ -0,0 +1,33 @@
+#ifndef MBED_HOST_BLE_GATT_CLIENT_H
+#define MBED_HOST_BLE_GATT_CLIENT_H
+
+#include "ble/common/BLETypes.h"
+
+namespace ble {
+
+/** The client side, as far as a peripheral uses it: the ATT MTU exchange. */
+class GattClient {
+public:
+    class EventHandler {
+    public:
+        virtual void onAttMtuChange(connection_handle_t connectionHandle, uint16_t attMtuSize)
+        {
+            (void)connectionHandle;
+            (void)attMtuSize;
+        }
+
+    protected:
+        ~EventHandler() = default;
+    };
+
+    void setEventHandler(EventHandler *handler);
+
+    /** Exchange MTUs with the peer; onAttMtuChange() reports the result. */
+    ble_error_t negotiateAttMtu(connection_handle_t connection);
+};
+
+} // namespace ble
+
+using ble::GattClient;
+
+#endif // MBED_HOST_BLE_GATT_CLIENT_H
@@ -0,0 +1,96 @@
+#ifndef MBED_HOST_BLE_GATT_SERVER_H
+#define MBED_HOST_BLE_GATT_SERVER_H
+
+#include "GattCallbackParamTypes.h"
+#include "GattCharacteristic.h"
+#include "GattService.h"
+#include "ble/common/BLETypes.h"
+
+namespace ble {
+
+/**
+ * Attribute table of the device. Handles are given out by addService()
+ * as Cordio does: the service declaration, then per characteristic its
+ * declaration, value, client configuration (with notify or indicate)
+ * and descriptors. Writes notify every connection subscribed to the
+ * characteristic, queued on each link.
+ */
+class GattServer {
+public:
+    class EventHandler {
+    public:
+        virtual void onAttMtuChange(connection_handle_t connectionHandle, uint16_t attMtuSize)
+        {
+            (void)connectionHandle;
+            (void)attMtuSize;
+        }
+
+        virtual void onDataSent(const GattDataSentCallbackParams &params)
+        {
+            (void)params;
+        }
+
+        virtual void onDataWritten(const GattWriteCallbackParams &params)
+        {
+            (void)params;
+        }
+
+        virtual void onDataRead(const GattReadCallbackParams &params)
+        {
+            (void)params;
+        }
+
+        virtual void onShutdown(const GattServer &server)
+        {
+            (void)server;
+        }
+
+        virtual void onUpdatesEnabled(const GattUpdatesEnabledCallbackParams &params)
+        {
+            (void)params;
+        }
+
+        virtual void onUpdatesDisabled(const GattUpdatesDisabledCallbackParams &params)
+        {
+            (void)params;
+        }
+
+        virtual void onConfirmationReceived(const GattConfirmationReceivedCallbackParams &params)
+        {
+            (void)params;
+        }
+
+    protected:
+        ~EventHandler() = default;
+    };
+
+    void setEventHandler(EventHandler *handler);
+
+    ble_error_t addService(GattService &service);
+
+    ble_error_t read(GattAttribute::Handle_t attributeHandle, uint8_t buffer[], uint16_t *lengthP);
+    ble_error_t read(connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle, uint8_t buffer[],
+                     uint16_t *lengthP);
+
+    /**
+     * Set a value and, unless localOnly, notify or indicate it to every
+     * subscribed connection. BLE_ERROR_NO_MEM if a link had no room left
+     * for it; the others got it.
+     */
+    ble_error_t write(GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size,
+                      bool localOnly = false);
+
+    /** The same, for one connection only. */
+    ble_error_t write(connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle,
+                      const uint8_t *value, uint16_t size, bool localOnly = false);
+
+    ble_error_t areUpdatesEnabled(const GattCharacteristic &characteristic, bool *enabledP);
+    ble_error_t areUpdatesEnabled(connection_handle_t connectionHandle, const GattCharacteristic &characteristic,
+                                  bool *enabledP);
+};
+
+} // namespace ble
+
+using ble::GattServer;
+
+#endif // MBED_HOST_BLE_GATT_SERVER_H
@@ -0,0 +1,363 @@
+#ifndef MBED_HOST_BLE_TYPES_H
+#define MBED_HOST_BLE_TYPES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Types of the Mbed OS 6 BLE API the lab applications use, with the same
+ * names and units: durations count in the unit of the Bluetooth spec
+ * (1.25 ms for a connection interval, 10 ms for a supervision timeout).
+ */
+
+enum ble_error_t {
+    BLE_ERROR_NONE = 0,
+    BLE_ERROR_BUFFER_OVERFLOW = 1,
+    BLE_ERROR_NOT_IMPLEMENTED = 2,
+    BLE_ERROR_PARAM_OUT_OF_RANGE = 3,
+    BLE_ERROR_INVALID_PARAM = 4,
+    BLE_STACK_BUSY = 5,
+    BLE_ERROR_INVALID_STATE = 6,
+    BLE_ERROR_NO_MEM = 7,
+    BLE_ERROR_OPERATION_NOT_PERMITTED = 8,
+    BLE_ERROR_INITIALIZATION_INCOMPLETE = 9,
+    BLE_ERROR_ALREADY_INITIALIZED = 10,
+    BLE_ERROR_UNSPECIFIED = 11,
+    BLE_ERROR_INTERNAL_STACK_FAILURE = 12,
+    BLE_ERROR_NOT_FOUND = 13,
+};
+
+namespace ble {
+
+typedef uintptr_t connection_handle_t;
+typedef uint16_t attribute_handle_t;
+typedef uint8_t advertising_handle_t;
+typedef uint16_t slave_latency_t;
+
+static const advertising_handle_t LEGACY_ADVERTISING_HANDLE = 0;
+
+/** A duration of Rep units of TB microseconds. */
+template <typename Rep, uint32_t TB>
+class Duration {
+public:
+    Duration() :
+        _value(0)
+    {
+    }
+
+    explicit Duration(Rep value) :
+        _value(value)
+    {
+    }
+
+    Rep value() const
+    {
+        return _value;
+    }
+
+    uint32_t valueInUs() const
+    {
+        return (uint32_t)_value * TB;
+    }
+
+    uint32_t valueInMs() const
+    {
+        return valueInUs() / 1000;
+    }
+
+private:
+    Rep _value;
+};
+
+typedef Duration<uint16_t, 1250> conn_interval_t;
+typedef Duration<uint16_t, 10000> supervision_timeout_t;
+typedef Duration<uint16_t, 625> conn_event_length_t;
+typedef Duration<uint32_t, 625> adv_interval_t;
+
+/** Physical layer of a connection. */
+class phy_t {
+public:
+    enum type {
+        NONE = 0,
+        LE_1M = 1,
+        LE_2M = 2,
+        LE_CODED = 3,
+    };
+
+    phy_t(type value = NONE) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+    bool operator==(const phy_t &other) const
+    {
+        return _value == other._value;
+    }
+
+    bool operator!=(const phy_t &other) const
+    {
+        return _value != other._value;
+    }
+
+private:
+    type _value;
+};
+
+/** A set of PHYs, as a bit per PHY. */
+class phy_set_t {
+public:
+    static const uint8_t PHY_SET_1M = 0x01;
+    static const uint8_t PHY_SET_2M = 0x02;
+    static const uint8_t PHY_SET_CODED = 0x04;
+
+    phy_set_t() :
+        _value(0)
+    {
+    }
+
+    phy_set_t(bool phy_1m, bool phy_2m, bool phy_coded) :
+        _value((phy_1m ? PHY_SET_1M : 0) | (phy_2m ? PHY_SET_2M : 0) | (phy_coded ? PHY_SET_CODED : 0))
+    {
+    }
+
+    phy_set_t(phy_t phy) :
+        _value(phy.value() == phy_t::LE_1M ? PHY_SET_1M :
+               phy.value() == phy_t::LE_2M ? PHY_SET_2M :
+               phy.value() == phy_t::LE_CODED ? PHY_SET_CODED : 0)
+    {
+    }
+
+    void set_1m(bool enabled = true)
+    {
+        set(PHY_SET_1M, enabled);
+    }
+
+    void set_2m(bool enabled = true)
+    {
+        set(PHY_SET_2M, enabled);
+    }
+
+    void set_coded(bool enabled = true)
+    {
+        set(PHY_SET_CODED, enabled);
+    }
+
+    bool get_1m() const
+    {
+        return _value & PHY_SET_1M;
+    }
+
+    bool get_2m() const
+    {
+        return _value & PHY_SET_2M;
+    }
+
+    bool get_coded() const
+    {
+        return _value & PHY_SET_CODED;
+    }
+
+    uint8_t value() const
+    {
+        return _value;
+    }
+
+private:
+    void set(uint8_t bit, bool enabled)
+    {
+        _value = enabled ? (_value | bit) : (_value & ~bit);
+    }
+
+    uint8_t _value;
+};
+
+class coded_symbol_per_bit_t {
+public:
+    enum type {
+        UNDEFINED,
+        S2,
+        S8,
+    };
+
+    coded_symbol_per_bit_t(type value = UNDEFINED) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+/** Features a controller may support, see Gap::isFeatureSupported(). */
+class controller_supported_features_t {
+public:
+    enum type {
+        LE_ENCRYPTION = 0,
+        CONNECTION_PARAMETERS_REQUEST_PROCEDURE,
+        EXTENDED_REJECT_INDICATION,
+        SLAVE_INITIATED_FEATURES_EXCHANGE,
+        LE_PING,
+        LE_DATA_PACKET_LENGTH_EXTENSION,
+        LL_PRIVACY,
+        EXTENDED_SCANNER_FILTER_POLICIES,
+        LE_2M_PHY,
+        STABLE_MODULATION_INDEX_TRANSMITTER,
+        STABLE_MODULATION_INDEX_RECEIVER,
+        LE_CODED_PHY,
+        LE_EXTENDED_ADVERTISING,
+        LE_PERIODIC_ADVERTISING,
+        CHANNEL_SELECTION_ALGORITHM_2,
+        LE_POWER_CLASS,
+    };
+
+    controller_supported_features_t(type value) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+/** PDU type of an advertising set. */
+class advertising_type_t {
+public:
+    enum type {
+        CONNECTABLE_UNDIRECTED = 0x00,
+        CONNECTABLE_DIRECTED = 0x01,
+        SCANNABLE_UNDIRECTED = 0x02,
+        NON_CONNECTABLE_UNDIRECTED = 0x03,
+        CONNECTABLE_DIRECTED_LOW_DUTY = 0x04,
+        CONNECTABLE_NON_SCANNABLE_UNDIRECTED = 0x05,
+    };
+
+    advertising_type_t(type value = CONNECTABLE_UNDIRECTED) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+class connection_role_t {
+public:
+    enum type {
+        CENTRAL = 0,
+        PERIPHERAL = 1,
+    };
+
+    connection_role_t(type value = PERIPHERAL) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+class disconnection_reason_t {
+public:
+    enum type {
+        AUTHENTICATION_FAILURE = 0x05,
+        CONNECTION_TIMEOUT = 0x08,
+        REMOTE_USER_TERMINATED_CONNECTION = 0x13,
+        REMOTE_DEV_TERMINATION_DUE_TO_LOW_RESOURCES = 0x14,
+        REMOTE_DEV_TERMINATION_DUE_TO_POWER_OFF = 0x15,
+        LOCAL_HOST_TERMINATED_CONNECTION = 0x16,
+        UNACCEPTABLE_CONNECTION_PARAMETERS = 0x3B,
+    };
+
+    disconnection_reason_t(type value = REMOTE_USER_TERMINATED_CONNECTION) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+/** A device address, least significant byte first as on the air. */
+class address_t {
+public:
+    address_t()
+    {
+        memset(_bytes, 0, sizeof(_bytes));
+    }
+
+    explicit address_t(const uint8_t bytes[6])
+    {
+        memcpy(_bytes, bytes, sizeof(_bytes));
+    }
+
+    const uint8_t *data() const
+    {
+        return _bytes;
+    }
+
+    uint8_t operator[](size_t i) const
+    {
+        return _bytes[i];
+    }
+
+private:
+    uint8_t _bytes[6];
+};
+
+class peer_address_type_t {
+public:
+    enum type {
+        PUBLIC = 0,
+        RANDOM,
+        PUBLIC_IDENTITY,
+        RANDOM_STATIC_IDENTITY,
+    };
+
+    peer_address_type_t(type value = RANDOM) :
+        _value(value)
+    {
+    }
+
+    type value() const
+    {
+        return _value;
+    }
+
+private:
+    type _value;
+};
+
+} // namespace ble
+
+#endif // MBED_HOST_BLE_TYPES_H
@@ -0,0 +1,74 @@
+#ifndef MBED_HOST_GATT_ATTRIBUTE_H
+#define MBED_HOST_GATT_ATTRIBUTE_H
+
+#include <cstdint>
+
+#include "UUID.h"
+#include "ble/common/BLETypes.h"
+
+namespace mbed_host { class BleStack; }
+
+/**
+ * An attribute of the GATT server: its UUID, handle and value. Before
+ * GattServer::addService() the value is the application's buffer;
+ * after, the server keeps a copy and read() and write() go there.
+ */
+class GattAttribute {
+public:
+    typedef ble::attribute_handle_t Handle_t;
+
+    static const Handle_t INVALID_HANDLE = 0x0000;
+
+    GattAttribute(const UUID &uuid, uint8_t *valuePtr = nullptr, uint16_t len = 0, uint16_t maxLen = 0,
+                  bool hasVariableLen = true) :
+        _uuid(uuid),
+        _value(valuePtr),
+        _length(len),
+        _max_length(maxLen),
+        _variable_length(hasVariableLen),
+        _handle(INVALID_HANDLE)
+    {
+    }
+
+    Handle_t getHandle() const
+    {
+        return _handle;
+    }
+
+    const UUID &getUUID() const
+    {
+        return _uuid;
+    }
+
+    uint16_t getLength() const
+    {
+        return _length;
+    }
+
+    uint16_t getMaxLength() const
+    {
+        return _max_length;
+    }
+
+    uint8_t *getValuePtr()
+    {
+        return _value;
+    }
+
+    bool hasVariableLength() const
+    {
+        return _variable_length;
+    }
+
+private:
+    friend class mbed_host::BleStack;
+
+    UUID _uuid;
+    uint8_t *_value;
+    uint16_t _length;
+    uint16_t _max_length;
+    bool _variable_length;
+    Handle_t _handle;
+};
+
+#endif // MBED_HOST_GATT_ATTRIBUTE_H
@@ -0,0 +1,83 @@
+#ifndef MBED_HOST_GATT_CALLBACK_PARAM_TYPES_H
+#define MBED_HOST_GATT_CALLBACK_PARAM_TYPES_H
+
+#include <cstdint>
+
+#include "GattAttribute.h"
+
+enum GattAuthCallbackReply_t {
+    AUTH_CALLBACK_REPLY_SUCCESS = 0x00,
+    AUTH_CALLBACK_REPLY_ATTERR_INVALID_HANDLE = 0x0101,
+    AUTH_CALLBACK_REPLY_ATTERR_READ_NOT_PERMITTED = 0x0102,
+    AUTH_CALLBACK_REPLY_ATTERR_WRITE_NOT_PERMITTED = 0x0103,
+    AUTH_CALLBACK_REPLY_ATTERR_INVALID_PDU = 0x0104,
+    AUTH_CALLBACK_REPLY_ATTERR_INSUFFICIENT_AUTHENTICATION = 0x0105,
+    AUTH_CALLBACK_REPLY_ATTERR_REQUEST_NOT_SUPPORTED = 0x0106,
+    AUTH_CALLBACK_REPLY_ATTERR_INVALID_OFFSET = 0x0107,
+    AUTH_CALLBACK_REPLY_ATTERR_INSUFFICIENT_AUTHORIZATION = 0x0108,
+    AUTH_CALLBACK_REPLY_ATTERR_ATTRIBUTE_NOT_LONG = 0x010B,
+    AUTH_CALLBACK_REPLY_ATTERR_INVALID_ATT_VAL_LENGTH = 0x010D,
+    AUTH_CALLBACK_REPLY_ATTERR_UNLIKELY_ERROR = 0x010E,
+};
+
+struct GattWriteCallbackParams {
+    enum WriteOp_t {
+        OP_INVALID = 0x00,
+        OP_WRITE_REQ = 0x01,
+        OP_WRITE_CMD = 0x02,
+        OP_SIGN_WRITE_CMD = 0x03,
+        OP_PREP_WRITE_REQ = 0x04,
+        OP_EXEC_WRITE_REQ_CANCEL = 0x05,
+        OP_EXEC_WRITE_REQ_NOW = 0x06,
+    };
+
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t handle;
+    WriteOp_t writeOp;
+    uint16_t offset;
+    uint16_t len;
+    const uint8_t *data;
+};
+
+struct GattReadCallbackParams {
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t handle;
+    uint16_t offset;
+    uint16_t len;
+    const uint8_t *data;
+};
+
+struct GattWriteAuthCallbackParams {
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t handle;
+    uint16_t offset;
+    uint16_t len;
+    const uint8_t *data;
+    /** Set by the handler, AUTH_CALLBACK_REPLY_SUCCESS lets the write through. */
+    GattAuthCallbackReply_t authorizationReply;
+};
+
+struct GattReadAuthCallbackParams {
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t handle;
+    uint16_t offset;
+    uint16_t len;
+    uint8_t *data;
+    GattAuthCallbackReply_t authorizationReply;
+};
+
+struct GattDataSentCallbackParams {
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t attHandle;
+};
+
+struct GattUpdatesEnabledCallbackParams {
+    ble::connection_handle_t connHandle;
+    GattAttribute::Handle_t attHandle;
+    GattAttribute::Handle_t charHandle;
+};
+
+typedef GattUpdatesEnabledCallbackParams GattUpdatesDisabledCallbackParams;
+typedef GattDataSentCallbackParams GattConfirmationReceivedCallbackParams;
+
+#endif // MBED_HOST_GATT_CALLBACK_PARAM_TYPES_H
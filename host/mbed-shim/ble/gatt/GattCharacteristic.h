@@ -0,0 +1,126 @@
+#ifndef MBED_HOST_GATT_CHARACTERISTIC_H
+#define MBED_HOST_GATT_CHARACTERISTIC_H
+
+#include <cstdint>
+
+#include "GattAttribute.h"
+#include "GattCallbackParamTypes.h"
+#include "platform/Callback.h"
+
+/** A characteristic: its value attribute, properties and descriptors. */
+class GattCharacteristic {
+public:
+    enum Properties_t {
+        BLE_GATT_CHAR_PROPERTIES_NONE = 0x00,
+        BLE_GATT_CHAR_PROPERTIES_BROADCAST = 0x01,
+        BLE_GATT_CHAR_PROPERTIES_READ = 0x02,
+        BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE = 0x04,
+        BLE_GATT_CHAR_PROPERTIES_WRITE = 0x08,
+        BLE_GATT_CHAR_PROPERTIES_NOTIFY = 0x10,
+        BLE_GATT_CHAR_PROPERTIES_INDICATE = 0x20,
+        BLE_GATT_CHAR_PROPERTIES_AUTHENTICATED_SIGNED_WRITES = 0x40,
+        BLE_GATT_CHAR_PROPERTIES_EXTENDED_PROPERTIES = 0x80,
+    };
+
+    GattCharacteristic(const UUID &uuid, uint8_t *valuePtr = nullptr, uint16_t len = 0, uint16_t maxLen = 0,
+                       uint8_t props = BLE_GATT_CHAR_PROPERTIES_NONE, GattAttribute *descriptors[] = nullptr,
+                       unsigned numDescriptors = 0, bool hasVariableLen = true) :
+        _value_attribute(uuid, valuePtr, len, maxLen, hasVariableLen),
+        _properties(props),
+        _descriptors(descriptors),
+        _descriptor_count(numDescriptors)
+    {
+    }
+
+    virtual ~GattCharacteristic()
+    {
+    }
+
+    void setWriteAuthorizationCallback(void (*callback)(GattWriteAuthCallbackParams *))
+    {
+        _write_authorization = callback;
+    }
+
+    template <typename T>
+    void setWriteAuthorizationCallback(T *object, void (T::*member)(GattWriteAuthCallbackParams *))
+    {
+        _write_authorization = mbed::Callback<void(GattWriteAuthCallbackParams *)>(object, member);
+    }
+
+    void setReadAuthorizationCallback(void (*callback)(GattReadAuthCallbackParams *))
+    {
+        _read_authorization = callback;
+    }
+
+    template <typename T>
+    void setReadAuthorizationCallback(T *object, void (T::*member)(GattReadAuthCallbackParams *))
+    {
+        _read_authorization = mbed::Callback<void(GattReadAuthCallbackParams *)>(object, member);
+    }
+
+    /** Run the write authorization handler, if any. */
+    GattAuthCallbackReply_t authorizeWrite(GattWriteAuthCallbackParams *params)
+    {
+        if (!_write_authorization) {
+            return AUTH_CALLBACK_REPLY_SUCCESS;
+        }
+        params->authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS;
+        _write_authorization(params);
+        return params->authorizationReply;
+    }
+
+    GattAuthCallbackReply_t authorizeRead(GattReadAuthCallbackParams *params)
+    {
+        if (!_read_authorization) {
+            return AUTH_CALLBACK_REPLY_SUCCESS;
+        }
+        params->authorizationReply = AUTH_CALLBACK_REPLY_SUCCESS;
+        _read_authorization(params);
+        return params->authorizationReply;
+    }
+
+    bool isWriteAuthorizationEnabled() const
+    {
+        return static_cast<bool>(_write_authorization);
+    }
+
+    GattAttribute &getValueAttribute()
+    {
+        return _value_attribute;
+    }
+
+    const GattAttribute &getValueAttribute() const
+    {
+        return _value_attribute;
+    }
+
+    GattAttribute::Handle_t getValueHandle() const
+    {
+        return _value_attribute.getHandle();
+    }
+
+    uint8_t getProperties() const
+    {
+        return _properties;
+    }
+
+    uint8_t getDescriptorCount() const
+    {
+        return (uint8_t)_descriptor_count;
+    }
+
+    GattAttribute *getDescriptor(uint8_t index)
+    {
+        return index < _descriptor_count ? _descriptors[index] : nullptr;
+    }
+
+private:
+    GattAttribute _value_attribute;
+    uint8_t _properties;
+    GattAttribute **_descriptors;
+    unsigned _descriptor_count;
+    mbed::Callback<void(GattWriteAuthCallbackParams *)> _write_authorization;
+    mbed::Callback<void(GattReadAuthCallbackParams *)> _read_authorization;
+};
+
+#endif // MBED_HOST_GATT_CHARACTERISTIC_H
@@ -0,0 +1,51 @@
+#ifndef MBED_HOST_GATT_SERVICE_H
+#define MBED_HOST_GATT_SERVICE_H
+
+#include <cstdint>
+
+#include "GattCharacteristic.h"
+#include "UUID.h"
+
+namespace mbed_host { class BleStack; }
+
+/** A service: a UUID and the characteristics the application owns. */
+class GattService {
+public:
+    GattService(const UUID &uuid, GattCharacteristic *characteristics[], unsigned numCharacteristics) :
+        _uuid(uuid),
+        _characteristics(characteristics),
+        _count(numCharacteristics),
+        _handle(GattAttribute::INVALID_HANDLE)
+    {
+    }
+
+    const UUID &getUUID() const
+    {
+        return _uuid;
+    }
+
+    uint16_t getHandle() const
+    {
+        return _handle;
+    }
+
+    uint8_t getCharacteristicCount() const
+    {
+        return (uint8_t)_count;
+    }
+
+    GattCharacteristic *getCharacteristic(uint8_t index)
+    {
+        return index < _count ? _characteristics[index] : nullptr;
+    }
+
+private:
+    friend class mbed_host::BleStack;
+
+    UUID _uuid;
+    GattCharacteristic **_characteristics;
+    unsigned _count;
+    uint16_t _handle;
+};
+
+#endif // MBED_HOST_GATT_SERVICE_H
@@ -0,0 +1,115 @@
+#ifndef MBED_HOST_BLE_UUID_H
+#define MBED_HOST_BLE_UUID_H
+
+#include <cstdint>
+#include <cstring>
+
+/**
+ * A 16-bit or 128-bit UUID, as "A000" or
+ * "12345678-bc75-4741-8a26-264af75807de". The 128 bits are kept least
+ * significant byte first, as on the air.
+ */
+class UUID {
+public:
+    enum UUID_Type_t {
+        UUID_TYPE_SHORT = 0,
+        UUID_TYPE_LONG = 1,
+    };
+
+    typedef uint16_t ShortUUIDBytes_t;
+
+    static const unsigned LENGTH_OF_LONG_UUID = 16;
+    typedef uint8_t LongUUIDBytes_t[LENGTH_OF_LONG_UUID];
+
+    UUID(ShortUUIDBytes_t short_uuid = 0) :
+        _type(UUID_TYPE_SHORT),
+        _short(short_uuid)
+    {
+        memset(_long, 0, sizeof(_long));
+        _long[12] = (uint8_t)short_uuid;
+        _long[13] = (uint8_t)(short_uuid >> 8);
+    }
+
+    UUID(const char *text) :
+        _type(UUID_TYPE_SHORT),
+        _short(0)
+    {
+        memset(_long, 0, sizeof(_long));
+        uint8_t bytes[LENGTH_OF_LONG_UUID];
+        size_t count = 0;
+        for (const char *c = text; *c && count < 2 * LENGTH_OF_LONG_UUID; c++) {
+            int digit = hex(*c);
+            if (digit < 0) {
+                continue;
+            }
+            if (count % 2 == 0) {
+                bytes[count / 2] = (uint8_t)(digit << 4);
+            } else {
+                bytes[count / 2] |= (uint8_t)digit;
+            }
+            count++;
+        }
+        if (count == 4) {
+            _short = (uint16_t)(bytes[0] << 8 | bytes[1]);
+            _long[12] = bytes[1];
+            _long[13] = bytes[0];
+        } else if (count == 2 * LENGTH_OF_LONG_UUID) {
+            _type = UUID_TYPE_LONG;
+            for (size_t i = 0; i < LENGTH_OF_LONG_UUID; i++) {
+                _long[i] = bytes[LENGTH_OF_LONG_UUID - 1 - i];
+            }
+            _short = (uint16_t)(_long[13] << 8 | _long[12]);
+        }
+    }
+
+    UUID_Type_t shortOrLong() const
+    {
+        return _type;
+    }
+
+    ShortUUIDBytes_t getShortUUID() const
+    {
+        return _short;
+    }
+
+    const uint8_t *getBaseUUID() const
+    {
+        return _type == UUID_TYPE_SHORT ? reinterpret_cast<const uint8_t *>(&_short) : _long;
+    }
+
+    uint8_t getLen() const
+    {
+        return _type == UUID_TYPE_SHORT ? sizeof(ShortUUIDBytes_t) : LENGTH_OF_LONG_UUID;
+    }
+
+    bool operator==(const UUID &other) const
+    {
+        return _type == other._type && _short == other._short && memcmp(_long, other._long, sizeof(_long)) == 0;
+    }
+
+    bool operator!=(const UUID &other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    static int hex(char c)
+    {
+        if (c >= '0' && c <= '9') {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    UUID_Type_t _type;
+    ShortUUIDBytes_t _short;
+    LongUUIDBytes_t _long;
+};
+
+#endif // MBED_HOST_BLE_UUID_H
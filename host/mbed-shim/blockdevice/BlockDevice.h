@@ -0,0 +1,71 @@
+#ifndef MBED_HOST_BLOCKDEVICE_H
+#define MBED_HOST_BLOCKDEVICE_H
+
+#include <cstdint>
+
+typedef uint64_t bd_addr_t;
+typedef uint64_t bd_size_t;
+
+enum {
+    BD_ERROR_OK = 0,
+    BD_ERROR_DEVICE_ERROR = -4001,
+};
+
+namespace mbed {
+
+class BlockDevice {
+public:
+    /**
+     * The board's QSPI NOR flash, see HostFlashBlockDevice. Backed by the
+     * file named in MBED_HOST_FLASH, or by memory.
+     */
+    static BlockDevice *get_default_instance();
+
+    virtual ~BlockDevice() = default;
+
+    virtual int init() = 0;
+    virtual int deinit() = 0;
+
+    virtual int sync()
+    {
+        return 0;
+    }
+
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size) = 0;
+
+    virtual int erase(bd_addr_t addr, bd_size_t size)
+    {
+        (void)addr;
+        (void)size;
+        return 0;
+    }
+
+    virtual bd_size_t get_read_size() const = 0;
+    virtual bd_size_t get_program_size() const = 0;
+
+    virtual bd_size_t get_erase_size() const
+    {
+        return get_program_size();
+    }
+
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const
+    {
+        (void)addr;
+        return get_erase_size();
+    }
+
+    /** @return the value of erased bytes, -1 if undefined. */
+    virtual int get_erase_value() const
+    {
+        return -1;
+    }
+
+    virtual bd_size_t size() const = 0;
+
+    virtual const char *get_type() const = 0;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_BLOCKDEVICE_H
@@ -0,0 +1,75 @@
+#ifndef MBED_HOST_FLASH_BLOCK_DEVICE_H
+#define MBED_HOST_FLASH_BLOCK_DEVICE_H
+
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+#include "blockdevice/BlockDevice.h"
+
+namespace mbed {
+
+/**
+ * NOR flash in memory: programming only clears bits, erasing sets whole
+ * sectors back to 0xFF, as the MX25R6435F does. With a file name the
+ * content is loaded at init() and every change written through, so it
+ * survives a restart of the program like the chip survives a reset.
+ */
+class HostFlashBlockDevice : public BlockDevice {
+public:
+    HostFlashBlockDevice(bd_size_t size, bd_size_t erase_size, const char *path = nullptr);
+    ~HostFlashBlockDevice() override;
+
+    int init() override;
+    int deinit() override;
+
+    int read(void *buffer, bd_addr_t addr, bd_size_t size) override;
+    int program(const void *buffer, bd_addr_t addr, bd_size_t size) override;
+    int erase(bd_addr_t addr, bd_size_t size) override;
+
+    bd_size_t get_read_size() const override
+    {
+        return 1;
+    }
+
+    bd_size_t get_program_size() const override
+    {
+        return 1;
+    }
+
+    bd_size_t get_erase_size() const override
+    {
+        return _erase_size;
+    }
+
+    int get_erase_value() const override
+    {
+        return 0xFF;
+    }
+
+    bd_size_t size() const override
+    {
+        return _size;
+    }
+
+    const char *get_type() const override
+    {
+        return "HOSTFLASH";
+    }
+
+private:
+    bool in_range(bd_addr_t addr, bd_size_t size) const;
+    void write_through(bd_addr_t addr, bd_size_t size);
+
+    std::mutex _mutex;
+    std::vector<uint8_t> _data;
+    bd_size_t _size;
+    bd_size_t _erase_size;
+    const char *_path;
+    std::FILE *_file;
+    int _init_count;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_FLASH_BLOCK_DEVICE_H
@@ -0,0 +1,43 @@
+#ifndef MBED_HOST_ISM43362_INTERFACE_H
+#define MBED_HOST_ISM43362_INTERFACE_H
+
+#include <cstdint>
+#include <mutex>
+
+#include "netsocket/WiFiInterface.h"
+
+/**
+ * Stand-in for the ISM43362 module: the host network plays the access
+ * point. A scan reports one AP, named MBED_HOST_WIFI_SSID or
+ * "mbed-host"; connect() joins whatever SSID it is given unless
+ * MBED_HOST_WIFI_DOWN is set, in which case no SSID is found.
+ */
+class ISM43362Interface : public WiFiInterface {
+public:
+    explicit ISM43362Interface(bool debug = false);
+
+    nsapi_error_t set_credentials(const char *ssid, const char *pass,
+                                  nsapi_security_t security = NSAPI_SECURITY_NONE) override;
+    nsapi_error_t set_channel(uint8_t channel) override;
+    int8_t get_rssi() override;
+
+    nsapi_error_t connect(const char *ssid, const char *pass,
+                          nsapi_security_t security = NSAPI_SECURITY_NONE, uint8_t channel = 0) override;
+    nsapi_error_t connect() override;
+    nsapi_error_t disconnect() override;
+
+    nsapi_size_or_error_t scan(WiFiAccessPoint *res, nsapi_size_t count) override;
+
+    const char *get_mac_address() override;
+
+    using NetworkInterface::get_ip_address;
+    using NetworkInterface::get_netmask;
+    using NetworkInterface::get_gateway;
+
+private:
+    std::mutex _mutex;
+    char _ssid[33];
+    bool _connected;
+};
+
+#endif // MBED_HOST_ISM43362_INTERFACE_H
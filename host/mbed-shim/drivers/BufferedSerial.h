@@ -0,0 +1,80 @@
+#ifndef MBED_HOST_BUFFEREDSERIAL_H
+#define MBED_HOST_BUFFEREDSERIAL_H
+
+#include "PinNames.h"
+#include "platform/FileHandle.h"
+
+#ifndef MBED_CONF_PLATFORM_DEFAULT_SERIAL_BAUD_RATE
+#define MBED_CONF_PLATFORM_DEFAULT_SERIAL_BAUD_RATE 9600
+#endif
+
+namespace mbed {
+
+/**
+ * The console UART: writes go to stdout through stdio, so they stay in
+ * order with printf, reads come from stdin.
+ */
+class BufferedSerial : public FileHandle {
+public:
+    BufferedSerial(PinName tx, PinName rx, int baud = MBED_CONF_PLATFORM_DEFAULT_SERIAL_BAUD_RATE);
+
+    ssize_t read(void *buffer, size_t size) override;
+    ssize_t write(const void *buffer, size_t size) override;
+
+    int sync() override;
+
+    int isatty() override
+    {
+        return 1;
+    }
+
+    int set_blocking(bool blocking) override
+    {
+        _blocking = blocking;
+        return 0;
+    }
+
+    bool is_blocking() const override
+    {
+        return _blocking;
+    }
+
+    bool readable() const override;
+
+    bool writable() const override
+    {
+        return true;
+    }
+
+    void set_baud(int baud)
+    {
+        _baud = baud;
+    }
+
+    void set_format(int bits = 8, int parity = 0, int stop_bits = 1)
+    {
+        (void)bits;
+        (void)parity;
+        (void)stop_bits;
+    }
+
+    int enable_input(bool enabled = true)
+    {
+        (void)enabled;
+        return 0;
+    }
+
+    int enable_output(bool enabled = true)
+    {
+        (void)enabled;
+        return 0;
+    }
+
+private:
+    int _baud;
+    bool _blocking;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_BUFFEREDSERIAL_H
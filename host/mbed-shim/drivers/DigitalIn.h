@@ -0,0 +1,44 @@
+#ifndef MBED_HOST_DIGITALIN_H
+#define MBED_HOST_DIGITALIN_H
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+/** Input pin, reads the level MBED_HOST_INPUT last set. */
+class DigitalIn {
+public:
+    explicit DigitalIn(PinName pin, PinMode mode = PullDefault) :
+        _pin(pin)
+    {
+        (void)mode;
+    }
+
+    int read() const
+    {
+        return mbed_host::pin_read(_pin);
+    }
+
+    void mode(PinMode mode)
+    {
+        (void)mode;
+    }
+
+    int is_connected() const
+    {
+        return _pin != NC;
+    }
+
+    operator int() const
+    {
+        return read();
+    }
+
+private:
+    PinName _pin;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_DIGITALIN_H
@@ -0,0 +1,87 @@
+#ifndef MBED_HOST_DIGITALINOUT_H
+#define MBED_HOST_DIGITALINOUT_H
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+/**
+ * Bidirectional pin. As an input it floats (traced as Z) and reads the
+ * simulated level; the last written value comes back once it drives.
+ */
+class DigitalInOut {
+public:
+    explicit DigitalInOut(PinName pin) :
+        _pin(pin),
+        _value(0),
+        _output(false)
+    {
+    }
+
+    DigitalInOut(PinName pin, PinDirection direction, PinMode mode, int value) :
+        _pin(pin),
+        _value(value ? 1 : 0),
+        _output(false)
+    {
+        (void)mode;
+        if (direction == PIN_OUTPUT) {
+            output();
+        }
+    }
+
+    void write(int value)
+    {
+        _value = value ? 1 : 0;
+        if (_output) {
+            mbed_host::pin_write(_pin, _value);
+        }
+    }
+
+    int read() const
+    {
+        return _output ? _value : mbed_host::pin_read(_pin);
+    }
+
+    void output()
+    {
+        _output = true;
+        mbed_host::pin_write(_pin, _value);
+    }
+
+    void input()
+    {
+        _output = false;
+        mbed_host::pin_write(_pin, -1);
+    }
+
+    void mode(PinMode mode)
+    {
+        (void)mode;
+    }
+
+    int is_connected() const
+    {
+        return _pin != NC;
+    }
+
+    DigitalInOut &operator=(int value)
+    {
+        write(value);
+        return *this;
+    }
+
+    operator int() const
+    {
+        return read();
+    }
+
+private:
+    PinName _pin;
+    int _value;
+    bool _output;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_DIGITALINOUT_H
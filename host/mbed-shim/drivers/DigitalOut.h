@@ -0,0 +1,66 @@
+#ifndef MBED_HOST_DIGITALOUT_H
+#define MBED_HOST_DIGITALOUT_H
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+/** Output pin; writes land in the simulated pin levels. */
+class DigitalOut {
+public:
+    explicit DigitalOut(PinName pin) :
+        _pin(pin),
+        _value(0)
+    {
+        write(0);
+    }
+
+    DigitalOut(PinName pin, int value) :
+        _pin(pin),
+        _value(0)
+    {
+        write(value);
+    }
+
+    void write(int value)
+    {
+        _value = value ? 1 : 0;
+        mbed_host::pin_write(_pin, _value);
+    }
+
+    int read() const
+    {
+        return _value;
+    }
+
+    int is_connected() const
+    {
+        return _pin != NC;
+    }
+
+    DigitalOut &operator=(int value)
+    {
+        write(value);
+        return *this;
+    }
+
+    DigitalOut &operator=(const DigitalOut &rhs)
+    {
+        write(rhs.read());
+        return *this;
+    }
+
+    operator int() const
+    {
+        return read();
+    }
+
+private:
+    PinName _pin;
+    int _value;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_DIGITALOUT_H
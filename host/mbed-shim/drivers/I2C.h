@@ -0,0 +1,57 @@
+#ifndef MBED_HOST_I2C_H
+#define MBED_HOST_I2C_H
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+/**
+ * I2C master. Transfers go to the devices the shim puts on the bus of
+ * the SDA pin (see mbed_host::i2c_write()); the frequency is kept only.
+ */
+class I2C {
+public:
+    I2C(PinName sda, PinName scl) :
+        _sda(sda),
+        _scl(scl),
+        _hz(100000)
+    {
+    }
+
+    void frequency(int hz)
+    {
+        _hz = hz;
+    }
+
+    /** @return 0 on success (ack), non-zero on failure (nack). */
+    int read(int address, char *data, int length, bool repeated = false)
+    {
+        (void)repeated;
+        return mbed_host::i2c_read(_sda, address, data, length);
+    }
+
+    /** @return 0 on success (ack), non-zero on failure (nack). */
+    int write(int address, const char *data, int length, bool repeated = false)
+    {
+        (void)repeated;
+        return mbed_host::i2c_write(_sda, address, data, length);
+    }
+
+    void lock()
+    {
+    }
+
+    void unlock()
+    {
+    }
+
+private:
+    PinName _sda;
+    PinName _scl;
+    int _hz;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_I2C_H
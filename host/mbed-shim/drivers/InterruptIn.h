@@ -0,0 +1,53 @@
+#ifndef MBED_HOST_INTERRUPTIN_H
+#define MBED_HOST_INTERRUPTIN_H
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+
+namespace mbed {
+
+/**
+ * Edge interrupts of an input pin. Levels played by MBED_HOST_INPUT (or
+ * mbed_host::pin_input()) call the handlers from the thread that plays
+ * them, one edge at a time, as the interrupt would.
+ */
+class InterruptIn : private NonCopyable<InterruptIn> {
+public:
+    explicit InterruptIn(PinName pin);
+    InterruptIn(PinName pin, PinMode mode);
+    ~InterruptIn();
+
+    int read();
+
+    operator int()
+    {
+        return read();
+    }
+
+    void rise(Callback<void()> func);
+    void fall(Callback<void()> func);
+
+    void mode(PinMode pull)
+    {
+        (void)pull;
+    }
+
+    void enable_irq();
+    void disable_irq();
+
+private:
+    friend void mbed_host::pin_input(PinName pin, int level);
+
+    void edge(bool rising);
+
+    PinName _pin;
+    Callback<void()> _rise;
+    Callback<void()> _fall;
+    bool _enabled;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_INTERRUPTIN_H
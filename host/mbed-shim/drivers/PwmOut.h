@@ -0,0 +1,113 @@
+#ifndef MBED_HOST_PWMOUT_H
+#define MBED_HOST_PWMOUT_H
+
+#include <cstdint>
+
+#include "PinNames.h"
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+/** PWM output; period and duty cycle are kept and traced, nothing toggles. */
+class PwmOut {
+public:
+    explicit PwmOut(PinName pin) :
+        _pin(pin),
+        _period_us(20000),
+        _duty(0.0f),
+        _suspended(false)
+    {
+        update();
+    }
+
+    void write(float value)
+    {
+        _duty = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        update();
+    }
+
+    float read() const
+    {
+        return _duty;
+    }
+
+    void period(float seconds)
+    {
+        period_us((int)(seconds * 1000000.0f));
+    }
+
+    void period_ms(int ms)
+    {
+        period_us(ms * 1000);
+    }
+
+    void period_us(int us)
+    {
+        // the duty cycle is kept, as the STM32 PWM driver does
+        _period_us = us > 0 ? (uint32_t)us : 1;
+        update();
+    }
+
+    void pulsewidth(float seconds)
+    {
+        pulsewidth_us((int)(seconds * 1000000.0f));
+    }
+
+    void pulsewidth_ms(int ms)
+    {
+        pulsewidth_us(ms * 1000);
+    }
+
+    void pulsewidth_us(int us)
+    {
+        write((float)us / (float)_period_us);
+    }
+
+    int read_period_us() const
+    {
+        return (int)_period_us;
+    }
+
+    int read_pulsewidth_us() const
+    {
+        return (int)(_duty * _period_us);
+    }
+
+    void suspend()
+    {
+        _suspended = true;
+        update();
+    }
+
+    void resume()
+    {
+        _suspended = false;
+        update();
+    }
+
+    PwmOut &operator=(float value)
+    {
+        write(value);
+        return *this;
+    }
+
+    operator float() const
+    {
+        return read();
+    }
+
+private:
+    void update()
+    {
+        mbed_host::pin_pwm(_pin, _period_us, _suspended ? 0.0f : _duty);
+    }
+
+    PinName _pin;
+    uint32_t _period_us;
+    float _duty;
+    bool _suspended;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_PWMOUT_H
@@ -0,0 +1,76 @@
+#ifndef MBED_HOST_TICKER_H
+#define MBED_HOST_TICKER_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+
+namespace mbed_host { class TickerQueue; }
+
+namespace mbed {
+
+typedef uint64_t us_timestamp_t;
+
+/**
+ * Timer interrupt, periodic for Ticker, once for Timeout. Handlers run
+ * from the shim's timer thread, one at a time with the other interrupt
+ * handlers. A periodic handler keeps its phase: it is due at multiples of
+ * the period after attach().
+ */
+class TickerBase : private NonCopyable<TickerBase> {
+public:
+    void attach(Callback<void()> func, std::chrono::microseconds t);
+
+    /** t in seconds, deprecated in Mbed OS 6 but still common. */
+    void attach(Callback<void()> func, float t)
+    {
+        attach(func, std::chrono::microseconds((int64_t)(t * 1e6f)));
+    }
+
+    void attach_us(Callback<void()> func, us_timestamp_t t)
+    {
+        attach(func, std::chrono::microseconds(t));
+    }
+
+    /** No handler runs once detach() returns. */
+    void detach();
+
+protected:
+    explicit TickerBase(bool repeat);
+    ~TickerBase();
+
+private:
+    friend class mbed_host::TickerQueue;
+
+    void fire();
+
+    Callback<void()> _function;
+    uint64_t _period_us;
+    bool _repeat;
+    /** Place in the timer queue, while queued. */
+    bool _queued;
+    uint64_t _due_us;
+    uint64_t _sequence;
+};
+
+class Ticker : public TickerBase {
+public:
+    Ticker() :
+        TickerBase(true)
+    {
+    }
+};
+
+class Timeout : public TickerBase {
+public:
+    Timeout() :
+        TickerBase(false)
+    {
+    }
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_TICKER_H
@@ -0,0 +1,6 @@
+#ifndef MBED_HOST_TIMEOUT_H
+#define MBED_HOST_TIMEOUT_H
+
+#include "drivers/Ticker.h"
+
+#endif // MBED_HOST_TIMEOUT_H
@@ -0,0 +1,136 @@
+#ifndef MBED_HOST_EVENTQUEUE_H
+#define MBED_HOST_EVENTQUEUE_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#include "host/HostRuntime.h"
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+
+/** Room one event takes in a queue, whatever its arguments. */
+#define EVENTS_EVENT_SIZE (4 * sizeof(void *) + sizeof(mbed::Callback<void()>))
+
+#ifndef EVENTS_QUEUE_SIZE
+#define EVENTS_QUEUE_SIZE (32 * EVENTS_EVENT_SIZE)
+#endif
+
+namespace events {
+
+/**
+ * Mbed EventQueue: events posted from any thread or interrupt handler
+ * run in the thread that dispatches. A queue of size bytes holds
+ * size / EVENTS_EVENT_SIZE events; posting to a full queue returns 0 as
+ * on the board. Periodic events keep their phase, they are due at
+ * multiples of the period after the first post.
+ */
+class EventQueue : private mbed::NonCopyable<EventQueue> {
+public:
+    using duration = std::chrono::duration<int, std::milli>;
+
+    EventQueue(unsigned size = EVENTS_QUEUE_SIZE, unsigned char *buffer = nullptr);
+    ~EventQueue();
+
+    void dispatch_for(duration ms);
+    void dispatch_forever();
+
+    /** Run the events due now and return. */
+    void dispatch_once();
+
+    void break_dispatch();
+
+    /** @return false if the event already ran or was unknown. */
+    bool cancel(int id);
+
+    /** @return ms until the event is due, 0 if due or gone. */
+    int time_left(int id);
+
+    template <typename F, typename... ArgTs>
+    int call(F f, ArgTs... args)
+    {
+        return post(0, 0, bind(f, args...));
+    }
+
+    template <typename T, typename R, typename... BoundTs, typename... ArgTs>
+    int call(T *obj, R (T::*method)(BoundTs...), ArgTs... args)
+    {
+        return post(0, 0, bind(obj, method, args...));
+    }
+
+    template <typename F, typename... ArgTs>
+    int call_in(duration ms, F f, ArgTs... args)
+    {
+        return post(ms.count(), 0, bind(f, args...));
+    }
+
+    template <typename T, typename R, typename... BoundTs, typename... ArgTs>
+    int call_in(duration ms, T *obj, R (T::*method)(BoundTs...), ArgTs... args)
+    {
+        return post(ms.count(), 0, bind(obj, method, args...));
+    }
+
+    template <typename F, typename... ArgTs>
+    int call_every(duration ms, F f, ArgTs... args)
+    {
+        return post(ms.count(), ms.count(), bind(f, args...));
+    }
+
+    template <typename T, typename R, typename... BoundTs, typename... ArgTs>
+    int call_every(duration ms, T *obj, R (T::*method)(BoundTs...), ArgTs... args)
+    {
+        return post(ms.count(), ms.count(), bind(obj, method, args...));
+    }
+
+private:
+    struct Event {
+        int id;
+        uint64_t period_us;
+        std::function<void()> run;
+    };
+
+    /** Due time and post order: events due together run in post order. */
+    typedef std::pair<uint64_t, uint64_t> Key;
+
+    template <typename F, typename... ArgTs>
+    static std::function<void()> bind(F f, ArgTs... args)
+    {
+        return [f, args...]() mutable {
+            f(args...);
+        };
+    }
+
+    template <typename T, typename R, typename... BoundTs, typename... ArgTs>
+    static std::function<void()> bind(T *obj, R (T::*method)(BoundTs...), ArgTs... args)
+    {
+        return [obj, method, args...]() {
+            (obj->*method)(args...);
+        };
+    }
+
+    int post(int64_t delay_ms, int64_t period_ms, std::function<void()> run);
+
+    /** Run the events due; returns with the lock held. */
+    void run_due(std::unique_lock<std::mutex> &lock);
+
+    std::mutex _mutex;
+    mbed_host::Condition _cv;
+    std::map<Key, Event> _events;
+    std::map<int, Key> _keys;
+    size_t _capacity;
+    /** Events posted or running, against _capacity. */
+    size_t _used;
+    int _next_id;
+    uint64_t _sequence;
+    uint64_t _changes;
+    int _running_id;
+    bool _running_cancelled;
+    bool _break;
+};
+
+} // namespace events
+
+#endif // MBED_HOST_EVENTQUEUE_H
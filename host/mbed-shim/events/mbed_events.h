@@ -0,0 +1,11 @@
+#ifndef MBED_HOST_EVENTS_H
+#define MBED_HOST_EVENTS_H
+
+#include "events/EventQueue.h"
+#include "events/mbed_shared_queues.h"
+
+#ifndef MBED_NO_GLOBAL_USING_DIRECTIVE
+using namespace events;
+#endif
+
+#endif // MBED_HOST_EVENTS_H
@@ -0,0 +1,16 @@
+#ifndef MBED_HOST_SHARED_QUEUES_H
+#define MBED_HOST_SHARED_QUEUES_H
+
+#include "events/EventQueue.h"
+
+namespace mbed {
+
+/**
+ * The shared event queue. Nothing dispatches it on the host until the
+ * application does, as with events.shared-dispatch-from-application.
+ */
+events::EventQueue *mbed_event_queue();
+
+} // namespace mbed
+
+#endif // MBED_HOST_SHARED_QUEUES_H
@@ -0,0 +1,17 @@
+#ifndef MBED_HOST_US_TICKER_API_H
+#define MBED_HOST_US_TICKER_API_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Microseconds of the host clock, wrapping at 32 bits as on the board. */
+uint32_t us_ticker_read(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_US_TICKER_API_H
@@ -0,0 +1,161 @@
+#ifndef MBED_HOST_RUNTIME_H
+#define MBED_HOST_RUNTIME_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "PinNames.h"
+
+/*
+ * Host side of the shim: the clock every timed call goes through, the
+ * simulated pin levels and the settings taken from the environment.
+ *
+ *   MBED_HOST_CLOCK        "virtual" runs on a simulated clock, see virtual_clock()
+ *   MBED_HOST_RUN_MS       stop the program after this many ms
+ *   MBED_HOST_INPUT        input levels to play, "PC_13@1000=0,PC_13@1200=1"
+ *   MBED_HOST_TRACE        "pins" prints every pin change on stderr, "sched"
+ *                          every thread the virtual clock wakes up
+ *   MBED_HOST_NET_REDIRECT connect every socket to this address instead
+ *   MBED_HOST_FLASH        file backing the default block device
+ */
+
+namespace mbed { class InterruptIn; }
+
+namespace mbed_host {
+
+struct Task;
+
+/**
+ * True with MBED_HOST_CLOCK=virtual. The threads of the program then take
+ * turns on one simulated CPU: a thread runs until it blocks in the shim,
+ * the highest priority thread ready runs next (the one ready first among
+ * equals), and when every thread waits the clock jumps to the earliest
+ * deadline. Runs are repeatable and idle time costs nothing.
+ */
+bool virtual_clock();
+
+/** Microseconds since the program started, real or virtual. */
+uint64_t now_us();
+
+/** Block the calling thread until now_us() reaches deadline_us. */
+void sleep_until(uint64_t deadline_us);
+
+/** Let the other threads ready at the same priority run first. */
+void yield();
+
+/**
+ * Condition variable of the shim's blocking primitives, the only way
+ * they wait. With the virtual clock waiting passes the CPU on and
+ * notifying makes the waiters ready.
+ */
+class Condition {
+public:
+    void notify_one();
+    void notify_all();
+
+    /**
+     * Wait until pred() holds or deadline_us passes, whatever comes first.
+     *
+     * @return pred() on return.
+     */
+    template <typename Pred>
+    bool wait_until(std::unique_lock<std::mutex> &lock, uint64_t deadline_us, Pred pred)
+    {
+        while (!pred()) {
+            if (now_us() >= deadline_us) {
+                return false;
+            }
+            wait(lock, deadline_us);
+        }
+        return true;
+    }
+
+private:
+    void wait(std::unique_lock<std::mutex> &lock, uint64_t deadline_us);
+
+    std::condition_variable _cv;
+};
+
+/**
+ * Register a thread about to be started, from the thread starting it;
+ * the new thread calls task_run() first. Both do nothing with the real
+ * clock.
+ */
+Task *task_create(const char *name, int priority);
+void task_run(Task *task);
+
+/** The calling thread is done and leaves the schedule. */
+void task_exit();
+
+void task_set_priority(Task *task, int priority);
+
+/**
+ * Held around a call that blocks in the host, on stdin or a socket: the
+ * other threads run meanwhile. While a thread is outside the virtual
+ * clock goes no faster than real time, so the host has the time to
+ * answer, unless it is not expecting anything (pace_clock false).
+ */
+class Outside {
+public:
+    explicit Outside(bool pace_clock = true);
+    ~Outside();
+
+private:
+    Task *_task;
+};
+
+/** Deadline for a timeout in ms, osWaitForever (or more) waits forever. */
+uint64_t deadline_after_ms(uint64_t ms);
+
+/** Current level of a pin, inputs idle at the level of pin_default(). */
+int pin_read(PinName pin);
+
+/** Drive a pin from the application; traced with MBED_HOST_TRACE=pins. */
+void pin_write(PinName pin, int level);
+
+/** Drive an input pin from outside, firing the edge handlers attached. */
+void pin_input(PinName pin, int level);
+
+/**
+ * Run hook once, at the start of the next us_ticker_read() of any
+ * thread, for checks that put an interrupt at a given point of the code:
+ * the hook may pin_input() and sleep_until() for the time the code was
+ * held up.
+ */
+void before_next_ticker_read(void (*hook)());
+
+/** PWM output of a pin, traced like pin_write(). */
+void pin_pwm(PinName pin, uint32_t period_us, float duty);
+
+/**
+ * Transfers of mbed::I2C on the bus of its SDA pin, with 8-bit addresses;
+ * 0 when the device acknowledges. Only the sensor bus (I2C2, PB_11 and
+ * PB_10) has devices on it.
+ */
+int i2c_write(PinName sda, int address, const char *data, int length);
+int i2c_read(PinName sda, int address, char *data, int length);
+
+/**
+ * Held while interrupt handlers run, so holding it keeps them out, as
+ * masking interrupts does on the board.
+ */
+std::recursive_mutex &irq_mutex();
+
+void pin_attach(PinName pin, mbed::InterruptIn *irq);
+void pin_detach(PinName pin, mbed::InterruptIn *irq);
+
+/** "PA_5", or the alias the board gives it. */
+const char *pin_name(PinName pin);
+
+/** Environment setting, or fallback if unset. */
+const char *setting(const char *name, const char *fallback = nullptr);
+
+/** Print a line on stderr prefixed with the time, for the traces. */
+void trace(const char *format, ...);
+
+bool tracing(const char *what);
+
+} // namespace mbed_host
+
+#endif // MBED_HOST_RUNTIME_H
@@ -0,0 +1,43 @@
+#ifndef MBED_HOST_MBED_H
+#define MBED_HOST_MBED_H
+
+/*
+ * mbed.h of the host build: the subset of Mbed OS 6 the lab applications
+ * use, on pthreads, BSD sockets and the host clock. __MBED__ stays
+ * undefined so lab-utils keeps to its portable code paths.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "PinNames.h"
+#include "platform/Callback.h"
+#include "platform/FileHandle.h"
+#include "platform/NonCopyable.h"
+#include "platform/mbed_retarget.h"
+#include "platform/mbed_stats.h"
+#include "platform/mbed_wait_api.h"
+#include "hal/us_ticker_api.h"
+
+#include "drivers/BufferedSerial.h"
+#include "drivers/DigitalIn.h"
+#include "drivers/DigitalInOut.h"
+#include "drivers/DigitalOut.h"
+#include "drivers/I2C.h"
+#include "drivers/InterruptIn.h"
+#include "drivers/PwmOut.h"
+#include "drivers/Ticker.h"
+#include "drivers/Timeout.h"
+
+#include "rtos/rtos.h"
+
+#include "events/mbed_events.h"
+
+#ifndef MBED_NO_GLOBAL_USING_DIRECTIVE
+using namespace mbed;
+using namespace std;
+#endif
+
+#endif // MBED_HOST_MBED_H
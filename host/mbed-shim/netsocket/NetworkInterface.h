@@ -0,0 +1,44 @@
+#ifndef MBED_HOST_NETWORKINTERFACE_H
+#define MBED_HOST_NETWORKINTERFACE_H
+
+#include "netsocket/SocketAddress.h"
+#include "netsocket/nsapi_types.h"
+
+class WiFiInterface;
+
+/**
+ * Network interface. On the host every interface is the host's own
+ * network; name resolution goes to the system resolver.
+ */
+class NetworkInterface {
+public:
+    virtual ~NetworkInterface() = default;
+
+    virtual nsapi_error_t connect() = 0;
+    virtual nsapi_error_t disconnect() = 0;
+
+    virtual const char *get_mac_address()
+    {
+        return nullptr;
+    }
+
+    virtual nsapi_error_t get_ip_address(SocketAddress *address);
+    virtual nsapi_error_t get_netmask(SocketAddress *address);
+    virtual nsapi_error_t get_gateway(SocketAddress *address);
+
+    /** Deprecated text forms, still used by the examples. */
+    virtual const char *get_ip_address();
+    virtual const char *get_netmask();
+    virtual const char *get_gateway();
+
+    virtual nsapi_error_t gethostbyname(const char *host, SocketAddress *address,
+                                        nsapi_version_t version = NSAPI_UNSPEC,
+                                        const char *interface_name = nullptr);
+
+    virtual WiFiInterface *wifiInterface()
+    {
+        return nullptr;
+    }
+};
+
+#endif // MBED_HOST_NETWORKINTERFACE_H
@@ -0,0 +1,56 @@
+#ifndef MBED_HOST_SOCKETADDRESS_H
+#define MBED_HOST_SOCKETADDRESS_H
+
+#include <cstdint>
+
+#include "netsocket/nsapi_types.h"
+
+/** IP address and port, IPv4 or IPv6. */
+class SocketAddress {
+public:
+    SocketAddress();
+    SocketAddress(const nsapi_addr_t &addr, uint16_t port = 0);
+    SocketAddress(const char *addr, uint16_t port = 0);
+
+    /** @return false if addr is not a numeric address. */
+    bool set_ip_address(const char *addr);
+    void set_ip_bytes(const void *bytes, nsapi_version_t version);
+    void set_addr(const nsapi_addr_t &addr);
+
+    void set_port(uint16_t port)
+    {
+        _port = port;
+    }
+
+    const char *get_ip_address() const;
+
+    const void *get_ip_bytes() const
+    {
+        return _addr.bytes;
+    }
+
+    nsapi_version_t get_ip_version() const
+    {
+        return _addr.version;
+    }
+
+    nsapi_addr_t get_addr() const
+    {
+        return _addr;
+    }
+
+    uint16_t get_port() const
+    {
+        return _port;
+    }
+
+    /** True for an address other than all zeros. */
+    explicit operator bool() const;
+
+private:
+    nsapi_addr_t _addr;
+    uint16_t _port;
+    mutable char _text[NSAPI_IP_SIZE];
+};
+
+#endif // MBED_HOST_SOCKETADDRESS_H
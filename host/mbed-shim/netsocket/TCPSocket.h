@@ -0,0 +1,61 @@
+#ifndef MBED_HOST_TCPSOCKET_H
+#define MBED_HOST_TCPSOCKET_H
+
+#include "netsocket/NetworkInterface.h"
+#include "netsocket/SocketAddress.h"
+#include "netsocket/nsapi_types.h"
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+
+/**
+ * TCP socket on a BSD socket of the host.
+ *
+ * Blocking calls honour set_timeout(). In non-blocking mode connect()
+ * answers NSAPI_ERROR_IN_PROGRESS, then NSAPI_ERROR_ALREADY until the
+ * connection is up, and the sigio callback runs from the shim's socket
+ * thread when something happened: connection done, data in, room to
+ * send after a WOULD_BLOCK, or the peer gone. Like the drivers it stands
+ * for, it fires once per event, not for as long as data is waiting.
+ *
+ * MBED_HOST_NET_REDIRECT sends every connection to another address,
+ * e.g. 127.0.0.1 for a server.py running next to the program.
+ */
+class TCPSocket : private mbed::NonCopyable<TCPSocket> {
+public:
+    TCPSocket();
+    ~TCPSocket();
+
+    nsapi_error_t open(NetworkInterface *stack);
+    nsapi_error_t close();
+
+    nsapi_error_t connect(const SocketAddress &address);
+
+    nsapi_size_or_error_t send(const void *data, nsapi_size_t size);
+    nsapi_size_or_error_t recv(void *data, nsapi_size_t size);
+
+    void set_blocking(bool blocking);
+
+    /** @param timeout ms, -1 for none. */
+    void set_timeout(int timeout);
+
+    void sigio(mbed::Callback<void()> func);
+
+private:
+    /** Blocking mode: wait for events, honouring the timeout. */
+    bool wait_for(short events);
+
+    /** Non-blocking mode: raise sigio once events happen. */
+    void arm(short events);
+
+    nsapi_error_t finish_connect();
+
+    int _fd;
+    bool _open;
+    /** -1 blocks without limit, 0 is non-blocking. */
+    int _timeout_ms;
+    bool _connecting;
+    bool _connected;
+    mbed::Callback<void()> _sigio;
+};
+
+#endif // MBED_HOST_TCPSOCKET_H
@@ -0,0 +1,41 @@
+#ifndef MBED_HOST_WIFIACCESSPOINT_H
+#define MBED_HOST_WIFIACCESSPOINT_H
+
+#include "netsocket/nsapi_types.h"
+
+/** One scan result. */
+class WiFiAccessPoint {
+public:
+    WiFiAccessPoint();
+    WiFiAccessPoint(nsapi_wifi_ap_t ap);
+
+    const char *get_ssid() const
+    {
+        return _ap.ssid;
+    }
+
+    const uint8_t *get_bssid() const
+    {
+        return _ap.bssid;
+    }
+
+    nsapi_security_t get_security() const
+    {
+        return _ap.security;
+    }
+
+    int8_t get_rssi() const
+    {
+        return _ap.rssi;
+    }
+
+    uint8_t get_channel() const
+    {
+        return _ap.channel;
+    }
+
+private:
+    nsapi_wifi_ap_t _ap;
+};
+
+#endif // MBED_HOST_WIFIACCESSPOINT_H
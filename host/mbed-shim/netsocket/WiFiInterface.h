@@ -0,0 +1,34 @@
+#ifndef MBED_HOST_WIFIINTERFACE_H
+#define MBED_HOST_WIFIINTERFACE_H
+
+#include <cstdint>
+
+#include "netsocket/NetworkInterface.h"
+#include "netsocket/WiFiAccessPoint.h"
+
+class WiFiInterface : public NetworkInterface {
+public:
+    virtual nsapi_error_t set_credentials(const char *ssid, const char *pass,
+                                          nsapi_security_t security = NSAPI_SECURITY_NONE) = 0;
+
+    virtual nsapi_error_t set_channel(uint8_t channel) = 0;
+
+    virtual int8_t get_rssi() = 0;
+
+    virtual nsapi_error_t connect(const char *ssid, const char *pass,
+                                  nsapi_security_t security = NSAPI_SECURITY_NONE, uint8_t channel = 0) = 0;
+
+    nsapi_error_t connect() override = 0;
+
+    nsapi_error_t disconnect() override = 0;
+
+    /** @return results stored, or the number available if count is 0. */
+    virtual nsapi_size_or_error_t scan(WiFiAccessPoint *res, nsapi_size_t count) = 0;
+
+    WiFiInterface *wifiInterface() override
+    {
+        return this;
+    }
+};
+
+#endif // MBED_HOST_WIFIINTERFACE_H
@@ -0,0 +1,127 @@
+#ifndef MBED_HOST_CALLBACK_H
+#define MBED_HOST_CALLBACK_H
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace mbed {
+
+template <typename Signature>
+class Callback;
+
+/**
+ * mbed::Callback on top of std::function: a function, an object and a
+ * method, a function with a bound first argument or any functor.
+ */
+template <typename R, typename... ArgTs>
+class Callback<R(ArgTs...)> {
+public:
+    Callback() = default;
+
+    Callback(std::nullptr_t)
+    {
+    }
+
+    Callback(R (*func)(ArgTs...))
+    {
+        if (func) {
+            _func = func;
+        }
+    }
+
+    template <typename F, typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type, Callback>::value &&
+                  std::is_constructible<std::function<R(ArgTs...)>, F>::value>::type>
+    Callback(F func) :
+        _func(std::move(func))
+    {
+    }
+
+    template <typename T, typename U>
+    Callback(U *obj, R (T::*method)(ArgTs...)) :
+        _func([obj, method](ArgTs... args) -> R {
+            return (obj->*method)(std::forward<ArgTs>(args)...);
+        })
+    {
+    }
+
+    template <typename T, typename U>
+    Callback(const U *obj, R (T::*method)(ArgTs...) const) :
+        _func([obj, method](ArgTs... args) -> R {
+            return (obj->*method)(std::forward<ArgTs>(args)...);
+        })
+    {
+    }
+
+    template <typename T, typename U>
+    Callback(R (*func)(T *, ArgTs...), U *arg) :
+        _func([func, arg](ArgTs... args) -> R {
+            return func(arg, std::forward<ArgTs>(args)...);
+        })
+    {
+    }
+
+    R call(ArgTs... args) const
+    {
+        return _func(std::forward<ArgTs>(args)...);
+    }
+
+    R operator()(ArgTs... args) const
+    {
+        return _func(std::forward<ArgTs>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(_func);
+    }
+
+    friend bool operator==(const Callback &callback, std::nullptr_t)
+    {
+        return !callback;
+    }
+
+    friend bool operator!=(const Callback &callback, std::nullptr_t)
+    {
+        return static_cast<bool>(callback);
+    }
+
+private:
+    std::function<R(ArgTs...)> _func;
+};
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(R (*func)(ArgTs...))
+{
+    return Callback<R(ArgTs...)>(func);
+}
+
+template <typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const Callback<R(ArgTs...)> &func)
+{
+    return func;
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(U *obj, R (T::*method)(ArgTs...))
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(const U *obj, R (T::*method)(ArgTs...) const)
+{
+    return Callback<R(ArgTs...)>(obj, method);
+}
+
+template <typename T, typename U, typename R, typename... ArgTs>
+Callback<R(ArgTs...)> callback(R (*func)(T *, ArgTs...), U *arg)
+{
+    return Callback<R(ArgTs...)>(func, arg);
+}
+
+} // namespace mbed
+
+#endif // MBED_HOST_CALLBACK_H
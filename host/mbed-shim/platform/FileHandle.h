@@ -0,0 +1,68 @@
+#ifndef MBED_HOST_FILEHANDLE_H
+#define MBED_HOST_FILEHANDLE_H
+
+#include <cerrno>
+#include <cstdio>
+#include <sys/types.h>
+
+#include "platform/NonCopyable.h"
+
+namespace mbed {
+
+/** Stream interface of the Mbed drivers (serial ports, files). */
+class FileHandle : private NonCopyable<FileHandle> {
+public:
+    virtual ~FileHandle() = default;
+
+    /** @return bytes read, 0 at the end, or a negative errno. */
+    virtual ssize_t read(void *buffer, size_t size) = 0;
+
+    /** @return bytes written or a negative errno. */
+    virtual ssize_t write(const void *buffer, size_t size) = 0;
+
+    virtual off_t seek(off_t offset, int whence = SEEK_SET)
+    {
+        (void)offset;
+        (void)whence;
+        return -ESPIPE;
+    }
+
+    virtual int close()
+    {
+        return 0;
+    }
+
+    virtual int sync()
+    {
+        return 0;
+    }
+
+    virtual int isatty()
+    {
+        return 0;
+    }
+
+    virtual int set_blocking(bool blocking)
+    {
+        return blocking ? 0 : -ENOTTY;
+    }
+
+    virtual bool is_blocking() const
+    {
+        return true;
+    }
+
+    virtual bool readable() const
+    {
+        return true;
+    }
+
+    virtual bool writable() const
+    {
+        return true;
+    }
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_FILEHANDLE_H
@@ -0,0 +1,20 @@
+#ifndef MBED_HOST_NONCOPYABLE_H
+#define MBED_HOST_NONCOPYABLE_H
+
+namespace mbed {
+
+/** Base of the classes that must not be copied, as in Mbed OS. */
+template <typename T>
+class NonCopyable {
+protected:
+    NonCopyable() = default;
+    ~NonCopyable() = default;
+
+public:
+    NonCopyable(const NonCopyable &) = delete;
+    NonCopyable &operator=(const NonCopyable &) = delete;
+};
+
+} // namespace mbed
+
+#endif // MBED_HOST_NONCOPYABLE_H
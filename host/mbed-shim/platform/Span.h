@@ -0,0 +1,72 @@
+#ifndef MBED_HOST_SPAN_H
+#define MBED_HOST_SPAN_H
+
+#include <cstddef>
+
+namespace mbed {
+
+#define SPAN_DYNAMIC_EXTENT -1
+
+/** Span of Mbed OS, the dynamic extent only: a pointer and a size. */
+template <typename ElementType, ptrdiff_t Extent = SPAN_DYNAMIC_EXTENT>
+class Span {
+public:
+    Span() :
+        _data(nullptr),
+        _size(0)
+    {
+    }
+
+    Span(ElementType *data, size_t size) :
+        _data(data),
+        _size(size)
+    {
+    }
+
+    template <size_t N>
+    Span(ElementType (&array)[N]) :
+        _data(array),
+        _size(N)
+    {
+    }
+
+    ElementType *data() const
+    {
+        return _data;
+    }
+
+    ptrdiff_t size() const
+    {
+        return (ptrdiff_t)_size;
+    }
+
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    ElementType &operator[](ptrdiff_t index) const
+    {
+        return _data[index];
+    }
+
+private:
+    ElementType *_data;
+    size_t _size;
+};
+
+template <typename T>
+Span<T> make_Span(T *data, size_t size)
+{
+    return Span<T>(data, size);
+}
+
+template <typename T>
+Span<const T> make_const_Span(const T *data, size_t size)
+{
+    return Span<const T>(data, size);
+}
+
+} // namespace mbed
+
+#endif // MBED_HOST_SPAN_H
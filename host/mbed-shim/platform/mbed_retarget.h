@@ -0,0 +1,16 @@
+#ifndef MBED_HOST_RETARGET_H
+#define MBED_HOST_RETARGET_H
+
+#include "platform/FileHandle.h"
+
+namespace mbed {
+
+/**
+ * Console override of an application. The declaration only: stdio is
+ * the console of the host build whatever an application returns.
+ */
+FileHandle *mbed_override_console(int fd);
+
+} // namespace mbed
+
+#endif // MBED_HOST_RETARGET_H
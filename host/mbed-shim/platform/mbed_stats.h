@@ -0,0 +1,16 @@
+#ifndef MBED_HOST_STATS_H
+#define MBED_HOST_STATS_H
+
+#include <cstdint>
+
+/** CPU time of the process standing in for the board's idle counter. */
+typedef struct {
+    uint64_t uptime;
+    uint64_t idle_time;
+    uint64_t sleep_time;
+    uint64_t deep_sleep_time;
+} mbed_stats_cpu_t;
+
+void mbed_stats_cpu_get(mbed_stats_cpu_t *stats);
+
+#endif // MBED_HOST_STATS_H
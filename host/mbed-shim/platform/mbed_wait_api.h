@@ -0,0 +1,17 @@
+#ifndef MBED_HOST_WAIT_API_H
+#define MBED_HOST_WAIT_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Wait on the host clock; the board spins, the host sleeps. */
+void wait_us(int us);
+
+void wait_ns(unsigned int ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MBED_HOST_WAIT_API_H
@@ -0,0 +1,51 @@
+#ifndef MBED_HOST_EVENTFLAGS_H
+#define MBED_HOST_EVENTFLAGS_H
+
+#include <cstdint>
+#include <mutex>
+
+#include "host/HostRuntime.h"
+#include "platform/NonCopyable.h"
+#include "rtos/Kernel.h"
+
+namespace rtos {
+
+/** Set of 31 flags threads wait on; set() is fine from interrupt handlers. */
+class EventFlags : private mbed::NonCopyable<EventFlags> {
+public:
+    EventFlags() :
+        _flags(0)
+    {
+    }
+
+    explicit EventFlags(const char *name) :
+        _flags(0)
+    {
+        (void)name;
+    }
+
+    uint32_t set(uint32_t flags);
+    uint32_t clear(uint32_t flags = 0x7fffffff);
+    uint32_t get() const;
+
+    uint32_t wait_all(uint32_t flags = 0, uint32_t millisec = osWaitForever, bool clear = true);
+    uint32_t wait_any(uint32_t flags = 0, uint32_t millisec = osWaitForever, bool clear = true);
+
+    uint32_t wait_all_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear = true);
+    uint32_t wait_any_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear = true);
+
+    uint32_t wait_all_until(uint32_t flags, Kernel::Clock::time_point abs_time, bool clear = true);
+    uint32_t wait_any_until(uint32_t flags, Kernel::Clock::time_point abs_time, bool clear = true);
+
+private:
+    /** @return the flags at the time they matched, or osFlagsErrorTimeout. */
+    uint32_t wait(uint32_t flags, bool all, uint64_t deadline_us, bool clear);
+
+    mutable std::mutex _mutex;
+    mbed_host::Condition _cv;
+    uint32_t _flags;
+};
+
+} // namespace rtos
+
+#endif // MBED_HOST_EVENTFLAGS_H
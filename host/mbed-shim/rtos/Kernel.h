@@ -0,0 +1,32 @@
+#ifndef MBED_HOST_KERNEL_H
+#define MBED_HOST_KERNEL_H
+
+#include <chrono>
+#include <cstdint>
+
+#include "rtos/mbed_rtos_types.h"
+
+namespace rtos {
+namespace Kernel {
+
+/** The RTOS tick: milliseconds of the host clock since the program started. */
+struct Clock {
+    using rep = int64_t;
+    using period = std::milli;
+    using duration = std::chrono::duration<rep, period>;
+    using duration_u32 = std::chrono::duration<uint32_t, period>;
+    using time_point = std::chrono::time_point<Clock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now();
+};
+
+constexpr Clock::duration_u32 wait_for_u32_forever(osWaitForever);
+constexpr Clock::duration_u32 wait_for_u32_max(osWaitForever - 1);
+
+uint64_t get_ms_count();
+
+} // namespace Kernel
+} // namespace rtos
+
+#endif // MBED_HOST_KERNEL_H
@@ -0,0 +1,56 @@
+#ifndef MBED_HOST_MUTEX_H
+#define MBED_HOST_MUTEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "host/HostRuntime.h"
+#include "platform/NonCopyable.h"
+#include "rtos/Kernel.h"
+
+namespace rtos {
+
+/**
+ * Recursive mutex, as the RTOS one. Waiting for it goes through the
+ * shim's Condition, so a thread blocked on it lets the others run.
+ */
+class Mutex : private mbed::NonCopyable<Mutex> {
+public:
+    Mutex() :
+        _count(0)
+    {
+    }
+
+    explicit Mutex(const char *name) :
+        _count(0)
+    {
+        (void)name;
+    }
+
+    void lock()
+    {
+        lock_until(UINT64_MAX);
+    }
+
+    bool trylock()
+    {
+        return lock_until(0);
+    }
+
+    bool trylock_for(Kernel::Clock::duration_u32 rel_time);
+
+    void unlock();
+
+private:
+    bool lock_until(uint64_t deadline_us);
+
+    std::mutex _mutex;
+    mbed_host::Condition _cv;
+    std::thread::id _owner;
+    uint32_t _count;
+};
+
+} // namespace rtos
+
+#endif // MBED_HOST_MUTEX_H
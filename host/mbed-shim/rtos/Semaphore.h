@@ -0,0 +1,37 @@
+#ifndef MBED_HOST_SEMAPHORE_H
+#define MBED_HOST_SEMAPHORE_H
+
+#include <cstdint>
+#include <mutex>
+
+#include "host/HostRuntime.h"
+#include "platform/NonCopyable.h"
+#include "rtos/Kernel.h"
+
+namespace rtos {
+
+class Semaphore : private mbed::NonCopyable<Semaphore> {
+public:
+    explicit Semaphore(int32_t count = 0);
+    Semaphore(int32_t count, uint16_t max_count);
+
+    void acquire();
+    bool try_acquire();
+    bool try_acquire_for(Kernel::Clock::duration_u32 rel_time);
+    bool try_acquire_until(Kernel::Clock::time_point abs_time);
+
+    /** @return osErrorResource once the maximum count is reached. */
+    osStatus release();
+
+private:
+    bool acquire_until(uint64_t deadline_us);
+
+    std::mutex _mutex;
+    mbed_host::Condition _cv;
+    int32_t _count;
+    int32_t _max_count;
+};
+
+} // namespace rtos
+
+#endif // MBED_HOST_SEMAPHORE_H
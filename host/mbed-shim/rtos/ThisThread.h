@@ -0,0 +1,28 @@
+#ifndef MBED_HOST_THISTHREAD_H
+#define MBED_HOST_THISTHREAD_H
+
+#include <cstdint>
+
+#include "rtos/Kernel.h"
+#include "rtos/mbed_rtos_types.h"
+
+namespace rtos {
+namespace ThisThread {
+
+void sleep_for(uint32_t millisec);
+void sleep_for(Kernel::Clock::duration_u32 rel_time);
+
+void sleep_until(uint64_t millisec);
+void sleep_until(Kernel::Clock::time_point abs_time);
+
+void yield();
+
+osThreadId_t get_id();
+
+/** Name of the rtos::Thread running, "main" for the main thread. */
+const char *get_name();
+
+} // namespace ThisThread
+} // namespace rtos
+
+#endif // MBED_HOST_THISTHREAD_H
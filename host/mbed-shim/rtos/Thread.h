@@ -0,0 +1,90 @@
+#ifndef MBED_HOST_THREAD_H
+#define MBED_HOST_THREAD_H
+
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "host/HostRuntime.h"
+#include "platform/Callback.h"
+#include "platform/NonCopyable.h"
+#include "rtos/mbed_rtos_types.h"
+
+namespace rtos {
+
+/**
+ * RTOS thread on a pthread. With the real clock the threads run side by
+ * side and the priority is only kept for get_priority(); with the virtual
+ * clock it picks the next thread to run. Stacks are the system's.
+ */
+class Thread : private mbed::NonCopyable<Thread> {
+public:
+    enum State {
+        Inactive,
+        Ready,
+        Running,
+        WaitingDelay,
+        WaitingJoin,
+        WaitingThreadFlag,
+        WaitingEventFlag,
+        WaitingMutex,
+        WaitingSemaphore,
+        WaitingMemoryPool,
+        WaitingMessageGet,
+        WaitingMessagePut,
+        WaitingInterval,
+        WaitingOr,
+        WaitingAnd,
+        WaitingMailbox,
+        Deleted = 0xFF
+    };
+
+    Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = OS_STACK_SIZE,
+           unsigned char *stack_mem = nullptr, const char *name = nullptr);
+
+    /** A running thread cannot be killed on the host, it is left to run. */
+    ~Thread();
+
+    osStatus start(mbed::Callback<void()> task);
+
+    osStatus join();
+
+    osStatus set_priority(osPriority priority);
+
+    osPriority get_priority() const;
+
+    State get_state() const;
+
+    uint32_t stack_size() const
+    {
+        return _stack_size;
+    }
+
+    const char *get_name() const
+    {
+        return _name;
+    }
+
+    osThreadId_t get_id() const
+    {
+        return const_cast<Thread *>(this);
+    }
+
+private:
+    void run(mbed_host::Task *task);
+
+    mbed::Callback<void()> _task;
+    std::thread _thread;
+    /** Place in the virtual clock schedule while the thread runs. */
+    mbed_host::Task *_scheduled;
+    mutable std::mutex _mutex;
+    mbed_host::Condition _finished_cv;
+    osPriority _priority;
+    uint32_t _stack_size;
+    const char *_name;
+    State _state;
+};
+
+} // namespace rtos
+
+#endif // MBED_HOST_THREAD_H
@@ -0,0 +1,53 @@
+#ifndef MBED_HOST_RTOS_TYPES_H
+#define MBED_HOST_RTOS_TYPES_H
+
+#include <cstdint>
+
+/* CMSIS-RTOS2 names the Mbed RTOS API is written in. */
+
+typedef enum {
+    osPriorityNone = 0,
+    osPriorityIdle = 1,
+    osPriorityLow = 8,
+    osPriorityBelowNormal = 16,
+    osPriorityNormal = 24,
+    osPriorityAboveNormal = 32,
+    osPriorityHigh = 40,
+    osPriorityRealtime = 48,
+    osPriorityISR = 56,
+    osPriorityError = -1
+} osPriority_t;
+
+typedef osPriority_t osPriority;
+
+typedef enum {
+    osOK = 0,
+    osError = -1,
+    osErrorTimeout = -2,
+    osErrorResource = -3,
+    osErrorParameter = -4,
+    osErrorNoMemory = -5,
+    osErrorISR = -6
+} osStatus_t;
+
+typedef osStatus_t osStatus;
+
+typedef void *osThreadId_t;
+
+#define osWaitForever         0xFFFFFFFFU
+
+#define osFlagsWaitAny        0x00000000U
+#define osFlagsWaitAll        0x00000001U
+#define osFlagsNoClear        0x00000002U
+
+#define osFlagsError          0x80000000U
+#define osFlagsErrorTimeout   0xFFFFFFFEU
+#define osFlagsErrorParameter 0xFFFFFFFCU
+
+#ifndef MBED_CONF_RTOS_THREAD_STACK_SIZE
+#define MBED_CONF_RTOS_THREAD_STACK_SIZE 4096
+#endif
+
+#define OS_STACK_SIZE MBED_CONF_RTOS_THREAD_STACK_SIZE
+
+#endif // MBED_HOST_RTOS_TYPES_H
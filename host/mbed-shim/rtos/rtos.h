@@ -0,0 +1,16 @@
+#ifndef MBED_HOST_RTOS_H
+#define MBED_HOST_RTOS_H
+
+#include "rtos/mbed_rtos_types.h"
+#include "rtos/EventFlags.h"
+#include "rtos/Kernel.h"
+#include "rtos/Mutex.h"
+#include "rtos/Semaphore.h"
+#include "rtos/ThisThread.h"
+#include "rtos/Thread.h"
+
+#ifndef MBED_NO_GLOBAL_USING_DIRECTIVE
+using namespace rtos;
+#endif
+
+#endif // MBED_HOST_RTOS_H
@@ -0,0 +1,1511 @@
+#include "ble/BLE.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "LinkBudget.h"
+#include "drivers/Timeout.h"
+#include "host/HostRuntime.h"
+
+namespace mbed_host {
+
+using namespace ble;
+
+namespace {
+
+const int MAX_LINKS = 4;
+
+/** Notifications a link holds before write() fails with BLE_ERROR_NO_MEM. */
+const size_t TX_QUEUE = 16;
+
+/** Connection events from a request to its answer, as phones take them. */
+const int MTU_EVENTS = 2;
+const int DATA_LENGTH_EVENTS = 2;
+const int PHY_EVENTS = 3;
+const int SUBSCRIBE_EVENTS = 4;
+const int PARAMETERS_EVENTS = 6;
+const int REJECT_EVENTS = 1;
+
+/** Time a central takes to find advertising that (re)started. */
+const uint32_t SCAN_US = 20000;
+
+/** Supervision timeout centrals connect with, 5 s. */
+const uint16_t CONNECT_TIMEOUT_10MS = 500;
+
+const uint16_t CCCD_NOTIFY = 0x0001;
+const uint16_t CCCD_INDICATE = 0x0002;
+
+/** Advertising sets, handle 0 the legacy one. */
+const int MAX_ADVERTISING_SETS = 4;
+const uint16_t LEGACY_DATA_MAX = 31;
+const uint16_t EXTENDED_DATA_MAX = 1650;
+/** advDelay, the pseudo-random 0-10 ms added to each advertising interval. */
+const uint32_t ADV_DELAY_MAX_US = 10000;
+
+/**
+ * A peer of MBED_HOST_BLE, "name@connect_ms[-disconnect_ms][:option]...":
+ *
+ *   2m              supports the 2M PHY
+ *   dle             supports data length extension
+ *   mtu=N           its ATT MTU, 23 by default
+ *   interval=MS     interval it connects with, 50 by default
+ *   min-interval=MS shortest interval it accepts, 15 by default
+ *   max-latency=N   highest peripheral latency it accepts, 30 by default
+ *   event-ms=MS     time it gives a connection event, the interval by default
+ *   reject          rejects every parameter update
+ *   nosub           does not subscribe to the notifications
+ */
+struct Central {
+    Central() :
+        connect_us(0),
+        disconnect_us(UINT64_MAX),
+        phy_2m(false),
+        dle(false),
+        reject(false),
+        subscribe(true),
+        mtu(lab::BLE_DEFAULT_ATT_MTU),
+        interval_us(50000),
+        min_interval_us(15000),
+        max_latency(30),
+        event_us(0),
+        waiting(false),
+        connected(false)
+    {
+    }
+
+    std::string name;
+    uint64_t connect_us;
+    uint64_t disconnect_us;
+    bool phy_2m;
+    bool dle;
+    bool reject;
+    bool subscribe;
+    uint16_t mtu;
+    uint32_t interval_us;
+    uint32_t min_interval_us;
+    uint16_t max_latency;
+    uint32_t event_us;
+    /** Due, waiting for the device to advertise. */
+    bool waiting;
+    bool connected;
+    mbed::Timeout timer;
+};
+
+struct Procedure {
+    enum Kind {
+        MTU,
+        DATA_LENGTH,
+        PHY,
+        PARAMETERS,
+        SUBSCRIBE,
+        WRITE,
+        DISCONNECT,
+    };
+
+    Kind kind;
+    uint64_t due_us;
+    /** PHY: the PHYs asked for; PARAMETERS: the request. */
+    uint8_t phys;
+    uint32_t min_interval_us;
+    uint32_t max_interval_us;
+    uint16_t latency;
+    uint16_t timeout_10ms;
+    disconnection_reason_t::type reason;
+    /** WRITE: index in the scripted writes. */
+    size_t write;
+};
+
+/**
+ * A write of MBED_HOST_BLE_WRITES, "name@ms:handle=hex": the central
+ * writes the value without response at its first connection event from
+ * ms on, if it is connected by then.
+ */
+struct ScriptedWrite {
+    std::string central;
+    uint64_t at_us;
+    GattAttribute::Handle_t handle;
+    std::vector<uint8_t> value;
+};
+
+/** An advertising set; the legacy one starts out created, connectable. */
+struct AdvertisingSet {
+    AdvertisingSet() :
+        created(false),
+        active(false),
+        connectable(true),
+        legacy(true),
+        interval_us(AdvertisingParameters::DEFAULT_ADVERTISING_INTERVAL_MIN * 625),
+        events(0)
+    {
+    }
+
+    bool created;
+    bool active;
+    bool connectable;
+    bool legacy;
+    uint32_t interval_us;
+    std::vector<uint8_t> payload;
+    uint32_t events;
+    mbed::Timeout timer;
+};
+
+struct Notification {
+    GattAttribute::Handle_t handle;
+    bool indication;
+    std::vector<uint8_t> value;
+};
+
+struct Link {
+    Link() :
+        open(false),
+        central(nullptr)
+    {
+    }
+
+    bool open;
+    Central *central;
+    /** A connection event every interval_us from anchor_us. */
+    uint64_t anchor_us;
+    uint32_t interval_us;
+    uint16_t latency;
+    uint16_t timeout_10ms;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    uint16_t data_length;
+    uint16_t att_mtu;
+    bool mtu_exchanged;
+    /** Client configuration of every CCCD written, by CCCD handle. */
+    std::vector<std::pair<GattAttribute::Handle_t, uint16_t> > cccds;
+    std::deque<Notification> queue;
+    std::vector<Procedure> procedures;
+    uint64_t notifications;
+    uint64_t bytes;
+    mbed::Timeout timer;
+    uint64_t timer_due_us;
+};
+
+struct Attribute {
+    enum Kind {
+        SERVICE,
+        DECLARATION,
+        VALUE,
+        CCCD,
+        DESCRIPTOR,
+    };
+
+    Kind kind;
+    /** The characteristic of a value or CCCD. */
+    GattCharacteristic *characteristic;
+    std::vector<uint8_t> value;
+    uint16_t max_length;
+};
+
+/** "2m:dle:mtu=247" and friends, see Central. */
+bool parse_option(Central &central, const std::string &option)
+{
+    size_t equal = option.find('=');
+    std::string key = option.substr(0, equal);
+    long value = equal == std::string::npos ? -1 : strtol(option.c_str() + equal + 1, nullptr, 10);
+    if (key == "2m") {
+        central.phy_2m = true;
+    } else if (key == "dle") {
+        central.dle = true;
+    } else if (key == "reject") {
+        central.reject = true;
+    } else if (key == "nosub") {
+        central.subscribe = false;
+    } else if (key == "mtu" && value >= lab::BLE_DEFAULT_ATT_MTU && value <= 517) {
+        central.mtu = (uint16_t)value;
+    } else if (key == "interval" && value >= 8 && value <= 4000) {
+        // rounded to the 1.25 ms unit of the link layer
+        central.interval_us = (uint32_t)(value * 1000 / 1250 * 1250);
+    } else if (key == "min-interval" && value >= 7 && value <= 4000) {
+        central.min_interval_us = (uint32_t)(value * 1000 / 1250 * 1250);
+        if (central.min_interval_us < 7500) {
+            central.min_interval_us = 7500;
+        }
+    } else if (key == "max-latency" && value >= 0 && value <= 499) {
+        central.max_latency = (uint16_t)value;
+    } else if (key == "event-ms" && value > 0) {
+        central.event_us = (uint32_t)value * 1000;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::unique_ptr<Central> > parse_centrals(const char *script)
+{
+    std::vector<std::unique_ptr<Central> > centrals;
+    const char *item = script;
+    while (*item) {
+        const char *end = strchr(item, ',');
+        std::string text(item, end ? (size_t)(end - item) : strlen(item));
+        item += text.size() + (end ? 1 : 0);
+
+        std::unique_ptr<Central> central(new Central());
+        size_t at = text.find('@');
+        bool valid = at != std::string::npos && at > 0;
+        if (valid) {
+            central->name = text.substr(0, at);
+            char *next;
+            central->connect_us = strtoull(text.c_str() + at + 1, &next, 10) * 1000;
+            if (*next == '-') {
+                central->disconnect_us = strtoull(next + 1, &next, 10) * 1000;
+            }
+            std::string options(next);
+            while (valid && !options.empty()) {
+                if (options[0] != ':') {
+                    valid = false;
+                    break;
+                }
+                size_t colon = options.find(':', 1);
+                valid = parse_option(*central, options.substr(1, colon == std::string::npos ? colon : colon - 1));
+                options = colon == std::string::npos ? std::string() : options.substr(colon);
+            }
+        }
+        if (!valid) {
+            fprintf(stderr, "MBED_HOST_BLE: cannot parse \"%s\"\n", text.c_str());
+            continue;
+        }
+        centrals.push_back(std::move(central));
+    }
+    return centrals;
+}
+
+std::vector<ScriptedWrite> parse_writes(const char *script)
+{
+    std::vector<ScriptedWrite> writes;
+    const char *item = script;
+    while (*item) {
+        const char *end = strchr(item, ',');
+        std::string text(item, end ? (size_t)(end - item) : strlen(item));
+        item += text.size() + (end ? 1 : 0);
+
+        ScriptedWrite write;
+        size_t at = text.find('@');
+        size_t colon = text.find(':', at == std::string::npos ? 0 : at);
+        size_t equal = text.find('=', colon == std::string::npos ? 0 : colon);
+        bool valid = at != std::string::npos && at > 0 && colon != std::string::npos && equal != std::string::npos;
+        if (valid) {
+            write.central = text.substr(0, at);
+            write.at_us = strtoull(text.c_str() + at + 1, nullptr, 10) * 1000;
+            long handle = strtol(text.c_str() + colon + 1, nullptr, 10);
+            std::string hex = text.substr(equal + 1);
+            valid = handle > 0 && handle <= 0xFFFF && !hex.empty() && hex.size() % 2 == 0 &&
+                    hex.find_first_not_of("0123456789abcdefABCDEF") == std::string::npos;
+            write.handle = (GattAttribute::Handle_t)handle;
+            for (size_t i = 0; valid && i < hex.size(); i += 2) {
+                write.value.push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), nullptr, 16));
+            }
+        }
+        if (!valid) {
+            fprintf(stderr, "MBED_HOST_BLE_WRITES: cannot parse \"%s\"\n", text.c_str());
+            continue;
+        }
+        writes.push_back(write);
+    }
+    return writes;
+}
+
+bool has_feature(const char *features, const char *feature)
+{
+    const char *found = strstr(features, feature);
+    size_t length = strlen(feature);
+    return found && (found == features || found[-1] == ',') && (found[length] == '\0' || found[length] == ',');
+}
+
+} // namespace
+
+/**
+ * The controller and host of the simulation. Centrals connect, exchange
+ * and take notifications at their connection events, which run from a
+ * Timeout per link under irq_mutex(), the lock of the whole stack. What
+ * the application is told goes through a queue that BLE::processEvents()
+ * empties, so the handlers run in the application's thread.
+ */
+class BleStack {
+public:
+    static BleStack &instance()
+    {
+        static BleStack *stack = new BleStack();
+        return *stack;
+    }
+
+    ble_error_t start(BLE &ble, BLE::InitializationCompleteCallback_t completion_cb, uint16_t att_mtu,
+                      uint16_t acl_buffer_size)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (_initialized) {
+            return BLE_ERROR_ALREADY_INITIALIZED;
+        }
+        _initialized = true;
+        _ble = &ble;
+        // the reassembly buffer bounds the MTU and the data length, see the cordio settings
+        _acl_buffer_size = std::max<uint16_t>(acl_buffer_size, lab::BLE_DEFAULT_DATA_LENGTH);
+        _att_mtu = std::max<uint16_t>(lab::BLE_DEFAULT_ATT_MTU, std::min<uint16_t>(att_mtu, _acl_buffer_size - 4));
+        uint64_t now = now_us();
+        for (std::unique_ptr<Central> &central : _centrals) {
+            Central *peer = central.get();
+            peer->timer.attach([this, peer] { central_due(peer); },
+                               std::chrono::microseconds(peer->connect_us > now ? peer->connect_us - now : 1));
+        }
+        post([this, completion_cb] {
+            if (completion_cb) {
+                BLE::InitializationCompleteCallbackContext context = { *_ble, BLE_ERROR_NONE };
+                completion_cb(&context);
+            }
+        });
+        return BLE_ERROR_NONE;
+    }
+
+    bool initialized()
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        return _initialized;
+    }
+
+    ble_error_t shutdown()
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (!_initialized) {
+            return BLE_ERROR_INITIALIZATION_INCOMPLETE;
+        }
+        for (std::unique_ptr<Central> &central : _centrals) {
+            central->timer.detach();
+        }
+        for (Link &link : _links) {
+            link.timer.detach();
+            link.open = false;
+        }
+        for (AdvertisingSet &set : _sets) {
+            set.timer.detach();
+            set.active = false;
+        }
+        _initialized = false;
+        _events.clear();
+        if (_server_handler) {
+            _server_handler->onShutdown(_ble->gattServer());
+        }
+        return BLE_ERROR_NONE;
+    }
+
+    void on_events(const BLE::OnEventsToProcessCallback_t &callback)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        _on_events = callback;
+    }
+
+    void process_events()
+    {
+        std::deque<std::function<void()> > events;
+        {
+            std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+            events.swap(_events);
+        }
+        for (std::function<void()> &event : events) {
+            event();
+        }
+    }
+
+    void set_gap_handler(Gap::EventHandler *handler)
+    {
+        _gap_handler = handler;
+    }
+
+    void set_server_handler(GattServer::EventHandler *handler)
+    {
+        _server_handler = handler;
+    }
+
+    void set_client_handler(GattClient::EventHandler *handler)
+    {
+        _client_handler = handler;
+    }
+
+    bool feature(controller_supported_features_t feature)
+    {
+        switch (feature.value()) {
+            case controller_supported_features_t::LE_2M_PHY:
+                return _feature_2m;
+            case controller_supported_features_t::LE_DATA_PACKET_LENGTH_EXTENSION:
+                return _feature_dle;
+            case controller_supported_features_t::LE_EXTENDED_ADVERTISING:
+                return _feature_extended;
+            case controller_supported_features_t::CONNECTION_PARAMETERS_REQUEST_PROCEDURE:
+            case controller_supported_features_t::EXTENDED_REJECT_INDICATION:
+            case controller_supported_features_t::SLAVE_INITIATED_FEATURES_EXCHANGE:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    uint16_t max_advertising_data()
+    {
+        return _feature_extended ? EXTENDED_DATA_MAX : LEGACY_DATA_MAX;
+    }
+
+    ble_error_t create_advertising_set(advertising_handle_t *handle, const AdvertisingParameters &parameters)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (!handle) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (!_feature_extended) {
+            return BLE_ERROR_OPERATION_NOT_PERMITTED;
+        }
+        for (int i = 1; i < MAX_ADVERTISING_SETS; i++) {
+            if (!_sets[i].created) {
+                ble_error_t error = configure(_sets[i], parameters);
+                if (error) {
+                    return error;
+                }
+                _sets[i].created = true;
+                _sets[i].payload.clear();
+                *handle = (advertising_handle_t)i;
+                return BLE_ERROR_NONE;
+            }
+        }
+        return BLE_ERROR_NO_MEM;
+    }
+
+    ble_error_t destroy_advertising_set(advertising_handle_t handle)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        AdvertisingSet *set = find_set(handle);
+        if (!set || handle == LEGACY_ADVERTISING_HANDLE) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (set->active) {
+            return BLE_ERROR_OPERATION_NOT_PERMITTED;
+        }
+        set->created = false;
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t set_advertising_parameters(advertising_handle_t handle, const AdvertisingParameters &parameters)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        AdvertisingSet *set = find_set(handle);
+        if (!set) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (set->active) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        if (handle == LEGACY_ADVERTISING_HANDLE && !parameters.getUseLegacyPDU()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        return configure(*set, parameters);
+    }
+
+    ble_error_t set_advertising_payload(advertising_handle_t handle, const uint8_t *payload, size_t length)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        AdvertisingSet *set = find_set(handle);
+        if (!set || (length && !payload)) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (length > (set->legacy ? LEGACY_DATA_MAX : EXTENDED_DATA_MAX)) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        // taken at the next advertising event, also while advertising
+        set->payload.assign(payload, payload + length);
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t start_advertising(advertising_handle_t handle)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (!_initialized) {
+            return BLE_ERROR_INITIALIZATION_INCOMPLETE;
+        }
+        AdvertisingSet *set = find_set(handle);
+        if (!set) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (set->active) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        set->active = true;
+        set->events = 0;
+        set->timer.attach([this, set] { advertising_event(*set); }, std::chrono::microseconds(1));
+        post([this, handle] {
+            if (_gap_handler) {
+                _gap_handler->onAdvertisingStart(AdvertisingStartEvent(handle));
+            }
+        });
+        if (set->connectable) {
+            for (std::unique_ptr<Central> &central : _centrals) {
+                Central *peer = central.get();
+                if (peer->waiting) {
+                    peer->timer.attach([this, peer] { central_due(peer); }, std::chrono::microseconds(SCAN_US));
+                }
+            }
+        }
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t stop_advertising(advertising_handle_t handle)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        AdvertisingSet *set = find_set(handle);
+        if (!set) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (!set->active) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        set->active = false;
+        set->timer.detach();
+        uint8_t events = (uint8_t)std::min<uint32_t>(set->events, 255);
+        post([this, handle, events] {
+            if (_gap_handler) {
+                _gap_handler->onAdvertisingEnd(AdvertisingEndEvent(handle, 0, events, false));
+            }
+        });
+        return BLE_ERROR_NONE;
+    }
+
+    bool advertising(advertising_handle_t handle)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        AdvertisingSet *set = find_set(handle);
+        return set && set->active;
+    }
+
+    ble_error_t update_parameters(connection_handle_t connection, uint32_t min_interval_us, uint32_t max_interval_us,
+                                  uint16_t latency, uint16_t timeout_10ms)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Link *link = find(connection);
+        if (!link) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        // ranges of the spec, and the timeout must outlast the events latency skips, twice over
+        if (min_interval_us < 7500 || max_interval_us > 4000000 || min_interval_us > max_interval_us ||
+            latency > 499 || timeout_10ms < 10 || timeout_10ms > 3200 ||
+            (uint64_t)timeout_10ms * 10000 <= (uint64_t)(1 + latency) * max_interval_us * 2) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (pending(*link, Procedure::PARAMETERS)) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        Procedure procedure = procedure_in(*link, Procedure::PARAMETERS,
+                                           link->central->reject ? REJECT_EVENTS : PARAMETERS_EVENTS);
+        procedure.min_interval_us = min_interval_us;
+        procedure.max_interval_us = max_interval_us;
+        procedure.latency = latency;
+        procedure.timeout_10ms = timeout_10ms;
+        schedule(*link, procedure);
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t read_phy(connection_handle_t connection)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Link *link = find(connection);
+        if (!link) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        phy_t tx = (phy_t::type)link->tx_phy;
+        phy_t rx = (phy_t::type)link->rx_phy;
+        post([this, connection, tx, rx] {
+            if (_gap_handler) {
+                _gap_handler->onReadPhy(BLE_ERROR_NONE, connection, tx, rx);
+            }
+        });
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t set_phy(connection_handle_t connection, uint8_t phys)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Link *link = find(connection);
+        if (!link) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if ((phys & phy_set_t::PHY_SET_CODED) || ((phys & phy_set_t::PHY_SET_2M) && !_feature_2m)) {
+            if (!(phys & phy_set_t::PHY_SET_1M)) {
+                return BLE_ERROR_NOT_IMPLEMENTED;
+            }
+        }
+        if (pending(*link, Procedure::PHY)) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        Procedure procedure = procedure_in(*link, Procedure::PHY, PHY_EVENTS);
+        procedure.phys = phys;
+        schedule(*link, procedure);
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t disconnect(connection_handle_t connection, disconnection_reason_t reason)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Link *link = find(connection);
+        if (!link) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        Procedure procedure = procedure_in(*link, Procedure::DISCONNECT, 1);
+        procedure.reason = reason.value();
+        schedule(*link, procedure);
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t negotiate_mtu(connection_handle_t connection)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Link *link = find(connection);
+        if (!link) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        // once per connection
+        if (link->mtu_exchanged || pending(*link, Procedure::MTU)) {
+            return BLE_ERROR_INVALID_STATE;
+        }
+        schedule(*link, procedure_in(*link, Procedure::MTU, MTU_EVENTS));
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t add_service(GattService &service)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (_attributes.size() + 1 + service._count * 4 > 0xFFFF) {
+            return BLE_ERROR_NO_MEM;
+        }
+        service._handle = add_attribute(Attribute::SERVICE, nullptr, nullptr, 0, 0);
+        for (unsigned i = 0; i < service._count; i++) {
+            GattCharacteristic *characteristic = service._characteristics[i];
+            GattAttribute &value = characteristic->getValueAttribute();
+            add_attribute(Attribute::DECLARATION, nullptr, nullptr, 0, 0);
+            value._handle = add_attribute(Attribute::VALUE, characteristic, value._value, value._length,
+                                          std::max(value._max_length, value._length));
+            if (characteristic->getProperties() & (GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY |
+                                                   GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_INDICATE)) {
+                add_attribute(Attribute::CCCD, characteristic, nullptr, 0, 0);
+            }
+            for (unsigned d = 0; d < characteristic->getDescriptorCount(); d++) {
+                GattAttribute *descriptor = characteristic->getDescriptor(d);
+                descriptor->_handle = add_attribute(Attribute::DESCRIPTOR, nullptr, descriptor->_value,
+                                                    descriptor->_length,
+                                                    std::max(descriptor->_max_length, descriptor->_length));
+            }
+        }
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t read(GattAttribute::Handle_t handle, uint8_t buffer[], uint16_t *length)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Attribute *attribute = find(handle);
+        if (!attribute || !length) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        uint16_t size = std::min<uint16_t>(*length, (uint16_t)attribute->value.size());
+        if (buffer && size) {
+            memcpy(buffer, attribute->value.data(), size);
+        }
+        *length = (uint16_t)attribute->value.size();
+        return BLE_ERROR_NONE;
+    }
+
+    ble_error_t write(connection_handle_t *connection, GattAttribute::Handle_t handle, const uint8_t *value,
+                      uint16_t size, bool local_only)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        Attribute *attribute = find(handle);
+        if (!attribute || (size && !value)) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        if (size > attribute->max_length) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        attribute->value.assign(value, value + size);
+        if (local_only || attribute->kind != Attribute::VALUE) {
+            return BLE_ERROR_NONE;
+        }
+        ble_error_t error = BLE_ERROR_NONE;
+        for (Link &link : _links) {
+            if (!link.open || (connection && handle_of(link) != *connection)) {
+                continue;
+            }
+            uint16_t cccd = configuration(link, (GattAttribute::Handle_t)(handle + 1));
+            if (!(cccd & (CCCD_NOTIFY | CCCD_INDICATE))) {
+                continue;
+            }
+            if (link.queue.size() >= TX_QUEUE) {
+                error = BLE_ERROR_NO_MEM;
+                continue;
+            }
+            // a notification carries att_mtu - 3 bytes of the value
+            Notification notification;
+            notification.handle = handle;
+            notification.indication = !(cccd & CCCD_NOTIFY);
+            notification.value.assign(value, value + std::min<uint16_t>(size, link.att_mtu - 3));
+            link.queue.push_back(notification);
+            arm(link, now_us());
+        }
+        return error;
+    }
+
+    ble_error_t updates_enabled(connection_handle_t *connection, const GattCharacteristic &characteristic,
+                                bool *enabled)
+    {
+        std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+        if (!enabled || !find(characteristic.getValueHandle())) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        *enabled = false;
+        for (Link &link : _links) {
+            if (link.open && (!connection || handle_of(link) == *connection) &&
+                configuration(link, (GattAttribute::Handle_t)(characteristic.getValueHandle() + 1))) {
+                *enabled = true;
+            }
+        }
+        return BLE_ERROR_NONE;
+    }
+
+private:
+    BleStack() :
+        _centrals(parse_centrals(setting("MBED_HOST_BLE", ""))),
+        _writes(parse_writes(setting("MBED_HOST_BLE_WRITES", ""))),
+        _initialized(false),
+        _feature_2m(has_feature(setting("MBED_HOST_BLE_FEATURES", "2m,dle"), "2m")),
+        _feature_dle(has_feature(setting("MBED_HOST_BLE_FEATURES", "2m,dle"), "dle")),
+        _feature_extended(has_feature(setting("MBED_HOST_BLE_FEATURES", "2m,dle"), "ext-adv")),
+        _address(setting("MBED_HOST_BLE_ADDRESS", "c0:de:00:00:00:01")),
+        _scan(nullptr),
+        _scan_loss(atoi(setting("MBED_HOST_BLE_SCAN_LOSS", "0"))),
+        _random(1),
+        _att_mtu(lab::BLE_DEFAULT_ATT_MTU),
+        _acl_buffer_size(lab::BLE_DEFAULT_DATA_LENGTH),
+        _ble(nullptr),
+        _gap_handler(nullptr),
+        _server_handler(nullptr),
+        _client_handler(nullptr)
+    {
+        _sets[LEGACY_ADVERTISING_HANDLE].created = true;
+        const char *scan = setting("MBED_HOST_BLE_SCAN", "");
+        if (*scan) {
+            _scan = fopen(scan, "w");
+            if (!_scan) {
+                fprintf(stderr, "MBED_HOST_BLE_SCAN: cannot open %s\n", scan);
+            }
+        }
+    }
+
+    AdvertisingSet *find_set(advertising_handle_t handle)
+    {
+        return handle < MAX_ADVERTISING_SETS && _sets[handle].created ? &_sets[handle] : nullptr;
+    }
+
+    static ble_error_t configure(AdvertisingSet &set, const AdvertisingParameters &parameters)
+    {
+        bool connectable = parameters.getType().value() != advertising_type_t::NON_CONNECTABLE_UNDIRECTED;
+        // the centrals only connect to legacy advertising
+        if (connectable && !parameters.getUseLegacyPDU()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        uint32_t interval_us = parameters.getMinPrimaryInterval().valueInUs();
+        if (interval_us < 20000 || interval_us > parameters.getMaxPrimaryInterval().valueInUs()) {
+            return BLE_ERROR_INVALID_PARAM;
+        }
+        set.connectable = connectable;
+        set.legacy = parameters.getUseLegacyPDU();
+        set.interval_us = interval_us;
+        return BLE_ERROR_NONE;
+    }
+
+    uint32_t random()
+    {
+        _random = _random * 1103515245u + 12345u;
+        return _random >> 8;
+    }
+
+    /**
+     * An advertising event: with MBED_HOST_BLE_SCAN, a scanner that
+     * listens all the time writes a report of it, one line
+     * "time_us address rssi legacy|extended payload-hex", and misses
+     * MBED_HOST_BLE_SCAN_LOSS percent of them.
+     */
+    void advertising_event(AdvertisingSet &set)
+    {
+        if (!set.active) {
+            return;
+        }
+        set.events++;
+        if (_scan && !set.payload.empty() && random() % 100 >= (uint32_t)_scan_loss) {
+            fprintf(_scan, "%llu %s -60 %s ", (unsigned long long)now_us(), _address.c_str(),
+                    set.legacy ? "legacy" : "extended");
+            for (uint8_t byte : set.payload) {
+                fprintf(_scan, "%02x", byte);
+            }
+            fputc('\n', _scan);
+            fflush(_scan);
+        }
+        AdvertisingSet *target = &set;
+        set.timer.attach([this, target] { advertising_event(*target); },
+                         std::chrono::microseconds(set.interval_us + random() % (ADV_DELAY_MAX_US + 1)));
+    }
+
+    bool connectable_advertising()
+    {
+        const AdvertisingSet &set = _sets[LEGACY_ADVERTISING_HANDLE];
+        return set.active && set.connectable;
+    }
+
+    /** Queue an event for processEvents(), signalling the first one. */
+    void post(std::function<void()> event)
+    {
+        bool first = _events.empty();
+        _events.push_back(std::move(event));
+        if (first && _on_events && _ble) {
+            BLE::OnEventsToProcessCallbackContext context = { *_ble };
+            _on_events(&context);
+        }
+    }
+
+    static connection_handle_t handle_of(const Link &link)
+    {
+        return (connection_handle_t)(&link - &instance()._links[0] + 1);
+    }
+
+    Link *find(connection_handle_t connection)
+    {
+        if (connection < 1 || connection > MAX_LINKS || !_links[connection - 1].open) {
+            return nullptr;
+        }
+        return &_links[connection - 1];
+    }
+
+    Attribute *find(GattAttribute::Handle_t handle)
+    {
+        return handle >= 1 && handle <= _attributes.size() ? &_attributes[handle - 1] : nullptr;
+    }
+
+    GattAttribute::Handle_t add_attribute(Attribute::Kind kind, GattCharacteristic *characteristic,
+                                          const uint8_t *value, uint16_t length, uint16_t max_length)
+    {
+        Attribute attribute;
+        attribute.kind = kind;
+        attribute.characteristic = characteristic;
+        if (value) {
+            attribute.value.assign(value, value + length);
+        }
+        attribute.max_length = max_length;
+        _attributes.push_back(attribute);
+        return (GattAttribute::Handle_t)_attributes.size();
+    }
+
+    static uint16_t configuration(const Link &link, GattAttribute::Handle_t cccd)
+    {
+        for (const std::pair<GattAttribute::Handle_t, uint16_t> &entry : link.cccds) {
+            if (entry.first == cccd) {
+                return entry.second;
+            }
+        }
+        return 0;
+    }
+
+    /** First connection event at or after time_us. */
+    static uint64_t event_at(const Link &link, uint64_t time_us)
+    {
+        if (time_us <= link.anchor_us) {
+            return link.anchor_us;
+        }
+        uint64_t events = (time_us - link.anchor_us + link.interval_us - 1) / link.interval_us;
+        return link.anchor_us + events * link.interval_us;
+    }
+
+    /** A procedure answered events connection events after the next one. */
+    Procedure procedure_in(const Link &link, Procedure::Kind kind, int events)
+    {
+        Procedure procedure = Procedure();
+        procedure.kind = kind;
+        procedure.due_us = event_at(link, now_us() + 1) + (uint64_t)events * link.interval_us;
+        return procedure;
+    }
+
+    static bool pending(const Link &link, Procedure::Kind kind)
+    {
+        for (const Procedure &procedure : link.procedures) {
+            if (procedure.kind == kind) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void schedule(Link &link, const Procedure &procedure)
+    {
+        link.procedures.push_back(procedure);
+        arm(link, now_us());
+    }
+
+    /** Set the link's timer on its next work: a procedure, or notifications to send. */
+    void arm(Link &link, uint64_t after_us)
+    {
+        uint64_t due = UINT64_MAX;
+        for (const Procedure &procedure : link.procedures) {
+            due = std::min(due, procedure.due_us);
+        }
+        if (!link.queue.empty()) {
+            due = std::min(due, event_at(link, after_us));
+        }
+        if (due == UINT64_MAX) {
+            link.timer.detach();
+            link.timer_due_us = UINT64_MAX;
+            return;
+        }
+        if (link.timer_due_us == due) {
+            return;
+        }
+        link.timer_due_us = due;
+        uint64_t now = now_us();
+        Link *target = &link;
+        link.timer.attach([this, target] { link_due(*target); },
+                          std::chrono::microseconds(due > now ? due - now : 1));
+    }
+
+    void central_due(Central *central)
+    {
+        if (central->connected || now_us() >= central->disconnect_us) {
+            return;
+        }
+        Link *link = nullptr;
+        for (Link &candidate : _links) {
+            if (!candidate.open) {
+                link = &candidate;
+                break;
+            }
+        }
+        if (!connectable_advertising() || !link) {
+            central->waiting = true;
+            return;
+        }
+        central->waiting = false;
+        central->connected = true;
+        connect(*link, *central);
+    }
+
+    void connect(Link &link, Central &central)
+    {
+        uint64_t now = now_us();
+        link.open = true;
+        link.central = &central;
+        link.anchor_us = now;
+        link.interval_us = central.interval_us;
+        link.latency = 0;
+        link.timeout_10ms = CONNECT_TIMEOUT_10MS;
+        link.tx_phy = lab::BLE_PHY_1M;
+        link.rx_phy = lab::BLE_PHY_1M;
+        link.data_length = lab::BLE_DEFAULT_DATA_LENGTH;
+        link.att_mtu = lab::BLE_DEFAULT_ATT_MTU;
+        link.mtu_exchanged = false;
+        link.cccds.clear();
+        link.queue.clear();
+        link.procedures.clear();
+        link.notifications = 0;
+        link.bytes = 0;
+        link.timer_due_us = UINT64_MAX;
+        _sets[LEGACY_ADVERTISING_HANDLE].active = false;
+        _sets[LEGACY_ADVERTISING_HANDLE].timer.detach();
+
+        connection_handle_t handle = handle_of(link);
+        if (tracing("ble")) {
+            trace("ble: %s connected, handle %u, interval %.2f ms", central.name.c_str(), (unsigned)handle,
+                  link.interval_us / 1000.0);
+        }
+
+        uint8_t bytes[6] = { 0 };
+        for (size_t i = 0; i < central.name.size(); i++) {
+            bytes[i % 5] = (uint8_t)(bytes[i % 5] * 31 + central.name[i]);
+        }
+        bytes[5] = 0xC0;
+        ConnectionCompleteEvent event(BLE_ERROR_NONE, handle, connection_role_t::PERIPHERAL,
+                                      peer_address_type_t::RANDOM, address_t(bytes),
+                                      conn_interval_t((uint16_t)(link.interval_us / 1250)), 0,
+                                      supervision_timeout_t(link.timeout_10ms));
+        post([this, handle, event] {
+            if (_gap_handler) {
+                _gap_handler->onAdvertisingEnd(AdvertisingEndEvent(LEGACY_ADVERTISING_HANDLE, handle, 0, true));
+                _gap_handler->onConnectionComplete(event);
+            }
+        });
+
+        // both controllers exchange their data length right away
+        if (_feature_dle && central.dle && _acl_buffer_size > lab::BLE_DEFAULT_DATA_LENGTH) {
+            schedule(link, procedure_in(link, Procedure::DATA_LENGTH, DATA_LENGTH_EVENTS));
+        }
+        if (central.subscribe) {
+            schedule(link, procedure_in(link, Procedure::SUBSCRIBE, SUBSCRIBE_EVENTS));
+        }
+        for (size_t i = 0; i < _writes.size(); i++) {
+            const ScriptedWrite &write = _writes[i];
+            if (write.central == central.name && write.at_us >= now && write.at_us < central.disconnect_us) {
+                Procedure procedure = Procedure();
+                procedure.kind = Procedure::WRITE;
+                procedure.due_us = event_at(link, write.at_us);
+                procedure.write = i;
+                link.procedures.push_back(procedure);
+            }
+        }
+        if (central.disconnect_us != UINT64_MAX) {
+            Procedure procedure = Procedure();
+            procedure.kind = Procedure::DISCONNECT;
+            procedure.due_us = std::max(central.disconnect_us, now + 1);
+            procedure.reason = disconnection_reason_t::REMOTE_USER_TERMINATED_CONNECTION;
+            schedule(link, procedure);
+        }
+    }
+
+    void link_due(Link &link)
+    {
+        uint64_t now = link.timer_due_us;
+        link.timer_due_us = UINT64_MAX;
+
+        std::stable_sort(link.procedures.begin(), link.procedures.end(),
+                         [](const Procedure &a, const Procedure &b) {
+            return a.due_us < b.due_us;
+        });
+        while (link.open && !link.procedures.empty() && link.procedures.front().due_us <= now) {
+            Procedure procedure = link.procedures.front();
+            link.procedures.erase(link.procedures.begin());
+            complete(link, procedure);
+        }
+        if (!link.open) {
+            return;
+        }
+
+        if (!link.queue.empty() && event_at(link, now) == now) {
+            transmit(link);
+        }
+        arm(link, now + 1);
+    }
+
+    /** One connection event: notifications while they fit the time the central gives it. */
+    void transmit(Link &link)
+    {
+        uint32_t budget = link.central->event_us ? std::min(link.central->event_us, link.interval_us) :
+                                                   link.interval_us;
+        // the event starts with the central's empty packet
+        uint32_t used = lab::ble_exchange_us(0, link.rx_phy);
+        connection_handle_t handle = handle_of(link);
+        while (!link.queue.empty()) {
+            const Notification &notification = link.queue.front();
+            uint32_t air = lab::ble_notification_us((uint16_t)notification.value.size(), link.tx_phy,
+                                                    link.data_length);
+            if (used + air > budget) {
+                break;
+            }
+            used += air;
+            link.notifications++;
+            link.bytes += notification.value.size();
+            GattDataSentCallbackParams params = { handle, notification.handle };
+            bool indication = notification.indication;
+            post([this, params, indication] {
+                if (_server_handler) {
+                    _server_handler->onDataSent(params);
+                    // confirmed within the event
+                    if (indication) {
+                        _server_handler->onConfirmationReceived(params);
+                    }
+                }
+            });
+            link.queue.pop_front();
+        }
+    }
+
+    void complete(Link &link, const Procedure &procedure)
+    {
+        connection_handle_t handle = handle_of(link);
+        Central &central = *link.central;
+        switch (procedure.kind) {
+            case Procedure::MTU: {
+                link.mtu_exchanged = true;
+                link.att_mtu = std::min(_att_mtu, central.mtu);
+                uint16_t mtu = link.att_mtu;
+                if (tracing("ble")) {
+                    trace("ble: %s ATT MTU %u", central.name.c_str(), mtu);
+                }
+                post([this, handle, mtu] {
+                    if (_server_handler) {
+                        _server_handler->onAttMtuChange(handle, mtu);
+                    }
+                    if (_client_handler) {
+                        _client_handler->onAttMtuChange(handle, mtu);
+                    }
+                });
+                break;
+            }
+            case Procedure::DATA_LENGTH: {
+                link.data_length = std::min<uint16_t>(lab::BLE_MAX_DATA_LENGTH, _acl_buffer_size);
+                uint16_t length = link.data_length;
+                if (tracing("ble")) {
+                    trace("ble: %s data length %u", central.name.c_str(), length);
+                }
+                post([this, handle, length] {
+                    if (_gap_handler) {
+                        _gap_handler->onDataLengthChange(handle, length, length);
+                    }
+                });
+                break;
+            }
+            case Procedure::PHY: {
+                // the central takes 2M when both can, and 1M when asked for
+                if ((procedure.phys & phy_set_t::PHY_SET_2M) && _feature_2m && central.phy_2m) {
+                    link.tx_phy = link.rx_phy = lab::BLE_PHY_2M;
+                } else if (procedure.phys & phy_set_t::PHY_SET_1M) {
+                    link.tx_phy = link.rx_phy = lab::BLE_PHY_1M;
+                }
+                phy_t tx = (phy_t::type)link.tx_phy;
+                phy_t rx = (phy_t::type)link.rx_phy;
+                if (tracing("ble")) {
+                    trace("ble: %s PHY %s", central.name.c_str(), lab::ble_phy_name(link.tx_phy));
+                }
+                post([this, handle, tx, rx] {
+                    if (_gap_handler) {
+                        _gap_handler->onPhyUpdateComplete(BLE_ERROR_NONE, handle, tx, rx);
+                    }
+                });
+                break;
+            }
+            case Procedure::PARAMETERS: {
+                ble_error_t status = BLE_ERROR_NONE;
+                uint32_t interval = std::max(procedure.min_interval_us, central.min_interval_us);
+                if (central.reject || interval > procedure.max_interval_us ||
+                    procedure.latency > central.max_latency) {
+                    status = BLE_ERROR_UNSPECIFIED;
+                } else {
+                    // the new interval counts from the instant
+                    link.anchor_us = procedure.due_us;
+                    link.interval_us = interval;
+                    link.latency = procedure.latency;
+                    link.timeout_10ms = procedure.timeout_10ms;
+                }
+                if (tracing("ble")) {
+                    trace("ble: %s %s interval %.2f ms, latency %u, timeout %u ms", central.name.c_str(),
+                          status == BLE_ERROR_NONE ? "took" : "rejected",
+                          (status == BLE_ERROR_NONE ? interval : procedure.max_interval_us) / 1000.0,
+                          procedure.latency, procedure.timeout_10ms * 10u);
+                }
+                ConnectionParametersUpdateCompleteEvent event(status, handle,
+                                                              conn_interval_t((uint16_t)(link.interval_us / 1250)),
+                                                              link.latency, supervision_timeout_t(link.timeout_10ms));
+                post([this, event] {
+                    if (_gap_handler) {
+                        _gap_handler->onConnectionParametersUpdateComplete(event);
+                    }
+                });
+                break;
+            }
+            case Procedure::SUBSCRIBE:
+                // discovery done, the central enables every notification and indication
+                for (size_t i = 0; i < _attributes.size(); i++) {
+                    const Attribute &attribute = _attributes[i];
+                    if (attribute.kind != Attribute::CCCD) {
+                        continue;
+                    }
+                    uint8_t properties = attribute.characteristic->getProperties();
+                    uint16_t cccd = (properties & GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_NOTIFY) ?
+                                    CCCD_NOTIFY : CCCD_INDICATE;
+                    link.cccds.push_back(std::make_pair((GattAttribute::Handle_t)(i + 1), cccd));
+                    GattUpdatesEnabledCallbackParams params = { handle, (GattAttribute::Handle_t)(i + 1),
+                                                                attribute.characteristic->getValueHandle() };
+                    post([this, params] {
+                        if (_server_handler) {
+                            _server_handler->onUpdatesEnabled(params);
+                        }
+                    });
+                }
+                break;
+            case Procedure::WRITE: {
+                const ScriptedWrite &write = _writes[procedure.write];
+                Attribute *attribute = find(write.handle);
+                if (!attribute || attribute->kind != Attribute::VALUE ||
+                    !(attribute->characteristic->getProperties() &
+                      GattCharacteristic::BLE_GATT_CHAR_PROPERTIES_WRITE_WITHOUT_RESPONSE) ||
+                    write.value.size() > attribute->max_length || write.value.size() > link.att_mtu - 3u) {
+                    fprintf(stderr, "MBED_HOST_BLE_WRITES: %s cannot write %u bytes to handle %u\n",
+                            central.name.c_str(), (unsigned)write.value.size(), (unsigned)write.handle);
+                    break;
+                }
+                if (tracing("ble")) {
+                    trace("ble: %s writes %u bytes to handle %u", central.name.c_str(), (unsigned)write.value.size(),
+                          (unsigned)write.handle);
+                }
+                size_t index = procedure.write;
+                post([this, handle, index] { deliver(handle, _writes[index]); });
+                break;
+            }
+            case Procedure::DISCONNECT: {
+                disconnection_reason_t reason = (disconnection_reason_t::type)procedure.reason;
+                if (tracing("ble")) {
+                    trace("ble: %s disconnected, %llu notifications, %llu bytes", central.name.c_str(),
+                          (unsigned long long)link.notifications, (unsigned long long)link.bytes);
+                }
+                link.open = false;
+                link.timer.detach();
+                link.queue.clear();
+                link.procedures.clear();
+                post([this, handle, reason] {
+                    if (_gap_handler) {
+                        _gap_handler->onDisconnectionComplete(DisconnectionCompleteEvent(handle, reason));
+                    }
+                });
+                break;
+            }
+        }
+    }
+
+    /** A write command reaching the server, from processEvents(). */
+    void deliver(connection_handle_t connection, const ScriptedWrite &write)
+    {
+        GattCharacteristic *characteristic;
+        {
+            std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+            Attribute *attribute = find(write.handle);
+            if (!attribute) {
+                return;
+            }
+            characteristic = attribute->characteristic;
+        }
+        // a write command gets no answer, one turned down is dropped
+        if (characteristic->isWriteAuthorizationEnabled()) {
+            GattWriteAuthCallbackParams auth = { connection, write.handle, 0, (uint16_t)write.value.size(),
+                                                 write.value.data(), AUTH_CALLBACK_REPLY_SUCCESS };
+            if (characteristic->authorizeWrite(&auth) != AUTH_CALLBACK_REPLY_SUCCESS) {
+                return;
+            }
+        }
+        {
+            std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+            find(write.handle)->value = write.value;
+        }
+        GattWriteCallbackParams params = { connection, write.handle, GattWriteCallbackParams::OP_WRITE_CMD, 0,
+                                           (uint16_t)write.value.size(), write.value.data() };
+        if (_server_handler) {
+            _server_handler->onDataWritten(params);
+        }
+    }
+
+    std::vector<std::unique_ptr<Central> > _centrals;
+    std::vector<ScriptedWrite> _writes;
+    Link _links[MAX_LINKS];
+    std::vector<Attribute> _attributes;
+    std::deque<std::function<void()> > _events;
+    AdvertisingSet _sets[MAX_ADVERTISING_SETS];
+    bool _initialized;
+    bool _feature_2m;
+    bool _feature_dle;
+    bool _feature_extended;
+    std::string _address;
+    FILE *_scan;
+    int _scan_loss;
+    uint32_t _random;
+    uint16_t _att_mtu;
+    uint16_t _acl_buffer_size;
+    BLE *_ble;
+    BLE::OnEventsToProcessCallback_t _on_events;
+    Gap::EventHandler *_gap_handler;
+    GattServer::EventHandler *_server_handler;
+    GattClient::EventHandler *_client_handler;
+};
+
+} // namespace mbed_host
+
+namespace ble {
+
+BLE &BLE::Instance(InstanceID_t id)
+{
+    static BLE *ble = new BLE();
+    (void)id;
+    return *ble;
+}
+
+ble_error_t BLE::start(InitializationCompleteCallback_t completion_cb, uint16_t att_mtu, uint16_t acl_buffer_size)
+{
+    return mbed_host::BleStack::instance().start(*this, completion_cb, att_mtu, acl_buffer_size);
+}
+
+bool BLE::hasInitialized() const
+{
+    return mbed_host::BleStack::instance().initialized();
+}
+
+ble_error_t BLE::shutdown()
+{
+    return mbed_host::BleStack::instance().shutdown();
+}
+
+void BLE::onEventsToProcess(const OnEventsToProcessCallback_t &on_event_processing_callback)
+{
+    mbed_host::BleStack::instance().on_events(on_event_processing_callback);
+}
+
+void BLE::processEvents()
+{
+    mbed_host::BleStack::instance().process_events();
+}
+
+void Gap::setEventHandler(EventHandler *handler)
+{
+    mbed_host::BleStack::instance().set_gap_handler(handler);
+}
+
+bool Gap::isFeatureSupported(controller_supported_features_t feature)
+{
+    return mbed_host::BleStack::instance().feature(feature);
+}
+
+uint8_t Gap::getMaxAdvertisingSetNumber()
+{
+    return mbed_host::MAX_ADVERTISING_SETS;
+}
+
+uint16_t Gap::getMaxAdvertisingDataLength()
+{
+    return mbed_host::BleStack::instance().max_advertising_data();
+}
+
+ble_error_t Gap::createAdvertisingSet(advertising_handle_t *handle, const AdvertisingParameters &parameters)
+{
+    return mbed_host::BleStack::instance().create_advertising_set(handle, parameters);
+}
+
+ble_error_t Gap::destroyAdvertisingSet(advertising_handle_t handle)
+{
+    return mbed_host::BleStack::instance().destroy_advertising_set(handle);
+}
+
+ble_error_t Gap::setAdvertisingParameters(advertising_handle_t handle, const AdvertisingParameters &params)
+{
+    return mbed_host::BleStack::instance().set_advertising_parameters(handle, params);
+}
+
+ble_error_t Gap::setAdvertisingPayload(advertising_handle_t handle, mbed::Span<const uint8_t> payload)
+{
+    return mbed_host::BleStack::instance().set_advertising_payload(handle, payload.data(), (size_t)payload.size());
+}
+
+ble_error_t Gap::startAdvertising(advertising_handle_t handle)
+{
+    return mbed_host::BleStack::instance().start_advertising(handle);
+}
+
+ble_error_t Gap::stopAdvertising(advertising_handle_t handle)
+{
+    return mbed_host::BleStack::instance().stop_advertising(handle);
+}
+
+bool Gap::isAdvertisingActive(advertising_handle_t handle)
+{
+    return mbed_host::BleStack::instance().advertising(handle);
+}
+
+ble_error_t Gap::updateConnectionParameters(connection_handle_t connectionHandle,
+                                            conn_interval_t minConnectionInterval,
+                                            conn_interval_t maxConnectionInterval, slave_latency_t slaveLatency,
+                                            supervision_timeout_t supervisionTimeout,
+                                            conn_event_length_t minConnectionEventLength,
+                                            conn_event_length_t maxConnectionEventLength)
+{
+    (void)minConnectionEventLength;
+    (void)maxConnectionEventLength;
+    return mbed_host::BleStack::instance().update_parameters(connectionHandle, minConnectionInterval.valueInUs(),
+                                                             maxConnectionInterval.valueInUs(), slaveLatency,
+                                                             supervisionTimeout.value());
+}
+
+ble_error_t Gap::readPhy(connection_handle_t connection)
+{
+    return mbed_host::BleStack::instance().read_phy(connection);
+}
+
+ble_error_t Gap::setPreferredPhys(const phy_set_t *txPhys, const phy_set_t *rxPhys)
+{
+    // only peripheral initiated updates are simulated, preferences change nothing
+    (void)txPhys;
+    (void)rxPhys;
+    return BLE_ERROR_NONE;
+}
+
+ble_error_t Gap::setPhy(connection_handle_t connection, const phy_set_t *txPhys, const phy_set_t *rxPhys,
+                        coded_symbol_per_bit_t codedSymbol)
+{
+    (void)codedSymbol;
+    uint8_t phys = (txPhys ? txPhys->value() : 0) | (rxPhys ? rxPhys->value() : 0);
+    return mbed_host::BleStack::instance().set_phy(connection, phys ? phys : phy_set_t::PHY_SET_1M);
+}
+
+ble_error_t Gap::disconnect(connection_handle_t connectionHandle, disconnection_reason_t reason)
+{
+    return mbed_host::BleStack::instance().disconnect(connectionHandle, reason);
+}
+
+void GattServer::setEventHandler(EventHandler *handler)
+{
+    mbed_host::BleStack::instance().set_server_handler(handler);
+}
+
+ble_error_t GattServer::addService(GattService &service)
+{
+    return mbed_host::BleStack::instance().add_service(service);
+}
+
+ble_error_t GattServer::read(GattAttribute::Handle_t attributeHandle, uint8_t buffer[], uint16_t *lengthP)
+{
+    return mbed_host::BleStack::instance().read(attributeHandle, buffer, lengthP);
+}
+
+ble_error_t GattServer::read(connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle,
+                             uint8_t buffer[], uint16_t *lengthP)
+{
+    (void)connectionHandle;
+    return mbed_host::BleStack::instance().read(attributeHandle, buffer, lengthP);
+}
+
+ble_error_t GattServer::write(GattAttribute::Handle_t attributeHandle, const uint8_t *value, uint16_t size,
+                              bool localOnly)
+{
+    return mbed_host::BleStack::instance().write(nullptr, attributeHandle, value, size, localOnly);
+}
+
+ble_error_t GattServer::write(connection_handle_t connectionHandle, GattAttribute::Handle_t attributeHandle,
+                              const uint8_t *value, uint16_t size, bool localOnly)
+{
+    return mbed_host::BleStack::instance().write(&connectionHandle, attributeHandle, value, size, localOnly);
+}
+
+ble_error_t GattServer::areUpdatesEnabled(const GattCharacteristic &characteristic, bool *enabledP)
+{
+    return mbed_host::BleStack::instance().updates_enabled(nullptr, characteristic, enabledP);
+}
+
+ble_error_t GattServer::areUpdatesEnabled(connection_handle_t connectionHandle,
+                                          const GattCharacteristic &characteristic, bool *enabledP)
+{
+    return mbed_host::BleStack::instance().updates_enabled(&connectionHandle, characteristic, enabledP);
+}
+
+void GattClient::setEventHandler(EventHandler *handler)
+{
+    mbed_host::BleStack::instance().set_client_handler(handler);
+}
+
+ble_error_t GattClient::negotiateAttMtu(connection_handle_t connection)
+{
+    return mbed_host::BleStack::instance().negotiate_mtu(connection);
+}
+
+} // namespace ble
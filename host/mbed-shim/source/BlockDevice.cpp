@@ -0,0 +1,124 @@
+#include "blockdevice/HostFlashBlockDevice.h"
+
+#include <cstring>
+
+#include "host/HostRuntime.h"
+
+namespace mbed {
+
+HostFlashBlockDevice::HostFlashBlockDevice(bd_size_t size, bd_size_t erase_size, const char *path) :
+    _size(size),
+    _erase_size(erase_size),
+    _path(path),
+    _file(nullptr),
+    _init_count(0)
+{
+}
+
+HostFlashBlockDevice::~HostFlashBlockDevice()
+{
+    if (_file) {
+        fclose(_file);
+    }
+}
+
+int HostFlashBlockDevice::init()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_init_count++) {
+        return BD_ERROR_OK;
+    }
+
+    _data.assign(_size, 0xFF);
+    if (!_path) {
+        return BD_ERROR_OK;
+    }
+    _file = fopen(_path, "r+b");
+    if (_file) {
+        size_t loaded = fread(_data.data(), 1, _size, _file);
+        (void)loaded;
+    } else {
+        _file = fopen(_path, "w+b");
+    }
+    if (!_file) {
+        _init_count = 0;
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    // a short or new file reads as erased flash
+    write_through(0, _size);
+    return BD_ERROR_OK;
+}
+
+int HostFlashBlockDevice::deinit()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_init_count || --_init_count) {
+        return BD_ERROR_OK;
+    }
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    return BD_ERROR_OK;
+}
+
+bool HostFlashBlockDevice::in_range(bd_addr_t addr, bd_size_t size) const
+{
+    return _init_count && addr <= _size && size <= _size - addr;
+}
+
+void HostFlashBlockDevice::write_through(bd_addr_t addr, bd_size_t size)
+{
+    if (!_file || !size) {
+        return;
+    }
+    if (fseek(_file, (long)addr, SEEK_SET) == 0) {
+        fwrite(_data.data() + addr, 1, size, _file);
+        fflush(_file);
+    }
+}
+
+int HostFlashBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!in_range(addr, size)) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    memcpy(buffer, _data.data() + addr, size);
+    return BD_ERROR_OK;
+}
+
+int HostFlashBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!in_range(addr, size)) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    // NOR programming only takes bits from 1 to 0
+    const uint8_t *bytes = (const uint8_t *)buffer;
+    for (bd_size_t i = 0; i < size; i++) {
+        _data[addr + i] &= bytes[i];
+    }
+    write_through(addr, size);
+    return BD_ERROR_OK;
+}
+
+int HostFlashBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!in_range(addr, size) || addr % _erase_size || size % _erase_size) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    memset(_data.data() + addr, 0xFF, size);
+    write_through(addr, size);
+    return BD_ERROR_OK;
+}
+
+BlockDevice *BlockDevice::get_default_instance()
+{
+    // 64 Mbit with 4 KB sectors, as on the board
+    static HostFlashBlockDevice flash(8 * 1024 * 1024, 4096, mbed_host::setting("MBED_HOST_FLASH"));
+    return &flash;
+}
+
+} // namespace mbed
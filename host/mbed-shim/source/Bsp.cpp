@@ -0,0 +1,220 @@
+#include "stm32l475e_iot01.h"
+#include "stm32l475e_iot01_accelero.h"
+#include "stm32l475e_iot01_gyro.h"
+#include "stm32l475e_iot01_hsensor.h"
+#include "stm32l475e_iot01_magneto.h"
+#include "stm32l475e_iot01_psensor.h"
+#include "stm32l475e_iot01_tsensor.h"
+
+#include <cmath>
+#include <mutex>
+
+#include "SimulatedLsm6dsl.h"
+#include "hal/us_ticker_api.h"
+#include "host/HostRuntime.h"
+
+/*
+ * The board sensors as slow sine waves around plausible values, so the
+ * printed reports move. The LSM6DSL on the sensor I2C bus is the
+ * register model of lab-utils, which the FIFO code runs against.
+ */
+
+namespace {
+
+const float PI = 3.14159265f;
+
+/** Offset plus a sine of the given period, phase shifted per axis. */
+float wave(float offset, float amplitude, float period_s, int axis = 0)
+{
+    float t = mbed_host::now_us() / 1e6f;
+    return offset + amplitude * sinf(2.0f * PI * t / period_s + axis * 2.0f * PI / 3.0f);
+}
+
+std::mutex &bus_mutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+lab::SimulatedLsm6dsl &lsm6dsl()
+{
+    static lab::SimulatedLsm6dsl device;
+    return device;
+}
+
+/** Register address last written to the LSM6DSL over mbed::I2C. */
+uint8_t lsm6dsl_pointer;
+
+} // namespace
+
+namespace mbed_host {
+
+// SENSOR_IO and mbed::I2C on the pins of I2C2 reach the same LSM6DSL
+
+int i2c_write(PinName sda, int address, const char *data, int length)
+{
+    if (sda != PB_11 || (address & ~1) != lab::Lsm6dslFifo::I2C_ADDRESS || length < 1) {
+        return 1;
+    }
+    std::lock_guard<std::mutex> lock(bus_mutex());
+    lsm6dsl_pointer = (uint8_t)data[0];
+    if (length > 1) {
+        lsm6dsl().advance_to(us_ticker_read());
+        lsm6dsl().write(lsm6dsl_pointer, reinterpret_cast<const uint8_t *>(data + 1), length - 1);
+    }
+    return 0;
+}
+
+int i2c_read(PinName sda, int address, char *data, int length)
+{
+    if (sda != PB_11 || (address & ~1) != lab::Lsm6dslFifo::I2C_ADDRESS) {
+        return 1;
+    }
+    // every read of I2cRegisterBus writes its register first, so the
+    // pointer needs no auto-increment here
+    std::lock_guard<std::mutex> lock(bus_mutex());
+    lsm6dsl().advance_to(us_ticker_read());
+    return lsm6dsl().read(lsm6dsl_pointer, reinterpret_cast<uint8_t *>(data), length) ? 1 : 0;
+}
+
+} // namespace mbed_host
+
+extern "C" {
+
+void SENSOR_IO_Init(void)
+{
+}
+
+void SENSOR_IO_Write(uint8_t Addr, uint8_t Reg, uint8_t Value)
+{
+    SENSOR_IO_WriteMultiple(Addr, Reg, &Value, 1);
+}
+
+uint8_t SENSOR_IO_Read(uint8_t Addr, uint8_t Reg)
+{
+    uint8_t value = 0;
+    SENSOR_IO_ReadMultiple(Addr, Reg, &value, 1);
+    return value;
+}
+
+uint16_t SENSOR_IO_ReadMultiple(uint8_t Addr, uint8_t Reg, uint8_t *Buffer, uint16_t Length)
+{
+    // only the LSM6DSL answers, anything else is a bus error like a NACK
+    if (Addr != lab::Lsm6dslFifo::I2C_ADDRESS) {
+        return 1;
+    }
+    std::lock_guard<std::mutex> lock(bus_mutex());
+    lsm6dsl().advance_to(us_ticker_read());
+    return lsm6dsl().read(Reg, Buffer, Length) ? 1 : 0;
+}
+
+void SENSOR_IO_WriteMultiple(uint8_t Addr, uint8_t Reg, uint8_t *Buffer, uint16_t Length)
+{
+    if (Addr != lab::Lsm6dslFifo::I2C_ADDRESS) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(bus_mutex());
+    lsm6dsl().advance_to(us_ticker_read());
+    lsm6dsl().write(Reg, Buffer, Length);
+}
+
+void SENSOR_IO_Delay(uint32_t Delay)
+{
+    mbed_host::sleep_until(mbed_host::now_us() + (uint64_t)Delay * 1000);
+}
+
+uint32_t BSP_TSENSOR_Init(void)
+{
+    return TSENSOR_OK;
+}
+
+float BSP_TSENSOR_ReadTemp(void)
+{
+    return wave(24.0f, 1.5f, 60.0f);
+}
+
+uint32_t BSP_HSENSOR_Init(void)
+{
+    return HSENSOR_OK;
+}
+
+float BSP_HSENSOR_ReadHumidity(void)
+{
+    return wave(45.0f, 5.0f, 90.0f);
+}
+
+uint32_t BSP_PSENSOR_Init(void)
+{
+    return PSENSOR_OK;
+}
+
+float BSP_PSENSOR_ReadPressure(void)
+{
+    return wave(1013.0f, 2.0f, 120.0f);
+}
+
+MAGNETO_StatusTypeDef BSP_MAGNETO_Init(void)
+{
+    return MAGNETO_OK;
+}
+
+void BSP_MAGNETO_DeInit(void)
+{
+}
+
+void BSP_MAGNETO_LowPower(uint16_t status)
+{
+    (void)status;
+}
+
+void BSP_MAGNETO_GetXYZ(int16_t *pDataXYZ)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        pDataXYZ[axis] = (int16_t)wave(0.0f, 400.0f, 20.0f, axis);
+    }
+}
+
+uint8_t BSP_GYRO_Init(void)
+{
+    return GYRO_OK;
+}
+
+void BSP_GYRO_DeInit(void)
+{
+}
+
+void BSP_GYRO_LowPower(uint16_t status)
+{
+    (void)status;
+}
+
+void BSP_GYRO_GetXYZ(float *pfData)
+{
+    for (int axis = 0; axis < 3; axis++) {
+        pfData[axis] = wave(0.0f, 1500.0f, 5.0f, axis);
+    }
+}
+
+ACCELERO_StatusTypeDef BSP_ACCELERO_Init(void)
+{
+    return ACCELERO_OK;
+}
+
+void BSP_ACCELERO_DeInit(void)
+{
+}
+
+void BSP_ACCELERO_LowPower(uint16_t status)
+{
+    (void)status;
+}
+
+void BSP_ACCELERO_AccGetXYZ(int16_t *pDataXYZ)
+{
+    // lying flat: gravity on Z, a little vibration on every axis
+    pDataXYZ[0] = (int16_t)wave(0.0f, 20.0f, 0.5f, 0);
+    pDataXYZ[1] = (int16_t)wave(0.0f, 20.0f, 0.5f, 1);
+    pDataXYZ[2] = (int16_t)wave(1000.0f, 20.0f, 0.5f, 2);
+}
+
+} // extern "C"
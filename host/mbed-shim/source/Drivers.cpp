@@ -0,0 +1,104 @@
+#include "drivers/BufferedSerial.h"
+#include "drivers/InterruptIn.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace mbed {
+
+InterruptIn::InterruptIn(PinName pin) :
+    _pin(pin),
+    _enabled(true)
+{
+    mbed_host::pin_attach(_pin, this);
+}
+
+InterruptIn::InterruptIn(PinName pin, PinMode mode) :
+    InterruptIn(pin)
+{
+    (void)mode;
+}
+
+InterruptIn::~InterruptIn()
+{
+    mbed_host::pin_detach(_pin, this);
+}
+
+int InterruptIn::read()
+{
+    return mbed_host::pin_read(_pin);
+}
+
+// handlers change with interrupts held off, never while an edge runs them
+void InterruptIn::rise(Callback<void()> func)
+{
+    std::lock_guard<std::recursive_mutex> lock(mbed_host::irq_mutex());
+    _rise = func;
+}
+
+void InterruptIn::fall(Callback<void()> func)
+{
+    std::lock_guard<std::recursive_mutex> lock(mbed_host::irq_mutex());
+    _fall = func;
+}
+
+void InterruptIn::enable_irq()
+{
+    std::lock_guard<std::recursive_mutex> lock(mbed_host::irq_mutex());
+    _enabled = true;
+}
+
+void InterruptIn::disable_irq()
+{
+    std::lock_guard<std::recursive_mutex> lock(mbed_host::irq_mutex());
+    _enabled = false;
+}
+
+void InterruptIn::edge(bool rising)
+{
+    const Callback<void()> &handler = rising ? _rise : _fall;
+    if (_enabled && handler) {
+        handler();
+    }
+}
+
+BufferedSerial::BufferedSerial(PinName tx, PinName rx, int baud) :
+    _baud(baud),
+    _blocking(true)
+{
+    (void)tx;
+    (void)rx;
+}
+
+ssize_t BufferedSerial::read(void *buffer, size_t size)
+{
+    if (!_blocking && !readable()) {
+        return -EAGAIN;
+    }
+    ssize_t count;
+    {
+        mbed_host::Outside waiting;
+        count = ::read(STDIN_FILENO, buffer, size);
+    }
+    return count < 0 ? -errno : count;
+}
+
+ssize_t BufferedSerial::write(const void *buffer, size_t size)
+{
+    size_t written = fwrite(buffer, 1, size, stdout);
+    fflush(stdout);
+    return written;
+}
+
+int BufferedSerial::sync()
+{
+    return fflush(stdout);
+}
+
+bool BufferedSerial::readable() const
+{
+    pollfd input = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&input, 1, 0) == 1 && (input.revents & POLLIN);
+}
+
+} // namespace mbed
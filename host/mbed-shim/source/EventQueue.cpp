@@ -0,0 +1,162 @@
+#include "events/EventQueue.h"
+#include "events/mbed_shared_queues.h"
+
+#include <climits>
+
+#include "host/HostRuntime.h"
+
+namespace events {
+
+EventQueue::EventQueue(unsigned size, unsigned char *buffer) :
+    _capacity(size / EVENTS_EVENT_SIZE),
+    _used(0),
+    _next_id(1),
+    _sequence(0),
+    _changes(0),
+    _running_id(0),
+    _running_cancelled(false),
+    _break(false)
+{
+    (void)buffer;
+}
+
+EventQueue::~EventQueue()
+{
+}
+
+int EventQueue::post(int64_t delay_ms, int64_t period_ms, std::function<void()> run)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_used == _capacity) {
+        return 0;
+    }
+
+    int id = _next_id;
+    _next_id = _next_id == INT_MAX ? 1 : _next_id + 1;
+
+    uint64_t due = mbed_host::now_us() + (delay_ms > 0 ? delay_ms * 1000 : 0);
+    Key key(due, _sequence++);
+    Event event = { id, period_ms > 0 ? (uint64_t)period_ms * 1000 : 0, std::move(run) };
+    _events.emplace(key, std::move(event));
+    _keys[id] = key;
+    _used++;
+    _changes++;
+    _cv.notify_all();
+    return id;
+}
+
+bool EventQueue::cancel(int id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _keys.find(id);
+    if (found == _keys.end()) {
+        // a periodic event cancelled from its own run is not posted again
+        if (id && id == _running_id && !_running_cancelled) {
+            _running_cancelled = true;
+            return true;
+        }
+        return false;
+    }
+    _events.erase(found->second);
+    _keys.erase(found);
+    _used--;
+    _changes++;
+    _cv.notify_all();
+    return true;
+}
+
+int EventQueue::time_left(int id)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto found = _keys.find(id);
+    if (found == _keys.end()) {
+        return 0;
+    }
+    uint64_t now = mbed_host::now_us();
+    uint64_t due = found->second.first;
+    return due > now ? (int)((due - now + 999) / 1000) : 0;
+}
+
+void EventQueue::run_due(std::unique_lock<std::mutex> &lock)
+{
+    while (!_break && !_events.empty() && _events.begin()->first.first <= mbed_host::now_us()) {
+        auto first = _events.begin();
+        Key key = first->first;
+        Event event = std::move(first->second);
+        _events.erase(first);
+        _keys.erase(event.id);
+        _running_id = event.id;
+        _running_cancelled = false;
+
+        lock.unlock();
+        event.run();
+        lock.lock();
+
+        _running_id = 0;
+        if (event.period_us && !_running_cancelled) {
+            // due times stay on the grid of the first post
+            Key next(key.first + event.period_us, _sequence++);
+            _keys[event.id] = next;
+            _events.emplace(next, std::move(event));
+        } else {
+            _used--;
+        }
+    }
+}
+
+void EventQueue::dispatch_for(duration ms)
+{
+    uint64_t end = ms.count() < 0 ? UINT64_MAX : mbed_host::now_us() + (uint64_t)ms.count() * 1000;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        run_due(lock);
+        if (_break) {
+            _break = false;
+            return;
+        }
+        uint64_t now = mbed_host::now_us();
+        if (now >= end) {
+            return;
+        }
+
+        // sleep until the next event or the end, or until the queue changes
+        uint64_t wake = end;
+        if (!_events.empty() && _events.begin()->first.first < wake) {
+            wake = _events.begin()->first.first;
+        }
+        uint64_t seen = _changes;
+        _cv.wait_until(lock, wake, [this, seen] {
+            return _changes != seen || _break;
+        });
+    }
+}
+
+void EventQueue::dispatch_forever()
+{
+    dispatch_for(duration(-1));
+}
+
+void EventQueue::dispatch_once()
+{
+    dispatch_for(duration(0));
+}
+
+void EventQueue::break_dispatch()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _break = true;
+    _cv.notify_all();
+}
+
+} // namespace events
+
+namespace mbed {
+
+events::EventQueue *mbed_event_queue()
+{
+    static events::EventQueue queue;
+    return &queue;
+}
+
+} // namespace mbed
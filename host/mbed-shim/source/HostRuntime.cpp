@@ -0,0 +1,381 @@
+#include "host/HostRuntime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "drivers/InterruptIn.h"
+#include "hal/us_ticker_api.h"
+#include "platform/mbed_stats.h"
+#include "platform/mbed_wait_api.h"
+#include "rtos/mbed_rtos_types.h"
+
+namespace mbed_host {
+
+namespace {
+
+const int PIN_COUNT = 5 * 16;
+const int IRQS_PER_PIN = 2;
+
+struct Pin {
+    int level;
+    uint32_t period_us;
+    float duty;
+    mbed::InterruptIn *irqs[IRQS_PER_PIN];
+};
+
+struct PinAlias {
+    PinName pin;
+    const char *name;
+};
+
+/* Names accepted in MBED_HOST_INPUT, the first one of a pin is traced. */
+const PinAlias aliases[] = {
+    { LED1, "LED1" },
+    { LED2, "LED2" },
+    { LED3, "LED3" },
+    { USER_BUTTON, "USER_BUTTON" },
+    { USER_BUTTON, "BUTTON1" },
+    { PD_11, "LSM6DSL_INT1" },
+    { PWM_OUT, "PWM_OUT" },
+};
+
+struct InputStep {
+    uint64_t at_us;
+    PinName pin;
+    int level;
+};
+
+struct PinTable {
+    PinTable() :
+        pins()
+    {
+        // the user button is active low, released it reads 1
+        pins[USER_BUTTON].level = 1;
+    }
+
+    Pin pins[PIN_COUNT];
+};
+
+Pin *pins()
+{
+    static PinTable table;
+    return table.pins;
+}
+
+bool valid(PinName pin)
+{
+    return pin >= 0 && pin < PIN_COUNT;
+}
+
+int parse_pin(const char *text, size_t length)
+{
+    for (const PinAlias &alias : aliases) {
+        if (strlen(alias.name) == length && !strncmp(alias.name, text, length)) {
+            return alias.pin;
+        }
+    }
+    // PA_0 to PE_15
+    if (length >= 4 && length <= 5 && text[0] == 'P' && text[1] >= 'A' && text[1] <= 'E' && text[2] == '_') {
+        int number = atoi(text + 3);
+        if (number >= 0 && number < 16) {
+            return (text[1] - 'A') * 16 + number;
+        }
+    }
+    return -1;
+}
+
+/** "PC_13@1000=0,PC_13@1200=1": pin, time in ms, level. */
+std::vector<InputStep> parse_input(const char *script)
+{
+    std::vector<InputStep> steps;
+    const char *item = script;
+    while (*item) {
+        const char *end = strchr(item, ',');
+        size_t length = end ? (size_t)(end - item) : strlen(item);
+        const char *at = (const char *)memchr(item, '@', length);
+        const char *equal = (const char *)memchr(item, '=', length);
+        int pin = at ? parse_pin(item, at - item) : -1;
+        if (pin < 0 || !equal || equal < at) {
+            fprintf(stderr, "MBED_HOST_INPUT: cannot parse \"%.*s\"\n", (int)length, item);
+        } else {
+            InputStep step = { strtoull(at + 1, nullptr, 10) * 1000, (PinName)pin, atoi(equal + 1) ? 1 : 0 };
+            steps.push_back(step);
+        }
+        item += length + (end ? 1 : 0);
+    }
+    std::stable_sort(steps.begin(), steps.end(), [](const InputStep &a, const InputStep &b) {
+        return a.at_us < b.at_us;
+    });
+    return steps;
+}
+
+void play_input(Task *task, std::vector<InputStep> steps)
+{
+    task_run(task);
+    for (const InputStep &step : steps) {
+        sleep_until(step.at_us);
+        pin_input(step.pin, step.level);
+    }
+    task_exit();
+}
+
+void stop_after(Task *task, uint64_t run_us)
+{
+    task_run(task);
+    sleep_until(run_us);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(0);
+}
+
+} // namespace
+
+std::recursive_mutex &irq_mutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+uint64_t deadline_after_ms(uint64_t ms)
+{
+    if (ms >= osWaitForever) {
+        return UINT64_MAX;
+    }
+    return now_us() + ms * 1000;
+}
+
+int pin_read(PinName pin)
+{
+    if (!valid(pin)) {
+        return 0;
+    }
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    return pins()[pin].level > 0;
+}
+
+void pin_write(PinName pin, int level)
+{
+    if (!valid(pin)) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    Pin &state = pins()[pin];
+    if (state.level != level && tracing("pins")) {
+        if (level < 0) {
+            trace("%s = Z", pin_name(pin));
+        } else {
+            trace("%s = %d", pin_name(pin), level);
+        }
+    }
+    state.level = level;
+}
+
+void pin_input(PinName pin, int level)
+{
+    if (!valid(pin)) {
+        return;
+    }
+    // handlers run one at a time under the pin lock, like interrupts of
+    // one priority level
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    Pin &state = pins()[pin];
+    if (state.level == level) {
+        return;
+    }
+    state.level = level;
+    if (tracing("pins")) {
+        trace("%s <- %d", pin_name(pin), level);
+    }
+    for (mbed::InterruptIn *irq : state.irqs) {
+        if (irq) {
+            irq->edge(level != 0);
+        }
+    }
+}
+
+void pin_pwm(PinName pin, uint32_t period_us, float duty)
+{
+    if (!valid(pin)) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    Pin &state = pins()[pin];
+    if ((state.period_us != period_us || state.duty != duty) && tracing("pins")) {
+        trace("%s = pwm %lu us %.1f %%", pin_name(pin), (unsigned long)period_us, duty * 100.0f);
+    }
+    state.period_us = period_us;
+    state.duty = duty;
+}
+
+void pin_attach(PinName pin, mbed::InterruptIn *irq)
+{
+    if (!valid(pin)) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    for (mbed::InterruptIn *&slot : pins()[pin].irqs) {
+        if (!slot) {
+            slot = irq;
+            return;
+        }
+    }
+    fprintf(stderr, "%s: more than %d InterruptIn, edges not delivered\n", pin_name(pin), IRQS_PER_PIN);
+}
+
+void pin_detach(PinName pin, mbed::InterruptIn *irq)
+{
+    if (!valid(pin)) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(irq_mutex());
+    for (mbed::InterruptIn *&slot : pins()[pin].irqs) {
+        if (slot == irq) {
+            slot = nullptr;
+        }
+    }
+}
+
+const char *pin_name(PinName pin)
+{
+    struct PinNames {
+        PinNames()
+        {
+            for (int pin = 0; pin < PIN_COUNT; pin++) {
+                snprintf(names[pin], sizeof(names[pin]), "P%c_%d", 'A' + pin / 16, pin % 16);
+            }
+        }
+
+        char names[PIN_COUNT][6];
+    };
+    static const PinNames table;
+
+    if (!valid(pin)) {
+        return "NC";
+    }
+    for (const PinAlias &alias : aliases) {
+        if (alias.pin == pin) {
+            return alias.name;
+        }
+    }
+    return table.names[pin];
+}
+
+namespace {
+
+std::atomic<void (*)()> ticker_hook(nullptr);
+
+void run_ticker_hook()
+{
+    // cleared first, the hook reads the ticker itself
+    void (*hook)() = ticker_hook.exchange(nullptr);
+    if (hook) {
+        hook();
+    }
+}
+
+} // namespace
+
+void before_next_ticker_read(void (*hook)())
+{
+    ticker_hook.store(hook);
+}
+
+const char *setting(const char *name, const char *fallback)
+{
+    const char *value = getenv(name);
+    return value && *value ? value : fallback;
+}
+
+bool tracing(const char *what)
+{
+    static const char *traces = setting("MBED_HOST_TRACE", "");
+    const char *found = strstr(traces, what);
+    size_t length = strlen(what);
+    return found && (found == traces || found[-1] == ',') && (found[length] == '\0' || found[length] == ',');
+}
+
+void trace(const char *format, ...)
+{
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    uint64_t now = now_us();
+    fprintf(stderr, "[%6lu.%03lu] %s\n", (unsigned long)(now / 1000), (unsigned long)(now % 1000), line);
+}
+
+} // namespace mbed_host
+
+extern "C" uint32_t us_ticker_read(void)
+{
+    mbed_host::run_ticker_hook();
+    return (uint32_t)mbed_host::now_us();
+}
+
+extern "C" void wait_us(int us)
+{
+    // a spin on the board; with the virtual clock even wait_us(0) takes a
+    // microsecond, or a loop polling with it would stop the clock
+    if (us > 0 || mbed_host::virtual_clock()) {
+        mbed_host::sleep_until(mbed_host::now_us() + (us > 0 ? us : 1));
+    }
+}
+
+extern "C" void wait_ns(unsigned int ns)
+{
+    wait_us((ns + 999) / 1000);
+}
+
+void mbed_stats_cpu_get(mbed_stats_cpu_t *stats)
+{
+    // what the process did not run of the time since start counts as idle
+    timespec cpu;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+    uint64_t busy = (uint64_t)cpu.tv_sec * 1000000 + cpu.tv_nsec / 1000;
+    stats->uptime = mbed_host::now_us();
+    stats->idle_time = busy < stats->uptime ? stats->uptime - busy : 0;
+    stats->sleep_time = stats->idle_time;
+    stats->deep_sleep_time = 0;
+}
+
+/*
+ * The applications' main() runs from here, as it does from the RTOS
+ * start-up code on the board (the build links with --wrap=main). Once it
+ * returns the program halts without destructors, threads may still be
+ * using the static objects.
+ */
+extern "C" int __real_main(int argc, char **argv);
+
+extern "C" int __wrap_main(int argc, char **argv)
+{
+    using namespace mbed_host;
+
+    now_us();
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    task_run(task_create("main", osPriorityNormal));
+
+    // both stand for hardware, they run ahead of any thread when due
+    const char *run_ms = setting("MBED_HOST_RUN_MS");
+    if (run_ms) {
+        std::thread(stop_after, task_create("run-limit", osPriorityISR), strtoull(run_ms, nullptr, 10) * 1000).detach();
+    }
+    const char *input = setting("MBED_HOST_INPUT");
+    if (input) {
+        std::thread(play_input, task_create("input", osPriorityISR), parse_input(input)).detach();
+    }
+
+    int result = __real_main(argc, argv);
+    fflush(stdout);
+    fflush(stderr);
+    _exit(result);
+}
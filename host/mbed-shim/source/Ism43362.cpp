@@ -0,0 +1,111 @@
+#include "ISM43362Interface.h"
+
+#include <cstring>
+
+#include "host/HostRuntime.h"
+
+namespace {
+
+const char *simulated_ssid()
+{
+    return mbed_host::setting("MBED_HOST_WIFI_SSID", "mbed-host");
+}
+
+bool wifi_down()
+{
+    return mbed_host::setting("MBED_HOST_WIFI_DOWN") != nullptr;
+}
+
+} // namespace
+
+ISM43362Interface::ISM43362Interface(bool debug) :
+    _connected(false)
+{
+    (void)debug;
+    _ssid[0] = '\0';
+}
+
+nsapi_error_t ISM43362Interface::set_credentials(const char *ssid, const char *pass, nsapi_security_t security)
+{
+    (void)pass;
+    (void)security;
+    if (!ssid || strlen(ssid) >= sizeof(_ssid)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    strcpy(_ssid, ssid);
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t ISM43362Interface::set_channel(uint8_t channel)
+{
+    (void)channel;
+    return NSAPI_ERROR_OK;
+}
+
+int8_t ISM43362Interface::get_rssi()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _connected ? -42 : 0;
+}
+
+nsapi_error_t ISM43362Interface::connect(const char *ssid, const char *pass,
+                                         nsapi_security_t security, uint8_t channel)
+{
+    (void)channel;
+    nsapi_error_t result = set_credentials(ssid, pass, security);
+    if (result != NSAPI_ERROR_OK) {
+        return result;
+    }
+    return connect();
+}
+
+nsapi_error_t ISM43362Interface::connect()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_connected) {
+        return NSAPI_ERROR_IS_CONNECTED;
+    }
+    if (!_ssid[0]) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    if (wifi_down()) {
+        return NSAPI_ERROR_NO_SSID;
+    }
+    _connected = true;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t ISM43362Interface::disconnect()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_connected) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    _connected = false;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_size_or_error_t ISM43362Interface::scan(WiFiAccessPoint *res, nsapi_size_t count)
+{
+    if (wifi_down()) {
+        return 0;
+    }
+    if (!count) {
+        return 1;
+    }
+    nsapi_wifi_ap_t ap = {};
+    strncpy(ap.ssid, simulated_ssid(), sizeof(ap.ssid) - 1);
+    const uint8_t bssid[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+    memcpy(ap.bssid, bssid, sizeof(bssid));
+    ap.security = NSAPI_SECURITY_WPA2;
+    ap.rssi = -42;
+    ap.channel = 6;
+    res[0] = WiFiAccessPoint(ap);
+    return 1;
+}
+
+const char *ISM43362Interface::get_mac_address()
+{
+    return "02:00:00:00:00:01";
+}
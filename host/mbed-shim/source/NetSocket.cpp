@@ -0,0 +1,567 @@
+#include "netsocket/NetworkInterface.h"
+#include "netsocket/SocketAddress.h"
+#include "netsocket/TCPSocket.h"
+#include "netsocket/WiFiAccessPoint.h"
+
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "host/HostRuntime.h"
+#include "rtos/mbed_rtos_types.h"
+
+namespace {
+
+nsapi_error_t error_from_errno(int error)
+{
+    switch (error) {
+        case ECONNREFUSED:
+        case ENETUNREACH:
+        case EHOSTUNREACH:
+        case ENOTCONN:
+            return NSAPI_ERROR_NO_CONNECTION;
+        case ETIMEDOUT:
+            return NSAPI_ERROR_CONNECTION_TIMEOUT;
+        case ECONNRESET:
+        case ECONNABORTED:
+        case EPIPE:
+            return NSAPI_ERROR_CONNECTION_LOST;
+        case EADDRINUSE:
+            return NSAPI_ERROR_ADDRESS_IN_USE;
+        case ENOMEM:
+        case ENOBUFS:
+            return NSAPI_ERROR_NO_MEMORY;
+        default:
+            return NSAPI_ERROR_DEVICE_ERROR;
+    }
+}
+
+/**
+ * The thread standing in for the network drivers: it polls the sockets
+ * with something armed and runs their sigio callback once per event.
+ * An event disarms what it reported; the socket arms it again when a
+ * call would block.
+ */
+class SocketPoller {
+public:
+    static SocketPoller &instance()
+    {
+        static SocketPoller *poller = new SocketPoller();
+        return *poller;
+    }
+
+    void set_sigio(TCPSocket *socket, mbed::Callback<void()> callback)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (callback) {
+                Entry &entry = _entries[socket];
+                entry.callback = callback;
+                return;
+            }
+            _entries.erase(socket);
+        }
+        wake();
+        sync();
+    }
+
+    void arm(TCPSocket *socket, int fd, short events)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto found = _entries.find(socket);
+        if (found == _entries.end()) {
+            return;
+        }
+        found->second.fd = fd;
+        found->second.armed |= events;
+        wake();
+    }
+
+    /** Stop polling a socket; no callback of it runs after this returns. */
+    void forget(TCPSocket *socket)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto found = _entries.find(socket);
+            if (found == _entries.end()) {
+                return;
+            }
+            found->second.fd = -1;
+            found->second.armed = 0;
+        }
+        wake();
+        sync();
+    }
+
+private:
+    struct Entry {
+        Entry() :
+            fd(-1),
+            armed(0)
+        {
+        }
+
+        int fd;
+        short armed;
+        mbed::Callback<void()> callback;
+    };
+
+    SocketPoller() :
+        _task(mbed_host::task_create("sockets", osPriorityISR))
+    {
+        if (pipe(_wake) == 0) {
+            fcntl(_wake[0], F_SETFL, O_NONBLOCK);
+            fcntl(_wake[1], F_SETFL, O_NONBLOCK);
+        }
+        std::thread(&SocketPoller::run, this).detach();
+    }
+
+    void wake()
+    {
+        char byte = 0;
+        if (write(_wake[1], &byte, 1) < 0) {
+            // the pipe is full, the poller wakes up anyway
+        }
+    }
+
+    /** Wait for the callbacks running, unless called from one of them. */
+    void sync()
+    {
+        std::lock_guard<std::recursive_mutex> lock(_firing);
+    }
+
+    void run()
+    {
+        mbed_host::task_run(_task);
+        std::vector<pollfd> fds;
+        std::vector<TCPSocket *> sockets;
+        std::vector<TCPSocket *> ready;
+
+        while (true) {
+            fds.assign(1, pollfd { _wake[0], POLLIN, 0 });
+            sockets.assign(1, nullptr);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (auto &entry : _entries) {
+                    if (entry.second.fd >= 0 && entry.second.armed) {
+                        fds.push_back(pollfd { entry.second.fd, entry.second.armed, 0 });
+                        sockets.push_back(entry.first);
+                    }
+                }
+            }
+
+            int polled;
+            {
+                // with a socket armed an answer is expected, the clock waits for it
+                mbed_host::Outside waiting(fds.size() > 1);
+                polled = poll(fds.data(), fds.size(), -1);
+            }
+            if (polled < 0) {
+                continue;
+            }
+            char drain[64];
+            while (read(_wake[0], drain, sizeof(drain)) > 0) {
+            }
+
+            std::lock_guard<std::recursive_mutex> firing(_firing);
+            ready.clear();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                for (size_t i = 1; i < fds.size(); i++) {
+                    auto found = _entries.find(sockets[i]);
+                    if (!fds[i].revents || found == _entries.end() || found->second.fd != fds[i].fd) {
+                        continue;
+                    }
+                    // a hang-up or an error is reported once for everything armed
+                    short fired = fds[i].revents & (POLLHUP | POLLERR) ? found->second.armed : fds[i].revents;
+                    found->second.armed &= ~fired;
+                    ready.push_back(sockets[i]);
+                }
+            }
+            for (TCPSocket *socket : ready) {
+                mbed::Callback<void()> callback;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    auto found = _entries.find(socket);
+                    if (found == _entries.end()) {
+                        continue;
+                    }
+                    callback = found->second.callback;
+                }
+                callback();
+            }
+        }
+    }
+
+    std::mutex _mutex;
+    std::recursive_mutex _firing;
+    std::map<TCPSocket *, Entry> _entries;
+    int _wake[2];
+    mbed_host::Task *_task;
+};
+
+} // namespace
+
+SocketAddress::SocketAddress() :
+    _addr(),
+    _port(0)
+{
+    _text[0] = '\0';
+}
+
+SocketAddress::SocketAddress(const nsapi_addr_t &addr, uint16_t port) :
+    _addr(addr),
+    _port(port)
+{
+    _text[0] = '\0';
+}
+
+SocketAddress::SocketAddress(const char *addr, uint16_t port) :
+    _addr(),
+    _port(port)
+{
+    _text[0] = '\0';
+    if (addr) {
+        set_ip_address(addr);
+    }
+}
+
+bool SocketAddress::set_ip_address(const char *addr)
+{
+    nsapi_addr_t parsed = {};
+    if (inet_pton(AF_INET, addr, parsed.bytes) == 1) {
+        parsed.version = NSAPI_IPv4;
+    } else if (inet_pton(AF_INET6, addr, parsed.bytes) == 1) {
+        parsed.version = NSAPI_IPv6;
+    } else {
+        _addr = nsapi_addr_t();
+        return false;
+    }
+    _addr = parsed;
+    return true;
+}
+
+void SocketAddress::set_ip_bytes(const void *bytes, nsapi_version_t version)
+{
+    _addr = nsapi_addr_t();
+    _addr.version = version;
+    memcpy(_addr.bytes, bytes, version == NSAPI_IPv6 ? NSAPI_IPv6_BYTES : NSAPI_IPv4_BYTES);
+}
+
+void SocketAddress::set_addr(const nsapi_addr_t &addr)
+{
+    _addr = addr;
+}
+
+const char *SocketAddress::get_ip_address() const
+{
+    if (_addr.version == NSAPI_UNSPEC) {
+        return nullptr;
+    }
+    inet_ntop(_addr.version == NSAPI_IPv6 ? AF_INET6 : AF_INET, _addr.bytes, _text, sizeof(_text));
+    return _text;
+}
+
+SocketAddress::operator bool() const
+{
+    for (uint8_t byte : _addr.bytes) {
+        if (byte) {
+            return true;
+        }
+    }
+    return false;
+}
+
+nsapi_error_t NetworkInterface::get_ip_address(SocketAddress *address)
+{
+    address->set_ip_address("127.0.0.1");
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t NetworkInterface::get_netmask(SocketAddress *address)
+{
+    address->set_ip_address("255.0.0.0");
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t NetworkInterface::get_gateway(SocketAddress *address)
+{
+    address->set_ip_address("127.0.0.1");
+    return NSAPI_ERROR_OK;
+}
+
+const char *NetworkInterface::get_ip_address()
+{
+    return "127.0.0.1";
+}
+
+const char *NetworkInterface::get_netmask()
+{
+    return "255.0.0.0";
+}
+
+const char *NetworkInterface::get_gateway()
+{
+    return "127.0.0.1";
+}
+
+nsapi_error_t NetworkInterface::gethostbyname(const char *host, SocketAddress *address,
+                                              nsapi_version_t version, const char *interface_name)
+{
+    (void)interface_name;
+    if (address->set_ip_address(host)) {
+        return NSAPI_ERROR_OK;
+    }
+
+    addrinfo hints = {};
+    hints.ai_family = version == NSAPI_IPv4 ? AF_INET : (version == NSAPI_IPv6 ? AF_INET6 : AF_UNSPEC);
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) || !result) {
+        return NSAPI_ERROR_DNS_FAILURE;
+    }
+    if (result->ai_family == AF_INET6) {
+        address->set_ip_bytes(&((sockaddr_in6 *)result->ai_addr)->sin6_addr, NSAPI_IPv6);
+    } else {
+        address->set_ip_bytes(&((sockaddr_in *)result->ai_addr)->sin_addr, NSAPI_IPv4);
+    }
+    freeaddrinfo(result);
+    return NSAPI_ERROR_OK;
+}
+
+WiFiAccessPoint::WiFiAccessPoint() :
+    _ap()
+{
+}
+
+WiFiAccessPoint::WiFiAccessPoint(nsapi_wifi_ap_t ap) :
+    _ap(ap)
+{
+}
+
+TCPSocket::TCPSocket() :
+    _fd(-1),
+    _open(false),
+    _timeout_ms(-1),
+    _connecting(false),
+    _connected(false)
+{
+}
+
+TCPSocket::~TCPSocket()
+{
+    close();
+    SocketPoller::instance().set_sigio(this, nullptr);
+}
+
+nsapi_error_t TCPSocket::open(NetworkInterface *stack)
+{
+    if (!stack || _open) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+    _open = true;
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TCPSocket::close()
+{
+    if (!_open) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    SocketPoller::instance().forget(this);
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+    _fd = -1;
+    _open = false;
+    _connecting = false;
+    _connected = false;
+    return NSAPI_ERROR_OK;
+}
+
+void TCPSocket::set_blocking(bool blocking)
+{
+    _timeout_ms = blocking ? -1 : 0;
+}
+
+void TCPSocket::set_timeout(int timeout)
+{
+    _timeout_ms = timeout < 0 ? -1 : timeout;
+}
+
+void TCPSocket::sigio(mbed::Callback<void()> func)
+{
+    _sigio = func;
+    SocketPoller::instance().set_sigio(this, func);
+}
+
+bool TCPSocket::wait_for(short events)
+{
+    pollfd fd = { _fd, events, 0 };
+    mbed_host::Outside waiting;
+    int ready;
+    do {
+        ready = poll(&fd, 1, _timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0;
+}
+
+void TCPSocket::arm(short events)
+{
+    SocketPoller::instance().arm(this, _fd, events);
+}
+
+nsapi_error_t TCPSocket::finish_connect()
+{
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    _connecting = false;
+    if (error) {
+        SocketPoller::instance().forget(this);
+        ::close(_fd);
+        _fd = -1;
+        return error_from_errno(error);
+    }
+    _connected = true;
+    arm(POLLIN);
+    return NSAPI_ERROR_OK;
+}
+
+nsapi_error_t TCPSocket::connect(const SocketAddress &address)
+{
+    if (!_open) {
+        return NSAPI_ERROR_NO_SOCKET;
+    }
+    if (_connected) {
+        return NSAPI_ERROR_IS_CONNECTED;
+    }
+    if (_connecting) {
+        pollfd fd = { _fd, POLLOUT, 0 };
+        if (poll(&fd, 1, 0) <= 0) {
+            return NSAPI_ERROR_ALREADY;
+        }
+        nsapi_error_t result = finish_connect();
+        return result == NSAPI_ERROR_OK ? NSAPI_ERROR_IS_CONNECTED : result;
+    }
+
+    SocketAddress peer = address;
+    const char *redirect = mbed_host::setting("MBED_HOST_NET_REDIRECT");
+    if (redirect && !peer.set_ip_address(redirect)) {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    sockaddr_storage storage = {};
+    socklen_t length;
+    if (peer.get_ip_version() == NSAPI_IPv6) {
+        sockaddr_in6 *in6 = (sockaddr_in6 *)&storage;
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port = htons(peer.get_port());
+        memcpy(&in6->sin6_addr, peer.get_ip_bytes(), NSAPI_IPv6_BYTES);
+        length = sizeof(*in6);
+    } else if (peer.get_ip_version() == NSAPI_IPv4) {
+        sockaddr_in *in = (sockaddr_in *)&storage;
+        in->sin_family = AF_INET;
+        in->sin_port = htons(peer.get_port());
+        memcpy(&in->sin_addr, peer.get_ip_bytes(), NSAPI_IPv4_BYTES);
+        length = sizeof(*in);
+    } else {
+        return NSAPI_ERROR_PARAMETER;
+    }
+
+    if (_fd < 0) {
+        _fd = socket(storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (_fd < 0) {
+            return NSAPI_ERROR_NO_SOCKET;
+        }
+    }
+
+    if (::connect(_fd, (sockaddr *)&storage, length) == 0) {
+        _connected = true;
+        arm(POLLIN);
+        return NSAPI_ERROR_OK;
+    }
+    if (errno != EINPROGRESS) {
+        nsapi_error_t error = error_from_errno(errno);
+        ::close(_fd);
+        _fd = -1;
+        return error;
+    }
+
+    _connecting = true;
+    if (_timeout_ms == 0) {
+        arm(POLLOUT);
+        return NSAPI_ERROR_IN_PROGRESS;
+    }
+    if (!wait_for(POLLOUT)) {
+        return NSAPI_ERROR_TIMEOUT;
+    }
+    return finish_connect();
+}
+
+nsapi_size_or_error_t TCPSocket::send(const void *data, nsapi_size_t size)
+{
+    if (!_connected) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    while (true) {
+        ssize_t sent = ::send(_fd, data, size, MSG_NOSIGNAL);
+        if (sent >= 0) {
+            return sent;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return error_from_errno(errno);
+        }
+        if (_timeout_ms == 0) {
+            arm(POLLOUT);
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+        if (!wait_for(POLLOUT)) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+    }
+}
+
+nsapi_size_or_error_t TCPSocket::recv(void *data, nsapi_size_t size)
+{
+    if (!_connected) {
+        return NSAPI_ERROR_NO_CONNECTION;
+    }
+    while (true) {
+        ssize_t received = ::recv(_fd, data, size, 0);
+        if (received > 0) {
+            arm(POLLIN);
+            return received;
+        }
+        if (received == 0) {
+            return 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return error_from_errno(errno);
+        }
+        if (_timeout_ms == 0) {
+            arm(POLLIN);
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+        if (!wait_for(POLLIN)) {
+            return NSAPI_ERROR_WOULD_BLOCK;
+        }
+    }
+}
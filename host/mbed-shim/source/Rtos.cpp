@@ -0,0 +1,319 @@
+#include "rtos/rtos.h"
+
+#include <pthread.h>
+
+#include "host/HostRuntime.h"
+
+namespace rtos {
+
+namespace {
+
+thread_local Thread *current_thread = nullptr;
+
+uint64_t deadline_of(Kernel::Clock::duration_u32 rel_time)
+{
+    return mbed_host::deadline_after_ms(rel_time.count());
+}
+
+uint64_t deadline_of(Kernel::Clock::time_point abs_time)
+{
+    int64_t ms = abs_time.time_since_epoch().count();
+    return ms > 0 ? (uint64_t)ms * 1000 : 0;
+}
+
+} // namespace
+
+Kernel::Clock::time_point Kernel::Clock::now()
+{
+    return time_point(duration(get_ms_count()));
+}
+
+uint64_t Kernel::get_ms_count()
+{
+    return mbed_host::now_us() / 1000;
+}
+
+Thread::Thread(osPriority priority, uint32_t stack_size, unsigned char *stack_mem, const char *name) :
+    _scheduled(nullptr),
+    _priority(priority),
+    _stack_size(stack_size),
+    _name(name),
+    _state(Inactive)
+{
+    (void)stack_mem;
+}
+
+Thread::~Thread()
+{
+    if (_thread.joinable()) {
+        _thread.detach();
+    }
+}
+
+osStatus Thread::start(mbed::Callback<void()> task)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_state != Inactive || !task) {
+        return osErrorParameter;
+    }
+    _task = task;
+    _state = Ready;
+    _scheduled = mbed_host::task_create(_name ? _name : "application_unnamed_thread", _priority);
+    _thread = std::thread(&Thread::run, this, _scheduled);
+    return osOK;
+}
+
+void Thread::run(mbed_host::Task *task)
+{
+    mbed_host::task_run(task);
+    current_thread = this;
+    if (_name) {
+        // the kernel keeps 15 characters
+        char name[16];
+        snprintf(name, sizeof(name), "%s", _name);
+        pthread_setname_np(pthread_self(), name);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _state = Running;
+    }
+    _task();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _state = Deleted;
+        _scheduled = nullptr;
+        _finished_cv.notify_all();
+    }
+    mbed_host::task_exit();
+}
+
+osStatus Thread::join()
+{
+    if (current_thread == this) {
+        return osErrorResource;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_state == Inactive) {
+        return osOK;
+    }
+    _finished_cv.wait_until(lock, UINT64_MAX, [this] { return _state == Deleted; });
+    lock.unlock();
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    return osOK;
+}
+
+osStatus Thread::set_priority(osPriority priority)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _priority = priority;
+    mbed_host::task_set_priority(_scheduled, priority);
+    return osOK;
+}
+
+osPriority Thread::get_priority() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _priority;
+}
+
+Thread::State Thread::get_state() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _state;
+}
+
+void ThisThread::sleep_for(uint32_t millisec)
+{
+    sleep_for(Kernel::Clock::duration_u32(millisec));
+}
+
+void ThisThread::sleep_for(Kernel::Clock::duration_u32 rel_time)
+{
+    mbed_host::sleep_until(deadline_of(rel_time));
+}
+
+void ThisThread::sleep_until(uint64_t millisec)
+{
+    mbed_host::sleep_until(millisec * 1000);
+}
+
+void ThisThread::sleep_until(Kernel::Clock::time_point abs_time)
+{
+    mbed_host::sleep_until(deadline_of(abs_time));
+}
+
+void ThisThread::yield()
+{
+    mbed_host::yield();
+}
+
+osThreadId_t ThisThread::get_id()
+{
+    return current_thread;
+}
+
+const char *ThisThread::get_name()
+{
+    if (!current_thread) {
+        return "main";
+    }
+    return current_thread->get_name() ? current_thread->get_name() : "application_unnamed_thread";
+}
+
+bool Mutex::lock_until(uint64_t deadline_us)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::thread::id self = std::this_thread::get_id();
+    if (!_cv.wait_until(lock, deadline_us, [this, self] { return _count == 0 || _owner == self; })) {
+        return false;
+    }
+    _owner = self;
+    _count++;
+    return true;
+}
+
+bool Mutex::trylock_for(Kernel::Clock::duration_u32 rel_time)
+{
+    return lock_until(deadline_of(rel_time));
+}
+
+void Mutex::unlock()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count && --_count == 0) {
+        _owner = std::thread::id();
+        _cv.notify_one();
+    }
+}
+
+Semaphore::Semaphore(int32_t count) :
+    _count(count),
+    _max_count(0xFFFF)
+{
+}
+
+Semaphore::Semaphore(int32_t count, uint16_t max_count) :
+    _count(count),
+    _max_count(max_count)
+{
+}
+
+bool Semaphore::acquire_until(uint64_t deadline_us)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_cv.wait_until(lock, deadline_us, [this] { return _count > 0; })) {
+        return false;
+    }
+    _count--;
+    return true;
+}
+
+void Semaphore::acquire()
+{
+    acquire_until(UINT64_MAX);
+}
+
+bool Semaphore::try_acquire()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count == 0) {
+        return false;
+    }
+    _count--;
+    return true;
+}
+
+bool Semaphore::try_acquire_for(Kernel::Clock::duration_u32 rel_time)
+{
+    return acquire_until(deadline_of(rel_time));
+}
+
+bool Semaphore::try_acquire_until(Kernel::Clock::time_point abs_time)
+{
+    return acquire_until(deadline_of(abs_time));
+}
+
+osStatus Semaphore::release()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_count >= _max_count) {
+        return osErrorResource;
+    }
+    _count++;
+    _cv.notify_one();
+    return osOK;
+}
+
+uint32_t EventFlags::set(uint32_t flags)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flags |= flags & 0x7fffffff;
+    _cv.notify_all();
+    return _flags;
+}
+
+uint32_t EventFlags::clear(uint32_t flags)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint32_t previous = _flags;
+    _flags &= ~flags;
+    return previous;
+}
+
+uint32_t EventFlags::get() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _flags;
+}
+
+uint32_t EventFlags::wait(uint32_t flags, bool all, uint64_t deadline_us, bool clear)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    // no flags given waits for any flag
+    uint32_t wanted = flags ? flags : 0x7fffffff;
+    auto matched = [this, wanted, all] {
+        return all ? (_flags & wanted) == wanted : (_flags & wanted) != 0;
+    };
+    if (!_cv.wait_until(lock, deadline_us, matched)) {
+        return osFlagsErrorTimeout;
+    }
+    uint32_t result = _flags;
+    if (clear) {
+        _flags &= ~wanted;
+    }
+    return result;
+}
+
+uint32_t EventFlags::wait_all(uint32_t flags, uint32_t millisec, bool clear)
+{
+    return wait(flags, true, mbed_host::deadline_after_ms(millisec), clear);
+}
+
+uint32_t EventFlags::wait_any(uint32_t flags, uint32_t millisec, bool clear)
+{
+    return wait(flags, false, mbed_host::deadline_after_ms(millisec), clear);
+}
+
+uint32_t EventFlags::wait_all_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear)
+{
+    return wait(flags, true, deadline_of(rel_time), clear);
+}
+
+uint32_t EventFlags::wait_any_for(uint32_t flags, Kernel::Clock::duration_u32 rel_time, bool clear)
+{
+    return wait(flags, false, deadline_of(rel_time), clear);
+}
+
+uint32_t EventFlags::wait_all_until(uint32_t flags, Kernel::Clock::time_point abs_time, bool clear)
+{
+    return wait(flags, true, deadline_of(abs_time), clear);
+}
+
+uint32_t EventFlags::wait_any_until(uint32_t flags, Kernel::Clock::time_point abs_time, bool clear)
+{
+    return wait(flags, false, deadline_of(abs_time), clear);
+}
+
+} // namespace rtos
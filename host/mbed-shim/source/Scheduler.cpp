@@ -0,0 +1,380 @@
+#include "host/HostRuntime.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace mbed_host {
+
+struct Task {
+    enum State {
+        READY,
+        RUNNING,
+        BLOCKED,
+        OUTSIDE
+    };
+
+    const char *name;
+    int priority;
+    State state;
+    /** When the task became ready or blocked: ties go to the first. */
+    uint64_t order;
+    uint64_t deadline_us;
+    const Condition *condition;
+    /** Why the task became ready, for the trace. */
+    const char *reason;
+    /** Outside, the clock keeps to real time. */
+    bool pacing;
+    /** Signalled when the task gets the CPU. */
+    std::condition_variable turn;
+};
+
+namespace {
+
+/*
+ * The virtual clock schedule. One task holds the CPU at a time; it gives
+ * it up in block(), yield(), Outside or task_exit(), and dispatch() hands
+ * it to the next. Everything runs under the one mutex of the schedule,
+ * which no task holds while it runs application code. A task outside in
+ * the host comes back in a dispatch() of its own, so dispatch() checks
+ * whether the CPU was taken each time it waited.
+ */
+struct Schedule {
+    Schedule() :
+        running(nullptr),
+        order(0)
+    {
+    }
+
+    std::mutex mutex;
+    /** Signalled when a task comes back from the host. */
+    std::condition_variable host_returned;
+    std::vector<Task *> tasks;
+    Task *running;
+    uint64_t order;
+};
+
+std::chrono::steady_clock::time_point origin()
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return start;
+}
+
+Schedule &schedule()
+{
+    // never destroyed, threads may still run while the program exits
+    static Schedule *schedule = new Schedule();
+    return *schedule;
+}
+
+std::atomic<uint64_t> virtual_now(0);
+thread_local Task *current = nullptr;
+
+/** With the schedule locked, as every function below. */
+void make_ready(Task *task, const char *reason)
+{
+    task->state = Task::READY;
+    task->order = schedule().order++;
+    task->condition = nullptr;
+    task->reason = reason;
+}
+
+bool runs_before(const Task *a, const Task *b)
+{
+    return a->priority > b->priority || (a->priority == b->priority && a->order < b->order);
+}
+
+bool earlier(const Task *a, const Task *b)
+{
+    return a->deadline_us < b->deadline_us || (a->deadline_us == b->deadline_us && a->order < b->order);
+}
+
+/** Give the free CPU to the next task, moving the clock if all wait. */
+void dispatch(std::unique_lock<std::mutex> &lock)
+{
+    Schedule &s = schedule();
+    while (true) {
+        if (s.running) {
+            // taken while this waited, by a task back from the host
+            return;
+        }
+        Task *next = nullptr;
+        for (Task *task : s.tasks) {
+            if (task->state == Task::READY && (!next || runs_before(task, next))) {
+                next = task;
+            }
+        }
+        if (next) {
+            next->state = Task::RUNNING;
+            s.running = next;
+            if (tracing("sched")) {
+                trace("run %s (%s)", next->name, next->reason);
+            }
+            next->turn.notify_one();
+            return;
+        }
+
+        Task *first = nullptr;
+        bool outside = false;
+        bool pacing = false;
+        for (Task *task : s.tasks) {
+            outside |= task->state == Task::OUTSIDE;
+            pacing |= task->state == Task::OUTSIDE && task->pacing;
+            if (task->state == Task::BLOCKED && task->deadline_us != UINT64_MAX && (!first || earlier(task, first))) {
+                first = task;
+            }
+        }
+        if (!first) {
+            if (outside) {
+                // the CPU stays free for the first task back from the host
+                return;
+            }
+            fflush(stdout);
+            fprintf(stderr, "mbed_host: every thread waits forever at %llu ms\n",
+                    (unsigned long long)(virtual_now / 1000));
+            fflush(stderr);
+            _exit(0);
+        }
+
+        if (pacing) {
+            // the host may still answer before the deadline, in real time
+            auto wait = std::chrono::microseconds(first->deadline_us - virtual_now);
+            if (s.host_returned.wait_for(lock, wait) == std::cv_status::no_timeout) {
+                continue;
+            }
+        }
+
+        // idle: the clock jumps, the tasks due wake up in the order they slept
+        virtual_now = first->deadline_us;
+        std::vector<Task *> due;
+        for (Task *task : s.tasks) {
+            if (task->state == Task::BLOCKED && task->deadline_us <= virtual_now) {
+                due.push_back(task);
+            }
+        }
+        std::sort(due.begin(), due.end(), earlier);
+        for (Task *task : due) {
+            make_ready(task, task->condition ? "timeout" : "sleep");
+        }
+    }
+}
+
+void wait_turn(std::unique_lock<std::mutex> &lock, Task *task)
+{
+    if (!schedule().running) {
+        dispatch(lock);
+    }
+    task->turn.wait(lock, [task] {
+        return schedule().running == task;
+    });
+}
+
+/** The running task waits until notified or until deadline_us. */
+void block(uint64_t deadline_us, const Condition *condition)
+{
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    current->state = Task::BLOCKED;
+    current->order = s.order++;
+    current->deadline_us = deadline_us;
+    current->condition = condition;
+    s.running = nullptr;
+    dispatch(lock);
+    wait_turn(lock, current);
+}
+
+/** Make ready the tasks waiting on condition, first waiter first. */
+void wake(const Condition *condition, bool all)
+{
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    std::vector<Task *> waiting;
+    for (Task *task : s.tasks) {
+        if (task->state == Task::BLOCKED && task->condition == condition) {
+            waiting.push_back(task);
+        }
+    }
+    if (waiting.empty()) {
+        return;
+    }
+    std::sort(waiting.begin(), waiting.end(), runs_before);
+    if (!all) {
+        waiting.resize(1);
+    }
+    for (Task *task : waiting) {
+        make_ready(task, "notify");
+    }
+    if (!s.running) {
+        dispatch(lock);
+    }
+}
+
+} // namespace
+
+bool virtual_clock()
+{
+    static const bool enabled = [] {
+        const char *clock = setting("MBED_HOST_CLOCK", "real");
+        if (strcmp(clock, "virtual") && strcmp(clock, "real")) {
+            fprintf(stderr, "MBED_HOST_CLOCK: \"%s\" is neither real nor virtual\n", clock);
+        }
+        return !strcmp(clock, "virtual");
+    }();
+    return enabled;
+}
+
+uint64_t now_us()
+{
+    using namespace std::chrono;
+    if (virtual_clock()) {
+        return virtual_now;
+    }
+    return duration_cast<microseconds>(steady_clock::now() - origin()).count();
+}
+
+void sleep_until(uint64_t deadline_us)
+{
+    if (!virtual_clock()) {
+        std::this_thread::sleep_until(origin() + std::chrono::microseconds(deadline_us));
+        return;
+    }
+    if (!current) {
+        // not a thread of the schedule, nothing it could wait for
+        return;
+    }
+    if (deadline_us > now_us()) {
+        block(deadline_us, nullptr);
+    }
+}
+
+void yield()
+{
+    if (!current) {
+        std::this_thread::yield();
+        return;
+    }
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    make_ready(current, "yield");
+    s.running = nullptr;
+    dispatch(lock);
+    wait_turn(lock, current);
+}
+
+void Condition::notify_one()
+{
+    if (virtual_clock()) {
+        wake(this, false);
+    }
+    _cv.notify_one();
+}
+
+void Condition::notify_all()
+{
+    if (virtual_clock()) {
+        wake(this, true);
+    }
+    _cv.notify_all();
+}
+
+void Condition::wait(std::unique_lock<std::mutex> &lock, uint64_t deadline_us)
+{
+    if (current) {
+        // nothing else runs until this task blocks, no notify is missed
+        lock.unlock();
+        block(deadline_us, this);
+        lock.lock();
+        return;
+    }
+    if (deadline_us == UINT64_MAX) {
+        _cv.wait(lock);
+        return;
+    }
+    // the deadline is re-checked by the caller, a long one in steps
+    uint64_t left = std::min<uint64_t>(deadline_us - now_us(), 3600000000ull);
+    _cv.wait_for(lock, std::chrono::microseconds(left));
+}
+
+Task *task_create(const char *name, int priority)
+{
+    if (!virtual_clock()) {
+        return nullptr;
+    }
+    Task *task = new Task();
+    task->name = name;
+    task->priority = priority;
+    task->deadline_us = UINT64_MAX;
+
+    Schedule &s = schedule();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    make_ready(task, "start");
+    s.tasks.push_back(task);
+    return task;
+}
+
+void task_run(Task *task)
+{
+    if (!task) {
+        return;
+    }
+    current = task;
+    std::unique_lock<std::mutex> lock(schedule().mutex);
+    wait_turn(lock, task);
+}
+
+void task_exit()
+{
+    if (!current) {
+        return;
+    }
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    s.tasks.erase(std::find(s.tasks.begin(), s.tasks.end(), current));
+    delete current;
+    current = nullptr;
+    s.running = nullptr;
+    dispatch(lock);
+}
+
+void task_set_priority(Task *task, int priority)
+{
+    if (!task) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(schedule().mutex);
+    task->priority = priority;
+}
+
+Outside::Outside(bool pace_clock) :
+    _task(current)
+{
+    if (!_task) {
+        return;
+    }
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    _task->state = Task::OUTSIDE;
+    _task->pacing = pace_clock;
+    s.running = nullptr;
+    dispatch(lock);
+}
+
+Outside::~Outside()
+{
+    if (!_task) {
+        return;
+    }
+    Schedule &s = schedule();
+    std::unique_lock<std::mutex> lock(s.mutex);
+    make_ready(_task, "host");
+    s.host_returned.notify_all();
+    wait_turn(lock, _task);
+}
+
+} // namespace mbed_host
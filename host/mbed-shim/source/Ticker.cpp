@@ -0,0 +1,151 @@
+#include "drivers/Ticker.h"
+
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "host/HostRuntime.h"
+#include "rtos/mbed_rtos_types.h"
+
+namespace mbed_host {
+
+/**
+ * The timer hardware: one thread sleeping until the first ticker is due.
+ * Locks go irq_mutex() first, then the queue, so detach() under
+ * irq_mutex() excludes a handler running.
+ */
+class TickerQueue {
+public:
+    static TickerQueue &instance()
+    {
+        static TickerQueue *queue = new TickerQueue();
+        return *queue;
+    }
+
+    void insert(mbed::TickerBase *ticker, uint64_t due_us)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ticker->_queued = true;
+        ticker->_due_us = due_us;
+        ticker->_sequence = _sequence++;
+        _queue[Key(due_us, ticker->_sequence)] = ticker;
+        _changes++;
+        _cv.notify_all();
+    }
+
+    void remove(mbed::TickerBase *ticker)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (ticker->_queued) {
+            _queue.erase(Key(ticker->_due_us, ticker->_sequence));
+            ticker->_queued = false;
+        }
+    }
+
+private:
+    /** Due time and attach order: tickers due together run in that order. */
+    typedef std::pair<uint64_t, uint64_t> Key;
+
+    TickerQueue() :
+        _sequence(0),
+        _changes(0),
+        _task(task_create("us-ticker", osPriorityISR))
+    {
+        std::thread(&TickerQueue::run, this).detach();
+    }
+
+    uint64_t first_due()
+    {
+        return _queue.empty() ? UINT64_MAX : _queue.begin()->first.first;
+    }
+
+    void run()
+    {
+        task_run(_task);
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                uint64_t seen = _changes;
+                while (first_due() > now_us()) {
+                    _cv.wait_until(lock, first_due(), [this, &seen] {
+                        return _changes != seen;
+                    });
+                    seen = _changes;
+                }
+            }
+
+            std::lock_guard<std::recursive_mutex> irq(irq_mutex());
+            mbed::TickerBase *ticker;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                // detached while the lock was taken
+                if (first_due() > now_us()) {
+                    continue;
+                }
+                ticker = _queue.begin()->second;
+                _queue.erase(_queue.begin());
+                ticker->_queued = false;
+            }
+            ticker->fire();
+        }
+    }
+
+    std::mutex _mutex;
+    Condition _cv;
+    std::map<Key, mbed::TickerBase *> _queue;
+    uint64_t _sequence;
+    uint64_t _changes;
+    Task *_task;
+};
+
+} // namespace mbed_host
+
+namespace mbed {
+
+TickerBase::TickerBase(bool repeat) :
+    _period_us(0),
+    _repeat(repeat),
+    _queued(false),
+    _due_us(0),
+    _sequence(0)
+{
+}
+
+TickerBase::~TickerBase()
+{
+    detach();
+}
+
+void TickerBase::attach(Callback<void()> func, std::chrono::microseconds t)
+{
+    std::lock_guard<std::recursive_mutex> irq(mbed_host::irq_mutex());
+    mbed_host::TickerQueue &queue = mbed_host::TickerQueue::instance();
+    queue.remove(this);
+    _function = func;
+    _period_us = t.count() > 0 ? t.count() : 1;
+    queue.insert(this, mbed_host::now_us() + _period_us);
+}
+
+void TickerBase::detach()
+{
+    std::lock_guard<std::recursive_mutex> irq(mbed_host::irq_mutex());
+    if (_queued) {
+        mbed_host::TickerQueue::instance().remove(this);
+    }
+    _function = nullptr;
+}
+
+void TickerBase::fire()
+{
+    // queued again first, so the handler can still detach
+    if (_repeat) {
+        mbed_host::TickerQueue::instance().insert(this, _due_us + _period_us);
+    }
+    Callback<void()> function = _function;
+    if (function) {
+        function();
+    }
+}
+
+} // namespace mbed
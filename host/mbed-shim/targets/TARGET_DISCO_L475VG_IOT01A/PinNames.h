@@ -0,0 +1,70 @@
+#ifndef MBED_HOST_PINNAMES_H
+#define MBED_HOST_PINNAMES_H
+
+/*
+ * Pins of the DISCO_L475VG_IOT01A as the STM32 targets number them, port
+ * in the high nibble. Only the pins the lab applications use have their
+ * board alias here.
+ */
+
+#define MBED_HOST_PORT_PINS(port, base) \
+    port##_0 = base, port##_1, port##_2, port##_3, port##_4, port##_5, port##_6, port##_7, \
+    port##_8, port##_9, port##_10, port##_11, port##_12, port##_13, port##_14, port##_15
+
+typedef enum {
+    MBED_HOST_PORT_PINS(PA, 0x00),
+    MBED_HOST_PORT_PINS(PB, 0x10),
+    MBED_HOST_PORT_PINS(PC, 0x20),
+    MBED_HOST_PORT_PINS(PD, 0x30),
+    MBED_HOST_PORT_PINS(PE, 0x40),
+
+    // Arduino connector
+    D0 = PA_1,
+    D1 = PA_0,
+    D2 = PD_14,
+    D3 = PB_0,
+    D4 = PA_3,
+    D5 = PB_4,
+    D6 = PB_1,
+    D7 = PA_4,
+    D8 = PB_2,
+    D9 = PA_15,
+    D10 = PA_2,
+    D11 = PA_7,
+    D12 = PA_6,
+    D13 = PA_5,
+    D14 = PB_9,
+    D15 = PB_8,
+
+    LED1 = PA_5,
+    LED2 = PB_14,
+    LED3 = PC_9,
+    LED4 = PC_9,
+    USER_BUTTON = PC_13,
+    BUTTON1 = USER_BUTTON,
+    PWM_OUT = D9,
+
+    USBTX = PB_6,
+    USBRX = PB_7,
+    CONSOLE_TX = USBTX,
+    CONSOLE_RX = USBRX,
+
+    NC = -1
+} PinName;
+
+#undef MBED_HOST_PORT_PINS
+
+typedef enum {
+    PullNone = 0,
+    PullUp = 1,
+    PullDown = 2,
+    OpenDrain = 3,
+    PullDefault = PullNone
+} PinMode;
+
+typedef enum {
+    PIN_INPUT,
+    PIN_OUTPUT
+} PinDirection;
+
+#endif // MBED_HOST_PINNAMES_H
@@ -0,0 +1,11 @@
+#ifndef MBED_HOST_PINNAMESTYPES_H
+#define MBED_HOST_PINNAMESTYPES_H
+
+/*
+ * On the board the STM32 pin function encoding; the host has none, the
+ * pin modes and directions are in PinNames.h.
+ */
+
+#include "PinNames.h"
+
+#endif // MBED_HOST_PINNAMESTYPES_H
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Generate mbed_config.h for a host build.
+
+Mbed CLI turns mbed_app.json and the mbed_lib.json files of the libraries
+into MBED_CONF_* macros. This does the same for the parts the host build
+uses: the "config" sections of the application and of each library, and
+the "target_overrides" for "*" and the board.
+
+    mbed_config.py -o mbed_config.h --app ../Event-Thread/mbed_app.json \
+        --lib ../lab-utils/mbed_lib.json --lib mbed-shim/mbed_lib.json
+
+--set app.name=value overrides a parameter after all that, for a second
+build of an application with an option on.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+TARGET = "DISCO_L475VG_IOT01A"
+
+
+def macro_of(prefix, name):
+    return re.sub(r"[^A-Za-z0-9]", "_", "MBED_CONF_%s_%s" % (prefix, name)).upper()
+
+
+def value_text(value):
+    if isinstance(value, bool):
+        return "1" if value else "0"
+    # strings go in verbatim, as with Mbed CLI: "\"ssid\"" is a C string
+    return str(value)
+
+
+def load(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def collect(path, is_app, params):
+    """Add the parameters of one json file to params, keyed by full name."""
+    data = load(path)
+    space = "app" if is_app else data["name"]
+    for name, spec in data.get("config", {}).items():
+        if not isinstance(spec, dict):
+            spec = {"value": spec}
+        params["%s.%s" % (space, name)] = {
+            "macro": spec.get("macro_name") or macro_of(space, name),
+            "value": spec.get("value"),
+        }
+    return data
+
+
+def apply_overrides(data, is_app, params, path):
+    space = "app" if is_app else data["name"]
+    overrides = data.get("target_overrides", {})
+    for target in ("*", TARGET):
+        for name, value in overrides.get(target, {}).items():
+            if name.startswith("target."):
+                continue
+            full = name if "." in name else "%s.%s" % (space, name)
+            if full not in params:
+                # a setting of a library the host build does not have
+                sys.stderr.write("%s: %s ignored\n" % (path, full))
+                continue
+            params[full]["value"] = value
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--app", help="the application's mbed_app.json")
+    parser.add_argument("--lib", action="append", default=[], help="an mbed_lib.json")
+    parser.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                        help="a parameter to override, the value in JSON")
+    args = parser.parse_args()
+
+    params = {}
+    # libraries first, the application overrides them
+    files = [(path, False) for path in args.lib]
+    if args.app:
+        files.append((args.app, True))
+    loaded = [(collect(path, is_app, params), is_app, path) for path, is_app in files]
+    for data, is_app, path in loaded:
+        apply_overrides(data, is_app, params, path)
+    for setting in args.set:
+        name, _, value = setting.partition("=")
+        if name not in params:
+            parser.error("no parameter %s" % name)
+        params[name]["value"] = json.loads(value)
+
+    lines = [
+        "// Generated by mbed_config.py, do not edit",
+        "#ifndef MBED_CONFIG_H",
+        "#define MBED_CONFIG_H",
+        "",
+    ]
+    for full in sorted(params):
+        param = params[full]
+        if param["value"] is None:
+            continue
+        lines.append("#define %-60s %-20s // %s" % (param["macro"], value_text(param["value"]), full))
+    lines += ["", "#endif // MBED_CONFIG_H", ""]
+
+    text = "\n".join(lines)
+    try:
+        with open(args.output) as f:
+            if f.read() == text:
+                return
+    except OSError:
+        pass
+    with open(args.output, "w") as f:
+        f.write(text)
+
+
+if __name__ == "__main__":
+    main()
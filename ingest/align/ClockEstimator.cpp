@@ -0,0 +1,84 @@
+#include "ClockEstimator.h"
+
+#include <cmath>
+
+namespace lab {
+
+ClockEstimator::ClockEstimator(double nominal_period_us, uint32_t window, double forget) :
+    _nominal_us(nominal_period_us),
+    _seed_us(nominal_period_us),
+    _window(window ? window : 1),
+    _forget(forget),
+    _started(false),
+    _in_window(0),
+    _window_x(0.0),
+    _window_y(0.0),
+    _windows(0),
+    _w(0.0),
+    _sx(0.0),
+    _sy(0.0),
+    _sxx(0.0),
+    _sxy(0.0)
+{
+    _fit.first_sequence = 0;
+    _fit.origin_us = 0.0;
+    _fit.period_us = nominal_period_us;
+    _fit.skew_ppm = 0.0;
+}
+
+void ClockEstimator::seed_period(double period_us)
+{
+    _seed_us = period_us;
+    if (!settled()) {
+        _fit.period_us = period_us;
+        _fit.skew_ppm = (period_us / _nominal_us - 1.0) * 1e6;
+    }
+}
+
+void ClockEstimator::add(int64_t sequence, int64_t arrival_us)
+{
+    if (!_started) {
+        _started = true;
+        _fit.first_sequence = sequence;
+        _fit.origin_us = (double)arrival_us;
+    }
+    double x = (double)(sequence - _fit.first_sequence);
+    double y = (double)arrival_us - x * _nominal_us;
+    if (_in_window == 0 || y < _window_y) {
+        _window_x = x;
+        _window_y = y;
+    }
+    if (!settled()) {
+        // the seeded period, through the earliest sample so far
+        double origin = (double)arrival_us - x * _seed_us;
+        _fit.origin_us = origin < _fit.origin_us ? origin : _fit.origin_us;
+    }
+    if (++_in_window < _window) {
+        return;
+    }
+
+    _w = _forget * _w + 1.0;
+    _sx = _forget * _sx + _window_x;
+    _sy = _forget * _sy + _window_y;
+    _sxx = _forget * _sxx + _window_x * _window_x;
+    _sxy = _forget * _sxy + _window_x * _window_y;
+    _windows++;
+    _in_window = 0;
+    if (settled()) {
+        refit();
+    }
+}
+
+void ClockEstimator::refit()
+{
+    double determinant = _w * _sxx - _sx * _sx;
+    if (!(std::fabs(determinant) > 0.0)) {
+        return;
+    }
+    double slope = (_w * _sxy - _sx * _sy) / determinant;
+    _fit.origin_us = (_sy - slope * _sx) / _w;
+    _fit.period_us = _nominal_us + slope;
+    _fit.skew_ppm = (_fit.period_us / _nominal_us - 1.0) * 1e6;
+}
+
+} // namespace lab
@@ -0,0 +1,100 @@
+#ifndef LAB_CLOCK_ESTIMATOR_H
+#define LAB_CLOCK_ESTIMATOR_H
+
+#include <cstdint>
+
+namespace lab {
+
+/** Host time of the samples of a board: origin + (s - first) * period. */
+struct ClockFit {
+    int64_t first_sequence;
+    /** Host time of sample first_sequence, us. */
+    double origin_us;
+    /** Sample period of the board in host time, us. */
+    double period_us;
+    /** Period error against the nominal one, parts per million. */
+    double skew_ppm;
+};
+
+/**
+ * Clock of a board from the sequence numbers of its samples and their
+ * arrival times on the host.
+ *
+ * An arrival is the send time plus a network delay that is never below
+ * some floor and often well above it (queues, retries, samples sent in
+ * one packet). So the samples are taken in windows, and the one that
+ * came earliest for its sequence number stands for the window: it is
+ * the least delayed. A line fitted through those minima by least squares
+ * gives the period and the origin; windows are weighted down by a
+ * forgetting factor so the fit follows a clock that drifts with
+ * temperature.
+ *
+ * The floor itself cannot be seen from the host: times are the send
+ * times plus that floor, the same for boards on the same network.
+ */
+class ClockEstimator {
+public:
+    /**
+     * @param[in] nominal_period_us Period the board is configured for.
+     * @param[in] window Samples per window.
+     * @param[in] forget Weight of a window against the next one, below 1.
+     */
+    ClockEstimator(double nominal_period_us = 100000.0, uint32_t window = 50, double forget = 0.98);
+
+    /** Period to assume until two windows are in, from an earlier run of the board. */
+    void seed_period(double period_us);
+
+    /** A sample; sequence numbers only go up. */
+    void add(int64_t sequence, int64_t arrival_us);
+
+    ClockFit fit() const
+    {
+        return _fit;
+    }
+
+    /** Whether the period comes from the samples (two windows at least). */
+    bool settled() const
+    {
+        return _windows >= 2;
+    }
+
+    /** Host time of a sequence number, fractional or beyond the samples. */
+    double time_us(double sequence) const
+    {
+        return _fit.origin_us + (sequence - _fit.first_sequence) * _fit.period_us;
+    }
+
+    /** Fractional sequence number at a host time. */
+    double sequence_at(double time_us) const
+    {
+        return _fit.first_sequence + (time_us - _fit.origin_us) / _fit.period_us;
+    }
+
+private:
+    void refit();
+
+    double _nominal_us;
+    double _seed_us;
+    uint32_t _window;
+    double _forget;
+    bool _started;
+
+    // the window being filled: its least delayed sample
+    uint32_t _in_window;
+    double _window_x;
+    double _window_y;
+
+    // weighted sums of the window minima, x = s - first, y = arrival - x * nominal
+    uint32_t _windows;
+    double _w;
+    double _sx;
+    double _sy;
+    double _sxx;
+    double _sxy;
+
+    ClockFit _fit;
+};
+
+} // namespace lab
+
+#endif // LAB_CLOCK_ESTIMATOR_H
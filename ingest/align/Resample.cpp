@@ -0,0 +1,229 @@
+#include "Resample.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LAB_RESAMPLE_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace lab {
+
+namespace {
+
+bool simd_enabled = true;
+
+/**
+ * Lanczos kernel weights, a row of RESAMPLE_SINC_TAPS per phase, for
+ * inputs floor(u) - 3 ... floor(u) + 4. Each row sums to 1 so a
+ * constant goes through unchanged.
+ */
+struct SincTable {
+    SincTable()
+    {
+        const double pi = 3.141592653589793;
+        const double a = RESAMPLE_SINC_HALF_WIDTH;
+        for (int phase = 0; phase <= RESAMPLE_SINC_PHASES; phase++) {
+            double fraction = (double)phase / RESAMPLE_SINC_PHASES;
+            double row[RESAMPLE_SINC_TAPS];
+            double sum = 0.0;
+            for (int tap = 0; tap < RESAMPLE_SINC_TAPS; tap++) {
+                double x = tap - (RESAMPLE_SINC_HALF_WIDTH - 1) - fraction;
+                double weight = 1.0;
+                if (x != 0.0) {
+                    weight = std::fabs(x) < a ? a * std::sin(pi * x) * std::sin(pi * x / a) / (pi * pi * x * x) : 0.0;
+                }
+                row[tap] = weight;
+                sum += weight;
+            }
+            for (int tap = 0; tap < RESAMPLE_SINC_TAPS; tap++) {
+                weights[phase * RESAMPLE_SINC_TAPS + tap] = (float)(row[tap] / sum);
+            }
+        }
+    }
+
+    float weights[(RESAMPLE_SINC_PHASES + 1) * RESAMPLE_SINC_TAPS];
+};
+
+const float *sinc_table()
+{
+    static const SincTable table;
+    return table.weights;
+}
+
+/*
+ * Both kernels add the same products in the same order, without fused
+ * multiply-adds, so their outputs are the same to the bit.
+ */
+
+void linear_portable(const ResamplePlan &plan, size_t begin, const float *input, float *output)
+{
+    for (size_t k = begin; k < plan.end; k++) {
+        float x0 = input[plan.index[k]];
+        float x1 = input[plan.index[k] + 1];
+        output[k] = x0 + plan.fraction[k] * (x1 - x0);
+    }
+}
+
+void sinc_portable(const ResamplePlan &plan, size_t begin, const float *input, float *output)
+{
+    const float *table = sinc_table();
+    for (size_t k = begin; k < plan.end; k++) {
+        const float *x = input + plan.index[k];
+        const float *w = table + plan.phase[k] * RESAMPLE_SINC_TAPS;
+        float low = (x[0] * w[0] + x[1] * w[1]) + (x[2] * w[2] + x[3] * w[3]);
+        float high = (x[4] * w[4] + x[5] * w[5]) + (x[6] * w[6] + x[7] * w[7]);
+        output[k] = low + high;
+    }
+}
+
+#if LAB_RESAMPLE_AVX2
+
+__attribute__((target("avx2")))
+size_t linear_avx2(const ResamplePlan &plan, const float *input, float *output)
+{
+    size_t k = plan.begin;
+    for (; k + 8 <= plan.end; k += 8) {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&plan.index[k]));
+        __m256 fraction = _mm256_loadu_ps(&plan.fraction[k]);
+        __m256 x0 = _mm256_i32gather_ps(input, index, 4);
+        __m256 x1 = _mm256_i32gather_ps(input + 1, index, 4);
+        _mm256_storeu_ps(output + k, _mm256_add_ps(x0, _mm256_mul_ps(fraction, _mm256_sub_ps(x1, x0))));
+    }
+    return k;
+}
+
+/**
+ * The taps of an output are next to each other in the input and in its
+ * table row: a product vector per output, eight of them summed across
+ * by a tree of horizontal adds.
+ */
+__attribute__((target("avx2")))
+size_t sinc_avx2(const ResamplePlan &plan, const float *input, float *output)
+{
+    const float *table = sinc_table();
+    size_t k = plan.begin;
+    for (; k + 8 <= plan.end; k += 8) {
+        __m256 products[8];
+        for (int lane = 0; lane < 8; lane++) {
+            __m256 x = _mm256_loadu_ps(input + plan.index[k + lane]);
+            __m256 w = _mm256_loadu_ps(table + plan.phase[k + lane] * RESAMPLE_SINC_TAPS);
+            products[lane] = _mm256_mul_ps(x, w);
+        }
+        // lanes 0-3 of each 128-bit half: taps 0-3 of outputs 0-3, then 4-7
+        __m256 first = _mm256_hadd_ps(_mm256_hadd_ps(products[0], products[1]),
+                                      _mm256_hadd_ps(products[2], products[3]));
+        __m256 second = _mm256_hadd_ps(_mm256_hadd_ps(products[4], products[5]),
+                                       _mm256_hadd_ps(products[6], products[7]));
+        __m256 low = _mm256_permute2f128_ps(first, second, 0x20);
+        __m256 high = _mm256_permute2f128_ps(first, second, 0x31);
+        _mm256_storeu_ps(output + k, _mm256_add_ps(low, high));
+    }
+    return k;
+}
+
+static_assert(RESAMPLE_SINC_TAPS == 8, "a table row is a vector");
+
+#endif // LAB_RESAMPLE_AVX2
+
+} // namespace
+
+const char *resample_method_name(ResampleMethod method)
+{
+    return method == RESAMPLE_SINC ? "sinc" : "linear";
+}
+
+bool resample_method_from_name(const char *name, ResampleMethod &method)
+{
+    if (strcmp(name, "linear") == 0) {
+        method = RESAMPLE_LINEAR;
+    } else if (strcmp(name, "sinc") == 0) {
+        method = RESAMPLE_SINC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void resample_plan(ResampleMethod method, double first, double step, size_t length, size_t count, ResamplePlan &plan)
+{
+    plan.method = method;
+    plan.index.assign(length, 0);
+    plan.fraction.assign(method == RESAMPLE_LINEAR ? length : 0, 0.0f);
+    plan.phase.assign(method == RESAMPLE_SINC ? length : 0, 0);
+    plan.begin = length;
+    plan.end = length;
+    // inputs an output reads, before and after its position
+    double before = method == RESAMPLE_SINC ? RESAMPLE_SINC_HALF_WIDTH - 1 : 0;
+    double after = method == RESAMPLE_SINC ? RESAMPLE_SINC_HALF_WIDTH : 1;
+    bool inside = false;
+    for (size_t k = 0; k < length; k++) {
+        double position = first + k * step;
+        double whole = std::floor(position);
+        double fraction = position - whole;
+        if (method == RESAMPLE_LINEAR && whole == (double)count - 1 && fraction == 0.0) {
+            // the last input exactly
+            whole -= 1.0;
+            fraction = 1.0;
+        }
+        bool fits = whole - before >= 0.0 && whole + after <= (double)count - 1;
+        if (fits && !inside) {
+            plan.begin = k;
+            inside = true;
+        } else if (!fits && inside) {
+            plan.end = k;
+            break;
+        }
+        if (!fits) {
+            continue;
+        }
+        if (method == RESAMPLE_SINC) {
+            plan.index[k] = (int32_t)(whole - before);
+            plan.phase[k] = (int32_t)(fraction * RESAMPLE_SINC_PHASES + 0.5);
+        } else {
+            plan.index[k] = (int32_t)whole;
+            plan.fraction[k] = (float)fraction;
+        }
+    }
+    if (!inside) {
+        plan.begin = plan.end = 0;
+    }
+}
+
+void resample(const ResamplePlan &plan, const float *input, float *output)
+{
+    size_t k = plan.begin;
+#if LAB_RESAMPLE_AVX2
+    if (resample_simd_active()) {
+        k = plan.method == RESAMPLE_SINC ? sinc_avx2(plan, input, output) : linear_avx2(plan, input, output);
+    }
+#endif
+    if (plan.method == RESAMPLE_SINC) {
+        sinc_portable(plan, k, input, output);
+    } else {
+        linear_portable(plan, k, input, output);
+    }
+}
+
+bool resample_simd_available()
+{
+#if LAB_RESAMPLE_AVX2
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+void resample_use_simd(bool enable)
+{
+    simd_enabled = enable;
+}
+
+bool resample_simd_active()
+{
+    return simd_enabled && resample_simd_available();
+}
+
+} // namespace lab
@@ -0,0 +1,70 @@
+#ifndef LAB_RESAMPLE_H
+#define LAB_RESAMPLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lab {
+
+enum ResampleMethod {
+    /** Straight line between the two neighbours. */
+    RESAMPLE_LINEAR,
+    /** Lanczos windowed sinc over 8 neighbours, flat up to well beyond half the Nyquist frequency. */
+    RESAMPLE_SINC
+};
+
+/** Neighbours before the position a windowed sinc output uses, and after. */
+static const int RESAMPLE_SINC_HALF_WIDTH = 4;
+static const int RESAMPLE_SINC_TAPS = 2 * RESAMPLE_SINC_HALF_WIDTH;
+/** Fractional positions are rounded to 1 / RESAMPLE_SINC_PHASES of a sample. */
+static const int RESAMPLE_SINC_PHASES = 1024;
+
+/** "linear", "sinc". */
+const char *resample_method_name(ResampleMethod method);
+
+/** @return true and the method of a name. */
+bool resample_method_from_name(const char *name, ResampleMethod &method);
+
+/**
+ * Where the outputs of a resampling fall in a uniformly sampled input:
+ * output k at index position first + k * step. Made once for all the
+ * channels of a series, it holds per output the first input it reads and
+ * its fraction (linear) or phase (sinc). Outputs [begin, end) have all
+ * their inputs in the series, the others none.
+ */
+struct ResamplePlan {
+    ResampleMethod method;
+    std::vector<int32_t> index;
+    std::vector<float> fraction;
+    std::vector<int32_t> phase;
+    size_t begin;
+    size_t end;
+};
+
+/**
+ * @param[in] first Input position of output 0.
+ * @param[in] step Input samples per output, above 0.
+ * @param[in] length Outputs.
+ * @param[in] count Inputs.
+ */
+void resample_plan(ResampleMethod method, double first, double step, size_t length, size_t count, ResamplePlan &plan);
+
+/**
+ * Outputs [plan.begin, plan.end) of one channel, the others are not
+ * written. A NaN input, a sample that is missing, makes NaN every output
+ * that reads it.
+ */
+void resample(const ResamplePlan &plan, const float *input, float *output);
+
+/** Whether the CPU runs the AVX2 kernels. */
+bool resample_simd_available();
+
+/** Use the AVX2 kernels when the CPU has them (the default), or the portable ones, to compare. */
+void resample_use_simd(bool enable);
+
+bool resample_simd_active();
+
+} // namespace lab
+
+#endif // LAB_RESAMPLE_H
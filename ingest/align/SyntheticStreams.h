@@ -0,0 +1,130 @@
+#ifndef LAB_SYNTHETIC_STREAMS_H
+#define LAB_SYNTHETIC_STREAMS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "SensorHistory.h"
+
+namespace lab {
+
+/**
+ * Boards on one shaking table, all measuring the same motion at host
+ * time t (seconds): tones well below the Nyquist frequency of 10 Hz
+ * sampling, in the units of the telemetry.
+ */
+inline void synthetic_table_motion(double time_s, float values[HISTORY_CHANNELS])
+{
+    const double two_pi = 6.283185307179586;
+    values[HISTORY_A_X] = (float)(300.0 * std::sin(two_pi * 0.7 * time_s) + 150.0 * std::sin(two_pi * 1.9 * time_s + 1.0));
+    values[HISTORY_A_Y] = (float)(200.0 * std::cos(two_pi * 1.3 * time_s));
+    values[HISTORY_A_Z] = (float)(1000.0 + 80.0 * std::sin(two_pi * 0.4 * time_s));
+    values[HISTORY_G_X] = (float)(20000.0 * std::sin(two_pi * 0.9 * time_s));
+    values[HISTORY_G_Y] = (float)(15000.0 * std::cos(two_pi * 0.6 * time_s + 0.5));
+    values[HISTORY_G_Z] = (float)(8000.0 * std::sin(two_pi * 1.6 * time_s + 2.0));
+}
+
+struct SyntheticStreamOptions {
+    SyntheticStreamOptions() :
+        boards(8),
+        rate_hz(10.0),
+        skew_ppm(200.0),
+        floor_ms(3.0),
+        jitter_ms(20.0),
+        drop(0.01),
+        stall(0.002),
+        restart(false)
+    {
+    }
+
+    unsigned boards;
+    double rate_hz;
+    /** Clock errors spread over -skew_ppm ... +skew_ppm across the boards. */
+    double skew_ppm;
+    /** Network delay: a floor, the same for all boards, plus an exponential jitter of this mean. */
+    double floor_ms;
+    double jitter_ms;
+    /** Share of the samples a board never sends. */
+    double drop;
+    /** Share of the samples after which the link stalls for half a second. */
+    double stall;
+    /** Whether the last board restarts half way, its count back to 0 after 3 s. */
+    bool restart;
+};
+
+/** A sample as it reaches the host, with what the host cannot see. */
+struct SyntheticArrival {
+    uint32_t board;
+    int64_t sequence;
+    int64_t arrival_us;
+    /** When the board took it, host time. */
+    int64_t true_us;
+    float values[HISTORY_CHANNELS];
+};
+
+/** Clock error of a board of synthetic_streams(), ppm. */
+inline double synthetic_skew_ppm(const SyntheticStreamOptions &options, unsigned board)
+{
+    return options.boards > 1 ? options.skew_ppm * (2.0 * board / (options.boards - 1) - 1.0) : options.skew_ppm;
+}
+
+/**
+ * Streams of drifting boards over seconds, in arrival order. Each board
+ * starts at its own time in the first 2 s and runs on a clock with its
+ * skew; every sample gets a network delay and arrives in order, so a
+ * stall delivers a burst at once.
+ */
+inline std::vector<SyntheticArrival> synthetic_streams(const SyntheticStreamOptions &options, double seconds)
+{
+    std::vector<SyntheticArrival> arrivals;
+    uint32_t state = 0x2545F491u;
+    auto uniform = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0 / 16777216.0);
+    };
+
+    for (unsigned board = 0; board < options.boards; board++) {
+        double period_us = 1e6 / options.rate_hz * (1.0 + synthetic_skew_ppm(options, board) * 1e-6);
+        double start_us = std::fmod(board * 370000.0, 2000000.0);
+        double restart_us = options.restart && board + 1 == options.boards ? seconds * 1e6 / 2 : 1e300;
+        double last_arrival = 0.0;
+        double stalled_until = 0.0;
+        int64_t sequence = 0;
+        for (double true_us = start_us; true_us < seconds * 1e6; true_us += period_us, sequence++) {
+            if (true_us >= restart_us) {
+                true_us += 3e6;
+                sequence = 0;
+                restart_us = 1e300;
+            }
+            if (uniform() < options.drop) {
+                continue;
+            }
+            double delay = options.floor_ms * 1000.0 - options.jitter_ms * 1000.0 * std::log(1.0 - uniform());
+            double arrival = std::max(std::max(true_us + delay, last_arrival), stalled_until);
+            if (uniform() < options.stall) {
+                stalled_until = arrival + 500000.0;
+            }
+            last_arrival = arrival;
+
+            SyntheticArrival sample;
+            sample.board = board;
+            sample.sequence = sequence;
+            sample.arrival_us = (int64_t)arrival;
+            sample.true_us = (int64_t)true_us;
+            synthetic_table_motion(true_us * 1e-6, sample.values);
+            arrivals.push_back(sample);
+        }
+    }
+    std::stable_sort(arrivals.begin(), arrivals.end(), [](const SyntheticArrival &a, const SyntheticArrival &b) {
+        return a.arrival_us < b.arrival_us;
+    });
+    return arrivals;
+}
+
+} // namespace lab
+
+#endif // LAB_SYNTHETIC_STREAMS_H
@@ -0,0 +1,171 @@
+#include "TimeAligner.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <limits>
+
+namespace lab {
+
+namespace {
+
+/** Samples an output reads before and after its position. */
+int taps_before(ResampleMethod method)
+{
+    return method == RESAMPLE_SINC ? RESAMPLE_SINC_HALF_WIDTH - 1 : 0;
+}
+
+int taps_after(ResampleMethod method)
+{
+    return method == RESAMPLE_SINC ? RESAMPLE_SINC_HALF_WIDTH : 1;
+}
+
+} // namespace
+
+TimeAligner::TimeAligner(const AlignOptions &options) :
+    _options(options)
+{
+}
+
+size_t TimeAligner::add_board()
+{
+    _boards.push_back(Board());
+    return _boards.size() - 1;
+}
+
+void TimeAligner::add(size_t board, int64_t sequence, int64_t arrival_us, const float values[HISTORY_CHANNELS])
+{
+    if (board >= _boards.size()) {
+        return;
+    }
+    Board &state = _boards[board];
+    state.samples++;
+    Run *run = state.runs.empty() ? nullptr : &state.runs.back();
+    if (run && run->clock.settled()) {
+        state.period_us = run->clock.fit().period_us;
+    }
+
+    if (run && sequence > run->last && sequence - run->last - 1 <= (int64_t)_options.max_gap) {
+        int64_t missing = sequence - run->last - 1;
+        if (missing > 0) {
+            bool fill = missing <= (int64_t)_options.max_fill;
+            for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                std::vector<float> &column = run->values[channel];
+                float before = column.back();
+                for (int64_t i = 1; i <= missing; i++) {
+                    column.push_back(fill ? before + (values[channel] - before) * (float)i / (float)(missing + 1)
+                                          : std::numeric_limits<float>::quiet_NaN());
+                }
+            }
+            state.missing += missing;
+            state.filled += fill ? missing : 0;
+        }
+    } else {
+        // first sample, a restart or a gap too long: a new run
+        state.runs.push_back(Run(_options));
+        state.run_count++;
+        run = &state.runs.back();
+        run->first = sequence;
+        if (state.period_us > 0.0) {
+            run->clock.seed_period(state.period_us);
+        }
+    }
+
+    for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+        run->values[channel].push_back(values[channel]);
+    }
+    run->last = sequence;
+    run->clock.add(sequence, arrival_us);
+}
+
+BoardTiming TimeAligner::timing(size_t board) const
+{
+    BoardTiming timing;
+    memset(&timing, 0, sizeof(timing));
+    if (board >= _boards.size()) {
+        return timing;
+    }
+    const Board &state = _boards[board];
+    if (!state.runs.empty()) {
+        timing.clock = state.runs.back().clock.fit();
+        timing.settled = state.runs.back().clock.settled();
+    }
+    timing.samples = state.samples;
+    timing.missing = state.missing;
+    timing.filled = state.filled;
+    timing.runs = state.run_count;
+    return timing;
+}
+
+int64_t TimeAligner::ready_until() const
+{
+    int64_t ready = INT64_MAX;
+    bool any = false;
+    for (const Board &state : _boards) {
+        if (state.runs.empty()) {
+            continue;
+        }
+        const Run &run = state.runs.back();
+        double until = run.clock.time_us((double)(run.last - taps_after(_options.method)));
+        ready = std::min(ready, (int64_t)std::floor(until));
+        any = true;
+    }
+    return any ? ready : INT64_MIN;
+}
+
+void TimeAligner::align(int64_t start_us, size_t length, AlignedBlock &block)
+{
+    block.start_us = start_us;
+    block.period_us = _options.grid_period_us;
+    block.length = length;
+    block.boards = _boards.size();
+    block.values.assign(_boards.size() * HISTORY_CHANNELS * length, std::numeric_limits<float>::quiet_NaN());
+
+    for (size_t board = 0; board < _boards.size(); board++) {
+        // a later run overwrites an earlier one where both have samples
+        for (const Run &run : _boards[board].runs) {
+            ClockFit fit = run.clock.fit();
+            double first = run.clock.sequence_at((double)start_us) - (double)run.first;
+            double step = (double)_options.grid_period_us / fit.period_us;
+            resample_plan(_options.method, first, step, length, run.values[0].size(), _plan);
+            if (_plan.begin == _plan.end) {
+                continue;
+            }
+            for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                resample(_plan, run.values[channel].data(), block.column(board, channel));
+            }
+        }
+    }
+}
+
+void TimeAligner::discard_before(int64_t time_us)
+{
+    for (Board &state : _boards) {
+        size_t kept = 0;
+        for (size_t i = 0; i < state.runs.size(); i++) {
+            Run &run = state.runs[i];
+            bool current = i + 1 == state.runs.size();
+            double position = run.clock.sequence_at((double)time_us) - (double)run.first;
+            double unused = std::floor(position) - taps_before(_options.method) - 1;
+            size_t count = run.values[0].size();
+            if (!current && unused >= (double)count) {
+                continue;
+            }
+            // the current run keeps its last sample, the start of a gap to fill
+            size_t drop = unused <= 0.0 ? 0 : std::min((size_t)unused, count - 1);
+            if (drop) {
+                for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                    run.values[channel].erase(run.values[channel].begin(), run.values[channel].begin() + drop);
+                }
+                run.first += (int64_t)drop;
+            }
+            if (kept != i) {
+                state.runs[kept] = std::move(run);
+            }
+            kept++;
+        }
+        state.runs.erase(state.runs.begin() + kept, state.runs.end());
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,180 @@
+#ifndef LAB_TIME_ALIGNER_H
+#define LAB_TIME_ALIGNER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ClockEstimator.h"
+#include "Resample.h"
+#include "SensorHistory.h"
+
+namespace lab {
+
+struct AlignOptions {
+    AlignOptions() :
+        nominal_period_us(100000),
+        grid_period_us(100000),
+        method(RESAMPLE_SINC),
+        max_fill(5),
+        max_gap(600),
+        window(50),
+        forget(0.98)
+    {
+    }
+
+    /** Sample period the boards are configured for, 100 ms for the WiFi example. */
+    int64_t nominal_period_us;
+    /** Period of the common time grid. */
+    int64_t grid_period_us;
+    ResampleMethod method;
+    /** Missing samples, up to this many in a row, are filled in linearly; longer gaps stay empty. */
+    uint32_t max_fill;
+    /** A gap of more samples than this starts the board over, as a restart does. */
+    uint32_t max_gap;
+    /** Samples per window and forgetting factor of the clock fit, see ClockEstimator. */
+    uint32_t window;
+    double forget;
+};
+
+/**
+ * Samples of all boards on one time grid: grid point k is at host time
+ * start_us + k * period_us. Columns are per board and channel, NaN where
+ * the board has no data (before its first sample, in a long gap).
+ */
+struct AlignedBlock {
+    int64_t start_us;
+    int64_t period_us;
+    size_t length;
+    size_t boards;
+    /** values[(board * HISTORY_CHANNELS + channel) * length + k] */
+    std::vector<float> values;
+
+    float *column(size_t board, size_t channel)
+    {
+        return &values[(board * HISTORY_CHANNELS + channel) * length];
+    }
+
+    const float *column(size_t board, size_t channel) const
+    {
+        return &values[(board * HISTORY_CHANNELS + channel) * length];
+    }
+
+    bool valid(size_t board, size_t k) const
+    {
+        return !std::isnan(column(board, 0)[k]);
+    }
+
+    int64_t time_us(size_t k) const
+    {
+        return start_us + (int64_t)k * period_us;
+    }
+};
+
+/** What the aligner knows of a board. */
+struct BoardTiming {
+    /** The clock of its current run. */
+    ClockFit clock;
+    bool settled;
+    uint64_t samples;
+    /** Sequence numbers that never came, and how many of them were filled in. */
+    uint64_t missing;
+    uint64_t filled;
+    /** Runs: restarts of the board and gaps beyond max_gap start a new one. */
+    uint32_t runs;
+};
+
+/**
+ * Puts the streams of many boards on one time grid.
+ *
+ * Boards only number their samples. Per board and run (until the
+ * sequence goes back or jumps too far), a ClockEstimator turns sequence
+ * numbers into host time from the arrival times, so the skew and offset
+ * of every board are taken out. Samples are kept per run in columns
+ * indexed by sequence number: a missing one is NaN, or a straight line
+ * between its neighbours in a short gap.
+ *
+ * align() then resamples every run of every board onto the grid, by
+ * linear or windowed-sinc interpolation with resample(): one plan per
+ * run, vectorized over the grid points, shared by the six channels.
+ * The sinc needs 4 samples after a grid point, linear 1: ready_until()
+ * tells how far all the boards can be aligned so far.
+ */
+class TimeAligner {
+public:
+    explicit TimeAligner(const AlignOptions &options = AlignOptions());
+
+    const AlignOptions &options() const
+    {
+        return _options;
+    }
+
+    /** @return the index of a new board. */
+    size_t add_board();
+
+    size_t board_count() const
+    {
+        return _boards.size();
+    }
+
+    /** A sample of a board, its sequence number and when it arrived on the host. */
+    void add(size_t board, int64_t sequence, int64_t arrival_us, const float values[HISTORY_CHANNELS]);
+
+    BoardTiming timing(size_t board) const;
+
+    /**
+     * Host time up to which the grid is complete for every board with
+     * samples, INT64_MIN if none has any.
+     */
+    int64_t ready_until() const;
+
+    /** Resample all boards on grid points start_us + k * grid_period_us, k < length. */
+    void align(int64_t start_us, size_t length, AlignedBlock &block);
+
+    /** Forget the samples no grid point from time_us on needs. */
+    void discard_before(int64_t time_us);
+
+private:
+    struct Run {
+        Run(const AlignOptions &options) :
+            clock((double)options.nominal_period_us, options.window, options.forget),
+            first(0),
+            last(0)
+        {
+        }
+
+        ClockEstimator clock;
+        /** Sequence numbers of values[.][0] and of the last sample. */
+        int64_t first;
+        int64_t last;
+        std::vector<float> values[HISTORY_CHANNELS];
+    };
+
+    struct Board {
+        Board() :
+            period_us(0.0),
+            samples(0),
+            missing(0),
+            filled(0),
+            run_count(0)
+        {
+        }
+
+        std::vector<Run> runs;
+        /** Last settled period, the seed of the next run. */
+        double period_us;
+        uint64_t samples;
+        uint64_t missing;
+        uint64_t filled;
+        uint32_t run_count;
+    };
+
+    AlignOptions _options;
+    std::vector<Board> _boards;
+    ResamplePlan _plan;
+};
+
+} // namespace lab
+
+#endif // LAB_TIME_ALIGNER_H
@@ -0,0 +1,122 @@
+#include "Bench.h"
+
+#include <vector>
+
+#include "Resample.h"
+#include "SyntheticStreams.h"
+#include "TimeAligner.h"
+
+/*
+ * Resampling onto the time grid. The resample benchmarks interpolate
+ * one channel of 4096 grid points from a board 150 ppm fast, an
+ * iteration being the whole column with its plan made beforehand. The
+ * align benchmark is 100 drifting boards at 10 Hz: an iteration puts a
+ * minute of all of them on the grid, six channels, plans included.
+ */
+
+namespace {
+
+const size_t LENGTH = 4096;
+const unsigned BOARDS = 100;
+const double SECONDS = 60;
+
+const std::vector<float> &column()
+{
+    static std::vector<float> values;
+    if (values.empty()) {
+        for (size_t i = 0; i < LENGTH + 16; i++) {
+            float sample[lab::HISTORY_CHANNELS];
+            lab::synthetic_table_motion(i * 0.1, sample);
+            values.push_back(sample[lab::HISTORY_A_X]);
+        }
+    }
+    return values;
+}
+
+void bench_resample(benchmark::State &state, lab::ResampleMethod method, bool simd)
+{
+    if (simd && !lab::resample_simd_available()) {
+        state.SkipWithError("no AVX2");
+        return;
+    }
+    lab::resample_use_simd(simd);
+    const std::vector<float> &input = column();
+    std::vector<float> output(LENGTH);
+    lab::ResamplePlan plan;
+    lab::resample_plan(method, 4.37, 1.0 - 150e-6, LENGTH, input.size(), plan);
+    for (auto _ : state) {
+        lab::resample(plan, input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    lab::resample_use_simd(true);
+    state.SetItemsProcessed(state.iterations() * (plan.end - plan.begin));
+}
+
+void bench_align(benchmark::State &state, lab::ResampleMethod method, bool simd)
+{
+    if (simd && !lab::resample_simd_available()) {
+        state.SkipWithError("no AVX2");
+        return;
+    }
+    lab::resample_use_simd(simd);
+    lab::SyntheticStreamOptions streams;
+    streams.boards = BOARDS;
+    lab::AlignOptions options;
+    options.method = method;
+    lab::TimeAligner aligner(options);
+    for (unsigned board = 0; board < BOARDS; board++) {
+        aligner.add_board();
+    }
+    // 2 s more, so every board covers the minute from 2 s on
+    for (const lab::SyntheticArrival &sample : lab::synthetic_streams(streams, SECONDS + 4)) {
+        aligner.add(sample.board, sample.sequence, sample.arrival_us, sample.values);
+    }
+
+    size_t length = (size_t)(SECONDS * 1000000 / options.grid_period_us);
+    lab::AlignedBlock block;
+    for (auto _ : state) {
+        aligner.align(2000000, length, block);
+        benchmark::DoNotOptimize(block.values.data());
+    }
+    lab::resample_use_simd(true);
+    state.SetItemsProcessed(state.iterations() * length * BOARDS);
+}
+
+} // namespace
+
+static void BM_ResampleLinearPortable(benchmark::State &state)
+{
+    bench_resample(state, lab::RESAMPLE_LINEAR, false);
+}
+BENCHMARK(BM_ResampleLinearPortable);
+
+static void BM_ResampleLinearAvx2(benchmark::State &state)
+{
+    bench_resample(state, lab::RESAMPLE_LINEAR, true);
+}
+BENCHMARK(BM_ResampleLinearAvx2);
+
+static void BM_ResampleSincPortable(benchmark::State &state)
+{
+    bench_resample(state, lab::RESAMPLE_SINC, false);
+}
+BENCHMARK(BM_ResampleSincPortable);
+
+static void BM_ResampleSincAvx2(benchmark::State &state)
+{
+    bench_resample(state, lab::RESAMPLE_SINC, true);
+}
+BENCHMARK(BM_ResampleSincAvx2);
+
+static void BM_Align100BoardsSincPortable(benchmark::State &state)
+{
+    bench_align(state, lab::RESAMPLE_SINC, false);
+}
+BENCHMARK(BM_Align100BoardsSincPortable);
+
+static void BM_Align100BoardsSincAvx2(benchmark::State &state)
+{
+    bench_align(state, lab::RESAMPLE_SINC, true);
+}
+BENCHMARK(BM_Align100BoardsSincAvx2);
@@ -0,0 +1,282 @@
+#include "Bench.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "BroadcastRing.h"
+
+/*
+ * The broadcast ring with telemetry sized messages.
+ *
+ * Publish: the writer flat out with 0 to 32 reader threads polling the
+ * ring. Readers that cannot keep up are lapped and the writer goes on at
+ * the same pace; the counters give the share of the messages each reader
+ * got on average and its laps.
+ *
+ * Fanout: batches of 64 messages, each batch handed to every reader before
+ * the next one, so nobody is lapped. The readers' time is not in the CPU
+ * time of the writer thread: deliveries_per_s is on the wall clock.
+ *
+ * Receive, Peek: one reader alone, copying or in place.
+ */
+
+namespace {
+
+const size_t CAPACITY = 1 << 20;
+
+const char MESSAGE[] = "{\"a_x\": 12, \"a_y\": -31, \"a_z\": 1002, \"g_x\": 175.0, \"g_y\": -8.75, "
+                       "\"g_z\": 35.0, \"s\": 12345}";
+
+/** A ring of this process, removed with it. */
+class BenchRing {
+public:
+    BenchRing()
+    {
+        snprintf(name, sizeof(name), "lab-bench-%d", (int)getpid());
+        lab::BroadcastWriter::remove(name);
+        ready = writer.open(name, CAPACITY) == 0;
+    }
+
+    ~BenchRing()
+    {
+        writer.close();
+        lab::BroadcastWriter::remove(name);
+    }
+
+    char name[32];
+    bool ready;
+    lab::BroadcastWriter writer;
+};
+
+struct ReaderThread {
+    std::thread thread;
+    uint64_t received;
+    uint64_t lapped;
+};
+
+void bench_publish(benchmark::State &state, unsigned readers)
+{
+    BenchRing ring;
+    if (!ring.ready) {
+        state.SkipWithError("no shared memory");
+        return;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned> attached(0);
+    std::vector<ReaderThread> threads(readers);
+    for (ReaderThread &reader : threads) {
+        reader.thread = std::thread([&ring, &stop, &attached, &reader] {
+            lab::BroadcastReader ring_reader;
+            ring_reader.open(ring.name);
+            attached++;
+            char buffer[256];
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (ring_reader.receive(buffer, sizeof(buffer)) <= 0) {
+                    std::this_thread::yield();
+                }
+            }
+            lab::BroadcastReaderStats stats = ring_reader.stats();
+            reader.received = stats.received;
+            reader.lapped = stats.lapped;
+        });
+    }
+    while (attached.load() < readers) {
+        std::this_thread::yield();
+    }
+
+    for (auto _ : state) {
+        ring.writer.publish(lab::BROADCAST_JSON, MESSAGE, sizeof(MESSAGE) - 1);
+    }
+
+    stop = true;
+    double received = 0;
+    double lapped = 0;
+    for (ReaderThread &reader : threads) {
+        reader.thread.join();
+        received += reader.received;
+        lapped += reader.lapped;
+    }
+    if (readers) {
+        state.counters["received"] = received / readers / state.iterations();
+        state.counters["laps"] = lapped / readers;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (sizeof(MESSAGE) - 1));
+}
+
+struct alignas(64) FanoutReader {
+    std::thread thread;
+    std::atomic<uint64_t> received;
+};
+
+void bench_fanout(benchmark::State &state, unsigned readers)
+{
+    const unsigned BATCH = 64;
+    BenchRing ring;
+    if (!ring.ready) {
+        state.SkipWithError("no shared memory");
+        return;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned> attached(0);
+    std::vector<FanoutReader> threads(readers);
+    for (FanoutReader &reader : threads) {
+        reader.received = 0;
+        reader.thread = std::thread([&ring, &stop, &attached, &reader] {
+            lab::BroadcastReader ring_reader;
+            ring_reader.open(ring.name);
+            attached++;
+            char buffer[256];
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (ring_reader.receive(buffer, sizeof(buffer)) > 0) {
+                    reader.received.fetch_add(1, std::memory_order_release);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    while (attached.load() < readers) {
+        std::this_thread::yield();
+    }
+
+    uint64_t published = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        for (unsigned i = 0; i < BATCH; i++) {
+            ring.writer.publish(lab::BROADCAST_JSON, MESSAGE, sizeof(MESSAGE) - 1);
+        }
+        published += BATCH;
+        for (FanoutReader &reader : threads) {
+            while (reader.received.load(std::memory_order_acquire) < published) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    stop = true;
+    for (FanoutReader &reader : threads) {
+        reader.thread.join();
+    }
+    state.counters["deliveries_per_s"] = published * readers / elapsed.count();
+}
+
+/** One reader draining batches of 1024 messages. */
+void bench_receive(benchmark::State &state, bool in_place)
+{
+    BenchRing ring;
+    lab::BroadcastReader reader;
+    if (!ring.ready || reader.open(ring.name) != 0) {
+        state.SkipWithError("no shared memory");
+        return;
+    }
+    char buffer[256];
+    uint64_t bytes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < 1024; i++) {
+            ring.writer.publish(lab::BROADCAST_JSON, MESSAGE, sizeof(MESSAGE) - 1);
+        }
+        state.ResumeTiming();
+        if (in_place) {
+            lab::BroadcastMessage message;
+            while (reader.peek(message)) {
+                // what a consumer would do with it, on the ring memory
+                bytes += memchr(message.data, '}', message.length) != nullptr;
+                reader.consume();
+            }
+        } else {
+            while (reader.receive(buffer, sizeof(buffer)) > 0) {
+                bytes += buffer[0] == '{';
+            }
+        }
+    }
+    benchmark::DoNotOptimize(bytes);
+    state.counters["laps"] = reader.stats().lapped;
+    state.SetItemsProcessed(state.iterations() * 1024);
+    state.SetBytesProcessed(state.iterations() * 1024 * (sizeof(MESSAGE) - 1));
+}
+
+} // namespace
+
+static void BM_BroadcastPublish0Readers(benchmark::State &state)
+{
+    bench_publish(state, 0);
+}
+BENCHMARK(BM_BroadcastPublish0Readers);
+
+static void BM_BroadcastPublish1Reader(benchmark::State &state)
+{
+    bench_publish(state, 1);
+}
+BENCHMARK(BM_BroadcastPublish1Reader);
+
+static void BM_BroadcastPublish4Readers(benchmark::State &state)
+{
+    bench_publish(state, 4);
+}
+BENCHMARK(BM_BroadcastPublish4Readers);
+
+static void BM_BroadcastPublish8Readers(benchmark::State &state)
+{
+    bench_publish(state, 8);
+}
+BENCHMARK(BM_BroadcastPublish8Readers);
+
+static void BM_BroadcastPublish16Readers(benchmark::State &state)
+{
+    bench_publish(state, 16);
+}
+BENCHMARK(BM_BroadcastPublish16Readers);
+
+static void BM_BroadcastPublish32Readers(benchmark::State &state)
+{
+    bench_publish(state, 32);
+}
+BENCHMARK(BM_BroadcastPublish32Readers);
+
+static void BM_BroadcastFanout1Reader(benchmark::State &state)
+{
+    bench_fanout(state, 1);
+}
+BENCHMARK(BM_BroadcastFanout1Reader);
+
+static void BM_BroadcastFanout4Readers(benchmark::State &state)
+{
+    bench_fanout(state, 4);
+}
+BENCHMARK(BM_BroadcastFanout4Readers);
+
+static void BM_BroadcastFanout16Readers(benchmark::State &state)
+{
+    bench_fanout(state, 16);
+}
+BENCHMARK(BM_BroadcastFanout16Readers);
+
+static void BM_BroadcastFanout32Readers(benchmark::State &state)
+{
+    bench_fanout(state, 32);
+}
+BENCHMARK(BM_BroadcastFanout32Readers);
+
+static void BM_BroadcastReceive(benchmark::State &state)
+{
+    bench_receive(state, false);
+}
+BENCHMARK(BM_BroadcastReceive);
+
+static void BM_BroadcastPeek(benchmark::State &state)
+{
+    bench_receive(state, true);
+}
+BENCHMARK(BM_BroadcastPeek);
@@ -0,0 +1,95 @@
+#include "Bench.h"
+
+#include <chrono>
+#include <vector>
+
+#include "MotionDetector.h"
+#include "SyntheticEvents.h"
+#include "SyntheticImu.h"
+
+/*
+ * The motion detector on 10 000 synthetic boards at 100 Hz, knocks and
+ * spins included: an iteration is one tick, a sample of every board
+ * staged with add() as the decoder would, then the frame. Sparse is a
+ * tick where one board in 16 has a sample. core_at_100hz is the share
+ * of this core the detector needs to keep up, on the wall clock.
+ */
+
+namespace {
+
+const unsigned DEVICES = 10000;
+const unsigned RATE_HZ = 100;
+const int64_t PERIOD_US = 1000000 / RATE_HZ;
+const unsigned TICKS = 20;
+
+/** TICKS samples of every board, tick after tick. */
+const std::vector<lab::HistorySample> &ticks()
+{
+    static std::vector<lab::HistorySample> samples;
+    if (samples.empty()) {
+        samples.resize((size_t)DEVICES * TICKS);
+        for (unsigned tick = 0; tick < TICKS; tick++) {
+            for (unsigned device = 0; device < DEVICES; device++) {
+                lab::HistorySample &sample = samples[(size_t)tick * DEVICES + device];
+                // 10 s in, where the first knocks are
+                uint64_t index = 10 * RATE_HZ + tick;
+                lab::synthetic_imu(&sample, 1, device, index, 0, PERIOD_US);
+                lab::synthetic_events(sample, device, index, RATE_HZ);
+            }
+        }
+    }
+    return samples;
+}
+
+void bench_detect(benchmark::State &state, bool simd, unsigned stride)
+{
+    const std::vector<lab::HistorySample> &samples = ticks();
+    lab::MotionDetector detector;
+    detector.use_simd(simd);
+    detector.resize(DEVICES);
+    if (simd && !detector.simd_active()) {
+        state.SkipWithError("no AVX2");
+        return;
+    }
+
+    uint64_t tick = 0;
+    size_t alerts = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        const lab::HistorySample *frame = &samples[(tick % TICKS) * DEVICES];
+        // the time goes on when the ticks come round again
+        int64_t time_us = (int64_t)tick * PERIOD_US;
+        for (unsigned device = (unsigned)(tick % stride); device < DEVICES; device += stride) {
+            detector.add(device, time_us, frame[device].values);
+        }
+        detector.flush();
+        alerts += detector.alerts().size();
+        detector.clear_alerts();
+        tick++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    state.counters["core_at_100hz"] = elapsed.count() / state.iterations() * RATE_HZ;
+    state.counters["alerts"] = (double)alerts;
+    state.SetItemsProcessed(state.iterations() * (DEVICES / stride));
+}
+
+} // namespace
+
+static void BM_Detect10kPortable(benchmark::State &state)
+{
+    bench_detect(state, false, 1);
+}
+BENCHMARK(BM_Detect10kPortable);
+
+static void BM_Detect10kAvx2(benchmark::State &state)
+{
+    bench_detect(state, true, 1);
+}
+BENCHMARK(BM_Detect10kAvx2);
+
+static void BM_Detect10kSparseAvx2(benchmark::State &state)
+{
+    bench_detect(state, true, 16);
+}
+BENCHMARK(BM_Detect10kSparseAvx2);
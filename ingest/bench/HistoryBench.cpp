@@ -0,0 +1,230 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include "SensorHistory.h"
+#include "SyntheticImu.h"
+
+/*
+ * The sensor history on synthetic data: the rollup kernels alone, AVX2
+ * and portable, ingest with the tiers kept up to date, and queries over
+ * two days of one board at 10 Hz (1.7 M samples), with the tiers and
+ * over the raw samples only. Queries start 90 s past the hour so the
+ * edges of every bucket come from the finer tiers and the samples.
+ */
+
+namespace {
+
+const int64_t START_US = 1704067200ll * 1000000; // 2024-01-01
+const int64_t PERIOD_US = 100000;
+const uint64_t DAY_SAMPLES = 864000;
+
+/** A history in a temporary directory, removed with it. */
+class TemporaryHistory {
+public:
+    TemporaryHistory()
+    {
+        const char *base = getenv("TMPDIR");
+        _path = std::string(base ? base : "/tmp") + "/lab-history-XXXXXX";
+        if (!mkdtemp(&_path[0]) || history.open(_path.c_str(), true) != 0) {
+            _path.clear();
+        }
+    }
+
+    ~TemporaryHistory()
+    {
+        history.close();
+        DIR *dir = _path.empty() ? nullptr : opendir(_path.c_str());
+        if (!dir) {
+            return;
+        }
+        while (struct dirent *entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') {
+                unlink((_path + "/" + entry->d_name).c_str());
+            }
+        }
+        closedir(dir);
+        rmdir(_path.c_str());
+    }
+
+    bool ready() const
+    {
+        return !_path.empty();
+    }
+
+    lab::SensorHistory history;
+
+private:
+    std::string _path;
+};
+
+/** Two days of board-000, built on first use. */
+TemporaryHistory &two_days()
+{
+    static TemporaryHistory store;
+    static bool filled = false;
+    if (!filled && store.ready()) {
+        std::vector<lab::HistorySample> batch(65536);
+        int device = store.history.add_device("board-000");
+        for (uint64_t index = 0; index < 2 * DAY_SAMPLES; index += batch.size()) {
+            size_t length = std::min<uint64_t>(batch.size(), 2 * DAY_SAMPLES - index);
+            lab::synthetic_imu(batch.data(), length, 0, index, START_US, PERIOD_US);
+            store.history.ingest(device, batch.data(), length);
+        }
+        filled = true;
+    }
+    return store;
+}
+
+void bench_samples(benchmark::State &state, bool simd)
+{
+    static float values[16384];
+    for (size_t i = 0; i < 16384; i++) {
+        values[i] = (float)((i * 7919) % 2001) - 1000.0f;
+    }
+    lab::rollup_use_simd(simd);
+    for (auto _ : state) {
+        lab::RollupStats stats;
+        lab::rollup_samples(values, 16384, stats);
+        benchmark::DoNotOptimize(stats);
+    }
+    state.counters["avx2"] = lab::rollup_simd_active();
+    lab::rollup_use_simd(true);
+    state.SetItemsProcessed(state.iterations() * 16384);
+    state.SetBytesProcessed(state.iterations() * sizeof(values));
+}
+
+void bench_buckets(benchmark::State &state, bool simd)
+{
+    static uint32_t counts[1024];
+    static float mins[1024];
+    static float maxs[1024];
+    static double sums[1024];
+    static double squares[1024];
+    for (size_t i = 0; i < 1024; i++) {
+        counts[i] = 600;
+        mins[i] = -(float)(i % 97);
+        maxs[i] = (float)(i % 89);
+        sums[i] = 600.0 * (i % 13);
+        squares[i] = 6e4 * (i % 17);
+    }
+    lab::RollupColumns columns = { counts, mins, maxs, sums, squares };
+    lab::rollup_use_simd(simd);
+    for (auto _ : state) {
+        lab::RollupStats stats;
+        lab::rollup_buckets(columns, 0, 1024, stats);
+        benchmark::DoNotOptimize(stats);
+    }
+    state.counters["avx2"] = lab::rollup_simd_active();
+    lab::rollup_use_simd(true);
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+/** Hourly or per-minute rollups of a_z over the two days. */
+void bench_query(benchmark::State &state, int64_t bucket_us, bool use_tiers)
+{
+    TemporaryHistory &store = two_days();
+    if (!store.ready()) {
+        state.SkipWithError("no temporary directory");
+        return;
+    }
+    lab::RollupQuery query(lab::HISTORY_A_Z, START_US + 90 * 1000000ll, START_US + 2 * 86400 * 1000000ll, bucket_us);
+    query.use_tiers = use_tiers;
+    std::vector<lab::Rollup> rollups;
+    for (auto _ : state) {
+        rollups.clear();
+        store.history.query(0, query, rollups);
+        benchmark::DoNotOptimize(rollups.data());
+    }
+    state.counters["buckets"] = rollups.size();
+    // samples covered by the query, whatever it read
+    state.SetItemsProcessed(state.iterations() * (2 * DAY_SAMPLES - 900));
+}
+
+} // namespace
+
+static void BM_RollupSamplesPortable(benchmark::State &state)
+{
+    bench_samples(state, false);
+}
+BENCHMARK(BM_RollupSamplesPortable);
+
+static void BM_RollupSamplesAvx2(benchmark::State &state)
+{
+    bench_samples(state, true);
+}
+BENCHMARK(BM_RollupSamplesAvx2);
+
+static void BM_RollupBucketsPortable(benchmark::State &state)
+{
+    bench_buckets(state, false);
+}
+BENCHMARK(BM_RollupBucketsPortable);
+
+static void BM_RollupBucketsAvx2(benchmark::State &state)
+{
+    bench_buckets(state, true);
+}
+BENCHMARK(BM_RollupBucketsAvx2);
+
+static void BM_HistoryIngest(benchmark::State &state)
+{
+    // a fresh device every 256 batches keeps the files at 1 M samples
+    TemporaryHistory store;
+    if (!store.ready()) {
+        state.SkipWithError("no temporary directory");
+        return;
+    }
+    std::vector<lab::HistorySample> batch(4096);
+    uint64_t index = 0;
+    int device = -1;
+    unsigned devices = 0;
+    for (auto _ : state) {
+        if (index % (256 * batch.size()) == 0) {
+            state.PauseTiming();
+            char name[32];
+            snprintf(name, sizeof(name), "board-%03u", devices++);
+            device = store.history.add_device(name);
+            index = 0;
+            state.ResumeTiming();
+        }
+        state.PauseTiming();
+        lab::synthetic_imu(batch.data(), batch.size(), 0, index, START_US, PERIOD_US);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(store.history.ingest(device, batch.data(), batch.size()));
+        index += batch.size();
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_HistoryIngest);
+
+static void BM_QueryHourlyTiers(benchmark::State &state)
+{
+    bench_query(state, 3600 * 1000000ll, true);
+}
+BENCHMARK(BM_QueryHourlyTiers);
+
+static void BM_QueryHourlyRaw(benchmark::State &state)
+{
+    bench_query(state, 3600 * 1000000ll, false);
+}
+BENCHMARK(BM_QueryHourlyRaw);
+
+static void BM_QueryMinuteTiers(benchmark::State &state)
+{
+    bench_query(state, 60 * 1000000ll, true);
+}
+BENCHMARK(BM_QueryMinuteTiers);
+
+static void BM_QueryWholeTiers(benchmark::State &state)
+{
+    bench_query(state, 0, true);
+}
+BENCHMARK(BM_QueryWholeTiers);
@@ -0,0 +1,339 @@
+#include "BroadcastRing.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace lab {
+
+namespace {
+
+const char MAGIC[8] = "LABCAST";
+const uint32_t VERSION = 1;
+const size_t HEADER_SIZE = sizeof(BroadcastHeader);
+
+static_assert(HEADER_SIZE % 64 == 0, "records start on a cache line");
+static_assert(sizeof(std::atomic<uint64_t>) == 8 && sizeof(std::atomic<uint32_t>) == 4,
+              "the shared header holds plain words");
+
+std::string shm_name(const char *name)
+{
+    return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+}
+
+size_t record_size(size_t length)
+{
+    return (sizeof(BroadcastRecord) + length + 7) & ~(size_t)7;
+}
+
+uint32_t *futex_word(const BroadcastHeader *header)
+{
+    return reinterpret_cast<uint32_t *>(const_cast<std::atomic<uint32_t> *>(&header->wakeups));
+}
+
+} // namespace
+
+BroadcastWriter::BroadcastWriter() :
+    _header(nullptr),
+    _ring(nullptr),
+    _size(0),
+    _mask(0)
+{
+}
+
+BroadcastWriter::~BroadcastWriter()
+{
+    close();
+}
+
+int BroadcastWriter::open(const char *name, size_t capacity)
+{
+    close();
+    if (capacity < 4096 || (capacity & (capacity - 1))) {
+        errno = EINVAL;
+        return -1;
+    }
+    int fd = shm_open(shm_name(name).c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t size = HEADER_SIZE + capacity;
+    struct stat info;
+    bool fresh = fstat(fd, &info) == 0 && info.st_size == 0;
+    if ((fresh && ftruncate(fd, size) != 0) || (!fresh && (size_t)info.st_size != size)) {
+        ::close(fd);
+        errno = EEXIST;
+        return -1;
+    }
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    BroadcastHeader *header = static_cast<BroadcastHeader *>(map);
+    if (fresh) {
+        // zero filled, the atomics are 0; the magic goes last, readers wait for it
+        header->version = VERSION;
+        header->capacity = capacity;
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(header->magic, MAGIC, sizeof(header->magic));
+    } else if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->version != VERSION ||
+               header->capacity != capacity) {
+        munmap(map, size);
+        errno = EEXIST;
+        return -1;
+    }
+    // a record torn by a writer that died is behind the tail, never read
+    header->tail_intent.store(header->tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    _header = header;
+    _ring = static_cast<uint8_t *>(map) + HEADER_SIZE;
+    _size = size;
+    _mask = capacity - 1;
+    return 0;
+}
+
+void BroadcastWriter::close()
+{
+    if (_header) {
+        munmap(_header, _size);
+    }
+    _header = nullptr;
+    _ring = nullptr;
+}
+
+int BroadcastWriter::publish(uint32_t type, const void *data, size_t length)
+{
+    uint64_t capacity = _mask + 1;
+    if (!_header || type == 0 || length == 0 || length > capacity / 8) {
+        return -1;
+    }
+    uint64_t tail = _header->tail.load(std::memory_order_relaxed);
+    size_t index = tail & _mask;
+    size_t size = record_size(length);
+    uint64_t start = tail;
+    if (size > capacity - index) {
+        // no record across the end: pad to it and start over at 0
+        start += capacity - index;
+    }
+    uint64_t end = start + size;
+
+    // announce what gets overwritten before overwriting it
+    _header->tail_intent.store(end, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (start != tail) {
+        BroadcastRecord padding = { (uint32_t)(start - tail - sizeof(BroadcastRecord)), 0 };
+        memcpy(_ring + index, &padding, sizeof(padding));
+    }
+    BroadcastRecord record = { (uint32_t)length, type };
+    uint8_t *at = _ring + (start & _mask);
+    memcpy(at, &record, sizeof(record));
+    memcpy(at + sizeof(record), data, length);
+
+    _header->latest.store(start, std::memory_order_relaxed);
+    _header->messages.store(_header->messages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    _header->tail.store(end, std::memory_order_release);
+    return 0;
+}
+
+void BroadcastWriter::notify()
+{
+    if (!_header) {
+        return;
+    }
+    _header->wakeups.fetch_add(1, std::memory_order_release);
+    syscall(SYS_futex, futex_word(_header), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+int BroadcastWriter::remove(const char *name)
+{
+    return shm_unlink(shm_name(name).c_str());
+}
+
+BroadcastReader::BroadcastReader() :
+    _header(nullptr),
+    _ring(nullptr),
+    _size(0),
+    _mask(0),
+    _cursor(0),
+    _next(0),
+    _length(0),
+    _received(0),
+    _lapped(0),
+    _lost_bytes(0)
+{
+}
+
+BroadcastReader::~BroadcastReader()
+{
+    close();
+}
+
+int BroadcastReader::open(const char *name)
+{
+    close();
+    int fd = shm_open(shm_name(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < HEADER_SIZE + 4096) {
+        ::close(fd);
+        errno = EAGAIN;
+        return -1;
+    }
+    size_t size = info.st_size;
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+
+    const BroadcastHeader *header = static_cast<const BroadcastHeader *>(map);
+    bool ready = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (!ready || header->version != VERSION || header->capacity + HEADER_SIZE != size) {
+        munmap(map, size);
+        errno = EAGAIN;
+        return -1;
+    }
+
+    _header = header;
+    _ring = static_cast<const uint8_t *>(map) + HEADER_SIZE;
+    _size = size;
+    _mask = header->capacity - 1;
+    _cursor = header->tail.load(std::memory_order_acquire);
+    _next = 0;
+    _received = 0;
+    _lapped = 0;
+    _lost_bytes = 0;
+    return 0;
+}
+
+void BroadcastReader::close()
+{
+    if (_header) {
+        munmap(const_cast<BroadcastHeader *>(_header), _size);
+    }
+    _header = nullptr;
+    _ring = nullptr;
+}
+
+bool BroadcastReader::intact(uint64_t position) const
+{
+    // reads of the ring before, the writer's announcement after
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return _header->tail_intent.load(std::memory_order_relaxed) <= position + _mask + 1;
+}
+
+void BroadcastReader::lap()
+{
+    uint64_t latest = _header->latest.load(std::memory_order_acquire);
+    _lapped++;
+    _lost_bytes += latest > _cursor ? latest - _cursor : 0;
+    _cursor = latest;
+    _next = 0;
+}
+
+bool BroadcastReader::peek(BroadcastMessage &message)
+{
+    if (!_header) {
+        return false;
+    }
+    _next = 0;
+    while (_cursor < _header->tail.load(std::memory_order_acquire)) {
+        size_t index = _cursor & _mask;
+        BroadcastRecord record;
+        memcpy(&record, _ring + index, sizeof(record));
+        size_t size = record_size(record.length);
+        // a record header read while it was overwritten is not used
+        if (!intact(_cursor) || index + size > _mask + 1) {
+            lap();
+            continue;
+        }
+        if (record.type == 0) {
+            _cursor += size;
+            continue;
+        }
+        message.data = _ring + index + sizeof(record);
+        message.length = record.length;
+        message.type = record.type;
+        _length = record.length;
+        _next = _cursor + size;
+        return true;
+    }
+    return false;
+}
+
+bool BroadcastReader::consume()
+{
+    if (!_next) {
+        return false;
+    }
+    if (!intact(_cursor)) {
+        lap();
+        return false;
+    }
+    _cursor = _next;
+    _next = 0;
+    _received++;
+    return true;
+}
+
+long BroadcastReader::receive(void *buffer, size_t size, uint32_t *type)
+{
+    BroadcastMessage message;
+    while (peek(message)) {
+        if (type) {
+            *type = message.type;
+        }
+        if (message.length > size) {
+            _next = 0;
+            return -1;
+        }
+        memcpy(buffer, message.data, message.length);
+        if (consume()) {
+            return (long)message.length;
+        }
+    }
+    return 0;
+}
+
+bool BroadcastReader::wait(int timeout_ms)
+{
+    if (!_header) {
+        return false;
+    }
+    uint32_t seen = _header->wakeups.load(std::memory_order_acquire);
+    if (_cursor < _header->tail.load(std::memory_order_acquire)) {
+        return true;
+    }
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+    syscall(SYS_futex, futex_word(_header), FUTEX_WAIT, seen, timeout_ms < 0 ? nullptr : &timeout, nullptr, 0);
+    return _cursor < _header->tail.load(std::memory_order_acquire);
+}
+
+BroadcastReaderStats BroadcastReader::stats() const
+{
+    BroadcastReaderStats stats;
+    uint64_t tail = _header ? _header->tail.load(std::memory_order_acquire) : _cursor;
+    stats.received = _received;
+    stats.lag_bytes = tail > _cursor ? tail - _cursor : 0;
+    stats.lapped = _lapped;
+    stats.lost_bytes = _lost_bytes;
+    return stats;
+}
+
+} // namespace lab
@@ -0,0 +1,206 @@
+#ifndef LAB_BROADCAST_RING_H
+#define LAB_BROADCAST_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** Type of the telemetry messages server.py publishes, one JSON object each. */
+static const uint32_t BROADCAST_JSON = 1;
+/** Type of the alerts of tools/detect, one JSON object each. */
+static const uint32_t BROADCAST_ALERT = 2;
+
+/**
+ * Shared memory layout of a broadcast ring: this header, then the ring
+ * of records. Every record starts with a BroadcastRecord and is padded
+ * to 8 bytes; a record of type 0 pads the end of the ring before a wrap.
+ * Positions are byte counts since the ring was created, they never wrap.
+ */
+struct BroadcastHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t capacity;
+
+    /** End of the record being written: the ring is overwritten up to it. */
+    alignas(64) std::atomic<uint64_t> tail_intent;
+    /** End of the last complete record. */
+    alignas(64) std::atomic<uint64_t> tail;
+    /** Start of the last complete record, where a lapped reader resumes. */
+    std::atomic<uint64_t> latest;
+    /** Messages published. */
+    std::atomic<uint64_t> messages;
+    /** Bumped by notify(), readers sleep on it with a futex. */
+    alignas(64) std::atomic<uint32_t> wakeups;
+};
+
+struct BroadcastRecord {
+    uint32_t length;
+    uint32_t type;
+};
+
+/** Where a reader stands, see BroadcastReader. */
+struct BroadcastReaderStats {
+    uint64_t received;
+    /** Bytes published and not read yet. */
+    uint64_t lag_bytes;
+    /** Times the writer overwrote what the reader had not read. */
+    uint64_t lapped;
+    /** Bytes of messages skipped because of that. */
+    uint64_t lost_bytes;
+};
+
+/**
+ * Writer of a broadcast ring in POSIX shared memory: one writer, any
+ * number of readers in any process.
+ *
+ * Readers only map the ring read-only and keep their cursor to
+ * themselves, so the writer never waits for them and never knows how
+ * many there are: publish() costs a copy into the ring and three
+ * stores, with 1 or 32 readers alike. A reader that falls more than the
+ * capacity behind is lapped; it learns so, with the bytes it lost, and
+ * carries on from the newest message.
+ */
+class BroadcastWriter {
+public:
+    BroadcastWriter();
+    ~BroadcastWriter();
+
+    BroadcastWriter(const BroadcastWriter &) = delete;
+    BroadcastWriter &operator=(const BroadcastWriter &) = delete;
+
+    /**
+     * Create the ring /name, or take over an existing one of the same
+     * capacity where the last writer left it.
+     *
+     * @param[in] capacity Bytes, a power of two of at least 4096.
+     * @return 0, or -1.
+     */
+    int open(const char *name, size_t capacity);
+
+    void close();
+
+    /**
+     * Copy a message into the ring.
+     *
+     * @param[in] type Application defined, not 0.
+     * @return 0, or -1 if the message is empty, can never fit (capacity
+     * / 8 bytes at most) or the ring is not open.
+     */
+    int publish(uint32_t type, const void *data, size_t length);
+
+    /**
+     * Wake up the readers sleeping in wait(). A system call: once per
+     * batch of messages, not per message.
+     */
+    void notify();
+
+    /** Remove the ring /name; mappings still open keep working. */
+    static int remove(const char *name);
+
+    const BroadcastHeader *header() const
+    {
+        return _header;
+    }
+
+private:
+    BroadcastHeader *_header;
+    uint8_t *_ring;
+    size_t _size;
+    uint64_t _mask;
+};
+
+/** A message in place in the ring, see BroadcastReader::peek(). */
+struct BroadcastMessage {
+    const void *data;
+    size_t length;
+    uint32_t type;
+};
+
+/**
+ * One reader of a broadcast ring, with its own cursor.
+ *
+ * receive() copies the next message out and checks it was not
+ * overwritten meanwhile. peek() and consume() read it in place instead:
+ * the data may be overwritten while the reader works on it, so whatever
+ * was made of it is only good if consume() returns true.
+ *
+ * Not thread-safe: one reader per thread.
+ */
+class BroadcastReader {
+public:
+    BroadcastReader();
+    ~BroadcastReader();
+
+    BroadcastReader(const BroadcastReader &) = delete;
+    BroadcastReader &operator=(const BroadcastReader &) = delete;
+
+    /**
+     * Map the ring /name, read-only. The reader starts with the next
+     * message published.
+     *
+     * @return 0, or -1 if there is no ring of that name yet.
+     */
+    int open(const char *name);
+
+    void close();
+
+    /** @return whether a message is there, in message. */
+    bool peek(BroadcastMessage &message);
+
+    /**
+     * Move past the message of peek().
+     *
+     * @return false if it was overwritten before this call; the reader
+     * then counts a lap and goes on with the newest message.
+     */
+    bool consume();
+
+    /**
+     * Copy the next message into buffer.
+     *
+     * @return its length, 0 if there is none, or -1 if it is larger than
+     * size (it stays next, type holds its type and length() its size).
+     */
+    long receive(void *buffer, size_t size, uint32_t *type = nullptr);
+
+    /**
+     * Sleep until the writer calls notify() or timeout_ms passes (-1
+     * for no timeout), unless a message is already there.
+     *
+     * @return true if a message is there.
+     */
+    bool wait(int timeout_ms);
+
+    BroadcastReaderStats stats() const;
+
+    /** Length of the message of the last peek() or failed receive(). */
+    size_t length() const
+    {
+        return _length;
+    }
+
+private:
+    /** Cursor overwritten by the writer: resume at the newest message. */
+    void lap();
+    /** Whether nothing from position on can have been overwritten yet. */
+    bool intact(uint64_t position) const;
+
+    const BroadcastHeader *_header;
+    const uint8_t *_ring;
+    size_t _size;
+    uint64_t _mask;
+    uint64_t _cursor;
+    /** Position after the message of peek(), 0 if none. */
+    uint64_t _next;
+    size_t _length;
+    uint64_t _received;
+    uint64_t _lapped;
+    uint64_t _lost_bytes;
+};
+
+} // namespace lab
+
+#endif // LAB_BROADCAST_RING_H
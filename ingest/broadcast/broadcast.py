@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+"""Python side of the broadcast ring of the ingest host.
+
+Binds liblab_broadcast.so (BroadcastRing.h, lab_broadcast.h) with
+ctypes. The library is taken from LAB_BROADCAST_LIB, else from the
+build-ingest directory of the repository, else from the library path.
+
+    writer = broadcast.Writer('lab-telemetry')
+    writer.publish(broadcast.JSON, line.encode())
+    writer.notify()
+
+    reader = broadcast.Reader('lab-telemetry')
+    for kind, data in reader.messages(timeout=1.0):
+        ...
+
+    python3 broadcast.py tail lab-telemetry     # print what server.py publishes
+    python3 broadcast.py selftest               # writer and reader in two processes
+"""
+
+import argparse
+import ctypes
+import ctypes.util
+import os
+import sys
+import time
+
+JSON = 1
+ALERT = 2
+DEFAULT_CAPACITY = 1 << 22
+
+
+class Stats(ctypes.Structure):
+    _fields_ = [('received', ctypes.c_uint64),
+                ('lag_bytes', ctypes.c_uint64),
+                ('lapped', ctypes.c_uint64),
+                ('lost_bytes', ctypes.c_uint64)]
+
+
+def _load():
+    here = os.path.dirname(os.path.abspath(__file__))
+    candidates = [os.environ.get('LAB_BROADCAST_LIB'),
+                  os.path.join(here, '..', '..', 'build-ingest', 'liblab_broadcast.so'),
+                  ctypes.util.find_library('lab_broadcast')]
+    for path in candidates:
+        if path and (os.path.exists(path) or not os.path.dirname(path)):
+            break
+    else:
+        raise OSError('liblab_broadcast.so not found, build ingest/ or set LAB_BROADCAST_LIB')
+    lib = ctypes.CDLL(path, use_errno=True)
+
+    lib.lab_broadcast_writer_open.argtypes = [ctypes.c_char_p, ctypes.c_size_t]
+    lib.lab_broadcast_writer_open.restype = ctypes.c_void_p
+    lib.lab_broadcast_publish.argtypes = [ctypes.c_void_p, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_size_t]
+    lib.lab_broadcast_publish.restype = ctypes.c_int
+    lib.lab_broadcast_notify.argtypes = [ctypes.c_void_p]
+    lib.lab_broadcast_writer_close.argtypes = [ctypes.c_void_p]
+    lib.lab_broadcast_remove.argtypes = [ctypes.c_char_p]
+    lib.lab_broadcast_remove.restype = ctypes.c_int
+
+    lib.lab_broadcast_reader_open.argtypes = [ctypes.c_char_p]
+    lib.lab_broadcast_reader_open.restype = ctypes.c_void_p
+    lib.lab_broadcast_receive.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t,
+                                          ctypes.POINTER(ctypes.c_uint32)]
+    lib.lab_broadcast_receive.restype = ctypes.c_long
+    lib.lab_broadcast_length.argtypes = [ctypes.c_void_p]
+    lib.lab_broadcast_length.restype = ctypes.c_size_t
+    lib.lab_broadcast_wait.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.lab_broadcast_wait.restype = ctypes.c_int
+    lib.lab_broadcast_reader_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(Stats)]
+    lib.lab_broadcast_reader_close.argtypes = [ctypes.c_void_p]
+    return lib
+
+
+_lib = None
+
+
+def lib():
+    global _lib
+    if _lib is None:
+        _lib = _load()
+    return _lib
+
+
+def _error(what, name):
+    errno = ctypes.get_errno()
+    return OSError(errno, '%s %s: %s' % (what, name, os.strerror(errno)))
+
+
+class Writer:
+    """The one writer of a ring; never waits for the readers."""
+
+    def __init__(self, name, capacity=DEFAULT_CAPACITY):
+        self.handle = lib().lab_broadcast_writer_open(name.encode(), capacity)
+        if not self.handle:
+            raise _error('cannot create ring', name)
+
+    def publish(self, kind, data):
+        """False if the message is empty or larger than capacity / 8."""
+        return lib().lab_broadcast_publish(self.handle, kind, data, len(data)) == 0
+
+    def notify(self):
+        """Wake up the waiting readers, once per batch."""
+        lib().lab_broadcast_notify(self.handle)
+
+    def close(self):
+        if self.handle:
+            lib().lab_broadcast_writer_close(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+    @staticmethod
+    def remove(name):
+        return lib().lab_broadcast_remove(name.encode()) == 0
+
+
+class Reader:
+    """One reader with its own cursor, from the next message on."""
+
+    def __init__(self, name):
+        self.handle = lib().lab_broadcast_reader_open(name.encode())
+        if not self.handle:
+            raise _error('cannot open ring', name)
+        self.buffer = ctypes.create_string_buffer(4096)
+
+    def receive(self):
+        """(type, bytes) of the next message, None if there is none."""
+        kind = ctypes.c_uint32()
+        while True:
+            length = lib().lab_broadcast_receive(self.handle, self.buffer, len(self.buffer), ctypes.byref(kind))
+            if length > 0:
+                return kind.value, self.buffer.raw[:length]
+            if length == 0:
+                return None
+            self.buffer = ctypes.create_string_buffer(lib().lab_broadcast_length(self.handle))
+
+    def wait(self, timeout=None):
+        """True once a message is there, False after timeout seconds."""
+        ms = -1 if timeout is None else int(timeout * 1000)
+        return lib().lab_broadcast_wait(self.handle, ms) != 0
+
+    def messages(self, timeout=None):
+        """Messages as they come; stops after timeout seconds without any."""
+        while True:
+            message = self.receive()
+            if message:
+                yield message
+            elif not self.wait(timeout):
+                return
+
+    def stats(self):
+        """received, lag_bytes, lapped and lost_bytes."""
+        stats = Stats()
+        lib().lab_broadcast_reader_stats(self.handle, ctypes.byref(stats))
+        return {name: getattr(stats, name) for name, _ in Stats._fields_}
+
+    def close(self):
+        if self.handle:
+            lib().lab_broadcast_reader_close(self.handle)
+            self.handle = None
+
+    def __del__(self):
+        self.close()
+
+
+def selftest(count=2000):
+    """A reader process gets every message in order, a stalled one is lapped."""
+    name = 'lab-selftest-%d' % os.getpid()
+    Writer.remove(name)
+    writer = Writer(name, 1 << 16)
+    ready_read, ready_write = os.pipe()
+    child = os.fork()
+    if child == 0:
+        os.close(ready_read)
+        reader = Reader(name)
+        os.write(ready_write, b'1')
+        expected = 0
+        for kind, data in reader.messages(timeout=5.0):
+            if kind != JSON or data != b'{"s": %d}' % expected:
+                os._exit(1)
+            expected += 1
+            if expected == count:
+                os._exit(0)
+        os._exit(2)
+    os.close(ready_write)
+    os.read(ready_read, 1)
+    stalled = Reader(name)
+    for i in range(count):
+        writer.publish(JSON, b'{"s": %d}' % i)
+        if i % 100 == 99:
+            writer.notify()
+    writer.notify()
+    _, status = os.waitpid(child, 0)
+    # four times the ring
+    total = count + (1 << 18) // len(b'{"s": %d}' % count)
+    for i in range(count, total):
+        writer.publish(JSON, b'{"s": %d}' % i)
+
+    last = None
+    for last in stalled.messages(timeout=0):
+        pass
+    stats = stalled.stats()
+    writer.close()
+    Writer.remove(name)
+    if os.WEXITSTATUS(status) != 0:
+        sys.exit('reader process failed: %d' % os.WEXITSTATUS(status))
+    if not stats['lapped'] or last != (JSON, b'{"s": %d}' % (total - 1)):
+        sys.exit('stalled reader: %s, last %s' % (stats, last))
+    print('ok: %d messages, stalled reader %s' % (count, stats))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    commands = parser.add_subparsers(dest='command', required=True)
+    tail = commands.add_parser('tail', help='print the messages of a ring')
+    tail.add_argument('name')
+    tail.add_argument('--stats', type=float, metavar='SECONDS',
+                      help='print the lag and overruns this often on stderr')
+    remove = commands.add_parser('remove', help='remove a ring')
+    remove.add_argument('name')
+    commands.add_parser('selftest', help='check the library with two processes')
+    options = parser.parse_args()
+
+    if options.command == 'selftest':
+        selftest()
+        return
+
+    if options.command == 'remove':
+        if not Writer.remove(options.name):
+            sys.exit('no ring %s' % options.name)
+        return
+
+    reader = Reader(options.name)
+    last = time.monotonic()
+    try:
+        while True:
+            message = reader.receive()
+            if message:
+                kind, data = message
+                print(data.decode('utf-8', 'replace') if kind in (JSON, ALERT) else '<%d: %d bytes>' % (kind, len(data)))
+            else:
+                reader.wait(0.5)
+            if options.stats and time.monotonic() - last >= options.stats:
+                last = time.monotonic()
+                print(reader.stats(), file=sys.stderr)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
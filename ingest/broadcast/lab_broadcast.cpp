@@ -0,0 +1,80 @@
+#include "lab_broadcast.h"
+
+#include "BroadcastRing.h"
+
+struct lab_broadcast_writer {
+    lab::BroadcastWriter writer;
+};
+
+struct lab_broadcast_reader {
+    lab::BroadcastReader reader;
+};
+
+lab_broadcast_writer *lab_broadcast_writer_open(const char *name, size_t capacity)
+{
+    lab_broadcast_writer *handle = new lab_broadcast_writer();
+    if (handle->writer.open(name, capacity) != 0) {
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
+
+int lab_broadcast_publish(lab_broadcast_writer *writer, uint32_t type, const void *data, size_t length)
+{
+    return writer->writer.publish(type, data, length);
+}
+
+void lab_broadcast_notify(lab_broadcast_writer *writer)
+{
+    writer->writer.notify();
+}
+
+void lab_broadcast_writer_close(lab_broadcast_writer *writer)
+{
+    delete writer;
+}
+
+int lab_broadcast_remove(const char *name)
+{
+    return lab::BroadcastWriter::remove(name);
+}
+
+lab_broadcast_reader *lab_broadcast_reader_open(const char *name)
+{
+    lab_broadcast_reader *handle = new lab_broadcast_reader();
+    if (handle->reader.open(name) != 0) {
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
+
+long lab_broadcast_receive(lab_broadcast_reader *reader, void *buffer, size_t size, uint32_t *type)
+{
+    return reader->reader.receive(buffer, size, type);
+}
+
+size_t lab_broadcast_length(const lab_broadcast_reader *reader)
+{
+    return reader->reader.length();
+}
+
+int lab_broadcast_wait(lab_broadcast_reader *reader, int timeout_ms)
+{
+    return reader->reader.wait(timeout_ms) ? 1 : 0;
+}
+
+void lab_broadcast_reader_stats(const lab_broadcast_reader *reader, lab_broadcast_stats *stats)
+{
+    lab::BroadcastReaderStats current = reader->reader.stats();
+    stats->received = current.received;
+    stats->lag_bytes = current.lag_bytes;
+    stats->lapped = current.lapped;
+    stats->lost_bytes = current.lost_bytes;
+}
+
+void lab_broadcast_reader_close(lab_broadcast_reader *reader)
+{
+    delete reader;
+}
@@ -0,0 +1,47 @@
+#ifndef LAB_BROADCAST_C_H
+#define LAB_BROADCAST_C_H
+
+/*
+ * C interface of the broadcast ring, for other languages: liblab_broadcast.so,
+ * loaded by broadcast.py with ctypes. The functions mirror
+ * BroadcastWriter and BroadcastReader of BroadcastRing.h.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct lab_broadcast_writer lab_broadcast_writer;
+typedef struct lab_broadcast_reader lab_broadcast_reader;
+
+typedef struct {
+    uint64_t received;
+    uint64_t lag_bytes;
+    uint64_t lapped;
+    uint64_t lost_bytes;
+} lab_broadcast_stats;
+
+/** NULL on failure, errno set. */
+lab_broadcast_writer *lab_broadcast_writer_open(const char *name, size_t capacity);
+int lab_broadcast_publish(lab_broadcast_writer *writer, uint32_t type, const void *data, size_t length);
+void lab_broadcast_notify(lab_broadcast_writer *writer);
+void lab_broadcast_writer_close(lab_broadcast_writer *writer);
+int lab_broadcast_remove(const char *name);
+
+/** NULL on failure, errno set. */
+lab_broadcast_reader *lab_broadcast_reader_open(const char *name);
+/** Length, 0 if no message, -1 if larger than size (lab_broadcast_length() tells). */
+long lab_broadcast_receive(lab_broadcast_reader *reader, void *buffer, size_t size, uint32_t *type);
+size_t lab_broadcast_length(const lab_broadcast_reader *reader);
+int lab_broadcast_wait(lab_broadcast_reader *reader, int timeout_ms);
+void lab_broadcast_reader_stats(const lab_broadcast_reader *reader, lab_broadcast_stats *stats);
+void lab_broadcast_reader_close(lab_broadcast_reader *reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LAB_BROADCAST_C_H
@@ -0,0 +1,120 @@
+#include "CaptureReplay.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace lab {
+
+CaptureReplay::CaptureReplay() :
+    _capture(new TriggerCapture<CAPACITY, CHANNELS>()),
+    _hold_us(0)
+{
+}
+
+static uint16_t to_lsb(unsigned mg, double mg_per_lsb)
+{
+    double lsb = std::floor(mg / mg_per_lsb + 0.5);
+    return lsb > 65535.0 ? 65535 : (uint16_t)lsb;
+}
+
+int CaptureReplay::configure(const CaptureReplayOptions &options)
+{
+    if (options.mg_per_lsb <= 0) {
+        return -1;
+    }
+    CaptureConfig config = {};
+    config.pre_samples = options.pre_samples;
+    config.post_samples = options.post_samples;
+    config.magnitude_channel = 0;
+    config.magnitude_high = to_lsb(options.high_mg, options.mg_per_lsb);
+    config.magnitude_low = to_lsb(options.low_mg, options.mg_per_lsb);
+    config.hysteresis = to_lsb(options.hysteresis_mg, options.mg_per_lsb);
+    if (_capture->configure(config)) {
+        return -1;
+    }
+    _hold_us = options.hold_us;
+    _bursts.clear();
+    return 0;
+}
+
+int CaptureReplay::line(const char *text)
+{
+    char *end;
+    unsigned long time_us = strtoul(text, &end, 10);
+    if (end == text || *end != ',') {
+        return -1;
+    }
+    const char *rest = end + 1;
+    if (strncmp(rest, "button", 6) == 0) {
+        return event(CAPTURE_BUTTON, (uint32_t)time_us) > 0;
+    }
+    if (strncmp(rest, "command", 7) == 0) {
+        return event(CAPTURE_COMMAND, (uint32_t)time_us) > 0;
+    }
+
+    int16_t values[CHANNELS];
+    for (size_t channel = 0; channel < CHANNELS; channel++) {
+        long value = strtol(rest, &end, 10);
+        if (end == rest || value < INT16_MIN || value > INT16_MAX || (channel + 1 < CHANNELS && *end != ',')) {
+            return -1;
+        }
+        values[channel] = (int16_t)value;
+        rest = end + 1;
+    }
+    return sample(values, (uint32_t)time_us);
+}
+
+int CaptureReplay::sample(const int16_t *values, uint32_t time_us)
+{
+    // the board hands a burst back once it is uploaded
+    if (_capture->state() == CAPTURE_FROZEN && (int32_t)(time_us - _capture->burst().last_us) >= (int32_t)_hold_us) {
+        _capture->release();
+    }
+    if (!_capture->push(values, time_us)) {
+        return 0;
+    }
+    take();
+    return 1;
+}
+
+int CaptureReplay::event(CaptureSource source, uint32_t time_us)
+{
+    if (_capture->trigger(source, time_us)) {
+        return -1;
+    }
+    if (_capture->state() != CAPTURE_FROZEN) {
+        return 0;
+    }
+    take();
+    return 1;
+}
+
+void CaptureReplay::take()
+{
+    ReplayBurst burst;
+    burst.burst = _capture->burst();
+    burst.values.resize((size_t)burst.burst.length * CHANNELS);
+    _capture->read(0, burst.values.data(), burst.burst.length);
+    for (size_t i = 0; i < burst.burst.length; i++) {
+        burst.times.push_back(_capture->timestamp(i));
+    }
+    _bursts.push_back(burst);
+}
+
+void print_replay_burst(FILE *output, const ReplayBurst &burst, bool samples)
+{
+    const CaptureBurst &b = burst.burst;
+    fprintf(output, "burst,%u,%s,%u,%u,%lu,%lu,%lu,%lu\n", (unsigned)b.sequence, capture_source_name(b.source),
+            (unsigned)b.pre, (unsigned)b.length, (unsigned long)b.requested_us, (unsigned long)b.trigger_us,
+            (unsigned long)b.first_us, (unsigned long)b.last_us);
+    if (!samples) {
+        return;
+    }
+    for (size_t i = 0; i < b.length; i++) {
+        const int16_t *v = &burst.values[i * CaptureReplay::CHANNELS];
+        fprintf(output, "%lu,%d,%d,%d\n", (unsigned long)burst.times[i], v[0], v[1], v[2]);
+    }
+}
+
+} // namespace lab
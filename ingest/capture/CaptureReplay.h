@@ -0,0 +1,106 @@
+#ifndef LAB_CAPTURE_REPLAY_H
+#define LAB_CAPTURE_REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "TriggerCapture.h"
+
+namespace lab {
+
+/*
+ * An accelerometer trace through the TriggerCapture of the boards, on
+ * Linux. A trace is text, one line each:
+ *
+ *   T,X,Y,Z        a sample at T us, raw values
+ *   T,button       a button press at T us
+ *   T,command      a capture command received at T us
+ *
+ * in the order the board gets them: samples come in batches from the
+ * FIFO, so a press is usually read after the samples it falls among, and
+ * a command before its sample is in. Other lines (a header, # comments)
+ * are skipped.
+ */
+
+/** Defaults are the settings of the BLE button example. */
+struct CaptureReplayOptions {
+    CaptureReplayOptions() :
+        pre_samples(256),
+        post_samples(768),
+        high_mg(2500),
+        low_mg(250),
+        hysteresis_mg(200),
+        mg_per_lsb(0.122),
+        hold_us(1000000)
+    {
+    }
+
+    uint16_t pre_samples;
+    uint16_t post_samples;
+    /** Magnitude thresholds, 0 is off. */
+    unsigned high_mg;
+    unsigned low_mg;
+    unsigned hysteresis_mg;
+    /** Scale of the samples, 4 g full scale of the LSM6DSL by default. */
+    double mg_per_lsb;
+    /** A burst stays frozen this long, as while the board uploads it. */
+    uint32_t hold_us;
+};
+
+/** A burst with its samples. */
+struct ReplayBurst {
+    CaptureBurst burst;
+    std::vector<int16_t> values;
+    std::vector<uint32_t> times;
+};
+
+class CaptureReplay {
+public:
+    static const size_t CAPACITY = 8192;
+    static const size_t CHANNELS = 3;
+
+    CaptureReplay();
+
+    /** @return 0, -1 if the capture does not take the settings. */
+    int configure(const CaptureReplayOptions &options);
+
+    /**
+     * One line of a trace.
+     *
+     * @return 1 if it completed a burst (bursts().back()), 0, -1 if it is
+     * not a trace line.
+     */
+    int line(const char *text);
+
+    /** @return 1 if it completed a burst. */
+    int sample(const int16_t *values, uint32_t time_us);
+
+    /** @return 1 if it completed a burst, -1 if the capture was busy. */
+    int event(CaptureSource source, uint32_t time_us);
+
+    const std::vector<ReplayBurst> &bursts() const
+    {
+        return _bursts;
+    }
+
+    const CaptureStats &stats() const
+    {
+        return _capture->stats();
+    }
+
+private:
+    void take();
+
+    std::unique_ptr<TriggerCapture<CAPACITY, CHANNELS> > _capture;
+    uint32_t _hold_us;
+    std::vector<ReplayBurst> _bursts;
+};
+
+/** The line of a burst, and with samples one line per sample after it. */
+void print_replay_burst(FILE *output, const ReplayBurst &burst, bool samples);
+
+} // namespace lab
+
+#endif // LAB_CAPTURE_REPLAY_H
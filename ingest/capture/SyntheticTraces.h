@@ -0,0 +1,145 @@
+#ifndef LAB_SYNTHETIC_TRACES_H
+#define LAB_SYNTHETIC_TRACES_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "TriggerCapture.h"
+
+namespace lab {
+
+struct SyntheticTraceOptions {
+    SyntheticTraceOptions() :
+        rate_hz(416),
+        seconds(60),
+        batch_ms(20),
+        period_s(8)
+    {
+    }
+
+    /** The FIFO rate of the BLE button example. */
+    uint32_t rate_hz;
+    uint32_t seconds;
+    /** Samples come in batches, as the FIFO drain every 20 ms gives them. */
+    uint32_t batch_ms;
+    /** One event every period_s, in turn a knock, a press, a fall and a command. */
+    uint32_t period_s;
+};
+
+enum SyntheticMotion {
+    SYNTHETIC_NONE,
+    /** 3 g on Z for 3 samples. */
+    SYNTHETIC_KNOCK,
+    /** 100 ms of weightlessness. */
+    SYNTHETIC_FALL,
+};
+
+/** An event of the trace, and what the capture should make of it. */
+struct SyntheticTraceEvent {
+    CaptureSource source;
+    SyntheticMotion motion;
+    uint32_t time_us;
+    /** A second press while the burst of the first records: turned down. */
+    bool busy;
+};
+
+struct SyntheticTrace {
+    std::vector<std::string> lines;
+    std::vector<SyntheticTraceEvent> events;
+    uint64_t samples;
+};
+
+/** 1 g at 0.122 mg per LSB, the 4 g scale. */
+static const int16_t SYNTHETIC_ONE_G = 8197;
+
+inline uint32_t synthetic_trace_time(uint64_t index, uint32_t rate_hz)
+{
+    return (uint32_t)(index * 1000000 / rate_hz);
+}
+
+/**
+ * A board lying flat with a little vibration, plus the motion of the
+ * events. A sample index always gives the same sample.
+ */
+inline void synthetic_trace_sample(const SyntheticTraceOptions &options, const std::vector<SyntheticTraceEvent> &events,
+                                   uint64_t index, int16_t values[3])
+{
+    bool falling = false;
+    bool knocked = false;
+    uint32_t time_us = synthetic_trace_time(index, options.rate_hz);
+    for (const SyntheticTraceEvent &event : events) {
+        uint32_t since = time_us - event.time_us;
+        if ((int32_t)since < 0) {
+            continue;
+        }
+        falling |= event.motion == SYNTHETIC_FALL && since < 100000;
+        knocked |= event.motion == SYNTHETIC_KNOCK && since < 3 * 1000000 / options.rate_hz;
+    }
+    for (unsigned axis = 0; axis < 3; axis++) {
+        uint32_t hash = (uint32_t)index * 0x9E3779B1u ^ (axis + 1) * 0x85EBCA77u;
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6Du;
+        hash ^= hash >> 12;
+        int value = (int)(hash % 121) - 60;
+        if (axis == 2 && !falling) {
+            value += knocked ? 3 * SYNTHETIC_ONE_G : SYNTHETIC_ONE_G;
+        }
+        values[axis] = (int16_t)value;
+    }
+}
+
+/**
+ * The trace lines of a run, as CaptureReplay reads them, in batches:
+ * a command goes before the batch its time falls in (it waits for its
+ * sample), a press after it (the capture looks back for its sample).
+ */
+inline SyntheticTrace synthetic_trace(const SyntheticTraceOptions &options)
+{
+    SyntheticTrace trace;
+    static const CaptureSource sources[] = { CAPTURE_THRESHOLD, CAPTURE_BUTTON, CAPTURE_THRESHOLD, CAPTURE_COMMAND };
+    static const SyntheticMotion motions[] = { SYNTHETIC_KNOCK, SYNTHETIC_NONE, SYNTHETIC_FALL, SYNTHETIC_NONE };
+    for (uint32_t k = 1; (k + 1) * options.period_s <= options.seconds; k++) {
+        // off the sample grid, and a little later each time
+        uint32_t time_us = k * options.period_s * 1000000 + 137 * k;
+        SyntheticTraceEvent event = { sources[k % 4], motions[k % 4], time_us, false };
+        trace.events.push_back(event);
+        if (event.source == CAPTURE_BUTTON) {
+            SyntheticTraceEvent again = { CAPTURE_BUTTON, SYNTHETIC_NONE, time_us + 300000, true };
+            trace.events.push_back(again);
+        }
+    }
+
+    char line[64];
+    uint64_t index = 0;
+    uint64_t end = (uint64_t)options.seconds * options.rate_hz;
+    uint32_t batch_us = options.batch_ms * 1000;
+    for (uint32_t batch_end = batch_us; index < end; batch_end += batch_us) {
+        for (const SyntheticTraceEvent &event : trace.events) {
+            if (event.source == CAPTURE_COMMAND && event.time_us < batch_end && event.time_us + batch_us >= batch_end) {
+                snprintf(line, sizeof(line), "%lu,command", (unsigned long)event.time_us);
+                trace.lines.push_back(line);
+            }
+        }
+        for (; index < end && synthetic_trace_time(index, options.rate_hz) < batch_end; index++) {
+            int16_t values[3];
+            synthetic_trace_sample(options, trace.events, index, values);
+            snprintf(line, sizeof(line), "%lu,%d,%d,%d", (unsigned long)synthetic_trace_time(index, options.rate_hz),
+                     values[0], values[1], values[2]);
+            trace.lines.push_back(line);
+        }
+        for (const SyntheticTraceEvent &event : trace.events) {
+            if (event.source == CAPTURE_BUTTON && event.time_us < batch_end && event.time_us + batch_us >= batch_end) {
+                snprintf(line, sizeof(line), "%lu,button", (unsigned long)event.time_us);
+                trace.lines.push_back(line);
+            }
+        }
+    }
+    trace.samples = index;
+    return trace;
+}
+
+} // namespace lab
+
+#endif // LAB_SYNTHETIC_TRACES_H
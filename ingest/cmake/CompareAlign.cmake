@@ -0,0 +1,37 @@
+# Align synthetic drifting boards, one restarting, with AVX2 and with
+# the portable code, both methods, and fail unless the grids are the
+# same to the last digit.
+#
+#   cmake -DALIGN=<path> -P CompareAlign.cmake
+
+set(options synth --boards 8 --seconds 300 --restart --dump)
+
+foreach(method linear sinc)
+    foreach(variant simd scalar)
+        set(extra)
+        if(variant STREQUAL scalar)
+            set(extra --scalar)
+        endif()
+        execute_process(
+            COMMAND ${ALIGN} ${options} --method ${method} ${extra}
+            OUTPUT_VARIABLE output_${variant}
+            ERROR_QUIET
+            RESULT_VARIABLE result
+        )
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "align ${options} --method ${method} ${extra} exited with ${result}")
+        endif()
+    endforeach()
+
+    string(REGEX MATCHALL "\n" lines "${output_simd}")
+    list(LENGTH lines length)
+    if(NOT output_simd STREQUAL output_scalar)
+        file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/align-${method}-simd.csv "${output_simd}")
+        file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/align-${method}-scalar.csv "${output_scalar}")
+        message(FATAL_ERROR "${method} grids differ, see align-${method}-*.csv in ${CMAKE_CURRENT_BINARY_DIR}")
+    endif()
+    if(length EQUAL 0)
+        message(FATAL_ERROR "No ${method} grid points")
+    endif()
+    message("${length} identical ${method} grid points")
+endforeach()
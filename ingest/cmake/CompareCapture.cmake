@@ -0,0 +1,37 @@
+# Capture a synthetic trace while writing it out, replay the file, and
+# fail unless both give the same bursts with the same samples.
+#
+#   cmake -DCAPTURE=<path> -DTRACE=<file> -P CompareCapture.cmake
+
+execute_process(
+    COMMAND ${CAPTURE} synth --seconds 120 --trace ${TRACE} --samples
+    OUTPUT_VARIABLE output_synth
+    ERROR_QUIET
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "capture synth exited with ${result}")
+endif()
+
+execute_process(
+    COMMAND ${CAPTURE} replay --samples ${TRACE}
+    OUTPUT_VARIABLE output_replay
+    ERROR_QUIET
+    RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "capture replay exited with ${result}")
+endif()
+
+string(REGEX MATCHALL "burst,[^\n]*" bursts "${output_synth}")
+list(LENGTH bursts length)
+if(NOT output_synth STREQUAL output_replay)
+    get_filename_component(directory ${TRACE} DIRECTORY)
+    file(WRITE ${directory}/capture-synth.csv "${output_synth}")
+    file(WRITE ${directory}/capture-replay.csv "${output_replay}")
+    message(FATAL_ERROR "bursts differ, see capture-*.csv in ${directory}")
+endif()
+if(length EQUAL 0)
+    message(FATAL_ERROR "No bursts")
+endif()
+message("${length} identical bursts")
@@ -0,0 +1,33 @@
+# Run the detector on synthetic boards with AVX2 and with the portable
+# code, and fail unless both raise the same alerts, and at least one.
+#
+#   cmake -DDETECT=<path> -P CompareDetect.cmake
+
+set(options synth --devices 500 --seconds 70 --rate-hz 100)
+
+foreach(variant simd scalar)
+    set(extra)
+    if(variant STREQUAL scalar)
+        set(extra --scalar)
+    endif()
+    execute_process(
+        COMMAND ${DETECT} ${options} ${extra}
+        OUTPUT_VARIABLE output_${variant}
+        RESULT_VARIABLE result
+    )
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "detect ${options} ${extra} exited with ${result}")
+    endif()
+endforeach()
+
+string(REGEX MATCHALL "\n" lines "${output_simd}")
+list(LENGTH lines length)
+if(NOT output_simd STREQUAL output_scalar)
+    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/detect-simd.txt "${output_simd}")
+    file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/detect-scalar.txt "${output_scalar}")
+    message(FATAL_ERROR "Alerts differ, see detect-*.txt in ${CMAKE_CURRENT_BINARY_DIR}")
+endif()
+if(length EQUAL 0)
+    message(FATAL_ERROR "No alerts from the synthetic knocks and spins")
+endif()
+message("${length} identical alerts")
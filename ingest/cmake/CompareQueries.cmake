@@ -0,0 +1,40 @@
+# Query a history from its tiers and from the raw samples only, with
+# bucket edges that are and are not on tier boundaries, and fail unless
+# both give the same rollups.
+#
+#   cmake -DROLLUP=<path> -DSTORE=<directory> -P CompareQueries.cmake
+
+set(queries
+    "--bucket 1h"
+    "--bucket 90m --from 2024-01-01T00:00:07"
+    "--bucket 0 --from 2024-01-01T05:59:59 --to 2024-01-01T18:00:01"
+    "--bucket 10s --channel g_z --from 2024-01-01T23:58"
+)
+
+set(number 0)
+foreach(query IN LISTS queries)
+    foreach(source tiers raw)
+        separate_arguments(options UNIX_COMMAND "${query}")
+        if(source STREQUAL raw)
+            list(APPEND options --raw)
+        endif()
+        execute_process(
+            COMMAND ${ROLLUP} query ${STORE} --csv ${options}
+            OUTPUT_VARIABLE output_${source}
+            RESULT_VARIABLE result
+        )
+        if(NOT result EQUAL 0)
+            message(FATAL_ERROR "rollup query ${options} exited with ${result}")
+        endif()
+    endforeach()
+
+    math(EXPR number "${number} + 1")
+    if(NOT output_tiers STREQUAL output_raw)
+        file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/query${number}-tiers.csv "${output_tiers}")
+        file(WRITE ${CMAKE_CURRENT_BINARY_DIR}/query${number}-raw.csv "${output_raw}")
+        message(FATAL_ERROR "Query ${number} differs, see query${number}-*.csv in ${CMAKE_CURRENT_BINARY_DIR}")
+    endif()
+    string(REGEX MATCHALL "\n" lines "${output_tiers}")
+    list(LENGTH lines length)
+    message("Query ${number} (${query}): ${length} identical lines")
+endforeach()
@@ -0,0 +1,392 @@
+#include "MotionDetector.h"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LAB_DETECT_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace lab {
+
+namespace {
+
+/** Columns of a frame and of the devices, padded to a multiple of 8. */
+struct DetectColumns {
+    const float *values[HISTORY_CHANNELS];
+    const float *dt;
+    uint32_t *present;
+    float *previous[3];
+    float *mean;
+    float *variance;
+    float *seen;
+    uint32_t *active;
+    uint32_t *raised;
+};
+
+/** The limits as the kernels compare them, squared to save the roots. */
+struct DetectConstants {
+    float alpha;
+    float keep;
+    float z;
+    float z2;
+    float min_variance;
+    float warmup;
+    float jerk2;
+    float gyro2;
+};
+
+/*
+ * Both kernels do the same operations in the same order, without fused
+ * multiply-adds, so they raise the same alerts to the bit. A group of
+ * eight devices without a sample is skipped as a whole.
+ *
+ * Once warm, a sample moves the statistics at most as much as one z
+ * sigma away would: a knock does not blind the detector to the next one,
+ * a lasting change (a board turned over) is still learned, in steps.
+ */
+
+void frame_portable(const DetectColumns &c, size_t count, const DetectConstants &k, std::vector<uint32_t> &groups)
+{
+    for (size_t group = 0; group < count; group += 8) {
+        bool any_present = false;
+        for (size_t i = group; i < group + 8; i++) {
+            any_present |= c.present[i] != 0;
+        }
+        if (!any_present) {
+            continue;
+        }
+        bool any_raised = false;
+        for (size_t i = group; i < group + 8; i++) {
+            if (!c.present[i]) {
+                c.raised[i] = 0;
+                continue;
+            }
+            float ax = c.values[HISTORY_A_X][i];
+            float ay = c.values[HISTORY_A_Y][i];
+            float az = c.values[HISTORY_A_Z][i];
+            float gx = c.values[HISTORY_G_X][i];
+            float gy = c.values[HISTORY_G_Y][i];
+            float gz = c.values[HISTORY_G_Z][i];
+
+            float accel = std::sqrt((ax * ax + ay * ay) + az * az);
+            float gyro2 = (gx * gx + gy * gy) + gz * gz;
+            float dx = ax - c.previous[0][i];
+            float dy = ay - c.previous[1][i];
+            float dz = az - c.previous[2][i];
+            float jerk2 = (dx * dx + dy * dy) + dz * dz;
+            float dt = c.dt[i];
+
+            float seen = c.seen[i];
+            float mean = seen == 0.0f ? accel : c.mean[i];
+            float d = accel - mean;
+            float d2 = d * d;
+            float variance = c.variance[i];
+            float floor = variance > k.min_variance ? variance : k.min_variance;
+
+            uint32_t kinds = 0;
+            bool warm = seen >= k.warmup;
+            if (warm && d2 > k.z2 * floor) {
+                kinds |= MOTION_ACCEL;
+            }
+            if (dt > 0.0f && jerk2 > k.jerk2 * (dt * dt)) {
+                kinds |= MOTION_JERK;
+            }
+            if (gyro2 > k.gyro2) {
+                kinds |= MOTION_GYRO;
+            }
+
+            float limit = warm ? k.z * std::sqrt(floor) : INFINITY;
+            float step = d < -limit ? -limit : (d > limit ? limit : d);
+            c.mean[i] = mean + k.alpha * step;
+            c.variance[i] = k.keep * (variance + k.alpha * (step * step));
+            c.seen[i] = seen + 1.0f < k.warmup ? seen + 1.0f : k.warmup;
+            c.previous[0][i] = ax;
+            c.previous[1][i] = ay;
+            c.previous[2][i] = az;
+            c.raised[i] = kinds & ~c.active[i];
+            c.active[i] = kinds;
+            c.present[i] = 0;
+            any_raised |= c.raised[i] != 0;
+        }
+        if (any_raised) {
+            groups.push_back((uint32_t)group);
+        }
+    }
+}
+
+#if LAB_DETECT_AVX2
+
+__attribute__((target("avx2")))
+void frame_avx2(const DetectColumns &c, size_t count, const DetectConstants &k, std::vector<uint32_t> &groups)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 alpha = _mm256_set1_ps(k.alpha);
+    const __m256 keep = _mm256_set1_ps(k.keep);
+    const __m256 z = _mm256_set1_ps(k.z);
+    const __m256 z2 = _mm256_set1_ps(k.z2);
+    const __m256 infinity = _mm256_set1_ps(INFINITY);
+    const __m256 min_variance = _mm256_set1_ps(k.min_variance);
+    const __m256 warmup = _mm256_set1_ps(k.warmup);
+    const __m256 jerk_limit2 = _mm256_set1_ps(k.jerk2);
+    const __m256 gyro_limit2 = _mm256_set1_ps(k.gyro2);
+    const __m256i accel_bit = _mm256_set1_epi32(MOTION_ACCEL);
+    const __m256i jerk_bit = _mm256_set1_epi32(MOTION_JERK);
+    const __m256i gyro_bit = _mm256_set1_epi32(MOTION_GYRO);
+
+    for (size_t i = 0; i < count; i += 8) {
+        __m256i present = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.present + i));
+        if (_mm256_testz_si256(present, present)) {
+            continue;
+        }
+        __m256 mask = _mm256_castsi256_ps(present);
+
+        __m256 ax = _mm256_loadu_ps(c.values[HISTORY_A_X] + i);
+        __m256 ay = _mm256_loadu_ps(c.values[HISTORY_A_Y] + i);
+        __m256 az = _mm256_loadu_ps(c.values[HISTORY_A_Z] + i);
+        __m256 gx = _mm256_loadu_ps(c.values[HISTORY_G_X] + i);
+        __m256 gy = _mm256_loadu_ps(c.values[HISTORY_G_Y] + i);
+        __m256 gz = _mm256_loadu_ps(c.values[HISTORY_G_Z] + i);
+
+        __m256 accel = _mm256_sqrt_ps(
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, ax), _mm256_mul_ps(ay, ay)), _mm256_mul_ps(az, az)));
+        __m256 gyro2 =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(gx, gx), _mm256_mul_ps(gy, gy)), _mm256_mul_ps(gz, gz));
+        __m256 px = _mm256_loadu_ps(c.previous[0] + i);
+        __m256 py = _mm256_loadu_ps(c.previous[1] + i);
+        __m256 pz = _mm256_loadu_ps(c.previous[2] + i);
+        __m256 dx = _mm256_sub_ps(ax, px);
+        __m256 dy = _mm256_sub_ps(ay, py);
+        __m256 dz = _mm256_sub_ps(az, pz);
+        __m256 jerk2 =
+            _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+        __m256 dt = _mm256_loadu_ps(c.dt + i);
+
+        __m256 seen = _mm256_loadu_ps(c.seen + i);
+        __m256 mean = _mm256_blendv_ps(_mm256_loadu_ps(c.mean + i), accel, _mm256_cmp_ps(seen, zero, _CMP_EQ_OQ));
+        __m256 d = _mm256_sub_ps(accel, mean);
+        __m256 d2 = _mm256_mul_ps(d, d);
+        __m256 variance = _mm256_loadu_ps(c.variance + i);
+        __m256 floor = _mm256_max_ps(variance, min_variance);
+
+        __m256 warm = _mm256_cmp_ps(seen, warmup, _CMP_GE_OQ);
+        __m256 accel_hit = _mm256_and_ps(warm, _mm256_cmp_ps(d2, _mm256_mul_ps(z2, floor), _CMP_GT_OQ));
+        __m256 jerk_hit = _mm256_and_ps(_mm256_cmp_ps(dt, zero, _CMP_GT_OQ),
+                                        _mm256_cmp_ps(jerk2, _mm256_mul_ps(jerk_limit2, _mm256_mul_ps(dt, dt)), _CMP_GT_OQ));
+        __m256 gyro_hit = _mm256_cmp_ps(gyro2, gyro_limit2, _CMP_GT_OQ);
+        __m256i kinds = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(accel_hit), accel_bit),
+                                                        _mm256_and_si256(_mm256_castps_si256(jerk_hit), jerk_bit)),
+                                        _mm256_and_si256(_mm256_castps_si256(gyro_hit), gyro_bit));
+        kinds = _mm256_and_si256(kinds, present);
+
+        __m256 limit = _mm256_blendv_ps(infinity, _mm256_mul_ps(z, _mm256_sqrt_ps(floor)), warm);
+        __m256 step = _mm256_min_ps(_mm256_max_ps(d, _mm256_sub_ps(zero, limit)), limit);
+        __m256 new_mean = _mm256_add_ps(mean, _mm256_mul_ps(alpha, step));
+        __m256 new_variance =
+            _mm256_mul_ps(keep, _mm256_add_ps(variance, _mm256_mul_ps(alpha, _mm256_mul_ps(step, step))));
+        __m256 new_seen = _mm256_min_ps(_mm256_add_ps(seen, one), warmup);
+        _mm256_storeu_ps(c.mean + i, _mm256_blendv_ps(_mm256_loadu_ps(c.mean + i), new_mean, mask));
+        _mm256_storeu_ps(c.variance + i, _mm256_blendv_ps(variance, new_variance, mask));
+        _mm256_storeu_ps(c.seen + i, _mm256_blendv_ps(seen, new_seen, mask));
+        _mm256_storeu_ps(c.previous[0] + i, _mm256_blendv_ps(px, ax, mask));
+        _mm256_storeu_ps(c.previous[1] + i, _mm256_blendv_ps(py, ay, mask));
+        _mm256_storeu_ps(c.previous[2] + i, _mm256_blendv_ps(pz, az, mask));
+
+        __m256i active = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(c.active + i));
+        __m256i raised = _mm256_andnot_si256(active, kinds);
+        active = _mm256_or_si256(kinds, _mm256_andnot_si256(present, active));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(c.active + i), active);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(c.raised + i), raised);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(c.present + i), _mm256_setzero_si256());
+        if (!_mm256_testz_si256(raised, raised)) {
+            groups.push_back((uint32_t)i);
+        }
+    }
+}
+
+#endif // LAB_DETECT_AVX2
+
+bool simd_available()
+{
+#if LAB_DETECT_AVX2
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+} // namespace
+
+const char *motion_alert_name(uint32_t kind)
+{
+    switch (kind) {
+        case MOTION_ACCEL:
+            return "accel";
+        case MOTION_JERK:
+            return "jerk";
+        case MOTION_GYRO:
+            return "gyro";
+        default:
+            return "?";
+    }
+}
+
+MotionDetector::MotionDetector() :
+    _devices(0),
+    _pending(0),
+    _simd(true)
+{
+}
+
+void MotionDetector::configure(const MotionLimits &limits)
+{
+    _limits = limits;
+}
+
+void MotionDetector::resize(size_t count)
+{
+    if (count <= _devices) {
+        return;
+    }
+    size_t padded = (count + 7) & ~(size_t)7;
+    for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+        _values[channel].resize(padded, 0.0f);
+    }
+    _dt.resize(padded, 0.0f);
+    _present.resize(padded, 0);
+    _last_us.resize(padded, INT64_MIN);
+    for (size_t axis = 0; axis < 3; axis++) {
+        _previous[axis].resize(padded, 0.0f);
+    }
+    _mean.resize(padded, 0.0f);
+    _variance.resize(padded, 0.0f);
+    _seen.resize(padded, 0.0f);
+    _active.resize(padded, 0);
+    _raised.resize(padded, 0);
+    _devices = count;
+}
+
+void MotionDetector::add(uint32_t device, int64_t time_us, const float values[HISTORY_CHANNELS])
+{
+    if (device >= _devices) {
+        resize((size_t)device + 1);
+    }
+    if (_present[device]) {
+        run_frame();
+    }
+    int64_t last_us = _last_us[device];
+    _dt[device] = last_us != INT64_MIN && time_us > last_us ? (float)((time_us - last_us) * 1e-6) : 0.0f;
+    _last_us[device] = time_us;
+    for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+        _values[channel][device] = values[channel];
+    }
+    _present[device] = ~0u;
+    _pending++;
+}
+
+void MotionDetector::flush()
+{
+    if (_pending) {
+        run_frame();
+    }
+}
+
+void MotionDetector::run_frame()
+{
+    DetectColumns columns;
+    for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+        columns.values[channel] = _values[channel].data();
+    }
+    columns.dt = _dt.data();
+    columns.present = _present.data();
+    for (size_t axis = 0; axis < 3; axis++) {
+        columns.previous[axis] = _previous[axis].data();
+    }
+    columns.mean = _mean.data();
+    columns.variance = _variance.data();
+    columns.seen = _seen.data();
+    columns.active = _active.data();
+    columns.raised = _raised.data();
+
+    DetectConstants constants;
+    constants.alpha = _limits.alpha;
+    constants.keep = 1.0f - _limits.alpha;
+    constants.z = _limits.z;
+    constants.z2 = _limits.z * _limits.z;
+    constants.min_variance = _limits.min_sigma * _limits.min_sigma;
+    constants.warmup = (float)(_limits.warmup ? _limits.warmup : 1);
+    constants.jerk2 = _limits.jerk * _limits.jerk;
+    constants.gyro2 = _limits.gyro * _limits.gyro;
+
+    _groups.clear();
+#if LAB_DETECT_AVX2
+    if (simd_active()) {
+        frame_avx2(columns, _present.size(), constants, _groups);
+    } else
+#endif
+    {
+        frame_portable(columns, _present.size(), constants, _groups);
+    }
+    _pending = 0;
+
+    for (uint32_t group : _groups) {
+        for (uint32_t device = group; device < group + 8 && device < _devices; device++) {
+            if (!_raised[device]) {
+                continue;
+            }
+            MotionAlert alert;
+            alert.device = device;
+            alert.kinds = _raised[device];
+            alert.time_us = _last_us[device];
+            for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                alert.values[channel] = _values[channel][device];
+            }
+            MotionState current = state(device);
+            alert.accel_mean = current.accel_mean;
+            alert.accel_sigma = current.accel_sigma;
+            _alerts.push_back(alert);
+        }
+    }
+}
+
+void MotionDetector::reset(uint32_t device)
+{
+    if (device >= _devices) {
+        return;
+    }
+    _dt[device] = 0.0f;
+    _last_us[device] = INT64_MIN;
+    for (size_t axis = 0; axis < 3; axis++) {
+        _previous[axis][device] = 0.0f;
+    }
+    _mean[device] = 0.0f;
+    _variance[device] = 0.0f;
+    _seen[device] = 0.0f;
+    _active[device] = 0;
+}
+
+MotionState MotionDetector::state(uint32_t device) const
+{
+    MotionState state;
+    memset(&state, 0, sizeof(state));
+    if (device < _devices) {
+        float min_variance = _limits.min_sigma * _limits.min_sigma;
+        float variance = _variance[device];
+        state.samples = (uint32_t)_seen[device];
+        state.accel_mean = _mean[device];
+        state.accel_sigma = std::sqrt(variance > min_variance ? variance : min_variance);
+        state.active = _active[device];
+    }
+    return state;
+}
+
+bool MotionDetector::simd_active() const
+{
+    return _simd && simd_available();
+}
+
+} // namespace lab
@@ -0,0 +1,177 @@
+#ifndef LAB_MOTION_DETECTOR_H
+#define LAB_MOTION_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SensorHistory.h"
+
+namespace lab {
+
+/** What a sample of a device tripped, bits of MotionAlert::kinds. */
+enum MotionAlertKind {
+    /** Acceleration magnitude beyond z sigma of its rolling mean: a shock, a fall, a tilt. */
+    MOTION_ACCEL = 1,
+    /** Change of acceleration over the sample period beyond the jerk limit. */
+    MOTION_JERK = 2,
+    /** Rotation rate magnitude beyond the gyro limit. */
+    MOTION_GYRO = 4
+};
+
+/** "accel", "jerk", "gyro". */
+const char *motion_alert_name(uint32_t kind);
+
+/** Limits of the detector, in the units of the telemetry (mg, mdps). */
+struct MotionLimits {
+    MotionLimits() :
+        alpha(0.02f),
+        z(6.0f),
+        min_sigma(10.0f),
+        warmup(50),
+        jerk(20000.0f),
+        gyro(500000.0f)
+    {
+    }
+
+    /** Weight of a new sample in the rolling mean and variance, 1 / samples remembered. */
+    float alpha;
+    /** Sigmas from the rolling mean of the acceleration magnitude that make an alert. */
+    float z;
+    /** Floor of that sigma, mg, so a board at rest does not alert on its noise. */
+    float min_sigma;
+    /** Samples of a device before its rolling statistics are trusted. */
+    uint32_t warmup;
+    /** Jerk magnitude, mg/s. */
+    float jerk;
+    /** Rotation rate magnitude, mdps. */
+    float gyro;
+};
+
+/** A device entering an alert state. */
+struct MotionAlert {
+    uint32_t device;
+    /** MotionAlertKind bits that were not set on the previous sample. */
+    uint32_t kinds;
+    int64_t time_us;
+    /** The sample, and the rolling acceleration magnitude after it. */
+    float values[HISTORY_CHANNELS];
+    float accel_mean;
+    float accel_sigma;
+};
+
+/** Rolling statistics of one device, see MotionDetector::state(). */
+struct MotionState {
+    /** Samples seen, counted up to the warmup. */
+    uint32_t samples;
+    float accel_mean;
+    float accel_sigma;
+    /** MotionAlertKind bits of the last sample. */
+    uint32_t active;
+};
+
+/**
+ * Streaming motion anomaly detector for many devices at once.
+ *
+ * Every device keeps an EWMA of the mean and variance of its
+ * acceleration magnitude, its previous acceleration for the jerk, and
+ * the alerts of its last sample. A sample alerts when its acceleration
+ * is z sigma away from the mean, its jerk or its rotation rate beyond
+ * their limits; only the kinds not already active on the previous
+ * sample are reported, so a long event is one alert. Outliers are
+ * clipped to z sigma before they enter the statistics.
+ *
+ * State and input are kept in struct-of-arrays layout, one column per
+ * quantity indexed by device, and a frame, one sample for any subset of
+ * the devices, is processed by one pass over the columns: eight devices
+ * per AVX2 instruction when the CPU has it (picked at run time), the
+ * portable code otherwise, with the same results. Groups of eight
+ * devices without a sample in the frame are skipped.
+ *
+ * Decoded samples are staged with add() and a frame runs when a device
+ * already in it gets another sample, or with flush(). At a common rate
+ * that is one frame per sample period.
+ */
+class MotionDetector {
+public:
+    MotionDetector();
+
+    void configure(const MotionLimits &limits);
+
+    const MotionLimits &limits() const
+    {
+        return _limits;
+    }
+
+    /** Make room for devices 0 to count - 1; add() grows it as well. */
+    void resize(size_t count);
+
+    size_t device_count() const
+    {
+        return _devices;
+    }
+
+    /**
+     * Stage a sample of a device. A time that does not go forward, the
+     * first sample or a board that restarted, has no jerk.
+     */
+    void add(uint32_t device, int64_t time_us, const float values[HISTORY_CHANNELS]);
+
+    /** Run the staged samples, if any. */
+    void flush();
+
+    /** Alerts of the frames run so far, in device order per frame. */
+    const std::vector<MotionAlert> &alerts() const
+    {
+        return _alerts;
+    }
+
+    void clear_alerts()
+    {
+        _alerts.clear();
+    }
+
+    /** Forget the statistics of a device, as for a new board. */
+    void reset(uint32_t device);
+
+    MotionState state(uint32_t device) const;
+
+    /** Use AVX2 when the CPU has it (the default), or the portable code, to compare. */
+    void use_simd(bool enable)
+    {
+        _simd = enable;
+    }
+
+    bool simd_active() const;
+
+private:
+    void run_frame();
+
+    MotionLimits _limits;
+    size_t _devices;
+    size_t _pending;
+    bool _simd;
+
+    // the frame: a sample per device, present or not
+    std::vector<float> _values[HISTORY_CHANNELS];
+    /** Seconds since the previous sample of the device, 0 for none. */
+    std::vector<float> _dt;
+    std::vector<uint32_t> _present;
+
+    // the devices
+    std::vector<int64_t> _last_us;
+    std::vector<float> _previous[3];
+    std::vector<float> _mean;
+    std::vector<float> _variance;
+    std::vector<float> _seen;
+    std::vector<uint32_t> _active;
+
+    /** New alert kinds of the frame, and the groups of eight that have any. */
+    std::vector<uint32_t> _raised;
+    std::vector<uint32_t> _groups;
+    std::vector<MotionAlert> _alerts;
+};
+
+} // namespace lab
+
+#endif // LAB_MOTION_DETECTOR_H
@@ -0,0 +1,29 @@
+#ifndef LAB_SYNTHETIC_EVENTS_H
+#define LAB_SYNTHETIC_EVENTS_H
+
+#include <cstdint>
+
+#include "SensorHistory.h"
+
+namespace lab {
+
+/**
+ * Motion events on top of synthetic_imu(), for the detector: one board
+ * in 97 is knocked every 30 s, a 3 g shock on Z for one sample, and one
+ * in 89 is spun at 700 dps about Z for one second every minute. Like
+ * synthetic_imu(), a sample index always gives the same sample.
+ */
+inline void synthetic_events(HistorySample &sample, uint32_t device, uint64_t index, uint32_t rate_hz)
+{
+    uint64_t offset = (uint64_t)device * 7 * rate_hz / 10;
+    if (device % 97 == 0 && (index + offset) % (30ull * rate_hz) == 10ull * rate_hz) {
+        sample.values[HISTORY_A_Z] += 3000.0f;
+    }
+    if (device % 89 == 1 && (index + offset) % (60ull * rate_hz) / rate_hz == 20) {
+        sample.values[HISTORY_G_Z] += 700000.0f;
+    }
+}
+
+} // namespace lab
+
+#endif // LAB_SYNTHETIC_EVENTS_H
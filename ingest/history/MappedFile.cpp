@@ -0,0 +1,95 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lab {
+
+MappedFile::MappedFile() :
+    _fd(-1),
+    _writable(false),
+    _data(nullptr),
+    _size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+int MappedFile::open(const char *path, bool writable)
+{
+    close();
+    _fd = ::open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (_fd < 0) {
+        return -1;
+    }
+    _writable = writable;
+
+    struct stat info;
+    if (fstat(_fd, &info) != 0 || map(info.st_size) != 0) {
+        close();
+        return -1;
+    }
+    return 0;
+}
+
+void MappedFile::close()
+{
+    if (_data) {
+        munmap(_data, _size);
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+    }
+    _fd = -1;
+    _data = nullptr;
+    _size = 0;
+}
+
+int MappedFile::map(size_t size)
+{
+    if (_data) {
+        munmap(_data, _size);
+        _data = nullptr;
+        _size = 0;
+    }
+    if (size == 0) {
+        // mmap refuses empty mappings, an empty file has no data()
+        return 0;
+    }
+    void *data = mmap(nullptr, size, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _fd, 0);
+    if (data == MAP_FAILED) {
+        return -1;
+    }
+    _data = static_cast<uint8_t *>(data);
+    _size = size;
+    return 0;
+}
+
+int MappedFile::reserve(size_t size)
+{
+    if (_fd < 0 || !_writable) {
+        return -1;
+    }
+    if (size <= _size) {
+        return 0;
+    }
+    if (ftruncate(_fd, (off_t)size) != 0) {
+        return -1;
+    }
+    return map(size);
+}
+
+int MappedFile::sync()
+{
+    if (!_data || !_writable) {
+        return 0;
+    }
+    return msync(_data, _size, MS_SYNC);
+}
+
+} // namespace lab
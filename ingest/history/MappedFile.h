@@ -0,0 +1,71 @@
+#ifndef LAB_MAPPED_FILE_H
+#define LAB_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * A file mapped in memory, shared with the page cache.
+ *
+ * Writes through data() reach the file without a write() call; readers in
+ * other processes map the same pages. A writable file grows with
+ * reserve(), which may move the mapping: pointers into data() do not
+ * survive it.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /**
+     * Map a file, created empty if writable and missing.
+     *
+     * @return 0, or -1 with errno set.
+     */
+    int open(const char *path, bool writable);
+
+    void close();
+
+    /**
+     * Grow the file to size bytes, zero filled. Writable files only.
+     *
+     * @return 0, or -1.
+     */
+    int reserve(size_t size);
+
+    /** Write the mapped pages back to the file. @return 0, or -1. */
+    int sync();
+
+    bool is_open() const
+    {
+        return _fd >= 0;
+    }
+
+    uint8_t *data() const
+    {
+        return _data;
+    }
+
+    /** Bytes mapped, the file size when it was opened or last grown. */
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    int map(size_t size);
+
+    int _fd;
+    bool _writable;
+    uint8_t *_data;
+    size_t _size;
+};
+
+} // namespace lab
+
+#endif // LAB_MAPPED_FILE_H
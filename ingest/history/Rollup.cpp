@@ -0,0 +1,240 @@
+#include "Rollup.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LAB_ROLLUP_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace lab {
+
+namespace {
+
+bool simd_enabled = true;
+
+void samples_portable(const float *values, size_t count, RollupStats &stats)
+{
+    float min = stats.min;
+    float max = stats.max;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        float value = values[i];
+        min = value < min ? value : min;
+        max = value > max ? value : max;
+        sum += value;
+        sum_squares += (double)value * value;
+    }
+    stats.count += count;
+    stats.min = min;
+    stats.max = max;
+    stats.sum += sum;
+    stats.sum_squares += sum_squares;
+}
+
+void buckets_portable(const RollupColumns &columns, size_t begin, size_t end, RollupStats &stats)
+{
+    uint64_t count = 0;
+    float min = stats.min;
+    float max = stats.max;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+    for (size_t i = begin; i < end; i++) {
+        count += columns.count[i];
+        min = columns.min[i] < min ? columns.min[i] : min;
+        max = columns.max[i] > max ? columns.max[i] : max;
+        sum += columns.sum[i];
+        sum_squares += columns.sum_squares[i];
+    }
+    stats.count += count;
+    stats.min = min;
+    stats.max = max;
+    stats.sum += sum;
+    stats.sum_squares += sum_squares;
+}
+
+#if LAB_ROLLUP_AVX2
+
+/*
+ * The AVX2 kernels are compiled for that instruction set only, whatever
+ * the flags of the build, and picked at run time. Sums go to double
+ * lanes as the portable kernels do; only the order of the additions
+ * differs, in the last bits of the result.
+ */
+
+__attribute__((target("avx2")))
+float min_of(__m256 lanes)
+{
+    float values[8];
+    _mm256_storeu_ps(values, lanes);
+    float min = values[0];
+    for (int i = 1; i < 8; i++) {
+        min = values[i] < min ? values[i] : min;
+    }
+    return min;
+}
+
+__attribute__((target("avx2")))
+float max_of(__m256 lanes)
+{
+    float values[8];
+    _mm256_storeu_ps(values, lanes);
+    float max = values[0];
+    for (int i = 1; i < 8; i++) {
+        max = values[i] > max ? values[i] : max;
+    }
+    return max;
+}
+
+__attribute__((target("avx2")))
+double sum_of(__m256d lanes)
+{
+    double values[4];
+    _mm256_storeu_pd(values, lanes);
+    return (values[0] + values[1]) + (values[2] + values[3]);
+}
+
+__attribute__((target("avx2,fma")))
+void samples_avx2(const float *values, size_t count, RollupStats &stats)
+{
+    __m256 min0 = _mm256_set1_ps(stats.min);
+    __m256 max0 = _mm256_set1_ps(stats.max);
+    __m256 min1 = min0;
+    __m256 max1 = max0;
+    // four independent sums of each kind hide the latency of the adds
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    __m256d sum3 = _mm256_setzero_pd();
+    __m256d squares0 = _mm256_setzero_pd();
+    __m256d squares1 = _mm256_setzero_pd();
+    __m256d squares2 = _mm256_setzero_pd();
+    __m256d squares3 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_loadu_ps(values + i);
+        __m256 b = _mm256_loadu_ps(values + i + 8);
+        min0 = _mm256_min_ps(min0, a);
+        max0 = _mm256_max_ps(max0, a);
+        min1 = _mm256_min_ps(min1, b);
+        max1 = _mm256_max_ps(max1, b);
+
+        __m256d a_low = _mm256_cvtps_pd(_mm256_castps256_ps128(a));
+        __m256d a_high = _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1));
+        __m256d b_low = _mm256_cvtps_pd(_mm256_castps256_ps128(b));
+        __m256d b_high = _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1));
+        sum0 = _mm256_add_pd(sum0, a_low);
+        sum1 = _mm256_add_pd(sum1, a_high);
+        sum2 = _mm256_add_pd(sum2, b_low);
+        sum3 = _mm256_add_pd(sum3, b_high);
+        squares0 = _mm256_fmadd_pd(a_low, a_low, squares0);
+        squares1 = _mm256_fmadd_pd(a_high, a_high, squares1);
+        squares2 = _mm256_fmadd_pd(b_low, b_low, squares2);
+        squares3 = _mm256_fmadd_pd(b_high, b_high, squares3);
+    }
+    for (; i + 8 <= count; i += 8) {
+        __m256 a = _mm256_loadu_ps(values + i);
+        min0 = _mm256_min_ps(min0, a);
+        max0 = _mm256_max_ps(max0, a);
+        __m256d a_low = _mm256_cvtps_pd(_mm256_castps256_ps128(a));
+        __m256d a_high = _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1));
+        sum0 = _mm256_add_pd(sum0, a_low);
+        sum1 = _mm256_add_pd(sum1, a_high);
+        squares0 = _mm256_fmadd_pd(a_low, a_low, squares0);
+        squares1 = _mm256_fmadd_pd(a_high, a_high, squares1);
+    }
+
+    RollupStats merged;
+    merged.count = i;
+    merged.min = min_of(_mm256_min_ps(min0, min1));
+    merged.max = max_of(_mm256_max_ps(max0, max1));
+    merged.sum = sum_of(_mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3)));
+    merged.sum_squares = sum_of(_mm256_add_pd(_mm256_add_pd(squares0, squares1), _mm256_add_pd(squares2, squares3)));
+    stats.add(merged);
+    samples_portable(values + i, count - i, stats);
+}
+
+__attribute__((target("avx2")))
+void buckets_avx2(const RollupColumns &columns, size_t begin, size_t end, RollupStats &stats)
+{
+    __m256i count0 = _mm256_setzero_si256();
+    __m256i count1 = _mm256_setzero_si256();
+    __m256 min = _mm256_set1_ps(stats.min);
+    __m256 max = _mm256_set1_ps(stats.max);
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d squares0 = _mm256_setzero_pd();
+    __m256d squares1 = _mm256_setzero_pd();
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256i counts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(columns.count + i));
+        count0 = _mm256_add_epi64(count0, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(counts)));
+        count1 = _mm256_add_epi64(count1, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(counts, 1)));
+        min = _mm256_min_ps(min, _mm256_loadu_ps(columns.min + i));
+        max = _mm256_max_ps(max, _mm256_loadu_ps(columns.max + i));
+        sum0 = _mm256_add_pd(sum0, _mm256_loadu_pd(columns.sum + i));
+        sum1 = _mm256_add_pd(sum1, _mm256_loadu_pd(columns.sum + i + 4));
+        squares0 = _mm256_add_pd(squares0, _mm256_loadu_pd(columns.sum_squares + i));
+        squares1 = _mm256_add_pd(squares1, _mm256_loadu_pd(columns.sum_squares + i + 4));
+    }
+
+    uint64_t counts[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(counts), _mm256_add_epi64(count0, count1));
+    RollupStats merged;
+    merged.count = counts[0] + counts[1] + counts[2] + counts[3];
+    merged.min = min_of(min);
+    merged.max = max_of(max);
+    merged.sum = sum_of(_mm256_add_pd(sum0, sum1));
+    merged.sum_squares = sum_of(_mm256_add_pd(squares0, squares1));
+    stats.add(merged);
+    buckets_portable(columns, i, end, stats);
+}
+
+#endif // LAB_ROLLUP_AVX2
+
+} // namespace
+
+bool rollup_simd_available()
+{
+#if LAB_ROLLUP_AVX2
+    static const bool available = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return available;
+#else
+    return false;
+#endif
+}
+
+void rollup_use_simd(bool enable)
+{
+    simd_enabled = enable;
+}
+
+bool rollup_simd_active()
+{
+    return simd_enabled && rollup_simd_available();
+}
+
+void rollup_samples(const float *values, size_t count, RollupStats &stats)
+{
+#if LAB_ROLLUP_AVX2
+    if (rollup_simd_active()) {
+        samples_avx2(values, count, stats);
+        return;
+    }
+#endif
+    samples_portable(values, count, stats);
+}
+
+void rollup_buckets(const RollupColumns &columns, size_t begin, size_t end, RollupStats &stats)
+{
+#if LAB_ROLLUP_AVX2
+    if (rollup_simd_active()) {
+        buckets_avx2(columns, begin, end, stats);
+        return;
+    }
+#endif
+    buckets_portable(columns, begin, end, stats);
+}
+
+} // namespace lab
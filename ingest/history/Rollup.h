@@ -0,0 +1,88 @@
+#ifndef LAB_ROLLUP_H
+#define LAB_ROLLUP_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace lab {
+
+/**
+ * Count, extremes and sums of a set of samples. Rollups of adjacent time
+ * ranges merge with add(), so a bucket can be made of coarser buckets
+ * and raw samples alike.
+ */
+struct RollupStats {
+    uint64_t count;
+    float min;
+    float max;
+    double sum;
+    double sum_squares;
+
+    RollupStats() :
+        count(0),
+        min(std::numeric_limits<float>::infinity()),
+        max(-std::numeric_limits<float>::infinity()),
+        sum(0.0),
+        sum_squares(0.0)
+    {
+    }
+
+    void add(const RollupStats &other)
+    {
+        count += other.count;
+        min = other.min < min ? other.min : min;
+        max = other.max > max ? other.max : max;
+        sum += other.sum;
+        sum_squares += other.sum_squares;
+    }
+
+    double mean() const
+    {
+        return count ? sum / count : 0.0;
+    }
+
+    double rms() const
+    {
+        return count ? std::sqrt(sum_squares / count) : 0.0;
+    }
+};
+
+/**
+ * Buckets of one channel in struct-of-arrays layout, as a rollup tier
+ * stores them: bucket i is count[i], min[i], ... An empty bucket has a
+ * count of 0, min +inf and max -inf, so it merges as a no-op.
+ */
+struct RollupColumns {
+    const uint32_t *count;
+    const float *min;
+    const float *max;
+    const double *sum;
+    const double *sum_squares;
+};
+
+/**
+ * Merge count samples into stats. Sums are kept in double, the values
+ * are the raw sensor units of a history column.
+ */
+void rollup_samples(const float *values, size_t count, RollupStats &stats);
+
+/** Merge buckets [begin, end) of a tier column into stats. */
+void rollup_buckets(const RollupColumns &columns, size_t begin, size_t end, RollupStats &stats);
+
+/** Whether the CPU runs the AVX2 kernels. */
+bool rollup_simd_available();
+
+/**
+ * Use the AVX2 kernels when the CPU has them (the default), or the
+ * portable ones, to compare both.
+ */
+void rollup_use_simd(bool enable);
+
+/** Whether rollup_samples() and rollup_buckets() currently use AVX2. */
+bool rollup_simd_active();
+
+} // namespace lab
+
+#endif // LAB_ROLLUP_H
@@ -0,0 +1,56 @@
+#include "SampleLine.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+/** The number after "key": in a flat JSON object. */
+bool number_of(const char *line, const char *key, double &value)
+{
+    char quoted[16];
+    snprintf(quoted, sizeof(quoted), "\"%s\"", key);
+    const char *found = strstr(line, quoted);
+    if (!found) {
+        return false;
+    }
+    const char *c = found + strlen(quoted);
+    while (*c == ' ') {
+        c++;
+    }
+    if (*c++ != ':') {
+        return false;
+    }
+    char *end;
+    value = strtod(c, &end);
+    if (end == c) {
+        return false;
+    }
+    while (*end == ' ') {
+        end++;
+    }
+    return *end == ',' || *end == '}';
+}
+
+} // namespace
+
+bool parse_sample_line(const char *line, float values[HISTORY_CHANNELS], int64_t &sequence)
+{
+    double value;
+    for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+        if (!number_of(line, history_channel_name(channel), value)) {
+            return false;
+        }
+        values[channel] = (float)value;
+    }
+    if (!number_of(line, "s", value)) {
+        return false;
+    }
+    sequence = (int64_t)value;
+    return true;
+}
+
+} // namespace lab
@@ -0,0 +1,25 @@
+#ifndef LAB_SAMPLE_LINE_H
+#define LAB_SAMPLE_LINE_H
+
+#include <cstdint>
+
+#include "SensorHistory.h"
+
+namespace lab {
+
+/**
+ * Parse one line of the data files client-server/server.py writes, the
+ * JSON of one telemetry message. Raw IMU samples,
+ *
+ *     {"a_x": 12, "a_y": -31, "a_z": 1002, "g_x": 175.0, "g_y": -8.75, "g_z": 35.0, "s": 42}
+ *
+ * give their values in channel order and their sequence number; feature
+ * frames, metrics and anomaly snippets are not samples.
+ *
+ * @return true if the line is a raw sample.
+ */
+bool parse_sample_line(const char *line, float values[HISTORY_CHANNELS], int64_t &sequence);
+
+} // namespace lab
+
+#endif // LAB_SAMPLE_LINE_H
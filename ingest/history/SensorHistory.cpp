@@ -0,0 +1,630 @@
+#include "SensorHistory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "MappedFile.h"
+
+namespace lab {
+
+const RollupTier rollup_tiers[ROLLUP_TIER_COUNT] = {
+    { "1m", 60ll * 1000000 },
+    { "1h", 3600ll * 1000000 },
+    { "1d", 86400ll * 1000000 },
+};
+
+namespace {
+
+const char *const channel_names[HISTORY_CHANNELS] = { "a_x", "a_y", "a_z", "g_x", "g_y", "g_z" };
+
+const char RAW_MAGIC[8] = "LABHRAW";
+const char TIER_MAGIC[8] = "LABTIER";
+const uint32_t FORMAT_VERSION = 1;
+
+const size_t HEADER_SIZE = 64;
+const size_t BLOCK_SAMPLES = SensorHistory::BLOCK_SAMPLES;
+const size_t BLOCK_BYTES = BLOCK_SAMPLES * (sizeof(int64_t) + HISTORY_CHANNELS * sizeof(float));
+const size_t TIER_CHUNK = SensorHistory::TIER_CHUNK;
+const size_t CHUNK_BYTES = TIER_CHUNK * (sizeof(uint32_t) + HISTORY_CHANNELS * (2 * sizeof(float) + 2 * sizeof(double)));
+
+struct RawHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_samples;
+    /** Samples stored, written once they are. */
+    uint64_t samples;
+};
+
+struct TierHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunk_buckets;
+    int64_t width_us;
+    /** Bucket number, time / width, of the first bucket of the file. */
+    int64_t origin;
+    /** Buckets from origin to the last one holding samples. */
+    uint64_t buckets;
+    /** Chunks initialised. */
+    uint64_t chunks;
+    /** Raw samples the tier holds, valid if that is all of them. */
+    uint64_t samples;
+};
+
+static_assert(sizeof(RawHeader) <= HEADER_SIZE && sizeof(TierHeader) <= HEADER_SIZE, "history header too large");
+
+/** Columns of one channel in a tier chunk. */
+struct TierColumns {
+    uint32_t *count;
+    float *min;
+    float *max;
+    double *sum;
+    double *sum_squares;
+
+    TierColumns(uint8_t *chunk, size_t channel)
+    {
+        float *floats = reinterpret_cast<float *>(chunk + TIER_CHUNK * sizeof(uint32_t));
+        double *doubles = reinterpret_cast<double *>(floats + 2 * HISTORY_CHANNELS * TIER_CHUNK);
+        count = reinterpret_cast<uint32_t *>(chunk);
+        min = floats + channel * TIER_CHUNK;
+        max = floats + (HISTORY_CHANNELS + channel) * TIER_CHUNK;
+        sum = doubles + channel * TIER_CHUNK;
+        sum_squares = doubles + (HISTORY_CHANNELS + channel) * TIER_CHUNK;
+    }
+};
+
+int64_t floor_div(int64_t value, int64_t divisor)
+{
+    int64_t quotient = value / divisor;
+    return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+int64_t ceil_div(int64_t value, int64_t divisor)
+{
+    return -floor_div(-value, divisor);
+}
+
+/** Capacity for at least count units, a quarter more than before. */
+size_t grown(size_t capacity, size_t count)
+{
+    size_t step = capacity + capacity / 4 + 1;
+    return count > step ? count : step;
+}
+
+bool valid_name(const char *name)
+{
+    if (!*name || *name == '.') {
+        return false;
+    }
+    for (const char *c = name; *c; c++) {
+        bool valid = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') ||
+                     strchr("-_.:", *c);
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const char *history_channel_name(size_t channel)
+{
+    return channel < HISTORY_CHANNELS ? channel_names[channel] : "?";
+}
+
+int history_channel_from_name(const char *name)
+{
+    for (size_t i = 0; i < HISTORY_CHANNELS; i++) {
+        if (strcmp(name, channel_names[i]) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+struct SensorHistory::Device {
+    std::string name;
+    MappedFile raw;
+    MappedFile tiers[ROLLUP_TIER_COUNT];
+    /** Samples readable: the header count, within the mapped blocks. */
+    uint64_t samples;
+    /** The tier holds exactly the readable samples. */
+    bool tier_valid[ROLLUP_TIER_COUNT];
+
+    RawHeader *raw_header() const
+    {
+        return reinterpret_cast<RawHeader *>(raw.data());
+    }
+
+    TierHeader *tier_header(size_t level) const
+    {
+        return reinterpret_cast<TierHeader *>(tiers[level].data());
+    }
+
+    uint8_t *block(uint64_t index) const
+    {
+        return raw.data() + HEADER_SIZE + index * BLOCK_BYTES;
+    }
+
+    int64_t *times(uint64_t block_index) const
+    {
+        return reinterpret_cast<int64_t *>(block(block_index));
+    }
+
+    float *values(uint64_t block_index, size_t channel) const
+    {
+        return reinterpret_cast<float *>(block(block_index) + BLOCK_SAMPLES * sizeof(int64_t)) +
+               channel * BLOCK_SAMPLES;
+    }
+
+    int64_t time_at(uint64_t sample) const
+    {
+        return times(sample / BLOCK_SAMPLES)[sample % BLOCK_SAMPLES];
+    }
+
+    uint64_t mapped_blocks() const
+    {
+        return raw.size() < HEADER_SIZE ? 0 : (raw.size() - HEADER_SIZE) / BLOCK_BYTES;
+    }
+
+    uint64_t mapped_chunks(size_t level) const
+    {
+        size_t size = tiers[level].size();
+        return size < HEADER_SIZE ? 0 : (size - HEADER_SIZE) / CHUNK_BYTES;
+    }
+
+    /** First sample at or after time_us, in [begin, samples]. */
+    uint64_t lower_bound(int64_t time_us, uint64_t begin) const
+    {
+        uint64_t end = samples;
+        while (begin < end) {
+            uint64_t middle = begin + (end - begin) / 2;
+            if (time_at(middle) < time_us) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+        return begin;
+    }
+
+    int reserve_samples(uint64_t count)
+    {
+        uint64_t blocks = (count + BLOCK_SAMPLES - 1) / BLOCK_SAMPLES;
+        if (blocks <= mapped_blocks()) {
+            return 0;
+        }
+        return raw.reserve(HEADER_SIZE + grown(mapped_blocks(), blocks) * BLOCK_BYTES);
+    }
+
+    int reserve_chunks(size_t level, uint64_t chunks)
+    {
+        if (chunks > mapped_chunks(level) &&
+            tiers[level].reserve(HEADER_SIZE + grown(mapped_chunks(level), chunks) * CHUNK_BYTES) != 0) {
+            return -1;
+        }
+        TierHeader *header = tier_header(level);
+        for (uint64_t chunk = header->chunks; chunk < chunks; chunk++) {
+            uint8_t *base = tiers[level].data() + HEADER_SIZE + chunk * CHUNK_BYTES;
+            memset(base, 0, CHUNK_BYTES);
+            for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                TierColumns columns(base, channel);
+                std::fill(columns.min, columns.min + TIER_CHUNK, RollupStats().min);
+                std::fill(columns.max, columns.max + TIER_CHUNK, RollupStats().max);
+            }
+        }
+        if (chunks > header->chunks) {
+            header->chunks = chunks;
+        }
+        return 0;
+    }
+
+    void reset_tier(size_t level)
+    {
+        TierHeader *header = tier_header(level);
+        memset(header, 0, HEADER_SIZE);
+        memcpy(header->magic, TIER_MAGIC, sizeof(header->magic));
+        header->version = FORMAT_VERSION;
+        header->chunk_buckets = TIER_CHUNK;
+        header->width_us = rollup_tiers[level].width_us;
+    }
+
+    /** Fold one sample into a tier, writable histories only. */
+    int add_to_tier(size_t level, const HistorySample &sample)
+    {
+        TierHeader *header = tier_header(level);
+        int64_t bucket = floor_div(sample.time_us, header->width_us);
+        if (header->buckets == 0) {
+            header->origin = bucket;
+        }
+        uint64_t index = bucket - header->origin;
+        uint64_t chunk = index / TIER_CHUNK;
+        if (chunk >= header->chunks) {
+            if (reserve_chunks(level, chunk + 1) != 0) {
+                return -1;
+            }
+            header = tier_header(level);
+        }
+
+        uint8_t *base = tiers[level].data() + HEADER_SIZE + chunk * CHUNK_BYTES;
+        size_t slot = index % TIER_CHUNK;
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            TierColumns columns(base, channel);
+            float value = sample.values[channel];
+            columns.min[slot] = value < columns.min[slot] ? value : columns.min[slot];
+            columns.max[slot] = value > columns.max[slot] ? value : columns.max[slot];
+            columns.sum[slot] += value;
+            columns.sum_squares[slot] += (double)value * value;
+        }
+        TierColumns(base, 0).count[slot]++;
+        if (index >= header->buckets) {
+            header->buckets = index + 1;
+        }
+        return 0;
+    }
+
+    /** Merge the tier buckets numbered [first, last) of one channel. */
+    void tier_range(size_t level, size_t channel, int64_t first, int64_t last, RollupStats &stats) const
+    {
+        const TierHeader *header = tier_header(level);
+        int64_t begin = std::max(first, header->origin);
+        int64_t end = std::min(last, header->origin + (int64_t)header->buckets);
+        for (int64_t index = begin - header->origin; index < end - header->origin;) {
+            uint64_t chunk = index / TIER_CHUNK;
+            size_t slot = index % TIER_CHUNK;
+            size_t length = std::min<int64_t>(end - header->origin - index, TIER_CHUNK - slot);
+            TierColumns columns(tiers[level].data() + HEADER_SIZE + chunk * CHUNK_BYTES, channel);
+            RollupColumns view = { columns.count, columns.min, columns.max, columns.sum, columns.sum_squares };
+            rollup_buckets(view, slot, slot + length, stats);
+            index += length;
+        }
+    }
+
+    /** Merge the samples in [from_us, to_us), searching from cursor on. */
+    void raw_range(size_t channel, int64_t from_us, int64_t to_us, uint64_t &cursor, RollupStats &stats) const
+    {
+        uint64_t begin = lower_bound(from_us, cursor);
+        uint64_t end = lower_bound(to_us, begin);
+        cursor = end;
+        while (begin < end) {
+            uint64_t block_index = begin / BLOCK_SAMPLES;
+            size_t offset = begin % BLOCK_SAMPLES;
+            size_t length = std::min<uint64_t>(end - begin, BLOCK_SAMPLES - offset);
+            rollup_samples(values(block_index, channel) + offset, length, stats);
+            begin += length;
+        }
+    }
+};
+
+SensorHistory::SensorHistory() :
+    _writable(false)
+{
+}
+
+SensorHistory::~SensorHistory()
+{
+    close();
+}
+
+int SensorHistory::open(const char *directory, bool writable)
+{
+    close();
+    _directory = directory;
+    _writable = writable;
+    if (writable && mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        return -1;
+    }
+
+    DIR *dir = opendir(directory);
+    if (!dir) {
+        return -1;
+    }
+    std::vector<std::string> names;
+    while (struct dirent *entry = readdir(dir)) {
+        size_t length = strlen(entry->d_name);
+        if (length > 4 && strcmp(entry->d_name + length - 4, ".raw") == 0) {
+            names.push_back(std::string(entry->d_name, length - 4));
+        }
+    }
+    closedir(dir);
+
+    // devices in name order, the same on every open
+    std::sort(names.begin(), names.end());
+    for (const std::string &name : names) {
+        if (valid_name(name.c_str()) && open_device(name) == -1) {
+            close();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int SensorHistory::open_device(const std::string &name)
+{
+    Device *device = new Device();
+    device->name = name;
+    device->samples = 0;
+
+    std::string path = _directory + "/" + name;
+    if (device->raw.open((path + ".raw").c_str(), _writable) != 0) {
+        delete device;
+        return -1;
+    }
+    if (device->raw.size() < HEADER_SIZE) {
+        if (!_writable) {
+            // being created by the process that ingests, skipped
+            delete device;
+            return -2;
+        }
+        if (device->raw.reserve(HEADER_SIZE) != 0) {
+            delete device;
+            return -1;
+        }
+        RawHeader *header = device->raw_header();
+        memcpy(header->magic, RAW_MAGIC, sizeof(header->magic));
+        header->version = FORMAT_VERSION;
+        header->block_samples = BLOCK_SAMPLES;
+        header->samples = 0;
+    }
+
+    const RawHeader *header = device->raw_header();
+    if (memcmp(header->magic, RAW_MAGIC, sizeof(header->magic)) != 0 || header->version != FORMAT_VERSION ||
+        header->block_samples != BLOCK_SAMPLES) {
+        delete device;
+        return -1;
+    }
+    device->samples = std::min<uint64_t>(header->samples, device->mapped_blocks() * BLOCK_SAMPLES);
+
+    bool stale = false;
+    for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+        MappedFile &tier = device->tiers[level];
+        device->tier_valid[level] = false;
+        if (tier.open((path + "." + rollup_tiers[level].name).c_str(), _writable) != 0) {
+            if (_writable) {
+                delete device;
+                return -1;
+            }
+            continue;
+        }
+        const TierHeader *tier_header = device->tier_header(level);
+        device->tier_valid[level] = tier.size() >= HEADER_SIZE &&
+                                    memcmp(tier_header->magic, TIER_MAGIC, sizeof(tier_header->magic)) == 0 &&
+                                    tier_header->version == FORMAT_VERSION &&
+                                    tier_header->chunk_buckets == TIER_CHUNK &&
+                                    tier_header->width_us == rollup_tiers[level].width_us &&
+                                    tier_header->samples == device->samples &&
+                                    tier_header->chunks <= device->mapped_chunks(level) &&
+                                    tier_header->buckets <= tier_header->chunks * TIER_CHUNK;
+        stale |= !device->tier_valid[level];
+    }
+
+    _devices.push_back(device);
+    int index = (int)_devices.size() - 1;
+    if (_writable && stale && rebuild_tiers(index) != 0) {
+        return -1;
+    }
+    return index;
+}
+
+void SensorHistory::close()
+{
+    for (Device *device : _devices) {
+        delete device;
+    }
+    _devices.clear();
+}
+
+int SensorHistory::sync()
+{
+    int result = 0;
+    for (Device *device : _devices) {
+        result |= device->raw.sync();
+        for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+            result |= device->tiers[level].sync();
+        }
+    }
+    return result ? -1 : 0;
+}
+
+const char *SensorHistory::device_name(size_t device) const
+{
+    return _devices[device]->name.c_str();
+}
+
+int SensorHistory::find_device(const char *name) const
+{
+    for (size_t i = 0; i < _devices.size(); i++) {
+        if (_devices[i]->name == name) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int SensorHistory::add_device(const char *name)
+{
+    int index = find_device(name);
+    if (index >= 0) {
+        return index;
+    }
+    if (!_writable || !valid_name(name)) {
+        return -1;
+    }
+    return open_device(name);
+}
+
+uint64_t SensorHistory::sample_count(size_t device) const
+{
+    return _devices[device]->samples;
+}
+
+int64_t SensorHistory::first_us(size_t device) const
+{
+    const Device &history = *_devices[device];
+    return history.samples ? history.time_at(0) : 0;
+}
+
+int64_t SensorHistory::last_us(size_t device) const
+{
+    const Device &history = *_devices[device];
+    return history.samples ? history.time_at(history.samples - 1) : 0;
+}
+
+long SensorHistory::ingest(size_t index, const HistorySample *samples, size_t count)
+{
+    if (!_writable) {
+        return -1;
+    }
+    Device &device = *_devices[index];
+    if (device.reserve_samples(device.samples + count) != 0) {
+        return -1;
+    }
+
+    // the tiers change before the samples are counted: stale until done
+    for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+        device.tier_header(level)->samples = UINT64_MAX;
+    }
+
+    int64_t last = device.samples ? device.time_at(device.samples - 1) : INT64_MIN;
+    uint64_t stored = device.samples;
+    for (size_t i = 0; i < count; i++) {
+        const HistorySample &sample = samples[i];
+        if (sample.time_us < last) {
+            continue;
+        }
+        uint64_t block_index = stored / BLOCK_SAMPLES;
+        size_t offset = stored % BLOCK_SAMPLES;
+        device.times(block_index)[offset] = sample.time_us;
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            device.values(block_index, channel)[offset] = sample.values[channel];
+        }
+        for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+            if (device.add_to_tier(level, sample) != 0) {
+                // the tiers no longer match the samples, open() rebuilds them
+                return -1;
+            }
+        }
+        last = sample.time_us;
+        stored++;
+    }
+
+    long added = (long)(stored - device.samples);
+    device.samples = stored;
+    device.raw_header()->samples = stored;
+    for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+        device.tier_header(level)->samples = stored;
+    }
+    return added;
+}
+
+int SensorHistory::rebuild_tiers(size_t index)
+{
+    if (!_writable) {
+        return -1;
+    }
+    Device &device = *_devices[index];
+    for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+        if (device.tiers[level].reserve(HEADER_SIZE) != 0) {
+            return -1;
+        }
+        device.reset_tier(level);
+    }
+
+    HistorySample sample;
+    for (uint64_t i = 0; i < device.samples; i++) {
+        uint64_t block_index = i / BLOCK_SAMPLES;
+        size_t offset = i % BLOCK_SAMPLES;
+        sample.time_us = device.times(block_index)[offset];
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            sample.values[channel] = device.values(block_index, channel)[offset];
+        }
+        for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+            if (device.add_to_tier(level, sample) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    for (size_t level = 0; level < ROLLUP_TIER_COUNT; level++) {
+        device.tier_header(level)->samples = device.samples;
+        device.tier_valid[level] = true;
+    }
+    return 0;
+}
+
+void SensorHistory::accumulate(const Device &device, size_t channel, int64_t from_us, int64_t to_us, int level,
+                               uint64_t &cursor, RollupStats &stats) const
+{
+    if (from_us >= to_us) {
+        return;
+    }
+    if (level < 0) {
+        device.raw_range(channel, from_us, to_us, cursor, stats);
+        return;
+    }
+    if (!device.tier_valid[level]) {
+        accumulate(device, channel, from_us, to_us, level - 1, cursor, stats);
+        return;
+    }
+
+    // whole buckets of this tier inside the range, the edges from finer ones
+    int64_t width = rollup_tiers[level].width_us;
+    int64_t first = ceil_div(from_us, width);
+    int64_t last = floor_div(to_us, width);
+    if (first >= last) {
+        accumulate(device, channel, from_us, to_us, level - 1, cursor, stats);
+        return;
+    }
+    accumulate(device, channel, from_us, first * width, level - 1, cursor, stats);
+    device.tier_range(level, channel, first, last, stats);
+    accumulate(device, channel, last * width, to_us, level - 1, cursor, stats);
+}
+
+void SensorHistory::query(size_t index, const RollupQuery &query, std::vector<Rollup> &rollups) const
+{
+    const Device &device = *_devices[index];
+    if (!device.samples || query.channel >= HISTORY_CHANNELS) {
+        return;
+    }
+    int64_t from_us = std::max(query.from_us, device.time_at(0));
+    int64_t to_us = std::min(query.to_us, device.time_at(device.samples - 1) + 1);
+    if (from_us >= to_us) {
+        return;
+    }
+    int top = query.use_tiers ? (int)ROLLUP_TIER_COUNT - 1 : -1;
+    uint64_t cursor = 0;
+
+    if (query.bucket_us <= 0) {
+        Rollup rollup;
+        rollup.start_us = from_us;
+        accumulate(device, query.channel, from_us, to_us, top, cursor, rollup.stats);
+        if (rollup.stats.count) {
+            rollups.push_back(rollup);
+        }
+        return;
+    }
+
+    int64_t width = query.bucket_us;
+    for (int64_t start = floor_div(from_us, width) * width; start < to_us; start += width) {
+        Rollup rollup;
+        rollup.start_us = start;
+        int64_t end = std::min(start + width, to_us);
+        accumulate(device, query.channel, std::max(start, from_us), end, top, cursor, rollup.stats);
+        if (rollup.stats.count) {
+            rollups.push_back(rollup);
+            continue;
+        }
+        // nothing in this bucket: go straight to the bucket of the next sample
+        cursor = device.lower_bound(end, cursor);
+        if (cursor == device.samples) {
+            return;
+        }
+        start = floor_div(device.time_at(cursor), width) * width - width;
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,180 @@
+#ifndef LAB_SENSOR_HISTORY_H
+#define LAB_SENSOR_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Rollup.h"
+
+namespace lab {
+
+/** Accelerometer (mg) then gyroscope (mdps) axes of a telemetry sample. */
+enum HistoryChannel {
+    HISTORY_A_X,
+    HISTORY_A_Y,
+    HISTORY_A_Z,
+    HISTORY_G_X,
+    HISTORY_G_Y,
+    HISTORY_G_Z,
+    HISTORY_CHANNELS
+};
+
+/** "a_x" ... "g_z", the keys of the telemetry JSON. */
+const char *history_channel_name(size_t channel);
+
+/** @return the channel of a name, or -1. */
+int history_channel_from_name(const char *name);
+
+struct HistorySample {
+    /** Microseconds since the Unix epoch, UTC. */
+    int64_t time_us;
+    float values[HISTORY_CHANNELS];
+};
+
+/** A precomputed resolution, buckets aligned on multiples of width_us. */
+struct RollupTier {
+    const char *name;
+    int64_t width_us;
+};
+
+static const size_t ROLLUP_TIER_COUNT = 3;
+
+/** 1 minute, 1 hour and 1 day, finest first. */
+extern const RollupTier rollup_tiers[ROLLUP_TIER_COUNT];
+
+/** One time bucket of a query result. */
+struct Rollup {
+    int64_t start_us;
+    RollupStats stats;
+};
+
+struct RollupQuery {
+    RollupQuery(size_t channel, int64_t from_us, int64_t to_us, int64_t bucket_us) :
+        channel(channel),
+        from_us(from_us),
+        to_us(to_us),
+        bucket_us(bucket_us),
+        use_tiers(true)
+    {
+    }
+
+    size_t channel;
+    /** Samples with from_us <= time < to_us. */
+    int64_t from_us;
+    int64_t to_us;
+    /**
+     * Bucket width, buckets start on multiples of it since the epoch;
+     * 0 makes the whole range one bucket.
+     */
+    int64_t bucket_us;
+    /** false reduces the raw samples only, to check or compare. */
+    bool use_tiers;
+};
+
+/**
+ * IMU history of many devices in a directory, with rollup queries.
+ *
+ * Each device has a column file, NAME.raw, and one file per rollup tier,
+ * NAME.1m, NAME.1h and NAME.1d. Samples are stored in blocks of
+ * BLOCK_SAMPLES: the timestamps, then each channel, contiguous. A tier
+ * holds, per bucket and channel, the count, min, max, sum and sum of
+ * squares of the samples, in chunks of TIER_CHUNK buckets laid out the
+ * same way. Files are mapped in memory and grow in place; their content
+ * is in host byte order.
+ *
+ * ingest() appends samples in time order and updates every tier on the
+ * way, so the tiers never need a batch job. A query splits each bucket
+ * into the largest whole tier buckets it holds, and reduces the ragged
+ * edges from the next finer tier down to the raw samples. Weeks of data
+ * at any bucket width cost a few thousand tier buckets and two short runs
+ * of samples per bucket; the reductions run over contiguous columns with
+ * the AVX2 kernels of Rollup.h.
+ *
+ * One process ingests; others may open the directory read-only at the
+ * same time and see the data as of open(). A tier is only used if it
+ * holds exactly the samples of the raw file, a reader opening in the
+ * middle of a batch falls back to the raw samples for that device.
+ */
+class SensorHistory {
+public:
+    static const size_t BLOCK_SAMPLES = 4096;
+    static const size_t TIER_CHUNK = 1024;
+
+    SensorHistory();
+    ~SensorHistory();
+
+    SensorHistory(const SensorHistory &) = delete;
+    SensorHistory &operator=(const SensorHistory &) = delete;
+
+    /**
+     * Open every device of a directory, created if writable. Missing or
+     * stale tiers of a writable history are rebuilt.
+     *
+     * @return 0, or -1.
+     */
+    int open(const char *directory, bool writable);
+
+    void close();
+
+    /** Write the mapped files back to disk. @return 0, or -1. */
+    int sync();
+
+    size_t device_count() const
+    {
+        return _devices.size();
+    }
+
+    const char *device_name(size_t device) const;
+
+    /** @return the index of a device, or -1. */
+    int find_device(const char *name) const;
+
+    /**
+     * Index of a device, added if new. Names are made of letters, digits
+     * and "-_.:", not starting with a dot.
+     *
+     * @return the index, or -1 for a bad name, an I/O error or a
+     * read-only history.
+     */
+    int add_device(const char *name);
+
+    uint64_t sample_count(size_t device) const;
+
+    /** Time of the first and last sample, 0 if there is none. */
+    int64_t first_us(size_t device) const;
+    int64_t last_us(size_t device) const;
+
+    /**
+     * Append samples sorted by time. A sample older than the last one
+     * stored is dropped, equal times are kept.
+     *
+     * @return the number of samples stored, or -1 on an I/O error.
+     */
+    long ingest(size_t device, const HistorySample *samples, size_t count);
+
+    /** Recompute the tiers of a device from its samples. @return 0, or -1. */
+    int rebuild_tiers(size_t device);
+
+    /**
+     * Rollups of one channel of a device, appended to rollups in time
+     * order. Empty buckets are left out.
+     */
+    void query(size_t device, const RollupQuery &query, std::vector<Rollup> &rollups) const;
+
+private:
+    struct Device;
+
+    int open_device(const std::string &name);
+    void accumulate(const Device &device, size_t channel, int64_t from_us, int64_t to_us, int level,
+                    uint64_t &cursor, RollupStats &stats) const;
+
+    std::string _directory;
+    bool _writable;
+    std::vector<Device *> _devices;
+};
+
+} // namespace lab
+
+#endif // LAB_SENSOR_HISTORY_H
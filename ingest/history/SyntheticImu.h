@@ -0,0 +1,53 @@
+#ifndef LAB_SYNTHETIC_IMU_H
+#define LAB_SYNTHETIC_IMU_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "SensorHistory.h"
+
+namespace lab {
+
+/**
+ * Telemetry of a board on a bench, for benchmarks and demonstrations:
+ * gravity on Z, a slow tilt, a daily temperature drift of the gyroscope
+ * bias and a few LSB of noise, in the units of the telemetry JSON.
+ * Sample index of a device always gives the same values, whatever the
+ * batches they are generated in.
+ */
+inline void synthetic_imu(HistorySample *samples, size_t count, uint32_t device, uint64_t index,
+                          int64_t start_us, int64_t period_us)
+{
+    const double two_pi = 6.283185307179586;
+    const double day_us = 86400e6;
+    double phase = device * 0.37;
+    for (size_t i = 0; i < count; i++, index++) {
+        HistorySample &sample = samples[i];
+        sample.time_us = start_us + (int64_t)index * period_us;
+        double tilt = std::sin(two_pi * sample.time_us / 600e6 + phase);
+        double day = std::sin(two_pi * sample.time_us / day_us + phase);
+
+        // xorshift32 seeded by device and index, never 0
+        uint32_t state = (uint32_t)(index * 2654435761u) ^ (device * 0x9E3779B9u) ^ 0x1234567u;
+        state |= 1;
+        float noise[HISTORY_CHANNELS];
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            noise[channel] = (float)(state % 17) - 8.0f;
+        }
+
+        sample.values[HISTORY_A_X] = (float)(40.0 * tilt) + noise[0];
+        sample.values[HISTORY_A_Y] = (float)(-25.0 * tilt) + noise[1];
+        sample.values[HISTORY_A_Z] = (float)(1000.0 - 2.0 * tilt * tilt) + noise[2];
+        sample.values[HISTORY_G_X] = (float)(120.0 * day) + 10.0f * noise[3];
+        sample.values[HISTORY_G_Y] = (float)(-80.0 * day) + 10.0f * noise[4];
+        sample.values[HISTORY_G_Z] = (float)(35.0 + 60.0 * day) + 10.0f * noise[5];
+    }
+}
+
+} // namespace lab
+
+#endif // LAB_SYNTHETIC_IMU_H
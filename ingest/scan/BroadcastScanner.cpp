@@ -0,0 +1,189 @@
+#include "BroadcastScanner.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = (char)tolower((unsigned char)c);
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : -1;
+}
+
+const char *skip_spaces(const char *at)
+{
+    while (*at == ' ' || *at == '\t') {
+        at++;
+    }
+    return at;
+}
+
+const char *word_end(const char *at)
+{
+    while (*at && !isspace((unsigned char)*at)) {
+        at++;
+    }
+    return at;
+}
+
+} // namespace
+
+bool parse_scan_report(const char *line, ScanReport &report)
+{
+    const char *at = skip_spaces(line);
+    char *end;
+    long long time_us = strtoll(at, &end, 10);
+    if (end == at || (*end != ' ' && *end != '\t')) {
+        return false;
+    }
+
+    at = skip_spaces(end);
+    const char *address_end = word_end(at);
+    if (address_end == at) {
+        return false;
+    }
+    report.address.assign(at, address_end);
+
+    at = skip_spaces(address_end);
+    long rssi = strtol(at, &end, 10);
+    if (end == at) {
+        return false;
+    }
+
+    at = skip_spaces(end);
+    const char *kind_end = word_end(at);
+    size_t kind_length = (size_t)(kind_end - at);
+    if (kind_length == 6 && strncmp(at, "legacy", 6) == 0) {
+        report.extended = false;
+    } else if (kind_length == 8 && strncmp(at, "extended", 8) == 0) {
+        report.extended = true;
+    } else {
+        return false;
+    }
+
+    at = skip_spaces(kind_end);
+    report.payload.clear();
+    while (*at && !isspace((unsigned char)*at)) {
+        int high = hex_digit(at[0]);
+        int low = high < 0 ? -1 : hex_digit(at[1]);
+        if (low < 0 || report.payload.size() == SCAN_MAX_PAYLOAD) {
+            return false;
+        }
+        report.payload.push_back((uint8_t)(high << 4 | low));
+        at += 2;
+    }
+    if (report.payload.empty() || (!report.extended && report.payload.size() > BROADCAST_LEGACY_PAYLOAD)) {
+        return false;
+    }
+    report.time_us = time_us;
+    report.rssi = (int)rssi;
+    return true;
+}
+
+bool BroadcastScanner::add(const ScanReport &report, ScanBatch &batch)
+{
+    BroadcastFragment fragment;
+    bool parsed = broadcast_parse(report.payload.data(), report.payload.size(), fragment) == 0;
+    auto found = _nodes.find(report.address);
+    if (found == _nodes.end()) {
+        if (!parsed) {
+            // somebody else's advertising
+            return false;
+        }
+        found = _nodes.emplace(report.address, Node()).first;
+    }
+    Node &node = found->second;
+    node.stats.reports++;
+    node.stats.last_us = report.time_us;
+    node.stats.rssi = report.rssi;
+    if (!parsed) {
+        node.stats.malformed++;
+        return false;
+    }
+
+    node.stats.fragments++;
+    uint32_t incomplete = node.assembler.incomplete();
+    BroadcastAssembler::Result result = node.assembler.add(fragment);
+    node.stats.incomplete += node.assembler.incomplete() - incomplete;
+    switch (result) {
+        case BroadcastAssembler::PENDING:
+            return false;
+        case BroadcastAssembler::DUPLICATE:
+            node.stats.duplicates++;
+            return false;
+        case BroadcastAssembler::REJECTED:
+            node.stats.rejected++;
+            return false;
+        case BroadcastAssembler::COMPLETE:
+            break;
+    }
+
+    batch.values.resize(IMU_CODEC_MAX_FRAMES * IMU_CODEC_MAX_CHANNELS);
+    int frames = broadcast_decode_imu(node.assembler.batch(), node.assembler.batch_length(), batch.first_frame,
+                                      batch.period_us, batch.values.data(), IMU_CODEC_MAX_FRAMES, batch.channels);
+    if (frames <= 0) {
+        node.stats.decode_errors++;
+        return false;
+    }
+    batch.address = report.address;
+    batch.time_us = report.time_us;
+    batch.sequence = node.assembler.sequence();
+    batch.frames = (size_t)frames;
+    batch.values.resize(batch.frames * batch.channels);
+
+    // frame numbers going back are a restart of the node
+    if (node.has_frames && batch.first_frame > node.next_frame) {
+        node.stats.missed_frames += batch.first_frame - node.next_frame;
+    }
+    node.next_frame = batch.first_frame + (uint32_t)batch.frames;
+    node.has_frames = true;
+    node.stats.batches++;
+    node.stats.frames += batch.frames;
+    return true;
+}
+
+std::vector<std::string> BroadcastScanner::nodes() const
+{
+    std::vector<std::string> addresses;
+    for (const auto &node : _nodes) {
+        addresses.push_back(node.first);
+    }
+    return addresses;
+}
+
+const ScanNodeStats *BroadcastScanner::stats(const std::string &address) const
+{
+    auto found = _nodes.find(address);
+    return found == _nodes.end() ? nullptr : &found->second.stats;
+}
+
+ScanNodeStats BroadcastScanner::total() const
+{
+    ScanNodeStats total;
+    for (const auto &node : _nodes) {
+        const ScanNodeStats &stats = node.second.stats;
+        total.reports += stats.reports;
+        total.fragments += stats.fragments;
+        total.duplicates += stats.duplicates;
+        total.rejected += stats.rejected;
+        total.malformed += stats.malformed;
+        total.incomplete += stats.incomplete;
+        total.batches += stats.batches;
+        total.decode_errors += stats.decode_errors;
+        total.frames += stats.frames;
+        total.missed_frames += stats.missed_frames;
+        if (stats.last_us > total.last_us) {
+            total.last_us = stats.last_us;
+        }
+    }
+    return total;
+}
+
+} // namespace lab
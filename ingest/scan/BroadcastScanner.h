@@ -0,0 +1,134 @@
+#ifndef LAB_BROADCAST_SCANNER_H
+#define LAB_BROADCAST_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "BroadcastFormat.h"
+
+namespace lab {
+
+/** Largest advertising payload, an extended advertising chain. */
+static const size_t SCAN_MAX_PAYLOAD = 1650;
+
+/**
+ * One advertising report of a scanner, a line of text:
+ *
+ *     time_us address rssi legacy|extended payload-hex
+ *
+ * e.g. "1000001 c0:de:00:00:00:01 -60 legacy 1effffff0101...", as the
+ * host build of the board writes them with MBED_HOST_BLE_SCAN and a
+ * gateway gets them from its controller.
+ */
+struct ScanReport {
+    int64_t time_us;
+    std::string address;
+    int rssi;
+    bool extended;
+    std::vector<uint8_t> payload;
+};
+
+/** @return true if the line is a report. */
+bool parse_scan_report(const char *line, ScanReport &report);
+
+/** Per broadcaster, since the first report of it. */
+struct ScanNodeStats {
+    ScanNodeStats() :
+        reports(0),
+        fragments(0),
+        duplicates(0),
+        rejected(0),
+        malformed(0),
+        incomplete(0),
+        batches(0),
+        decode_errors(0),
+        frames(0),
+        missed_frames(0),
+        last_us(0),
+        rssi(0)
+    {
+    }
+
+    uint64_t reports;
+    /** Reports with a fragment in them, duplicates included. */
+    uint64_t fragments;
+    uint64_t duplicates;
+    /** Fragments that did not fit their batch, batches whose tag did not match. */
+    uint64_t rejected;
+    /** Reports of the broadcaster with no or a malformed fragment. */
+    uint64_t malformed;
+    /** Batches started and not completed before the next one. */
+    uint64_t incomplete;
+    uint64_t batches;
+    /** Complete batches, tag and all, the codec did not take. */
+    uint64_t decode_errors;
+    uint64_t frames;
+    /** Frame numbers skipped between one batch and the next. */
+    uint64_t missed_frames;
+    int64_t last_us;
+    int rssi;
+};
+
+/** The frames of one complete batch. */
+struct ScanBatch {
+    std::string address;
+    int64_t time_us;
+    uint16_t sequence;
+    uint32_t first_frame;
+    uint32_t period_us;
+    uint8_t channels;
+    size_t frames;
+    /** frames * channels interleaved values. */
+    std::vector<int16_t> values;
+};
+
+/**
+ * Harvests the sensor batches of many broadcasters from advertising
+ * reports, see lab-utils/ble/BroadcastFormat.h.
+ *
+ * Each address gets a BroadcastAssembler; reports of different nodes
+ * interleave freely, the repeats of a fragment count as duplicates and
+ * a batch comes out once, when its last missing fragment arrives and its
+ * tag matches.
+ */
+class BroadcastScanner {
+public:
+    /**
+     * Take one report.
+     *
+     * @return true if it completed a batch, which is then in batch.
+     */
+    bool add(const ScanReport &report, ScanBatch &batch);
+
+    /** Addresses seen, sorted. */
+    std::vector<std::string> nodes() const;
+
+    /** @return stats of a node, nullptr if it never broadcast. */
+    const ScanNodeStats *stats(const std::string &address) const;
+
+    /** The stats of all nodes added up, last_us the latest. */
+    ScanNodeStats total() const;
+
+private:
+    struct Node {
+        Node() :
+            next_frame(0),
+            has_frames(false)
+        {
+        }
+
+        BroadcastAssembler assembler;
+        ScanNodeStats stats;
+        uint32_t next_frame;
+        bool has_frames;
+    };
+
+    std::map<std::string, Node> _nodes;
+};
+
+} // namespace lab
+
+#endif // LAB_BROADCAST_SCANNER_H
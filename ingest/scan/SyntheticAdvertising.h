@@ -0,0 +1,188 @@
+#ifndef LAB_SYNTHETIC_ADVERTISING_H
+#define LAB_SYNTHETIC_ADVERTISING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "BroadcastFormat.h"
+#include "BroadcastScanner.h"
+#include "ImuCodec.h"
+
+namespace lab {
+
+struct SyntheticAdvertisingOptions {
+    SyntheticAdvertisingOptions() :
+        nodes(100),
+        legacy(false),
+        frame_period_us(38528),
+        batch_ms(1000),
+        interval_ms(100),
+        rotate_ms(300),
+        max_fragments(3),
+        loss(0.2),
+        corrupt(0.001),
+        restart(false)
+    {
+    }
+
+    unsigned nodes;
+    /** 31 byte payloads instead of extended advertising ones. */
+    bool legacy;
+    /** The decimated IMU frames of the Sensors example, 64 samples at 1660 Hz. */
+    uint32_t frame_period_us;
+    /** A batch of the frames since the last one every batch_ms, as SensorBroadcaster. */
+    uint32_t batch_ms;
+    uint32_t interval_ms;
+    uint32_t rotate_ms;
+    size_t max_fragments;
+    /** Share of the advertising events the scanner misses. */
+    double loss;
+    /** Share of the reports with a bit flipped that the CRC of the radio let through. */
+    double corrupt;
+    /** Whether the first node restarts half way, frames and sequence back to 0. */
+    bool restart;
+};
+
+/**
+ * Six channels of a node, frame by frame: slow tones with a little
+ * noise, different per node and per run of the node (epoch) so a batch
+ * put together across a restart does not come out right by chance.
+ */
+inline void synthetic_broadcast_frame(unsigned node, unsigned epoch, uint32_t frame, int16_t values[6])
+{
+    const double two_pi = 6.283185307179586;
+    double time_s = frame * 0.0385;
+    for (unsigned channel = 0; channel < 6; channel++) {
+        uint32_t hash = (node * 0x9E3779B1u) ^ (epoch * 0x85EBCA77u) ^ (frame * 0xC2B2AE3Du) ^ (channel * 0x27D4EB2Fu);
+        hash ^= hash >> 15;
+        hash *= 0x2C1B3C6Du;
+        hash ^= hash >> 12;
+        double amplitude = channel < 3 ? 4000.0 : 800.0;
+        double value = amplitude * std::sin(two_pi * (0.3 + 0.1 * channel + 0.01 * node) * time_s + epoch) +
+                       (double)(hash % 65) - 32.0;
+        values[channel] = (int16_t)value;
+    }
+}
+
+/** What the nodes of synthetic_advertising() did, to check the scanner against. */
+struct SyntheticAdvertisingRun {
+    std::vector<ScanReport> reports;
+    /** Batches on the air, all nodes. */
+    uint64_t batches;
+    /** When the first node restarted, its reports from then on are of epoch 1; INT64_MAX if it did not. */
+    int64_t restart_us;
+};
+
+/** Address of node n. */
+inline std::string synthetic_node_address(unsigned node)
+{
+    char address[18];
+    snprintf(address, sizeof(address), "c0:de:00:00:%02x:%02x", (node >> 8) & 0xFF, node & 0xFF);
+    return address;
+}
+
+/**
+ * The advertising reports a gateway gets from nodes broadcasting like
+ * SensorBroadcaster over seconds, in time order: each node starts at its
+ * own time in the first second, publishes a batch every batch_ms and
+ * rotates its fragments every rotate_ms, with the 0-10 ms random delay
+ * of each advertising event. Some events are lost, some reports
+ * corrupted.
+ */
+inline SyntheticAdvertisingRun synthetic_advertising(const SyntheticAdvertisingOptions &options, double seconds)
+{
+    SyntheticAdvertisingRun run;
+    run.batches = 0;
+    run.restart_us = INT64_MAX;
+    uint32_t state = 0x2545F491u;
+    auto uniform = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0 / 16777216.0);
+    };
+
+    ImuCodecConfig codec = {};
+    codec.channels = 6;
+    ImuEncoder encoder(codec);
+    BroadcastPacker packer(options.legacy ? BROADCAST_LEGACY_PAYLOAD : BROADCAST_EXTENDED_PAYLOAD);
+    size_t budget = std::min(options.max_fragments * packer.fragment_data(), BROADCAST_MAX_BATCH);
+    int64_t end_us = (int64_t)(seconds * 1e6);
+    int64_t batch_us = (int64_t)options.batch_ms * 1000;
+
+    std::vector<int16_t> values;
+    uint8_t batch[BROADCAST_MAX_BATCH];
+    uint8_t payload[BROADCAST_EXTENDED_PAYLOAD];
+    for (unsigned node = 0; node < options.nodes; node++) {
+        int64_t start_us = (int64_t)(uniform() * 1e6);
+        int64_t restart_us = options.restart && node == 0 ? end_us / 2 : INT64_MAX;
+        unsigned epoch = 0;
+        uint32_t next_frame = 0;
+        uint16_t sequence = 0;
+        int64_t event_us = start_us;
+        for (int64_t publish_us = start_us + batch_us; publish_us < end_us; publish_us += batch_us) {
+            if (publish_us >= restart_us) {
+                run.restart_us = publish_us;
+                epoch++;
+                next_frame = 0;
+                sequence = 0;
+                restart_us = INT64_MAX;
+            }
+            // the frames since the last batch, the newest that fit
+            uint32_t frames = (uint32_t)(batch_us / options.frame_period_us);
+            values.resize(frames * 6);
+            for (uint32_t k = 0; k < frames; k++) {
+                synthetic_broadcast_frame(node, epoch, next_frame + k, &values[k * 6]);
+            }
+            int length = -1;
+            uint32_t sent = frames;
+            while (sent) {
+                uint32_t skipped = frames - sent;
+                length = broadcast_encode_imu(encoder, next_frame + skipped, options.frame_period_us,
+                                              &values[skipped * 6], sent, batch, budget);
+                if (length > 0) {
+                    break;
+                }
+                sent /= 2;
+            }
+            next_frame += frames;
+            if (length <= 0 || packer.set(++sequence, batch, (size_t)length) < 0) {
+                continue;
+            }
+            run.batches++;
+
+            int64_t until_us = std::min(publish_us + batch_us, end_us);
+            for (event_us = std::max(event_us, publish_us); event_us < until_us;
+                 event_us += options.interval_ms * 1000 + (int64_t)(uniform() * 10000)) {
+                if (uniform() < options.loss) {
+                    continue;
+                }
+                size_t index = (size_t)((event_us - publish_us) / (options.rotate_ms * 1000)) % packer.fragments();
+                int size = packer.pack(index, payload, sizeof(payload));
+                ScanReport report;
+                report.time_us = event_us;
+                report.address = synthetic_node_address(node);
+                report.rssi = -40 - (int)(node % 50);
+                report.extended = !options.legacy;
+                report.payload.assign(payload, payload + size);
+                if (uniform() < options.corrupt) {
+                    size_t bit = (size_t)(uniform() * size * 8);
+                    report.payload[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+                }
+                run.reports.push_back(report);
+            }
+        }
+    }
+    std::stable_sort(run.reports.begin(), run.reports.end(), [](const ScanReport &a, const ScanReport &b) {
+        return a.time_us < b.time_us;
+    });
+    return run;
+}
+
+} // namespace lab
+
+#endif // LAB_SYNTHETIC_ADVERTISING_H
@@ -0,0 +1,351 @@
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BroadcastRing.h"
+#include "SampleLine.h"
+#include "SyntheticStreams.h"
+#include "TimeAligner.h"
+
+/*
+ * Boards on one time grid:
+ *
+ *     align live [--period-ms MS] [--grid-ms MS] [--method linear|sinc] RING...
+ *     align synth [--boards N] [--seconds S] [--rate-hz R] [--skew-ppm P] [--jitter-ms M]
+ *                 [--drop P] [--restart] [--method linear|sinc] [--scalar] [--dump] [--check]
+ *
+ * live reads the broadcast rings of several server.py, one board each,
+ * times the samples on arrival and prints the aligned samples as CSV,
+ * a row per grid point and six columns per board, once a second.
+ *
+ * synth aligns drifting synthetic boards (SyntheticStreams.h) block by
+ * block as they arrive, and reports the clock errors found against the
+ * true ones, the timing error against the s * period of server.py and
+ * the error of the aligned samples. --check exits with 1 if these are
+ * out of bounds, --dump prints the aligned blocks instead.
+ */
+
+using namespace lab;
+
+namespace {
+
+const int64_t SECOND_US = 1000000;
+
+volatile sig_atomic_t stopped = 0;
+
+int usage()
+{
+    fprintf(stderr,
+            "usage: align live [--period-ms MS] [--grid-ms MS] [--method linear|sinc] RING...\n"
+            "       align synth [--boards N] [--seconds S] [--rate-hz R] [--skew-ppm P] [--jitter-ms M]\n"
+            "                   [--drop P] [--restart] [--method linear|sinc] [--scalar] [--dump] [--check]\n");
+    return 2;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+int64_t now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * SECOND_US + now.tv_nsec / 1000;
+}
+
+void print_rows(FILE *output, const AlignedBlock &block)
+{
+    for (size_t k = 0; k < block.length; k++) {
+        fprintf(output, "%.3f", block.time_us(k) / 1e6);
+        for (size_t board = 0; board < block.boards; board++) {
+            for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+                float value = block.column(board, channel)[k];
+                if (std::isnan(value)) {
+                    fputs(",", output);
+                } else {
+                    fprintf(output, ",%.3f", value);
+                }
+            }
+        }
+        fputs("\n", output);
+    }
+}
+
+int live_command(int argc, char **argv)
+{
+    AlignOptions options;
+    std::vector<std::string> names;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--period-ms") == 0 && has_value) {
+            options.nominal_period_us = (int64_t)(atof(argv[++i]) * 1000);
+        } else if (strcmp(argv[i], "--grid-ms") == 0 && has_value) {
+            options.grid_period_us = (int64_t)(atof(argv[++i]) * 1000);
+        } else if (strcmp(argv[i], "--method") == 0 && has_value) {
+            if (!resample_method_from_name(argv[++i], options.method)) {
+                return usage();
+            }
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    if (names.empty() || options.nominal_period_us <= 0 || options.grid_period_us <= 0) {
+        return usage();
+    }
+
+    TimeAligner aligner(options);
+    std::vector<std::unique_ptr<BroadcastReader>> readers;
+    for (const std::string &name : names) {
+        readers.emplace_back(new BroadcastReader());
+        if (readers.back()->open(name.c_str()) != 0) {
+            perror(name.c_str());
+            return 1;
+        }
+        aligner.add_board();
+    }
+    signal(SIGINT, [](int) { stopped = 1; });
+    signal(SIGTERM, [](int) { stopped = 1; });
+
+    printf("time");
+    for (const std::string &name : names) {
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            printf(",%s.%s", name.c_str(), history_channel_name(channel));
+        }
+    }
+    printf("\n");
+
+    char line[1024];
+    AlignedBlock block;
+    int64_t next_us = INT64_MIN;
+    int64_t flushed_us = now_us();
+    while (!stopped) {
+        bool idle = true;
+        for (size_t board = 0; board < readers.size(); board++) {
+            BroadcastMessage message;
+            for (int count = 0; count < 256 && readers[board]->peek(message); count++) {
+                int64_t arrival_us = now_us();
+                float values[HISTORY_CHANNELS];
+                int64_t sequence;
+                bool sample = message.type == BROADCAST_JSON && message.length < sizeof(line);
+                if (sample) {
+                    memcpy(line, message.data, message.length);
+                    line[message.length] = '\0';
+                }
+                if (readers[board]->consume() && sample && parse_sample_line(line, values, sequence)) {
+                    aligner.add(board, sequence, arrival_us, values);
+                }
+                idle = false;
+            }
+        }
+
+        if (now_us() - flushed_us >= SECOND_US) {
+            flushed_us = now_us();
+            int64_t ready_us = aligner.ready_until();
+            if (ready_us != INT64_MIN && next_us == INT64_MIN) {
+                next_us = ready_us / options.grid_period_us * options.grid_period_us;
+            }
+            if (ready_us != INT64_MIN && ready_us >= next_us) {
+                size_t length = (size_t)((ready_us - next_us) / options.grid_period_us) + 1;
+                aligner.align(next_us, length, block);
+                print_rows(stdout, block);
+                fflush(stdout);
+                next_us += (int64_t)length * options.grid_period_us;
+                aligner.discard_before(next_us);
+            }
+        }
+        if (idle) {
+            readers[0]->wait(10);
+        }
+    }
+
+    for (size_t board = 0; board < names.size(); board++) {
+        BoardTiming timing = aligner.timing(board);
+        fprintf(stderr, "%s: %+.1f ppm, %llu samples, %llu missing, %u runs\n", names[board].c_str(),
+                timing.clock.skew_ppm, (unsigned long long)timing.samples, (unsigned long long)timing.missing,
+                timing.runs);
+    }
+    return 0;
+}
+
+struct Error {
+    Error() : sum_squares(0.0), count(0) {}
+
+    void add(double error)
+    {
+        sum_squares += error * error;
+        count++;
+    }
+
+    double rms() const
+    {
+        return count ? std::sqrt(sum_squares / count) : 0.0;
+    }
+
+    double sum_squares;
+    uint64_t count;
+};
+
+int synth_command(int argc, char **argv)
+{
+    SyntheticStreamOptions streams;
+    double seconds = 600;
+    AlignOptions options;
+    bool dump = false;
+    bool check = false;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--boards") == 0 && has_value) {
+            streams.boards = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rate-hz") == 0 && has_value) {
+            streams.rate_hz = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--skew-ppm") == 0 && has_value) {
+            streams.skew_ppm = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter-ms") == 0 && has_value) {
+            streams.jitter_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--drop") == 0 && has_value) {
+            streams.drop = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--restart") == 0) {
+            streams.restart = true;
+        } else if (strcmp(argv[i], "--method") == 0 && has_value) {
+            if (!resample_method_from_name(argv[++i], options.method)) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--scalar") == 0) {
+            resample_use_simd(false);
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dump = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            return usage();
+        }
+    }
+    if (streams.boards == 0 || streams.rate_hz <= 0 || seconds <= 0) {
+        return usage();
+    }
+    options.nominal_period_us = (int64_t)(SECOND_US / streams.rate_hz);
+    options.grid_period_us = options.nominal_period_us;
+
+    std::vector<SyntheticArrival> arrivals = synthetic_streams(streams, seconds);
+    TimeAligner aligner(options);
+    for (unsigned board = 0; board < streams.boards; board++) {
+        aligner.add_board();
+    }
+
+    // as they arrive, aligned every 10 s of arrivals
+    double floor_us = streams.floor_ms * 1000.0;
+    AlignedBlock block;
+    Error sample_error;
+    double signal_squares = 0.0;
+    size_t points = 0;
+    double align_ms = 0.0;
+    int64_t next_us = 0;
+    int64_t block_end_us = 10 * SECOND_US;
+    for (size_t i = 0; i <= arrivals.size(); i++) {
+        bool last = i == arrivals.size();
+        if (last || arrivals[i].arrival_us >= block_end_us) {
+            int64_t ready_us = aligner.ready_until();
+            if (ready_us != INT64_MIN && ready_us >= next_us) {
+                size_t length = (size_t)((ready_us - next_us) / options.grid_period_us) + 1;
+                auto started = std::chrono::steady_clock::now();
+                aligner.align(next_us, length, block);
+                align_ms += elapsed_ms(started);
+                if (dump) {
+                    print_rows(stdout, block);
+                }
+                for (size_t k = 0; k < block.length; k++) {
+                    float truth[HISTORY_CHANNELS];
+                    synthetic_table_motion((block.time_us(k) - floor_us) * 1e-6, truth);
+                    for (size_t board = 0; board < block.boards; board++) {
+                        if (block.valid(board, k)) {
+                            sample_error.add(block.column(board, HISTORY_A_X)[k] - truth[HISTORY_A_X]);
+                            signal_squares += (double)truth[HISTORY_A_X] * truth[HISTORY_A_X];
+                        }
+                    }
+                }
+                points += block.length * block.boards;
+                next_us += (int64_t)length * options.grid_period_us;
+                aligner.discard_before(next_us);
+            }
+            block_end_us += 10 * SECOND_US;
+        }
+        if (!last) {
+            const SyntheticArrival &sample = arrivals[i];
+            aligner.add(sample.board, sample.sequence, sample.arrival_us, sample.values);
+        }
+    }
+
+    // sample times of the last run of every board, with the final clocks
+    std::vector<Error> timing_error(streams.boards);
+    std::vector<Error> naive_error(streams.boards);
+    std::vector<int64_t> run_start(streams.boards, INT64_MIN);
+    std::vector<int64_t> run_first(streams.boards, 0);
+    std::vector<int64_t> previous(streams.boards, INT64_MAX);
+    for (const SyntheticArrival &sample : arrivals) {
+        if (sample.sequence < previous[sample.board]) {
+            // server.py: the first arrival, then s * period
+            timing_error[sample.board] = Error();
+            naive_error[sample.board] = Error();
+            run_start[sample.board] = sample.arrival_us;
+            run_first[sample.board] = sample.sequence;
+        }
+        previous[sample.board] = sample.sequence;
+        ClockFit fit = aligner.timing(sample.board).clock;
+        double estimated = fit.origin_us + (sample.sequence - fit.first_sequence) * fit.period_us - floor_us;
+        double naive = run_start[sample.board] +
+                       (double)(sample.sequence - run_first[sample.board]) * options.nominal_period_us - floor_us;
+        timing_error[sample.board].add((estimated - sample.true_us) / 1000.0);
+        naive_error[sample.board].add((naive - sample.true_us) / 1000.0);
+    }
+
+    FILE *report = dump ? stderr : stdout;
+    bool failed = false;
+    fprintf(report, "%-6s %10s %10s %12s %12s %8s %8s %5s\n", "board", "skew ppm", "found", "timing ms", "naive ms",
+            "missing", "filled", "runs");
+    for (unsigned board = 0; board < streams.boards; board++) {
+        BoardTiming timing = aligner.timing(board);
+        double skew = synthetic_skew_ppm(streams, board);
+        fprintf(report, "%-6u %+10.1f %+10.1f %12.2f %12.2f %8llu %8llu %5u\n", board, skew, timing.clock.skew_ppm,
+                timing_error[board].rms(), naive_error[board].rms(), (unsigned long long)timing.missing,
+                (unsigned long long)timing.filled, timing.runs);
+        failed |= std::fabs(timing.clock.skew_ppm - skew) > 5.0 || timing_error[board].rms() > 2.0;
+    }
+    double relative = signal_squares > 0 ? sample_error.rms() / std::sqrt(signal_squares / sample_error.count) : 0.0;
+    fprintf(report, "a_x error %.2f mg rms, %.2f %% of the signal, %s, %zu of %zu grid points in %.1f ms (%s)\n",
+            sample_error.rms(), 100.0 * relative, resample_method_name(options.method),
+            (size_t)sample_error.count, points, align_ms, resample_simd_active() ? "avx2" : "scalar");
+    failed |= relative > (options.method == RESAMPLE_SINC ? 0.04 : 0.08) || sample_error.count == 0;
+    if (check && failed) {
+        fprintf(stderr, "align: out of bounds\n");
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "live") == 0) {
+        return live_command(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "synth") == 0) {
+        return synth_command(argc - 2, argv + 2);
+    }
+    return usage();
+}
@@ -0,0 +1,275 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "CaptureReplay.h"
+#include "SyntheticTraces.h"
+
+/*
+ * The trigger capture of the boards on accelerometer traces:
+ *
+ *     capture replay [SETTINGS] [--samples] [FILE]
+ *     capture synth [SETTINGS] [--seconds S] [--trace FILE] [--samples] [--check]
+ *
+ *     SETTINGS: [--pre N] [--post N] [--high MG] [--low MG] [--hysteresis MG]
+ *               [--mg-per-lsb X] [--hold-ms MS]
+ *
+ * replay runs a trace (CaptureReplay.h) from FILE or stdin through the
+ * capture and prints a line per burst: sequence, source, pre-trigger
+ * samples, length, requested, trigger, first and last time. --samples
+ * adds the samples of each burst after its line, as trace lines, so a
+ * burst uploaded by a board replays as well. The settings default to the
+ * ones of the BLE button example.
+ *
+ * synth makes a trace of knocks, presses, falls and commands
+ * (SyntheticTraces.h), writes it to --trace and prints the bursts of it
+ * as replay does. --check exits with 1 unless every event gave its burst,
+ * from the sample of the event on, with the full history before it and
+ * the samples of the trace, and the second press of each pair was
+ * turned down.
+ */
+
+using namespace lab;
+
+namespace {
+
+int usage()
+{
+    fprintf(stderr,
+            "usage: capture replay [SETTINGS] [--samples] [FILE]\n"
+            "       capture synth [SETTINGS] [--seconds S] [--trace FILE] [--samples] [--check]\n"
+            "SETTINGS: [--pre N] [--post N] [--high MG] [--low MG] [--hysteresis MG] [--mg-per-lsb X]\n"
+            "          [--hold-ms MS]\n");
+    return 2;
+}
+
+/** @return 1 if argv[i] was a setting (and its value), 0 if not one, -1 if the value is missing. */
+int parse_setting(int argc, char **argv, int &i, CaptureReplayOptions &options)
+{
+    static const char *const names[] = { "--pre", "--post", "--high", "--low", "--hysteresis", "--mg-per-lsb",
+                                         "--hold-ms" };
+    size_t which = 0;
+    while (which < sizeof(names) / sizeof(names[0]) && strcmp(argv[i], names[which]) != 0) {
+        which++;
+    }
+    if (which == sizeof(names) / sizeof(names[0])) {
+        return 0;
+    }
+    if (i + 1 >= argc) {
+        return -1;
+    }
+    const char *value = argv[++i];
+    switch (which) {
+        case 0:
+            options.pre_samples = (uint16_t)atoi(value);
+            break;
+        case 1:
+            options.post_samples = (uint16_t)atoi(value);
+            break;
+        case 2:
+            options.high_mg = (unsigned)atoi(value);
+            break;
+        case 3:
+            options.low_mg = (unsigned)atoi(value);
+            break;
+        case 4:
+            options.hysteresis_mg = (unsigned)atoi(value);
+            break;
+        case 5:
+            options.mg_per_lsb = atof(value);
+            break;
+        default:
+            options.hold_us = (uint32_t)atoi(value) * 1000;
+            break;
+    }
+    return 1;
+}
+
+void print_stats(FILE *output, const CaptureReplay &replay)
+{
+    const CaptureStats &stats = replay.stats();
+    fprintf(output, "%lu samples, %lu bursts, %lu triggers busy, %lu late, %lu samples dropped while frozen\n",
+            (unsigned long)stats.samples, (unsigned long)stats.bursts, (unsigned long)stats.busy,
+            (unsigned long)stats.late, (unsigned long)stats.dropped);
+}
+
+int replay_command(int argc, char **argv)
+{
+    CaptureReplayOptions options;
+    bool samples = false;
+    const char *path = nullptr;
+    for (int i = 0; i < argc; i++) {
+        int setting = parse_setting(argc, argv, i, options);
+        if (setting < 0) {
+            return usage();
+        } else if (setting) {
+            continue;
+        } else if (strcmp(argv[i], "--samples") == 0) {
+            samples = true;
+        } else if (!path && argv[i][0] != '-') {
+            path = argv[i];
+        } else {
+            return usage();
+        }
+    }
+
+    CaptureReplay replay;
+    if (replay.configure(options)) {
+        fprintf(stderr, "capture: the settings do not fit %zu samples\n", CaptureReplay::CAPACITY);
+        return 2;
+    }
+    FILE *input = stdin;
+    if (path) {
+        input = fopen(path, "r");
+        if (!input) {
+            perror(path);
+            return 1;
+        }
+    }
+    char line[256];
+    uint64_t skipped = 0;
+    while (fgets(line, sizeof(line), input)) {
+        int result = replay.line(line);
+        if (result < 0) {
+            skipped++;
+        } else if (result) {
+            print_replay_burst(stdout, replay.bursts().back(), samples);
+        }
+    }
+    if (input != stdin) {
+        fclose(input);
+    }
+    print_stats(stderr, replay);
+    if (skipped) {
+        fprintf(stderr, "%llu lines are not trace lines\n", (unsigned long long)skipped);
+    }
+    return 0;
+}
+
+/** Every burst where the events put it, with the samples of the trace. */
+bool check_bursts(const SyntheticTraceOptions &trace_options, const CaptureReplayOptions &options,
+                  const SyntheticTrace &trace, const CaptureReplay &replay)
+{
+    size_t expected = 0;
+    size_t busy = 0;
+    bool good = true;
+    const std::vector<ReplayBurst> &bursts = replay.bursts();
+    for (const SyntheticTraceEvent &event : trace.events) {
+        if (event.busy) {
+            busy++;
+            continue;
+        }
+        if (expected >= bursts.size()) {
+            fprintf(stderr, "capture: no burst for the %s at %lu us\n", capture_source_name(event.source),
+                    (unsigned long)event.time_us);
+            return false;
+        }
+        const ReplayBurst &burst = bursts[expected++];
+        uint64_t trigger = ((uint64_t)event.time_us * trace_options.rate_hz + 999999) / 1000000;
+        while (synthetic_trace_time(trigger, trace_options.rate_hz) < event.time_us) {
+            trigger++;
+        }
+        bool same = burst.burst.source == event.source && burst.burst.pre == options.pre_samples &&
+                    burst.burst.length == options.pre_samples + options.post_samples &&
+                    burst.burst.trigger_us == synthetic_trace_time(trigger, trace_options.rate_hz);
+        for (size_t i = 0; same && i < burst.burst.length; i++) {
+            uint64_t index = trigger - burst.burst.pre + i;
+            int16_t values[3];
+            synthetic_trace_sample(trace_options, trace.events, index, values);
+            same = burst.times[i] == synthetic_trace_time(index, trace_options.rate_hz) &&
+                   memcmp(values, &burst.values[i * 3], sizeof(values)) == 0;
+        }
+        if (!same) {
+            fprintf(stderr, "capture: burst %u is not the one of the %s at %lu us\n",
+                    (unsigned)burst.burst.sequence, capture_source_name(event.source), (unsigned long)event.time_us);
+            good = false;
+        }
+    }
+    if (bursts.size() != expected || replay.stats().busy != busy) {
+        fprintf(stderr, "capture: %zu bursts and %lu busy, %zu and %zu expected\n", bursts.size(),
+                (unsigned long)replay.stats().busy, expected, busy);
+        good = false;
+    }
+    return good && expected > 0;
+}
+
+int synth_command(int argc, char **argv)
+{
+    CaptureReplayOptions options;
+    SyntheticTraceOptions trace_options;
+    const char *trace_path = nullptr;
+    bool samples = false;
+    bool check = false;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        int setting = parse_setting(argc, argv, i, options);
+        if (setting < 0) {
+            return usage();
+        } else if (setting) {
+            continue;
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            trace_options.seconds = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--samples") == 0) {
+            samples = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            return usage();
+        }
+    }
+
+    CaptureReplay replay;
+    if (replay.configure(options)) {
+        fprintf(stderr, "capture: the settings do not fit %zu samples\n", CaptureReplay::CAPACITY);
+        return 2;
+    }
+    SyntheticTrace trace = synthetic_trace(trace_options);
+    FILE *output = nullptr;
+    if (trace_path) {
+        output = fopen(trace_path, "w");
+        if (!output) {
+            perror(trace_path);
+            return 1;
+        }
+        fprintf(output, "# %llu samples at %u Hz, %zu events\n", (unsigned long long)trace.samples,
+                (unsigned)trace_options.rate_hz, trace.events.size());
+    }
+    for (const std::string &line : trace.lines) {
+        if (output) {
+            fprintf(output, "%s\n", line.c_str());
+        }
+        if (replay.line(line.c_str()) > 0) {
+            print_replay_burst(stdout, replay.bursts().back(), samples);
+        }
+    }
+    if (output) {
+        fclose(output);
+    }
+    print_stats(stderr, replay);
+
+    if (check && !check_bursts(trace_options, options, trace, replay)) {
+        fprintf(stderr, "capture: out of bounds\n");
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "replay") == 0) {
+        return replay_command(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "synth") == 0) {
+        return synth_command(argc - 2, argv + 2);
+    }
+    return usage();
+}
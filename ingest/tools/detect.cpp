@@ -0,0 +1,271 @@
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BroadcastRing.h"
+#include "MotionDetector.h"
+#include "SampleLine.h"
+#include "SyntheticEvents.h"
+#include "SyntheticImu.h"
+
+/*
+ * Motion anomaly detection on the telemetry:
+ *
+ *     detect live [--alerts RING] [--period-ms MS] [LIMITS] RING...
+ *     detect synth [--devices N] [--seconds S] [--rate-hz R] [--scalar] [LIMITS]
+ *
+ * live reads the broadcast rings server.py publishes to, one per board,
+ * and prints the alerts; --alerts publishes them as JSON on another ring
+ * as well. Samples are timed by their sequence number times --period-ms
+ * (100, the WiFi example). synth runs synthetic boards with knocks and
+ * spins (SyntheticEvents.h) as fast as it can.
+ *
+ * LIMITS: --alpha A --z Z --min-sigma MG --warmup N --jerk MG_PER_S --gyro MDPS,
+ * see MotionLimits.
+ */
+
+using namespace lab;
+
+namespace {
+
+const int64_t SECOND_US = 1000000;
+
+volatile sig_atomic_t stopped = 0;
+
+int usage()
+{
+    fprintf(stderr,
+            "usage: detect live [--alerts RING] [--period-ms MS] [LIMITS] RING...\n"
+            "       detect synth [--devices N] [--seconds S] [--rate-hz R] [--scalar] [LIMITS]\n"
+            "LIMITS: --alpha A --z Z --min-sigma MG --warmup N --jerk MG_PER_S --gyro MDPS\n");
+    return 2;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+/** A limit option at argv[i], its value consumed. */
+bool parse_limit(int argc, char **argv, int &i, MotionLimits &limits)
+{
+    if (i + 1 >= argc) {
+        return false;
+    }
+    const char *option = argv[i];
+    float value = (float)atof(argv[i + 1]);
+    if (strcmp(option, "--alpha") == 0) {
+        limits.alpha = value;
+    } else if (strcmp(option, "--z") == 0) {
+        limits.z = value;
+    } else if (strcmp(option, "--min-sigma") == 0) {
+        limits.min_sigma = value;
+    } else if (strcmp(option, "--warmup") == 0) {
+        limits.warmup = (uint32_t)value;
+    } else if (strcmp(option, "--jerk") == 0) {
+        limits.jerk = value;
+    } else if (strcmp(option, "--gyro") == 0) {
+        limits.gyro = value;
+    } else {
+        return false;
+    }
+    i++;
+    return true;
+}
+
+std::string kind_names(uint32_t kinds)
+{
+    std::string names;
+    for (uint32_t kind = MOTION_ACCEL; kind <= MOTION_GYRO; kind <<= 1) {
+        if (kinds & kind) {
+            names += names.empty() ? "" : ",";
+            names += motion_alert_name(kind);
+        }
+    }
+    return names;
+}
+
+float magnitude(const float *values)
+{
+    return std::sqrt(values[0] * values[0] + values[1] * values[1] + values[2] * values[2]);
+}
+
+int live_command(int argc, char **argv)
+{
+    const char *alerts_name = nullptr;
+    int64_t period_us = 100000;
+    MotionLimits limits;
+    std::vector<std::string> names;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--alerts") == 0 && i + 1 < argc) {
+            alerts_name = argv[++i];
+        } else if (strcmp(argv[i], "--period-ms") == 0 && i + 1 < argc) {
+            period_us = (int64_t)(atof(argv[++i]) * 1000);
+        } else if (argv[i][0] == '-') {
+            if (!parse_limit(argc, argv, i, limits)) {
+                return usage();
+            }
+        } else {
+            names.push_back(argv[i]);
+        }
+    }
+    if (names.empty() || period_us <= 0) {
+        return usage();
+    }
+
+    std::vector<std::unique_ptr<BroadcastReader>> readers;
+    for (const std::string &name : names) {
+        readers.emplace_back(new BroadcastReader());
+        if (readers.back()->open(name.c_str()) != 0) {
+            perror(name.c_str());
+            return 1;
+        }
+    }
+    BroadcastWriter alerts;
+    if (alerts_name && alerts.open(alerts_name, 1 << 20) != 0) {
+        perror(alerts_name);
+        return 1;
+    }
+
+    MotionDetector detector;
+    detector.configure(limits);
+    detector.resize(readers.size());
+    signal(SIGINT, [](int) { stopped = 1; });
+    signal(SIGTERM, [](int) { stopped = 1; });
+
+    char line[1024];
+    while (!stopped) {
+        bool idle = true;
+        for (size_t device = 0; device < readers.size(); device++) {
+            BroadcastReader &reader = *readers[device];
+            BroadcastMessage message;
+            // a bounded batch per ring, so one busy board does not starve the others
+            for (int count = 0; count < 256 && reader.peek(message); count++) {
+                float values[HISTORY_CHANNELS];
+                int64_t sequence;
+                bool sample = message.type == BROADCAST_JSON && message.length < sizeof(line);
+                if (sample) {
+                    memcpy(line, message.data, message.length);
+                    line[message.length] = '\0';
+                }
+                if (reader.consume() && sample && parse_sample_line(line, values, sequence)) {
+                    detector.add((uint32_t)device, sequence * period_us, values);
+                }
+                idle = false;
+            }
+        }
+        if (idle) {
+            detector.flush();
+        }
+
+        for (const MotionAlert &alert : detector.alerts()) {
+            char json[512];
+            int length = snprintf(json, sizeof(json),
+                                  "{\"device\": \"%s\", \"alert\": \"%s\", \"s\": %lld, \"a\": %.1f, "
+                                  "\"mean\": %.1f, \"sigma\": %.1f, \"g\": %.1f}",
+                                  names[alert.device].c_str(), kind_names(alert.kinds).c_str(),
+                                  (long long)(alert.time_us / period_us), magnitude(alert.values),
+                                  alert.accel_mean, alert.accel_sigma, magnitude(alert.values + HISTORY_G_X));
+            puts(json);
+            if (alerts_name) {
+                alerts.publish(BROADCAST_ALERT, json, length);
+            }
+        }
+        if (!detector.alerts().empty()) {
+            detector.clear_alerts();
+            alerts.notify();
+            fflush(stdout);
+        }
+        if (idle) {
+            // the futex of one ring; the others are polled at this pace
+            readers[0]->wait(10);
+        }
+    }
+    return 0;
+}
+
+int synth_command(int argc, char **argv)
+{
+    unsigned devices = 1000;
+    double seconds = 60;
+    unsigned rate_hz = 100;
+    MotionLimits limits;
+    bool simd = true;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--devices") == 0 && has_value) {
+            devices = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--rate-hz") == 0 && has_value) {
+            rate_hz = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scalar") == 0) {
+            simd = false;
+        } else if (!parse_limit(argc, argv, i, limits)) {
+            return usage();
+        }
+    }
+    if (devices == 0 || rate_hz == 0 || seconds <= 0) {
+        return usage();
+    }
+
+    MotionDetector detector;
+    detector.configure(limits);
+    detector.use_simd(simd);
+    detector.resize(devices);
+    int64_t period_us = SECOND_US / rate_hz;
+    uint64_t ticks = (uint64_t)(seconds * rate_hz);
+    HistorySample sample;
+    std::vector<HistorySample> tick(devices);
+    double detect_ms = 0;
+    size_t alerts = 0;
+    for (uint64_t index = 0; index < ticks; index++) {
+        // one sample of every board per tick, generated outside the timing
+        for (unsigned device = 0; device < devices; device++) {
+            synthetic_imu(&sample, 1, device, index, 0, period_us);
+            synthetic_events(sample, device, index, rate_hz);
+            tick[device] = sample;
+        }
+        auto started = std::chrono::steady_clock::now();
+        for (unsigned device = 0; device < devices; device++) {
+            detector.add(device, tick[device].time_us, tick[device].values);
+        }
+        detector.flush();
+        detect_ms += elapsed_ms(started);
+
+        for (const MotionAlert &alert : detector.alerts()) {
+            printf("%10.2f board-%05u %-16s a %8.1f mean %7.1f sigma %6.1f g %9.1f\n", alert.time_us / 1e6,
+                   alert.device, kind_names(alert.kinds).c_str(), magnitude(alert.values), alert.accel_mean,
+                   alert.accel_sigma, magnitude(alert.values + HISTORY_G_X));
+        }
+        alerts += detector.alerts().size();
+        detector.clear_alerts();
+    }
+    double samples = (double)devices * ticks;
+    fprintf(stderr, "%u devices x %llu samples, %zu alerts, %.1f ms (%.1f M samples/s, %s)\n", devices,
+            (unsigned long long)ticks, alerts, detect_ms, samples / detect_ms / 1000,
+            detector.simd_active() ? "avx2" : "scalar");
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "live") == 0) {
+        return live_command(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "synth") == 0) {
+        return synth_command(argc - 2, argv + 2);
+    }
+    return usage();
+}
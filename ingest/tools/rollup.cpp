@@ -0,0 +1,457 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "SampleLine.h"
+#include "SensorHistory.h"
+#include "SyntheticImu.h"
+
+/*
+ * Command line of the sensor history:
+ *
+ *     rollup ingest STORE [--device NAME] [--start TIME] [--period-ms MS] FILE...
+ *     rollup synth STORE [--devices N] [--days D] [--rate-hz R] [--start TIME]
+ *     rollup query STORE [--device NAME]... [--channel NAME]... [--from TIME] [--to TIME]
+ *                        [--bucket WIDTH] [--raw] [--scalar] [--csv]
+ *     rollup info STORE
+ *     rollup rebuild STORE
+ *
+ * Times are UTC, 2024-05-01, 2024-05-01T12:30 or 2024-05-01T12:30:15, or
+ * seconds since the epoch. Widths are a number and a unit: 500ms, 10s,
+ * 15m, 1h, 1d, 1w; 0 is one bucket for the whole range.
+ */
+
+using namespace lab;
+
+namespace {
+
+const int64_t SECOND_US = 1000000;
+
+int usage()
+{
+    fprintf(stderr,
+            "usage: rollup ingest STORE [--device NAME] [--start TIME] [--period-ms MS] FILE...\n"
+            "       rollup synth STORE [--devices N] [--days D] [--rate-hz R] [--start TIME]\n"
+            "       rollup query STORE [--device NAME]... [--channel NAME]... [--from TIME] [--to TIME]\n"
+            "                          [--bucket WIDTH] [--raw] [--scalar] [--csv]\n"
+            "       rollup info STORE\n"
+            "       rollup rebuild STORE\n");
+    return 2;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+bool parse_time(const char *text, int64_t &time_us)
+{
+    char *end;
+    long long seconds = strtoll(text, &end, 10);
+    if (end != text && *end == '\0') {
+        time_us = seconds * SECOND_US;
+        return true;
+    }
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    int fields = sscanf(text, "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second);
+    if (fields != 3 && fields != 5 && fields != 6) {
+        return false;
+    }
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    date.tm_year = year - 1900;
+    date.tm_mon = month - 1;
+    date.tm_mday = day;
+    date.tm_hour = hour;
+    date.tm_min = minute;
+    date.tm_sec = second;
+    time_us = (int64_t)timegm(&date) * SECOND_US;
+    return true;
+}
+
+bool parse_width(const char *text, int64_t &width_us)
+{
+    static const struct {
+        const char *suffix;
+        int64_t us;
+    } units[] = {
+        { "us", 1 }, { "ms", 1000 }, { "s", SECOND_US }, { "m", 60 * SECOND_US },
+        { "h", 3600 * SECOND_US }, { "d", 86400 * SECOND_US }, { "w", 7 * 86400 * SECOND_US },
+    };
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value < 0) {
+        return false;
+    }
+    if (*end == '\0' && value == 0) {
+        width_us = 0;
+        return true;
+    }
+    for (const auto &unit : units) {
+        if (strcmp(end, unit.suffix) == 0) {
+            width_us = (int64_t)(value * unit.us);
+            return width_us > 0;
+        }
+    }
+    return false;
+}
+
+const char *format_time(int64_t time_us, char *text, size_t size)
+{
+    time_t seconds = (time_t)(time_us >= 0 ? time_us / SECOND_US : (time_us - SECOND_US + 1) / SECOND_US);
+    int ms = (int)((time_us - (int64_t)seconds * SECOND_US) / 1000);
+    struct tm date;
+    gmtime_r(&seconds, &date);
+    size_t length = strftime(text, size, "%Y-%m-%dT%H:%M:%S", &date);
+    if (ms) {
+        length += snprintf(text + length, size - length, ".%03d", ms);
+    }
+    snprintf(text + length, size - length, "Z");
+    return text;
+}
+
+/** Start of a file of server.py, named data-DD::MM::YYYY HH:MM:SS.txt in local time. */
+bool start_of_file(const std::string &path, int64_t &time_us)
+{
+    size_t slash = path.rfind('/');
+    std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+    struct tm date;
+    memset(&date, 0, sizeof(date));
+    if (sscanf(name.c_str(), "data-%d::%d::%d %d:%d:%d", &date.tm_mday, &date.tm_mon, &date.tm_year,
+               &date.tm_hour, &date.tm_min, &date.tm_sec) != 6) {
+        return false;
+    }
+    date.tm_mon -= 1;
+    date.tm_year -= 1900;
+    date.tm_isdst = -1;
+    time_us = (int64_t)mktime(&date) * SECOND_US;
+    return true;
+}
+
+struct DataFile {
+    std::string path;
+    int64_t start_us;
+};
+
+int ingest_command(const char *store, int argc, char **argv)
+{
+    const char *device_name = "board";
+    bool run_start = false;
+    int64_t start_us = 0;
+    int64_t period_us = 100000;
+    std::vector<DataFile> files;
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--device") == 0 && i + 1 < argc) {
+            device_name = argv[++i];
+        } else if (strcmp(argv[i], "--start") == 0 && i + 1 < argc) {
+            if (!parse_time(argv[++i], start_us)) {
+                return usage();
+            }
+            run_start = true;
+        } else if (strcmp(argv[i], "--period-ms") == 0 && i + 1 < argc) {
+            period_us = (int64_t)(atof(argv[++i]) * 1000);
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            files.push_back(DataFile { argv[i], 0 });
+        }
+    }
+    if (files.empty() || period_us <= 0) {
+        return usage();
+    }
+    for (DataFile &file : files) {
+        if (!run_start && !start_of_file(file.path, file.start_us)) {
+            fprintf(stderr, "%s: no time in the name, give --start\n", file.path.c_str());
+            return 1;
+        }
+    }
+    // the names sort by day of the month, the times do not
+    std::stable_sort(files.begin(), files.end(), [](const DataFile &a, const DataFile &b) {
+        return a.start_us < b.start_us;
+    });
+
+    SensorHistory history;
+    int device = history.open(store, true) == 0 ? history.add_device(device_name) : -1;
+    if (device < 0) {
+        fprintf(stderr, "%s: cannot open device %s\n", store, device_name);
+        return 1;
+    }
+
+    // with --start the files are one run, the sequence numbers go on
+    bool have_base = false;
+    int64_t base_us = start_us;
+    int64_t base_sequence = 0;
+    int64_t last_sequence = 0;
+    std::vector<HistorySample> samples;
+    char *line = nullptr;
+    size_t capacity = 0;
+    for (const DataFile &file : files) {
+        FILE *input = fopen(file.path.c_str(), "r");
+        if (!input) {
+            perror(file.path.c_str());
+            return 1;
+        }
+        if (!run_start) {
+            have_base = false;
+            base_us = file.start_us;
+        }
+        samples.clear();
+        HistorySample sample;
+        int64_t sequence;
+        while (getline(&line, &capacity, input) > 0) {
+            if (!parse_sample_line(line, sample.values, sequence)) {
+                continue;
+            }
+            if (!have_base) {
+                base_sequence = sequence;
+                have_base = true;
+            } else if (sequence < last_sequence) {
+                // the board restarted its count: carry on after the last sample
+                base_us += (last_sequence - base_sequence + 1) * period_us;
+                base_sequence = sequence;
+            }
+            last_sequence = sequence;
+            sample.time_us = base_us + (sequence - base_sequence) * period_us;
+            samples.push_back(sample);
+        }
+        fclose(input);
+
+        long stored = history.ingest(device, samples.data(), samples.size());
+        if (stored < 0) {
+            fprintf(stderr, "%s: write error\n", store);
+            return 1;
+        }
+        printf("%s: %zu samples, %ld stored\n", file.path.c_str(), samples.size(), stored);
+    }
+    free(line);
+    return history.sync() == 0 ? 0 : 1;
+}
+
+int synth_command(const char *store, int argc, char **argv)
+{
+    unsigned devices = 8;
+    double days = 7;
+    double rate_hz = 10;
+    int64_t start_us = 1704067200 * SECOND_US; // 2024-01-01
+    for (int i = 0; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--devices") == 0) {
+            devices = (unsigned)atoi(argv[i + 1]);
+        } else if (strcmp(argv[i], "--days") == 0) {
+            days = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--rate-hz") == 0) {
+            rate_hz = atof(argv[i + 1]);
+        } else if (strcmp(argv[i], "--start") != 0 || !parse_time(argv[i + 1], start_us)) {
+            return usage();
+        }
+    }
+    if (argc % 2 || rate_hz <= 0 || days <= 0) {
+        return usage();
+    }
+
+    SensorHistory history;
+    if (history.open(store, true) != 0) {
+        fprintf(stderr, "%s: cannot open\n", store);
+        return 1;
+    }
+    int64_t period_us = (int64_t)(SECOND_US / rate_hz);
+    uint64_t count = (uint64_t)(days * 86400 * rate_hz);
+    std::vector<HistorySample> batch(65536);
+    auto started = std::chrono::steady_clock::now();
+    for (unsigned d = 0; d < devices; d++) {
+        char name[32];
+        snprintf(name, sizeof(name), "board-%03u", d);
+        int device = history.add_device(name);
+        if (device < 0) {
+            fprintf(stderr, "%s: cannot add %s\n", store, name);
+            return 1;
+        }
+        // carries on after what an earlier run stored
+        uint64_t first = history.sample_count(device);
+        for (uint64_t index = first; index < first + count; index += batch.size()) {
+            size_t length = (size_t)std::min<uint64_t>(batch.size(), first + count - index);
+            synthetic_imu(batch.data(), length, d, index, start_us, period_us);
+            if (history.ingest(device, batch.data(), length) < 0) {
+                fprintf(stderr, "%s: write error\n", store);
+                return 1;
+            }
+        }
+    }
+    double ms = elapsed_ms(started);
+    printf("%u devices, %llu samples each, in %.0f ms (%.1f M samples/s)\n", devices,
+           (unsigned long long)count, ms, devices * count / ms / 1000);
+    return history.sync() == 0 ? 0 : 1;
+}
+
+struct Series {
+    size_t device;
+    size_t channel;
+    std::vector<Rollup> rollups;
+};
+
+int query_command(const char *store, int argc, char **argv)
+{
+    std::vector<std::string> device_names;
+    std::vector<size_t> channels;
+    int64_t from_us = INT64_MIN;
+    int64_t to_us = INT64_MAX;
+    int64_t bucket_us = 3600 * SECOND_US;
+    bool use_tiers = true;
+    bool csv = false;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--device") == 0 && has_value) {
+            device_names.push_back(argv[++i]);
+        } else if (strcmp(argv[i], "--channel") == 0 && has_value) {
+            int channel = history_channel_from_name(argv[++i]);
+            if (channel < 0) {
+                fprintf(stderr, "unknown channel %s\n", argv[i]);
+                return 2;
+            }
+            channels.push_back(channel);
+        } else if (strcmp(argv[i], "--from") == 0 && has_value) {
+            if (!parse_time(argv[++i], from_us)) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--to") == 0 && has_value) {
+            if (!parse_time(argv[++i], to_us)) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--bucket") == 0 && has_value) {
+            if (!parse_width(argv[++i], bucket_us)) {
+                return usage();
+            }
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            use_tiers = false;
+        } else if (strcmp(argv[i], "--scalar") == 0) {
+            rollup_use_simd(false);
+        } else if (strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        } else {
+            return usage();
+        }
+    }
+
+    SensorHistory history;
+    if (history.open(store, false) != 0) {
+        fprintf(stderr, "%s: cannot open\n", store);
+        return 1;
+    }
+    std::vector<size_t> devices;
+    for (const std::string &name : device_names) {
+        int device = history.find_device(name.c_str());
+        if (device < 0) {
+            fprintf(stderr, "%s: no device %s\n", store, name.c_str());
+            return 1;
+        }
+        devices.push_back(device);
+    }
+    if (device_names.empty()) {
+        for (size_t device = 0; device < history.device_count(); device++) {
+            devices.push_back(device);
+        }
+    }
+    if (channels.empty()) {
+        for (size_t channel = 0; channel < HISTORY_CHANNELS; channel++) {
+            channels.push_back(channel);
+        }
+    }
+
+    std::vector<Series> results;
+    size_t rollups = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (size_t device : devices) {
+        for (size_t channel : channels) {
+            RollupQuery query(channel, from_us, to_us, bucket_us);
+            query.use_tiers = use_tiers;
+            Series series = { device, channel, std::vector<Rollup>() };
+            history.query(device, query, series.rollups);
+            rollups += series.rollups.size();
+            results.push_back(std::move(series));
+        }
+    }
+    double ms = elapsed_ms(started);
+
+    if (csv) {
+        printf("device,channel,start,count,min,max,mean,rms\n");
+    } else {
+        printf("%-12s %-7s %-24s %10s %10s %10s %10s %10s\n", "device", "channel", "start", "count", "min", "max",
+               "mean", "rms");
+    }
+    const char *format = csv ? "%s,%s,%s,%llu,%.3f,%.3f,%.3f,%.3f\n" : "%-12s %-7s %-24s %10llu %10.3f %10.3f %10.3f %10.3f\n";
+    for (const Series &series : results) {
+        for (const Rollup &rollup : series.rollups) {
+            char start[40];
+            printf(format, history.device_name(series.device), history_channel_name(series.channel),
+                   format_time(rollup.start_us, start, sizeof(start)), (unsigned long long)rollup.stats.count,
+                   rollup.stats.min, rollup.stats.max, rollup.stats.mean(), rollup.stats.rms());
+        }
+    }
+    fprintf(stderr, "%zu devices x %zu channels, %zu rollups in %.2f ms (%s, %s)\n", devices.size(), channels.size(),
+            rollups, ms, use_tiers ? "tiers" : "raw", rollup_simd_active() ? "avx2" : "scalar");
+    return 0;
+}
+
+int info_command(const char *store)
+{
+    SensorHistory history;
+    if (history.open(store, false) != 0) {
+        fprintf(stderr, "%s: cannot open\n", store);
+        return 1;
+    }
+    printf("%-12s %12s %-24s %-24s\n", "device", "samples", "first", "last");
+    for (size_t device = 0; device < history.device_count(); device++) {
+        char first[40];
+        char last[40];
+        printf("%-12s %12llu %-24s %-24s\n", history.device_name(device),
+               (unsigned long long)history.sample_count(device),
+               format_time(history.first_us(device), first, sizeof(first)),
+               format_time(history.last_us(device), last, sizeof(last)));
+    }
+    return 0;
+}
+
+int rebuild_command(const char *store)
+{
+    SensorHistory history;
+    if (history.open(store, true) != 0) {
+        fprintf(stderr, "%s: cannot open\n", store);
+        return 1;
+    }
+    auto started = std::chrono::steady_clock::now();
+    for (size_t device = 0; device < history.device_count(); device++) {
+        if (history.rebuild_tiers(device) != 0) {
+            fprintf(stderr, "%s: cannot rebuild %s\n", store, history.device_name(device));
+            return 1;
+        }
+    }
+    printf("%zu devices in %.0f ms\n", history.device_count(), elapsed_ms(started));
+    return history.sync() == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        return usage();
+    }
+    const char *command = argv[1];
+    const char *store = argv[2];
+    if (strcmp(command, "ingest") == 0) {
+        return ingest_command(store, argc - 3, argv + 3);
+    } else if (strcmp(command, "synth") == 0) {
+        return synth_command(store, argc - 3, argv + 3);
+    } else if (strcmp(command, "query") == 0) {
+        return query_command(store, argc - 3, argv + 3);
+    } else if (strcmp(command, "info") == 0 && argc == 3) {
+        return info_command(store);
+    } else if (strcmp(command, "rebuild") == 0 && argc == 3) {
+        return rebuild_command(store);
+    }
+    return usage();
+}
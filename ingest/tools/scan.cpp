@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "BroadcastScanner.h"
+#include "SyntheticAdvertising.h"
+
+/*
+ * Sensor batches of broadcasting boards, from advertising reports:
+ *
+ *     scan decode [FILE]
+ *     scan synth [--nodes N] [--seconds S] [--loss P] [--corrupt P] [--legacy] [--restart]
+ *                [--dump] [--check]
+ *
+ * decode reads reports, one per line as BroadcastScanner.h has them
+ * (MBED_HOST_BLE_SCAN of the host build, or a gateway), from FILE or
+ * stdin, and prints the frames as CSV: address, sequence, frame number
+ * and the values. A table of the nodes goes to stderr at the end.
+ *
+ * synth runs the reports of many synthetic nodes (SyntheticAdvertising.h)
+ * through the scanner and compares every frame that comes out with the
+ * one the node sent. --check exits with 1 if one differs, a batch got
+ * through that should not have, or too few came out for the loss.
+ */
+
+using namespace lab;
+
+namespace {
+
+int usage()
+{
+    fprintf(stderr,
+            "usage: scan decode [FILE]\n"
+            "       scan synth [--nodes N] [--seconds S] [--loss P] [--corrupt P] [--legacy] [--restart]\n"
+            "                  [--dump] [--check]\n");
+    return 2;
+}
+
+void print_batch(FILE *output, const ScanBatch &batch)
+{
+    for (size_t k = 0; k < batch.frames; k++) {
+        fprintf(output, "%s,%u,%u", batch.address.c_str(), (unsigned)batch.sequence,
+                (unsigned)(batch.first_frame + k));
+        for (size_t channel = 0; channel < batch.channels; channel++) {
+            fprintf(output, ",%d", batch.values[k * batch.channels + channel]);
+        }
+        fputs("\n", output);
+    }
+}
+
+void print_nodes(FILE *output, const BroadcastScanner &scanner)
+{
+    fprintf(output, "%-17s %5s %8s %8s %8s %8s %8s %8s %8s\n", "address", "rssi", "reports", "dups", "rejected",
+            "partial", "batches", "frames", "missed");
+    for (const std::string &address : scanner.nodes()) {
+        const ScanNodeStats &stats = *scanner.stats(address);
+        fprintf(output, "%-17s %5d %8llu %8llu %8llu %8llu %8llu %8llu %8llu\n", address.c_str(), stats.rssi,
+                (unsigned long long)stats.reports, (unsigned long long)stats.duplicates,
+                (unsigned long long)stats.rejected, (unsigned long long)stats.incomplete,
+                (unsigned long long)stats.batches, (unsigned long long)stats.frames,
+                (unsigned long long)stats.missed_frames);
+    }
+}
+
+int decode_command(int argc, char **argv)
+{
+    if (argc > 1) {
+        return usage();
+    }
+    FILE *input = stdin;
+    if (argc == 1) {
+        input = fopen(argv[0], "r");
+        if (!input) {
+            perror(argv[0]);
+            return 1;
+        }
+    }
+
+    BroadcastScanner scanner;
+    ScanReport report;
+    ScanBatch batch;
+    char line[4096];
+    uint64_t skipped = 0;
+    printf("address,sequence,frame,c0,c1,c2,c3,c4,c5\n");
+    while (fgets(line, sizeof(line), input)) {
+        if (!parse_scan_report(line, report)) {
+            skipped++;
+            continue;
+        }
+        if (scanner.add(report, batch)) {
+            print_batch(stdout, batch);
+        }
+    }
+    if (input != stdin) {
+        fclose(input);
+    }
+    print_nodes(stderr, scanner);
+    if (skipped) {
+        fprintf(stderr, "%llu lines are not reports\n", (unsigned long long)skipped);
+    }
+    return 0;
+}
+
+int synth_command(int argc, char **argv)
+{
+    SyntheticAdvertisingOptions options;
+    double seconds = 60;
+    bool dump = false;
+    bool check = false;
+    for (int i = 0; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--nodes") == 0 && has_value) {
+            options.nodes = (unsigned)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && has_value) {
+            options.loss = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--corrupt") == 0 && has_value) {
+            options.corrupt = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--legacy") == 0) {
+            options.legacy = true;
+        } else if (strcmp(argv[i], "--restart") == 0) {
+            options.restart = true;
+        } else if (strcmp(argv[i], "--dump") == 0) {
+            dump = true;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else {
+            return usage();
+        }
+    }
+    if (options.nodes == 0 || options.nodes > 65536 || seconds <= 0 || options.loss < 0 || options.loss >= 1) {
+        return usage();
+    }
+
+    SyntheticAdvertisingRun run = synthetic_advertising(options, seconds);
+    BroadcastScanner scanner;
+    ScanBatch batch;
+    uint64_t mismatched = 0;
+    auto started = std::chrono::steady_clock::now();
+    double verify_ms = 0.0;
+    for (const ScanReport &report : run.reports) {
+        if (!scanner.add(report, batch)) {
+            continue;
+        }
+        auto verify = std::chrono::steady_clock::now();
+        if (dump) {
+            print_batch(stdout, batch);
+        }
+        unsigned node = (unsigned)strtoul(batch.address.c_str() + 12, nullptr, 16) << 8 |
+                        (unsigned)strtoul(batch.address.c_str() + 15, nullptr, 16);
+        unsigned epoch = node == 0 && batch.time_us >= run.restart_us ? 1 : 0;
+        bool same = batch.channels == 6;
+        for (size_t k = 0; same && k < batch.frames; k++) {
+            int16_t expected[6];
+            synthetic_broadcast_frame(node, epoch, batch.first_frame + (uint32_t)k, expected);
+            same = memcmp(expected, &batch.values[k * 6], sizeof(expected)) == 0;
+        }
+        mismatched += !same;
+        verify_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - verify).count();
+    }
+    double scan_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count() - verify_ms;
+
+    FILE *report = dump ? stderr : stdout;
+    ScanNodeStats total = scanner.total();
+    double delivered = run.batches ? (double)total.batches / run.batches : 0.0;
+    fprintf(report, "%u nodes, %s advertising, %.0f s, %.0f %% of the events lost\n", options.nodes,
+            options.legacy ? "legacy" : "extended", seconds, 100.0 * options.loss);
+    fprintf(report, "%zu reports: %llu fragments, %llu duplicates, %llu rejected, %llu malformed\n",
+            run.reports.size(), (unsigned long long)total.fragments, (unsigned long long)total.duplicates,
+            (unsigned long long)total.rejected, (unsigned long long)total.malformed);
+    fprintf(report, "%llu of %llu batches (%.1f %%), %llu partial, %llu frames, %llu missed, %llu mismatched\n",
+            (unsigned long long)total.batches, (unsigned long long)run.batches, 100.0 * delivered,
+            (unsigned long long)total.incomplete, (unsigned long long)total.frames,
+            (unsigned long long)total.missed_frames, (unsigned long long)mismatched);
+    fprintf(report, "%.1f ms, %.0f reports/s\n", scan_ms, scan_ms > 0 ? run.reports.size() / scan_ms * 1000.0 : 0.0);
+
+    // with three tries at each fragment a batch is lost about
+    // fragments * loss^3 of the time
+    double expected = 1.0 - (double)options.max_fragments * options.loss * options.loss * options.loss;
+    bool failed = mismatched || total.decode_errors || delivered < 0.9 * expected;
+    if (check && failed) {
+        fprintf(stderr, "scan: out of bounds\n");
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        return usage();
+    }
+    if (strcmp(argv[1], "decode") == 0) {
+        return decode_command(argc - 2, argv + 2);
+    }
+    if (strcmp(argv[1], "synth") == 0) {
+        return synth_command(argc - 2, argv + 2);
+    }
+    return usage();
+}
@@ -0,0 +1,254 @@
+#include "BroadcastFormat.h"
+
+#include <cstring>
+
+#include "Crc32.h"
+
+namespace lab {
+
+static const uint8_t AD_MANUFACTURER_DATA = 0xFF;
+
+static uint16_t get16(const uint8_t *data)
+{
+    return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void put16(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)value;
+    data[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *data, uint32_t value)
+{
+    put16(data, (uint16_t)value);
+    put16(data + 2, (uint16_t)(value >> 16));
+}
+
+uint32_t broadcast_tag(uint16_t sequence, const uint8_t *batch, size_t length)
+{
+    uint8_t prefix[2];
+    put16(prefix, sequence);
+    uint32_t crc = crc32_update(0xFFFFFFFF, prefix, sizeof(prefix));
+    return ~crc32_update(crc, batch, length);
+}
+
+int broadcast_parse(const uint8_t *payload, size_t length, BroadcastFragment &fragment)
+{
+    size_t at = 0;
+    while (at < length) {
+        size_t size = payload[at];
+        if (!size) {
+            // zero padding ends the significant part
+            break;
+        }
+        if (at + 1 + size > length) {
+            return -1;
+        }
+        const uint8_t *field = payload + at + 1;
+        if (field[0] == AD_MANUFACTURER_DATA && size >= 3 + BROADCAST_HEADER_SIZE &&
+            get16(field + 1) == BROADCAST_COMPANY_ID) {
+            const uint8_t *header = field + 3;
+            if (header[0] != BROADCAST_VERSION) {
+                return -1;
+            }
+            fragment.sequence = get16(header + 1);
+            fragment.index = header[3];
+            fragment.count = header[4];
+            fragment.total = get16(header + 5);
+            fragment.tag = get32(header + 7);
+            fragment.data = header + BROADCAST_HEADER_SIZE;
+            fragment.length = (uint8_t)(size - 3 - BROADCAST_HEADER_SIZE);
+            if (!fragment.count || fragment.index >= fragment.count || fragment.count > BROADCAST_MAX_FRAGMENTS ||
+                !fragment.total || fragment.total > BROADCAST_MAX_BATCH || !fragment.length ||
+                fragment.length > fragment.total) {
+                return -1;
+            }
+            return 0;
+        }
+        at += 1 + size;
+    }
+    return -1;
+}
+
+int broadcast_encode_imu(ImuEncoder &encoder, uint32_t first_frame, uint32_t period_us, const int16_t *values,
+                         size_t frames, uint8_t *out, size_t capacity)
+{
+    if (capacity < BROADCAST_IMU_HEADER) {
+        return -1;
+    }
+    put32(out, first_frame);
+    put32(out + 4, period_us);
+    encoder.reset();
+    int length = encoder.encode(values, frames, out + BROADCAST_IMU_HEADER, capacity - BROADCAST_IMU_HEADER);
+    return length < 0 ? -1 : (int)BROADCAST_IMU_HEADER + length;
+}
+
+int broadcast_decode_imu(const uint8_t *batch, size_t length, uint32_t &first_frame, uint32_t &period_us,
+                         int16_t *values, size_t capacity, uint8_t &channels)
+{
+    if (length <= BROADCAST_IMU_HEADER) {
+        return -1;
+    }
+    first_frame = get32(batch);
+    period_us = get32(batch + 4);
+    ImuDecoder decoder;
+    size_t used = 0;
+    int frames = decoder.decode(batch + BROADCAST_IMU_HEADER, length - BROADCAST_IMU_HEADER, values, capacity, &used);
+    if (frames == -3) {
+        return -3;
+    }
+    // one key block and nothing after it
+    if (frames < 0 || used != length - BROADCAST_IMU_HEADER) {
+        return -1;
+    }
+    channels = decoder.channels();
+    return frames;
+}
+
+BroadcastPacker::BroadcastPacker(size_t max_payload) :
+    _fragment_data(0),
+    _sequence(0),
+    _batch(nullptr),
+    _length(0),
+    _count(0),
+    _tag(0)
+{
+    // one AD structure, its length fits a byte
+    if (max_payload > 256) {
+        max_payload = 256;
+    }
+    if (max_payload > BROADCAST_OVERHEAD) {
+        _fragment_data = max_payload - BROADCAST_OVERHEAD;
+    }
+}
+
+int BroadcastPacker::set(uint16_t sequence, const uint8_t *batch, size_t length)
+{
+    if (!_fragment_data || !length || length > BROADCAST_MAX_BATCH) {
+        return -1;
+    }
+    size_t count = (length + _fragment_data - 1) / _fragment_data;
+    if (count > BROADCAST_MAX_FRAGMENTS) {
+        return -1;
+    }
+    _sequence = sequence;
+    _batch = batch;
+    _length = length;
+    _count = count;
+    _tag = broadcast_tag(sequence, batch, length);
+    return (int)count;
+}
+
+int BroadcastPacker::pack(size_t index, uint8_t *out, size_t capacity) const
+{
+    if (index >= _count) {
+        return -1;
+    }
+    size_t offset = index * _fragment_data;
+    size_t data = _length - offset < _fragment_data ? _length - offset : _fragment_data;
+    size_t size = BROADCAST_OVERHEAD + data;
+    if (size > capacity) {
+        return -1;
+    }
+    out[0] = (uint8_t)(size - 1);
+    out[1] = AD_MANUFACTURER_DATA;
+    put16(out + 2, BROADCAST_COMPANY_ID);
+    uint8_t *header = out + 4;
+    header[0] = BROADCAST_VERSION;
+    put16(header + 1, _sequence);
+    header[3] = (uint8_t)index;
+    header[4] = (uint8_t)_count;
+    put16(header + 5, (uint16_t)_length);
+    put32(header + 7, _tag);
+    memcpy(header + BROADCAST_HEADER_SIZE, _batch + offset, data);
+    return (int)size;
+}
+
+BroadcastAssembler::BroadcastAssembler() :
+    _incomplete(0)
+{
+    reset();
+}
+
+void BroadcastAssembler::reset()
+{
+    _sequence = 0;
+    _total = 0;
+    _tag = 0;
+    _count = 0;
+    _fragment_data = 0;
+    _last_length = 0;
+    _received = 0;
+    _active = false;
+    _complete = false;
+}
+
+void BroadcastAssembler::start(const BroadcastFragment &fragment)
+{
+    if (_active) {
+        _incomplete++;
+    }
+    _sequence = fragment.sequence;
+    _total = fragment.total;
+    _tag = fragment.tag;
+    _count = fragment.count;
+    _fragment_data = 0;
+    _last_length = 0;
+    _received = 0;
+    _active = true;
+    _complete = false;
+}
+
+BroadcastAssembler::Result BroadcastAssembler::add(const BroadcastFragment &fragment)
+{
+    if (_complete && fragment.sequence == _sequence && fragment.tag == _tag) {
+        return DUPLICATE;
+    }
+    if (!_active || fragment.sequence != _sequence) {
+        start(fragment);
+    } else if (fragment.total != _total || fragment.count != _count || fragment.tag != _tag) {
+        // two batches under one sequence, start over with the newer
+        start(fragment);
+    }
+    uint32_t bit = 1u << fragment.index;
+    if (_received & bit) {
+        return DUPLICATE;
+    }
+
+    bool last = fragment.index == _count - 1;
+    size_t offset;
+    if (last) {
+        offset = _total - fragment.length;
+        _last_length = fragment.length;
+    } else {
+        if (_fragment_data && fragment.length != _fragment_data) {
+            return REJECTED;
+        }
+        _fragment_data = fragment.length;
+        offset = (size_t)fragment.index * fragment.length;
+        if (offset + fragment.length > _total) {
+            return REJECTED;
+        }
+    }
+    memcpy(_batch + offset, fragment.data, fragment.length);
+    _received |= bit;
+
+    if (_received != (_count == 32 ? 0xFFFFFFFFu : (1u << _count) - 1)) {
+        return PENDING;
+    }
+    _active = false;
+    size_t expected = (size_t)(_count - 1) * _fragment_data + _last_length;
+    if (expected != _total || broadcast_tag(_sequence, _batch, _total) != _tag) {
+        return REJECTED;
+    }
+    _complete = true;
+    return COMPLETE;
+}
+
+} // namespace lab
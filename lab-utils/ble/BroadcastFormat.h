@@ -0,0 +1,194 @@
+#ifndef LAB_BROADCAST_FORMAT_H
+#define LAB_BROADCAST_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ImuCodec.h"
+
+namespace lab {
+
+/**
+ * Sensor batches in advertising payloads, for gateways that listen
+ * without connecting.
+ *
+ * A batch is cut into fragments, one per advertising payload, each a
+ * single manufacturer specific AD structure:
+ *
+ *   length, 0xFF, company 0xFFFF (the test ID, little endian)
+ *   version         1
+ *   sequence        16 bit, the batch
+ *   index, count    of the fragment in the batch, 8 bit each
+ *   total           16 bit, bytes in the batch
+ *   tag             32 bit CRC-32 of the sequence and the batch
+ *   data            up to the end of the structure
+ *
+ * Multi-byte fields are little endian. Every fragment but the last has
+ * the same size, so a fragment goes at index * its size, the last one at
+ * total minus its size, in whatever order they come. The tag tells a
+ * batch put together from fragments of two batches with the same
+ * sequence (after a reset), not a forged one: anybody can compute it.
+ */
+static const uint16_t BROADCAST_COMPANY_ID = 0xFFFF;
+static const uint8_t BROADCAST_VERSION = 1;
+static const size_t BROADCAST_HEADER_SIZE = 11;
+/** AD length, AD type, company ID and header. */
+static const size_t BROADCAST_OVERHEAD = 4 + BROADCAST_HEADER_SIZE;
+
+/** A legacy advertising payload. */
+static const size_t BROADCAST_LEGACY_PAYLOAD = 31;
+/** The advertising data of one AUX_ADV_IND with no chain behind it. */
+static const size_t BROADCAST_EXTENDED_PAYLOAD = 245;
+
+static const size_t BROADCAST_MAX_FRAGMENTS = 32;
+static const size_t BROADCAST_MAX_BATCH = 512;
+
+/** A fragment as parsed, data points into the payload. */
+struct BroadcastFragment {
+    uint16_t sequence;
+    uint8_t index;
+    uint8_t count;
+    uint16_t total;
+    uint32_t tag;
+    const uint8_t *data;
+    uint8_t length;
+};
+
+/** Tag of a batch, see above. */
+uint32_t broadcast_tag(uint16_t sequence, const uint8_t *batch, size_t length);
+
+/**
+ * Find the fragment in an advertising payload.
+ *
+ * @return 0, -1 if the payload has none or a malformed one.
+ */
+int broadcast_parse(const uint8_t *payload, size_t length, BroadcastFragment &fragment);
+
+/** Batch header of the IMU frames: first frame number and frame period, 32 bit each. */
+static const size_t BROADCAST_IMU_HEADER = 8;
+
+/**
+ * A batch of IMU frames: the header, then one key block of the encoder,
+ * which it resets first so a gateway decodes any batch it gets.
+ *
+ * @return bytes written, -1 if capacity is too small.
+ */
+int broadcast_encode_imu(ImuEncoder &encoder, uint32_t first_frame, uint32_t period_us, const int16_t *values,
+                         size_t frames, uint8_t *out, size_t capacity);
+
+/**
+ * Frames of a batch of broadcast_encode_imu().
+ *
+ * @return frames, -1 for a malformed batch, -3 if values is too small.
+ */
+int broadcast_decode_imu(const uint8_t *batch, size_t length, uint32_t &first_frame, uint32_t &period_us,
+                         int16_t *values, size_t capacity, uint8_t &channels);
+
+/** Cuts batches into advertising payloads. */
+class BroadcastPacker {
+public:
+    /** @param[in] max_payload largest advertising payload, 31 for legacy advertising. */
+    explicit BroadcastPacker(size_t max_payload);
+
+    /**
+     * Take a new batch. It is not copied and has to stay as it is while
+     * its fragments are packed.
+     *
+     * @return fragments of the batch, -1 if it does not fit
+     * BROADCAST_MAX_FRAGMENTS fragments or BROADCAST_MAX_BATCH bytes.
+     */
+    int set(uint16_t sequence, const uint8_t *batch, size_t length);
+
+    /**
+     * Advertising payload of a fragment of the batch.
+     *
+     * @return bytes written, -1 for a bad index or too small a buffer.
+     */
+    int pack(size_t index, uint8_t *out, size_t capacity) const;
+
+    /** Batch bytes a fragment carries at most. */
+    size_t fragment_data() const
+    {
+        return _fragment_data;
+    }
+
+    size_t fragments() const
+    {
+        return _count;
+    }
+
+private:
+    size_t _fragment_data;
+    uint16_t _sequence;
+    const uint8_t *_batch;
+    size_t _length;
+    size_t _count;
+    uint32_t _tag;
+};
+
+/**
+ * Puts the batches of one broadcaster back together.
+ *
+ * One batch is assembled at a time: a fragment of another sequence
+ * drops what is there, and fragments of the batch completed last are
+ * duplicates. A gateway keeps one per broadcaster.
+ */
+class BroadcastAssembler {
+public:
+    enum Result {
+        /** The fragment completed a batch, see batch(). */
+        COMPLETE,
+        PENDING,
+        DUPLICATE,
+        /** Inconsistent with the other fragments of its batch, or the tag does not match. */
+        REJECTED,
+    };
+
+    BroadcastAssembler();
+
+    Result add(const BroadcastFragment &fragment);
+
+    /** The batch completed last. */
+    const uint8_t *batch() const
+    {
+        return _batch;
+    }
+
+    size_t batch_length() const
+    {
+        return _total;
+    }
+
+    uint16_t sequence() const
+    {
+        return _sequence;
+    }
+
+    /** Batches started and dropped before they were complete. */
+    uint32_t incomplete() const
+    {
+        return _incomplete;
+    }
+
+    void reset();
+
+private:
+    void start(const BroadcastFragment &fragment);
+
+    uint8_t _batch[BROADCAST_MAX_BATCH];
+    uint16_t _sequence;
+    uint16_t _total;
+    uint32_t _tag;
+    uint8_t _count;
+    /** Size of every fragment but the last, 0 until one of them is in. */
+    uint8_t _fragment_data;
+    uint8_t _last_length;
+    uint32_t _received;
+    bool _active;
+    bool _complete;
+    uint32_t _incomplete;
+};
+
+} // namespace lab
+
+#endif // LAB_BROADCAST_FORMAT_H
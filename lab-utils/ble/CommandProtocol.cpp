@@ -0,0 +1,181 @@
+#include "CommandProtocol.h"
+
+#include <cstring>
+
+namespace lab {
+
+CommandReader::CommandReader(const uint8_t *packet, size_t length) :
+    _packet(packet),
+    _length(length),
+    // the sequence number
+    _offset(length ? 1 : 0)
+{
+}
+
+int CommandReader::next(Command &command)
+{
+    if (!_length) {
+        return -1;
+    }
+    if (_offset == _length) {
+        return 0;
+    }
+    const uint8_t *at = _packet + _offset;
+    size_t left = _length - _offset;
+    size_t size;
+    memset(&command, 0, sizeof(command));
+    command.opcode = at[0];
+    switch (at[0]) {
+        case COMMAND_LED:
+            size = 3;
+            if (left < size) {
+                return -1;
+            }
+            command.target = at[1];
+            command.value = at[2] ? 1 : 0;
+            break;
+        case COMMAND_BLINK:
+            size = 5;
+            if (left < size) {
+                return -1;
+            }
+            command.target = at[1];
+            command.on_ms = (uint16_t)(at[2] * 10);
+            command.off_ms = (uint16_t)(at[3] * 10);
+            command.count = at[4];
+            break;
+        case COMMAND_PWM:
+            size = 4;
+            if (left < size) {
+                return -1;
+            }
+            command.target = at[1];
+            command.value = (uint16_t)(at[2] | (at[3] << 8));
+            break;
+        case COMMAND_REGISTERS:
+            if (left < 3 || !at[2] || left < 3 + (size_t)at[2]) {
+                return -1;
+            }
+            size = 3 + (size_t)at[2];
+            command.target = at[1];
+            command.count = at[2];
+            command.data = at + 3;
+            break;
+        case COMMAND_CAPTURE:
+            size = 1;
+            break;
+        default:
+            return -1;
+    }
+    _offset += size;
+    return 1;
+}
+
+void apply_commands(const uint8_t *packet, size_t length, CommandTarget &target, CommandStatus &status)
+{
+    status.sequence = length ? packet[0] : 0;
+    status.applied = 0;
+    status.failed = 0xFF;
+    status.error = COMMAND_OK;
+    status.packets++;
+
+    // the whole packet first, nothing applied from a malformed one
+    CommandReader check(packet, length);
+    Command command;
+    int result;
+    size_t commands = 0;
+    while ((result = check.next(command)) > 0) {
+        commands++;
+    }
+    if (result < 0) {
+        status.result = COMMAND_RESULT_MALFORMED;
+        status.failed = (uint8_t)(commands < 0xFF ? commands : 0xFF);
+        status.error = (uint8_t)(check.offset() < 0xFF ? check.offset() : 0xFF);
+        return;
+    }
+
+    status.result = COMMAND_RESULT_OK;
+    CommandReader reader(packet, length);
+    for (size_t index = 0; reader.next(command) > 0; index++) {
+        uint8_t error = target.apply(command);
+        if (error == COMMAND_OK) {
+            if (status.applied < 0xFF) {
+                status.applied++;
+            }
+        } else if (status.result == COMMAND_RESULT_OK) {
+            status.result = COMMAND_RESULT_PARTIAL;
+            status.failed = (uint8_t)(index < 0xFF ? index : 0xFF);
+            status.error = error;
+        }
+    }
+}
+
+size_t encode_command_status(const CommandStatus &status, uint8_t out[COMMAND_STATUS_SIZE])
+{
+    out[0] = status.sequence;
+    out[1] = status.result;
+    out[2] = status.applied;
+    out[3] = status.failed;
+    out[4] = status.error;
+    out[5] = (uint8_t)status.packets;
+    out[6] = (uint8_t)(status.packets >> 8);
+    return COMMAND_STATUS_SIZE;
+}
+
+int encode_command(const Command &command, uint8_t *out, size_t capacity)
+{
+    size_t size;
+    switch (command.opcode) {
+        case COMMAND_LED:
+            size = 3;
+            break;
+        case COMMAND_BLINK:
+            if (command.on_ms > 2550 || command.off_ms > 2550) {
+                return -1;
+            }
+            size = 5;
+            break;
+        case COMMAND_PWM:
+            size = 4;
+            break;
+        case COMMAND_REGISTERS:
+            if (!command.count || !command.data) {
+                return -1;
+            }
+            size = 3 + (size_t)command.count;
+            break;
+        case COMMAND_CAPTURE:
+            size = 1;
+            break;
+        default:
+            return -1;
+    }
+    if (size > capacity) {
+        return -1;
+    }
+    out[0] = command.opcode;
+    if (size > 1) {
+        out[1] = command.target;
+    }
+    switch (command.opcode) {
+        case COMMAND_LED:
+            out[2] = command.value ? 1 : 0;
+            break;
+        case COMMAND_BLINK:
+            out[2] = (uint8_t)(command.on_ms / 10);
+            out[3] = (uint8_t)(command.off_ms / 10);
+            out[4] = command.count;
+            break;
+        case COMMAND_PWM:
+            out[2] = (uint8_t)command.value;
+            out[3] = (uint8_t)(command.value >> 8);
+            break;
+        case COMMAND_REGISTERS:
+            out[2] = command.count;
+            memcpy(out + 3, command.data, command.count);
+            break;
+    }
+    return (int)size;
+}
+
+} // namespace lab
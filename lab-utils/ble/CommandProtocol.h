@@ -0,0 +1,141 @@
+#ifndef LAB_COMMAND_PROTOCOL_H
+#define LAB_COMMAND_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Batches of actuator commands in one write, for a characteristic
+ * written without response.
+ *
+ * A packet is a sequence number, then commands back to back, each an
+ * opcode and its fixed fields (multi-byte fields little endian):
+ *
+ *   0x01 LED        led, state (0 off, anything else on)
+ *   0x02 BLINK      led, on and off time in 10 ms, count (0 for ever)
+ *   0x03 PWM        channel, 16 bit level in per mille
+ *   0x04 REGISTERS  first register, count, count values
+ *   0x05 CAPTURE    none: freeze a burst of the accelerometer around now
+ *
+ * A packet is checked whole before any of it is applied: a malformed one
+ * (unknown opcode, truncated command) changes nothing. The commands of a
+ * good one are applied in order; one the target turns down does not stop
+ * the ones after it. Either way one CommandStatus answers the packet.
+ */
+enum CommandOpcode {
+    COMMAND_LED = 0x01,
+    COMMAND_BLINK = 0x02,
+    COMMAND_PWM = 0x03,
+    COMMAND_REGISTERS = 0x04,
+    COMMAND_CAPTURE = 0x05,
+};
+
+/** What a target answers for a command, 0 for done. */
+enum CommandError {
+    COMMAND_OK = 0,
+    /** No such LED, channel or register. */
+    COMMAND_ERROR_TARGET = 1,
+    /** Out of range for the target. */
+    COMMAND_ERROR_VALUE = 2,
+    /** The target cannot take it now. */
+    COMMAND_ERROR_BUSY = 3,
+};
+
+/** One command as parsed; data points into the packet. */
+struct Command {
+    uint8_t opcode;
+    /** The LED, the PWM channel or the first register. */
+    uint8_t target;
+    /** LED: 0 or 1; PWM: the level. */
+    uint16_t value;
+    /** BLINK: the pattern, in ms. */
+    uint16_t on_ms;
+    uint16_t off_ms;
+    uint8_t count;
+    /** REGISTERS: count values. */
+    const uint8_t *data;
+};
+
+/** Walks the commands of a packet. */
+class CommandReader {
+public:
+    CommandReader(const uint8_t *packet, size_t length);
+
+    /**
+     * The next command.
+     *
+     * @return 1, 0 at the end of the packet, -1 if what follows is not a
+     * command; offset() is then where it starts.
+     */
+    int next(Command &command);
+
+    /** Bytes of the packet read so far, the sequence number included. */
+    size_t offset() const
+    {
+        return _offset;
+    }
+
+private:
+    const uint8_t *_packet;
+    size_t _length;
+    size_t _offset;
+};
+
+/** Applies commands, e.g. the LEDs and PWM outputs of a board. */
+class CommandTarget {
+public:
+    /** @return COMMAND_OK or a CommandError. */
+    virtual uint8_t apply(const Command &command) = 0;
+
+protected:
+    ~CommandTarget() {}
+};
+
+enum CommandResult {
+    /** Every command applied. */
+    COMMAND_RESULT_OK = 0,
+    /** Some commands turned down, see failed and error. */
+    COMMAND_RESULT_PARTIAL = 1,
+    /** Nothing applied: failed is the command that is not one, error its offset. */
+    COMMAND_RESULT_MALFORMED = 2,
+};
+
+/**
+ * The answer to a packet, notified as 7 bytes: sequence, result,
+ * applied, failed, error, then packets (16 bit). packets counts every
+ * packet taken, so a client that gets only the newest status still
+ * knows how many went through.
+ */
+struct CommandStatus {
+    uint8_t sequence;
+    uint8_t result;
+    /** Commands applied, 255 at most. */
+    uint8_t applied;
+    /** Index of the first command that failed, 255 for none. */
+    uint8_t failed;
+    /** Its CommandError, or the offset for a malformed packet. */
+    uint8_t error;
+    uint16_t packets;
+};
+
+static const size_t COMMAND_STATUS_SIZE = 7;
+
+/** Apply a packet to a target, and fill in status; status.packets goes up by one. */
+void apply_commands(const uint8_t *packet, size_t length, CommandTarget &target, CommandStatus &status);
+
+/** @return COMMAND_STATUS_SIZE. */
+size_t encode_command_status(const CommandStatus &status, uint8_t out[COMMAND_STATUS_SIZE]);
+
+/**
+ * Append a command to a packet being built, for clients and tests.
+ *
+ * @return bytes written, -1 if capacity is too small or the command is
+ * not one.
+ */
+int encode_command(const Command &command, uint8_t *out, size_t capacity);
+
+} // namespace lab
+
+#endif // LAB_COMMAND_PROTOCOL_H
@@ -0,0 +1,374 @@
+#if defined(FEATURE_BLE)
+
+#include "ConnectionManager.h"
+
+#include <chrono>
+#include <cstring>
+
+#include "DeferredLog.h"
+#include "hal/us_ticker_api.h"
+
+namespace lab {
+
+ConnectionPolicy default_connection_policy()
+{
+    ConnectionPolicy policy;
+    policy.streaming.min_interval_us = 7500;
+    policy.streaming.max_interval_us = 15000;
+    policy.streaming.latency = 0;
+    policy.streaming.timeout_ms = 2000;
+    policy.idle.min_interval_us = 400000;
+    policy.idle.max_interval_us = 500000;
+    policy.idle.latency = 2;
+    policy.idle.timeout_ms = 6000;
+    policy.idle_after_ms = 5000;
+    policy.prefer_2m_phy = true;
+    return policy;
+}
+
+ConnectionManager::ConnectionManager(BLE &ble, events::EventQueue &queue, ble::Gap::EventHandler *next) :
+    _ble(ble),
+    _queue(queue),
+    _next(next),
+    _services(),
+    _service_count(0),
+    _links(),
+    _streaming(false),
+    _idle_check(false)
+{
+}
+
+int ConnectionManager::add_service(const char *name, const ConnectionPolicy &policy)
+{
+    if (_service_count == MAX_SERVICES) {
+        return -1;
+    }
+    Service &service = _services[_service_count];
+    service.name = name;
+    service.policy = policy;
+    service.streaming = false;
+    service.last_activity_us = 0;
+    return (int)_service_count++;
+}
+
+void ConnectionManager::start()
+{
+    _ble.gap().setEventHandler(this);
+    _ble.gattClient().setEventHandler(this);
+}
+
+const BleLinkState *ConnectionManager::link(ble::connection_handle_t handle) const
+{
+    for (const Link &link : _links) {
+        if (link.state.connected && link.state.handle == handle) {
+            return &link.state;
+        }
+    }
+    return nullptr;
+}
+
+ConnectionManager::Link *ConnectionManager::find(ble::connection_handle_t handle)
+{
+    for (Link &link : _links) {
+        if (link.state.connected && link.state.handle == handle) {
+            return &link;
+        }
+    }
+    return nullptr;
+}
+
+void ConnectionManager::activity(int service)
+{
+    if (service < 0 || (size_t)service >= _service_count) {
+        return;
+    }
+    Service &entry = _services[service];
+    entry.last_activity_us = us_ticker_read();
+    if (!entry.streaming) {
+        entry.streaming = true;
+        LAB_LOG_DEBUG("ble %s streaming", entry.name);
+        set_mode(true);
+    }
+    if (!_idle_check) {
+        _idle_check = true;
+        _queue.call_in(std::chrono::milliseconds(entry.policy.idle_after_ms), this, &ConnectionManager::check_idle);
+    }
+}
+
+void ConnectionManager::check_idle()
+{
+    _idle_check = false;
+    uint32_t now = us_ticker_read();
+    uint32_t next_ms = UINT32_MAX;
+    bool streaming = false;
+    for (size_t i = 0; i < _service_count; i++) {
+        Service &service = _services[i];
+        if (!service.streaming) {
+            continue;
+        }
+        uint32_t quiet_ms = (now - service.last_activity_us) / 1000;
+        if (quiet_ms >= service.policy.idle_after_ms) {
+            service.streaming = false;
+            LAB_LOG_DEBUG("ble %s idle", service.name);
+            continue;
+        }
+        streaming = true;
+        uint32_t left_ms = service.policy.idle_after_ms - quiet_ms;
+        next_ms = left_ms < next_ms ? left_ms : next_ms;
+    }
+    if (streaming) {
+        _idle_check = true;
+        _queue.call_in(std::chrono::milliseconds(next_ms), this, &ConnectionManager::check_idle);
+    }
+    set_mode(streaming);
+}
+
+/** The parameters of the most demanding service for the mode: the shortest interval. */
+const ConnectionParameters *ConnectionManager::wanted() const
+{
+    const ConnectionParameters *best = nullptr;
+    for (size_t i = 0; i < _service_count; i++) {
+        const Service &service = _services[i];
+        if (_streaming && !service.streaming) {
+            continue;
+        }
+        const ConnectionParameters *candidate = _streaming ? &service.policy.streaming : &service.policy.idle;
+        if (!best || candidate->max_interval_us < best->max_interval_us) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+void ConnectionManager::set_mode(bool streaming)
+{
+    if (streaming == _streaming) {
+        return;
+    }
+    _streaming = streaming;
+    for (Link &link : _links) {
+        if (link.state.connected) {
+            link.rejected_streaming = false;
+            link.rejected_idle = false;
+            apply(link);
+        }
+    }
+}
+
+void ConnectionManager::apply(Link &link)
+{
+    const ConnectionParameters *parameters = wanted();
+    if (!parameters) {
+        return;
+    }
+    if (link.pending) {
+        // asked again once the central has answered
+        link.stale = true;
+        return;
+    }
+    const BleLinkState &state = link.state;
+    if (state.interval_us >= parameters->min_interval_us && state.interval_us <= parameters->max_interval_us &&
+        state.latency == parameters->latency && state.timeout_ms == parameters->timeout_ms) {
+        return;
+    }
+    if (_streaming ? link.rejected_streaming : link.rejected_idle) {
+        return;
+    }
+
+    ble_error_t error = _ble.gap().updateConnectionParameters(
+        state.handle, ble::conn_interval_t((uint16_t)(parameters->min_interval_us / 1250)),
+        ble::conn_interval_t((uint16_t)(parameters->max_interval_us / 1250)), parameters->latency,
+        ble::supervision_timeout_t((uint16_t)(parameters->timeout_ms / 10)));
+    if (error) {
+        LAB_LOG_WARN("ble link %u: parameter update failed, error %u", (unsigned)state.handle, error);
+        return;
+    }
+    link.pending = true;
+    link.stale = false;
+    link.state.streaming = _streaming;
+}
+
+void ConnectionManager::report(Link &link)
+{
+    BleLinkState &state = link.state;
+    state.throughput_bps = ble_notify_throughput_bps(state.interval_us, state.interval_us, state.tx_phy,
+                                                     state.tx_octets, state.att_mtu);
+    LAB_LOG_INFO("ble link %u: interval %u us, latency %u, timeout %u ms", (unsigned)state.handle,
+                 state.interval_us, state.latency, state.timeout_ms);
+    LAB_LOG_INFO("ble link %u: PHY %s, data length %u, ATT MTU %u, up to %u bit/s", (unsigned)state.handle,
+                 ble_phy_name(state.tx_phy), state.tx_octets, state.att_mtu, state.throughput_bps);
+    if (_on_change) {
+        _on_change(state);
+    }
+}
+
+void ConnectionManager::onAdvertisingStart(const ble::AdvertisingStartEvent &event)
+{
+    if (_next) {
+        _next->onAdvertisingStart(event);
+    }
+}
+
+void ConnectionManager::onAdvertisingEnd(const ble::AdvertisingEndEvent &event)
+{
+    if (_next) {
+        _next->onAdvertisingEnd(event);
+    }
+}
+
+void ConnectionManager::onConnectionComplete(const ble::ConnectionCompleteEvent &event)
+{
+    if (event.getStatus() == BLE_ERROR_NONE && event.getOwnRole().value() == ble::connection_role_t::PERIPHERAL) {
+        Link *link = nullptr;
+        for (Link &candidate : _links) {
+            if (!candidate.state.connected) {
+                link = &candidate;
+                break;
+            }
+        }
+        if (!link) {
+            LAB_LOG_WARN("ble link %u: no room to track it", (unsigned)event.getConnectionHandle());
+        } else {
+            memset(link, 0, sizeof(*link));
+            BleLinkState &state = link->state;
+            state.handle = event.getConnectionHandle();
+            state.connected = true;
+            state.interval_us = event.getConnectionInterval().valueInUs();
+            state.latency = event.getConnectionLatency();
+            state.timeout_ms = (uint16_t)event.getSupervisionTimeout().valueInMs();
+            state.tx_phy = state.rx_phy = BLE_PHY_1M;
+            state.tx_octets = state.rx_octets = BLE_DEFAULT_DATA_LENGTH;
+            state.att_mtu = BLE_DEFAULT_ATT_MTU;
+            report(*link);
+
+            bool want_2m = false;
+            for (size_t i = 0; i < _service_count; i++) {
+                want_2m = want_2m || _services[i].policy.prefer_2m_phy;
+            }
+            ble::Gap &gap = _ble.gap();
+            if (want_2m && gap.isFeatureSupported(ble::controller_supported_features_t::LE_2M_PHY)) {
+                ble::phy_set_t phys(false, true, false);
+                ble_error_t error = gap.setPhy(state.handle, &phys, &phys, ble::coded_symbol_per_bit_t::UNDEFINED);
+                if (error) {
+                    LAB_LOG_WARN("ble link %u: 2M PHY request failed, error %u", (unsigned)state.handle, error);
+                }
+            }
+            ble_error_t error = _ble.gattClient().negotiateAttMtu(state.handle);
+            if (error) {
+                LAB_LOG_WARN("ble link %u: MTU exchange failed, error %u", (unsigned)state.handle, error);
+            }
+            apply(*link);
+        }
+    }
+    if (_next) {
+        _next->onConnectionComplete(event);
+    }
+}
+
+void ConnectionManager::onUpdateConnectionParametersRequest(const ble::UpdateConnectionParametersRequestEvent &event)
+{
+    if (_next) {
+        _next->onUpdateConnectionParametersRequest(event);
+    }
+}
+
+void ConnectionManager::onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event)
+{
+    Link *link = find(event.getConnectionHandle());
+    if (link) {
+        link->pending = false;
+        if (event.getStatus() == BLE_ERROR_NONE) {
+            link->state.updates++;
+            link->state.interval_us = event.getConnectionInterval().valueInUs();
+            link->state.latency = event.getSlaveLatency();
+            link->state.timeout_ms = (uint16_t)event.getSupervisionTimeout().valueInMs();
+            report(*link);
+        } else {
+            // not asked again in this mode, the central would only say no again
+            link->state.rejections++;
+            if (link->state.streaming) {
+                link->rejected_streaming = true;
+            } else {
+                link->rejected_idle = true;
+            }
+            LAB_LOG_WARN("ble link %u: central rejected the %s parameters, error %u",
+                         (unsigned)link->state.handle, link->state.streaming ? "streaming" : "idle",
+                         event.getStatus());
+        }
+        if (link->stale) {
+            apply(*link);
+        }
+    }
+    if (_next) {
+        _next->onConnectionParametersUpdateComplete(event);
+    }
+}
+
+void ConnectionManager::onReadPhy(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                                  ble::phy_t rx_phy)
+{
+    Link *link = find(connection);
+    if (link && status == BLE_ERROR_NONE) {
+        link->state.tx_phy = (uint8_t)tx_phy.value();
+        link->state.rx_phy = (uint8_t)rx_phy.value();
+    }
+    if (_next) {
+        _next->onReadPhy(status, connection, tx_phy, rx_phy);
+    }
+}
+
+void ConnectionManager::onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connection,
+                                            ble::phy_t tx_phy, ble::phy_t rx_phy)
+{
+    Link *link = find(connection);
+    if (link && status == BLE_ERROR_NONE) {
+        link->state.tx_phy = (uint8_t)tx_phy.value();
+        link->state.rx_phy = (uint8_t)rx_phy.value();
+        report(*link);
+    }
+    if (_next) {
+        _next->onPhyUpdateComplete(status, connection, tx_phy, rx_phy);
+    }
+}
+
+void ConnectionManager::onDataLengthChange(ble::connection_handle_t connection, uint16_t tx_size, uint16_t rx_size)
+{
+    Link *link = find(connection);
+    if (link) {
+        link->state.tx_octets = tx_size;
+        link->state.rx_octets = rx_size;
+        report(*link);
+    }
+    if (_next) {
+        _next->onDataLengthChange(connection, tx_size, rx_size);
+    }
+}
+
+void ConnectionManager::onAttMtuChange(ble::connection_handle_t connection, uint16_t att_mtu)
+{
+    Link *link = find(connection);
+    if (link) {
+        link->state.att_mtu = att_mtu;
+        report(*link);
+    }
+}
+
+void ConnectionManager::onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
+{
+    Link *link = find(event.getConnectionHandle());
+    if (link) {
+        link->state.connected = false;
+        LAB_LOG_INFO("ble link %u: disconnected, %u updates, %u rejected", (unsigned)link->state.handle,
+                     link->state.updates, link->state.rejections);
+        if (_on_change) {
+            _on_change(link->state);
+        }
+    }
+    if (_next) {
+        _next->onDisconnectionComplete(event);
+    }
+}
+
+} // namespace lab
+
+#endif // FEATURE_BLE
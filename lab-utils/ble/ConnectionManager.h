@@ -0,0 +1,171 @@
+#ifndef LAB_CONNECTION_MANAGER_H
+#define LAB_CONNECTION_MANAGER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LinkBudget.h"
+#include "ble/BLE.h"
+#include "events/EventQueue.h"
+#include "platform/Callback.h"
+
+namespace lab {
+
+/** Connection parameters to ask the central for. */
+struct ConnectionParameters {
+    /** Interval range, multiples of 1250 us from 7500 us to 4 s. */
+    uint32_t min_interval_us;
+    uint32_t max_interval_us;
+    /** Connection events the peripheral may skip when it has nothing to send. */
+    uint16_t latency;
+    /** Supervision timeout, above (1 + latency) * max_interval * 2. */
+    uint16_t timeout_ms;
+};
+
+/**
+ * What a service wants from the links: parameters while it streams and
+ * once it has been quiet for idle_after_ms, and whether the 2M PHY is
+ * worth asking for.
+ */
+struct ConnectionPolicy {
+    ConnectionParameters streaming;
+    ConnectionParameters idle;
+    uint32_t idle_after_ms;
+    bool prefer_2m_phy;
+};
+
+/**
+ * 7.5-15 ms without latency while streaming, 400-500 ms skipping two
+ * events out of three after 5 s of quiet, and 2M.
+ */
+ConnectionPolicy default_connection_policy();
+
+/** One connection as negotiated so far. */
+struct BleLinkState {
+    ble::connection_handle_t handle;
+    bool connected;
+    /** The parameters asked for last were the streaming ones. */
+    bool streaming;
+    uint32_t interval_us;
+    uint16_t latency;
+    uint16_t timeout_ms;
+    uint8_t tx_phy;
+    uint8_t rx_phy;
+    /** Link layer payload, each way. */
+    uint16_t tx_octets;
+    uint16_t rx_octets;
+    uint16_t att_mtu;
+    /** Parameter updates the central took and turned down. */
+    uint16_t updates;
+    uint16_t rejections;
+    /** Notification throughput the link allows at best, ble_notify_throughput_bps(). */
+    uint32_t throughput_bps;
+};
+
+/**
+ * Tunes the connections of a peripheral for the services on top.
+ *
+ * Each service registers a ConnectionPolicy and calls activity() when it
+ * sends; the links get the streaming parameters of the most demanding
+ * service active, and the idle ones of the most demanding service once
+ * every service has been quiet for its idle_after_ms. On connection the
+ * manager also asks for the 2M PHY and the ATT MTU exchange. The data
+ * length is not asked for: Cordio extends it on its own up to
+ * cordio.rx-acl-buffer-size, the manager only reports it.
+ *
+ * It takes over the Gap event handler and passes every event on to the
+ * handler it replaces (BLEProcess restarts advertising from there), and
+ * the GattClient one for the MTU. Everything runs from processEvents(),
+ * on the event queue thread.
+ */
+class ConnectionManager : public ble::Gap::EventHandler, public ble::GattClient::EventHandler {
+public:
+    static const size_t MAX_SERVICES = 4;
+    static const size_t MAX_LINKS = 4;
+
+    /**
+     * @param[in] next Gap handler the events go on to, typically the
+     * BLEProcess.
+     */
+    ConnectionManager(BLE &ble, events::EventQueue &queue, ble::Gap::EventHandler *next = nullptr);
+
+    /**
+     * Register a service before start().
+     *
+     * @param[in] name static string, for the log.
+     * @return id for activity(), -1 if the table is full.
+     */
+    int add_service(const char *name, const ConnectionPolicy &policy);
+
+    /** The service sent something: streaming parameters until it goes quiet. */
+    void activity(int service);
+
+    /** Install the event handlers, once the stack is initialized. */
+    void start();
+
+    /** Called on every negotiated change of a link, from the event queue thread. */
+    void on_change(mbed::Callback<void(const BleLinkState &)> callback)
+    {
+        _on_change = callback;
+    }
+
+    /** @return the state of a connection, nullptr if it is not one. */
+    const BleLinkState *link(ble::connection_handle_t handle) const;
+
+    bool streaming() const
+    {
+        return _streaming;
+    }
+
+private:
+    struct Service {
+        const char *name;
+        ConnectionPolicy policy;
+        bool streaming;
+        uint32_t last_activity_us;
+    };
+
+    struct Link {
+        BleLinkState state;
+        /** An update is in flight, and whether the mode changed since. */
+        bool pending;
+        bool stale;
+        /** Mode the central turned down, not asked again until the mode changes. */
+        bool rejected_streaming;
+        bool rejected_idle;
+    };
+
+    void onAdvertisingStart(const ble::AdvertisingStartEvent &event) override;
+    void onAdvertisingEnd(const ble::AdvertisingEndEvent &event) override;
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override;
+    void onUpdateConnectionParametersRequest(const ble::UpdateConnectionParametersRequestEvent &event) override;
+    void onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) override;
+    void onReadPhy(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                   ble::phy_t rx_phy) override;
+    void onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                             ble::phy_t rx_phy) override;
+    void onDataLengthChange(ble::connection_handle_t connection, uint16_t tx_size, uint16_t rx_size) override;
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override;
+    void onAttMtuChange(ble::connection_handle_t connection, uint16_t att_mtu) override;
+
+    Link *find(ble::connection_handle_t handle);
+    const ConnectionParameters *wanted() const;
+    void set_mode(bool streaming);
+    void check_idle();
+    void apply(Link &link);
+    void report(Link &link);
+
+    BLE &_ble;
+    events::EventQueue &_queue;
+    ble::Gap::EventHandler *_next;
+    mbed::Callback<void(const BleLinkState &)> _on_change;
+    Service _services[MAX_SERVICES];
+    size_t _service_count;
+    Link _links[MAX_LINKS];
+    bool _streaming;
+    bool _idle_check;
+};
+
+} // namespace lab
+
+#endif // LAB_CONNECTION_MANAGER_H
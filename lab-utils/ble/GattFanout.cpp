@@ -0,0 +1,382 @@
+#if defined(FEATURE_BLE)
+
+#include "GattFanout.h"
+
+#include <cstring>
+
+#include "DeferredLog.h"
+
+namespace lab {
+
+GattFanout::GattFanout(BLE &ble, ble::Gap::EventHandler *gap_next, ble::GattServer::EventHandler *server_next) :
+    _ble(ble),
+    _gap_next(gap_next),
+    _server_next(server_next),
+    _characteristics(),
+    _values(),
+    _lengths(),
+    _streams(0),
+    _characteristic_count(0),
+    _clients(),
+    _turn(0)
+{
+}
+
+int GattFanout::add_characteristic(GattCharacteristic &characteristic, bool coalesce)
+{
+    if (_characteristic_count == MAX_CHARACTERISTICS) {
+        return -1;
+    }
+    _characteristics[_characteristic_count] = &characteristic;
+    if (!coalesce) {
+        _streams |= (uint16_t)(1u << _characteristic_count);
+    }
+    return (int)_characteristic_count++;
+}
+
+void GattFanout::start()
+{
+    _ble.gattServer().setEventHandler(this);
+}
+
+const GattClientState *GattFanout::client(ble::connection_handle_t handle) const
+{
+    for (const Client &client : _clients) {
+        if (client.state.connected && client.state.handle == handle) {
+            return &client.state;
+        }
+    }
+    return nullptr;
+}
+
+GattFanout::Client *GattFanout::find(ble::connection_handle_t handle)
+{
+    for (Client &client : _clients) {
+        if (client.state.connected && client.state.handle == handle) {
+            return &client;
+        }
+    }
+    return nullptr;
+}
+
+int GattFanout::characteristic_of(GattAttribute::Handle_t value_handle) const
+{
+    for (size_t i = 0; i < _characteristic_count; i++) {
+        if (_characteristics[i]->getValueHandle() == value_handle) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+size_t GattFanout::subscribers(int characteristic) const
+{
+    size_t count = 0;
+    for (const Client &client : _clients) {
+        if (client.state.connected && (client.state.subscriptions & (1u << characteristic))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+size_t GattFanout::room(int characteristic) const
+{
+    size_t room = QUEUE_DEPTH;
+    for (const Client &client : _clients) {
+        if (client.state.connected && (client.state.subscriptions & (1u << characteristic)) &&
+            QUEUE_DEPTH - client.state.queued < room) {
+            room = QUEUE_DEPTH - client.state.queued;
+        }
+    }
+    return room;
+}
+
+int GattFanout::notify(int characteristic, const uint8_t *value, uint16_t length)
+{
+    if (characteristic < 0 || (size_t)characteristic >= _characteristic_count || length > VALUE_MAX) {
+        return -1;
+    }
+    memcpy(_values[characteristic], value, length);
+    _lengths[characteristic] = (uint8_t)length;
+    // reads see the new value; the notifications go out per connection
+    _ble.gattServer().write(_characteristics[characteristic]->getValueHandle(), value, length, true);
+
+    for (Client &client : _clients) {
+        if (client.state.connected && (client.state.subscriptions & (1u << characteristic))) {
+            enqueue(client, (uint8_t)characteristic, value, length);
+        }
+    }
+    pump();
+    return 0;
+}
+
+int GattFanout::notify(int characteristic, ble::connection_handle_t connection, const uint8_t *value,
+                       uint16_t length)
+{
+    if (characteristic < 0 || (size_t)characteristic >= _characteristic_count || length > VALUE_MAX) {
+        return -1;
+    }
+    Client *client = find(connection);
+    if (!client || !(client->state.subscriptions & (1u << characteristic))) {
+        return -1;
+    }
+    memcpy(_values[characteristic], value, length);
+    _lengths[characteristic] = (uint8_t)length;
+    _ble.gattServer().write(_characteristics[characteristic]->getValueHandle(), value, length, true);
+    enqueue(*client, (uint8_t)characteristic, value, length);
+    pump();
+    return 0;
+}
+
+void GattFanout::enqueue(Client &client, uint8_t characteristic, const uint8_t *value, uint16_t length)
+{
+    GattClientState &state = client.state;
+    Pending *slot = nullptr;
+    // the newest pending value of the characteristic is stale now, unless the stack has it
+    for (size_t i = (_streams & (1u << characteristic)) ? 0 : state.queued; i-- > 0;) {
+        Pending &pending = client.queue[(client.head + i) % QUEUE_DEPTH];
+        if (pending.characteristic == characteristic) {
+            if (i + 1 == (size_t)state.queued) {
+                slot = &pending;
+                state.coalesced++;
+            }
+            break;
+        }
+    }
+    if (!slot) {
+        if (state.queued == QUEUE_DEPTH) {
+            client.head = (uint8_t)((client.head + 1) % QUEUE_DEPTH);
+            state.queued--;
+            state.dropped++;
+        }
+        slot = &client.queue[(client.head + state.queued) % QUEUE_DEPTH];
+        state.queued++;
+    }
+    slot->characteristic = characteristic;
+    slot->length = (uint8_t)length;
+    memcpy(slot->value, value, length);
+}
+
+/** Hand the stack the oldest pending value of a client, if it has room. */
+bool GattFanout::send(Client &client)
+{
+    GattClientState &state = client.state;
+    if (!state.queued || state.in_flight >= MAX_IN_FLIGHT) {
+        return false;
+    }
+    const Pending &pending = client.queue[client.head];
+    GattAttribute::Handle_t handle = _characteristics[pending.characteristic]->getValueHandle();
+    uint16_t length = pending.length;
+    if (length > state.att_mtu - 3) {
+        length = state.att_mtu - 3;
+    }
+    ble::GattServer &server = _ble.gattServer();
+    ble_error_t error = server.write(state.handle, handle, pending.value, length);
+    if (error == BLE_ERROR_NO_MEM) {
+        // the stack is out of buffers for the link, retried on its next onDataSent()
+        return false;
+    }
+    if (error) {
+        LAB_LOG_WARN("ble fanout %u: notification failed, error %u", (unsigned)state.handle, error);
+    } else {
+        state.in_flight++;
+    }
+    // a write to one connection sets the value for all, put the latest back
+    if (length != _lengths[pending.characteristic] ||
+        memcmp(pending.value, _values[pending.characteristic], length)) {
+        server.write(handle, _values[pending.characteristic], _lengths[pending.characteristic], true);
+    }
+    client.head = (uint8_t)((client.head + 1) % QUEUE_DEPTH);
+    state.queued--;
+    return true;
+}
+
+/** Rounds of one notification per client, each round from the next client, until none can send. */
+void GattFanout::pump()
+{
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (size_t i = 0; i < MAX_CLIENTS; i++) {
+            Client &client = _clients[(_turn + i) % MAX_CLIENTS];
+            if (client.state.connected && send(client)) {
+                progress = true;
+            }
+        }
+        _turn = (_turn + 1) % MAX_CLIENTS;
+    }
+}
+
+void GattFanout::onConnectionComplete(const ble::ConnectionCompleteEvent &event)
+{
+    if (event.getStatus() == BLE_ERROR_NONE) {
+        Client *client = nullptr;
+        for (Client &candidate : _clients) {
+            if (!candidate.state.connected) {
+                client = &candidate;
+                break;
+            }
+        }
+        if (!client) {
+            LAB_LOG_WARN("ble fanout %u: no room, the client gets no notifications",
+                         (unsigned)event.getConnectionHandle());
+        } else {
+            memset(client, 0, sizeof(*client));
+            client->state.handle = event.getConnectionHandle();
+            client->state.connected = true;
+            client->state.att_mtu = BLE_DEFAULT_ATT_MTU;
+        }
+    }
+    if (_gap_next) {
+        _gap_next->onConnectionComplete(event);
+    }
+}
+
+void GattFanout::onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event)
+{
+    Client *client = find(event.getConnectionHandle());
+    if (client) {
+        const GattClientState &state = client->state;
+        LAB_LOG_INFO("ble fanout %u: %u sent, %u coalesced, %u dropped", (unsigned)state.handle, state.sent,
+                     state.coalesced, state.dropped);
+        client->state.connected = false;
+    }
+    if (_gap_next) {
+        _gap_next->onDisconnectionComplete(event);
+    }
+}
+
+void GattFanout::onAdvertisingStart(const ble::AdvertisingStartEvent &event)
+{
+    if (_gap_next) {
+        _gap_next->onAdvertisingStart(event);
+    }
+}
+
+void GattFanout::onAdvertisingEnd(const ble::AdvertisingEndEvent &event)
+{
+    if (_gap_next) {
+        _gap_next->onAdvertisingEnd(event);
+    }
+}
+
+void GattFanout::onUpdateConnectionParametersRequest(const ble::UpdateConnectionParametersRequestEvent &event)
+{
+    if (_gap_next) {
+        _gap_next->onUpdateConnectionParametersRequest(event);
+    }
+}
+
+void GattFanout::onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event)
+{
+    if (_gap_next) {
+        _gap_next->onConnectionParametersUpdateComplete(event);
+    }
+}
+
+void GattFanout::onReadPhy(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                           ble::phy_t rx_phy)
+{
+    if (_gap_next) {
+        _gap_next->onReadPhy(status, connection, tx_phy, rx_phy);
+    }
+}
+
+void GattFanout::onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                                     ble::phy_t rx_phy)
+{
+    if (_gap_next) {
+        _gap_next->onPhyUpdateComplete(status, connection, tx_phy, rx_phy);
+    }
+}
+
+void GattFanout::onDataLengthChange(ble::connection_handle_t connection, uint16_t tx_size, uint16_t rx_size)
+{
+    if (_gap_next) {
+        _gap_next->onDataLengthChange(connection, tx_size, rx_size);
+    }
+}
+
+void GattFanout::onAttMtuChange(ble::connection_handle_t connection, uint16_t att_mtu)
+{
+    Client *client = find(connection);
+    if (client) {
+        client->state.att_mtu = att_mtu;
+    }
+    if (_server_next) {
+        _server_next->onAttMtuChange(connection, att_mtu);
+    }
+}
+
+void GattFanout::onDataSent(const GattDataSentCallbackParams &params)
+{
+    Client *client = find(params.connHandle);
+    if (client && client->state.in_flight) {
+        client->state.in_flight--;
+        client->state.sent++;
+    }
+    if (_server_next) {
+        _server_next->onDataSent(params);
+    }
+    pump();
+}
+
+void GattFanout::onDataWritten(const GattWriteCallbackParams &params)
+{
+    if (_server_next) {
+        _server_next->onDataWritten(params);
+    }
+}
+
+void GattFanout::onDataRead(const GattReadCallbackParams &params)
+{
+    if (_server_next) {
+        _server_next->onDataRead(params);
+    }
+}
+
+void GattFanout::onShutdown(const ble::GattServer &server)
+{
+    for (Client &client : _clients) {
+        client.state.connected = false;
+    }
+    if (_server_next) {
+        _server_next->onShutdown(server);
+    }
+}
+
+void GattFanout::onUpdatesEnabled(const GattUpdatesEnabledCallbackParams &params)
+{
+    Client *client = find(params.connHandle);
+    int characteristic = characteristic_of(params.charHandle);
+    if (client && characteristic >= 0) {
+        client->state.subscriptions |= (uint16_t)(1u << characteristic);
+    }
+    if (_server_next) {
+        _server_next->onUpdatesEnabled(params);
+    }
+}
+
+void GattFanout::onUpdatesDisabled(const GattUpdatesDisabledCallbackParams &params)
+{
+    Client *client = find(params.connHandle);
+    int characteristic = characteristic_of(params.charHandle);
+    if (client && characteristic >= 0) {
+        client->state.subscriptions &= (uint16_t)~(1u << characteristic);
+    }
+    if (_server_next) {
+        _server_next->onUpdatesDisabled(params);
+    }
+}
+
+void GattFanout::onConfirmationReceived(const GattConfirmationReceivedCallbackParams &params)
+{
+    if (_server_next) {
+        _server_next->onConfirmationReceived(params);
+    }
+}
+
+} // namespace lab
+
+#endif // FEATURE_BLE
@@ -0,0 +1,162 @@
+#ifndef LAB_GATT_FANOUT_H
+#define LAB_GATT_FANOUT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LinkBudget.h"
+#include "ble/BLE.h"
+
+namespace lab {
+
+/** What the fanout knows of one connected client. */
+struct GattClientState {
+    ble::connection_handle_t handle;
+    bool connected;
+    uint16_t att_mtu;
+    /** Bit i: subscribed to characteristic i of the fanout. */
+    uint16_t subscriptions;
+    /** Notifications waiting here, and handed to the stack but not sent yet. */
+    uint8_t queued;
+    uint8_t in_flight;
+    uint32_t sent;
+    /** Pending values replaced by a newer one of the same characteristic. */
+    uint32_t coalesced;
+    /** Pending values dropped because the queue was full. */
+    uint32_t dropped;
+};
+
+/**
+ * Notifications of a GATT server to several centrals at once.
+ *
+ * GattServer::write() without a connection hands a value to every
+ * subscribed link; when one link is slow its buffers fill and write()
+ * fails for everyone. The fanout keeps a table per connection instead:
+ * subscriptions, ATT MTU and a queue of pending values, and hands the
+ * stack at most MAX_IN_FLIGHT notifications per link, taking one from
+ * each client in turn. A client that cannot keep up only loses its own
+ * updates: a newer value replaces a pending one of the same
+ * characteristic, and when the queue is full the oldest pending value
+ * goes. A characteristic added with coalesce false is a stream instead,
+ * every value counts: its values are all queued, and the sender keeps
+ * them from being dropped by waiting for room().
+ *
+ * The fanout is the GattServer event handler and passes every event on
+ * to the service behind it. It also needs the Gap events: install it as
+ * the Gap handler, or as the next handler of one (ConnectionManager);
+ * it passes those on too. Everything runs from processEvents() or the
+ * thread dispatching the event queue.
+ */
+class GattFanout : public ble::Gap::EventHandler, public ble::GattServer::EventHandler {
+public:
+    static const size_t MAX_CLIENTS = 4;
+    static const size_t MAX_CHARACTERISTICS = 16;
+    static const size_t QUEUE_DEPTH = 8;
+    static const size_t VALUE_MAX = 32;
+    static const uint8_t MAX_IN_FLIGHT = 4;
+
+    /**
+     * @param[in] gap_next Gap handler the events go on to, typically the
+     * BLEProcess.
+     * @param[in] server_next GattServer handler the events go on to, the
+     * service.
+     */
+    GattFanout(BLE &ble, ble::Gap::EventHandler *gap_next, ble::GattServer::EventHandler *server_next);
+
+    /**
+     * Register a characteristic with notify or indicate, before start().
+     *
+     * @param[in] coalesce Whether a newer value replaces a pending one.
+     *
+     * @return id for notify(), -1 if the table is full.
+     */
+    int add_characteristic(GattCharacteristic &characteristic, bool coalesce = true);
+
+    /** Install the GattServer event handler, once the services are added. */
+    void start();
+
+    /**
+     * Set the value of a characteristic and queue it for every client
+     * subscribed to it; values longer than a client's MTU allows are cut
+     * to att_mtu - 3 for that client.
+     *
+     * @return 0, -1 for a bad id or a value over VALUE_MAX bytes.
+     */
+    int notify(int characteristic, const uint8_t *value, uint16_t length);
+
+    /**
+     * The same for one client, e.g. the answer to its write.
+     *
+     * @return 0, -1 for a bad id, a value over VALUE_MAX bytes or a client
+     * not subscribed to the characteristic.
+     */
+    int notify(int characteristic, ble::connection_handle_t connection, const uint8_t *value, uint16_t length);
+
+    /** @return the state of a client, nullptr if it is not connected. */
+    const GattClientState *client(ble::connection_handle_t handle) const;
+
+    /** Clients subscribed to a characteristic. */
+    size_t subscribers(int characteristic) const;
+
+    /** Free queue slots of the fullest client subscribed to a characteristic, QUEUE_DEPTH for none. */
+    size_t room(int characteristic) const;
+
+private:
+    struct Pending {
+        uint8_t characteristic;
+        uint8_t length;
+        uint8_t value[VALUE_MAX];
+    };
+
+    struct Client {
+        GattClientState state;
+        /** Ring of state.queued values from head. */
+        Pending queue[QUEUE_DEPTH];
+        uint8_t head;
+    };
+
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override;
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override;
+    void onAdvertisingStart(const ble::AdvertisingStartEvent &event) override;
+    void onAdvertisingEnd(const ble::AdvertisingEndEvent &event) override;
+    void onUpdateConnectionParametersRequest(const ble::UpdateConnectionParametersRequestEvent &event) override;
+    void onConnectionParametersUpdateComplete(const ble::ConnectionParametersUpdateCompleteEvent &event) override;
+    void onReadPhy(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                   ble::phy_t rx_phy) override;
+    void onPhyUpdateComplete(ble_error_t status, ble::connection_handle_t connection, ble::phy_t tx_phy,
+                             ble::phy_t rx_phy) override;
+    void onDataLengthChange(ble::connection_handle_t connection, uint16_t tx_size, uint16_t rx_size) override;
+
+    void onAttMtuChange(ble::connection_handle_t connection, uint16_t att_mtu) override;
+    void onDataSent(const GattDataSentCallbackParams &params) override;
+    void onDataWritten(const GattWriteCallbackParams &params) override;
+    void onDataRead(const GattReadCallbackParams &params) override;
+    void onShutdown(const ble::GattServer &server) override;
+    void onUpdatesEnabled(const GattUpdatesEnabledCallbackParams &params) override;
+    void onUpdatesDisabled(const GattUpdatesDisabledCallbackParams &params) override;
+    void onConfirmationReceived(const GattConfirmationReceivedCallbackParams &params) override;
+
+    Client *find(ble::connection_handle_t handle);
+    int characteristic_of(GattAttribute::Handle_t value_handle) const;
+    void enqueue(Client &client, uint8_t characteristic, const uint8_t *value, uint16_t length);
+    void pump();
+    bool send(Client &client);
+
+    BLE &_ble;
+    ble::Gap::EventHandler *_gap_next;
+    ble::GattServer::EventHandler *_server_next;
+    GattCharacteristic *_characteristics[MAX_CHARACTERISTICS];
+    /** Latest value of each characteristic, what a read gets. */
+    uint8_t _values[MAX_CHARACTERISTICS][VALUE_MAX];
+    uint8_t _lengths[MAX_CHARACTERISTICS];
+    /** Bit i: characteristic i is a stream, never coalesced. */
+    uint16_t _streams;
+    size_t _characteristic_count;
+    Client _clients[MAX_CLIENTS];
+    /** Client the next round starts with. */
+    size_t _turn;
+};
+
+} // namespace lab
+
+#endif // LAB_GATT_FANOUT_H
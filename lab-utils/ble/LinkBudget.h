@@ -0,0 +1,82 @@
+#ifndef LAB_LINK_BUDGET_H
+#define LAB_LINK_BUDGET_H
+
+#include <cstdint>
+
+namespace lab {
+
+/** PHY numbers of the HCI. */
+enum BlePhy {
+    BLE_PHY_1M = 1,
+    BLE_PHY_2M = 2,
+    BLE_PHY_CODED = 3,
+};
+
+/** Link layer payload and ATT MTU before any negotiation. */
+static const uint16_t BLE_DEFAULT_DATA_LENGTH = 27;
+static const uint16_t BLE_MAX_DATA_LENGTH = 251;
+static const uint16_t BLE_DEFAULT_ATT_MTU = 23;
+
+/** Inter frame space. */
+static const uint32_t BLE_IFS_US = 150;
+
+inline const char *ble_phy_name(uint8_t phy)
+{
+    return phy == BLE_PHY_2M ? "2M" : phy == BLE_PHY_CODED ? "coded" : "1M";
+}
+
+/** Air time of a data packet: preamble, access address, header, payload and CRC. */
+inline uint32_t ble_packet_us(uint16_t payload, uint8_t phy)
+{
+    switch (phy) {
+    case BLE_PHY_2M:
+        return (2u + 4u + 2u + payload + 3u) * 4u;
+    case BLE_PHY_CODED:
+        // S=8: 80 us preamble, 376 us up to the header, 64 us a byte, 24 us TERM2
+        return 376u + (2u + payload + 3u) * 64u + 24u;
+    default:
+        return (1u + 4u + 2u + payload + 3u) * 8u;
+    }
+}
+
+/** A data packet and the empty packet acknowledging it, both spaces included. */
+inline uint32_t ble_exchange_us(uint16_t payload, uint8_t phy)
+{
+    return ble_packet_us(payload, phy) + BLE_IFS_US + ble_packet_us(0, phy) + BLE_IFS_US;
+}
+
+/**
+ * Air time of a notification of length bytes: with its ATT (3 bytes)
+ * and L2CAP (4) headers, in link layer packets of data_length at most.
+ */
+inline uint32_t ble_notification_us(uint16_t length, uint8_t phy, uint16_t data_length)
+{
+    uint32_t pdu = 4u + 3u + length;
+    uint32_t time = 0;
+    while (pdu > data_length) {
+        time += ble_exchange_us(data_length, phy);
+        pdu -= data_length;
+    }
+    return time + ble_exchange_us((uint16_t)pdu, phy);
+}
+
+/**
+ * Notification throughput of a link, bits of value per second: as many
+ * notifications of att_mtu - 3 bytes as fit in event_us, every
+ * interval_us. With event_us the whole interval it is what the link can
+ * carry at best; centrals often close the event earlier.
+ */
+inline uint32_t ble_notify_throughput_bps(uint32_t interval_us, uint32_t event_us, uint8_t phy, uint16_t data_length,
+                                          uint16_t att_mtu)
+{
+    if (!interval_us || att_mtu <= 3) {
+        return 0;
+    }
+    uint16_t length = att_mtu - 3;
+    uint32_t per_event = event_us / ble_notification_us(length, phy, data_length);
+    return (uint32_t)((uint64_t)per_event * length * 8u * 1000000u / interval_us);
+}
+
+} // namespace lab
+
+#endif // LAB_LINK_BUDGET_H
@@ -0,0 +1,72 @@
+#ifndef LAB_MULTI_CENTRAL_PROCESS_H
+#define LAB_MULTI_CENTRAL_PROCESS_H
+
+#include <cstddef>
+
+#include "ble/BLE.h"
+#include "events/EventQueue.h"
+
+namespace lab {
+
+/**
+ * A BLEProcess (or GattServerProcess) that keeps advertising while
+ * connected, until max_centrals are.
+ *
+ * The processes of mbed-os-ble-utils advertise again only after a
+ * disconnection, so a second central never finds the device. This one
+ * restarts advertising after each connection while there is room, and
+ * skips start_advertising() while advertising is already on, which a
+ * disconnection below max_centrals would otherwise trip on.
+ */
+template <typename Process>
+class MultiCentralProcess : public Process {
+public:
+    MultiCentralProcess(events::EventQueue &event_queue, BLE &ble_interface, size_t max_centrals = 4) :
+        Process(event_queue, ble_interface),
+        _max_centrals(max_centrals),
+        _centrals(0)
+    {
+    }
+
+    size_t centrals() const
+    {
+        return _centrals;
+    }
+
+protected:
+    void start_advertising() override
+    {
+        if (this->_ble.gap().isAdvertisingActive(ble::LEGACY_ADVERTISING_HANDLE)) {
+            return;
+        }
+        Process::start_advertising();
+    }
+
+    void onConnectionComplete(const ble::ConnectionCompleteEvent &event) override
+    {
+        Process::onConnectionComplete(event);
+        if (event.getStatus() != BLE_ERROR_NONE) {
+            return;
+        }
+        _centrals++;
+        if (_centrals < _max_centrals) {
+            this->start_activity();
+        }
+    }
+
+    void onDisconnectionComplete(const ble::DisconnectionCompleteEvent &event) override
+    {
+        if (_centrals) {
+            _centrals--;
+        }
+        Process::onDisconnectionComplete(event);
+    }
+
+private:
+    size_t _max_centrals;
+    size_t _centrals;
+};
+
+} // namespace lab
+
+#endif // LAB_MULTI_CENTRAL_PROCESS_H
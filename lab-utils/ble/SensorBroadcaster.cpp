@@ -0,0 +1,174 @@
+#if defined(FEATURE_BLE)
+
+#include "SensorBroadcaster.h"
+
+#include <chrono>
+
+#include "DeferredLog.h"
+
+namespace lab {
+
+SensorBroadcastConfig default_sensor_broadcast_config(uint8_t channels)
+{
+    SensorBroadcastConfig config = {};
+    config.codec.channels = channels;
+    config.codec.key_interval = 0;
+    config.interval_ms = 100;
+    config.rotate_ms = 300;
+    config.max_fragments = 3;
+    config.extended = true;
+    return config;
+}
+
+SensorBroadcaster::SensorBroadcaster(BLE &ble, events::EventQueue &queue, const SensorBroadcastConfig &config) :
+    _ble(ble),
+    _queue(queue),
+    _config(config),
+    _encoder(config.codec),
+    _packer(BROADCAST_LEGACY_PAYLOAD),
+    _handle(ble::LEGACY_ADVERTISING_HANDLE),
+    _extended(false),
+    _started(false),
+    _advertising(false),
+    _rotation(0),
+    _next(0),
+    _sequence(0)
+{
+}
+
+int SensorBroadcaster::start()
+{
+    ble::Gap &gap = _ble.gap();
+    uint32_t interval = _config.interval_ms * 1000 / 625;
+    ble::AdvertisingParameters parameters(ble::advertising_type_t::NON_CONNECTABLE_UNDIRECTED,
+                                          ble::adv_interval_t(interval), ble::adv_interval_t(interval));
+
+    _extended = false;
+    _handle = ble::LEGACY_ADVERTISING_HANDLE;
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    if (_config.extended && gap.isFeatureSupported(ble::controller_supported_features_t::LE_EXTENDED_ADVERTISING)) {
+        parameters.setUseLegacyPDU(false);
+        ble_error_t error = gap.createAdvertisingSet(&_handle, parameters);
+        if (error == BLE_ERROR_NONE) {
+            _extended = true;
+        } else {
+            LAB_LOG_WARN("ble broadcast: no extended set (%d), legacy", (int)error);
+            _handle = ble::LEGACY_ADVERTISING_HANDLE;
+            parameters.setUseLegacyPDU(true);
+        }
+    }
+#endif
+    if (!_extended) {
+        ble_error_t error = gap.setAdvertisingParameters(_handle, parameters);
+        if (error != BLE_ERROR_NONE) {
+            LAB_LOG_ERROR("ble broadcast: parameters refused (%d)", (int)error);
+            return -1;
+        }
+    }
+    _packer = BroadcastPacker(_extended ? BROADCAST_EXTENDED_PAYLOAD : BROADCAST_LEGACY_PAYLOAD);
+    _started = true;
+    LAB_LOG_INFO("ble broadcast: %s advertising, %u byte fragments", _extended ? "extended" : "legacy",
+                 (unsigned)_packer.fragment_data());
+    return 0;
+}
+
+void SensorBroadcaster::stop()
+{
+    if (_rotation) {
+        _queue.cancel(_rotation);
+        _rotation = 0;
+    }
+    if (_advertising) {
+        _ble.gap().stopAdvertising(_handle);
+        _advertising = false;
+    }
+#if BLE_FEATURE_EXTENDED_ADVERTISING
+    if (_extended) {
+        _ble.gap().destroyAdvertisingSet(_handle);
+        _extended = false;
+    }
+#endif
+    _started = false;
+}
+
+int SensorBroadcaster::publish(const int16_t *values, size_t frames, uint32_t first_frame, uint32_t period_us)
+{
+    if (!_started || !frames) {
+        return -1;
+    }
+    // the rotation packs from _batch
+    if (_rotation) {
+        _queue.cancel(_rotation);
+        _rotation = 0;
+    }
+    if (frames > IMU_CODEC_MAX_FRAMES) {
+        values += (frames - IMU_CODEC_MAX_FRAMES) * _config.codec.channels;
+        first_frame += (uint32_t)(frames - IMU_CODEC_MAX_FRAMES);
+        frames = IMU_CODEC_MAX_FRAMES;
+    }
+    size_t budget = _config.max_fragments * _packer.fragment_data();
+    if (budget > BROADCAST_MAX_BATCH) {
+        budget = BROADCAST_MAX_BATCH;
+    }
+
+    // the newest frames that fit, halving until they do
+    int length = -1;
+    size_t sent = frames;
+    while (sent) {
+        size_t skipped = frames - sent;
+        length = broadcast_encode_imu(_encoder, first_frame + (uint32_t)skipped, period_us,
+                                      values + skipped * _config.codec.channels, sent, _batch, budget);
+        if (length > 0) {
+            break;
+        }
+        sent /= 2;
+    }
+    if (length <= 0) {
+        return -1;
+    }
+
+    _sequence++;
+    if (_packer.set(_sequence, _batch, (size_t)length) < 0) {
+        return -1;
+    }
+    _next = 0;
+    if (advertise_next()) {
+        return -1;
+    }
+    if (!_advertising) {
+        ble_error_t error = _ble.gap().startAdvertising(_handle);
+        if (error != BLE_ERROR_NONE) {
+            LAB_LOG_ERROR("ble broadcast: start refused (%d)", (int)error);
+            return -1;
+        }
+        _advertising = true;
+    }
+    if (_packer.fragments() > 1) {
+        _rotation = _queue.call_every(std::chrono::milliseconds(_config.rotate_ms), this, &SensorBroadcaster::rotate);
+    }
+    return (int)sent;
+}
+
+void SensorBroadcaster::rotate()
+{
+    advertise_next();
+}
+
+int SensorBroadcaster::advertise_next()
+{
+    int size = _packer.pack(_next, _payload, sizeof(_payload));
+    if (size < 0) {
+        return -1;
+    }
+    ble_error_t error = _ble.gap().setAdvertisingPayload(_handle, mbed::make_const_Span(_payload, (size_t)size));
+    if (error != BLE_ERROR_NONE) {
+        LAB_LOG_WARN("ble broadcast: payload refused (%d)", (int)error);
+        return -1;
+    }
+    _next = (_next + 1) % _packer.fragments();
+    return 0;
+}
+
+} // namespace lab
+
+#endif // FEATURE_BLE
@@ -0,0 +1,111 @@
+#ifndef LAB_SENSOR_BROADCASTER_H
+#define LAB_SENSOR_BROADCASTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "BroadcastFormat.h"
+#include "ImuCodec.h"
+#include "ble/BLE.h"
+#include "events/EventQueue.h"
+
+namespace lab {
+
+struct SensorBroadcastConfig {
+    ImuCodecConfig codec;
+    /** Advertising interval, 100 ms and up for non-connectable legacy advertising. */
+    uint32_t interval_ms;
+    /** How long each fragment of a batch is advertised before the next one. */
+    uint32_t rotate_ms;
+    /** Fragments of a batch at most: publish() drops the oldest frames beyond. */
+    size_t max_fragments;
+    /** Use extended advertising where the controller has it. */
+    bool extended;
+};
+
+/**
+ * 100 ms interval, 300 ms per fragment (three advertising events), at
+ * most 3 fragments, extended advertising, lossless codec.
+ */
+SensorBroadcastConfig default_sensor_broadcast_config(uint8_t channels);
+
+/**
+ * Broadcasts the latest batch of sensor frames in non-connectable
+ * advertising, see BroadcastFormat.h, for gateways that scan instead of
+ * connecting.
+ *
+ * With extended advertising (BLE_FEATURE_EXTENDED_ADVERTISING and a
+ * controller that has it) the broadcaster gets a set of its own with
+ * 245 byte payloads and connectable legacy advertising goes on
+ * alongside. Otherwise it takes the legacy set, 31 byte payloads, and the
+ * device is not connectable while it broadcasts.
+ *
+ * The fragments of a batch are advertised in turn, each for rotate_ms,
+ * over and over until the next publish(). Everything runs on the event
+ * queue thread.
+ */
+class SensorBroadcaster {
+public:
+    SensorBroadcaster(BLE &ble, events::EventQueue &queue, const SensorBroadcastConfig &config);
+
+    /**
+     * Set up advertising, once the stack is initialized. Nothing goes on
+     * the air before the first publish().
+     *
+     * @return 0, -1 if the stack refused.
+     */
+    int start();
+
+    void stop();
+
+    /**
+     * Broadcast a batch, in place of the one on the air.
+     *
+     * @param[in] values frames * channels interleaved values, oldest first.
+     * @param[in] first_frame number of the first frame, for the gateway
+     * to line batches up.
+     *
+     * @return frames broadcast, the newest ones that fit max_fragments,
+     * -1 on error.
+     */
+    int publish(const int16_t *values, size_t frames, uint32_t first_frame, uint32_t period_us);
+
+    bool extended() const
+    {
+        return _extended;
+    }
+
+    /** Sequence of the batch on the air. */
+    uint16_t sequence() const
+    {
+        return _sequence;
+    }
+
+    size_t fragments() const
+    {
+        return _packer.fragments();
+    }
+
+private:
+    void rotate();
+    int advertise_next();
+
+    BLE &_ble;
+    events::EventQueue &_queue;
+    SensorBroadcastConfig _config;
+    ImuEncoder _encoder;
+    BroadcastPacker _packer;
+    ble::advertising_handle_t _handle;
+    bool _extended;
+    bool _started;
+    bool _advertising;
+    int _rotation;
+    size_t _next;
+    uint16_t _sequence;
+    uint8_t _batch[BROADCAST_MAX_BATCH];
+    uint8_t _payload[BROADCAST_EXTENDED_PAYLOAD];
+};
+
+} // namespace lab
+
+#endif // LAB_SENSOR_BROADCASTER_H
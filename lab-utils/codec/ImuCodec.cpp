@@ -0,0 +1,320 @@
+#include "ImuCodec.h"
+
+#include <cstring>
+
+namespace lab {
+
+static const uint8_t BLOCK_KEY = 0x10;
+static const uint8_t BLOCK_QUANT = 0x20;
+static const size_t HEADER_SIZE = 2;
+
+namespace {
+
+class BitWriter {
+public:
+    BitWriter(uint8_t *data, size_t capacity) :
+        _data(data), _capacity(capacity), _bytes(0), _acc(0), _bits(0), _overflow(false)
+    {
+    }
+
+    void put(uint32_t value, unsigned width)
+    {
+        if (!width) {
+            return;
+        }
+        _acc |= (uint64_t)(value & ((1ull << width) - 1)) << _bits;
+        _bits += width;
+        while (_bits >= 8) {
+            emit((uint8_t)_acc);
+            _acc >>= 8;
+            _bits -= 8;
+        }
+    }
+
+    /** @return bytes used, or -1 on overflow. */
+    int finish()
+    {
+        if (_bits) {
+            emit((uint8_t)_acc);
+            _acc = 0;
+            _bits = 0;
+        }
+        return _overflow ? -1 : (int)_bytes;
+    }
+
+private:
+    void emit(uint8_t byte)
+    {
+        if (_bytes < _capacity) {
+            _data[_bytes++] = byte;
+        } else {
+            _overflow = true;
+        }
+    }
+
+    uint8_t *_data;
+    size_t _capacity;
+    size_t _bytes;
+    uint64_t _acc;
+    unsigned _bits;
+    bool _overflow;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t *data, size_t length) :
+        _data(data), _length(length), _bytes(0), _acc(0), _bits(0), _underflow(false)
+    {
+    }
+
+    uint32_t get(unsigned width)
+    {
+        if (!width) {
+            return 0;
+        }
+        while (_bits < width) {
+            uint8_t byte = 0;
+            if (_bytes < _length) {
+                byte = _data[_bytes++];
+            } else {
+                _underflow = true;
+            }
+            _acc |= (uint64_t)byte << _bits;
+            _bits += 8;
+        }
+        uint32_t value = (uint32_t)(_acc & ((1ull << width) - 1));
+        _acc >>= width;
+        _bits -= width;
+        return value;
+    }
+
+    bool underflow() const
+    {
+        return _underflow;
+    }
+
+    /** Bytes consumed, the partial last byte included. */
+    size_t used() const
+    {
+        return _bytes;
+    }
+
+private:
+    const uint8_t *_data;
+    size_t _length;
+    size_t _bytes;
+    uint64_t _acc;
+    unsigned _bits;
+    bool _underflow;
+};
+
+} // namespace
+
+// residuals of int16 values span 17 bits
+static inline uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static inline unsigned bit_width(uint32_t value)
+{
+    unsigned width = 0;
+    while (value) {
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+static inline int16_t quantize(int16_t value, unsigned shift)
+{
+    if (!shift) {
+        return value;
+    }
+    // round to nearest and keep the result representable after <<shift
+    int32_t q = ((int32_t)value + (1 << (shift - 1))) >> shift;
+    int32_t max = INT16_MAX >> shift;
+    return (int16_t)(q > max ? max : q);
+}
+
+ImuEncoder::ImuEncoder(const ImuCodecConfig &config) :
+    _config(config),
+    _since_key(0),
+    _need_key(true)
+{
+    if (_config.channels > IMU_CODEC_MAX_CHANNELS) {
+        _config.channels = IMU_CODEC_MAX_CHANNELS;
+    }
+    for (size_t c = 0; c < IMU_CODEC_MAX_CHANNELS; c++) {
+        if (_config.quant_shift[c] > 15) {
+            _config.quant_shift[c] = 15;
+        }
+    }
+    memset(_last, 0, sizeof(_last));
+}
+
+void ImuEncoder::reset()
+{
+    _need_key = true;
+}
+
+size_t ImuEncoder::max_block_size(size_t frames) const
+{
+    size_t bits = _config.channels * (4 + 16 + 5 + frames * 17);
+    return HEADER_SIZE + (bits + 7) / 8;
+}
+
+int ImuEncoder::encode(const int16_t *values, size_t frames, uint8_t *out, size_t capacity)
+{
+    const size_t channels = _config.channels;
+    if (!frames || frames > IMU_CODEC_MAX_FRAMES || capacity < HEADER_SIZE) {
+        return -1;
+    }
+
+    bool key = _need_key || _config.key_interval <= 1 || _since_key >= _config.key_interval;
+    bool lossy = false;
+    for (size_t c = 0; c < channels; c++) {
+        lossy = lossy || _config.quant_shift[c];
+    }
+
+    out[0] = channels | (key ? BLOCK_KEY : 0) | (lossy ? BLOCK_QUANT : 0);
+    out[1] = frames;
+    BitWriter bits(out + HEADER_SIZE, capacity - HEADER_SIZE);
+
+    if (lossy) {
+        for (size_t c = 0; c < channels; c++) {
+            bits.put(_config.quant_shift[c], 4);
+        }
+    }
+
+    int16_t last[IMU_CODEC_MAX_CHANNELS];
+    if (key) {
+        for (size_t c = 0; c < channels; c++) {
+            last[c] = quantize(values[c], _config.quant_shift[c]);
+            bits.put((uint16_t)last[c], 16);
+        }
+    } else {
+        memcpy(last, _last, sizeof(last));
+    }
+
+    const size_t first = key ? 1 : 0;
+    for (size_t c = 0; c < channels; c++) {
+        const unsigned shift = _config.quant_shift[c];
+
+        // widest residual of the block sets the width of all of them
+        uint32_t any = 0;
+        int16_t previous = last[c];
+        for (size_t f = first; f < frames; f++) {
+            int16_t q = quantize(values[f * channels + c], shift);
+            any |= zigzag((int32_t)q - previous);
+            previous = q;
+        }
+        unsigned width = bit_width(any);
+        bits.put(width, 5);
+
+        previous = last[c];
+        for (size_t f = first; f < frames; f++) {
+            int16_t q = quantize(values[f * channels + c], shift);
+            bits.put(zigzag((int32_t)q - previous), width);
+            previous = q;
+        }
+        last[c] = previous;
+    }
+
+    int size = bits.finish();
+    if (size < 0) {
+        return -1;
+    }
+
+    // only commit the state once the block is complete
+    memcpy(_last, last, sizeof(_last));
+    _since_key = key ? 1 : _since_key + 1;
+    _need_key = false;
+    return HEADER_SIZE + size;
+}
+
+ImuDecoder::ImuDecoder() :
+    _channels(0),
+    _synced(false)
+{
+    memset(_last, 0, sizeof(_last));
+}
+
+void ImuDecoder::reset()
+{
+    _synced = false;
+}
+
+int ImuDecoder::decode(const uint8_t *data, size_t length, int16_t *values, size_t capacity, size_t *used)
+{
+    if (length < HEADER_SIZE) {
+        return -1;
+    }
+
+    const size_t channels = data[0] & 0x0F;
+    const bool key = data[0] & BLOCK_KEY;
+    const bool lossy = data[0] & BLOCK_QUANT;
+    const size_t frames = data[1];
+
+    if (!channels || channels > IMU_CODEC_MAX_CHANNELS || !frames || (data[0] & 0xC0)) {
+        return -1;
+    }
+    if (!key && (!_synced || channels != _channels)) {
+        return -2;
+    }
+    if (frames > capacity) {
+        return -3;
+    }
+
+    BitReader bits(data + HEADER_SIZE, length - HEADER_SIZE);
+
+    unsigned shift[IMU_CODEC_MAX_CHANNELS] = {0};
+    if (lossy) {
+        for (size_t c = 0; c < channels; c++) {
+            shift[c] = bits.get(4);
+        }
+    }
+
+    int16_t last[IMU_CODEC_MAX_CHANNELS];
+    if (key) {
+        for (size_t c = 0; c < channels; c++) {
+            last[c] = (int16_t)bits.get(16);
+            values[c] = (int16_t)(last[c] * (1 << shift[c]));
+        }
+    } else {
+        memcpy(last, _last, sizeof(last));
+    }
+
+    const size_t first = key ? 1 : 0;
+    for (size_t c = 0; c < channels; c++) {
+        unsigned width = bits.get(5);
+        if (width > 17) {
+            return -1;
+        }
+        int16_t previous = last[c];
+        for (size_t f = first; f < frames; f++) {
+            previous = (int16_t)(previous + unzigzag(bits.get(width)));
+            values[f * channels + c] = (int16_t)(previous * (1 << shift[c]));
+        }
+        last[c] = previous;
+    }
+
+    if (bits.underflow()) {
+        return -1;
+    }
+
+    memcpy(_last, last, sizeof(_last));
+    _channels = channels;
+    _synced = true;
+    if (used) {
+        *used = HEADER_SIZE + bits.used();
+    }
+    return frames;
+}
+
+} // namespace lab
@@ -0,0 +1,106 @@
+#ifndef LAB_IMU_CODEC_H
+#define LAB_IMU_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+static const size_t IMU_CODEC_MAX_CHANNELS = 8;
+static const size_t IMU_CODEC_MAX_FRAMES = 255;
+
+struct ImuCodecConfig {
+    /** Interleaved int16 values per frame, e.g. 6 for an ImuSample. */
+    uint8_t channels;
+    /**
+     * Low bits dropped per channel before coding, 0 keeps the channel
+     * lossless. The error is at most half a step of 2^shift (a full step
+     * next to INT16_MAX, where values are clamped).
+     */
+    uint8_t quant_shift[IMU_CODEC_MAX_CHANNELS];
+    /** Blocks between two key blocks, 0 or 1 makes every block a key. */
+    uint16_t key_interval;
+};
+
+/**
+ * Block encoder for interleaved int16 sensor frames.
+ *
+ * Each channel is predicted from its previous value; the residuals are
+ * zigzag mapped to unsigned and bit-packed at the smallest width that
+ * holds the whole block, so a quiet axis costs a few bits per sample and
+ * a constant one nothing at all. Blocks are self-describing and decoded
+ * in order; a key block also carries absolute first values so a decoder
+ * can start or resynchronise there.
+ *
+ * Block layout, bits packed LSB first:
+ *   byte 0   channel count (low nibble), KEY 0x10, QUANT 0x20
+ *   byte 1   frame count
+ *   QUANT:   4 bit shift per channel
+ *   KEY:     16 bit first value per channel
+ *   per channel: 5 bit width, then one residual per frame (the first
+ *   frame of a key block has none)
+ *
+ * The state is the last reconstructed value of each channel, so encoder
+ * and decoder predict from the same values in the lossy mode as well.
+ */
+class ImuEncoder {
+public:
+    explicit ImuEncoder(const ImuCodecConfig &config);
+
+    /** Upper bound of an encoded block of frames. */
+    size_t max_block_size(size_t frames) const;
+
+    /**
+     * Encode frames into one block.
+     *
+     * @param[in] values frames * channels interleaved values.
+     * @param[in] frames 1 to IMU_CODEC_MAX_FRAMES.
+     *
+     * @return bytes written, or -1 if capacity is too small.
+     */
+    int encode(const int16_t *values, size_t frames, uint8_t *out, size_t capacity);
+
+    /** Make the next block a key block. */
+    void reset();
+
+private:
+    ImuCodecConfig _config;
+    int16_t _last[IMU_CODEC_MAX_CHANNELS];
+    uint16_t _since_key;
+    bool _need_key;
+};
+
+/** Decoder of ImuEncoder blocks. */
+class ImuDecoder {
+public:
+    ImuDecoder();
+
+    /**
+     * Decode one block.
+     *
+     * @param[in] capacity Frames available in values.
+     * @param[out] used Bytes of data consumed by the block, may be null.
+     *
+     * @return frames decoded, -1 on a malformed or truncated block, -2 if
+     * no key block was seen yet, -3 if values is too small.
+     */
+    int decode(const uint8_t *data, size_t length, int16_t *values, size_t capacity, size_t *used);
+
+    /** Channels of the last decoded block. */
+    uint8_t channels() const
+    {
+        return _channels;
+    }
+
+    /** Wait for the next key block. */
+    void reset();
+
+private:
+    int16_t _last[IMU_CODEC_MAX_CHANNELS];
+    uint8_t _channels;
+    bool _synced;
+};
+
+} // namespace lab
+
+#endif // LAB_IMU_CODEC_H
@@ -0,0 +1,109 @@
+#ifndef LAB_MPSC_RING_H
+#define LAB_MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Multi-producer / single-consumer bounded ring without locks.
+ *
+ * Producers may be any mix of threads and interrupt handlers. A slot is
+ * claimed with a compare-and-swap on the write index and published with a
+ * per-slot sequence number, so a producer preempted between the two never
+ * blocks another producer: the consumer simply stops at the unpublished
+ * slot until it is complete. When the ring is full, push() fails
+ * immediately and the loss is counted.
+ *
+ * @tparam T element type, must be trivially copyable.
+ * @tparam N capacity, must be a power of two.
+ */
+template<typename T, size_t N>
+class MpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscRing capacity must be a power of two");
+
+public:
+    MpscRing() : _write(0), _read(0), _dropped(0)
+    {
+        for (size_t i = 0; i < N; i++) {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Append an element. Safe from any context.
+     *
+     * @return false if the ring was full.
+     */
+    bool push(const T &value)
+    {
+        uint32_t pos = _write.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &_cells[pos & (N - 1)];
+            uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(sequence - pos);
+            if (diff == 0) {
+                if (_write.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _write.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the oldest published element. Single consumer only.
+     *
+     * @return false if the ring is empty or the oldest slot is still being
+     * written.
+     */
+    bool pop(T &value)
+    {
+        Cell *cell = &_cells[_read & (N - 1)];
+        uint32_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if (sequence != _read + 1) {
+            return false;
+        }
+        value = cell->value;
+        cell->sequence.store(_read + N, std::memory_order_release);
+        _read++;
+        return true;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    /** Number of elements rejected by push() because the ring was full. */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    Cell _cells[N];
+    std::atomic<uint32_t> _write;
+    uint32_t _read;
+    std::atomic<uint32_t> _dropped;
+};
+
+} // namespace lab
+
+#endif // LAB_MPSC_RING_H
@@ -0,0 +1,108 @@
+#ifndef LAB_SPSC_RING_H
+#define LAB_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Single-producer / single-consumer ring buffer without locks.
+ *
+ * The producer is typically an interrupt handler and the consumer a thread
+ * (or the other way around). Neither side ever blocks or masks interrupts:
+ * head and tail are only written by their owner and published with
+ * release/acquire ordering.
+ *
+ * @tparam T element type, must be trivially copyable.
+ * @tparam N capacity, must be a power of two.
+ */
+template<typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : _head(0), _tail(0), _dropped(0) {}
+
+    /**
+     * Append an element. Producer side only.
+     *
+     * @return false if the ring was full; the element is dropped and counted.
+     */
+    bool push(const T &value)
+    {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= N) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _buffer[head & (N - 1)] = value;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove the oldest element. Consumer side only.
+     *
+     * @return false if the ring was empty.
+     */
+    bool pop(T &value)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = _buffer[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Remove up to max elements in one go. Consumer side only.
+     *
+     * @return number of elements copied into dst.
+     */
+    size_t pop_batch(T *dst, size_t max)
+    {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        uint32_t avail = _head.load(std::memory_order_acquire) - tail;
+        size_t count = avail < max ? avail : max;
+        for (size_t i = 0; i < count; i++) {
+            dst[i] = _buffer[(tail + i) & (N - 1)];
+        }
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+    /** Number of elements rejected by push() because the ring was full. */
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    T _buffer[N];
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    std::atomic<uint32_t> _dropped;
+};
+
+} // namespace lab
+
+#endif // LAB_SPSC_RING_H
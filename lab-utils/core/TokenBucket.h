@@ -0,0 +1,75 @@
+#ifndef LAB_TOKEN_BUCKET_H
+#define LAB_TOKEN_BUCKET_H
+
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Token bucket rate limiter on the 32-bit microsecond clock.
+ *
+ * Tokens accumulate at rate per second up to burst; take() succeeds when
+ * enough are available. Units are up to the caller, typically bytes.
+ */
+class TokenBucket {
+public:
+    TokenBucket(uint32_t rate, uint32_t burst) :
+        _rate(rate),
+        _burst((uint64_t)burst * 1000000),
+        _tokens(_burst),
+        _last_us(0),
+        _started(false)
+    {
+    }
+
+    /** @return true and spend the tokens if amount is available at now_us. */
+    bool take(uint32_t amount, uint32_t now_us)
+    {
+        refill(now_us);
+        uint64_t cost = (uint64_t)amount * 1000000;
+        if (_tokens < cost) {
+            return false;
+        }
+        _tokens -= cost;
+        return true;
+    }
+
+    /** Whole tokens available at now_us. */
+    uint32_t available(uint32_t now_us)
+    {
+        refill(now_us);
+        return (uint32_t)(_tokens / 1000000);
+    }
+
+    void set_rate(uint32_t rate)
+    {
+        _rate = rate;
+    }
+
+private:
+    void refill(uint32_t now_us)
+    {
+        if (!_started) {
+            _started = true;
+            _last_us = now_us;
+            return;
+        }
+        uint32_t elapsed = now_us - _last_us;
+        _last_us = now_us;
+        _tokens += (uint64_t)elapsed * _rate;
+        if (_tokens > _burst) {
+            _tokens = _burst;
+        }
+    }
+
+    uint32_t _rate;
+    uint64_t _burst;
+    /* tokens scaled by 10^6, one microsecond at one token per second */
+    uint64_t _tokens;
+    uint32_t _last_us;
+    bool _started;
+};
+
+} // namespace lab
+
+#endif // LAB_TOKEN_BUCKET_H
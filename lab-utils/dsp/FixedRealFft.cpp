@@ -0,0 +1,122 @@
+#include "FixedRealFft.h"
+
+#include <cmath>
+
+namespace lab {
+
+static const float TWO_PI = 6.28318530718f;
+
+static inline int16_t to_q15(float value)
+{
+    float scaled = value * 32768.0f;
+    scaled = scaled > 32767.0f ? 32767.0f : (scaled < -32768.0f ? -32768.0f : scaled);
+    return (int16_t)lrintf(scaled);
+}
+
+static inline int32_t mul_q15(int32_t value, int16_t factor)
+{
+    return (int32_t)(((int64_t)value * factor) >> 15);
+}
+
+FixedRealFftBase::FixedRealFftBase(size_t size, int16_t *twiddles) :
+    _size(size),
+    _log2_half(0),
+    _twiddles(twiddles)
+{
+    while ((size_t(2) << _log2_half) < size) {
+        _log2_half++;
+    }
+
+    for (size_t k = 0; k < size / 2; k++) {
+        float angle = TWO_PI * k / size;
+        _twiddles[2 * k] = to_q15(cosf(angle));
+        _twiddles[2 * k + 1] = to_q15(-sinf(angle));
+    }
+}
+
+void FixedRealFftBase::forward(const int16_t *input, int32_t *output) const
+{
+    const size_t half = _size / 2;
+
+    // even samples as real, odd ones as imaginary parts, in bit reversed
+    // order for the in-place decimation in time
+    for (size_t i = 0; i < half; i++) {
+        size_t r = 0;
+        for (unsigned b = 0; b < _log2_half; b++) {
+            r |= ((i >> b) & 1) << (_log2_half - 1 - b);
+        }
+        output[2 * r] = (int32_t)input[2 * i] << OUTPUT_SHIFT;
+        output[2 * r + 1] = (int32_t)input[2 * i + 1] << OUTPUT_SHIFT;
+    }
+
+    complex_fft(output);
+    split(output);
+}
+
+void FixedRealFftBase::complex_fft(int32_t *data) const
+{
+    const size_t half = _size / 2;
+
+    for (size_t len = 2; len <= half; len <<= 1) {
+        const size_t span = len / 2;
+        // W_len^j is entry j * size / len of the size point table
+        const size_t step = _size / len;
+
+        for (size_t start = 0; start < half; start += len) {
+            for (size_t j = 0; j < span; j++) {
+                int32_t *a = data + 2 * (start + j);
+                int32_t *b = a + 2 * span;
+                int16_t wr = _twiddles[2 * j * step];
+                int16_t wi = _twiddles[2 * j * step + 1];
+
+                int32_t tr = mul_q15(b[0], wr) - mul_q15(b[1], wi);
+                int32_t ti = mul_q15(b[0], wi) + mul_q15(b[1], wr);
+
+                b[0] = (a[0] - tr) >> 1;
+                b[1] = (a[1] - ti) >> 1;
+                a[0] = (a[0] + tr) >> 1;
+                a[1] = (a[1] + ti) >> 1;
+            }
+        }
+    }
+}
+
+void FixedRealFftBase::split(int32_t *data) const
+{
+    const size_t half = _size / 2;
+
+    // X[0] and X[n/2] only depend on Z[0]
+    int32_t z0r = data[0];
+    int32_t z0i = data[1];
+    data[0] = (z0r + z0i) >> 1;
+    data[1] = 0;
+    data[2 * half] = (z0r - z0i) >> 1;
+    data[2 * half + 1] = 0;
+
+    // X[k] = (E + W^k O) / 2 with E = (Z[k] + Z*[m-k]) / 2 and
+    // O = -i (Z[k] - Z*[m-k]) / 2; bins k and m-k use the same two inputs
+    for (size_t k = 1; k <= half / 2; k++) {
+        size_t m = half - k;
+        int32_t ar = data[2 * k], ai = data[2 * k + 1];
+        int32_t br = data[2 * m], bi = data[2 * m + 1];
+
+        // bin k
+        int32_t er = (ar + br) >> 1, ei = (ai - bi) >> 1;
+        int32_t or_ = (ai + bi) >> 1, oi = (br - ar) >> 1;
+        int16_t wr = _twiddles[2 * k], wi = _twiddles[2 * k + 1];
+        int32_t xr = er + mul_q15(or_, wr) - mul_q15(oi, wi);
+        int32_t xi = ei + mul_q15(or_, wi) + mul_q15(oi, wr);
+
+        // bin m: E and O of the mirrored pair are conj(E) and conj(O)
+        int16_t vr = _twiddles[2 * m], vi = _twiddles[2 * m + 1];
+        int32_t yr = er + mul_q15(or_, vr) + mul_q15(oi, vi);
+        int32_t yi = -ei + mul_q15(or_, vi) - mul_q15(oi, vr);
+
+        data[2 * k] = xr >> 1;
+        data[2 * k + 1] = xi >> 1;
+        data[2 * m] = yr >> 1;
+        data[2 * m + 1] = yi >> 1;
+    }
+}
+
+} // namespace lab
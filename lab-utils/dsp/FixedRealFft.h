@@ -0,0 +1,75 @@
+#ifndef LAB_FIXED_REAL_FFT_H
+#define LAB_FIXED_REAL_FFT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Fixed-point FFT of a real signal.
+ *
+ * The n real samples are packed into an n/2 point complex FFT (radix 2,
+ * decimation in time) whose result is then split into the spectrum of
+ * the real input. Data move through 32-bit words with 8 guard bits below
+ * the Q15 input and every butterfly stage halves its result, so nothing
+ * can overflow whatever the input; twiddle factors are Q15. Only integer
+ * multiplies are used, with 64-bit products.
+ *
+ * Use the FixedRealFft template below to get the twiddle table storage.
+ */
+class FixedRealFftBase {
+public:
+    /** Output bins are X[k] * 2^OUTPUT_SHIFT / n. */
+    static const int OUTPUT_SHIFT = 8;
+
+    /**
+     * @param[in] size Number of real samples, a power of two, at least 8.
+     * @param[in] twiddles Storage for size int16_t, filled here.
+     */
+    FixedRealFftBase(size_t size, int16_t *twiddles);
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /**
+     * Transform size samples.
+     *
+     * @param[in] input Real samples.
+     * @param[out] output size + 2 words: real and imaginary parts of the
+     * bins 0 to size / 2.
+     */
+    void forward(const int16_t *input, int32_t *output) const;
+
+private:
+    void complex_fft(int32_t *data) const;
+    void split(int32_t *data) const;
+
+    size_t _size;
+    unsigned _log2_half;
+    /* cos and -sin of 2 pi k / size, for k < size / 2, interleaved. */
+    int16_t *_twiddles;
+};
+
+/**
+ * Real FFT with its twiddle table.
+ *
+ * @tparam Size number of real samples, a power of two from 8 to 4096.
+ */
+template<size_t Size>
+class FixedRealFft : public FixedRealFftBase {
+    static_assert(Size >= 8 && Size <= 4096 && (Size & (Size - 1)) == 0,
+                  "FixedRealFft size must be a power of two from 8 to 4096");
+
+public:
+    FixedRealFft() : FixedRealFftBase(Size, _table) {}
+
+private:
+    int16_t _table[Size];
+};
+
+} // namespace lab
+
+#endif // LAB_FIXED_REAL_FFT_H
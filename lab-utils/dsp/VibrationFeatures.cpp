@@ -0,0 +1,203 @@
+#include "VibrationFeatures.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace lab {
+
+static const float TWO_PI = 6.28318530718f;
+
+/* Mean square of the periodic Hann window. */
+static const float HANN_POWER = 0.375f;
+
+/* Windowed samples are halved to fit int16 once the mean is removed. */
+static const int WINDOW_SHIFT = 16;
+
+VibrationAnalyzerBase::VibrationAnalyzerBase(size_t window, size_t axes, FixedRealFftBase &fft,
+                                             int16_t *history, int16_t *hann, int16_t *scratch, int32_t *spectrum) :
+    _window(window),
+    _axes(axes),
+    _fft(fft),
+    _history(history),
+    _hann(hann),
+    _scratch(scratch),
+    _spectrum(spectrum),
+    _write(0),
+    _filled(0),
+    _since_hop(0),
+    _sequence(0)
+{
+    memset(&_config, 0, sizeof(_config));
+    memset(&_features, 0, sizeof(_features));
+}
+
+int VibrationAnalyzerBase::configure(const VibrationConfig &config)
+{
+    if (config.hop == 0 || config.hop > _window || config.sample_rate_hz <= 0.0f
+            || config.band_count > VIBRATION_MAX_BANDS) {
+        return -1;
+    }
+
+    _config = config;
+    if (_config.scale <= 0.0f) {
+        _config.scale = 1.0f;
+    }
+
+    for (size_t i = 0; i < _window; i++) {
+        float w = 0.5f - 0.5f * cosf(TWO_PI * i / _window);
+        _hann[i] = (int16_t)lrintf(w * 32767.0f);
+    }
+
+    reset();
+    return 0;
+}
+
+void VibrationAnalyzerBase::reset()
+{
+    _write = 0;
+    _filled = 0;
+    _since_hop = 0;
+}
+
+bool VibrationAnalyzerBase::push(const int16_t *frame, uint32_t timestamp_us)
+{
+    for (size_t a = 0; a < _axes; a++) {
+        _history[a * _window + _write] = frame[a];
+    }
+    _write = (_write + 1) & (_window - 1);
+
+    if (_filled < _window) {
+        _filled++;
+    }
+    _since_hop++;
+
+    if (_filled < _window || _since_hop < _config.hop) {
+        return false;
+    }
+    _since_hop = 0;
+
+    analyse(timestamp_us);
+    return true;
+}
+
+size_t VibrationAnalyzerBase::snippet(size_t axis, int16_t *dst, size_t max) const
+{
+    if (axis >= _axes) {
+        return 0;
+    }
+
+    size_t count = max < _filled ? max : _filled;
+    const int16_t *row = _history + axis * _window;
+    size_t start = (_write - count) & (_window - 1);
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = row[(start + i) & (_window - 1)];
+    }
+    return count;
+}
+
+void VibrationAnalyzerBase::analyse(uint32_t timestamp_us)
+{
+    _features.timestamp_us = timestamp_us;
+    _features.sequence = _sequence++;
+    _features.axis_count = _axes;
+    _features.band_count = _config.band_count;
+    _features.anomaly = 0;
+
+    for (size_t a = 0; a < _axes; a++) {
+        AxisFeatures &axis = _features.axis[a];
+        analyse_axis(a, axis);
+
+        if ((_config.rms_threshold > 0.0f && axis.rms > _config.rms_threshold)
+                || (_config.kurtosis_threshold > 0.0f && axis.kurtosis > _config.kurtosis_threshold)) {
+            _features.anomaly |= 1 << a;
+        }
+    }
+}
+
+void VibrationAnalyzerBase::analyse_axis(size_t axis, AxisFeatures &out)
+{
+    const int16_t *row = _history + axis * _window;
+    const size_t bins = _window / 2;
+
+    // time domain moments; the ring is analysed in storage order, which
+    // is only a rotation of the window and leaves every moment unchanged
+    int32_t sum = 0;
+    for (size_t i = 0; i < _window; i++) {
+        sum += row[i];
+    }
+    int32_t mean = sum / (int32_t)_window;
+
+    int64_t m2 = 0;
+    float m4 = 0.0f;
+    for (size_t i = 0; i < _window; i++) {
+        int32_t d = row[i] - mean;
+        int32_t d2 = d * d;
+        m2 += d2;
+        m4 += (float)d2 * (float)d2;
+    }
+    float variance = (float)m2 / _window;
+    out.rms = sqrtf(variance) * _config.scale;
+    out.kurtosis = variance > 0.0f ? (m4 / _window) / (variance * variance) : 0.0f;
+
+    // the spectrum needs chronological order for the window function
+    for (size_t i = 0; i < _window; i++) {
+        int32_t d = row[(_write + i) & (_window - 1)] - mean;
+        _scratch[i] = (int16_t)((d * _hann[i]) >> WINDOW_SHIFT);
+    }
+    _fft.forward(_scratch, _spectrum);
+
+    // |X[k]|^2 * 2 / n^2 is the mean square of a one-sided bin; undo the
+    // FFT output scaling, the halving above and the window power
+    const float unit = 2.0f * (float)(1 << (2 * (WINDOW_SHIFT - 15)))
+                       / (float)(1 << (2 * FixedRealFftBase::OUTPUT_SHIFT))
+                       / HANN_POWER * _config.scale * _config.scale;
+    const float bin_hz = _config.sample_rate_hz / _window;
+
+    float band[VIBRATION_MAX_BANDS] = {0};
+    float best = -1.0f;
+    float peak_hz = 0.0f;
+    float left = 0.0f, centre = 0.0f, right = 0.0f;
+    float prev = 0.0f;
+    bool after_peak = false;
+
+    for (size_t k = 1; k < bins; k++) {
+        int64_t re = _spectrum[2 * k];
+        int64_t im = _spectrum[2 * k + 1];
+        float power = (float)(re * re + im * im);
+
+        float hz = k * bin_hz;
+        for (size_t b = 0; b < _config.band_count; b++) {
+            if (hz >= _config.bands[b].low_hz && hz < _config.bands[b].high_hz) {
+                band[b] += power;
+            }
+        }
+
+        if (after_peak) {
+            right = power;
+            after_peak = false;
+        }
+        if (power > best) {
+            best = power;
+            peak_hz = hz;
+            left = prev;
+            centre = power;
+            right = 0.0f;
+            after_peak = true;
+        }
+        prev = power;
+    }
+
+    for (size_t b = 0; b < VIBRATION_MAX_BANDS; b++) {
+        out.band_energy[b] = b < _config.band_count ? band[b] * unit : 0.0f;
+    }
+
+    // parabolic interpolation on the magnitudes around the peak; the Hann
+    // main lobe spreads a line over three bins, all count for its RMS
+    float l = sqrtf(left), c = sqrtf(centre), r = sqrtf(right);
+    float denominator = l - 2.0f * c + r;
+    float offset = denominator != 0.0f ? 0.5f * (l - r) / denominator : 0.0f;
+    out.peak_hz = peak_hz + offset * bin_hz;
+    out.peak_rms = sqrtf((left + centre + right) * unit);
+}
+
+} // namespace lab
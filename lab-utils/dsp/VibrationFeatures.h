@@ -0,0 +1,155 @@
+#ifndef LAB_VIBRATION_FEATURES_H
+#define LAB_VIBRATION_FEATURES_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FixedRealFft.h"
+
+namespace lab {
+
+static const size_t VIBRATION_MAX_AXES = 6;
+static const size_t VIBRATION_MAX_BANDS = 8;
+
+/** Frequency band [low_hz, high_hz). */
+struct VibrationBand {
+    float low_hz;
+    float high_hz;
+};
+
+struct VibrationConfig {
+    float sample_rate_hz;
+    /** Samples between two analysed windows, at most the window size. */
+    uint16_t hop;
+    /** Physical units per LSB, applied to all amplitudes. */
+    float scale;
+    uint8_t band_count;
+    VibrationBand bands[VIBRATION_MAX_BANDS];
+    /** An axis over either threshold is flagged, 0 disables the check. */
+    float rms_threshold;
+    float kurtosis_threshold;
+};
+
+/** Features of one axis over one window; amplitudes in config units. */
+struct AxisFeatures {
+    /** RMS around the window mean. */
+    float rms;
+    /** Pearson kurtosis, 3 for Gaussian noise, high for impacts. */
+    float kurtosis;
+    /** Strongest spectral line, interpolated between bins. */
+    float peak_hz;
+    float peak_rms;
+    /** Mean square per band, in units squared. */
+    float band_energy[VIBRATION_MAX_BANDS];
+};
+
+struct VibrationFeatures {
+    /** Time of the last sample of the window. */
+    uint32_t timestamp_us;
+    uint16_t sequence;
+    uint8_t axis_count;
+    uint8_t band_count;
+    /** Bit per axis over a threshold. */
+    uint8_t anomaly;
+    AxisFeatures axis[VIBRATION_MAX_AXES];
+};
+
+/**
+ * Sliding-window spectral features of a multi-axis vibration signal.
+ *
+ * Frames of one sample per axis are pushed as they arrive; every hop
+ * samples the last window of each axis is reduced to RMS, kurtosis, the
+ * dominant frequency and band energies. The mean is removed, a Hann
+ * window applied and the spectrum computed with FixedRealFft; the
+ * statistics use integer sums except for the fourth moment.
+ *
+ * When push() returns true, the window behind features() is still in the
+ * history and snippet() can copy the raw samples, e.g. to ship them along
+ * with an anomaly.
+ *
+ * Use the VibrationAnalyzer template below to get the storage.
+ */
+class VibrationAnalyzerBase {
+public:
+    VibrationAnalyzerBase(size_t window, size_t axes, FixedRealFftBase &fft,
+                          int16_t *history, int16_t *hann, int16_t *scratch, int32_t *spectrum);
+
+    /**
+     * @return 0, or -1 if the configuration does not fit the window.
+     */
+    int configure(const VibrationConfig &config);
+
+    /**
+     * Add one sample per axis.
+     *
+     * @return true when a window was analysed and features() updated.
+     */
+    bool push(const int16_t *frame, uint32_t timestamp_us);
+
+    const VibrationFeatures &features() const
+    {
+        return _features;
+    }
+
+    /**
+     * Copy the newest raw samples of one axis, oldest first.
+     *
+     * @return number of samples copied.
+     */
+    size_t snippet(size_t axis, int16_t *dst, size_t max) const;
+
+    /** Drop the history, the next features need a full window. */
+    void reset();
+
+    size_t window() const
+    {
+        return _window;
+    }
+
+private:
+    void analyse(uint32_t timestamp_us);
+    void analyse_axis(size_t axis, AxisFeatures &out);
+
+    size_t _window;
+    size_t _axes;
+    FixedRealFftBase &_fft;
+    int16_t *_history;
+    int16_t *_hann;
+    int16_t *_scratch;
+    int32_t *_spectrum;
+    VibrationConfig _config;
+    VibrationFeatures _features;
+    size_t _write;
+    size_t _filled;
+    size_t _since_hop;
+    uint16_t _sequence;
+};
+
+/**
+ * Analyzer with static storage.
+ *
+ * @tparam Window samples per window, a power of two from 16 to 1024.
+ * @tparam Axes interleaved axes in each frame.
+ */
+template<size_t Window, size_t Axes>
+class VibrationAnalyzer : public VibrationAnalyzerBase {
+    static_assert(Window >= 16 && Window <= 1024, "VibrationAnalyzer window is 16 to 1024 samples");
+    static_assert(Axes >= 1 && Axes <= VIBRATION_MAX_AXES, "VibrationAnalyzer handles 1 to 6 axes");
+
+public:
+    VibrationAnalyzer() :
+        VibrationAnalyzerBase(Window, Axes, _fft, _history, _hann, _scratch, _spectrum)
+    {
+    }
+
+private:
+    FixedRealFft<Window> _fft;
+    int16_t _history[Window * Axes];
+    int16_t _hann[Window];
+    int16_t _scratch[Window];
+    int32_t _spectrum[Window + 2];
+};
+
+} // namespace lab
+
+#endif // LAB_VIBRATION_FEATURES_H
@@ -0,0 +1,166 @@
+#include "GestureDetector.h"
+
+namespace lab {
+
+const char *input_event_name(InputEventType type)
+{
+    switch (type) {
+        case INPUT_PRESS:
+            return "press";
+        case INPUT_RELEASE:
+            return "release";
+        case INPUT_CLICK:
+            return "click";
+        case INPUT_DOUBLE_CLICK:
+            return "double-click";
+        case INPUT_LONG_PRESS:
+            return "long-press";
+        default:
+            return "unknown";
+    }
+}
+
+GestureConfig default_gesture_config()
+{
+    GestureConfig config;
+    config.debounce_us = 20000;
+    config.long_press_us = 800000;
+    config.double_click_us = 300000;
+    config.active_level = 0;
+    config.leading_edge = true;
+    return config;
+}
+
+GestureDetector::GestureDetector(uint8_t channel, const GestureConfig &config) :
+    _config(config),
+    _channel(channel)
+{
+    reset(!config.active_level, 0);
+}
+
+void GestureDetector::reset(uint8_t level, uint32_t now_us)
+{
+    _stable_level = level ? 1 : 0;
+    _raw_level = _stable_level;
+    _in_burst = false;
+    _burst_start_us = now_us;
+    _last_edge_us = now_us;
+    _press_start_us = now_us;
+    _long_reported = false;
+    _click_pending = false;
+    _click_us = now_us;
+}
+
+size_t GestureDetector::on_edge(const InputEdge &edge, Emitted *out)
+{
+    size_t n = 0;
+    uint8_t level = edge.level ? 1 : 0;
+
+    if (!_in_burst) {
+        _in_burst = true;
+        _burst_start_us = edge.timestamp_us;
+        if (_config.leading_edge && level != _stable_level) {
+            _stable_level = level;
+            n = on_stable_change(edge.timestamp_us, out);
+        }
+    }
+
+    _raw_level = level;
+    _last_edge_us = edge.timestamp_us;
+    return n;
+}
+
+size_t GestureDetector::step(uint32_t now_us, Emitted *out)
+{
+    size_t n = 0;
+
+    // the line has been quiet long enough: whatever level it sits at is real
+    if (_in_burst && (uint32_t)(now_us - _last_edge_us) >= _config.debounce_us) {
+        _in_burst = false;
+        if (_raw_level != _stable_level) {
+            _stable_level = _raw_level;
+            n += on_stable_change(_config.leading_edge ? _last_edge_us : _burst_start_us, out + n);
+        }
+    }
+
+    if (pressed() && !_long_reported && _config.long_press_us != 0 &&
+        (uint32_t)(now_us - _press_start_us) >= _config.long_press_us) {
+        if (_click_pending) {
+            out[n++] = { INPUT_CLICK, _click_us };
+            _click_pending = false;
+        }
+        out[n++] = { INPUT_LONG_PRESS, _press_start_us + _config.long_press_us };
+        _long_reported = true;
+    }
+
+    if (_click_pending && !pressed() &&
+        (uint32_t)(now_us - _click_us) > _config.double_click_us) {
+        out[n++] = { INPUT_CLICK, _click_us };
+        _click_pending = false;
+    }
+
+    return n;
+}
+
+size_t GestureDetector::on_stable_change(uint32_t timestamp_us, Emitted *out)
+{
+    size_t n = 0;
+
+    if (pressed()) {
+        if (_click_pending && (uint32_t)(timestamp_us - _click_us) > _config.double_click_us) {
+            out[n++] = { INPUT_CLICK, _click_us };
+            _click_pending = false;
+        }
+        out[n++] = { INPUT_PRESS, timestamp_us };
+        _press_start_us = timestamp_us;
+        _long_reported = false;
+        return n;
+    }
+
+    out[n++] = { INPUT_RELEASE, timestamp_us };
+    if (_long_reported) {
+        return n;
+    }
+
+    if (_click_pending) {
+        out[n++] = { INPUT_DOUBLE_CLICK, timestamp_us };
+        _click_pending = false;
+    } else if (_config.double_click_us == 0) {
+        out[n++] = { INPUT_CLICK, timestamp_us };
+    } else {
+        _click_pending = true;
+        _click_us = timestamp_us;
+    }
+    return n;
+}
+
+int32_t GestureDetector::next_deadline(uint32_t now_us) const
+{
+    int32_t next = -1;
+    uint32_t elapsed;
+
+    if (_in_burst) {
+        elapsed = now_us - _last_edge_us;
+        next = elapsed >= _config.debounce_us ? 0 : (int32_t)(_config.debounce_us - elapsed);
+    }
+
+    if (pressed() && !_long_reported && _config.long_press_us != 0) {
+        elapsed = now_us - _press_start_us;
+        int32_t wait = elapsed >= _config.long_press_us ? 0 : (int32_t)(_config.long_press_us - elapsed);
+        if (next < 0 || wait < next) {
+            next = wait;
+        }
+    }
+
+    if (_click_pending && !pressed()) {
+        elapsed = now_us - _click_us;
+        int32_t wait = elapsed > _config.double_click_us ? 0 : (int32_t)(_config.double_click_us - elapsed + 1);
+        if (next < 0 || wait < next) {
+            next = wait;
+        }
+    }
+
+    return next;
+}
+
+} // namespace lab
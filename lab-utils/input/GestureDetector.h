@@ -0,0 +1,116 @@
+#ifndef LAB_GESTURE_DETECTOR_H
+#define LAB_GESTURE_DETECTOR_H
+
+#include "InputEvent.h"
+
+namespace lab {
+
+struct GestureConfig {
+    /** Quiet time required before a level is considered stable. */
+    uint32_t debounce_us;
+    /** Hold time after which a press is reported as a long press. */
+    uint32_t long_press_us;
+    /** Maximum gap between two clicks to report a double click, 0 disables it. */
+    uint32_t double_click_us;
+    /** Pin level of the pressed state (0 for buttons with a pull-up). */
+    uint8_t active_level;
+    /**
+     * Report the change on the first edge of a bounce burst instead of
+     * waiting for the line to settle. Lower latency, but a single glitch
+     * shorter than debounce_us is reported as a press/release pair.
+     */
+    bool leading_edge;
+};
+
+/** Defaults tuned for the tactile user buttons of the lab boards. */
+GestureConfig default_gesture_config();
+
+/**
+ * Debounce and gesture state machine for one input line.
+ *
+ * The detector runs in thread context. It only sees timestamped edges, so
+ * it never samples the pin and does not care how late it runs: every
+ * event carries the time of the edge that caused it. All times are
+ * microseconds on a free-running 32-bit counter, wrap-around is handled.
+ */
+class GestureDetector {
+public:
+    GestureDetector(uint8_t channel = 0, const GestureConfig &config = default_gesture_config());
+
+    /** Restart from a known pin level, clears all pending gestures. */
+    void reset(uint8_t level, uint32_t now_us);
+
+    /** Process one raw edge. Edges must be fed in timestamp order. */
+    template<size_t N>
+    void feed(const InputEdge &edge, InputBatch<N> &out)
+    {
+        Emitted e[2 * MAX_STEP_EVENTS];
+        size_t n = step(edge.timestamp_us, e);
+        n += on_edge(edge, e + n);
+        emit(e, n, out);
+    }
+
+    /** Run the timers up to now_us (settle, long press, click expiry). */
+    template<size_t N>
+    void advance(uint32_t now_us, InputBatch<N> &out)
+    {
+        Emitted e[MAX_STEP_EVENTS];
+        size_t n = step(now_us, e);
+        emit(e, n, out);
+    }
+
+    /**
+     * Time until the next timer of this detector expires.
+     *
+     * @return delay in microseconds, or -1 if nothing is pending.
+     */
+    int32_t next_deadline(uint32_t now_us) const;
+
+    bool pressed() const
+    {
+        return _stable_level == _config.active_level;
+    }
+
+    uint8_t channel() const
+    {
+        return _channel;
+    }
+
+private:
+    static const size_t MAX_STEP_EVENTS = 4;
+
+    struct Emitted {
+        InputEventType type;
+        uint32_t timestamp_us;
+    };
+
+    template<size_t N>
+    void emit(const Emitted *e, size_t n, InputBatch<N> &out) const
+    {
+        for (size_t i = 0; i < n; i++) {
+            out.push(_channel, e[i].type, e[i].timestamp_us);
+        }
+    }
+
+    size_t on_edge(const InputEdge &edge, Emitted *out);
+    size_t step(uint32_t now_us, Emitted *out);
+    size_t on_stable_change(uint32_t timestamp_us, Emitted *out);
+
+    GestureConfig _config;
+    uint8_t _channel;
+
+    uint8_t _stable_level;
+    uint8_t _raw_level;
+    bool _in_burst;
+    uint32_t _burst_start_us;
+    uint32_t _last_edge_us;
+
+    uint32_t _press_start_us;
+    bool _long_reported;
+    bool _click_pending;
+    uint32_t _click_us;
+};
+
+} // namespace lab
+
+#endif // LAB_GESTURE_DETECTOR_H
@@ -0,0 +1,80 @@
+#ifndef LAB_INPUT_EVENT_H
+#define LAB_INPUT_EVENT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** Raw edge captured in interrupt context. */
+struct InputEdge {
+    uint32_t timestamp_us;
+    uint8_t level;
+};
+
+enum InputEventType : uint8_t {
+    INPUT_PRESS = 0,
+    INPUT_RELEASE,
+    INPUT_CLICK,        /* short press not followed by a second one */
+    INPUT_DOUBLE_CLICK,
+    INPUT_LONG_PRESS,
+};
+
+/** Debounced event delivered to subscribers. */
+struct InputEvent {
+    uint32_t timestamp_us;
+    uint8_t channel;
+    InputEventType type;
+};
+
+/**
+ * Fixed capacity list of events produced by one processing pass.
+ */
+template<size_t N>
+class InputBatch {
+public:
+    InputBatch() : _count(0), _overflow(0) {}
+
+    void push(uint8_t channel, InputEventType type, uint32_t timestamp_us)
+    {
+        if (_count == N) {
+            _overflow++;
+            return;
+        }
+        _events[_count].timestamp_us = timestamp_us;
+        _events[_count].channel = channel;
+        _events[_count].type = type;
+        _count++;
+    }
+
+    void clear()
+    {
+        _count = 0;
+    }
+
+    const InputEvent *data() const
+    {
+        return _events;
+    }
+
+    size_t size() const
+    {
+        return _count;
+    }
+
+    uint32_t overflow() const
+    {
+        return _overflow;
+    }
+
+private:
+    InputEvent _events[N];
+    size_t _count;
+    uint32_t _overflow;
+};
+
+const char *input_event_name(InputEventType type);
+
+} // namespace lab
+
+#endif // LAB_INPUT_EVENT_H
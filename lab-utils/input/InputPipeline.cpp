@@ -0,0 +1,144 @@
+#include "InputPipeline.h"
+
+#include "hal/us_ticker_api.h"
+
+using namespace std::chrono;
+
+namespace lab {
+
+InputPipeline::InputPipeline(events::EventQueue &queue) :
+    _queue(queue),
+    _channel_count(0),
+    _subscriber_count(0),
+    _process_pending(false),
+    _timer_id(0)
+{
+}
+
+InputPipeline::~InputPipeline()
+{
+    for (size_t i = 0; i < _channel_count; i++) {
+        _channels[i].pin->rise(nullptr);
+        _channels[i].pin->fall(nullptr);
+    }
+    if (_timer_id) {
+        _queue.cancel(_timer_id);
+    }
+}
+
+int InputPipeline::attach(mbed::InterruptIn &pin, const GestureConfig &config)
+{
+    if (_channel_count == MAX_CHANNELS) {
+        return -1;
+    }
+
+    uint8_t id = _channel_count;
+    Channel &channel = _channels[id];
+    channel.owner = this;
+    channel.pin = &pin;
+    channel.detector = GestureDetector(id, config);
+    channel.detector.reset(pin.read(), us_ticker_read());
+    _channel_count++;
+
+    pin.rise(mbed::callback(&InputPipeline::on_rise, &channel));
+    pin.fall(mbed::callback(&InputPipeline::on_fall, &channel));
+    return id;
+}
+
+bool InputPipeline::subscribe(Subscriber subscriber)
+{
+    if (_subscriber_count == MAX_SUBSCRIBERS) {
+        return false;
+    }
+    _subscribers[_subscriber_count++] = subscriber;
+    return true;
+}
+
+uint32_t InputPipeline::dropped_edges() const
+{
+    uint32_t dropped = 0;
+    for (size_t i = 0; i < _channel_count; i++) {
+        dropped += _channels[i].edges.dropped();
+    }
+    return dropped;
+}
+
+void InputPipeline::on_rise(Channel *channel)
+{
+    channel->owner->capture(channel, 1);
+}
+
+void InputPipeline::on_fall(Channel *channel)
+{
+    channel->owner->capture(channel, 0);
+}
+
+void InputPipeline::capture(Channel *channel, uint8_t level)
+{
+    InputEdge edge = { us_ticker_read(), level };
+    channel->edges.push(edge);
+
+    // one queued pass drains every edge, so a burst of bounces costs a single event
+    if (!_process_pending.exchange(true, std::memory_order_acq_rel)) {
+        if (_queue.call(this, &InputPipeline::process) == 0) {
+            _process_pending.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void InputPipeline::process()
+{
+    _process_pending.store(false, std::memory_order_release);
+    if (_timer_id) {
+        _queue.cancel(_timer_id);
+        _timer_id = 0;
+    }
+
+    InputEdge edges[EDGE_RING_SIZE];
+    _batch.clear();
+
+    // before the drain: an edge stamped after it is not popped yet but
+    // carries a time >= now, so advance(now) never settles past an edge
+    // the detector has not seen
+    uint32_t now = us_ticker_read();
+    for (size_t i = 0; i < _channel_count; i++) {
+        Channel &channel = _channels[i];
+        size_t count = channel.edges.pop_batch(edges, EDGE_RING_SIZE);
+        for (size_t j = 0; j < count; j++) {
+            channel.detector.feed(edges[j], _batch);
+        }
+    }
+
+    for (size_t i = 0; i < _channel_count; i++) {
+        _channels[i].detector.advance(now, _batch);
+    }
+
+    if (_batch.size()) {
+        for (size_t i = 0; i < _subscriber_count; i++) {
+            _subscribers[i](_batch.data(), _batch.size());
+        }
+    }
+
+    schedule_timer(now);
+}
+
+void InputPipeline::schedule_timer(uint32_t now_us)
+{
+    int32_t next = -1;
+    for (size_t i = 0; i < _channel_count; i++) {
+        int32_t wait = _channels[i].detector.next_deadline(now_us);
+        if (wait >= 0 && (next < 0 || wait < next)) {
+            next = wait;
+        }
+    }
+
+    if (next < 0) {
+        return;
+    }
+
+    // round up so the timer never fires before the deadline it waits for
+    milliseconds delay((next + 999) / 1000);
+    _timer_id = _queue.call_in(delay, this, &InputPipeline::process);
+}
+
+} // namespace lab
@@ -0,0 +1,86 @@
+#ifndef LAB_INPUT_PIPELINE_H
+#define LAB_INPUT_PIPELINE_H
+
+#include <atomic>
+
+#include "mbed.h"
+#include "events/EventQueue.h"
+
+#include "GestureDetector.h"
+#include "InputEvent.h"
+#include "SpscRing.h"
+
+namespace lab {
+
+/**
+ * Debounced, timestamped input events for InterruptIn lines.
+ *
+ * The rise/fall handlers only stamp the edge into a per-line lock-free
+ * ring and post a single processing event to the queue; they never
+ * disable the interrupt, so no press is lost while a previous one is
+ * still being handled. The debounce and gesture state machines run from
+ * the event queue, and everything produced in one pass is handed to each
+ * subscriber as one batch.
+ */
+class InputPipeline : private mbed::NonCopyable<InputPipeline> {
+public:
+    static const size_t MAX_CHANNELS = 4;
+    static const size_t MAX_SUBSCRIBERS = 4;
+    static const size_t EDGE_RING_SIZE = 32;
+    static const size_t MAX_BATCH = 16;
+
+    typedef mbed::Callback<void(const InputEvent *events, size_t count)> Subscriber;
+
+    InputPipeline(events::EventQueue &queue);
+
+    ~InputPipeline();
+
+    /**
+     * Start capturing edges of a pin.
+     *
+     * @param[in] pin Interrupt line, rise and fall handlers are taken over.
+     * @param[in] config Debounce and gesture timings for this line.
+     *
+     * @return channel number reported in the events, or -1 if all channels
+     * are in use.
+     */
+    int attach(mbed::InterruptIn &pin, const GestureConfig &config = default_gesture_config());
+
+    /**
+     * Register a batch consumer. Called from the event queue thread.
+     *
+     * @return false if the subscriber table is full.
+     */
+    bool subscribe(Subscriber subscriber);
+
+    /** Edges lost because a channel ring overflowed. */
+    uint32_t dropped_edges() const;
+
+private:
+    struct Channel {
+        InputPipeline *owner;
+        mbed::InterruptIn *pin;
+        GestureDetector detector;
+        SpscRing<InputEdge, EDGE_RING_SIZE> edges;
+    };
+
+    static void on_rise(Channel *channel);
+    static void on_fall(Channel *channel);
+
+    void capture(Channel *channel, uint8_t level);
+    void process();
+    void schedule_timer(uint32_t now_us);
+
+    events::EventQueue &_queue;
+    Channel _channels[MAX_CHANNELS];
+    size_t _channel_count;
+    Subscriber _subscribers[MAX_SUBSCRIBERS];
+    size_t _subscriber_count;
+    InputBatch<MAX_BATCH> _batch;
+    std::atomic<bool> _process_pending;
+    int _timer_id;
+};
+
+} // namespace lab
+
+#endif // LAB_INPUT_PIPELINE_H
@@ -0,0 +1,231 @@
+#include "DeferredLog.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "MpscRing.h"
+
+// the host build's shim has the ticker too, on its real or virtual clock
+#if defined(__MBED__) || defined(MBED_HOST)
+#include "hal/us_ticker_api.h"
+#else
+#include <chrono>
+#endif
+
+namespace lab {
+
+static MpscRing<LogRecord, LAB_LOG_RING_SIZE> log_ring;
+
+static uint32_t log_timestamp()
+{
+#if defined(__MBED__) || defined(MBED_HOST)
+    return us_ticker_read();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void log_commit(uint8_t level, const char *format, const log_arg_t *args, size_t count)
+{
+    LogRecord record;
+    record.format = format;
+    record.timestamp_us = log_timestamp();
+    record.level = level;
+    record.arg_count = count;
+    for (size_t i = 0; i < count; i++) {
+        record.args[i] = args[i];
+    }
+    log_ring.push(record);
+}
+
+bool log_pop(LogRecord &record)
+{
+    return log_ring.pop(record);
+}
+
+uint32_t log_dropped()
+{
+    return log_ring.dropped();
+}
+
+const char *log_level_name(uint8_t level)
+{
+    switch (level) {
+        case LAB_LOG_LEVEL_ERROR:
+            return "E";
+        case LAB_LOG_LEVEL_WARN:
+            return "W";
+        case LAB_LOG_LEVEL_INFO:
+            return "I";
+        case LAB_LOG_LEVEL_DEBUG:
+            return "D";
+        case LAB_LOG_LEVEL_TRACE:
+            return "T";
+        default:
+            return "?";
+    }
+}
+
+/*
+ * Append to a bounded buffer, snprintf style: pos keeps counting past the
+ * end so truncation can be detected, but nothing is written out of bounds.
+ */
+static void append(char *buffer, size_t size, size_t &pos, const char *spec, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void append(char *buffer, size_t size, size_t &pos, const char *spec, ...)
+{
+    va_list ap;
+    va_start(ap, spec);
+    int n = vsnprintf(pos < size ? buffer + pos : nullptr, pos < size ? size - pos : 0, spec, ap);
+    va_end(ap);
+    if (n > 0) {
+        pos += n;
+    }
+}
+
+static float arg_to_float(log_arg_t arg)
+{
+    uint32_t bits = (uint32_t)arg;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+size_t log_format(const LogRecord &record, char *buffer, size_t size)
+{
+    size_t pos = 0;
+    size_t next_arg = 0;
+    const char *p = record.format;
+
+    append(buffer, size, pos, "[%6lu.%06lu] %s ",
+           (unsigned long)(record.timestamp_us / 1000000), (unsigned long)(record.timestamp_us % 1000000),
+           log_level_name(record.level));
+
+    while (*p) {
+        if (*p != '%') {
+            const char *literal = p;
+            while (*p && *p != '%') {
+                p++;
+            }
+            append(buffer, size, pos, "%.*s", (int)(p - literal), literal);
+            continue;
+        }
+
+        if (p[1] == '%') {
+            append(buffer, size, pos, "%%");
+            p += 2;
+            continue;
+        }
+
+        // rebuild the conversion without its length modifier, the stored
+        // argument width is fixed
+        char spec[16];
+        size_t len = 0;
+        spec[len++] = *p++;
+        while (*p && strchr("-+ #0123456789.", *p) && len < sizeof(spec) - 3) {
+            spec[len++] = *p++;
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;
+        }
+        char conversion = *p ? *p++ : 0;
+        if (!conversion) {
+            break;
+        }
+
+        if (next_arg >= record.arg_count) {
+            append(buffer, size, pos, "<?>");
+            continue;
+        }
+        log_arg_t arg = record.args[next_arg++];
+
+        switch (conversion) {
+            case 'd':
+            case 'i':
+                spec[len++] = 'l';
+                spec[len++] = conversion;
+                spec[len] = 0;
+                append(buffer, size, pos, spec, (long)(intptr_t)arg);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                spec[len++] = 'l';
+                spec[len++] = conversion;
+                spec[len] = 0;
+                append(buffer, size, pos, spec, (unsigned long)arg);
+                break;
+            case 'c':
+                spec[len++] = 'c';
+                spec[len] = 0;
+                append(buffer, size, pos, spec, (int)arg);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                spec[len++] = conversion;
+                spec[len] = 0;
+                append(buffer, size, pos, spec, (double)arg_to_float(arg));
+                break;
+            case 's':
+                spec[len++] = 's';
+                spec[len] = 0;
+                append(buffer, size, pos, spec, arg ? (const char *)arg : "(null)");
+                break;
+            case 'p':
+                append(buffer, size, pos, "%p", (void *)arg);
+                break;
+            default:
+                append(buffer, size, pos, "<%%%c?>", conversion);
+                break;
+        }
+    }
+
+    // formats carried over from printf often end with their own newline
+    if (pos == 0 || pos >= size || buffer[pos - 1] != '\n') {
+        append(buffer, size, pos, "\n");
+    }
+
+    if (pos >= size) {
+        // keep the line terminated even when truncated
+        if (size >= 2) {
+            buffer[size - 2] = '\n';
+            buffer[size - 1] = 0;
+        }
+        return size ? size - 1 : 0;
+    }
+    return pos;
+}
+
+static void put_u32(uint8_t *p, uint32_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    p[2] = value >> 16;
+    p[3] = value >> 24;
+}
+
+size_t log_encode(const LogRecord &record, uint8_t *buffer, size_t size)
+{
+    size_t len = 10 + 4 * record.arg_count;
+    if (size < len) {
+        return 0;
+    }
+
+    buffer[0] = LOG_FRAME_SYNC;
+    buffer[1] = (record.level << 4) | (record.arg_count & 0x0F);
+    put_u32(buffer + 2, (uint32_t)(uintptr_t)record.format);
+    put_u32(buffer + 6, record.timestamp_us);
+    for (size_t i = 0; i < record.arg_count; i++) {
+        put_u32(buffer + 10 + 4 * i, (uint32_t)record.args[i]);
+    }
+    return len;
+}
+
+} // namespace lab
@@ -0,0 +1,152 @@
+#ifndef LAB_DEFERRED_LOG_H
+#define LAB_DEFERRED_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#define LAB_LOG_LEVEL_NONE  0
+#define LAB_LOG_LEVEL_ERROR 1
+#define LAB_LOG_LEVEL_WARN  2
+#define LAB_LOG_LEVEL_INFO  3
+#define LAB_LOG_LEVEL_DEBUG 4
+#define LAB_LOG_LEVEL_TRACE 5
+
+#ifndef LAB_LOG_LEVEL
+#ifdef MBED_CONF_LAB_UTILS_LOG_LEVEL
+#define LAB_LOG_LEVEL MBED_CONF_LAB_UTILS_LOG_LEVEL
+#else
+#define LAB_LOG_LEVEL LAB_LOG_LEVEL_INFO
+#endif
+#endif
+
+#ifdef MBED_CONF_LAB_UTILS_LOG_RING_SIZE
+#define LAB_LOG_RING_SIZE MBED_CONF_LAB_UTILS_LOG_RING_SIZE
+#else
+#define LAB_LOG_RING_SIZE 64
+#endif
+
+#define LAB_LOG_MAX_ARGS 6
+
+/*
+ * Logging macros. The format must be a string literal: only its address
+ * and the raw arguments are recorded, formatting happens later in the log
+ * thread or on the host. For the same reason %s arguments must point to
+ * storage that outlives the record (string literals, static tables).
+ * Statements below LAB_LOG_LEVEL compile to nothing, arguments included.
+ */
+#define LAB_LOG_RECORD(level, fmt, ...) ::lab::log_write(level, "" fmt, ##__VA_ARGS__)
+
+#if LAB_LOG_LEVEL >= LAB_LOG_LEVEL_ERROR
+#define LAB_LOG_ERROR(fmt, ...) LAB_LOG_RECORD(LAB_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LAB_LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+
+#if LAB_LOG_LEVEL >= LAB_LOG_LEVEL_WARN
+#define LAB_LOG_WARN(fmt, ...) LAB_LOG_RECORD(LAB_LOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LAB_LOG_WARN(fmt, ...) do {} while (0)
+#endif
+
+#if LAB_LOG_LEVEL >= LAB_LOG_LEVEL_INFO
+#define LAB_LOG_INFO(fmt, ...) LAB_LOG_RECORD(LAB_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LAB_LOG_INFO(fmt, ...) do {} while (0)
+#endif
+
+#if LAB_LOG_LEVEL >= LAB_LOG_LEVEL_DEBUG
+#define LAB_LOG_DEBUG(fmt, ...) LAB_LOG_RECORD(LAB_LOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LAB_LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
+
+#if LAB_LOG_LEVEL >= LAB_LOG_LEVEL_TRACE
+#define LAB_LOG_TRACE(fmt, ...) LAB_LOG_RECORD(LAB_LOG_LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#else
+#define LAB_LOG_TRACE(fmt, ...) do {} while (0)
+#endif
+
+namespace lab {
+
+typedef uintptr_t log_arg_t;
+
+/** One deferred log statement, as stored in the ring. */
+struct LogRecord {
+    const char *format;
+    uint32_t timestamp_us;
+    uint8_t level;
+    uint8_t arg_count;
+    log_arg_t args[LAB_LOG_MAX_ARGS];
+};
+
+/** Size of the largest frame produced by log_encode(). */
+const size_t LOG_FRAME_MAX = 10 + 4 * LAB_LOG_MAX_ARGS;
+
+/** Frame start marker of the binary log stream. */
+const uint8_t LOG_FRAME_SYNC = 0xA5;
+
+/** Store a record. Lock-free, callable from interrupt context. */
+void log_commit(uint8_t level, const char *format, const log_arg_t *args, size_t count);
+
+/** Take the oldest record, single consumer. */
+bool log_pop(LogRecord &record);
+
+/** Records lost because the ring was full. */
+uint32_t log_dropped();
+
+/**
+ * Render a record as one text line, newline included.
+ *
+ * @return number of characters written, excluding the terminating null.
+ */
+size_t log_format(const LogRecord &record, char *buffer, size_t size);
+
+/**
+ * Encode a record as a binary frame for log_decode.py.
+ *
+ * Layout, little endian: sync byte, (level << 4 | arg count), format
+ * address (u32), timestamp (u32), arguments (u32 each).
+ *
+ * @return frame length in bytes, 0 if the buffer is too small.
+ */
+size_t log_encode(const LogRecord &record, uint8_t *buffer, size_t size);
+
+const char *log_level_name(uint8_t level);
+
+/* Argument capture: integers widen, floating point keeps the float bits. */
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value, log_arg_t>::type
+log_arg(T value)
+{
+    return (log_arg_t)value;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, log_arg_t>::type
+log_arg(T value)
+{
+    float f = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+template<typename T>
+inline log_arg_t log_arg(const T *value)
+{
+    return (log_arg_t)value;
+}
+
+template<typename... Args>
+inline void log_write(uint8_t level, const char *format, Args... args)
+{
+    static_assert(sizeof...(Args) <= LAB_LOG_MAX_ARGS, "too many arguments for a deferred log record");
+    const log_arg_t raw[sizeof...(Args) + 1] = { log_arg(args)..., 0 };
+    log_commit(level, format, raw, sizeof...(Args));
+}
+
+} // namespace lab
+
+#endif // LAB_DEFERRED_LOG_H
@@ -0,0 +1,60 @@
+#include "LogThread.h"
+
+namespace lab {
+
+LogThread::LogThread(mbed::FileHandle &output, Mode mode, osPriority priority, uint32_t stack_size) :
+    _output(output),
+    _mode(mode),
+    _thread(priority, stack_size, nullptr, "log"),
+    _period(20),
+    _reported_drops(0)
+{
+}
+
+osStatus LogThread::start(std::chrono::milliseconds period)
+{
+    _period = period;
+    return _thread.start(mbed::callback(this, &LogThread::run));
+}
+
+void LogThread::flush()
+{
+    LogRecord record;
+
+    _mutex.lock();
+    while (log_pop(record)) {
+        write_record(record);
+    }
+
+    uint32_t drops = log_dropped();
+    if (drops != _reported_drops) {
+        if (_mode == TEXT) {
+            int len = snprintf(_line, sizeof(_line), "[log] %lu records dropped\n",
+                               (unsigned long)(drops - _reported_drops));
+            _output.write(_line, len);
+        }
+        _reported_drops = drops;
+    }
+    _mutex.unlock();
+}
+
+void LogThread::run()
+{
+    while (true) {
+        flush();
+        rtos::ThisThread::sleep_for(_period);
+    }
+}
+
+void LogThread::write_record(const LogRecord &record)
+{
+    size_t len;
+    if (_mode == BINARY) {
+        len = log_encode(record, (uint8_t *)_line, sizeof(_line));
+    } else {
+        len = log_format(record, _line, sizeof(_line));
+    }
+    _output.write(_line, len);
+}
+
+} // namespace lab
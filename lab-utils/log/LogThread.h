@@ -0,0 +1,50 @@
+#ifndef LAB_LOG_THREAD_H
+#define LAB_LOG_THREAD_H
+
+#include "mbed.h"
+
+#include "DeferredLog.h"
+
+namespace lab {
+
+/**
+ * Low priority consumer of the deferred log.
+ *
+ * Periodically drains the record ring and writes it to a FileHandle
+ * (usually the BufferedSerial console), either formatted as text or as
+ * binary frames to be decoded on the host by log_decode.py. Formatting
+ * and UART time are paid here, never at the call site.
+ */
+class LogThread : private mbed::NonCopyable<LogThread> {
+public:
+    enum Mode {
+        TEXT,
+        BINARY,
+    };
+
+    LogThread(mbed::FileHandle &output,
+              Mode mode = TEXT,
+              osPriority priority = osPriorityLow,
+              uint32_t stack_size = 1536);
+
+    osStatus start(std::chrono::milliseconds period = std::chrono::milliseconds(20));
+
+    /** Drain everything pending right now, from the calling thread. */
+    void flush();
+
+private:
+    void run();
+    void write_record(const LogRecord &record);
+
+    mbed::FileHandle &_output;
+    Mode _mode;
+    rtos::Thread _thread;
+    std::chrono::milliseconds _period;
+    rtos::Mutex _mutex;
+    uint32_t _reported_drops;
+    char _line[128];
+};
+
+} // namespace lab
+
+#endif // LAB_LOG_THREAD_H
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Decode the binary deferred log stream of a lab application.
+
+The firmware only sends the address of each format string plus the raw
+arguments (see log_encode() in DeferredLog.cpp). The strings are looked up
+in the ELF image that was flashed.
+
+    python3 log_decode.py BUILD/.../app.elf /dev/ttyACM0 --baud 115200
+    python3 log_decode.py BUILD/.../app.elf capture.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+FRAME_SYNC = 0xA5
+HEADER_LEN = 10
+LEVELS = {1: 'E', 2: 'W', 3: 'I', 4: 'D', 5: 'T'}
+SPEC = re.compile(r'%([-+ #0]*\d*(?:\.\d+)?)(hh|h|ll|l|L|q|j|z|t)?([diouxXeEfFgGcsp%])')
+
+
+class StringTable:
+    def __init__(self, path):
+        self._sections = []
+        self._cache = {}
+        with open(path, 'rb') as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                if section['sh_addr'] and section['sh_type'] == 'SHT_PROGBITS':
+                    self._sections.append((section['sh_addr'], section.data()))
+
+    def string_at(self, address):
+        if address in self._cache:
+            return self._cache[address]
+        for base, data in self._sections:
+            if base <= address < base + len(data):
+                start = address - base
+                end = data.find(b'\0', start)
+                value = data[start:end if end >= 0 else len(data)].decode('utf-8', 'replace')
+                self._cache[address] = value
+                return value
+        return None
+
+
+def render(fmt, args, strings):
+    args = list(args)
+
+    def convert(match):
+        flags, _, conversion = match.groups()
+        if conversion == '%':
+            return '%'
+        if not args:
+            return '<?>'
+        raw = args.pop(0)
+        if conversion in 'di':
+            return ('%' + flags + 'd') % struct.unpack('<i', struct.pack('<I', raw))[0]
+        if conversion == 'u':
+            return ('%' + flags + 'd') % raw
+        if conversion in 'xXoc':
+            return ('%' + flags + conversion) % raw
+        if conversion in 'eEfFgG':
+            return ('%' + flags + conversion) % struct.unpack('<f', struct.pack('<I', raw))[0]
+        if conversion == 's':
+            return ('%' + flags + 's') % (strings.string_at(raw) or '<0x%08x>' % raw)
+        return '0x%08x' % raw
+
+    return SPEC.sub(convert, fmt)
+
+
+def frames(stream, is_valid):
+    """Split the stream into frames, resynchronising on the sync byte."""
+    buffer = b''
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            return
+        buffer += chunk
+        while True:
+            start = buffer.find(bytes([FRAME_SYNC]))
+            if start < 0:
+                buffer = b''
+                break
+            buffer = buffer[start:]
+            if len(buffer) < HEADER_LEN:
+                break
+            count = buffer[1] & 0x0F
+            length = HEADER_LEN + 4 * count
+            if len(buffer) < length:
+                break
+            if not is_valid(buffer[:length]):
+                # the sync byte was payload, not a frame start
+                buffer = buffer[1:]
+                continue
+            yield buffer[:length]
+            buffer = buffer[length:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('elf', help='ELF image the board is running')
+    parser.add_argument('source', help='serial port or capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    options = parser.parse_args()
+
+    strings = StringTable(options.elf)
+
+    if options.source.startswith('/dev/') or options.source.upper().startswith('COM'):
+        import serial
+        stream = serial.Serial(options.source, options.baud, timeout=1)
+    else:
+        stream = open(options.source, 'rb')
+
+    def is_valid(frame):
+        address = struct.unpack_from('<I', frame, 2)[0]
+        return (frame[1] >> 4) in LEVELS and strings.string_at(address) is not None
+
+    for frame in frames(stream, is_valid):
+        level = frame[1] >> 4
+        count = frame[1] & 0x0F
+        address, timestamp = struct.unpack_from('<II', frame, 2)
+        args = struct.unpack_from('<%dI' % count, frame, HEADER_LEN)
+        fmt = strings.string_at(address)
+        line = render(fmt, args, strings)
+        sys.stdout.write('[%6d.%06d] %s %s' % (timestamp // 1000000, timestamp % 1000000, LEVELS[level], line))
+        if not line.endswith('\n'):
+            sys.stdout.write('\n')
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,82 @@
+#include "BlockPool.h"
+
+namespace lab {
+
+static inline uint32_t make_head(uint16_t tag, uint16_t index)
+{
+    return ((uint32_t)tag << 16) | index;
+}
+
+BlockPoolBase::BlockPoolBase(void *storage, size_t block_size, size_t count) :
+    _storage(static_cast<uint8_t *>(storage)),
+    _block_size(block_size < sizeof(uint16_t) ? sizeof(uint16_t) : block_size),
+    _count(count < NIL ? count : NIL - 1),
+    _head(0),
+    _in_use(0),
+    _high_water(0),
+    _failures(0)
+{
+    for (size_t i = 0; i < _count; i++) {
+        next_of(i) = (i + 1 < _count) ? i + 1 : NIL;
+    }
+    _head.store(make_head(0, _count ? 0 : NIL), std::memory_order_relaxed);
+}
+
+void *BlockPoolBase::alloc()
+{
+    uint32_t head = _head.load(std::memory_order_acquire);
+    uint16_t index;
+    for (;;) {
+        index = head & 0xFFFF;
+        if (index == NIL) {
+            _failures.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        uint32_t next = make_head((head >> 16) + 1, next_of(index));
+        if (_head.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    uint32_t used = _in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t peak = _high_water.load(std::memory_order_relaxed);
+    while (used > peak && !_high_water.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+
+    return _storage + index * _block_size;
+}
+
+void BlockPoolBase::free(void *block)
+{
+    if (!block) {
+        return;
+    }
+
+    uint16_t index = (static_cast<uint8_t *>(block) - _storage) / _block_size;
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    do {
+        next_of(index) = head & 0xFFFF;
+    } while (!_head.compare_exchange_weak(head, make_head((head >> 16) + 1, index),
+                                          std::memory_order_release, std::memory_order_relaxed));
+
+    _in_use.fetch_sub(1, std::memory_order_relaxed);
+}
+
+PoolStats BlockPoolBase::stats() const
+{
+    PoolStats stats;
+    stats.block_size = _block_size;
+    stats.capacity = _count;
+    stats.in_use = _in_use.load(std::memory_order_relaxed);
+    stats.high_water = _high_water.load(std::memory_order_relaxed);
+    stats.failures = _failures.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void BlockPoolBase::reset_stats()
+{
+    _high_water.store(_in_use.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    _failures.store(0, std::memory_order_relaxed);
+}
+
+} // namespace lab
@@ -0,0 +1,109 @@
+#ifndef LAB_BLOCK_POOL_H
+#define LAB_BLOCK_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** Usage counters of a pool, all in blocks except failures. */
+struct PoolStats {
+    size_t block_size;
+    size_t capacity;
+    size_t in_use;
+    size_t high_water;
+    uint32_t failures;
+};
+
+/**
+ * Fixed-size block allocator over caller provided storage.
+ *
+ * Free blocks form a lock-free stack. The head packs a 16-bit block index
+ * with a 16-bit generation tag, so a thread preempted in the middle of
+ * alloc() cannot be fooled by an interrupt that pops and pushes the same
+ * block back (ABA). alloc() and free() are constant time and can be
+ * called from interrupt context.
+ *
+ * Use the BlockPool template below to get the storage statically
+ * allocated with the pool.
+ */
+class BlockPoolBase {
+public:
+    /**
+     * @param[in] storage Memory for count blocks of block_size bytes,
+     * aligned for the largest type stored.
+     * @param[in] block_size Size of a block, at least sizeof(uint16_t).
+     * @param[in] count Number of blocks, at most 65535.
+     */
+    BlockPoolBase(void *storage, size_t block_size, size_t count);
+
+    /** @return a block, or nullptr if the pool is exhausted. */
+    void *alloc();
+
+    /** Return a block obtained from alloc() of this pool. */
+    void free(void *block);
+
+    /** True if ptr points into the storage of this pool. */
+    bool owns(const void *ptr) const
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(ptr);
+        return p >= _storage && p < _storage + _block_size * _count;
+    }
+
+    size_t block_size() const
+    {
+        return _block_size;
+    }
+
+    size_t capacity() const
+    {
+        return _count;
+    }
+
+    PoolStats stats() const;
+
+    /** Forget the high-water mark and failure count. */
+    void reset_stats();
+
+private:
+    static const uint16_t NIL = 0xFFFF;
+
+    uint16_t &next_of(uint16_t index)
+    {
+        return *reinterpret_cast<uint16_t *>(_storage + index * _block_size);
+    }
+
+    uint8_t *_storage;
+    size_t _block_size;
+    size_t _count;
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _in_use;
+    std::atomic<uint32_t> _high_water;
+    std::atomic<uint32_t> _failures;
+};
+
+/**
+ * Block pool with statically allocated storage.
+ *
+ * @tparam BlockSize size of each block in bytes, rounded up to keep every
+ * block 8-byte aligned.
+ * @tparam Count number of blocks.
+ */
+template<size_t BlockSize, size_t Count>
+class BlockPool : public BlockPoolBase {
+    static_assert(Count > 0 && Count < 0xFFFF, "BlockPool holds 1 to 65534 blocks");
+
+public:
+    static const size_t BLOCK_SIZE = (BlockSize + 7) & ~size_t(7);
+    static const size_t COUNT = Count;
+
+    BlockPool() : BlockPoolBase(_blocks, BLOCK_SIZE, Count) {}
+
+private:
+    alignas(8) uint8_t _blocks[BLOCK_SIZE * Count];
+};
+
+} // namespace lab
+
+#endif // LAB_BLOCK_POOL_H
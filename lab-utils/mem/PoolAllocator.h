@@ -0,0 +1,188 @@
+#ifndef LAB_POOL_ALLOCATOR_H
+#define LAB_POOL_ALLOCATOR_H
+
+#include <new>
+
+#include "BlockPool.h"
+
+namespace lab {
+
+/**
+ * Routes variable size requests to a family of block pools.
+ *
+ * Pools are kept sorted by block size; a request is served by the
+ * smallest pool whose blocks are large enough and that still has a free
+ * block, so a burst on a small size class spills into the next one
+ * instead of failing. Nothing falls back to the heap.
+ */
+class PoolAllocator {
+public:
+    static const size_t MAX_CLASSES = 6;
+
+    PoolAllocator() : _count(0) {}
+
+    /**
+     * Register a size class. Pools may be added in any order.
+     *
+     * @return false if the table is full.
+     */
+    bool add(BlockPoolBase &pool)
+    {
+        if (_count == MAX_CLASSES) {
+            return false;
+        }
+        size_t i = _count++;
+        while (i > 0 && _pools[i - 1]->block_size() > pool.block_size()) {
+            _pools[i] = _pools[i - 1];
+            i--;
+        }
+        _pools[i] = &pool;
+        return true;
+    }
+
+    /** @return a block of at least size bytes, or nullptr. ISR safe. */
+    void *alloc(size_t size)
+    {
+        for (size_t i = 0; i < _count; i++) {
+            if (_pools[i]->block_size() >= size) {
+                void *block = _pools[i]->alloc();
+                if (block) {
+                    return block;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    /** Return a block to the pool it came from. ISR safe. */
+    void free(void *block)
+    {
+        for (size_t i = 0; block && i < _count; i++) {
+            if (_pools[i]->owns(block)) {
+                _pools[i]->free(block);
+                return;
+            }
+        }
+    }
+
+    size_t classes() const
+    {
+        return _count;
+    }
+
+    const BlockPoolBase &pool(size_t index) const
+    {
+        return *_pools[index];
+    }
+
+private:
+    BlockPoolBase *_pools[MAX_CLASSES];
+    size_t _count;
+};
+
+/**
+ * Owning handle on a pool block, released when it goes out of scope.
+ */
+class PoolBuffer {
+public:
+    PoolBuffer(PoolAllocator &allocator, size_t size) :
+        _allocator(allocator),
+        _data(allocator.alloc(size)),
+        _size(_data ? size : 0)
+    {
+    }
+
+    ~PoolBuffer()
+    {
+        _allocator.free(_data);
+    }
+
+    PoolBuffer(const PoolBuffer &) = delete;
+    PoolBuffer &operator=(const PoolBuffer &) = delete;
+
+    explicit operator bool() const
+    {
+        return _data != nullptr;
+    }
+
+    template<typename T>
+    T *as()
+    {
+        return static_cast<T *>(_data);
+    }
+
+    void *data()
+    {
+        return _data;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /** Give up ownership; the block then goes back through PoolAllocator::free(). */
+    void *release()
+    {
+        void *data = _data;
+        _data = nullptr;
+        _size = 0;
+        return data;
+    }
+
+private:
+    PoolAllocator &_allocator;
+    void *_data;
+    size_t _size;
+};
+
+/**
+ * Array of objects constructed in a pool block.
+ */
+template<typename T>
+class PoolArray {
+public:
+    PoolArray(PoolAllocator &allocator, size_t count) :
+        _buffer(allocator, count * sizeof(T)),
+        _count(_buffer ? count : 0)
+    {
+        for (size_t i = 0; i < _count; i++) {
+            new (_buffer.as<T>() + i) T();
+        }
+    }
+
+    ~PoolArray()
+    {
+        for (size_t i = 0; i < _count; i++) {
+            _buffer.as<T>()[i].~T();
+        }
+    }
+
+    explicit operator bool() const
+    {
+        return static_cast<bool>(_buffer);
+    }
+
+    T *data()
+    {
+        return _buffer.as<T>();
+    }
+
+    T &operator[](size_t index)
+    {
+        return _buffer.as<T>()[index];
+    }
+
+    size_t size() const
+    {
+        return _count;
+    }
+
+private:
+    PoolBuffer _buffer;
+    size_t _count;
+};
+
+} // namespace lab
+
+#endif // LAB_POOL_ALLOCATOR_H
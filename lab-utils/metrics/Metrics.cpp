@@ -0,0 +1,250 @@
+#include "Metrics.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace lab {
+
+namespace {
+
+// zero-initialised before any constructor runs, so metrics may register
+// from static constructors in any order
+Metric *metrics[MetricsRegistry::MAX_METRICS];
+std::atomic<size_t> metric_count;
+
+const uint8_t ENCODING_MAGIC = 'M';
+const uint8_t ENCODING_VERSION = 1;
+
+/** snprintf that keeps track of the position and of overflow. */
+class Writer {
+public:
+    Writer(char *dst, size_t capacity) :
+        _dst(dst),
+        _capacity(capacity),
+        _length(0)
+    {
+    }
+
+    template<typename... Args>
+    void print(const char *format, Args... args)
+    {
+        if (_length < 0) {
+            return;
+        }
+        int n = snprintf(_dst + _length, _capacity - _length, format, args...);
+        _length = n < 0 || (size_t)(_length + n) >= _capacity ? -1 : _length + n;
+    }
+
+    int length() const
+    {
+        return _length;
+    }
+
+private:
+    char *_dst;
+    size_t _capacity;
+    int _length;
+};
+
+class Encoder {
+public:
+    Encoder(uint8_t *dst, size_t capacity) :
+        _dst(dst),
+        _capacity(capacity),
+        _length(0)
+    {
+    }
+
+    void put8(uint8_t value)
+    {
+        if (_length >= 0 && (size_t)_length < _capacity) {
+            _dst[_length++] = value;
+        } else {
+            _length = -1;
+        }
+    }
+
+    void put32(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++) {
+            put8(value >> (8 * i));
+        }
+    }
+
+    int length() const
+    {
+        return _length;
+    }
+
+private:
+    uint8_t *_dst;
+    size_t _capacity;
+    int _length;
+};
+
+} // namespace
+
+Metric::Metric(const char *name, MetricType type) :
+    _name(name),
+    _type(type)
+{
+    MetricsRegistry::add(*this);
+}
+
+HistogramBase::HistogramBase(const char *name, const uint32_t *bounds, size_t bound_count, std::atomic<uint32_t> *counts) :
+    Metric(name, METRIC_HISTOGRAM),
+    _bounds(bounds),
+    _bound_count(bound_count),
+    _counts(counts),
+    _sum(0)
+{
+}
+
+void HistogramBase::record(uint32_t value)
+{
+    size_t i = 0;
+    while (i < _bound_count && value > _bounds[i]) {
+        i++;
+    }
+    _counts[i].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+bool MetricsRegistry::add(Metric &metric)
+{
+    size_t index = metric_count.load(std::memory_order_relaxed);
+    do {
+        if (index == MAX_METRICS) {
+            return false;
+        }
+    } while (!metric_count.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel));
+    metrics[index] = &metric;
+    return true;
+}
+
+size_t MetricsRegistry::count()
+{
+    return metric_count.load(std::memory_order_acquire);
+}
+
+Metric &MetricsRegistry::metric(size_t index)
+{
+    return *metrics[index];
+}
+
+Metric *MetricsRegistry::find(const char *name)
+{
+    for (size_t i = 0; i < count(); i++) {
+        if (metrics[i] && strcmp(metrics[i]->name(), name) == 0) {
+            return metrics[i];
+        }
+    }
+    return nullptr;
+}
+
+int MetricsRegistry::format_text(char *dst, size_t capacity)
+{
+    Writer out(dst, capacity);
+    for (size_t i = 0; i < count(); i++) {
+        const Metric &m = *metrics[i];
+        switch (m.type()) {
+            case METRIC_COUNTER:
+                out.print("%s %lu\n", m.name(), (unsigned long)static_cast<const Counter &>(m).value());
+                break;
+            case METRIC_GAUGE: {
+                const Gauge &gauge = static_cast<const Gauge &>(m);
+                out.print("%s %ld max %ld\n", m.name(), (long)gauge.value(), (long)gauge.max());
+                break;
+            }
+            case METRIC_HISTOGRAM: {
+                const HistogramBase &histogram = static_cast<const HistogramBase &>(m);
+                out.print("%s sum %lu", m.name(), (unsigned long)histogram.sum());
+                for (size_t b = 0; b < histogram.bound_count(); b++) {
+                    out.print(" le%lu %lu", (unsigned long)histogram.bounds()[b], (unsigned long)histogram.bucket(b));
+                }
+                out.print(" inf %lu\n", (unsigned long)histogram.bucket(histogram.bound_count()));
+                break;
+            }
+        }
+    }
+    return out.length();
+}
+
+int MetricsRegistry::format_json(char *dst, size_t capacity)
+{
+    Writer out(dst, capacity);
+    out.print("{");
+    for (size_t i = 0; i < count(); i++) {
+        const Metric &m = *metrics[i];
+        out.print("%s\"%s\":", i ? "," : "", m.name());
+        switch (m.type()) {
+            case METRIC_COUNTER:
+                out.print("%lu", (unsigned long)static_cast<const Counter &>(m).value());
+                break;
+            case METRIC_GAUGE: {
+                const Gauge &gauge = static_cast<const Gauge &>(m);
+                out.print("[%ld,%ld]", (long)gauge.value(), (long)gauge.max());
+                break;
+            }
+            case METRIC_HISTOGRAM: {
+                const HistogramBase &histogram = static_cast<const HistogramBase &>(m);
+                out.print("{\"b\":[");
+                for (size_t b = 0; b < histogram.bound_count(); b++) {
+                    out.print(b ? ",%lu" : "%lu", (unsigned long)histogram.bounds()[b]);
+                }
+                out.print("],\"c\":[");
+                for (size_t b = 0; b < histogram.bucket_count(); b++) {
+                    out.print(b ? ",%lu" : "%lu", (unsigned long)histogram.bucket(b));
+                }
+                out.print("],\"s\":%lu}", (unsigned long)histogram.sum());
+                break;
+            }
+        }
+    }
+    out.print("}");
+    return out.length();
+}
+
+int MetricsRegistry::encode(uint8_t *dst, size_t capacity)
+{
+    Encoder out(dst, capacity);
+    size_t total = count();
+    out.put8(ENCODING_MAGIC);
+    out.put8(ENCODING_VERSION);
+    out.put8(total);
+    for (size_t i = 0; i < total; i++) {
+        const Metric &m = *metrics[i];
+        size_t name_length = strlen(m.name());
+        out.put8(m.type());
+        out.put8(name_length);
+        for (size_t c = 0; c < name_length; c++) {
+            out.put8(m.name()[c]);
+        }
+        switch (m.type()) {
+            case METRIC_COUNTER:
+                out.put32(static_cast<const Counter &>(m).value());
+                break;
+            case METRIC_GAUGE: {
+                const Gauge &gauge = static_cast<const Gauge &>(m);
+                out.put32(gauge.value());
+                out.put32(gauge.max());
+                break;
+            }
+            case METRIC_HISTOGRAM: {
+                const HistogramBase &histogram = static_cast<const HistogramBase &>(m);
+                out.put8(histogram.bound_count());
+                for (size_t b = 0; b < histogram.bound_count(); b++) {
+                    out.put32(histogram.bounds()[b]);
+                }
+                for (size_t b = 0; b < histogram.bucket_count(); b++) {
+                    out.put32(histogram.bucket(b));
+                }
+                out.put32(histogram.sum());
+                break;
+            }
+        }
+    }
+    return out.length();
+}
+
+} // namespace lab
@@ -0,0 +1,216 @@
+#ifndef LAB_METRICS_H
+#define LAB_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+enum MetricType {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE = 1,
+    METRIC_HISTOGRAM = 2,
+};
+
+/**
+ * Named runtime value, registered with MetricsRegistry on construction.
+ *
+ * Metrics are meant to be static objects; updates are single relaxed
+ * atomic operations, safe from any thread or interrupt, and never take a
+ * lock. A reader sees each value consistent on its own, not a snapshot
+ * of all of them at one instant.
+ */
+class Metric {
+public:
+    const char *name() const
+    {
+        return _name;
+    }
+
+    MetricType type() const
+    {
+        return _type;
+    }
+
+protected:
+    Metric(const char *name, MetricType type);
+    ~Metric() = default;
+
+private:
+    const char *_name;
+    MetricType _type;
+};
+
+/** Monotonic event count, wraps at 2^32; readers work on differences. */
+class Counter : public Metric {
+public:
+    explicit Counter(const char *name) :
+        Metric(name, METRIC_COUNTER),
+        _value(0)
+    {
+    }
+
+    void inc(uint32_t amount = 1)
+    {
+        _value.fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    uint32_t value() const
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint32_t> _value;
+};
+
+/** Current level, e.g. a queue depth, with its high-water mark. */
+class Gauge : public Metric {
+public:
+    explicit Gauge(const char *name) :
+        Metric(name, METRIC_GAUGE),
+        _value(0),
+        _max(INT32_MIN)
+    {
+    }
+
+    void set(int32_t value)
+    {
+        _value.store(value, std::memory_order_relaxed);
+        raise_max(value);
+    }
+
+    void add(int32_t delta)
+    {
+        raise_max(_value.fetch_add(delta, std::memory_order_relaxed) + delta);
+    }
+
+    int32_t value() const
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+    /** Highest value since the last reset_max(), INT32_MIN if never set. */
+    int32_t max() const
+    {
+        return _max.load(std::memory_order_relaxed);
+    }
+
+    void reset_max()
+    {
+        _max.store(value(), std::memory_order_relaxed);
+    }
+
+private:
+    void raise_max(int32_t value)
+    {
+        int32_t seen = _max.load(std::memory_order_relaxed);
+        while (value > seen && !_max.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::atomic<int32_t> _value;
+    std::atomic<int32_t> _max;
+};
+
+/**
+ * Distribution over fixed buckets. Bucket i counts values up to
+ * bounds[i] inclusive, the last bucket everything above the last bound.
+ */
+class HistogramBase : public Metric {
+public:
+    void record(uint32_t value);
+
+    /** Number of buckets, bounds() + 1. */
+    size_t bucket_count() const
+    {
+        return _bound_count + 1;
+    }
+
+    const uint32_t *bounds() const
+    {
+        return _bounds;
+    }
+
+    size_t bound_count() const
+    {
+        return _bound_count;
+    }
+
+    uint32_t bucket(size_t index) const
+    {
+        return _counts[index].load(std::memory_order_relaxed);
+    }
+
+    /** Sum of the recorded values, wraps at 2^32. */
+    uint32_t sum() const
+    {
+        return _sum.load(std::memory_order_relaxed);
+    }
+
+protected:
+    HistogramBase(const char *name, const uint32_t *bounds, size_t bound_count, std::atomic<uint32_t> *counts);
+
+private:
+    const uint32_t *_bounds;
+    size_t _bound_count;
+    std::atomic<uint32_t> *_counts;
+    std::atomic<uint32_t> _sum;
+};
+
+/** Histogram with its bucket storage, bounds given in ascending order. */
+template<size_t Bounds>
+class Histogram : public HistogramBase {
+public:
+    Histogram(const char *name, const uint32_t (&bounds)[Bounds]) :
+        HistogramBase(name, bounds, Bounds, _storage),
+        _storage()
+    {
+    }
+
+private:
+    std::atomic<uint32_t> _storage[Bounds + 1];
+};
+
+/**
+ * Table of every metric of the image, with the export formats.
+ *
+ * Text, one metric per line, for the console:
+ *     tx.frames 1234
+ *     tx.queue 2 max 7
+ *     tx.latency_ms sum 5120 le10 3 le20 40 ... inf 0
+ *
+ * JSON, one object, for the telemetry stream:
+ *     {"tx.frames":1234,"tx.queue":[2,7],"tx.latency_ms":{"b":[10,20],"c":[3,40,0],"s":5120}}
+ *
+ * Binary, for a BLE characteristic, little endian: 'M', version 1,
+ * metric count, then per metric a type byte, the name length and name,
+ * and the value: u32 for a counter, i32 value and i32 max for a gauge,
+ * bound count n, n u32 bounds, n + 1 u32 counts and u32 sum for a
+ * histogram.
+ *
+ * Every format returns the length written, or -1 if dst is too small.
+ */
+class MetricsRegistry {
+public:
+    static const size_t MAX_METRICS = 32;
+
+    /** @return false if the table is full; the metric is then not exported. */
+    static bool add(Metric &metric);
+
+    static size_t count();
+
+    static Metric &metric(size_t index);
+
+    /** @return the metric called name, or nullptr. */
+    static Metric *find(const char *name);
+
+    static int format_text(char *dst, size_t capacity);
+    static int format_json(char *dst, size_t capacity);
+    static int encode(uint8_t *dst, size_t capacity);
+};
+
+} // namespace lab
+
+#endif // LAB_METRICS_H
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""Host side of the lab-utils metrics registry.
+
+Decodes the binary snapshot of MetricsRegistry::encode() (BLE
+characteristic) and aggregates snapshots per device, whatever the
+transport: the JSON object of format_json() sent on the telemetry stream
+has the same shape as decode() returns.
+
+    counter    -> int
+    gauge      -> [value, max]
+    histogram  -> {'b': bounds, 'c': counts, 's': sum}
+
+    python3 metrics.py capture.bin      # decode one binary snapshot
+    python3 metrics.py selftest [SNAPSHOT.bin SNAPSHOT.json]
+
+selftest checks the aggregation over counter wraps and reboots, and that
+a binary snapshot decodes to the JSON export of the same registry.
+"""
+
+import json
+import struct
+import sys
+import time
+
+COUNTER, GAUGE, HISTOGRAM = 0, 1, 2
+MAGIC = ord('M')
+VERSION = 1
+WRAP = 1 << 32
+
+
+def decode(data):
+    """Binary snapshot to a {name: value} dict, ValueError if malformed."""
+    if len(data) < 3 or data[0] != MAGIC or data[1] != VERSION:
+        raise ValueError('not a metrics snapshot')
+    count = data[2]
+    pos = 3
+    snapshot = {}
+    try:
+        for _ in range(count):
+            kind, name_length = data[pos], data[pos + 1]
+            name = bytes(data[pos + 2:pos + 2 + name_length]).decode('utf-8', 'replace')
+            pos += 2 + name_length
+            if kind == COUNTER:
+                snapshot[name], = struct.unpack_from('<I', data, pos)
+                pos += 4
+            elif kind == GAUGE:
+                snapshot[name] = list(struct.unpack_from('<ii', data, pos))
+                pos += 8
+            elif kind == HISTOGRAM:
+                bounds = data[pos]
+                values = struct.unpack_from('<%dI' % (2 * bounds + 2), data, pos + 1)
+                snapshot[name] = {'b': list(values[:bounds]), 'c': list(values[bounds:-1]), 's': values[-1]}
+                pos += 1 + 4 * (2 * bounds + 2)
+            else:
+                raise ValueError('unknown metric type %d' % kind)
+    except (IndexError, struct.error):
+        raise ValueError('truncated metrics snapshot')
+    return snapshot
+
+
+class DeviceMetrics:
+    """Running totals of one device, robust to counter wrap and reboots."""
+
+    def __init__(self):
+        self.last = {}
+        self.totals = {}
+        self.rates = {}
+        self.gauges = {}
+        self.histograms = {}
+        self.last_time = None
+        self.snapshots = 0
+        self.resets = 0
+
+    def update(self, snapshot, now):
+        elapsed = now - self.last_time if self.last_time is not None else None
+        # any counter going back by more than half the range means a reboot
+        reboot = any(isinstance(value, int) and name in self.last and
+                     (value - self.last[name]) % WRAP > WRAP // 2
+                     for name, value in snapshot.items())
+        if reboot:
+            self.resets += 1
+            self.last = {}
+
+        for name, value in snapshot.items():
+            previous = self.last.get(name)
+            if isinstance(value, int):
+                delta = (value - previous) % WRAP if previous is not None else value
+                self.totals[name] = self.totals.get(name, 0) + delta
+                if elapsed:
+                    self.rates[name] = delta / elapsed
+            elif isinstance(value, list):
+                level, peak = value
+                old = self.gauges.get(name, (level, peak))
+                self.gauges[name] = (level, max(old[1], peak))
+            elif isinstance(value, dict):
+                counts = value['c']
+                if previous is not None and len(previous['c']) == len(counts):
+                    deltas = [(c - p) % WRAP for c, p in zip(counts, previous['c'])]
+                else:
+                    deltas = list(counts)
+                total = self.histograms.get(name)
+                if total is None or total['b'] != value['b']:
+                    total = {'b': list(value['b']), 'c': [0] * len(counts)}
+                total['c'] = [t + d for t, d in zip(total['c'], deltas)]
+                self.histograms[name] = total
+            self.last[name] = value
+        self.last_time = now
+        self.snapshots += 1
+
+    def percentile(self, name, fraction):
+        """Upper bound of the bucket holding the given fraction, None if empty."""
+        histogram = self.histograms.get(name)
+        if not histogram or not sum(histogram['c']):
+            return None
+        target = fraction * sum(histogram['c'])
+        running = 0
+        for i, count in enumerate(histogram['c']):
+            running += count
+            if running >= target:
+                return histogram['b'][i] if i < len(histogram['b']) else float('inf')
+        return float('inf')
+
+    def report(self):
+        lines = []
+        for name in sorted(self.totals):
+            rate = self.rates.get(name)
+            lines.append('  %-18s %10d%s' % (name, self.totals[name], '  %8.2f/s' % rate if rate is not None else ''))
+        for name in sorted(self.gauges):
+            lines.append('  %-18s %10d  max %d' % ((name,) + self.gauges[name]))
+        for name in sorted(self.histograms):
+            lines.append('  %-18s %10d  p50 <= %s  p99 <= %s' % (
+                name, sum(self.histograms[name]['c']), self.percentile(name, 0.5), self.percentile(name, 0.99)))
+        return '\n'.join(lines)
+
+
+class MetricsAggregator:
+    """Per-device aggregation of metrics snapshots."""
+
+    def __init__(self, clock=time.monotonic):
+        self.devices = {}
+        self._clock = clock
+
+    def update(self, device, snapshot, now=None):
+        metrics = self.devices.setdefault(device, DeviceMetrics())
+        metrics.update(snapshot, self._clock() if now is None else now)
+        return metrics
+
+    def report(self):
+        return '\n'.join('%s (%d snapshots, %d resets)\n%s' % (device, m.snapshots, m.resets, m.report())
+                         for device, m in sorted(self.devices.items()))
+
+
+def selftest(snapshot=None, expected=None):
+    """Aggregation over wraps and reboots, decode against format_json()."""
+    def fail(message, *args):
+        sys.exit('selftest: ' + message % args)
+
+    histogram = {'b': [10, 20], 'c': [WRAP - 2, 5, 0], 's': 100}
+    metrics = DeviceMetrics()
+    metrics.update({'tx': WRAP - 16, 'queue': [3, 9], 'latency': histogram}, 10.0)
+    # the counter and a histogram bucket wrap, the gauge peak drops
+    metrics.update({'tx': 16, 'queue': [1, 4],
+                    'latency': {'b': [10, 20], 'c': [3, 5, 1], 's': 160}}, 12.0)
+    if metrics.resets or metrics.totals['tx'] != WRAP + 16 or metrics.rates['tx'] != 16.0:
+        fail('wrap: %d resets, total %d, rate %s', metrics.resets, metrics.totals['tx'], metrics.rates['tx'])
+    if metrics.gauges['queue'] != (1, 9):
+        fail('wrap: gauge %s', metrics.gauges['queue'])
+    if metrics.histograms['latency']['c'] != [WRAP + 3, 5, 1]:
+        fail('wrap: histogram %s', metrics.histograms['latency']['c'])
+
+    # a reboot starts the counters over: what they hold since is new
+    metrics.update({'tx': 7, 'queue': [0, 2], 'latency': {'b': [10, 20], 'c': [1, 0, 0], 's': 4}}, 14.0)
+    if metrics.resets != 1 or metrics.totals['tx'] != WRAP + 23 or metrics.rates['tx'] != 3.5:
+        fail('reboot: %d resets, total %d, rate %s', metrics.resets, metrics.totals['tx'], metrics.rates['tx'])
+    if metrics.histograms['latency']['c'] != [WRAP + 4, 5, 1] or metrics.gauges['queue'] != (0, 9):
+        fail('reboot: histogram %s, gauge %s', metrics.histograms['latency']['c'], metrics.gauges['queue'])
+    metrics.update({'tx': 9}, 15.0)
+    if metrics.resets != 1 or metrics.totals['tx'] != WRAP + 25:
+        fail('after the reboot: %d resets, total %d', metrics.resets, metrics.totals['tx'])
+
+    # new bounds start the histogram over
+    metrics.update({'latency': {'b': [5], 'c': [2, 1], 's': 9}}, 16.0)
+    if metrics.histograms['latency'] != {'b': [5], 'c': [2, 1]} or metrics.percentile('latency', 0.5) != 5:
+        fail('new bounds: %s', metrics.histograms['latency'])
+
+    aggregator = MetricsAggregator(clock=lambda: 0.0)
+    aggregator.update('a', {'tx': 1})
+    aggregator.update('b', {'tx': WRAP - 1})
+    aggregator.update('a', {'tx': 2})
+    if aggregator.devices['a'].totals['tx'] != 2 or aggregator.devices['b'].resets:
+        fail('devices are not aggregated apart')
+
+    encoded = struct.pack('<BBBBB2sIBB1siiBB1sBIIIIII', MAGIC, VERSION, 3,
+                          COUNTER, 2, b'tx', 7, GAUGE, 1, b'q', -1, 4,
+                          HISTOGRAM, 1, b'h', 2, 10, 20, 1, 2, 3, 33)
+    if decode(encoded) != {'tx': 7, 'q': [-1, 4], 'h': {'b': [10, 20], 'c': [1, 2, 3], 's': 33}}:
+        fail('decode: %s', decode(encoded))
+    for bad in (encoded[:-1], encoded[:3 + 4], b'X' + encoded[1:], encoded[:3] + b'\x07' + encoded[4:]):
+        try:
+            decode(bad)
+        except ValueError:
+            continue
+        fail('decode accepted %r', bad)
+
+    if snapshot:
+        with open(snapshot, 'rb') as f:
+            decoded = decode(f.read())
+        with open(expected) as f:
+            exported = json.load(f)
+        if decoded != exported:
+            fail('%s decodes to\n%s\nnot\n%s', snapshot, decoded, exported)
+        print('ok: %s, %d metrics' % (snapshot, len(decoded)))
+    print('ok: wraps, reboots and decode')
+
+
+def main():
+    if len(sys.argv) >= 2 and sys.argv[1] == 'selftest' and len(sys.argv) in (2, 4):
+        selftest(*sys.argv[2:])
+        return
+    if len(sys.argv) != 2:
+        sys.exit('usage: metrics.py SNAPSHOT\n       metrics.py selftest [SNAPSHOT.bin SNAPSHOT.json]')
+    with open(sys.argv[1], 'rb') as f:
+        aggregator = MetricsAggregator()
+        aggregator.update(sys.argv[1], decode(f.read()))
+        print(aggregator.report())
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,48 @@
+/* Generated by lab-utils/ml/int8_model.py from activity_model.json: 3 layers, 64 x 3 input, 3 classes. Do not edit. */
+#ifndef LAB_ACTIVITY_MODEL_H
+#define LAB_ACTIVITY_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** Int8Model::arena_bytes() and the raw values of a window. */
+static const size_t ACTIVITY_MODEL_ARENA = 760;
+static const size_t ACTIVITY_MODEL_WINDOW = 192;
+
+/** still, walk, shake */
+alignas(4) static const uint8_t activity_model[332] = {
+    0x4c, 0x51, 0x38, 0x4d, 0x01, 0x00, 0x03, 0x00, 0x40, 0x00, 0x03, 0x00,
+    0x03, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x64, 0x61, 0xff, 0x3e, 0x91, 0xff, 0xff, 0xff, 0x38, 0x01, 0x00, 0x00,
+    0x4c, 0x01, 0x00, 0x00, 0x01, 0x01, 0x02, 0x00, 0x01, 0x00, 0x40, 0x00,
+    0x03, 0x00, 0x3f, 0x00, 0x06, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff,
+    0x94, 0x00, 0x00, 0x00, 0xb8, 0x00, 0x00, 0x00, 0xd0, 0x00, 0x00, 0x00,
+    0xe8, 0x00, 0x00, 0x00, 0x04, 0x00, 0x3f, 0x00, 0x3f, 0x00, 0x3f, 0x00,
+    0x06, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x06, 0x00, 0x01, 0x00, 0x03, 0x00, 0x00, 0x00, 0x91, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x00, 0x00, 0x14, 0x01, 0x00, 0x00, 0x20, 0x01, 0x00, 0x00,
+    0x2c, 0x01, 0x00, 0x00, 0x81, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x7f, 0x00,
+    0x00, 0x81, 0x00, 0x00, 0x00, 0x81, 0x00, 0x00, 0x7f, 0x00, 0x00, 0x7f,
+    0x00, 0x00, 0x81, 0x00, 0x00, 0x00, 0x81, 0x00, 0x00, 0x7f, 0x00, 0x00,
+    0x7f, 0x00, 0x00, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xee, 0x9a, 0x68, 0x4b, 0xee, 0x9a, 0x68, 0x4b,
+    0xee, 0x9a, 0x68, 0x4b, 0xee, 0x9a, 0x68, 0x4b, 0xee, 0x9a, 0x68, 0x4b,
+    0xee, 0x9a, 0x68, 0x4b, 0xfb, 0xff, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xff,
+    0xfb, 0xff, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xff, 0xfb, 0xff, 0xff, 0xff,
+    0xfb, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7f, 0x7f,
+    0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x30, 0x7b, 0x01, 0x00, 0x8d, 0x75, 0x01, 0x00,
+    0xa8, 0x7d, 0xc1, 0x6d, 0x18, 0xfc, 0x7e, 0x58, 0x7c, 0x7c, 0xa5, 0x4f,
+    0x04, 0x00, 0x00, 0x00, 0xf9, 0xff, 0xff, 0xff, 0xfa, 0xff, 0xff, 0xff,
+    0x73, 0x74, 0x69, 0x6c, 0x6c, 0x00, 0x77, 0x61, 0x6c, 0x6b, 0x00, 0x73,
+    0x68, 0x61, 0x6b, 0x65, 0x00, 0x00, 0x00, 0x00,
+};
+
+} // namespace lab
+
+#endif // LAB_ACTIVITY_MODEL_H
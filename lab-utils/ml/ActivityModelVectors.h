@@ -0,0 +1,136 @@
+/* Generated by lab-utils/ml/int8_model.py: windows and the logits ActivityModel.h must give. Do not edit. */
+#ifndef LAB_ACTIVITY_MODEL_VECTORS_H
+#define LAB_ACTIVITY_MODEL_VECTORS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ActivityModel.h"
+
+namespace lab {
+
+static const size_t ACTIVITY_MODEL_VECTORS = 6;
+
+static const int16_t activity_model_inputs[6][192] = {
+    {
+        236, -335, 910, 243, -334, 906, 238, -331, 912, 235, -338, 920,
+        233, -334, 912, 226, -338, 910, 237, -336, 913, 236, -331, 909,
+        236, -335, 915, 232, -334, 920, 236, -341, 910, 240, -324, 914,
+        234, -338, 918, 233, -344, 906, 239, -337, 909, 228, -340, 915,
+        232, -336, 912, 236, -328, 910, 237, -341, 910, 234, -339, 908,
+        237, -334, 907, 232, -332, 913, 236, -339, 901, 232, -337, 914,
+        240, -328, 911, 228, -337, 913, 240, -330, 911, 232, -334, 903,
+        232, -328, 912, 239, -343, 912, 228, -340, 912, 234, -335, 916,
+        232, -334, 917, 232, -335, 909, 240, -339, 908, 235, -335, 913,
+        238, -342, 908, 238, -342, 913, 233, -332, 907, 236, -335, 919,
+        236, -335, 914, 233, -338, 914, 236, -338, 912, 235, -329, 909,
+        236, -336, 912, 232, -333, 913, 237, -331, 909, 237, -330, 913,
+        235, -333, 912, 235, -338, 911, 230, -338, 911, 243, -336, 909,
+        235, -338, 909, 232, -337, 911, 234, -338, 922, 238, -338, 914,
+        233, -329, 910, 233, -334, 920, 236, -328, 914, 240, -337, 916,
+        243, -329, 911, 232, -336, 911, 238, -337, 908, 236, -334, 911,
+    },
+    {
+        -469, 968, -88, -483, 951, -102, -477, 953, -54, -502, 909, -60,
+        -479, 967, -46, -470, 938, -45, -464, 890, -12, -466, 879, 16,
+        -426, 842, 65, -433, 838, 83, -405, 796, 129, -381, 771, 105,
+        -394, 758, 159, -390, 717, 167, -364, 728, 190, -390, 745, 160,
+        -392, 775, 149, -403, 774, 112, -395, 834, 91, -435, 868, 38,
+        -450, 899, -1, -450, 956, -21, -519, 988, -62, -508, 983, -80,
+        -491, 1011, -111, -512, 1018, -121, -526, 996, -122, -505, 1035, -135,
+        -499, 992, -102, -482, 1003, -100, -506, 956, -91, -476, 966, -72,
+        -481, 970, -60, -491, 946, -88, -472, 946, -68, -469, 930, -27,
+        -465, 920, -49, -449, 892, -29, -453, 888, 6, -433, 850, 34,
+        -405, 834, 63, -383, 762, 104, -384, 778, 135, -389, 749, 154,
+        -369, 683, 177, -386, 737, 187, -367, 724, 174, -393, 753, 145,
+        -415, 808, 128, -450, 828, 59, -442, 845, 30, -454, 889, -25,
+        -476, 936, -15, -497, 943, -79, -492, 971, -108, -501, 999, -110,
+        -522, 993, -125, -515, 1000, -113, -502, 1009, -107, -519, 976, -94,
+        -502, 986, -115, -501, 967, -102, -504, 947, -81, -474, 953, -75,
+    },
+    {
+        -706, -440, 242, -1116, -267, 283, -1520, 103, 330, -1826, 204, 335,
+        -1708, 221, 322, -1219, -161, 310, -637, -558, 222, -275, -723, 196,
+        -289, -793, 193, -366, -715, 262, -474, -655, 203, -486, -623, 264,
+        -692, -440, 215, -1104, -255, 368, -1573, 29, 387, -1822, 255, 376,
+        -1682, 238, 329, -1208, -101, 302, -681, -498, 269, -331, -732, 215,
+        -229, -735, 200, -402, -747, 213, -439, -665, 213, -564, -599, 208,
+        -763, -446, 175, -1099, -252, 325, -1551, 25, 335, -1802, 257, 388,
+        -1729, 186, 335, -1223, -117, 335, -723, -510, 251, -358, -687, 182,
+        -228, -746, 195, -373, -709, 163, -426, -660, 187, -556, -615, 230,
+        -696, -493, 288, -997, -299, 202, -1490, -21, 358, -1832, 264, 407,
+        -1735, 219, 411, -1336, -88, 353, -752, -477, 269, -335, -740, 201,
+        -318, -780, 159, -342, -765, 180, -485, -685, 241, -579, -649, 240,
+        -740, -490, 192, -1034, -295, 282, -1410, 43, 314, -1747, 276, 347,
+        -1746, 244, 387, -1343, -91, 300, -752, -392, 264, -334, -714, 172,
+        -227, -796, 181, -317, -667, 202, -434, -635, 186, -551, -573, 226,
+        -687, -532, 206, -976, -318, 267, -1443, -19, 331, -1753, 164, 369,
+    },
+    {
+        -33, -112, -1000, -28, -109, -996, -32, -111, -989, -31, -104, -997,
+        -33, -111, -996, -31, -105, -989, -35, -104, -993, -24, -110, -997,
+        -27, -107, -995, -30, -109, -992, -37, -114, -993, -29, -111, -1001,
+        -25, -111, -998, -24, -105, -989, -27, -107, -997, -30, -108, -991,
+        -29, -113, -996, -32, -110, -997, -38, -114, -992, -31, -107, -1001,
+        -32, -106, -1001, -35, -116, -989, -30, -112, -993, -31, -106, -989,
+        -27, -108, -990, -27, -105, -1001, -29, -109, -993, -32, -110, -992,
+        -30, -109, -998, -36, -112, -1001, -33, -113, -1001, -38, -111, -996,
+        -22, -106, -997, -33, -113, -997, -32, -110, -996, -27, -107, -986,
+        -36, -107, -995, -37, -111, -1000, -31, -98, -988, -23, -105, -1000,
+        -29, -109, -992, -35, -117, -985, -26, -108, -996, -30, -114, -990,
+        -30, -110, -995, -31, -109, -995, -27, -108, -994, -34, -104, -988,
+        -28, -117, -995, -27, -109, -988, -32, -106, -991, -40, -111, -994,
+        -33, -113, -987, -31, -106, -999, -39, -111, -992, -33, -107, -990,
+        -32, -110, -996, -26, -102, -992, -33, -112, -995, -27, -112, -988,
+        -35, -109, -988, -23, -111, -990, -20, -105, -1002, -29, -100, -998,
+    },
+    {
+        93, -37, -1069, 90, -20, -1037, 177, -129, -980, 288, -147, -921,
+        439, -241, -884, 548, -261, -810, 641, -315, -746, 719, -363, -721,
+        783, -398, -699, 798, -385, -698, 753, -390, -701, 717, -357, -714,
+        698, -349, -737, 708, -376, -756, 679, -378, -755, 659, -357, -733,
+        579, -321, -756, 588, -326, -803, 529, -295, -798, 456, -246, -828,
+        362, -186, -902, 248, -101, -948, 166, -86, -971, 102, -82, -1052,
+        73, -47, -1051, 73, -48, -1020, 161, -84, -1011, 260, -112, -966,
+        377, -184, -890, 479, -296, -827, 601, -328, -758, 733, -374, -743,
+        725, -362, -715, 759, -387, -689, 751, -394, -713, 735, -368, -697,
+        726, -371, -719, 698, -345, -720, 658, -358, -692, 656, -318, -753,
+        612, -349, -752, 577, -305, -820, 550, -280, -813, 500, -211, -844,
+        385, -190, -874, 296, -141, -947, 159, -70, -979, 135, -50, -1040,
+        78, 7, -1057, 105, -24, -1059, 155, -56, -1004, 233, -97, -957,
+        325, -171, -927, 491, -234, -848, 583, -335, -785, 706, -332, -725,
+        753, -374, -713, 754, -399, -658, 739, -400, -677, 765, -398, -698,
+        749, -381, -702, 744, -356, -749, 650, -336, -743, 645, -343, -747,
+    },
+    {
+        -94, 616, 749, 524, 761, 1106, 958, 851, 1303, 949, 777, 1310,
+        365, 756, 1031, -266, 605, 604, -762, 560, 383, -907, 563, 299,
+        -747, 590, 419, -592, 591, 510, -458, 613, 541, -247, 626, 677,
+        319, 746, 988, 819, 793, 1239, 996, 851, 1346, 651, 721, 1058,
+        -79, 691, 770, -654, 562, 482, -876, 589, 349, -801, 592, 418,
+        -627, 586, 469, -534, 602, 528, -405, 655, 611, 69, 667, 828,
+        630, 758, 1171, 998, 826, 1285, 866, 754, 1262, 204, 680, 884,
+        -496, 591, 539, -843, 577, 348, -856, 539, 350, -700, 570, 475,
+        -606, 573, 499, -411, 570, 579, -89, 666, 726, 408, 673, 1016,
+        914, 754, 1307, 978, 799, 1292, 513, 729, 1078, -228, 665, 646,
+        -770, 611, 455, -826, 513, 375, -729, 582, 408, -578, 587, 445,
+        -441, 594, 577, -294, 597, 690, 237, 673, 922, 728, 715, 1235,
+        985, 836, 1364, 745, 817, 1195, 71, 674, 850, -567, 553, 505,
+        -877, 624, 395, -841, 564, 330, -667, 622, 462, -523, 572, 529,
+        -384, 541, 577, 56, 640, 841, 618, 746, 1128, 991, 790, 1329,
+        921, 767, 1261, 303, 705, 982, -389, 556, 640, -764, 521, 393,
+    },
+};
+
+static const int8_t activity_model_logits[6][3] = {
+    { -111, -114, -128 }, // still
+    { -111, -107, -117 }, // walk
+    { -111, -66, -44 }, // shake
+    { -111, -114, -128 }, // still
+    { -111, -100, -106 }, // walk
+    { -111, -56, -26 }, // shake
+};
+
+} // namespace lab
+
+#endif // LAB_ACTIVITY_MODEL_VECTORS_H
@@ -0,0 +1,117 @@
+#include "Int8Kernels.h"
+
+namespace lab {
+
+void int8_matvec(const int8_t *input, size_t n, const int8_t *weights, const int32_t *bias, size_t rows,
+                 const Int8Requant &requant, int8_t *output)
+{
+    size_t row = 0;
+    for (; row + 2 <= rows; row += 2) {
+        const int8_t *w0 = weights + row * n;
+        const int8_t *w1 = w0 + n;
+        int32_t acc0 = bias[row];
+        int32_t acc1 = bias[row + 1];
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            uint32_t x = int8_load4(input + i);
+            uint32_t even = int8_sxtb16(x);
+            uint32_t odd = int8_sxtb16_ror8(x);
+            uint32_t a = int8_load4(w0 + i);
+            uint32_t b = int8_load4(w1 + i);
+            acc0 = int8_smlad(even, int8_sxtb16(a), acc0);
+            acc0 = int8_smlad(odd, int8_sxtb16_ror8(a), acc0);
+            acc1 = int8_smlad(even, int8_sxtb16(b), acc1);
+            acc1 = int8_smlad(odd, int8_sxtb16_ror8(b), acc1);
+        }
+        for (; i < n; i++) {
+            acc0 += (int32_t)input[i] * w0[i];
+            acc1 += (int32_t)input[i] * w1[i];
+        }
+        output[row] = int8_output(acc0, requant, row);
+        output[row + 1] = int8_output(acc1, requant, row + 1);
+    }
+    if (row < rows) {
+        output[row] = int8_output(int8_dot(input, weights + row * n, n, bias[row]), requant, row);
+    }
+}
+
+void int8_dense(const int8_t *input, size_t inputs, const int8_t *weights, const int32_t *bias, size_t outputs,
+                const Int8Requant &requant, int8_t *output)
+{
+    int8_matvec(input, inputs, weights, bias, outputs, requant, output);
+}
+
+void int8_conv1d(const int8_t *input, size_t length, size_t in_channels, const int8_t *weights, const int32_t *bias,
+                 size_t out_channels, size_t kernel, size_t stride, const Int8Requant &requant, int8_t *output)
+{
+    size_t out_length = (length - kernel) / stride + 1;
+    for (size_t position = 0; position < out_length; position++) {
+        int8_matvec(input + position * stride * in_channels, kernel * in_channels, weights, bias, out_channels,
+                    requant, output + position * out_channels);
+    }
+}
+
+void int8_max_pool1d(const int8_t *input, size_t length, size_t channels, size_t window, int8_t *output)
+{
+    size_t out_length = length / window;
+    for (size_t position = 0; position < out_length; position++) {
+        const int8_t *first = input + position * window * channels;
+        for (size_t channel = 0; channel < channels; channel++) {
+            int8_t best = first[channel];
+            for (size_t k = 1; k < window; k++) {
+                int8_t value = first[k * channels + channel];
+                best = value > best ? value : best;
+            }
+            output[position * channels + channel] = best;
+        }
+    }
+}
+
+void int8_avg_pool1d(const int8_t *input, size_t length, size_t channels, size_t window, int8_t *output)
+{
+    size_t out_length = length / window;
+    int32_t half = (int32_t)(window / 2);
+    for (size_t position = 0; position < out_length; position++) {
+        const int8_t *first = input + position * window * channels;
+        for (size_t channel = 0; channel < channels; channel++) {
+            int32_t sum = 0;
+            for (size_t k = 0; k < window; k++) {
+                sum += first[k * channels + channel];
+            }
+            output[position * channels + channel] = (int8_t)((sum >= 0 ? sum + half : sum - half) / (int32_t)window);
+        }
+    }
+}
+
+void int8_dense_reference(const int8_t *input, size_t inputs, const int8_t *weights, const int32_t *bias,
+                          size_t outputs, const Int8Requant &requant, int8_t *output)
+{
+    for (size_t row = 0; row < outputs; row++) {
+        int32_t acc = bias[row];
+        for (size_t i = 0; i < inputs; i++) {
+            acc += (int32_t)input[i] * weights[row * inputs + i];
+        }
+        output[row] = int8_output(acc, requant, row);
+    }
+}
+
+void int8_conv1d_reference(const int8_t *input, size_t length, size_t in_channels, const int8_t *weights,
+                           const int32_t *bias, size_t out_channels, size_t kernel, size_t stride,
+                           const Int8Requant &requant, int8_t *output)
+{
+    size_t out_length = (length - kernel) / stride + 1;
+    for (size_t position = 0; position < out_length; position++) {
+        for (size_t channel = 0; channel < out_channels; channel++) {
+            int32_t acc = bias[channel];
+            for (size_t k = 0; k < kernel; k++) {
+                for (size_t i = 0; i < in_channels; i++) {
+                    acc += (int32_t)input[(position * stride + k) * in_channels + i] *
+                           weights[(channel * kernel + k) * in_channels + i];
+                }
+            }
+            output[position * out_channels + channel] = int8_output(acc, requant, channel);
+        }
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,176 @@
+#ifndef LAB_INT8_KERNELS_H
+#define LAB_INT8_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__ARM_FEATURE_DSP) && defined(__MBED__)
+#include "cmsis.h"
+#endif
+
+namespace lab {
+
+/*
+ * Int8 kernels of a quantized network, with the arithmetic of TensorFlow
+ * Lite Micro: activations are int8 with a zero point, weights int8 and
+ * symmetric per output channel, biases int32 with the input zero point
+ * folded in offline (bias - zero * sum of the weights), so a kernel only
+ * takes raw dot products. An accumulator goes back to int8 through a Q31
+ * multiplier and a shift per output channel, plus the output zero point,
+ * clamped to the activation range (ReLU: from the zero point up).
+ *
+ * The dot products take 4 bytes per load and two multiply-accumulates of
+ * 16 bit pairs per instruction (SXTB16, SMLAD) on a core with the DSP
+ * extension. Elsewhere those two instructions are emulated, so the host
+ * runs the very code of the board; the *_reference kernels are the plain
+ * loops to check it against. Integer sums do not depend on their order:
+ * both give the same bytes.
+ */
+
+/** Requantization of an output channel: multiplier in [2^30, 2^31), shift > 0 left. */
+struct Int8Requant {
+    const int32_t *multipliers;
+    const int32_t *shifts;
+    int32_t output_zero;
+    int8_t min;
+    int8_t max;
+};
+
+/** (a * b * 2 + 2^31) >> 32 rounded half away from zero, INT32_MIN squared saturates. */
+inline int32_t int8_high_mul(int32_t a, int32_t b)
+{
+    if (a == b && a == INT32_MIN) {
+        return INT32_MAX;
+    }
+    int64_t product = (int64_t)a * b;
+    int64_t nudge = product >= 0 ? (1 << 30) : (1 - (1 << 30));
+    return (int32_t)((product + nudge) / ((int64_t)1 << 31));
+}
+
+/** x / 2^exponent rounded half away from zero. */
+inline int32_t int8_rounding_shift(int32_t x, int exponent)
+{
+    int32_t mask = (int32_t)((1u << exponent) - 1);
+    int32_t remainder = x & mask;
+    int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+    return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+inline int32_t int8_requantize(int32_t acc, int32_t multiplier, int32_t shift)
+{
+    if (shift > 0) {
+        int64_t scaled = (int64_t)acc << shift;
+        acc = scaled > INT32_MAX ? INT32_MAX : (scaled < INT32_MIN ? INT32_MIN : (int32_t)scaled);
+        return int8_high_mul(acc, multiplier);
+    }
+    return int8_rounding_shift(int8_high_mul(acc, multiplier), -shift);
+}
+
+inline int8_t int8_output(int32_t acc, const Int8Requant &requant, size_t channel)
+{
+    int32_t value = int8_requantize(acc, requant.multipliers[channel], requant.shifts[channel]) + requant.output_zero;
+    return (int8_t)(value < requant.min ? requant.min : (value > requant.max ? requant.max : value));
+}
+
+#if defined(__ARM_FEATURE_DSP) && defined(__MBED__)
+
+inline uint32_t int8_sxtb16(uint32_t x)
+{
+    return __SXTB16(x);
+}
+
+inline uint32_t int8_sxtb16_ror8(uint32_t x)
+{
+    return __SXTB16(__ROR(x, 8));
+}
+
+inline int32_t int8_smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+    return (int32_t)__SMLAD(x, y, (uint32_t)acc);
+}
+
+#else
+
+/** Bytes 0 and 2 sign extended to the two halfwords. */
+inline uint32_t int8_sxtb16(uint32_t x)
+{
+    return (uint32_t)(uint16_t)(int16_t)(int8_t)x | (uint32_t)(uint16_t)(int16_t)(int8_t)(x >> 16) << 16;
+}
+
+/** Bytes 1 and 3. */
+inline uint32_t int8_sxtb16_ror8(uint32_t x)
+{
+    return int8_sxtb16(x >> 8 | x << 24);
+}
+
+/** acc + the products of the low and of the high halfwords, wrapping as the instruction. */
+inline int32_t int8_smlad(uint32_t x, uint32_t y, int32_t acc)
+{
+    int32_t low = (int32_t)(int16_t)x * (int16_t)y;
+    int32_t high = (int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16);
+    return (int32_t)((uint32_t)acc + (uint32_t)low + (uint32_t)high);
+}
+
+#endif
+
+inline uint32_t int8_load4(const int8_t *p)
+{
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/** acc + the dot product of a and b, n values. */
+inline int32_t int8_dot(const int8_t *a, const int8_t *b, size_t n, int32_t acc)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        uint32_t x = int8_load4(a + i);
+        uint32_t w = int8_load4(b + i);
+        acc = int8_smlad(int8_sxtb16(x), int8_sxtb16(w), acc);
+        acc = int8_smlad(int8_sxtb16_ror8(x), int8_sxtb16_ror8(w), acc);
+    }
+    for (; i < n; i++) {
+        acc += (int32_t)a[i] * b[i];
+    }
+    return acc;
+}
+
+/**
+ * output[r] = requant(bias[r] + weights[r] . input) for rows r, the
+ * weights row after row, n each. Two rows share each load of the input.
+ */
+void int8_matvec(const int8_t *input, size_t n, const int8_t *weights, const int32_t *bias, size_t rows,
+                 const Int8Requant &requant, int8_t *output);
+
+/** Dense layer, weights [outputs][inputs]. */
+void int8_dense(const int8_t *input, size_t inputs, const int8_t *weights, const int32_t *bias, size_t outputs,
+                const Int8Requant &requant, int8_t *output);
+
+/**
+ * 1D convolution without padding over [length][in_channels], weights
+ * [out_channels][kernel][in_channels], output [out_length][out_channels]
+ * with out_length = (length - kernel) / stride + 1. A window of the
+ * input is kernel * in_channels contiguous values: each output position
+ * is a matvec over it.
+ */
+void int8_conv1d(const int8_t *input, size_t length, size_t in_channels, const int8_t *weights, const int32_t *bias,
+                 size_t out_channels, size_t kernel, size_t stride, const Int8Requant &requant, int8_t *output);
+
+/** Max over windows of window positions, stride window, per channel. */
+void int8_max_pool1d(const int8_t *input, size_t length, size_t channels, size_t window, int8_t *output);
+
+/** Mean over the same windows rounded half away from zero; input and output share scale and zero. */
+void int8_avg_pool1d(const int8_t *input, size_t length, size_t channels, size_t window, int8_t *output);
+
+/** The plain loops, for checking. */
+void int8_dense_reference(const int8_t *input, size_t inputs, const int8_t *weights, const int32_t *bias,
+                          size_t outputs, const Int8Requant &requant, int8_t *output);
+void int8_conv1d_reference(const int8_t *input, size_t length, size_t in_channels, const int8_t *weights,
+                           const int32_t *bias, size_t out_channels, size_t kernel, size_t stride,
+                           const Int8Requant &requant, int8_t *output);
+
+} // namespace lab
+
+#endif // LAB_INT8_KERNELS_H
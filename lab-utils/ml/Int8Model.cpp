@@ -0,0 +1,309 @@
+#include "Int8Model.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace lab {
+
+static uint16_t read_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/** An array of count items of item_size at offset, inside the blob and aligned to align. */
+static bool in_blob(uint32_t offset, size_t count, size_t item_size, size_t align, size_t size)
+{
+    return offset % align == 0 && offset <= size && count * item_size <= size - offset;
+}
+
+Int8Model::Int8Model() :
+    _layer_count(0),
+    _input_length(0),
+    _input_channels(0),
+    _classes(0),
+    _input_multiplier(0),
+    _input_zero(0),
+    _output_scale(0.0f),
+    _output_zero(0)
+{
+}
+
+int Int8Model::load(const uint8_t *blob, size_t size)
+{
+    _layer_count = 0;
+    if (!blob || (uintptr_t)blob % 4 || size < HEADER_SIZE || memcmp(blob, "LQ8M", 4) || read_u16(blob + 4) != 1) {
+        return -1;
+    }
+    size_t layers = read_u16(blob + 6);
+    _input_length = read_u16(blob + 8);
+    _input_channels = read_u16(blob + 10);
+    _classes = read_u16(blob + 12);
+    _input_multiplier = (int32_t)read_u32(blob + 16);
+    _input_zero = (int32_t)read_u32(blob + 20);
+    uint32_t scale_bits = read_u32(blob + 24);
+    memcpy(&_output_scale, &scale_bits, sizeof(_output_scale));
+    _output_zero = (int32_t)read_u32(blob + 28);
+    uint32_t labels = read_u32(blob + 32);
+    if (read_u32(blob + 36) != size || !layers || layers > MAX_LAYERS || !_classes || _classes > MAX_CLASSES ||
+        !_input_length || !_input_channels || HEADER_SIZE + layers * LAYER_SIZE > size) {
+        return -1;
+    }
+
+    size_t length = _input_length;
+    size_t channels = _input_channels;
+    for (size_t i = 0; i < layers; i++) {
+        const uint8_t *record = blob + HEADER_SIZE + i * LAYER_SIZE;
+        Int8Layer &layer = _layers[i];
+        layer.type = record[0];
+        layer.kernel = read_u16(record + 2);
+        layer.stride = read_u16(record + 4);
+        layer.input_length = read_u16(record + 6);
+        layer.input_channels = read_u16(record + 8);
+        layer.output_length = read_u16(record + 10);
+        layer.output_channels = read_u16(record + 12);
+        if (layer.input_length != length || layer.input_channels != channels || !layer.output_channels) {
+            return -1;
+        }
+
+        size_t out_length;
+        size_t out_channels = layer.output_channels;
+        size_t weight_count = 0;
+        switch (layer.type) {
+            case INT8_LAYER_CONV1D:
+                if (!layer.kernel || !layer.stride || layer.kernel > length) {
+                    return -1;
+                }
+                out_length = (length - layer.kernel) / layer.stride + 1;
+                weight_count = out_channels * layer.kernel * channels;
+                break;
+            case INT8_LAYER_DENSE:
+                out_length = 1;
+                weight_count = out_channels * length * channels;
+                break;
+            case INT8_LAYER_MAX_POOL:
+            case INT8_LAYER_AVG_POOL:
+                if (!layer.kernel || layer.stride != layer.kernel || layer.kernel > length || out_channels != channels) {
+                    return -1;
+                }
+                out_length = length / layer.kernel;
+                break;
+            default:
+                return -1;
+        }
+        if (layer.output_length != out_length) {
+            return -1;
+        }
+
+        if (weight_count) {
+            uint32_t weights = read_u32(record + 20);
+            uint32_t bias = read_u32(record + 24);
+            uint32_t multipliers = read_u32(record + 28);
+            uint32_t shifts = read_u32(record + 32);
+            if (!in_blob(weights, weight_count, 1, 1, size) || !in_blob(bias, out_channels, 4, 4, size) ||
+                !in_blob(multipliers, out_channels, 4, 4, size) || !in_blob(shifts, out_channels, 4, 4, size)) {
+                return -1;
+            }
+            layer.weights = reinterpret_cast<const int8_t *>(blob + weights);
+            layer.bias = reinterpret_cast<const int32_t *>(blob + bias);
+            layer.requant.multipliers = reinterpret_cast<const int32_t *>(blob + multipliers);
+            layer.requant.shifts = reinterpret_cast<const int32_t *>(blob + shifts);
+            for (size_t k = 0; k < out_channels; k++) {
+                if (layer.requant.shifts[k] < -31 || layer.requant.shifts[k] > 30) {
+                    return -1;
+                }
+            }
+            int32_t zero = (int32_t)read_u32(record + 16);
+            if (zero < -128 || zero > 127) {
+                return -1;
+            }
+            layer.requant.output_zero = zero;
+            layer.requant.min = record[1] ? (int8_t)zero : (int8_t)-128;
+            layer.requant.max = 127;
+        } else {
+            layer.weights = nullptr;
+            layer.bias = nullptr;
+            layer.requant = Int8Requant();
+        }
+        length = out_length;
+        channels = out_channels;
+    }
+    if (length * channels != _classes) {
+        return -1;
+    }
+
+    size_t at = labels;
+    for (size_t k = 0; k < _classes; k++) {
+        const void *end = at < size ? memchr(blob + at, '\0', size - at) : nullptr;
+        if (!end) {
+            return -1;
+        }
+        _labels[k] = reinterpret_cast<const char *>(blob + at);
+        at = (size_t)(static_cast<const uint8_t *>(end) - blob) + 1;
+    }
+    _layer_count = layers;
+    return 0;
+}
+
+size_t Int8Model::arena_bytes() const
+{
+    size_t largest = (size_t)_input_length * _input_channels;
+    for (size_t i = 0; i < _layer_count; i++) {
+        size_t tensor = (size_t)_layers[i].output_length * _layers[i].output_channels;
+        largest = tensor > largest ? tensor : largest;
+    }
+    // the second buffer starts word aligned
+    largest = (largest + 3) & ~(size_t)3;
+    return 2 * largest;
+}
+
+int8_t Int8Model::quantize(int16_t raw) const
+{
+    int64_t step = ((int64_t)raw * _input_multiplier + (1 << 15)) >> 16;
+    int64_t value = step + _input_zero;
+    return (int8_t)(value < -128 ? -128 : (value > 127 ? 127 : value));
+}
+
+const int8_t *Int8Model::invoke(uint8_t *arena, size_t arena_size, bool reference) const
+{
+    size_t half = arena_bytes() / 2;
+    if (!_layer_count || arena_size < 2 * half) {
+        return nullptr;
+    }
+    int8_t *input = reinterpret_cast<int8_t *>(arena);
+    int8_t *output = reinterpret_cast<int8_t *>(arena + half);
+    for (size_t i = 0; i < _layer_count; i++) {
+        const Int8Layer &layer = _layers[i];
+        switch (layer.type) {
+            case INT8_LAYER_CONV1D:
+                if (reference) {
+                    int8_conv1d_reference(input, layer.input_length, layer.input_channels, layer.weights, layer.bias,
+                                          layer.output_channels, layer.kernel, layer.stride, layer.requant, output);
+                } else {
+                    int8_conv1d(input, layer.input_length, layer.input_channels, layer.weights, layer.bias,
+                                layer.output_channels, layer.kernel, layer.stride, layer.requant, output);
+                }
+                break;
+            case INT8_LAYER_DENSE:
+                if (reference) {
+                    int8_dense_reference(input, (size_t)layer.input_length * layer.input_channels, layer.weights,
+                                         layer.bias, layer.output_channels, layer.requant, output);
+                } else {
+                    int8_dense(input, (size_t)layer.input_length * layer.input_channels, layer.weights, layer.bias,
+                               layer.output_channels, layer.requant, output);
+                }
+                break;
+            case INT8_LAYER_MAX_POOL:
+                int8_max_pool1d(input, layer.input_length, layer.input_channels, layer.kernel, output);
+                break;
+            case INT8_LAYER_AVG_POOL:
+                int8_avg_pool1d(input, layer.input_length, layer.input_channels, layer.kernel, output);
+                break;
+        }
+        int8_t *done = output;
+        output = input;
+        input = done;
+    }
+    return input;
+}
+
+Int8ClassifierBase::Int8ClassifierBase(uint8_t *arena, size_t arena_size, int16_t *window, size_t window_capacity) :
+    _arena(arena),
+    _arena_size(arena_size),
+    _window(window),
+    _window_capacity(window_capacity),
+    _hop(1),
+    _head(0),
+    _filled(0),
+    _since(0),
+    _logits(nullptr),
+    _result()
+{
+}
+
+int Int8ClassifierBase::load(const uint8_t *blob, size_t size, size_t hop)
+{
+    if (_model.load(blob, size) || _model.arena_bytes() > _arena_size ||
+        _model.input_length() * _model.input_channels() > _window_capacity || !hop || hop > _model.input_length()) {
+        _model = Int8Model();
+        return -1;
+    }
+    _hop = hop;
+    _result = Int8Classification();
+    reset();
+    return 0;
+}
+
+void Int8ClassifierBase::reset()
+{
+    _head = 0;
+    _filled = 0;
+    _since = 0;
+}
+
+bool Int8ClassifierBase::push(const int16_t *sample)
+{
+    if (!_model.loaded()) {
+        return false;
+    }
+    size_t length = _model.input_length();
+    size_t channels = _model.input_channels();
+    memcpy(_window + _head * channels, sample, channels * sizeof(int16_t));
+    _head = (_head + 1) % length;
+    // the first window as soon as it is full, then one every hop
+    if (_filled < length) {
+        if (++_filled < length) {
+            return false;
+        }
+    } else if (++_since < _hop) {
+        return false;
+    }
+    _since = 0;
+
+    // oldest first: the ring from the head on
+    int8_t *input = reinterpret_cast<int8_t *>(_arena);
+    for (size_t k = 0; k < length; k++) {
+        const int16_t *values = _window + ((_head + k) % length) * channels;
+        for (size_t c = 0; c < channels; c++) {
+            input[k * channels + c] = _model.quantize(values[c]);
+        }
+    }
+    run();
+    return true;
+}
+
+const Int8Classification &Int8ClassifierBase::classify(const int16_t *window)
+{
+    if (_model.loaded()) {
+        size_t values = _model.input_length() * _model.input_channels();
+        int8_t *input = reinterpret_cast<int8_t *>(_arena);
+        for (size_t k = 0; k < values; k++) {
+            input[k] = _model.quantize(window[k]);
+        }
+        run();
+    }
+    return _result;
+}
+
+void Int8ClassifierBase::run()
+{
+    _logits = _model.invoke(_arena, _arena_size);
+    size_t best = 0;
+    for (size_t k = 1; k < _model.classes(); k++) {
+        best = _logits[k] > _logits[best] ? k : best;
+    }
+    // softmax of the dequantized logits, the best one's share
+    float sum = 0.0f;
+    for (size_t k = 0; k < _model.classes(); k++) {
+        sum += expf(_model.output_scale() * (float)(_logits[k] - _logits[best]));
+    }
+    _result.label = (uint8_t)best;
+    _result.confidence = (uint8_t)lrintf(100.0f / sum);
+    _result.sequence++;
+}
+
+} // namespace lab
@@ -0,0 +1,237 @@
+#ifndef LAB_INT8_MODEL_H
+#define LAB_INT8_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Int8Kernels.h"
+
+namespace lab {
+
+/*
+ * An int8 network as int8_model.py writes it, a blob in flash that is
+ * used in place: nothing is copied or allocated, the activations go to
+ * an arena of the caller. Little endian, 4 byte aligned:
+ *
+ *   header, 40 bytes
+ *     "LQ8M", u16 version 1, u16 layers,
+ *     u16 input length, u16 input channels, u16 classes, u16 0,
+ *     i32 input multiplier (Q16 int8 steps per raw unit), i32 input zero,
+ *     f32 output scale, i32 output zero, u32 labels, u32 blob size
+ *   per layer, 36 bytes
+ *     u8 type, u8 relu, u16 kernel (pool: window), u16 stride,
+ *     u16 input length, u16 input channels,
+ *     u16 output length, u16 output channels, u16 0,
+ *     i32 output zero, u32 weights, u32 bias, u32 multipliers, u32 shifts
+ *   then the data the offsets point at, and the labels, one C string each.
+ *
+ * Tensors are [length][channels]; a dense layer takes its input as one
+ * vector in that order and gives length 1. Pools keep the scale and zero
+ * of their input.
+ */
+enum Int8LayerType {
+    INT8_LAYER_CONV1D = 1,
+    INT8_LAYER_DENSE = 2,
+    INT8_LAYER_MAX_POOL = 3,
+    INT8_LAYER_AVG_POOL = 4,
+};
+
+struct Int8Layer {
+    uint8_t type;
+    uint16_t kernel;
+    uint16_t stride;
+    uint16_t input_length;
+    uint16_t input_channels;
+    uint16_t output_length;
+    uint16_t output_channels;
+    const int8_t *weights;
+    const int32_t *bias;
+    Int8Requant requant;
+};
+
+class Int8Model {
+public:
+    static const size_t MAX_LAYERS = 8;
+    static const size_t MAX_CLASSES = 8;
+    static const size_t HEADER_SIZE = 40;
+    static const size_t LAYER_SIZE = 36;
+
+    Int8Model();
+
+    /**
+     * Check a blob and point into it; blob stays in use.
+     *
+     * @return 0, -1 if it is not a model this code runs (magic, version,
+     * shapes that do not chain, offsets out of the blob or misaligned).
+     */
+    int load(const uint8_t *blob, size_t size);
+
+    bool loaded() const
+    {
+        return _layer_count != 0;
+    }
+
+    size_t input_length() const
+    {
+        return _input_length;
+    }
+
+    size_t input_channels() const
+    {
+        return _input_channels;
+    }
+
+    size_t classes() const
+    {
+        return _classes;
+    }
+
+    const char *label(size_t index) const
+    {
+        return index < _classes ? _labels[index] : "?";
+    }
+
+    size_t layer_count() const
+    {
+        return _layer_count;
+    }
+
+    const Int8Layer &layer(size_t index) const
+    {
+        return _layers[index];
+    }
+
+    /** Two buffers of the largest tensor, what invoke() needs. */
+    size_t arena_bytes() const;
+
+    /** Raw value to input step, rounded, clamped. */
+    int8_t quantize(int16_t raw) const;
+
+    float output_scale() const
+    {
+        return _output_scale;
+    }
+
+    int32_t output_zero() const
+    {
+        return _output_zero;
+    }
+
+    /**
+     * Run the network. The input, input_length * input_channels values,
+     * is at the start of the arena.
+     *
+     * @return the logits (classes values) in the arena, nullptr if the
+     * arena is too small.
+     */
+    const int8_t *invoke(uint8_t *arena, size_t arena_size, bool reference = false) const;
+
+private:
+    Int8Layer _layers[MAX_LAYERS];
+    size_t _layer_count;
+    uint16_t _input_length;
+    uint16_t _input_channels;
+    uint16_t _classes;
+    int32_t _input_multiplier;
+    int32_t _input_zero;
+    float _output_scale;
+    int32_t _output_zero;
+    const char *_labels[MAX_CLASSES];
+};
+
+/** The outcome of one window. */
+struct Int8Classification {
+    uint8_t label;
+    /** Softmax of the logits, percent. */
+    uint8_t confidence;
+    /** Windows classified since load(). */
+    uint32_t sequence;
+};
+
+/**
+ * Sliding windows of a sensor through an Int8Model.
+ *
+ * Samples of input_channels raw values (mg of the accelerometer for the
+ * activity model) go into a ring. The window is quantized into the arena
+ * and classified when the ring first fills, then every hop samples.
+ * Use the Int8Classifier template below for the storage.
+ */
+class Int8ClassifierBase {
+public:
+    /**
+     * @param[in] hop Samples between two windows, 1 to the window length.
+     *
+     * @return 0, -1 if the blob is not a model, or the model needs more
+     * arena or window than there is.
+     */
+    int load(const uint8_t *blob, size_t size, size_t hop);
+
+    /** Drop the samples so far, e.g. after a gap in the sensor data. */
+    void reset();
+
+    /**
+     * Take one sample.
+     *
+     * @return true if it completed a hop, result() is then the new window's.
+     */
+    bool push(const int16_t *sample);
+
+    /** Classify a window of input_length samples at once, oldest first. */
+    const Int8Classification &classify(const int16_t *window);
+
+    const Int8Classification &result() const
+    {
+        return _result;
+    }
+
+    /** The logits of the last window, model().classes() of them. */
+    const int8_t *logits() const
+    {
+        return _logits;
+    }
+
+    const Int8Model &model() const
+    {
+        return _model;
+    }
+
+protected:
+    Int8ClassifierBase(uint8_t *arena, size_t arena_size, int16_t *window, size_t window_capacity);
+
+private:
+    void run();
+
+    Int8Model _model;
+    uint8_t *_arena;
+    size_t _arena_size;
+    int16_t *_window;
+    size_t _window_capacity;
+    size_t _hop;
+    size_t _head;
+    size_t _filled;
+    size_t _since;
+    const int8_t *_logits;
+    Int8Classification _result;
+};
+
+/**
+ * Classifier with its storage, for a static instance: nothing comes from
+ * the heap.
+ *
+ * @tparam ArenaBytes at least Int8Model::arena_bytes() of the model,
+ * int8_model.py prints it.
+ * @tparam WindowValues at least input length times input channels.
+ */
+template<size_t ArenaBytes, size_t WindowValues>
+class Int8Classifier : public Int8ClassifierBase {
+public:
+    Int8Classifier() : Int8ClassifierBase(_arena, ArenaBytes, _storage, WindowValues) {}
+
+private:
+    alignas(4) uint8_t _arena[ArenaBytes];
+    int16_t _storage[WindowValues];
+};
+
+} // namespace lab
+
+#endif // LAB_INT8_MODEL_H
@@ -0,0 +1,549 @@
+#!/usr/bin/env python3
+"""Offline side of lab-utils/ml: int8 models for Int8Model.h.
+
+A float model (JSON, below) is quantized against calibration windows and
+written as a C++ header holding the blob Int8Model::load() takes, with
+the integer arithmetic of Int8Kernels.h done here as well, so the test
+vectors it writes are what the board must compute to the bit.
+
+    int8_model.py demo -o activity_model.json
+    int8_model.py synth [--windows N] [--seed S] -o windows.csv
+    int8_model.py quantize activity_model.json -o ActivityModel.h
+                  [--name activity_model] [--calibration windows.csv]
+                  [--vectors ActivityModelVectors.h]
+
+The float model, as a trainer exports it:
+
+    {"input": {"length": 64, "channels": 3, "scale": 16.0, "zero": 0},
+     "labels": ["still", "walk", "shake"],
+     "layers": [
+        {"type": "conv1d", "kernel": 2, "stride": 1, "relu": true,
+         "weights": [out][kernel][in], "bias": [out]},
+        {"type": "avg_pool", "window": 63},      (or "max_pool")
+        {"type": "dense", "relu": false, "weights": [out][in], "bias": [out]}]}
+
+Inputs are raw sensor values (mg for the accelerometer), tensors
+[length][channels], a dense layer takes its input flattened in that
+order. The input scale and zero are optional, calibrated otherwise.
+Calibration windows are CSV lines "window,label,x,y,z", one per sample;
+synth writes synthetic accelerometer windows at 50 Hz in that format.
+"""
+
+import argparse
+import json
+import math
+import os
+import random
+import struct
+import sys
+
+CONV1D, DENSE, MAX_POOL, AVG_POOL = 1, 2, 3, 4
+TYPES = {'conv1d': CONV1D, 'dense': DENSE, 'max_pool': MAX_POOL, 'avg_pool': AVG_POOL}
+HEADER_SIZE = 40
+LAYER_SIZE = 36
+INT32_MIN, INT32_MAX = -(1 << 31), (1 << 31) - 1
+SAMPLE_HZ = 50.0
+FULL_SCALE_MG = 2000
+
+
+def rnd(x):
+    """Round half away from zero."""
+    return int(math.floor(x + 0.5)) if x >= 0 else -int(math.floor(-x + 0.5))
+
+
+def tdiv(a, b):
+    """C integer division, truncating."""
+    q = abs(a) // abs(b)
+    return q if (a >= 0) == (b > 0) else -q
+
+
+def clamp(x, low, high):
+    return low if x < low else (high if x > high else x)
+
+
+# -- the arithmetic of Int8Kernels.h ------------------------------------------
+
+def high_mul(a, b):
+    if a == b == INT32_MIN:
+        return INT32_MAX
+    product = a * b
+    nudge = (1 << 30) if product >= 0 else 1 - (1 << 30)
+    return tdiv(product + nudge, 1 << 31)
+
+
+def rounding_shift(x, exponent):
+    mask = (1 << exponent) - 1
+    remainder = x & mask
+    threshold = (mask >> 1) + (1 if x < 0 else 0)
+    return (x >> exponent) + (1 if remainder > threshold else 0)
+
+
+def requantize(acc, multiplier, shift):
+    if shift > 0:
+        return high_mul(clamp(acc << shift, INT32_MIN, INT32_MAX), multiplier)
+    return rounding_shift(high_mul(acc, multiplier), -shift)
+
+
+def quantize_input(raw, multiplier, zero):
+    return clamp(((raw * multiplier + (1 << 15)) >> 16) + zero, -128, 127)
+
+
+def run_int8(model, window):
+    """Logits of the quantized model for a window of raw values, [length][channels]."""
+    x = [quantize_input(v, model['input_multiplier'], model['input_zero']) for v in window]
+    length, channels = model['length'], model['channels']
+    for layer in model['layers']:
+        kind = layer['type']
+        if kind in (CONV1D, DENSE):
+            kernel = layer['kernel'] if kind == CONV1D else length
+            stride = layer['stride'] if kind == CONV1D else 1
+            out_length = (length - kernel) // stride + 1
+            n = kernel * channels
+            y = []
+            for position in range(out_length):
+                window_values = x[position * stride * channels:position * stride * channels + n]
+                for row in range(layer['out_channels']):
+                    acc = layer['bias'][row]
+                    weights = layer['weights'][row * n:(row + 1) * n]
+                    acc += sum(a * w for a, w in zip(window_values, weights))
+                    value = requantize(acc, layer['multipliers'][row], layer['shifts'][row]) + layer['zero']
+                    y.append(clamp(value, layer['zero'] if layer['relu'] else -128, 127))
+            x, length, channels = y, out_length, layer['out_channels']
+        else:
+            window_size = layer['kernel']
+            out_length = length // window_size
+            y = []
+            for position in range(out_length):
+                for channel in range(channels):
+                    values = [x[(position * window_size + k) * channels + channel] for k in range(window_size)]
+                    if kind == MAX_POOL:
+                        y.append(max(values))
+                    else:
+                        total = sum(values)
+                        half = window_size // 2
+                        y.append(tdiv(total + half if total >= 0 else total - half, window_size))
+            x, length = y, out_length
+    return x
+
+
+# -- float model --------------------------------------------------------------
+
+def run_float(model, window, ranges=None):
+    """Float forward pass; records the output range of each layer in ranges."""
+    length, channels = model['input']['length'], model['input']['channels']
+    x = [float(v) for v in window]
+    for index, layer in enumerate(model['layers']):
+        kind = TYPES[layer['type']]
+        if kind in (CONV1D, DENSE):
+            weights = layer['weights']
+            out_channels = len(weights)
+            if kind == CONV1D:
+                kernel, stride = layer['kernel'], layer.get('stride', 1)
+                flat = [[w for tap in row for w in tap] for row in weights]
+            else:
+                kernel, stride = length, 1
+                flat = weights
+            out_length = (length - kernel) // stride + 1
+            n = kernel * channels
+            y = []
+            for position in range(out_length):
+                values = x[position * stride * channels:position * stride * channels + n]
+                for row in range(out_channels):
+                    value = layer['bias'][row] + sum(a * w for a, w in zip(values, flat[row]))
+                    y.append(max(value, 0.0) if layer.get('relu') else value)
+            x, length, channels = y, out_length, out_channels
+        else:
+            window_size = layer['window']
+            out_length = length // window_size
+            y = []
+            for position in range(out_length):
+                for channel in range(channels):
+                    values = [x[(position * window_size + k) * channels + channel] for k in range(window_size)]
+                    y.append(max(values) if kind == MAX_POOL else sum(values) / window_size)
+            x, length = y, out_length
+        if ranges is not None:
+            low, high = ranges.get(index, (0.0, 0.0))
+            ranges[index] = (min(low, min(x)), max(high, max(x)))
+    return x
+
+
+def activation_quant(low, high):
+    """Scale and zero of an int8 tensor covering [low, high], 0 included."""
+    low, high = min(low, 0.0), max(high, 0.0)
+    scale = (high - low) / 255.0 or 1.0
+    zero = clamp(rnd(-128 - low / scale), -128, 127)
+    return scale, zero
+
+
+def quantize_multiplier(real):
+    """Q31 multiplier in [2^30, 2^31) and shift of a positive real."""
+    if real <= 0:
+        return 0, 0
+    mantissa, exponent = math.frexp(real)
+    multiplier = rnd(mantissa * (1 << 31))
+    if multiplier == 1 << 31:
+        multiplier //= 2
+        exponent += 1
+    if exponent < -31:
+        return 0, 0
+    if exponent > 30:
+        raise ValueError('layer scale %g out of range' % real)
+    return multiplier, exponent
+
+
+def quantize(model, windows):
+    """The integer model, from the float one and calibration windows."""
+    ranges = {}
+    raw_low, raw_high = 0, 0
+    for window, _ in windows:
+        run_float(model, window, ranges)
+        raw_low, raw_high = min(raw_low, min(window)), max(raw_high, max(window))
+
+    spec = model['input']
+    if 'scale' in spec:
+        in_scale, in_zero = float(spec['scale']), int(spec.get('zero', 0))
+    else:
+        in_scale, in_zero = activation_quant(raw_low, raw_high)
+    result = {
+        'length': spec['length'],
+        'channels': spec['channels'],
+        'labels': model['labels'],
+        'input_multiplier': rnd(65536.0 / in_scale),
+        'input_zero': in_zero,
+        'layers': [],
+    }
+
+    scale, zero = in_scale, in_zero
+    length, channels = spec['length'], spec['channels']
+    for index, layer in enumerate(model['layers']):
+        kind = TYPES[layer['type']]
+        out = {'type': kind, 'relu': bool(layer.get('relu')), 'in_length': length, 'in_channels': channels}
+        if kind in (CONV1D, DENSE):
+            if kind == CONV1D:
+                out['kernel'], out['stride'] = layer['kernel'], layer.get('stride', 1)
+                rows = [[w for tap in row for w in tap] for row in layer['weights']]
+                out_length = (length - out['kernel']) // out['stride'] + 1
+            else:
+                out['kernel'], out['stride'] = 0, 0
+                rows = layer['weights']
+                out_length = 1
+            out_scale, out_zero = activation_quant(*ranges[index])
+            if out['relu']:
+                out_scale, out_zero = activation_quant(0.0, ranges[index][1])
+            out['weights'], out['bias'], out['multipliers'], out['shifts'] = [], [], [], []
+            for row, bias in zip(rows, layer['bias']):
+                if len(row) != (length if kind == DENSE else out['kernel']) * channels:
+                    raise ValueError('layer %d: %d weights per output, %d inputs' % (index, len(row), length * channels))
+                largest = max(abs(w) for w in row)
+                weight_scale = largest / 127.0 if largest else 1.0
+                q = [clamp(rnd(w / weight_scale), -127, 127) for w in row]
+                out['weights'] += q
+                out['bias'].append(rnd(bias / (scale * weight_scale)) - zero * sum(q))
+                multiplier, shift = quantize_multiplier(scale * weight_scale / out_scale)
+                out['multipliers'].append(multiplier)
+                out['shifts'].append(shift)
+            out['out_channels'] = len(rows)
+            out['zero'] = out_zero
+            scale, zero = out_scale, out_zero
+            length, channels = out_length, len(rows)
+        else:
+            out['kernel'] = out['stride'] = layer['window']
+            out['out_channels'] = channels
+            out['zero'] = zero
+            length //= layer['window']
+        out['out_length'] = length
+        result['layers'].append(out)
+
+    if length * channels != len(model['labels']):
+        raise ValueError('%d outputs for %d labels' % (length * channels, len(model['labels'])))
+    result['output_scale'], result['output_zero'] = scale, zero
+    return result
+
+
+def blob(q):
+    """The bytes Int8Model::load() reads."""
+    layers = q['layers']
+    data = bytearray()
+    offsets = []
+    base = HEADER_SIZE + LAYER_SIZE * len(layers)
+
+    def put(chunk):
+        while (base + len(data)) % 4:
+            data.append(0)
+        at = base + len(data)
+        data.extend(chunk)
+        return at
+
+    for layer in layers:
+        if layer['type'] in (CONV1D, DENSE):
+            count = layer['out_channels']
+            offsets.append((put(struct.pack('<%db' % len(layer['weights']), *layer['weights'])),
+                            put(struct.pack('<%di' % count, *layer['bias'])),
+                            put(struct.pack('<%di' % count, *layer['multipliers'])),
+                            put(struct.pack('<%di' % count, *layer['shifts']))))
+        else:
+            offsets.append((0, 0, 0, 0))
+    labels = put(b''.join(label.encode('ascii') + b'\0' for label in q['labels']))
+    while (base + len(data)) % 4:
+        data.append(0)
+    size = base + len(data)
+
+    out = bytearray(b'LQ8M')
+    out += struct.pack('<HHHHHH', 1, len(layers), q['length'], q['channels'], len(q['labels']), 0)
+    out += struct.pack('<iifiII', q['input_multiplier'], q['input_zero'], q['output_scale'], q['output_zero'],
+                       labels, size)
+    for layer, (weights, bias, multipliers, shifts) in zip(layers, offsets):
+        out += struct.pack('<BBHHHHHHHiIIII', layer['type'], layer['relu'], layer['kernel'], layer['stride'],
+                           layer['in_length'], layer['in_channels'], layer['out_length'], layer['out_channels'],
+                           0, layer['zero'], weights, bias, multipliers, shifts)
+    return bytes(out + data)
+
+
+def arena_bytes(q):
+    largest = q['length'] * q['channels']
+    for layer in q['layers']:
+        largest = max(largest, layer['out_length'] * layer['out_channels'])
+    return 2 * ((largest + 3) & ~3)
+
+
+def c_rows(values, per_line, indent='    '):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append(indent + ', '.join(values[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def header(name, source, q, data):
+    macro = name.upper()
+    shape = '%d layers, %d x %d input, %d classes' % (len(q['layers']), q['length'], q['channels'],
+                                                      len(q['labels']))
+    return '\n'.join([
+        '/* Generated by lab-utils/ml/int8_model.py from %s: %s. Do not edit. */' % (source, shape),
+        '#ifndef LAB_%s_H' % macro,
+        '#define LAB_%s_H' % macro,
+        '',
+        '#include <cstddef>',
+        '#include <cstdint>',
+        '',
+        'namespace lab {',
+        '',
+        '/** Int8Model::arena_bytes() and the raw values of a window. */',
+        'static const size_t %s_ARENA = %d;' % (macro, arena_bytes(q)),
+        'static const size_t %s_WINDOW = %d;' % (macro, q['length'] * q['channels']),
+        '',
+        '/** %s */' % ', '.join(q['labels']),
+        'alignas(4) static const uint8_t %s[%d] = {' % (name, len(data)),
+        c_rows(['0x%02x' % b for b in data], 12),
+        '};',
+        '',
+        '} // namespace lab',
+        '',
+        '#endif // LAB_%s_H' % macro,
+        '',
+    ])
+
+
+def vectors_header(name, model_header, q, vectors):
+    macro = name.upper() + '_VECTORS'
+    lines = [
+        '/* Generated by lab-utils/ml/int8_model.py: windows and the logits %s must give. Do not edit. */'
+        % model_header,
+        '#ifndef LAB_%s_H' % macro,
+        '#define LAB_%s_H' % macro,
+        '',
+        '#include <cstddef>',
+        '#include <cstdint>',
+        '',
+        '#include "%s"' % model_header,
+        '',
+        'namespace lab {',
+        '',
+        'static const size_t %s = %d;' % (macro, len(vectors)),
+        '',
+        'static const int16_t %s_inputs[%d][%d] = {' % (name, len(vectors), q['length'] * q['channels']),
+    ]
+    for window, _, _ in vectors:
+        lines.append('    {')
+        lines.append(c_rows(['%d' % v for v in window], 12, '        '))
+        lines.append('    },')
+    lines.append('};')
+    lines.append('')
+    lines.append('static const int8_t %s_logits[%d][%d] = {' % (name, len(vectors), len(q['labels'])))
+    for _, logits, label in vectors:
+        lines.append('    { %s }, // %s' % (', '.join('%d' % v for v in logits), label))
+    lines += ['};', '', '} // namespace lab', '', '#endif // LAB_%s_H' % macro, '']
+    return '\n'.join(lines)
+
+
+# -- synthetic accelerometer windows ------------------------------------------
+
+def synthetic_window(kind, length, rng):
+    """One window of a board at rest, carried by someone walking, or shaken."""
+    # gravity in some orientation
+    theta, phi = rng.uniform(0, math.pi), rng.uniform(0, 2 * math.pi)
+    gravity = [1000 * math.sin(theta) * math.cos(phi), 1000 * math.sin(theta) * math.sin(phi), 1000 * math.cos(theta)]
+    axis = [rng.gauss(0, 1) for _ in range(3)]
+    norm = math.sqrt(sum(a * a for a in axis)) or 1.0
+    axis = [a / norm for a in axis]
+    if kind == 'walk':
+        hz, amplitude, noise = rng.uniform(1.6, 2.4), rng.uniform(150, 400), 15.0
+    elif kind == 'shake':
+        hz, amplitude, noise = rng.uniform(4.0, 7.0), rng.uniform(800, 1800), 30.0
+    else:
+        hz, amplitude, noise = 0.0, 0.0, 4.0
+    phase = rng.uniform(0, 2 * math.pi)
+    window = []
+    for t in range(length):
+        angle = 2 * math.pi * hz * t / SAMPLE_HZ + phase
+        motion = amplitude * (math.sin(angle) + 0.3 * math.sin(2 * angle + 1.0))
+        for c in range(3):
+            value = gravity[c] + motion * axis[c] + rng.gauss(0, noise)
+            window.append(clamp(int(round(value)), -FULL_SCALE_MG, FULL_SCALE_MG))
+    return window
+
+
+def synthetic_windows(count, length, seed):
+    rng = random.Random(seed)
+    kinds = ['still', 'walk', 'shake']
+    return [(synthetic_window(kinds[i % 3], length, rng), kinds[i % 3]) for i in range(count)]
+
+
+def read_windows(path):
+    windows = {}
+    order = []
+    with open(path) as f:
+        for line in f:
+            fields = line.strip().split(',')
+            if len(fields) < 3 or fields[0] == 'window':
+                continue
+            key = fields[0]
+            if key not in windows:
+                windows[key] = ([], fields[1])
+                order.append(key)
+            windows[key][0].extend(int(v) for v in fields[2:])
+    return [windows[key] for key in order]
+
+
+# -- commands -----------------------------------------------------------------
+
+def demo_model():
+    """
+    A motion intensity model built by hand rather than trained: the
+    convolution takes the rectified sample to sample change of each axis,
+    the pool its mean over the window, and the dense layer splits the sum,
+    in mg per sample, at 25 (still or walking) and 200 (walking or shaken).
+    """
+    conv_weights = []
+    for axis in range(3):
+        for sign in (1, -1):
+            taps = [[0.0] * 3, [0.0] * 3]
+            taps[0][axis], taps[1][axis] = -sign, sign
+            conv_weights.append(taps)
+    slope_walk, slope_shake = 0.05, 0.04
+    still_walk, walk_shake = 25.0, 200.0
+    dense = [[0.0] * 6, [slope_walk] * 6, [slope_walk + slope_shake] * 6]
+    bias = [0.0, -slope_walk * still_walk, -slope_walk * still_walk - slope_shake * walk_shake]
+    return {
+        'input': {'length': 64, 'channels': 3, 'scale': 16.0, 'zero': 0},
+        'labels': ['still', 'walk', 'shake'],
+        'layers': [
+            {'type': 'conv1d', 'kernel': 2, 'stride': 1, 'relu': True, 'weights': conv_weights, 'bias': [0.0] * 6},
+            {'type': 'avg_pool', 'window': 63},
+            {'type': 'dense', 'relu': False, 'weights': dense, 'bias': bias},
+        ],
+    }
+
+
+def argmax(values):
+    return max(range(len(values)), key=lambda k: values[k])
+
+
+def demo_command(args):
+    with open(args.output, 'w') as f:
+        json.dump(demo_model(), f, indent=1)
+        f.write('\n')
+    return 0
+
+
+def synth_command(args):
+    with open(args.output, 'w') as f:
+        f.write('window,label,x,y,z\n')
+        for index, (window, label) in enumerate(synthetic_windows(args.windows, args.length, args.seed)):
+            for t in range(0, len(window), 3):
+                f.write('%d,%s,%d,%d,%d\n' % (index, label, window[t], window[t + 1], window[t + 2]))
+    return 0
+
+
+def quantize_command(args):
+    with open(args.model) as f:
+        model = json.load(f)
+    length = model['input']['length']
+    if args.calibration:
+        windows = read_windows(args.calibration)
+    else:
+        windows = synthetic_windows(300, length, args.seed)
+    windows = [w for w in windows if len(w[0]) == length * model['input']['channels']]
+    if not windows:
+        print('int8_model: no calibration window of %d samples' % length, file=sys.stderr)
+        return 1
+
+    q = quantize(model, windows)
+    data = blob(q)
+    name = args.name or os.path.splitext(os.path.basename(args.output))[0].lower()
+    with open(args.output, 'w') as f:
+        f.write(header(name, os.path.basename(args.model), q, data))
+
+    labels = model['labels']
+    float_right = int8_right = agree = 0
+    vectors = []
+    taken = {}
+    for window, label in windows:
+        expected = run_float(model, window)
+        logits = run_int8(q, window)
+        float_right += labels[argmax(expected)] == label
+        int8_right += labels[argmax(logits)] == label
+        agree += argmax(expected) == argmax(logits)
+        if taken.get(label, 0) < args.per_label:
+            taken[label] = taken.get(label, 0) + 1
+            vectors.append((window, logits, label))
+    print('%s: %d bytes, arena %d bytes, %d windows: float %.1f %%, int8 %.1f %%, %.1f %% the same label'
+          % (args.output, len(data), arena_bytes(q), len(windows), 100.0 * float_right / len(windows),
+             100.0 * int8_right / len(windows), 100.0 * agree / len(windows)))
+
+    if args.vectors:
+        with open(args.vectors, 'w') as f:
+            f.write(vectors_header(name, os.path.basename(args.output), q, vectors))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    commands = parser.add_subparsers(dest='command')
+    demo = commands.add_parser('demo', help='write the float activity model')
+    demo.add_argument('-o', '--output', required=True)
+    synth = commands.add_parser('synth', help='write synthetic accelerometer windows')
+    synth.add_argument('--windows', type=int, default=300)
+    synth.add_argument('--length', type=int, default=64)
+    synth.add_argument('--seed', type=int, default=1)
+    synth.add_argument('-o', '--output', required=True)
+    quant = commands.add_parser('quantize', help='quantize a float model into a header')
+    quant.add_argument('model')
+    quant.add_argument('-o', '--output', required=True)
+    quant.add_argument('--name')
+    quant.add_argument('--calibration')
+    quant.add_argument('--seed', type=int, default=1)
+    quant.add_argument('--vectors')
+    quant.add_argument('--per-label', type=int, default=2)
+    args = parser.parse_args()
+    if args.command == 'demo':
+        return demo_command(args)
+    if args.command == 'synth':
+        return synth_command(args)
+    if args.command == 'quantize':
+        return quantize_command(args)
+    parser.print_help()
+    return 2
+
+
+if __name__ == '__main__':
+    sys.exit(main())
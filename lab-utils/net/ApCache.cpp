@@ -0,0 +1,173 @@
+#include "ApCache.h"
+
+#include <cstring>
+
+#include "Crc32.h"
+
+namespace lab {
+
+/*
+ * Slot, little endian:
+ *   0  u16 magic
+ *   2  u8  channel
+ *   3  u8  security
+ *   4  u8  bssid[6]
+ *   10 u8  ssid length
+ *   11 u8  ssid[32]
+ *   43 u8  reserved[17], 0xFF
+ *   60 u32 CRC-32 of bytes 0-59
+ * An erased slot ends the sequence; the last valid slot wins.
+ */
+static const uint16_t SLOT_MAGIC = 0x4150;
+static const size_t CRC_OFFSET = ApCache::SLOT_SIZE - 4;
+
+static bool same_bssid(const ApInfo &a, const ApInfo &b)
+{
+    return memcmp(a.bssid, b.bssid, sizeof(a.bssid)) == 0;
+}
+
+static bool same_ap(const ApInfo &a, const ApInfo &b)
+{
+    return same_bssid(a, b) && a.channel == b.channel && a.security == b.security && strcmp(a.ssid, b.ssid) == 0;
+}
+
+ApCache::ApCache(FlashDevice &flash, uint32_t address) :
+    _flash(flash),
+    _address(address),
+    _has_last(false),
+    _next_slot(0),
+    _writes(0),
+    _count(0)
+{
+    memset(&_last, 0, sizeof(_last));
+}
+
+uint32_t ApCache::slot_count() const
+{
+    return _flash.sector_size() / SLOT_SIZE;
+}
+
+bool ApCache::load()
+{
+    uint8_t slot[SLOT_SIZE];
+
+    _has_last = false;
+    _next_slot = slot_count();
+    for (uint32_t i = 0; i < slot_count(); i++) {
+        if (_flash.read(_address + i * SLOT_SIZE, slot, SLOT_SIZE)) {
+            return false;
+        }
+        uint16_t magic = slot[0] | (slot[1] << 8);
+        if (magic == 0xFFFF) {
+            _next_slot = i;
+            break;
+        }
+        uint32_t crc = slot[CRC_OFFSET] | (slot[CRC_OFFSET + 1] << 8) | (slot[CRC_OFFSET + 2] << 16) |
+                       ((uint32_t)slot[CRC_OFFSET + 3] << 24);
+        // a torn slot is skipped, the one before it still holds
+        if (magic != SLOT_MAGIC || crc != crc32(slot, CRC_OFFSET) || slot[10] > 32) {
+            continue;
+        }
+        _last.channel = slot[2];
+        _last.security = slot[3];
+        memcpy(_last.bssid, slot + 4, sizeof(_last.bssid));
+        memcpy(_last.ssid, slot + 11, slot[10]);
+        _last.ssid[slot[10]] = '\0';
+        _last.rssi = 0;
+        _has_last = true;
+    }
+    return _has_last;
+}
+
+int ApCache::remember(const ApInfo &ap)
+{
+    if (_has_last && same_ap(_last, ap)) {
+        return 0;
+    }
+
+    if (_next_slot >= slot_count()) {
+        int err = _flash.erase(_address, _flash.sector_size());
+        if (err) {
+            return err;
+        }
+        _next_slot = 0;
+    }
+
+    uint8_t slot[SLOT_SIZE];
+    size_t ssid_length = strnlen(ap.ssid, 32);
+    memset(slot, 0xFF, sizeof(slot));
+    slot[0] = SLOT_MAGIC & 0xFF;
+    slot[1] = SLOT_MAGIC >> 8;
+    slot[2] = ap.channel;
+    slot[3] = ap.security;
+    memcpy(slot + 4, ap.bssid, sizeof(ap.bssid));
+    slot[10] = ssid_length;
+    memcpy(slot + 11, ap.ssid, ssid_length);
+    uint32_t crc = crc32(slot, CRC_OFFSET);
+    for (int i = 0; i < 4; i++) {
+        slot[CRC_OFFSET + i] = crc >> (8 * i);
+    }
+
+    int err = _flash.program(_address + _next_slot * SLOT_SIZE, slot, SLOT_SIZE);
+    _next_slot++;
+    _writes++;
+    if (err) {
+        return err;
+    }
+    _last = ap;
+    _last.ssid[ssid_length] = '\0';
+    _has_last = true;
+    return 0;
+}
+
+void ApCache::merge(const ApInfo *results, size_t count, const char *ssid)
+{
+    for (size_t i = 0; i < _count; i++) {
+        _candidates[i].misses++;
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        if (strcmp(results[r].ssid, ssid) != 0) {
+            continue;
+        }
+        size_t i = 0;
+        while (i < _count && !same_bssid(_candidates[i].ap, results[r])) {
+            i++;
+        }
+        if (i < _count) {
+            // smooth out single readings, RSSI jumps by several dB between scans
+            int rssi = (_candidates[i].ap.rssi + results[r].rssi) / 2;
+            _candidates[i].ap = results[r];
+            _candidates[i].ap.rssi = rssi;
+            _candidates[i].misses = 0;
+        } else if (_count < MAX_CANDIDATES) {
+            _candidates[_count].ap = results[r];
+            _candidates[_count].misses = 0;
+            _count++;
+        } else if (results[r].rssi > _candidates[_count - 1].ap.rssi) {
+            _candidates[_count - 1].ap = results[r];
+            _candidates[_count - 1].misses = 0;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < _count; i++) {
+        if (_candidates[i].misses < MAX_MISSES) {
+            _candidates[kept++] = _candidates[i];
+        }
+    }
+    _count = kept;
+
+    // insertion sort, the list is short and mostly in order already
+    for (size_t i = 1; i < _count; i++) {
+        Candidate moving = _candidates[i];
+        size_t j = i;
+        while (j > 0 && _candidates[j - 1].ap.rssi < moving.ap.rssi) {
+            _candidates[j] = _candidates[j - 1];
+            j--;
+        }
+        _candidates[j] = moving;
+    }
+}
+
+} // namespace lab
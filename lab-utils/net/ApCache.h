@@ -0,0 +1,94 @@
+#ifndef LAB_AP_CACHE_H
+#define LAB_AP_CACHE_H
+
+#include "FlashDevice.h"
+#include "WifiRadio.h"
+
+namespace lab {
+
+/**
+ * Last good access point, kept in flash, and a list of candidates ranked
+ * by signal.
+ *
+ * The last good AP lives in one reserved flash sector as a sequence of
+ * 64-byte slots with a CRC; remember() programs the next slot and only
+ * erases the sector once it is full, and writes nothing when the AP did
+ * not change, so a reboot costs no flash wear.
+ *
+ * merge() folds scan results for one SSID into the candidates: known
+ * BSSIDs get their RSSI averaged with the new reading, new ones are
+ * added, and entries missing from MAX_MISSES scans in a row are dropped.
+ */
+class ApCache {
+public:
+    static const size_t MAX_CANDIDATES = 8;
+    static const uint8_t MAX_MISSES = 3;
+    static const size_t SLOT_SIZE = 64;
+
+    /** @param[in] address start of a flash sector reserved for the cache. */
+    ApCache(FlashDevice &flash, uint32_t address);
+
+    /**
+     * Read the last good AP from flash.
+     *
+     * @return true if one was found.
+     */
+    bool load();
+
+    /** Store ap as the last good AP. @return 0, or a flash error. */
+    int remember(const ApInfo &ap);
+
+    /** Drop the last good AP from memory, e.g. after it failed. */
+    void forget()
+    {
+        _has_last = false;
+    }
+
+    /** @return the last good AP, or nullptr. */
+    const ApInfo *last_good() const
+    {
+        return _has_last ? &_last : nullptr;
+    }
+
+    /** Fold scan results into the candidates, keeping only ssid. */
+    void merge(const ApInfo *results, size_t count, const char *ssid);
+
+    size_t candidate_count() const
+    {
+        return _count;
+    }
+
+    /** Candidates from the strongest down. */
+    const ApInfo &candidate(size_t index) const
+    {
+        return _candidates[index].ap;
+    }
+
+    /** Flash slots programmed since construction. */
+    uint32_t writes() const
+    {
+        return _writes;
+    }
+
+private:
+    struct Candidate {
+        ApInfo ap;
+        uint8_t misses;
+    };
+
+    uint32_t slot_count() const;
+
+    FlashDevice &_flash;
+    uint32_t _address;
+    ApInfo _last;
+    bool _has_last;
+    uint32_t _next_slot;
+    uint32_t _writes;
+
+    Candidate _candidates[MAX_CANDIDATES];
+    size_t _count;
+};
+
+} // namespace lab
+
+#endif // LAB_AP_CACHE_H
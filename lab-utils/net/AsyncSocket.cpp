@@ -0,0 +1,202 @@
+#include "AsyncSocket.h"
+
+#include <cstring>
+
+namespace lab {
+
+AsyncSocket::AsyncSocket() :
+    _state(STATE_CLOSED),
+    _port(0),
+    _buffer_count(0),
+    _buffer_index(0),
+    _sent(0),
+    _recv_data(nullptr),
+    _recv_capacity(0)
+{
+    _address[0] = '\0';
+    _connect.done = nullptr;
+    _send.done = nullptr;
+    _recv.done = nullptr;
+}
+
+void AsyncSocket::start(Operation &op, Completion done, void *context, uint32_t now_us, uint32_t timeout_ms)
+{
+    op.done = done;
+    op.context = context;
+    op.deadline_us = now_us + timeout_ms * 1000;
+}
+
+void AsyncSocket::finish(Operation &op, int result)
+{
+    // clear first, the completion may start the next operation
+    Completion done = op.done;
+    op.done = nullptr;
+    if (done) {
+        done(op.context, result);
+    }
+}
+
+bool AsyncSocket::expired(const Operation &op, uint32_t now_us)
+{
+    return op.done && (int32_t)(now_us - op.deadline_us) >= 0;
+}
+
+int AsyncSocket::connect(const char *address, uint16_t port, uint32_t timeout_ms, Completion done, void *context)
+{
+    if (_state != STATE_CLOSED || !done) {
+        return ASYNC_BUSY;
+    }
+    if (strlen(address) >= sizeof(_address)) {
+        return ASYNC_ERROR;
+    }
+    if (io_open() != ASYNC_OK) {
+        return ASYNC_ERROR;
+    }
+
+    strcpy(_address, address);
+    _port = port;
+    _state = STATE_CONNECTING;
+    start(_connect, done, context, io_now_us(), timeout_ms);
+    io_schedule();
+    return ASYNC_OK;
+}
+
+int AsyncSocket::send(const AsyncBuffer *buffers, size_t count, uint32_t timeout_ms, Completion done, void *context)
+{
+    if (_state != STATE_CONNECTED) {
+        return ASYNC_CLOSED;
+    }
+    if (sending() || !done || count == 0 || count > MAX_BUFFERS) {
+        return ASYNC_BUSY;
+    }
+
+    memcpy(_buffers, buffers, count * sizeof(AsyncBuffer));
+    _buffer_count = count;
+    _buffer_index = 0;
+    _sent = 0;
+    start(_send, done, context, io_now_us(), timeout_ms);
+    io_schedule();
+    return ASYNC_OK;
+}
+
+int AsyncSocket::recv(void *data, size_t capacity, uint32_t timeout_ms, Completion done, void *context)
+{
+    if (_state != STATE_CONNECTED) {
+        return ASYNC_CLOSED;
+    }
+    if (receiving() || !done || capacity == 0) {
+        return ASYNC_BUSY;
+    }
+
+    _recv_data = data;
+    _recv_capacity = capacity;
+    start(_recv, done, context, io_now_us(), timeout_ms);
+    io_schedule();
+    return ASYNC_OK;
+}
+
+void AsyncSocket::close()
+{
+    if (_state != STATE_CLOSED) {
+        io_close();
+        _state = STATE_CLOSED;
+    }
+    fail_all(ASYNC_ABORTED);
+}
+
+void AsyncSocket::fail_all(int result)
+{
+    finish(_connect, result);
+    finish(_send, result);
+    finish(_recv, result);
+}
+
+bool AsyncSocket::wants_write() const
+{
+    return _state == STATE_CONNECTING || (_state == STATE_CONNECTED && sending());
+}
+
+bool AsyncSocket::wants_read() const
+{
+    return _state == STATE_CONNECTED && receiving();
+}
+
+int32_t AsyncSocket::next_deadline(uint32_t now_us) const
+{
+    const Operation *ops[] = { &_connect, &_send, &_recv };
+    int32_t next = -1;
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (!ops[i]->done) {
+            continue;
+        }
+        int32_t wait = (int32_t)(ops[i]->deadline_us - now_us);
+        wait = wait < 0 ? 0 : wait;
+        if (next < 0 || wait < next) {
+            next = wait;
+        }
+    }
+    return next;
+}
+
+void AsyncSocket::process(uint32_t now_us)
+{
+    if (_state == STATE_CONNECTING) {
+        int result = io_connect(_address, _port);
+        if (result == ASYNC_OK) {
+            _state = STATE_CONNECTED;
+            finish(_connect, ASYNC_OK);
+        } else if (result != ASYNC_WOULD_BLOCK || expired(_connect, now_us)) {
+            io_close();
+            _state = STATE_CLOSED;
+            finish(_connect, result == ASYNC_WOULD_BLOCK ? ASYNC_TIMEOUT : result);
+        }
+    }
+
+    // a completion may have closed the socket
+    while (_state == STATE_CONNECTED && sending()) {
+        int result = io_send(_buffers + _buffer_index, _buffer_count - _buffer_index);
+        if (result == ASYNC_WOULD_BLOCK || result == 0) {
+            if (expired(_send, now_us)) {
+                finish(_send, ASYNC_TIMEOUT);
+            }
+            break;
+        }
+        if (result < 0) {
+            io_close();
+            _state = STATE_CLOSED;
+            fail_all(result);
+            return;
+        }
+
+        // skip what went out, possibly ending inside a buffer
+        _sent += result;
+        size_t left = result;
+        while (_buffer_index < _buffer_count && left >= _buffers[_buffer_index].length) {
+            left -= _buffers[_buffer_index].length;
+            _buffer_index++;
+        }
+        if (_buffer_index < _buffer_count) {
+            _buffers[_buffer_index].data = static_cast<const uint8_t *>(_buffers[_buffer_index].data) + left;
+            _buffers[_buffer_index].length -= left;
+        } else {
+            finish(_send, (int)_sent);
+        }
+    }
+
+    if (_state == STATE_CONNECTED && receiving()) {
+        int result = io_recv(_recv_data, _recv_capacity);
+        if (result == ASYNC_WOULD_BLOCK) {
+            if (expired(_recv, now_us)) {
+                finish(_recv, ASYNC_TIMEOUT);
+            }
+        } else if (result == ASYNC_CLOSED || result < 0) {
+            io_close();
+            _state = STATE_CLOSED;
+            fail_all(result);
+        } else {
+            finish(_recv, result);
+        }
+    }
+}
+
+} // namespace lab
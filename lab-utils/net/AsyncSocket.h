@@ -0,0 +1,170 @@
+#ifndef LAB_ASYNC_SOCKET_H
+#define LAB_ASYNC_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** Results passed to completions, besides byte counts. */
+enum AsyncStatus {
+    ASYNC_OK = 0,
+    ASYNC_WOULD_BLOCK = -1,
+    ASYNC_TIMEOUT = -2,
+    ASYNC_CLOSED = -3,
+    ASYNC_BUSY = -4,
+    ASYNC_ABORTED = -5,
+    ASYNC_ERROR = -6,
+};
+
+/** One pre-serialised piece of a gathered send. */
+struct AsyncBuffer {
+    const void *data;
+    size_t length;
+};
+
+/**
+ * Non-blocking TCP client socket with completion callbacks.
+ *
+ * connect(), send() and recv() start an operation and return at once;
+ * its completion runs later from the platform's dispatch context (an
+ * EventQueue on Mbed, the poll loop on Linux) with a byte count or an
+ * AsyncStatus. One send and one receive can be pending together. Every
+ * operation has an explicit timeout, after which it completes with
+ * ASYNC_TIMEOUT; bytes already sent by a timed out send are lost for the
+ * caller, so the connection should be closed.
+ *
+ * A send gathers up to MAX_BUFFERS frames that stay owned by the caller
+ * until the completion; nothing is copied.
+ *
+ * This class holds the operation state machine; a platform subclass
+ * supplies the io_* primitives and calls process() whenever the socket
+ * may have progressed or a deadline passed.
+ */
+class AsyncSocket {
+public:
+    typedef void (*Completion)(void *context, int result);
+
+    static const size_t MAX_BUFFERS = 8;
+
+    AsyncSocket();
+    virtual ~AsyncSocket() {}
+
+    /**
+     * Open and connect to an IPv4 address.
+     *
+     * @return ASYNC_OK if started, ASYNC_BUSY if an operation is pending.
+     * The completion gets ASYNC_OK once connected.
+     */
+    int connect(const char *address, uint16_t port, uint32_t timeout_ms, Completion done, void *context);
+
+    /**
+     * Send the buffers in order.
+     *
+     * @return ASYNC_OK if started, ASYNC_BUSY or ASYNC_CLOSED. The
+     * completion gets the total length once everything was sent.
+     */
+    int send(const AsyncBuffer *buffers, size_t count, uint32_t timeout_ms, Completion done, void *context);
+
+    /**
+     * Receive what is available, up to capacity bytes.
+     *
+     * @return ASYNC_OK if started, ASYNC_BUSY or ASYNC_CLOSED. The
+     * completion gets the byte count, or ASYNC_CLOSED if the peer closed.
+     */
+    int recv(void *data, size_t capacity, uint32_t timeout_ms, Completion done, void *context);
+
+    /** Close; pending operations complete with ASYNC_ABORTED. */
+    void close();
+
+    bool connected() const
+    {
+        return _state == STATE_CONNECTED;
+    }
+
+    bool sending() const
+    {
+        return _send.done != nullptr;
+    }
+
+    bool receiving() const
+    {
+        return _recv.done != nullptr;
+    }
+
+protected:
+    /**
+     * Advance pending operations and expire timeouts. Must run in the
+     * dispatch context; completions are called from here.
+     */
+    void process(uint32_t now_us);
+
+    /**
+     * Time until the earliest pending deadline.
+     *
+     * @return microseconds, or -1 if nothing waits.
+     */
+    int32_t next_deadline(uint32_t now_us) const;
+
+    /** Connection stage the platform should watch for. */
+    bool wants_write() const;
+    bool wants_read() const;
+
+    /** @return ASYNC_OK or ASYNC_ERROR. */
+    virtual int io_open() = 0;
+
+    /** @return ASYNC_OK once connected, ASYNC_WOULD_BLOCK or an error. */
+    virtual int io_connect(const char *address, uint16_t port) = 0;
+
+    /** @return bytes accepted, ASYNC_WOULD_BLOCK or an error. */
+    virtual int io_send(const AsyncBuffer *buffers, size_t count) = 0;
+
+    /** @return bytes read, ASYNC_CLOSED, ASYNC_WOULD_BLOCK or an error. */
+    virtual int io_recv(void *data, size_t capacity) = 0;
+
+    virtual void io_close() = 0;
+
+    virtual uint32_t io_now_us() = 0;
+
+    /** Have process() called soon, from the dispatch context. */
+    virtual void io_schedule() = 0;
+
+private:
+    enum State {
+        STATE_CLOSED,
+        STATE_CONNECTING,
+        STATE_CONNECTED,
+    };
+
+    struct Operation {
+        Completion done;
+        void *context;
+        uint32_t deadline_us;
+    };
+
+    static void start(Operation &op, Completion done, void *context, uint32_t now_us, uint32_t timeout_ms);
+    static void finish(Operation &op, int result);
+    static bool expired(const Operation &op, uint32_t now_us);
+
+    void fail_all(int result);
+
+    State _state;
+    char _address[16];
+    uint16_t _port;
+
+    Operation _connect;
+
+    Operation _send;
+    AsyncBuffer _buffers[MAX_BUFFERS];
+    size_t _buffer_count;
+    size_t _buffer_index;
+    size_t _sent;
+
+    Operation _recv;
+    void *_recv_data;
+    size_t _recv_capacity;
+};
+
+} // namespace lab
+
+#endif // LAB_ASYNC_SOCKET_H
@@ -0,0 +1,135 @@
+#include "MbedAsyncSocket.h"
+
+#include "hal/us_ticker_api.h"
+
+using namespace std::chrono;
+
+namespace lab {
+
+MbedAsyncSocket::MbedAsyncSocket(NetworkInterface *net, events::EventQueue &queue) :
+    _net(net),
+    _queue(queue),
+    _dispatch_pending(false),
+    _timer_id(0)
+{
+}
+
+MbedAsyncSocket::~MbedAsyncSocket()
+{
+    _socket.sigio(nullptr);
+    _socket.close();
+    if (_timer_id) {
+        _queue.cancel(_timer_id);
+    }
+}
+
+int MbedAsyncSocket::io_open()
+{
+    if (_socket.open(_net) != NSAPI_ERROR_OK) {
+        return ASYNC_ERROR;
+    }
+    _socket.set_blocking(false);
+    _socket.sigio(mbed::callback(this, &MbedAsyncSocket::on_sigio));
+    return ASYNC_OK;
+}
+
+int MbedAsyncSocket::io_connect(const char *address, uint16_t port)
+{
+    SocketAddress peer;
+    if (!peer.set_ip_address(address)) {
+        return ASYNC_ERROR;
+    }
+    peer.set_port(port);
+
+    switch (_socket.connect(peer)) {
+        case NSAPI_ERROR_OK:
+        case NSAPI_ERROR_IS_CONNECTED:
+            return ASYNC_OK;
+        case NSAPI_ERROR_IN_PROGRESS:
+        case NSAPI_ERROR_ALREADY:
+        case NSAPI_ERROR_WOULD_BLOCK:
+            return ASYNC_WOULD_BLOCK;
+        default:
+            return ASYNC_ERROR;
+    }
+}
+
+int MbedAsyncSocket::io_send(const AsyncBuffer *buffers, size_t count)
+{
+    // no gather in the netsocket API: send the frames back to back until
+    // the driver pushes back
+    int total = 0;
+    for (size_t i = 0; i < count; i++) {
+        nsapi_size_or_error_t sent = _socket.send(buffers[i].data, buffers[i].length);
+        if (sent == NSAPI_ERROR_WOULD_BLOCK) {
+            return total ? total : ASYNC_WOULD_BLOCK;
+        }
+        if (sent < 0) {
+            return total ? total : ASYNC_ERROR;
+        }
+        total += sent;
+        if ((size_t)sent < buffers[i].length) {
+            break;
+        }
+    }
+    return total;
+}
+
+int MbedAsyncSocket::io_recv(void *data, size_t capacity)
+{
+    nsapi_size_or_error_t received = _socket.recv(data, capacity);
+    if (received == NSAPI_ERROR_WOULD_BLOCK) {
+        return ASYNC_WOULD_BLOCK;
+    }
+    if (received == 0) {
+        return ASYNC_CLOSED;
+    }
+    return received < 0 ? ASYNC_ERROR : received;
+}
+
+void MbedAsyncSocket::io_close()
+{
+    _socket.sigio(nullptr);
+    _socket.close();
+}
+
+uint32_t MbedAsyncSocket::io_now_us()
+{
+    return us_ticker_read();
+}
+
+void MbedAsyncSocket::io_schedule()
+{
+    on_sigio();
+}
+
+void MbedAsyncSocket::on_sigio()
+{
+    // one queued pass handles every event raised until it runs
+    if (!_dispatch_pending.exchange(true, std::memory_order_acq_rel)) {
+        if (_queue.call(this, &MbedAsyncSocket::dispatch) == 0) {
+            _dispatch_pending.store(false, std::memory_order_release);
+        }
+    }
+}
+
+void MbedAsyncSocket::dispatch()
+{
+    _dispatch_pending.store(false, std::memory_order_release);
+    if (_timer_id) {
+        _queue.cancel(_timer_id);
+        _timer_id = 0;
+    }
+
+    uint32_t now = us_ticker_read();
+    process(now);
+
+    int32_t next = next_deadline(us_ticker_read());
+    if (next >= 0) {
+        // round up so the timer never fires before the deadline it waits for
+        milliseconds delay((next + 999) / 1000);
+        _timer_id = _queue.call_in(delay, this, &MbedAsyncSocket::dispatch);
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,53 @@
+#ifndef LAB_MBED_ASYNC_SOCKET_H
+#define LAB_MBED_ASYNC_SOCKET_H
+
+#include <atomic>
+
+#include "mbed.h"
+#include "events/EventQueue.h"
+#include "netsocket/TCPSocket.h"
+
+#include "AsyncSocket.h"
+
+namespace lab {
+
+/**
+ * AsyncSocket on a non-blocking Mbed TCPSocket.
+ *
+ * The socket sigio callback, which drivers raise from their own thread or
+ * interrupt, only posts one coalesced event to the queue; all socket
+ * calls and every completion run from that queue, next to whatever else
+ * the application dispatches there (e.g. sensor sampling). Timeouts are
+ * queue timers.
+ *
+ * With the ISM43362 module each non-blocking call is still one SPI AT
+ * exchange, but none of them waits for the network any more.
+ */
+class MbedAsyncSocket : public AsyncSocket, private mbed::NonCopyable<MbedAsyncSocket> {
+public:
+    MbedAsyncSocket(NetworkInterface *net, events::EventQueue &queue);
+    ~MbedAsyncSocket() override;
+
+protected:
+    int io_open() override;
+    int io_connect(const char *address, uint16_t port) override;
+    int io_send(const AsyncBuffer *buffers, size_t count) override;
+    int io_recv(void *data, size_t capacity) override;
+    void io_close() override;
+    uint32_t io_now_us() override;
+    void io_schedule() override;
+
+private:
+    void on_sigio();
+    void dispatch();
+
+    NetworkInterface *_net;
+    events::EventQueue &_queue;
+    TCPSocket _socket;
+    std::atomic<bool> _dispatch_pending;
+    int _timer_id;
+};
+
+} // namespace lab
+
+#endif // LAB_MBED_ASYNC_SOCKET_H
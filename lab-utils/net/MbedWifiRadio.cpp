@@ -0,0 +1,63 @@
+#include "MbedWifiRadio.h"
+
+#include <cstring>
+
+#include "netsocket/WiFiAccessPoint.h"
+
+namespace lab {
+
+MbedWifiRadio::MbedWifiRadio(WiFiInterface &wifi, PoolAllocator &buffers) :
+    _wifi(wifi),
+    _buffers(buffers)
+{
+}
+
+int MbedWifiRadio::scan(ApInfo *results, size_t capacity)
+{
+    PoolArray<WiFiAccessPoint> ap(_buffers, capacity);
+    if (!ap) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+
+    int count = _wifi.scan(ap.data(), capacity);
+    for (int i = 0; i < count; i++) {
+        strncpy(results[i].ssid, ap[i].get_ssid(), sizeof(results[i].ssid) - 1);
+        results[i].ssid[sizeof(results[i].ssid) - 1] = '\0';
+        memcpy(results[i].bssid, ap[i].get_bssid(), sizeof(results[i].bssid));
+        results[i].channel = ap[i].get_channel();
+        results[i].security = ap[i].get_security();
+        results[i].rssi = ap[i].get_rssi();
+    }
+    return count;
+}
+
+int MbedWifiRadio::connect(const char *ssid, const char *password, const ApInfo *target)
+{
+    nsapi_security_t security = NSAPI_SECURITY_WPA_WPA2;
+    uint8_t channel = 0;
+    if (target) {
+        security = (nsapi_security_t)target->security;
+        channel = target->channel;
+    }
+
+    if (_wifi.set_channel(channel) != NSAPI_ERROR_OK) {
+        _wifi.set_channel(0);
+    }
+    nsapi_error_t err = _wifi.set_credentials(ssid, password, security);
+    if (err != NSAPI_ERROR_OK) {
+        return err;
+    }
+    return _wifi.connect();
+}
+
+int MbedWifiRadio::disconnect()
+{
+    return _wifi.disconnect();
+}
+
+int8_t MbedWifiRadio::rssi()
+{
+    return _wifi.get_rssi();
+}
+
+} // namespace lab
@@ -0,0 +1,36 @@
+#ifndef LAB_MBED_WIFI_RADIO_H
+#define LAB_MBED_WIFI_RADIO_H
+
+#include "mbed.h"
+#include "netsocket/WiFiInterface.h"
+
+#include "PoolAllocator.h"
+#include "WifiRadio.h"
+
+namespace lab {
+
+/**
+ * WifiRadio on an Mbed WiFiInterface.
+ *
+ * A targeted connect passes the cached security and channel. Modules
+ * that cannot pin a channel (the ISM43362 firmware always searches by
+ * SSID) still save the explicit scan and the security negotiation.
+ */
+class MbedWifiRadio : public WifiRadio {
+public:
+    /** @param[in] buffers temporary WiFiAccessPoint arrays for scan(). */
+    MbedWifiRadio(WiFiInterface &wifi, PoolAllocator &buffers);
+
+    int scan(ApInfo *results, size_t capacity) override;
+    int connect(const char *ssid, const char *password, const ApInfo *target) override;
+    int disconnect() override;
+    int8_t rssi() override;
+
+private:
+    WiFiInterface &_wifi;
+    PoolAllocator &_buffers;
+};
+
+} // namespace lab
+
+#endif // LAB_MBED_WIFI_RADIO_H
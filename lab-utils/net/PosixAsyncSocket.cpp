@@ -0,0 +1,224 @@
+#include "PosixAsyncSocket.h"
+
+#if !defined(__MBED__)
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace lab {
+
+PosixAsyncSocket::PosixAsyncSocket(PosixAsyncLoop &loop) :
+    _loop(loop),
+    _fd(-1),
+    _registered(false),
+    _connect_started(false),
+    _scheduled(false)
+{
+    _registered = _loop.add(this);
+}
+
+PosixAsyncSocket::~PosixAsyncSocket()
+{
+    io_close();
+    _loop.remove(this);
+}
+
+int PosixAsyncSocket::io_open()
+{
+    // the loop would never poll it
+    if (!_registered) {
+        return ASYNC_ERROR;
+    }
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) {
+        return ASYNC_ERROR;
+    }
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+    _connect_started = false;
+    return ASYNC_OK;
+}
+
+int PosixAsyncSocket::io_connect(const char *address, uint16_t port)
+{
+    if (!_connect_started) {
+        sockaddr_in peer = {};
+        peer.sin_family = AF_INET;
+        peer.sin_port = htons(port);
+        if (inet_pton(AF_INET, address, &peer.sin_addr) != 1) {
+            return ASYNC_ERROR;
+        }
+        _connect_started = true;
+        if (::connect(_fd, reinterpret_cast<sockaddr *>(&peer), sizeof(peer)) == 0) {
+            return ASYNC_OK;
+        }
+        return errno == EINPROGRESS ? ASYNC_WOULD_BLOCK : ASYNC_ERROR;
+    }
+
+    // the connection attempt ends when the socket becomes writable
+    pollfd pfd = { _fd, POLLOUT, 0 };
+    if (poll(&pfd, 1, 0) <= 0) {
+        return ASYNC_WOULD_BLOCK;
+    }
+    int error = 0;
+    socklen_t length = sizeof(error);
+    getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length);
+    return error ? ASYNC_ERROR : ASYNC_OK;
+}
+
+int PosixAsyncSocket::io_send(const AsyncBuffer *buffers, size_t count)
+{
+    iovec vectors[MAX_BUFFERS];
+    for (size_t i = 0; i < count; i++) {
+        vectors[i].iov_base = const_cast<void *>(buffers[i].data);
+        vectors[i].iov_len = buffers[i].length;
+    }
+
+    msghdr message = {};
+    message.msg_iov = vectors;
+    message.msg_iovlen = count;
+    ssize_t sent = sendmsg(_fd, &message, MSG_NOSIGNAL);
+    if (sent < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? ASYNC_WOULD_BLOCK : ASYNC_ERROR;
+    }
+    return (int)sent;
+}
+
+int PosixAsyncSocket::io_recv(void *data, size_t capacity)
+{
+    ssize_t received = ::recv(_fd, data, capacity, 0);
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? ASYNC_WOULD_BLOCK : ASYNC_ERROR;
+    }
+    return received ? (int)received : ASYNC_CLOSED;
+}
+
+void PosixAsyncSocket::io_close()
+{
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+}
+
+uint32_t PosixAsyncSocket::io_now_us()
+{
+    return PosixAsyncLoop::now_us();
+}
+
+void PosixAsyncSocket::io_schedule()
+{
+    _scheduled = true;
+}
+
+PosixAsyncLoop::PosixAsyncLoop() :
+    _count(0)
+{
+}
+
+uint32_t PosixAsyncLoop::now_us()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000);
+}
+
+bool PosixAsyncLoop::add(PosixAsyncSocket *socket)
+{
+    if (_count == MAX_SOCKETS) {
+        return false;
+    }
+    _sockets[_count++] = socket;
+    return true;
+}
+
+void PosixAsyncLoop::remove(PosixAsyncSocket *socket)
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (_sockets[i] == socket) {
+            _sockets[i] = _sockets[--_count];
+            return;
+        }
+    }
+}
+
+bool PosixAsyncLoop::contains(const PosixAsyncSocket *socket) const
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (_sockets[i] == socket) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int PosixAsyncLoop::run_once(uint32_t max_wait_ms)
+{
+    pollfd fds[MAX_SOCKETS];
+    size_t watched = 0;
+    // past 35 min the wait no longer fits the int32_t of the deadlines
+    uint64_t max_wait_us = (uint64_t)max_wait_ms * 1000;
+    int32_t wait_us = max_wait_us > INT32_MAX ? INT32_MAX : (int32_t)max_wait_us;
+    uint32_t now = now_us();
+
+    for (size_t i = 0; i < _count; i++) {
+        PosixAsyncSocket *socket = _sockets[i];
+        if (socket->_scheduled) {
+            wait_us = 0;
+        }
+        int32_t deadline = socket->next_deadline(now);
+        if (deadline >= 0 && deadline < wait_us) {
+            wait_us = deadline;
+        }
+        if (socket->_fd >= 0 && (socket->wants_read() || socket->wants_write())) {
+            fds[watched].fd = socket->_fd;
+            fds[watched].events = (socket->wants_read() ? POLLIN : 0) | (socket->wants_write() ? POLLOUT : 0);
+            fds[watched].revents = 0;
+            watched++;
+        }
+    }
+
+    if (poll(fds, watched, (int)(((int64_t)wait_us + 999) / 1000)) < 0 && errno != EINTR) {
+        return -1;
+    }
+
+    // cheap enough to give every socket a pass; the socket list may
+    // change from completions, so walk a snapshot and skip the sockets
+    // an earlier completion of the pass destroyed
+    PosixAsyncSocket *sockets[MAX_SOCKETS];
+    size_t count = _count;
+    for (size_t i = 0; i < count; i++) {
+        sockets[i] = _sockets[i];
+    }
+    now = now_us();
+    int processed = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!contains(sockets[i])) {
+            continue;
+        }
+        sockets[i]->_scheduled = false;
+        sockets[i]->process(now);
+        processed++;
+    }
+    return processed;
+}
+
+void PosixAsyncLoop::run_for(uint32_t duration_ms)
+{
+    uint32_t start = now_us();
+    uint32_t elapsed;
+    while ((elapsed = (now_us() - start) / 1000) < duration_ms) {
+        run_once(duration_ms - elapsed);
+    }
+}
+
+} // namespace lab
+
+#endif // !__MBED__
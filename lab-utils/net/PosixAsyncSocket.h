@@ -0,0 +1,82 @@
+#ifndef LAB_POSIX_ASYNC_SOCKET_H
+#define LAB_POSIX_ASYNC_SOCKET_H
+
+#if !defined(__MBED__)
+
+#include "AsyncSocket.h"
+
+namespace lab {
+
+class PosixAsyncLoop;
+
+/**
+ * AsyncSocket on a non-blocking BSD socket, for Linux tools and tests.
+ * Completions run from PosixAsyncLoop::run_once(). A socket the loop had
+ * no room for fails every connect() with ASYNC_ERROR.
+ */
+class PosixAsyncSocket : public AsyncSocket {
+public:
+    explicit PosixAsyncSocket(PosixAsyncLoop &loop);
+    ~PosixAsyncSocket() override;
+
+protected:
+    int io_open() override;
+    int io_connect(const char *address, uint16_t port) override;
+    int io_send(const AsyncBuffer *buffers, size_t count) override;
+    int io_recv(void *data, size_t capacity) override;
+    void io_close() override;
+    uint32_t io_now_us() override;
+    void io_schedule() override;
+
+    /** Descriptor of the open socket, -1 if closed; for socket options. */
+    int fd() const
+    {
+        return _fd;
+    }
+
+private:
+    friend class PosixAsyncLoop;
+
+    PosixAsyncLoop &_loop;
+    int _fd;
+    bool _registered;
+    bool _connect_started;
+    bool _scheduled;
+};
+
+/** poll() based dispatch loop of PosixAsyncSocket instances. */
+class PosixAsyncLoop {
+public:
+    static const size_t MAX_SOCKETS = 16;
+
+    PosixAsyncLoop();
+
+    /**
+     * Wait for socket activity or the next timeout, at most max_wait_ms,
+     * then run the due completions.
+     *
+     * @return number of sockets processed, -1 if poll() failed.
+     */
+    int run_once(uint32_t max_wait_ms);
+
+    /** Run for duration_ms. */
+    void run_for(uint32_t duration_ms);
+
+    static uint32_t now_us();
+
+private:
+    friend class PosixAsyncSocket;
+
+    bool add(PosixAsyncSocket *socket);
+    void remove(PosixAsyncSocket *socket);
+    bool contains(const PosixAsyncSocket *socket) const;
+
+    PosixAsyncSocket *_sockets[MAX_SOCKETS];
+    size_t _count;
+};
+
+} // namespace lab
+
+#endif // !__MBED__
+
+#endif // LAB_POSIX_ASYNC_SOCKET_H
@@ -0,0 +1,124 @@
+#include "SimulatedWifiRadio.h"
+
+#include <cstring>
+
+namespace lab {
+
+// nsapi_security_t values
+static const uint8_t SECURITY_WPA_WPA2 = 4;
+
+SimulatedWifiRadio::SimulatedWifiRadio(const WifiTiming &timing) :
+    _timing(timing),
+    _count(0),
+    _associated(nullptr),
+    _now_ms(0),
+    _scans(0)
+{
+}
+
+bool SimulatedWifiRadio::add_ap(const ApInfo &ap)
+{
+    if (_count == MAX_APS) {
+        return false;
+    }
+    _aps[_count].info = ap;
+    _aps[_count].up = true;
+    _count++;
+    return true;
+}
+
+SimulatedWifiRadio::SimulatedAp *SimulatedWifiRadio::find(const uint8_t *bssid)
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (memcmp(_aps[i].info.bssid, bssid, sizeof(_aps[i].info.bssid)) == 0) {
+            return &_aps[i];
+        }
+    }
+    return nullptr;
+}
+
+void SimulatedWifiRadio::set_up(const uint8_t *bssid, bool up)
+{
+    SimulatedAp *ap = find(bssid);
+    if (ap) {
+        ap->up = up;
+        if (!up && _associated == ap) {
+            _associated = nullptr;
+        }
+    }
+}
+
+void SimulatedWifiRadio::set_rssi(const uint8_t *bssid, int8_t rssi)
+{
+    SimulatedAp *ap = find(bssid);
+    if (ap) {
+        ap->info.rssi = rssi;
+    }
+}
+
+int SimulatedWifiRadio::scan(ApInfo *results, size_t capacity)
+{
+    _now_ms += _timing.scan_channel_ms * _timing.channels;
+    _scans++;
+
+    size_t count = 0;
+    for (size_t i = 0; i < _count && count < capacity; i++) {
+        if (_aps[i].up) {
+            results[count++] = _aps[i].info;
+        }
+    }
+    return (int)count;
+}
+
+int SimulatedWifiRadio::connect(const char *ssid, const char *password, const ApInfo *target)
+{
+    (void)password;
+    _associated = nullptr;
+
+    SimulatedAp *chosen = nullptr;
+    if (target && target->channel) {
+        // only the cached channel is searched
+        _now_ms += _timing.scan_channel_ms;
+        for (size_t i = 0; i < _count; i++) {
+            SimulatedAp &ap = _aps[i];
+            if (ap.up && ap.info.channel == target->channel && strcmp(ap.info.ssid, ssid) == 0 &&
+                (!chosen || ap.info.rssi > chosen->info.rssi)) {
+                chosen = &ap;
+            }
+        }
+    } else {
+        _now_ms += _timing.scan_channel_ms * _timing.channels;
+        for (size_t i = 0; i < _count; i++) {
+            SimulatedAp &ap = _aps[i];
+            if (ap.up && strcmp(ap.info.ssid, ssid) == 0 && (!chosen || ap.info.rssi > chosen->info.rssi)) {
+                chosen = &ap;
+            }
+        }
+    }
+
+    // WPA/WPA2 lets the module negotiate either
+    uint8_t security = target ? target->security : SECURITY_WPA_WPA2;
+    bool security_ok = chosen && (security == chosen->info.security ||
+                                  (security == SECURITY_WPA_WPA2 && chosen->info.security >= 2 && chosen->info.security <= 4));
+    if (!security_ok) {
+        _now_ms += _timing.fail_ms;
+        return -3004;   // NSAPI_ERROR_NO_CONNECTION
+    }
+
+    _now_ms += _timing.associate_ms + _timing.dhcp_ms;
+    _associated = chosen;
+    return 0;
+}
+
+int SimulatedWifiRadio::disconnect()
+{
+    _associated = nullptr;
+    return 0;
+}
+
+int8_t SimulatedWifiRadio::rssi()
+{
+    return _associated ? _associated->info.rssi : 0;
+}
+
+} // namespace lab
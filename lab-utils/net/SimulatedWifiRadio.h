@@ -0,0 +1,88 @@
+#ifndef LAB_SIMULATED_WIFI_RADIO_H
+#define LAB_SIMULATED_WIFI_RADIO_H
+
+#include "WifiRadio.h"
+
+namespace lab {
+
+/** Durations the simulated module spends in each step, in ms. */
+struct WifiTiming {
+    /** Dwell per channel of a scan. */
+    uint32_t scan_channel_ms;
+    uint32_t channels;
+    /** Authentication and association once on the right channel. */
+    uint32_t associate_ms;
+    uint32_t dhcp_ms;
+    /** Time before the module gives up on an AP that does not answer. */
+    uint32_t fail_ms;
+};
+
+/**
+ * WiFi module model for host builds, in virtual time.
+ *
+ * Every call advances the clock by what it would cost on the module: a
+ * scan dwells on each channel, a connect without a channel searches all
+ * channels first, a connect to a channel only listens there. Defaults
+ * are in the range measured on the ISM43362 (a scan of about 1.6 s, 2 to
+ * 3 s for a blind connect).
+ */
+class SimulatedWifiRadio : public WifiRadio {
+public:
+    static const size_t MAX_APS = 16;
+
+    static WifiTiming default_timing()
+    {
+        WifiTiming timing = { 120, 13, 450, 350, 3000 };
+        return timing;
+    }
+
+    explicit SimulatedWifiRadio(const WifiTiming &timing = default_timing());
+
+    /** @return false if the table is full. */
+    bool add_ap(const ApInfo &ap);
+
+    /** Take an AP off the air, or back. */
+    void set_up(const uint8_t *bssid, bool up);
+
+    void set_rssi(const uint8_t *bssid, int8_t rssi);
+
+    /** Virtual time since construction. */
+    uint32_t now_ms() const
+    {
+        return _now_ms;
+    }
+
+    void advance(uint32_t ms)
+    {
+        _now_ms += ms;
+    }
+
+    uint32_t scans() const
+    {
+        return _scans;
+    }
+
+    int scan(ApInfo *results, size_t capacity) override;
+    int connect(const char *ssid, const char *password, const ApInfo *target) override;
+    int disconnect() override;
+    int8_t rssi() override;
+
+private:
+    struct SimulatedAp {
+        ApInfo info;
+        bool up;
+    };
+
+    SimulatedAp *find(const uint8_t *bssid);
+
+    WifiTiming _timing;
+    SimulatedAp _aps[MAX_APS];
+    size_t _count;
+    SimulatedAp *_associated;
+    uint32_t _now_ms;
+    uint32_t _scans;
+};
+
+} // namespace lab
+
+#endif // LAB_SIMULATED_WIFI_RADIO_H
@@ -0,0 +1,96 @@
+#include "WifiConnector.h"
+
+namespace lab {
+
+WifiConnector::WifiConnector(WifiRadio &radio, ApCache &cache, const char *ssid, const char *password) :
+    _radio(radio),
+    _cache(cache),
+    _ssid(ssid),
+    _password(password),
+    _path(WIFI_PATH_NONE),
+    _connected(false)
+{
+}
+
+int WifiConnector::scan()
+{
+    int count = _radio.scan(_results, SCAN_CAPACITY);
+    if (count > 0) {
+        _cache.merge(_results, count, _ssid);
+    }
+    return count;
+}
+
+int WifiConnector::connect_to(const ApInfo &ap)
+{
+    int err = _radio.connect(_ssid, _password, &ap);
+    if (err == 0) {
+        _cache.remember(ap);
+    }
+    return err;
+}
+
+int WifiConnector::connect()
+{
+    _path = WIFI_PATH_NONE;
+    _connected = false;
+
+    const ApInfo *last = _cache.last_good();
+    if (last && connect_to(*last) == 0) {
+        _path = WIFI_PATH_CACHED;
+        _connected = true;
+        return 0;
+    }
+    _cache.forget();
+
+    int err = scan();
+    for (size_t i = 0; err >= 0 && i < _cache.candidate_count(); i++) {
+        // copy, a successful connect rewrites the cache
+        ApInfo candidate = _cache.candidate(i);
+        if (connect_to(candidate) == 0) {
+            _path = WIFI_PATH_SCANNED;
+            _connected = true;
+            return 0;
+        }
+    }
+
+    // hidden SSID or a scan that missed it
+    err = _radio.connect(_ssid, _password, nullptr);
+    if (err == 0) {
+        _path = WIFI_PATH_BLIND;
+        _connected = true;
+    }
+    return err;
+}
+
+int WifiConnector::maintain(uint8_t roam_margin_db)
+{
+    if (!_connected) {
+        int err = connect();
+        return err ? err : 1;
+    }
+
+    if (scan() <= 0 || roam_margin_db == 0 || _cache.candidate_count() == 0) {
+        return 0;
+    }
+
+    // the current AP cannot be stronger than itself by the margin, so a
+    // candidate that is must be another one
+    ApInfo best = _cache.candidate(0);
+    int8_t current = _radio.rssi();
+    if (current == 0 || best.rssi < current + roam_margin_db) {
+        return 0;
+    }
+
+    _radio.disconnect();
+    _connected = false;
+    if (connect_to(best) == 0) {
+        _connected = true;
+        _path = WIFI_PATH_SCANNED;
+        return 1;
+    }
+    int err = connect();
+    return err ? err : 1;
+}
+
+} // namespace lab
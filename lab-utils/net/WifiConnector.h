@@ -0,0 +1,80 @@
+#ifndef LAB_WIFI_CONNECTOR_H
+#define LAB_WIFI_CONNECTOR_H
+
+#include "ApCache.h"
+#include "WifiRadio.h"
+
+namespace lab {
+
+/** How the last connect() got through. */
+enum WifiConnectPath {
+    WIFI_PATH_NONE,
+    /** Straight to the cached AP, no scan. */
+    WIFI_PATH_CACHED,
+    /** Full scan, then the strongest candidate. */
+    WIFI_PATH_SCANNED,
+    /** Module left to find the SSID on its own. */
+    WIFI_PATH_BLIND,
+};
+
+/**
+ * Boot and roaming policy for one SSID.
+ *
+ * connect() goes to the last good AP first, which skips the scan, and
+ * only falls back to a full scan when that fails (AP gone, moved channel,
+ * changed security). maintain() is the background part: one scan merged
+ * into the ranked candidates, then a move to the best one if it beats
+ * the current link by the roaming margin. Both block for the length of
+ * the radio calls, so they belong on a thread that may wait.
+ */
+class WifiConnector {
+public:
+    static const size_t SCAN_CAPACITY = 15;
+
+    WifiConnector(WifiRadio &radio, ApCache &cache, const char *ssid, const char *password);
+
+    /** @return 0 once connected, the last radio error otherwise. */
+    int connect();
+
+    /**
+     * Scan, update the candidates and roam if worthwhile. After a
+     * failed connect or roam it connects again instead.
+     *
+     * @param[in] roam_margin_db how much stronger a candidate must be than
+     * the current link; 0 disables roaming.
+     * @return 1 if it (re)connected, 0 if nothing changed, a negative
+     * error if there is no link.
+     */
+    int maintain(uint8_t roam_margin_db);
+
+    WifiConnectPath path() const
+    {
+        return _path;
+    }
+
+    bool connected() const
+    {
+        return _connected;
+    }
+
+    const ApCache &cache() const
+    {
+        return _cache;
+    }
+
+private:
+    int scan();
+    int connect_to(const ApInfo &ap);
+
+    WifiRadio &_radio;
+    ApCache &_cache;
+    const char *_ssid;
+    const char *_password;
+    WifiConnectPath _path;
+    bool _connected;
+    ApInfo _results[SCAN_CAPACITY];
+};
+
+} // namespace lab
+
+#endif // LAB_WIFI_CONNECTOR_H
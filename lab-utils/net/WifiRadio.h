@@ -0,0 +1,47 @@
+#ifndef LAB_WIFI_RADIO_H
+#define LAB_WIFI_RADIO_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** What a scan reports about one access point. */
+struct ApInfo {
+    char ssid[33];
+    uint8_t bssid[6];
+    uint8_t channel;
+    /** nsapi_security_t value. */
+    uint8_t security;
+    int8_t rssi;
+};
+
+/**
+ * Station side of a WiFi module, as used by WifiConnector. Calls block
+ * until the module is done, as the Mbed WiFiInterface calls do.
+ */
+class WifiRadio {
+public:
+    virtual ~WifiRadio() {}
+
+    /** @return number of results stored, or a negative error. */
+    virtual int scan(ApInfo *results, size_t capacity) = 0;
+
+    /**
+     * Associate and obtain an address.
+     *
+     * @param[in] target AP to go to directly (channel and security), or
+     * nullptr to let the module search for the SSID.
+     * @return 0 once connected, a negative error otherwise.
+     */
+    virtual int connect(const char *ssid, const char *password, const ApInfo *target) = 0;
+
+    virtual int disconnect() = 0;
+
+    /** Signal of the current association, 0 if unknown. */
+    virtual int8_t rssi() = 0;
+};
+
+} // namespace lab
+
+#endif // LAB_WIFI_RADIO_H
@@ -0,0 +1,145 @@
+#include "BootProfile.h"
+
+#include <cstring>
+
+#if defined(__MBED__)
+#include "mbed.h"
+#else
+#include <time.h>
+#endif
+
+namespace lab {
+
+namespace {
+
+const uint32_t RECORD_MAGIC = 0x424F4F54;
+
+struct BootRecord {
+    uint32_t magic;
+    uint32_t boot;
+    uint32_t frequency_hz;
+    uint32_t count;
+    BootEvent events[BootProfile::MAX_EVENTS];
+    /** magic ^ boot, catches a record half overwritten before a reset. */
+    uint32_t check;
+};
+
+struct BootRetained {
+    BootRecord records[2];
+};
+
+LAB_RETAINED BootRetained retained;
+BootRecord *current = nullptr;
+
+#if !defined(__MBED__)
+uint64_t host_start_us = 0;
+
+uint64_t host_now_us()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+#endif
+
+bool valid(const BootRecord &record)
+{
+    return record.magic == RECORD_MAGIC && record.check == (RECORD_MAGIC ^ record.boot);
+}
+
+void dump_record(std::FILE *out, const BootRecord &record, const char *which)
+{
+    uint32_t count = record.count < BootProfile::MAX_EVENTS ? record.count : BootProfile::MAX_EVENTS;
+    fprintf(out, "BOOTPROF boot=%lu hz=%lu events=%lu dropped=%lu %s\n", (unsigned long)record.boot,
+            (unsigned long)record.frequency_hz, (unsigned long)count, (unsigned long)(record.count - count), which);
+    for (uint32_t i = 0; i < count; i++) {
+        const BootEvent &event = record.events[i];
+        fprintf(out, "BOOTPROF %lu %u %c %.*s\n", (unsigned long)event.cycles, event.lane, event.kind,
+                (int)sizeof(event.name), event.name);
+    }
+}
+
+} // namespace
+
+void BootProfile::begin()
+{
+#if defined(__MBED__) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#elif !defined(__MBED__)
+    host_start_us = host_now_us();
+#endif
+
+    // the newer of the two retained records is the previous boot
+    uint32_t last = 0;
+    for (const BootRecord &record : retained.records) {
+        if (valid(record) && record.boot > last) {
+            last = record.boot;
+        }
+    }
+
+    current = &retained.records[(last + 1) & 1];
+    current->magic = 0;
+    current->boot = last + 1;
+    current->frequency_hz = frequency_hz();
+    current->count = 0;
+    current->check = RECORD_MAGIC ^ current->boot;
+    current->magic = RECORD_MAGIC;
+}
+
+uint32_t BootProfile::cycles()
+{
+#if defined(__MBED__) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    return DWT->CYCCNT;
+#elif defined(__MBED__)
+    return us_ticker_read();
+#else
+    return (uint32_t)(host_now_us() - host_start_us);
+#endif
+}
+
+uint32_t BootProfile::frequency_hz()
+{
+#if defined(__MBED__) && defined(DWT_CTRL_CYCCNTENA_Msk)
+    return SystemCoreClock;
+#else
+    return 1000000;
+#endif
+}
+
+uint32_t BootProfile::boot_number()
+{
+    return current ? current->boot : 0;
+}
+
+void BootProfile::record(BootEventKind kind, const char *name, uint8_t lane)
+{
+    if (!current) {
+        return;
+    }
+    uint32_t now = cycles();
+    uint32_t index = __atomic_fetch_add(&current->count, 1, __ATOMIC_RELAXED);
+    if (index >= MAX_EVENTS) {
+        return;
+    }
+    BootEvent &event = current->events[index];
+    event.cycles = now;
+    event.kind = kind;
+    event.lane = lane;
+    strncpy(event.name, name, sizeof(event.name));
+}
+
+void BootProfile::dump(std::FILE *out)
+{
+    if (!current) {
+        return;
+    }
+    const BootRecord &previous = retained.records[(current->boot + 1) & 1];
+    if (valid(previous) && previous.boot + 1 == current->boot) {
+        dump_record(out, previous, "previous");
+    }
+    dump_record(out, *current, "current");
+}
+
+} // namespace lab
@@ -0,0 +1,114 @@
+#ifndef LAB_BOOT_PROFILE_H
+#define LAB_BOOT_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/*
+ * Section for the profile buffer. Left out of the startup zeroing, the
+ * record of the previous boot survives a reset (watchdog, brown-out) and
+ * can be dumped afterwards; a linker script that zeroes it anyway only
+ * costs that previous record.
+ */
+#ifndef LAB_RETAINED
+#if defined(__MBED__) && defined(__GNUC__)
+#define LAB_RETAINED __attribute__((section(".noinit")))
+#else
+#define LAB_RETAINED
+#endif
+#endif
+
+namespace lab {
+
+/** Kind of a boot event. */
+enum BootEventKind {
+    BOOT_MARK = '|',
+    BOOT_ENTER = '>',
+    BOOT_LEAVE = '<',
+};
+
+struct BootEvent {
+    uint32_t cycles;
+    uint8_t kind;
+    /** 0 for main, one per parallel init group. */
+    uint8_t lane;
+    char name[14];
+};
+
+/**
+ * Startup timeline stamped from the cycle counter.
+ *
+ * begin() starts the DWT cycle counter on Cortex-M3 and up (microseconds
+ * on the host) and opens a new record; enter()/leave() bracket phases,
+ * mark() stamps instants, from any thread. Names are copied, truncated
+ * to 14 characters. The last two boots are kept in retained RAM and
+ * dump() prints them as BOOTPROF lines for profile/boot_timeline.py.
+ *
+ * The counter wraps after 2^32 cycles, 53 s at 80 MHz, which bounds the
+ * span a record can cover.
+ */
+class BootProfile {
+public:
+    static const size_t MAX_EVENTS = 48;
+
+    /** Start the counter and a new record. Call first thing in main(). */
+    static void begin();
+
+    static void mark(const char *name, uint8_t lane = 0)
+    {
+        record(BOOT_MARK, name, lane);
+    }
+
+    static void enter(const char *name, uint8_t lane = 0)
+    {
+        record(BOOT_ENTER, name, lane);
+    }
+
+    static void leave(const char *name, uint8_t lane = 0)
+    {
+        record(BOOT_LEAVE, name, lane);
+    }
+
+    /** Counter ticks since begin(). */
+    static uint32_t cycles();
+
+    /** Counter frequency. */
+    static uint32_t frequency_hz();
+
+    /** Number of this boot, counted in retained RAM. */
+    static uint32_t boot_number();
+
+    /** Print the previous boot, if retained, and this one. */
+    static void dump(std::FILE *out = stdout);
+
+private:
+    static void record(BootEventKind kind, const char *name, uint8_t lane);
+};
+
+/** Phase covering the enclosing scope. */
+class BootPhase {
+public:
+    explicit BootPhase(const char *name, uint8_t lane = 0) :
+        _name(name),
+        _lane(lane)
+    {
+        BootProfile::enter(name, lane);
+    }
+
+    ~BootPhase()
+    {
+        BootProfile::leave(_name, _lane);
+    }
+
+    BootPhase(const BootPhase &) = delete;
+    BootPhase &operator=(const BootPhase &) = delete;
+
+private:
+    const char *_name;
+    uint8_t _lane;
+};
+
+} // namespace lab
+
+#endif // LAB_BOOT_PROFILE_H
@@ -0,0 +1,80 @@
+#include "ParallelInit.h"
+
+#include <new>
+
+#include "BootProfile.h"
+
+namespace lab {
+
+ParallelInit::ParallelInit(uint32_t stack_size) :
+    _count(0),
+    _stack_size(stack_size)
+{
+}
+
+bool ParallelInit::add(uint8_t group, const char *name, mbed::Callback<void()> task)
+{
+    if (_count == MAX_TASKS || group >= MAX_GROUPS) {
+        return false;
+    }
+    _tasks[_count].name = name;
+    _tasks[_count].run = task;
+    _tasks[_count].group = group;
+    _count++;
+    return true;
+}
+
+void ParallelInit::group_entry(GroupRun *run)
+{
+    run->owner->run_group(run->group);
+}
+
+void ParallelInit::run_group(uint8_t group)
+{
+    for (size_t i = 0; i < _count; i++) {
+        if (_tasks[i].group == group) {
+            BootPhase phase(_tasks[i].name, group);
+            _tasks[i].run();
+        }
+    }
+}
+
+void ParallelInit::run()
+{
+    // threads only live for the duration of run(), their stacks come
+    // from the heap and go back to it
+    alignas(rtos::Thread) static uint8_t storage[MAX_GROUPS - 1][sizeof(rtos::Thread)];
+    rtos::Thread *threads[MAX_GROUPS - 1] = {};
+    GroupRun runs[MAX_GROUPS - 1];
+
+    for (uint8_t group = 1; group < MAX_GROUPS; group++) {
+        bool used = false;
+        for (size_t i = 0; i < _count; i++) {
+            used |= _tasks[i].group == group;
+        }
+        if (!used) {
+            continue;
+        }
+        runs[group - 1].owner = this;
+        runs[group - 1].group = group;
+        rtos::Thread *thread = new (storage[group - 1]) rtos::Thread(osPriorityNormal, _stack_size, nullptr, "init");
+        if (thread->start(mbed::callback(group_entry, &runs[group - 1])) != osOK) {
+            // no thread, run the group here instead
+            thread->~Thread();
+            run_group(group);
+            continue;
+        }
+        threads[group - 1] = thread;
+    }
+
+    run_group(0);
+
+    for (rtos::Thread *thread : threads) {
+        if (thread) {
+            thread->join();
+            thread->~Thread();
+        }
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,53 @@
+#ifndef LAB_PARALLEL_INIT_H
+#define LAB_PARALLEL_INIT_H
+
+#include "mbed.h"
+
+namespace lab {
+
+/**
+ * Startup work split into independent groups.
+ *
+ * Tasks of one group run in the order they were added; groups run side
+ * by side, group 0 on the calling thread and each other group on a
+ * temporary thread. Tasks that share a bus belong to the same group:
+ * the BSP sensor drivers all sit on I2C2 without locking, while the WiFi
+ * module (SPI3) and the QSPI flash are independent of them. Every task
+ * is stamped as a BootProfile phase, with its group as the lane.
+ */
+class ParallelInit : private mbed::NonCopyable<ParallelInit> {
+public:
+    static const size_t MAX_TASKS = 12;
+    static const size_t MAX_GROUPS = 4;
+
+    explicit ParallelInit(uint32_t stack_size = 2048);
+
+    /** @return false if the table is full or group is out of range. */
+    bool add(uint8_t group, const char *name, mbed::Callback<void()> task);
+
+    /** Run every task, return once all are done. */
+    void run();
+
+private:
+    struct Task {
+        const char *name;
+        mbed::Callback<void()> run;
+        uint8_t group;
+    };
+
+    struct GroupRun {
+        ParallelInit *owner;
+        uint8_t group;
+    };
+
+    static void group_entry(GroupRun *run);
+    void run_group(uint8_t group);
+
+    Task _tasks[MAX_TASKS];
+    size_t _count;
+    uint32_t _stack_size;
+};
+
+} // namespace lab
+
+#endif // LAB_PARALLEL_INIT_H
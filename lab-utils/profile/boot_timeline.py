@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Turn the BOOTPROF dump of BootProfile into a startup timeline.
+
+Reads a serial port or a capture file; other output on the line (printf
+text, binary deferred log frames) is skipped.
+
+    python3 boot_timeline.py /dev/ttyACM0 --baud 115200
+    python3 boot_timeline.py capture.bin --compare
+"""
+
+import argparse
+import re
+import sys
+
+HEADER = re.compile(rb'BOOTPROF boot=(\d+) hz=(\d+) events=(\d+) dropped=(\d+) (\w+)')
+EVENT = re.compile(rb'BOOTPROF (\d+) (\d+) ([|<>]) ([^\r\n]*)')
+BAR_WIDTH = 48
+
+
+class Boot:
+    def __init__(self, number, hz, events, dropped, which):
+        self.number = number
+        self.hz = hz
+        self.expected = events
+        self.dropped = dropped
+        self.which = which
+        self.events = []
+
+    def ms(self, cycles):
+        return cycles * 1000.0 / self.hz
+
+    def phases(self):
+        """Pair enter/leave events per lane, nested phases allowed."""
+        open_phases = {}
+        phases = []
+        for cycles, lane, kind, name in self.events:
+            if kind == '>':
+                open_phases.setdefault((lane, name), []).append(cycles)
+            elif kind == '<' and open_phases.get((lane, name)):
+                start = open_phases[(lane, name)].pop()
+                phases.append((start, cycles, lane, name))
+        for (lane, name), starts in open_phases.items():
+            for start in starts:
+                phases.append((start, None, lane, name))
+        return sorted(phases)
+
+    def marks(self):
+        return [(cycles, lane, name) for cycles, lane, kind, name in self.events if kind == '|']
+
+    def end(self):
+        return max([cycles for cycles, _, _, _ in self.events] or [0])
+
+
+def parse(stream):
+    boots = []
+    buffer = b''
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            break
+        buffer += chunk
+        lines = buffer.split(b'\n')
+        buffer = lines.pop()
+        for line in lines:
+            match = HEADER.search(line)
+            if match:
+                number, hz, events, dropped = (int(value) for value in match.groups()[:4])
+                boots.append(Boot(number, hz, events, dropped, match.group(5).decode()))
+                continue
+            match = EVENT.search(line)
+            if match and boots:
+                cycles, lane = int(match.group(1)), int(match.group(2))
+                boots[-1].events.append((cycles, lane, match.group(3).decode(), match.group(4).decode('utf-8', 'replace')))
+    return boots
+
+
+def print_boot(boot):
+    total = boot.end() or 1
+    print('boot %d (%s), %.1f MHz counter, %d events%s' % (
+        boot.number, boot.which, boot.hz / 1e6, len(boot.events),
+        ', %d dropped' % boot.dropped if boot.dropped else ''))
+    print('  lane   start ms    dur ms  phase')
+    for start, stop, lane, name in boot.phases():
+        first = int(start * BAR_WIDTH / total)
+        last = int((stop if stop is not None else total) * BAR_WIDTH / total)
+        bar = ' ' * first + '#' * max(1, last - first)
+        duration = '%9.3f' % boot.ms(stop - start) if stop is not None else '     open'
+        print('  %4d %10.3f %s  %-14s |%s' % (lane, boot.ms(start), duration, name, bar.ljust(BAR_WIDTH)))
+    for cycles, lane, name in boot.marks():
+        print('  %4d %10.3f         |  %s' % (lane, boot.ms(cycles), name))
+    print('  total %.3f ms' % boot.ms(total))
+
+
+def compare(before, after):
+    def durations(boot):
+        return {name: boot.ms(stop - start) for start, stop, _, name in boot.phases() if stop is not None}
+
+    old, new = durations(before), durations(after)
+    print('phase           boot %-6d boot %-6d    delta' % (before.number, after.number))
+    for name in sorted(set(old) | set(new), key=lambda n: -new.get(n, old.get(n, 0))):
+        a, b = old.get(name), new.get(name)
+        delta = '%+9.3f' % (b - a) if a is not None and b is not None else ''
+        print('%-14s %11s %11s %s' % (name, '%.3f' % a if a is not None else '-',
+                                      '%.3f' % b if b is not None else '-', delta))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('source', help='serial port or capture file')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--compare', action='store_true', help='phase by phase against the previous boot')
+    options = parser.parse_args()
+
+    if options.source.startswith('/dev/') or options.source.upper().startswith('COM'):
+        import serial
+        stream = serial.Serial(options.source, options.baud, timeout=5)
+    else:
+        stream = open(options.source, 'rb')
+
+    boots = parse(stream)
+    if not boots:
+        sys.exit('no BOOTPROF dump found')
+    for boot in boots:
+        print_boot(boot)
+        print()
+    if options.compare and len(boots) >= 2:
+        compare(boots[-2], boots[-1])
+
+
+if __name__ == '__main__':
+    main()
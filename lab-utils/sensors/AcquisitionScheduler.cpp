@@ -0,0 +1,161 @@
+#include "AcquisitionScheduler.h"
+
+namespace lab {
+
+AcquisitionScheduler::AcquisitionScheduler() : _count(0), _triggered(0)
+{
+}
+
+int AcquisitionScheduler::add_channel(const SensorChannelConfig &config)
+{
+    if (_count == MAX_CHANNELS || !config.read) {
+        return -1;
+    }
+
+    Channel &channel = _channels[_count];
+    channel.config = config;
+    channel.stats = SensorChannelStats();
+    channel.stats.cost_us = config.cost_us;
+    channel.due_us = 0;
+    channel.sequence = 0;
+    return _count++;
+}
+
+void AcquisitionScheduler::start(uint32_t now_us)
+{
+    for (size_t i = 0; i < _count; i++) {
+        _channels[i].due_us = now_us;
+    }
+}
+
+bool AcquisitionScheduler::fits(size_t index, uint32_t now_us) const
+{
+    const Channel &candidate = _channels[index];
+
+    // event driven work has no period to protect; otherwise the starvation
+    // guard: a full period late, run whatever the cost. A triggered channel
+    // whose fallback poll is still ahead is not late at all.
+    if (!candidate.config.period_us) {
+        return true;
+    }
+    int32_t late_us = (int32_t)(now_us - candidate.due_us);
+    if (late_us >= 0 && (uint32_t)late_us >= candidate.config.period_us) {
+        return true;
+    }
+
+    for (size_t i = 0; i < _count; i++) {
+        const Channel &other = _channels[i];
+        if (other.config.priority <= candidate.config.priority || !other.config.period_us ||
+            is_due(i, now_us)) {
+            continue;
+        }
+        if (other.due_us - now_us < candidate.stats.cost_us) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int AcquisitionScheduler::next(uint32_t now_us, uint32_t *wait_us) const
+{
+    int best = -1;
+
+    for (size_t i = 0; i < _count; i++) {
+        const Channel &channel = _channels[i];
+        if (!is_due(i, now_us) || !fits(i, now_us)) {
+            continue;
+        }
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+        const Channel &current = _channels[best];
+        if (channel.config.priority > current.config.priority ||
+            (channel.config.priority == current.config.priority &&
+             (int32_t)(channel.due_us - current.due_us) < 0)) {
+            best = i;
+        }
+    }
+
+    if (best >= 0 || !wait_us) {
+        return best;
+    }
+
+    // idle until the earliest future deadline; a due channel that did not
+    // fit is unblocked by that deadline or by its own starvation guard
+    uint32_t wait = UINT32_MAX;
+    for (size_t i = 0; i < _count; i++) {
+        const Channel &channel = _channels[i];
+        if (!channel.config.period_us) {
+            continue;
+        }
+        uint32_t until = is_due(i, now_us) ?
+                         channel.due_us + channel.config.period_us - now_us :
+                         channel.due_us - now_us;
+        if (until < wait) {
+            wait = until;
+        }
+    }
+    *wait_us = wait;
+    return -1;
+}
+
+bool AcquisitionScheduler::execute(int channel, uint32_t start_us, SensorRecord &record)
+{
+    Channel &c = _channels[channel];
+
+    // a trigger arriving while the read runs makes the channel due again
+    _triggered.fetch_and(~(1u << channel), std::memory_order_acq_rel);
+
+    record.timestamp_us = start_us;
+    record.channel = channel;
+    record.count = 0;
+
+    if (c.config.read(c.config.context, record) != 0) {
+        c.stats.errors++;
+        return false;
+    }
+
+    record.sequence = c.sequence++;
+    c.stats.samples++;
+    return true;
+}
+
+void AcquisitionScheduler::complete(int channel, uint32_t start_us, uint32_t end_us)
+{
+    Channel &c = _channels[channel];
+
+    // smoothed cost, reacts to slow transactions faster than to fast ones
+    uint32_t duration = end_us - start_us;
+    if (duration > c.stats.cost_us) {
+        c.stats.cost_us += (duration - c.stats.cost_us + 1) / 2;
+    } else {
+        c.stats.cost_us -= (c.stats.cost_us - duration) / 8;
+    }
+
+    if (!c.config.period_us) {
+        return;
+    }
+
+    // triggered before its poll deadline: push the fallback poll back
+    if ((int32_t)(start_us - c.due_us) < 0) {
+        c.due_us = start_us + c.config.period_us;
+        return;
+    }
+
+    uint32_t latency = start_us - c.due_us;
+    if (latency > c.stats.max_latency_us) {
+        c.stats.max_latency_us = latency;
+    }
+
+    // keep the original phase, skip the periods that are already over
+    c.due_us += c.config.period_us;
+    uint32_t late = end_us - c.due_us;
+    if ((int32_t)late >= 0 && late >= c.config.period_us) {
+        uint32_t skipped = late / c.config.period_us;
+        c.stats.missed += skipped;
+        c.due_us += skipped * c.config.period_us;
+    }
+}
+
+} // namespace lab
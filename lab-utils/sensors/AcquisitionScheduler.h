@@ -0,0 +1,146 @@
+#ifndef LAB_ACQUISITION_SCHEDULER_H
+#define LAB_ACQUISITION_SCHEDULER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "SensorRecord.h"
+
+namespace lab {
+
+/**
+ * Reads one sample of a channel. Runs on the bus owner thread.
+ *
+ * @param[in] context Channel specific data given at registration.
+ * @param[out] record Fill count and value, the rest is set by the scheduler.
+ *
+ * @return 0 on success, a negative driver error otherwise.
+ */
+typedef int (*SensorReadFn)(void *context, SensorRecord &record);
+
+struct SensorChannelConfig {
+    const char *name;
+    /**
+     * Sampling period. 0 makes the channel event driven: it only runs
+     * after trigger(). With a period, trigger() runs it early and the
+     * period acts as a fallback poll.
+     */
+    uint32_t period_us;
+    /** Channels with a higher priority are never delayed by lower ones. */
+    uint8_t priority;
+    SensorReadFn read;
+    void *context;
+    /** Initial estimate of one read, refined from measurements. */
+    uint32_t cost_us;
+};
+
+struct SensorChannelStats {
+    uint32_t samples;
+    uint32_t errors;
+    /** Periods skipped because the channel could not run in time. */
+    uint32_t missed;
+    /** Worst delay between the due time and the start of a read. */
+    uint32_t max_latency_us;
+    /** Smoothed duration of one read. */
+    uint32_t cost_us;
+};
+
+/**
+ * Rate-monotonic style scheduler for the transactions of one sensor bus.
+ *
+ * Every channel has its own period, or is triggered by an interrupt.
+ * Transactions on a bus cannot be
+ * preempted, so when several channels are due the highest priority one
+ * goes first, and a lower priority read is only started if its measured
+ * duration fits before the next deadline of every higher priority
+ * channel. Slow environmental sensors therefore fill the gaps between
+ * IMU reads instead of delaying them. A channel overdue by a full period
+ * runs regardless, so nothing starves.
+ *
+ * The scheduler owns no thread and no clock: the bus owner asks next()
+ * what to do at a given time, runs it with execute() and reports the end
+ * time with complete(). The same object drives real hardware or a
+ * simulated bus in virtual time.
+ */
+class AcquisitionScheduler {
+public:
+    static const size_t MAX_CHANNELS = 8;
+
+    AcquisitionScheduler();
+
+    /** @return channel number, or -1 if the table is full. */
+    int add_channel(const SensorChannelConfig &config);
+
+    /** Make every channel due at now_us. */
+    void start(uint32_t now_us);
+
+    /**
+     * Make a channel due immediately, e.g. from a data-ready interrupt.
+     * Lock-free, callable from interrupt context.
+     */
+    void trigger(int channel)
+    {
+        _triggered.fetch_or(1u << channel, std::memory_order_release);
+    }
+
+    /**
+     * Pick the channel to read at now_us.
+     *
+     * @param[out] wait_us When nothing can run, time until something may.
+     *
+     * @return channel number, or -1 if the bus should stay idle.
+     */
+    int next(uint32_t now_us, uint32_t *wait_us) const;
+
+    /** Read a channel, filling everything in the record. */
+    bool execute(int channel, uint32_t start_us, SensorRecord &record);
+
+    /** Account for a finished read and schedule the next one. */
+    void complete(int channel, uint32_t start_us, uint32_t end_us);
+
+    size_t channels() const
+    {
+        return _count;
+    }
+
+    const SensorChannelConfig &config(int channel) const
+    {
+        return _channels[channel].config;
+    }
+
+    const SensorChannelStats &stats(int channel) const
+    {
+        return _channels[channel].stats;
+    }
+
+private:
+    struct Channel {
+        SensorChannelConfig config;
+        SensorChannelStats stats;
+        uint32_t due_us;
+        uint16_t sequence;
+    };
+
+    bool is_triggered(size_t index) const
+    {
+        return _triggered.load(std::memory_order_acquire) & (1u << index);
+    }
+
+    bool is_due(size_t index, uint32_t now_us) const
+    {
+        const Channel &channel = _channels[index];
+        return is_triggered(index) ||
+               (channel.config.period_us && (int32_t)(now_us - channel.due_us) >= 0);
+    }
+
+    bool fits(size_t index, uint32_t now_us) const;
+
+    Channel _channels[MAX_CHANNELS];
+    size_t _count;
+    std::atomic<uint32_t> _triggered;
+};
+
+} // namespace lab
+
+#endif // LAB_ACQUISITION_SCHEDULER_H
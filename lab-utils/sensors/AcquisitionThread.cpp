@@ -0,0 +1,70 @@
+#include "AcquisitionThread.h"
+
+#include "hal/us_ticker_api.h"
+
+namespace lab {
+
+AcquisitionThread::AcquisitionThread(AcquisitionScheduler &scheduler, osPriority priority, uint32_t stack_size) :
+    _scheduler(scheduler),
+    _thread(priority, stack_size, nullptr, "acquisition")
+{
+}
+
+osStatus AcquisitionThread::start()
+{
+    return _thread.start(mbed::callback(this, &AcquisitionThread::run));
+}
+
+void AcquisitionThread::trigger(int channel)
+{
+    _scheduler.trigger(channel);
+    wake_up();
+}
+
+size_t AcquisitionThread::read(SensorRecord *dst, size_t max, rtos::Kernel::Clock::duration_u32 timeout)
+{
+    size_t count = _records.pop_batch(dst, max);
+    if (count || timeout.count() == 0) {
+        return count;
+    }
+
+    _flags.wait_any_for(RECORDS_READY, timeout);
+    return _records.pop_batch(dst, max);
+}
+
+void AcquisitionThread::wake_up()
+{
+    _wake.set(WAKE_UP);
+}
+
+void AcquisitionThread::run()
+{
+    _scheduler.start(us_ticker_read());
+
+    while (true) {
+        uint32_t now = us_ticker_read();
+        uint32_t wait = 0;
+        int channel = _scheduler.next(now, &wait);
+
+        if (channel < 0) {
+            // the RTOS tick is 1 ms, too coarse for the gaps between reads:
+            // a microsecond timeout wakes the thread instead of a spin, a
+            // trigger cuts the sleep short
+            uint32_t us = wait < MAX_SLEEP_US ? wait : MAX_SLEEP_US;
+            _deadline.attach(mbed::callback(this, &AcquisitionThread::wake_up), std::chrono::microseconds(us));
+            _wake.wait_any(WAKE_UP);
+            _deadline.detach();
+            continue;
+        }
+
+        SensorRecord record;
+        bool ok = _scheduler.execute(channel, now, record);
+        _scheduler.complete(channel, now, us_ticker_read());
+
+        if (ok && _records.push(record)) {
+            _flags.set(RECORDS_READY);
+        }
+    }
+}
+
+} // namespace lab
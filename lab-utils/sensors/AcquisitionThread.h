@@ -0,0 +1,67 @@
+#ifndef LAB_ACQUISITION_THREAD_H
+#define LAB_ACQUISITION_THREAD_H
+
+#include "mbed.h"
+
+#include "AcquisitionScheduler.h"
+#include "SpscRing.h"
+
+namespace lab {
+
+/**
+ * Owner thread of one sensor bus.
+ *
+ * Runs the transactions picked by an AcquisitionScheduler at high
+ * priority and queues the timestamped records in a lock-free ring. The
+ * application thread collects them with read() whenever it likes and is
+ * never blocked by a bus transaction.
+ */
+class AcquisitionThread : private mbed::NonCopyable<AcquisitionThread> {
+public:
+    static const size_t RECORD_RING_SIZE = 128;
+
+    AcquisitionThread(AcquisitionScheduler &scheduler,
+                      osPriority priority = osPriorityAboveNormal,
+                      uint32_t stack_size = 2048);
+
+    osStatus start();
+
+    /**
+     * Run a channel as soon as the bus is free. Callable from interrupt
+     * context, typically a sensor data-ready or FIFO watermark line.
+     */
+    void trigger(int channel);
+
+    /**
+     * Collect pending records, waiting up to timeout for the first one.
+     *
+     * @return number of records copied to dst.
+     */
+    size_t read(SensorRecord *dst, size_t max, rtos::Kernel::Clock::duration_u32 timeout = rtos::Kernel::Clock::duration_u32(0));
+
+    /** Records lost because the application did not read fast enough. */
+    uint32_t dropped() const
+    {
+        return _records.dropped();
+    }
+
+private:
+    static const uint32_t RECORDS_READY = 1;
+    static const uint32_t WAKE_UP = 1;
+    /** Longest idle sleep, when no periodic channel is coming up. */
+    static const uint32_t MAX_SLEEP_US = 1000000;
+
+    void wake_up();
+    void run();
+
+    AcquisitionScheduler &_scheduler;
+    rtos::Thread _thread;
+    rtos::EventFlags _flags;
+    rtos::EventFlags _wake;
+    mbed::Timeout _deadline;
+    SpscRing<SensorRecord, RECORD_RING_SIZE> _records;
+};
+
+} // namespace lab
+
+#endif // LAB_ACQUISITION_THREAD_H
@@ -0,0 +1,188 @@
+#include "DiscoL475Sensors.h"
+
+// the BSP_B-L475E-IOT01 library is only there where the application has it
+#if defined(TARGET_DISCO_L475VG_IOT01A) && MBED_CONF_LAB_UTILS_DISCO_BSP
+
+#include "stm32l475e_iot01.h"
+#include "stm32l475e_iot01_tsensor.h"
+#include "stm32l475e_iot01_hsensor.h"
+#include "stm32l475e_iot01_psensor.h"
+#include "stm32l475e_iot01_magneto.h"
+#include "stm32l475e_iot01_gyro.h"
+#include "stm32l475e_iot01_accelero.h"
+#include "Lsm6dslFifo.h"
+
+namespace lab {
+
+static int read_temperature(void *, SensorRecord &record)
+{
+    record.value[0] = BSP_TSENSOR_ReadTemp();
+    record.count = 1;
+    return 0;
+}
+
+static int read_humidity(void *, SensorRecord &record)
+{
+    record.value[0] = BSP_HSENSOR_ReadHumidity();
+    record.count = 1;
+    return 0;
+}
+
+static int read_pressure(void *, SensorRecord &record)
+{
+    record.value[0] = BSP_PSENSOR_ReadPressure();
+    record.count = 1;
+    return 0;
+}
+
+static int read_magneto(void *, SensorRecord &record)
+{
+    int16_t xyz[3] = {0};
+    BSP_MAGNETO_GetXYZ(xyz);
+    for (int i = 0; i < 3; i++) {
+        record.value[i] = xyz[i];
+    }
+    record.count = 3;
+    return 0;
+}
+
+static int read_gyro(void *, SensorRecord &record)
+{
+    BSP_GYRO_GetXYZ(record.value);
+    record.count = 3;
+    return 0;
+}
+
+static int read_accelero(void *, SensorRecord &record)
+{
+    int16_t xyz[3] = {0};
+    BSP_ACCELERO_AccGetXYZ(xyz);
+    for (int i = 0; i < 3; i++) {
+        record.value[i] = xyz[i];
+    }
+    record.count = 3;
+    return 0;
+}
+
+DiscoL475Rates disco_l475_default_rates()
+{
+    DiscoL475Rates rates;
+    rates.temperature_us = 1000000;
+    rates.humidity_us = 1000000;
+    rates.pressure_us = 1000000;
+    rates.magneto_us = 50000;
+    rates.gyro_us = 10000;
+    rates.accelero_us = 10000;
+    return rates;
+}
+
+int disco_l475_add_sensors(AcquisitionScheduler &scheduler, const DiscoL475Rates &rates,
+                           int channels[DISCO_CHANNEL_COUNT])
+{
+    struct Entry {
+        const char *name;
+        uint32_t period_us;
+        uint8_t priority;
+        SensorReadFn read;
+        uint32_t cost_us;
+    };
+
+    // cost estimates at 100 kHz I2C, refined by the scheduler at run time
+    const Entry table[DISCO_CHANNEL_COUNT] = {
+        { "temperature", rates.temperature_us, 1, read_temperature, 1500 },
+        { "humidity",    rates.humidity_us,    1, read_humidity,    1500 },
+        { "pressure",    rates.pressure_us,    1, read_pressure,    1500 },
+        { "magneto",     rates.magneto_us,     2, read_magneto,     1000 },
+        { "gyro",        rates.gyro_us,        3, read_gyro,        1000 },
+        { "accelero",    rates.accelero_us,    3, read_accelero,    1000 },
+    };
+
+    if (rates.temperature_us) {
+        BSP_TSENSOR_Init();
+    }
+    if (rates.humidity_us) {
+        BSP_HSENSOR_Init();
+    }
+    if (rates.pressure_us) {
+        BSP_PSENSOR_Init();
+    }
+    if (rates.magneto_us) {
+        BSP_MAGNETO_Init();
+    }
+    if (rates.gyro_us) {
+        BSP_GYRO_Init();
+    }
+    if (rates.accelero_us) {
+        BSP_ACCELERO_Init();
+    }
+
+    int added = 0;
+    for (int i = 0; i < DISCO_CHANNEL_COUNT; i++) {
+        channels[i] = -1;
+        if (!table[i].period_us) {
+            continue;
+        }
+        SensorChannelConfig config;
+        config.name = table[i].name;
+        config.period_us = table[i].period_us;
+        config.priority = table[i].priority;
+        config.read = table[i].read;
+        config.context = nullptr;
+        config.cost_us = table[i].cost_us;
+        channels[i] = scheduler.add_channel(config);
+        if (channels[i] >= 0) {
+            added++;
+        }
+    }
+    return added;
+}
+
+const char *disco_l475_unit(DiscoL475Channel channel)
+{
+    switch (channel) {
+        case DISCO_TEMPERATURE:
+            return "degC";
+        case DISCO_HUMIDITY:
+            return "%";
+        case DISCO_PRESSURE:
+            return "mBar";
+        case DISCO_MAGNETO:
+            return "mGauss";
+        case DISCO_GYRO:
+            return "mdps";
+        case DISCO_ACCELERO:
+            return "mg";
+        default:
+            return "";
+    }
+}
+
+class BspImuBus : public RegisterBus {
+public:
+    BspImuBus()
+    {
+        SENSOR_IO_Init();
+    }
+
+    int read(uint8_t reg, uint8_t *data, size_t length) override
+    {
+        return SENSOR_IO_ReadMultiple(Lsm6dslFifo::I2C_ADDRESS, reg, data, length) ? -1 : 0;
+    }
+
+    int write(uint8_t reg, const uint8_t *data, size_t length) override
+    {
+        // the BSP takes a non-const buffer but only transmits it
+        SENSOR_IO_WriteMultiple(Lsm6dslFifo::I2C_ADDRESS, reg, const_cast<uint8_t *>(data), length);
+        return 0;
+    }
+};
+
+RegisterBus &disco_l475_imu_bus()
+{
+    static BspImuBus bus;
+    return bus;
+}
+
+} // namespace lab
+
+#endif // TARGET_DISCO_L475VG_IOT01A && MBED_CONF_LAB_UTILS_DISCO_BSP
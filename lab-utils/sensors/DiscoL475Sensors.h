@@ -0,0 +1,63 @@
+#ifndef LAB_DISCO_L475_SENSORS_H
+#define LAB_DISCO_L475_SENSORS_H
+
+#include "AcquisitionScheduler.h"
+#include "RegisterBus.h"
+
+namespace lab {
+
+/*
+ * Glue to the BSP_B-L475E-IOT01 drivers, built with lab-utils.disco-bsp
+ * in applications that have that library (lab-utils-disco with CMake).
+ */
+
+/** Channels of the B-L475E-IOT01A on-board sensors, in registration order. */
+enum DiscoL475Channel {
+    DISCO_TEMPERATURE = 0,
+    DISCO_HUMIDITY,
+    DISCO_PRESSURE,
+    DISCO_MAGNETO,
+    DISCO_GYRO,
+    DISCO_ACCELERO,
+    DISCO_CHANNEL_COUNT,
+};
+
+/** Sampling periods in microseconds, 0 leaves the sensor out. */
+struct DiscoL475Rates {
+    uint32_t temperature_us;
+    uint32_t humidity_us;
+    uint32_t pressure_us;
+    uint32_t magneto_us;
+    uint32_t gyro_us;
+    uint32_t accelero_us;
+};
+
+/** 1 Hz environment, 20 Hz magnetometer, 100 Hz IMU. */
+DiscoL475Rates disco_l475_default_rates();
+
+/**
+ * Initialise the BSP sensors and register them with a scheduler.
+ *
+ * All six sensors share the internal I2C2 bus, so a single scheduler
+ * serialises them. The IMU gets the highest priority, the magnetometer
+ * comes next and the environmental sensors fill the gaps.
+ *
+ * @param[out] channels Scheduler channel of each sensor, -1 if left out.
+ *
+ * @return number of channels registered.
+ */
+int disco_l475_add_sensors(AcquisitionScheduler &scheduler, const DiscoL475Rates &rates,
+                           int channels[DISCO_CHANNEL_COUNT]);
+
+const char *disco_l475_unit(DiscoL475Channel channel);
+
+/**
+ * Raw register access to the LSM6DSL through the BSP I2C helpers, for
+ * Lsm6dslFifo. Only use it from the thread that owns the sensor bus and
+ * leave the BSP gyro and accelerometer channels out (rate 0).
+ */
+RegisterBus &disco_l475_imu_bus();
+
+} // namespace lab
+
+#endif // LAB_DISCO_L475_SENSORS_H
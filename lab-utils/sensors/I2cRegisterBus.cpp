@@ -0,0 +1,37 @@
+#include "I2cRegisterBus.h"
+
+#if DEVICE_I2C
+
+#include <cstring>
+
+namespace lab {
+
+I2cRegisterBus::I2cRegisterBus(mbed::I2C &i2c, uint8_t address) :
+    _i2c(i2c),
+    _address(address)
+{
+}
+
+int I2cRegisterBus::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    char address = (char)reg;
+    if (_i2c.write(_address, &address, 1, true)) {
+        return -1;
+    }
+    return _i2c.read(_address, reinterpret_cast<char *>(data), (int)length) ? -1 : 0;
+}
+
+int I2cRegisterBus::write(uint8_t reg, const uint8_t *data, size_t length)
+{
+    if (length > WRITE_MAX) {
+        return -1;
+    }
+    char buffer[1 + WRITE_MAX];
+    buffer[0] = (char)reg;
+    memcpy(&buffer[1], data, length);
+    return _i2c.write(_address, buffer, (int)(1 + length)) ? -1 : 0;
+}
+
+} // namespace lab
+
+#endif // DEVICE_I2C
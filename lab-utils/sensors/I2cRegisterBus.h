@@ -0,0 +1,42 @@
+#ifndef LAB_I2C_REGISTER_BUS_H
+#define LAB_I2C_REGISTER_BUS_H
+
+#include "mbed.h"
+
+#include "RegisterBus.h"
+
+#if DEVICE_I2C
+
+namespace lab {
+
+/**
+ * RegisterBus on an Mbed I2C master, for a device with 8-bit register
+ * addresses that auto-increments them over a burst (the LSM6DSL does
+ * with IF_INC, its reset default).
+ *
+ * A read writes the register address and reads after a repeated start,
+ * a write sends the register address and the data in one transfer. Like
+ * the BSP helpers it replaces, it does not lock the I2C object: only use
+ * it from the thread that owns the bus.
+ */
+class I2cRegisterBus : public RegisterBus {
+public:
+    /** Longest write, the register address left out. */
+    static const size_t WRITE_MAX = 16;
+
+    /** @param[in] address 8-bit bus address, e.g. Lsm6dslFifo::I2C_ADDRESS. */
+    I2cRegisterBus(mbed::I2C &i2c, uint8_t address);
+
+    int read(uint8_t reg, uint8_t *data, size_t length) override;
+    int write(uint8_t reg, const uint8_t *data, size_t length) override;
+
+private:
+    mbed::I2C &_i2c;
+    uint8_t _address;
+};
+
+} // namespace lab
+
+#endif // DEVICE_I2C
+
+#endif // LAB_I2C_REGISTER_BUS_H
@@ -0,0 +1,72 @@
+#include "ImuFifoChannel.h"
+
+#include <new>
+
+namespace lab {
+
+/* Block layout: the batch header, then its samples. */
+static const size_t SAMPLES_OFFSET = ImuFifoChannel::block_size(0);
+
+ImuFifoChannel::ImuFifoChannel(Lsm6dslFifo &fifo, BlockPoolBase &pool, BatchSink sink, void *context) :
+    _fifo(fifo),
+    _pool(pool),
+    _sink(sink),
+    _context(context),
+    _no_buffer(0)
+{
+}
+
+int ImuFifoChannel::add_to(AcquisitionScheduler &scheduler, uint8_t priority, uint32_t poll_period_us)
+{
+    SensorChannelConfig config;
+    config.name = "imu-fifo";
+    config.period_us = poll_period_us;
+    config.priority = priority;
+    config.read = &ImuFifoChannel::read;
+    config.context = this;
+    config.cost_us = 2000;
+    return scheduler.add_channel(config);
+}
+
+size_t ImuFifoChannel::batch_capacity() const
+{
+    if (_pool.block_size() <= SAMPLES_OFFSET) {
+        return 0;
+    }
+    return (_pool.block_size() - SAMPLES_OFFSET) / sizeof(ImuSample);
+}
+
+int ImuFifoChannel::read(void *context, SensorRecord &record)
+{
+    ImuFifoChannel &self = *static_cast<ImuFifoChannel *>(context);
+
+    // without a buffer the FIFO keeps filling; the overrun flag tells the
+    // consumer about the hole once buffers are back
+    void *block = self._pool.alloc();
+    if (!block) {
+        self._no_buffer++;
+        return -1;
+    }
+
+    ImuBatch *batch = new (block) ImuBatch;
+    ImuSample *samples = reinterpret_cast<ImuSample *>(static_cast<uint8_t *>(block) + SAMPLES_OFFSET);
+    int count = self._fifo.drain(samples, self.batch_capacity(), record.timestamp_us, *batch);
+
+    if (count < 0) {
+        self._pool.free(block);
+        return -1;
+    }
+
+    record.value[0] = count;
+    record.count = 1;
+
+    // an empty poll is not worth a batch, unless it reports lost samples
+    if (count == 0 && !batch->overrun) {
+        self._pool.free(block);
+    } else {
+        self._sink(self._context, batch);
+    }
+    return 0;
+}
+
+} // namespace lab
@@ -0,0 +1,66 @@
+#ifndef LAB_IMU_FIFO_CHANNEL_H
+#define LAB_IMU_FIFO_CHANNEL_H
+
+#include "AcquisitionScheduler.h"
+#include "BlockPool.h"
+#include "Lsm6dslFifo.h"
+
+namespace lab {
+
+/**
+ * Runs an Lsm6dslFifo as an event driven AcquisitionScheduler channel.
+ *
+ * The watermark interrupt triggers the channel; its read drains the FIFO
+ * into a block taken from a pool and hands the batch to the sink, which
+ * owns it until release(). The SensorRecord of the channel only carries
+ * the number of data sets, so the scheduler statistics still cover the
+ * FIFO traffic.
+ */
+class ImuFifoChannel {
+public:
+    /** Called on the bus thread; give the batch back with release(). */
+    typedef void (*BatchSink)(void *context, ImuBatch *batch);
+
+    /** Pool block size needed for batches of up to sets data sets. */
+    static constexpr size_t block_size(size_t sets)
+    {
+        return ((sizeof(ImuBatch) + 7) & ~size_t(7)) + sets * sizeof(ImuSample);
+    }
+
+    ImuFifoChannel(Lsm6dslFifo &fifo, BlockPoolBase &pool, BatchSink sink, void *context);
+
+    /**
+     * Register with a scheduler. The channel also polls every
+     * poll_period_us in case a watermark edge was missed.
+     *
+     * @return scheduler channel, or -1.
+     */
+    int add_to(AcquisitionScheduler &scheduler, uint8_t priority, uint32_t poll_period_us);
+
+    void release(ImuBatch *batch)
+    {
+        _pool.free(batch);
+    }
+
+    /** Data sets that fit in one pool block. */
+    size_t batch_capacity() const;
+
+    /** Drains skipped because the pool was empty. */
+    uint32_t no_buffer() const
+    {
+        return _no_buffer;
+    }
+
+private:
+    static int read(void *context, SensorRecord &record);
+
+    Lsm6dslFifo &_fifo;
+    BlockPoolBase &_pool;
+    BatchSink _sink;
+    void *_context;
+    uint32_t _no_buffer;
+};
+
+} // namespace lab
+
+#endif // LAB_IMU_FIFO_CHANNEL_H
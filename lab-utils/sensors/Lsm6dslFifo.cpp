@@ -0,0 +1,203 @@
+#include "Lsm6dslFifo.h"
+
+namespace lab {
+
+static uint32_t odr_period_ns(Lsm6dslOdr odr)
+{
+    switch (odr) {
+        case LSM6DSL_ODR_104HZ:
+            return 9615385;
+        case LSM6DSL_ODR_208HZ:
+            return 4807692;
+        case LSM6DSL_ODR_416HZ:
+            return 2403846;
+        case LSM6DSL_ODR_833HZ:
+            return 1200480;
+        case LSM6DSL_ODR_1660HZ:
+            return 600240;
+        case LSM6DSL_ODR_3330HZ:
+            return 300120;
+        case LSM6DSL_ODR_6660HZ:
+        default:
+            return 150060;
+    }
+}
+
+Lsm6dslFifo::Lsm6dslFifo(RegisterBus &bus) :
+    _bus(bus),
+    _stats(),
+    _nominal_period_ns(0),
+    _period_ns(0),
+    _last_us(0),
+    _tracking(false),
+    _sequence(0)
+{
+    _config.odr = LSM6DSL_ODR_1660HZ;
+    _config.watermark = 64;
+    _config.accel_scale = LSM6DSL_ACCEL_2G;
+    _config.gyro_scale = LSM6DSL_GYRO_2000DPS;
+}
+
+int Lsm6dslFifo::configure(const Lsm6dslFifoConfig &config)
+{
+    uint8_t id = 0;
+    if (_bus.read_byte(REG_WHO_AM_I, id)) {
+        _stats.bus_errors++;
+        return -1;
+    }
+    if (id != WHO_AM_I_VALUE) {
+        return -2;
+    }
+
+    _config = config;
+    if (_config.watermark == 0) {
+        _config.watermark = 1;
+    } else if (_config.watermark > MAX_WATERMARK) {
+        _config.watermark = MAX_WATERMARK;
+    }
+
+    uint16_t threshold = _config.watermark * (sizeof(ImuSample) / sizeof(int16_t));
+    const uint8_t sequence[][2] = {
+        // bypass first, this also empties the FIFO
+        { REG_FIFO_CTRL5, FIFO_MODE_BYPASS },
+        { REG_CTRL3_C, CTRL3_C_BDU | CTRL3_C_IF_INC },
+        { REG_CTRL1_XL, (uint8_t)((_config.odr << 4) | (_config.accel_scale << 2)) },
+        { REG_CTRL2_G, (uint8_t)((_config.odr << 4) | (_config.gyro_scale << 2)) },
+        { REG_FIFO_CTRL1, (uint8_t)(threshold & 0xFF) },
+        { REG_FIFO_CTRL2, (uint8_t)((threshold >> 8) & 0x07) },
+        // gyro and accel both stored, no decimation
+        { REG_FIFO_CTRL3, (1 << 3) | 1 },
+        { REG_FIFO_CTRL4, 0 },
+        { REG_INT1_CTRL, INT1_FTH | INT1_FIFO_OVR },
+        { REG_FIFO_CTRL5, (uint8_t)((_config.odr << 3) | FIFO_MODE_CONTINUOUS) },
+    };
+
+    for (size_t i = 0; i < sizeof(sequence) / sizeof(sequence[0]); i++) {
+        if (_bus.write_byte(sequence[i][0], sequence[i][1])) {
+            _stats.bus_errors++;
+            return -1;
+        }
+    }
+
+    _nominal_period_ns = odr_period_ns(_config.odr);
+    _period_ns = _nominal_period_ns;
+    _tracking = false;
+    return 0;
+}
+
+int Lsm6dslFifo::drain(ImuSample *samples, size_t capacity, uint32_t now_us, ImuBatch &batch)
+{
+    const uint16_t words_per_set = sizeof(ImuSample) / sizeof(int16_t);
+    uint8_t status[4];
+
+    if (_bus.read(REG_FIFO_STATUS1, status, sizeof(status))) {
+        _stats.bus_errors++;
+        return -1;
+    }
+
+    uint16_t words = ((status[1] & 0x07) << 8) | status[0];
+    uint16_t pattern = ((status[3] & 0x03) << 8) | status[2];
+    bool overrun = status[1] & FIFO_STATUS2_OVER_RUN;
+    if (status[1] & FIFO_STATUS2_EMPTY) {
+        words = 0;
+    } else if (words == 0) {
+        // DIFF_FIFO has 11 bits: a FIFO that is not empty and counts 0 is full
+        words = FIFO_WORDS;
+    }
+
+    // the next word is not a gyro X: drop the tail of a broken data set
+    uint16_t misaligned = pattern % words_per_set;
+    if (misaligned && words) {
+        uint16_t skip = words_per_set - misaligned;
+        skip = skip < words ? skip : words;
+        uint8_t scratch[sizeof(ImuSample)];
+        if (_bus.read(REG_FIFO_DATA_OUT_L, scratch, skip * sizeof(int16_t))) {
+            _stats.bus_errors++;
+            return -1;
+        }
+        _stats.discarded_words += skip;
+        words -= skip;
+    }
+
+    size_t sets = words / words_per_set;
+    sets = sets < capacity ? sets : capacity;
+
+    // one transaction for the whole batch, little endian words land
+    // directly in the sample structures
+    if (sets && _bus.read(REG_FIFO_DATA_OUT_L, reinterpret_cast<uint8_t *>(samples), sets * sizeof(ImuSample))) {
+        _stats.bus_errors++;
+        return -1;
+    }
+
+    uint32_t remaining = words / words_per_set - sets;
+    uint32_t newest_us = now_us - (uint32_t)(((uint64_t)remaining * _period_ns) / 1000);
+
+    if (overrun) {
+        _stats.overruns++;
+        _tracking = false;
+    }
+
+    if (sets) {
+        if (!_tracking) {
+            _tracking = true;
+        } else {
+            // predicted end of this batch from the previous one; the error
+            // is part interrupt latency (filtered out) and part clock drift
+            // (slowly folded into the period)
+            uint32_t predicted = _last_us + (uint32_t)(((uint64_t)sets * _period_ns) / 1000);
+            int32_t error = (int32_t)(newest_us - predicted);
+            int64_t period = (int64_t)_period_ns + ((int64_t)error * 1000 / (int64_t)sets) / 8;
+            int64_t lo = _nominal_period_ns - _nominal_period_ns / 20;
+            int64_t hi = _nominal_period_ns + _nominal_period_ns / 20;
+            _period_ns = (uint32_t)(period < lo ? lo : (period > hi ? hi : period));
+            newest_us = predicted + error / 4;
+        }
+        _last_us = newest_us;
+    }
+
+    batch.samples = samples;
+    batch.count = sets;
+    batch.period_ns = _period_ns;
+    batch.first_us = sets ? newest_us - (uint32_t)(((uint64_t)(sets - 1) * _period_ns) / 1000) : now_us;
+    batch.overrun = overrun;
+    batch.sequence = _sequence;
+    if (sets || overrun) {
+        _sequence++;
+    }
+
+    _stats.batches++;
+    _stats.samples += sets;
+    return sets;
+}
+
+float Lsm6dslFifo::accel_mg_per_lsb() const
+{
+    switch (_config.accel_scale) {
+        case LSM6DSL_ACCEL_2G:
+            return 0.061f;
+        case LSM6DSL_ACCEL_4G:
+            return 0.122f;
+        case LSM6DSL_ACCEL_8G:
+            return 0.244f;
+        case LSM6DSL_ACCEL_16G:
+        default:
+            return 0.488f;
+    }
+}
+
+float Lsm6dslFifo::gyro_mdps_per_lsb() const
+{
+    switch (_config.gyro_scale) {
+        case LSM6DSL_GYRO_250DPS:
+            return 8.75f;
+        case LSM6DSL_GYRO_500DPS:
+            return 17.5f;
+        case LSM6DSL_GYRO_1000DPS:
+            return 35.0f;
+        case LSM6DSL_GYRO_2000DPS:
+        default:
+            return 70.0f;
+    }
+}
+
+} // namespace lab
@@ -0,0 +1,178 @@
+#ifndef LAB_LSM6DSL_FIFO_H
+#define LAB_LSM6DSL_FIFO_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "RegisterBus.h"
+
+namespace lab {
+
+/** One FIFO data set, in the order the LSM6DSL stores it. */
+struct ImuSample {
+    int16_t gyro[3];
+    int16_t accel[3];
+};
+
+/** A burst of samples read from the FIFO with reconstructed timing. */
+struct ImuBatch {
+    /** Estimated sampling time of samples[0]. */
+    uint32_t first_us;
+    /** Estimated sample period, refined from the batch arrival times. */
+    uint32_t period_ns;
+    uint16_t count;
+    uint16_t sequence;
+    /** The FIFO overflowed: samples were lost right before this batch. */
+    bool overrun;
+    ImuSample *samples;
+
+    uint32_t timestamp_us(size_t index) const
+    {
+        return first_us + (uint32_t)(((uint64_t)index * period_ns) / 1000);
+    }
+};
+
+/** Output data rates usable with the FIFO (CTRL1_XL / CTRL2_G codes). */
+enum Lsm6dslOdr : uint8_t {
+    LSM6DSL_ODR_104HZ = 0x4,
+    LSM6DSL_ODR_208HZ = 0x5,
+    LSM6DSL_ODR_416HZ = 0x6,
+    LSM6DSL_ODR_833HZ = 0x7,
+    LSM6DSL_ODR_1660HZ = 0x8,
+    LSM6DSL_ODR_3330HZ = 0x9,
+    LSM6DSL_ODR_6660HZ = 0xA,
+};
+
+enum Lsm6dslAccelScale : uint8_t {
+    LSM6DSL_ACCEL_2G = 0x0,
+    LSM6DSL_ACCEL_16G = 0x1,
+    LSM6DSL_ACCEL_4G = 0x2,
+    LSM6DSL_ACCEL_8G = 0x3,
+};
+
+enum Lsm6dslGyroScale : uint8_t {
+    LSM6DSL_GYRO_250DPS = 0x0,
+    LSM6DSL_GYRO_500DPS = 0x1,
+    LSM6DSL_GYRO_1000DPS = 0x2,
+    LSM6DSL_GYRO_2000DPS = 0x3,
+};
+
+struct Lsm6dslFifoConfig {
+    Lsm6dslOdr odr;
+    /** Data sets (gyro + accel) that raise the watermark interrupt. */
+    uint16_t watermark;
+    Lsm6dslAccelScale accel_scale;
+    Lsm6dslGyroScale gyro_scale;
+};
+
+struct Lsm6dslFifoStats {
+    uint32_t batches;
+    uint32_t samples;
+    uint32_t overruns;
+    /** Words dropped to realign on a data set boundary. */
+    uint32_t discarded_words;
+    uint32_t bus_errors;
+};
+
+/**
+ * Burst reader of the LSM6DSL hardware FIFO.
+ *
+ * Gyroscope and accelerometer are stored interleaved, without decimation,
+ * in continuous mode; INT1 goes high at the watermark and on overrun.
+ * drain() reads the FIFO status, then the whole available content in a
+ * single transaction (the FIFO output address rolls back from
+ * FIFO_DATA_OUT_H to FIFO_DATA_OUT_L) straight into the caller's buffer.
+ *
+ * The device has no timestamps in this mode, so they are reconstructed:
+ * the newest sample is anchored to the time of the status read, older
+ * ones are spaced by the sample period, and the period itself is tracked
+ * from successive batches since the sensor clock is only accurate to a
+ * few percent. An overrun breaks the sample chain and restarts tracking.
+ */
+class Lsm6dslFifo {
+public:
+    static const uint8_t I2C_ADDRESS = 0xD4;
+    static const uint8_t WHO_AM_I_VALUE = 0x6A;
+    /** 4 KB FIFO of 12-byte data sets. */
+    static const uint16_t MAX_WATERMARK = 4096 / sizeof(ImuSample) - 1;
+    static const uint16_t FIFO_WORDS = 4096 / sizeof(int16_t);
+
+    enum {
+        REG_FIFO_CTRL1 = 0x06,
+        REG_FIFO_CTRL2 = 0x07,
+        REG_FIFO_CTRL3 = 0x08,
+        REG_FIFO_CTRL4 = 0x09,
+        REG_FIFO_CTRL5 = 0x0A,
+        REG_INT1_CTRL = 0x0D,
+        REG_WHO_AM_I = 0x0F,
+        REG_CTRL1_XL = 0x10,
+        REG_CTRL2_G = 0x11,
+        REG_CTRL3_C = 0x12,
+        REG_FIFO_STATUS1 = 0x3A,
+        REG_FIFO_STATUS2 = 0x3B,
+        REG_FIFO_STATUS3 = 0x3C,
+        REG_FIFO_STATUS4 = 0x3D,
+        REG_FIFO_DATA_OUT_L = 0x3E,
+        REG_FIFO_DATA_OUT_H = 0x3F,
+    };
+
+    enum {
+        FIFO_STATUS2_WATERMARK = 0x80,
+        FIFO_STATUS2_OVER_RUN = 0x40,
+        FIFO_STATUS2_EMPTY = 0x10,
+        FIFO_MODE_BYPASS = 0x0,
+        FIFO_MODE_CONTINUOUS = 0x6,
+        INT1_FTH = 0x08,
+        INT1_FIFO_OVR = 0x10,
+        CTRL3_C_BDU = 0x40,
+        CTRL3_C_IF_INC = 0x04,
+    };
+
+    explicit Lsm6dslFifo(RegisterBus &bus);
+
+    /**
+     * Program data rate, scales, watermark and interrupt, then start the
+     * FIFO in continuous mode.
+     *
+     * @return 0, -1 on a bus error or -2 if the device does not answer as
+     * an LSM6DSL.
+     */
+    int configure(const Lsm6dslFifoConfig &config);
+
+    /**
+     * Read everything available, up to capacity data sets.
+     *
+     * @param[in] now_us Time of the call, used to anchor timestamps.
+     *
+     * @return number of data sets read, or -1 on a bus error.
+     */
+    int drain(ImuSample *samples, size_t capacity, uint32_t now_us, ImuBatch &batch);
+
+    /** Nominal period of the configured data rate. */
+    uint32_t nominal_period_ns() const
+    {
+        return _nominal_period_ns;
+    }
+
+    float accel_mg_per_lsb() const;
+    float gyro_mdps_per_lsb() const;
+
+    const Lsm6dslFifoStats &stats() const
+    {
+        return _stats;
+    }
+
+private:
+    RegisterBus &_bus;
+    Lsm6dslFifoConfig _config;
+    Lsm6dslFifoStats _stats;
+    uint32_t _nominal_period_ns;
+    uint32_t _period_ns;
+    uint32_t _last_us;
+    bool _tracking;
+    uint16_t _sequence;
+};
+
+} // namespace lab
+
+#endif // LAB_LSM6DSL_FIFO_H
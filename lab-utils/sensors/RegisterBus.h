@@ -0,0 +1,38 @@
+#ifndef LAB_REGISTER_BUS_H
+#define LAB_REGISTER_BUS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Register access to one device on a sensor bus.
+ *
+ * Multi-byte accesses are single bus transactions starting at reg; the
+ * device decides how the address advances.
+ */
+class RegisterBus {
+public:
+    virtual ~RegisterBus() {}
+
+    /** @return 0 on success, a negative error otherwise. */
+    virtual int read(uint8_t reg, uint8_t *data, size_t length) = 0;
+
+    /** @return 0 on success, a negative error otherwise. */
+    virtual int write(uint8_t reg, const uint8_t *data, size_t length) = 0;
+
+    int write_byte(uint8_t reg, uint8_t value)
+    {
+        return write(reg, &value, 1);
+    }
+
+    int read_byte(uint8_t reg, uint8_t &value)
+    {
+        return read(reg, &value, 1);
+    }
+};
+
+} // namespace lab
+
+#endif // LAB_REGISTER_BUS_H
@@ -0,0 +1,22 @@
+#ifndef LAB_SENSOR_RECORD_H
+#define LAB_SENSOR_RECORD_H
+
+#include <cstdint>
+
+namespace lab {
+
+/** One timestamped reading of a sensor channel. */
+struct SensorRecord {
+    /** Time the bus transaction started. */
+    uint32_t timestamp_us;
+    /** Per channel counter, gaps reveal dropped records. */
+    uint16_t sequence;
+    uint8_t channel;
+    /** Number of valid entries in value (1 for scalars, 3 for X/Y/Z). */
+    uint8_t count;
+    float value[3];
+};
+
+} // namespace lab
+
+#endif // LAB_SENSOR_RECORD_H
@@ -0,0 +1,176 @@
+#include "SimulatedLsm6dsl.h"
+
+#include <cstring>
+
+namespace lab {
+
+static const uint16_t WORDS_PER_SET = sizeof(ImuSample) / sizeof(int16_t);
+
+SimulatedLsm6dsl::SimulatedLsm6dsl(int32_t clock_error_ppm) :
+    _fifo_head(0),
+    _fifo_count(0),
+    _pattern(0),
+    _overrun(false),
+    _fail_next(false),
+    _clock_error_ppm(clock_error_ppm),
+    _now_us(0),
+    _now_ns(0),
+    _start_ns(0),
+    _produced(0)
+{
+    memset(_registers, 0, sizeof(_registers));
+    memset(_fifo, 0, sizeof(_fifo));
+    _registers[Lsm6dslFifo::REG_WHO_AM_I] = Lsm6dslFifo::WHO_AM_I_VALUE;
+    _registers[Lsm6dslFifo::REG_CTRL3_C] = Lsm6dslFifo::CTRL3_C_IF_INC;
+}
+
+bool SimulatedLsm6dsl::running() const
+{
+    uint8_t ctrl5 = _registers[Lsm6dslFifo::REG_FIFO_CTRL5];
+    return (ctrl5 & 0x07) == Lsm6dslFifo::FIFO_MODE_CONTINUOUS && ((ctrl5 >> 3) & 0x0F) != 0;
+}
+
+uint16_t SimulatedLsm6dsl::threshold() const
+{
+    return ((_registers[Lsm6dslFifo::REG_FIFO_CTRL2] & 0x07) << 8) | _registers[Lsm6dslFifo::REG_FIFO_CTRL1];
+}
+
+uint64_t SimulatedLsm6dsl::period_ns() const
+{
+    // 6664 Hz >> (10 - code), the data sheet rates
+    uint8_t code = (_registers[Lsm6dslFifo::REG_FIFO_CTRL5] >> 3) & 0x0F;
+    uint64_t hz = code >= 4 && code <= 10 ? 6664u >> (10 - code) : 104;
+    uint64_t nominal = 1000000000ull / hz;
+    return nominal + (int64_t)nominal * _clock_error_ppm / 1000000;
+}
+
+uint32_t SimulatedLsm6dsl::sample_time_us(uint32_t set_index) const
+{
+    uint64_t at_ns = _start_ns + (uint64_t)(set_index + 1) * period_ns();
+    return _now_us - (uint32_t)((_now_ns - at_ns) / 1000);
+}
+
+void SimulatedLsm6dsl::push_set()
+{
+    // continuous mode: the oldest data set is overwritten
+    if (_fifo_count + WORDS_PER_SET > FIFO_WORDS) {
+        _fifo_head = (_fifo_head + WORDS_PER_SET) % FIFO_WORDS;
+        _fifo_count -= WORDS_PER_SET;
+        _overrun = true;
+    }
+    for (int w = 0; w < WORDS_PER_SET; w++) {
+        _fifo[(_fifo_head + _fifo_count) % FIFO_WORDS] = (uint16_t)expected_word(_produced, w);
+        _fifo_count++;
+    }
+    _produced++;
+}
+
+void SimulatedLsm6dsl::advance_to(uint32_t now_us)
+{
+    // extend the 32-bit time, assuming calls less than 71 min apart
+    _now_ns += (uint64_t)(uint32_t)(now_us - _now_us) * 1000;
+    _now_us = now_us;
+
+    if (!running()) {
+        _start_ns = _now_ns;
+        return;
+    }
+
+    uint64_t period = period_ns();
+    while (_start_ns + (uint64_t)(_produced + 1) * period <= _now_ns) {
+        push_set();
+    }
+}
+
+bool SimulatedLsm6dsl::int1() const
+{
+    uint8_t ctrl = _registers[Lsm6dslFifo::REG_INT1_CTRL];
+    return ((ctrl & Lsm6dslFifo::INT1_FTH) && _fifo_count >= threshold() && threshold()) ||
+           ((ctrl & Lsm6dslFifo::INT1_FIFO_OVR) && _overrun);
+}
+
+uint8_t SimulatedLsm6dsl::status_register(uint8_t reg) const
+{
+    switch (reg) {
+        case Lsm6dslFifo::REG_FIFO_STATUS1:
+            return _fifo_count & 0xFF;
+        case Lsm6dslFifo::REG_FIFO_STATUS2:
+            return ((_fifo_count >> 8) & 0x07) |
+                   (_fifo_count >= threshold() && threshold() ? Lsm6dslFifo::FIFO_STATUS2_WATERMARK : 0) |
+                   (_overrun ? Lsm6dslFifo::FIFO_STATUS2_OVER_RUN : 0) |
+                   (_fifo_count == 0 ? Lsm6dslFifo::FIFO_STATUS2_EMPTY : 0);
+        case Lsm6dslFifo::REG_FIFO_STATUS3:
+            return _pattern & 0xFF;
+        case Lsm6dslFifo::REG_FIFO_STATUS4:
+        default:
+            return (_pattern >> 8) & 0x03;
+    }
+}
+
+int SimulatedLsm6dsl::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    if (_fail_next) {
+        _fail_next = false;
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        if (reg == Lsm6dslFifo::REG_FIFO_DATA_OUT_L || reg == Lsm6dslFifo::REG_FIFO_DATA_OUT_H) {
+            uint16_t word = 0;
+            if (_fifo_count) {
+                word = _fifo[_fifo_head];
+            }
+            data[i] = reg == Lsm6dslFifo::REG_FIFO_DATA_OUT_L ? word & 0xFF : word >> 8;
+            if (reg == Lsm6dslFifo::REG_FIFO_DATA_OUT_H) {
+                if (_fifo_count) {
+                    _fifo_head = (_fifo_head + 1) % FIFO_WORDS;
+                    _fifo_count--;
+                    _pattern = (_pattern + 1) % WORDS_PER_SET;
+                    _overrun = false;
+                }
+                // the FIFO output address rolls back
+                reg = Lsm6dslFifo::REG_FIFO_DATA_OUT_L;
+            } else {
+                reg = Lsm6dslFifo::REG_FIFO_DATA_OUT_H;
+            }
+            continue;
+        }
+
+        if (reg >= Lsm6dslFifo::REG_FIFO_STATUS1 && reg <= Lsm6dslFifo::REG_FIFO_STATUS4) {
+            data[i] = status_register(reg);
+        } else {
+            data[i] = _registers[reg & 0x7F];
+        }
+        reg++;
+    }
+    return 0;
+}
+
+int SimulatedLsm6dsl::write(uint8_t reg, const uint8_t *data, size_t length)
+{
+    if (_fail_next) {
+        _fail_next = false;
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++, reg++) {
+        if (reg == Lsm6dslFifo::REG_WHO_AM_I) {
+            continue;
+        }
+        _registers[reg & 0x7F] = data[i];
+
+        if (reg == Lsm6dslFifo::REG_FIFO_CTRL5) {
+            if ((data[i] & 0x07) == Lsm6dslFifo::FIFO_MODE_BYPASS) {
+                _fifo_head = 0;
+                _fifo_count = 0;
+                _pattern = 0;
+                _overrun = false;
+            }
+            _start_ns = _now_ns;
+            _produced = 0;
+        }
+    }
+    return 0;
+}
+
+} // namespace lab
@@ -0,0 +1,78 @@
+#ifndef LAB_SIMULATED_LSM6DSL_H
+#define LAB_SIMULATED_LSM6DSL_H
+
+#include "Lsm6dslFifo.h"
+
+namespace lab {
+
+/**
+ * Register-level model of the LSM6DSL FIFO, for host builds.
+ *
+ * Produces gyro/accel data sets at the programmed FIFO rate in virtual
+ * time, with an optional clock error, and implements the FIFO status
+ * registers, the watermark and overrun flags, the INT1 line and the
+ * rolling FIFO output address. Sample content is deterministic (see
+ * expected_word()) so a reader can verify ordering and losses.
+ */
+class SimulatedLsm6dsl : public RegisterBus {
+public:
+    static const uint16_t FIFO_WORDS = Lsm6dslFifo::FIFO_WORDS;
+
+    /** @param[in] clock_error_ppm deviation of the sensor clock from nominal. */
+    explicit SimulatedLsm6dsl(int32_t clock_error_ppm = 0);
+
+    /** Produce every data set due up to now_us. */
+    void advance_to(uint32_t now_us);
+
+    /** Level of the INT1 line. */
+    bool int1() const;
+
+    /** Make the next transaction fail. */
+    void fail_next()
+    {
+        _fail_next = true;
+    }
+
+    /** Data sets produced since the FIFO was started. */
+    uint32_t produced() const
+    {
+        return _produced;
+    }
+
+    /** Exact production time of a data set, for timestamp checks. */
+    uint32_t sample_time_us(uint32_t set_index) const;
+
+    /** Content of word (0-5, gyro XYZ then accel XYZ) of a data set. */
+    static int16_t expected_word(uint32_t set_index, int word)
+    {
+        return (int16_t)(((set_index * 8) + word) & 0x7FFF);
+    }
+
+    int read(uint8_t reg, uint8_t *data, size_t length) override;
+    int write(uint8_t reg, const uint8_t *data, size_t length) override;
+
+private:
+    bool running() const;
+    uint16_t threshold() const;
+    uint64_t period_ns() const;
+    void push_set();
+    uint8_t status_register(uint8_t reg) const;
+
+    uint8_t _registers[0x80];
+    uint16_t _fifo[FIFO_WORDS];
+    uint16_t _fifo_head;
+    uint16_t _fifo_count;
+    /** Position of the next word to read within its data set. */
+    uint32_t _pattern;
+    bool _overrun;
+    bool _fail_next;
+    int32_t _clock_error_ppm;
+    uint32_t _now_us;
+    uint64_t _now_ns;
+    uint64_t _start_ns;
+    uint32_t _produced;
+};
+
+} // namespace lab
+
+#endif // LAB_SIMULATED_LSM6DSL_H
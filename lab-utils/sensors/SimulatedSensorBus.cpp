@@ -0,0 +1,100 @@
+#include "SimulatedSensorBus.h"
+
+#include <cmath>
+
+namespace lab {
+
+SimulatedSensorBus::SimulatedSensorBus(uint32_t start_us) : _count(0), _now_us(start_us)
+{
+    for (size_t i = 0; i < MAX_DEVICES; i++) {
+        _channel_device[i] = -1;
+    }
+}
+
+int SimulatedSensorBus::attach(AcquisitionScheduler &scheduler, SensorChannelConfig config,
+                               uint32_t latency_us, uint8_t axes)
+{
+    if (_count == MAX_DEVICES) {
+        return -1;
+    }
+
+    Device &device = _devices[_count];
+    device.bus = this;
+    device.latency_us = latency_us;
+    device.axes = axes > 3 ? 3 : axes;
+    device.fail_next = false;
+    // a different tone per device makes mixed up channels obvious
+    device.frequency_hz = 1.0f + _count;
+
+    config.read = &SimulatedSensorBus::read;
+    config.context = &device;
+    int channel = scheduler.add_channel(config);
+    if (channel < 0) {
+        return -1;
+    }
+    _channel_device[channel] = _count++;
+    return channel;
+}
+
+void SimulatedSensorBus::fail_next(int channel)
+{
+    if (channel >= 0 && (size_t)channel < MAX_DEVICES && _channel_device[channel] >= 0) {
+        _devices[_channel_device[channel]].fail_next = true;
+    }
+}
+
+int SimulatedSensorBus::read(void *context, SensorRecord &record)
+{
+    Device &device = *static_cast<Device *>(context);
+    device.bus->_now_us += device.latency_us;
+
+    if (device.fail_next) {
+        device.fail_next = false;
+        return -1;
+    }
+
+    float t = device.bus->_now_us * 1e-6f;
+    for (uint8_t i = 0; i < device.axes; i++) {
+        record.value[i] = 1000.0f * sinf(2.0f * 3.14159265f * device.frequency_hz * t + i);
+    }
+    record.count = device.axes;
+    return 0;
+}
+
+SimulatedSensorBus::RunStats SimulatedSensorBus::run(AcquisitionScheduler &scheduler, uint32_t duration_us,
+                                                     RecordSink sink, void *sink_context)
+{
+    RunStats stats = { 0, 0, 0 };
+    uint32_t end = _now_us + duration_us;
+
+    while ((int32_t)(end - _now_us) > 0) {
+        uint32_t wait = 0;
+        int channel = scheduler.next(_now_us, &wait);
+        if (channel < 0) {
+            uint32_t left = end - _now_us;
+            wait = wait < left ? wait : left;
+            // the scheduler may ask for a zero wait right at a deadline
+            wait = wait ? wait : 1;
+            _now_us += wait;
+            stats.idle_us += wait;
+            continue;
+        }
+
+        uint32_t start = _now_us;
+        SensorRecord record;
+        bool ok = scheduler.execute(channel, start, record);
+        scheduler.complete(channel, start, _now_us);
+        stats.busy_us += _now_us - start;
+
+        if (ok) {
+            stats.records++;
+            if (sink) {
+                sink(sink_context, record);
+            }
+        }
+    }
+
+    return stats;
+}
+
+} // namespace lab
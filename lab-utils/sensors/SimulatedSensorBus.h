@@ -0,0 +1,74 @@
+#ifndef LAB_SIMULATED_SENSOR_BUS_H
+#define LAB_SIMULATED_SENSOR_BUS_H
+
+#include "AcquisitionScheduler.h"
+
+namespace lab {
+
+/**
+ * Sensor bus running in virtual time, for host builds.
+ *
+ * Each simulated device takes a fixed time per transaction and returns a
+ * sine wave, which is enough to check scheduling decisions, latencies and
+ * the achievable aggregate rate of a channel set without hardware.
+ */
+class SimulatedSensorBus {
+public:
+    static const size_t MAX_DEVICES = AcquisitionScheduler::MAX_CHANNELS;
+
+    typedef void (*RecordSink)(void *context, const SensorRecord &record);
+
+    struct RunStats {
+        uint32_t records;
+        uint64_t busy_us;
+        uint64_t idle_us;
+    };
+
+    /** @param[in] start_us Virtual time to start from, e.g. just before the wrap. */
+    explicit SimulatedSensorBus(uint32_t start_us = 0);
+
+    /**
+     * Add a device and register it with a scheduler.
+     *
+     * @param[in] config Channel configuration; read and context are
+     * replaced by the simulated device.
+     * @param[in] latency_us Duration of one transaction.
+     * @param[in] axes 1 for a scalar sensor, 3 for X/Y/Z.
+     *
+     * @return scheduler channel, or -1.
+     */
+    int attach(AcquisitionScheduler &scheduler, SensorChannelConfig config,
+               uint32_t latency_us, uint8_t axes);
+
+    /** Inject a transaction failure on the next read of a channel. */
+    void fail_next(int channel);
+
+    /** Drive the scheduler for duration_us of virtual time. */
+    RunStats run(AcquisitionScheduler &scheduler, uint32_t duration_us,
+                 RecordSink sink = nullptr, void *sink_context = nullptr);
+
+    uint32_t now() const
+    {
+        return _now_us;
+    }
+
+private:
+    struct Device {
+        SimulatedSensorBus *bus;
+        uint32_t latency_us;
+        uint8_t axes;
+        bool fail_next;
+        float frequency_hz;
+    };
+
+    static int read(void *context, SensorRecord &record);
+
+    Device _devices[MAX_DEVICES];
+    int _channel_device[MAX_DEVICES];
+    size_t _count;
+    uint32_t _now_us;
+};
+
+} // namespace lab
+
+#endif // LAB_SIMULATED_SENSOR_BUS_H
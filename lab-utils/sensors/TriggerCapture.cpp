@@ -0,0 +1,286 @@
+#include "TriggerCapture.h"
+
+#include <cstring>
+
+namespace lab {
+
+const char *capture_source_name(CaptureSource source)
+{
+    switch (source) {
+        case CAPTURE_THRESHOLD:
+            return "threshold";
+        case CAPTURE_BUTTON:
+            return "button";
+        case CAPTURE_COMMAND:
+            return "command";
+        default:
+            return "none";
+    }
+}
+
+TriggerCaptureBase::TriggerCaptureBase(int16_t *values, uint32_t *times, size_t capacity, size_t channels) :
+    _values(values),
+    _times(times),
+    _capacity(capacity),
+    _channels(channels),
+    _config(),
+    _state(CAPTURE_ARMED),
+    _head(0),
+    _filled(0),
+    _start(0),
+    _taken(0),
+    _threshold_ready(true),
+    _pending(CAPTURE_NONE),
+    _pending_us(0),
+    _burst(),
+    _stats()
+{
+    // a quarter before the trigger until configured
+    _config.pre_samples = (uint16_t)(capacity / 4);
+    _config.post_samples = (uint16_t)(capacity - capacity / 4);
+}
+
+int TriggerCaptureBase::configure(const CaptureConfig &config)
+{
+    bool threshold = config.magnitude_high || config.magnitude_low;
+    if (!config.post_samples || (size_t)config.pre_samples + config.post_samples > _capacity ||
+        (threshold && (size_t)config.magnitude_channel + 3 > _channels)) {
+        return -1;
+    }
+    _config = config;
+    reset();
+    return 0;
+}
+
+void TriggerCaptureBase::reset()
+{
+    _state = CAPTURE_ARMED;
+    _head = 0;
+    _filled = 0;
+    _taken = 0;
+    _threshold_ready = true;
+    _pending = CAPTURE_NONE;
+    _burst = CaptureBurst();
+}
+
+/** Slot of the sample back samples before the newest one. */
+size_t TriggerCaptureBase::slot(size_t back) const
+{
+    return (_head + 2 * _capacity - 1 - back) % _capacity;
+}
+
+bool TriggerCaptureBase::push(const int16_t *sample, uint32_t timestamp_us)
+{
+    bool outside = check_threshold(sample);
+    if (_state == CAPTURE_FROZEN) {
+        _stats.dropped++;
+        return false;
+    }
+
+    memcpy(_values + _head * _channels, sample, _channels * sizeof(int16_t));
+    _times[_head] = timestamp_us;
+    _head = (_head + 1) % _capacity;
+    _filled += _filled < _capacity;
+    _stats.samples++;
+
+    if (_state == CAPTURE_RECORDING) {
+        if (++_taken >= _config.post_samples) {
+            freeze();
+            return true;
+        }
+        return false;
+    }
+
+    if (_pending && (int32_t)(timestamp_us - _pending_us) >= 0) {
+        CaptureSource source = _pending;
+        _pending = CAPTURE_NONE;
+        start(source, 0, _pending_us);
+    } else if (outside && !_pending) {
+        start(CAPTURE_THRESHOLD, 0, timestamp_us);
+    }
+    return _state == CAPTURE_FROZEN;
+}
+
+int TriggerCaptureBase::trigger(CaptureSource source, uint32_t timestamp_us)
+{
+    if (_state != CAPTURE_ARMED || _pending) {
+        _stats.busy++;
+        return -1;
+    }
+    if (!_filled || (int32_t)(timestamp_us - _times[slot(0)]) > 0) {
+        // its sample is still to come
+        _pending = source;
+        _pending_us = timestamp_us;
+        return 0;
+    }
+
+    // the oldest sample at or after the time
+    size_t back = 0;
+    while (back + 1 < _filled && (int32_t)(_times[slot(back + 1)] - timestamp_us) >= 0) {
+        back++;
+    }
+    if (back + 1 == _filled && (int32_t)(_times[slot(back)] - timestamp_us) > 0) {
+        _stats.late++;
+    }
+    start(source, back, timestamp_us);
+    return 0;
+}
+
+void TriggerCaptureBase::start(CaptureSource source, size_t back, uint32_t requested_us)
+{
+    size_t before = _filled - 1 - back;
+    size_t pre = before < _config.pre_samples ? before : _config.pre_samples;
+    _start = (slot(back) + _capacity - pre) % _capacity;
+    _taken = back + 1;
+    _burst.source = source;
+    _burst.pre = (uint16_t)pre;
+    _burst.length = (uint16_t)(pre + _config.post_samples);
+    _burst.requested_us = requested_us;
+    _burst.trigger_us = _times[slot(back)];
+    _state = CAPTURE_RECORDING;
+    if (_taken >= _config.post_samples) {
+        freeze();
+    }
+}
+
+void TriggerCaptureBase::freeze()
+{
+    _state = CAPTURE_FROZEN;
+    _burst.sequence++;
+    _burst.first_us = _times[_start];
+    _burst.last_us = _times[(_start + _burst.length - 1) % _capacity];
+    _stats.bursts++;
+}
+
+/**
+ * Whether the sample is out of the band while the threshold is ready to
+ * fire. Once out, the threshold waits for the magnitude to come back in
+ * by the hysteresis, whatever the state: a burst that ends in the middle
+ * of a long shock is not followed by a second one.
+ */
+bool TriggerCaptureBase::check_threshold(const int16_t *sample)
+{
+    if (!_config.magnitude_high && !_config.magnitude_low) {
+        return false;
+    }
+    const int16_t *axis = sample + _config.magnitude_channel;
+    uint64_t square = 0;
+    for (int i = 0; i < 3; i++) {
+        square += (uint64_t)((int32_t)axis[i] * axis[i]);
+    }
+    uint64_t high = _config.magnitude_high;
+    uint64_t low = _config.magnitude_low;
+    if ((high && square > high * high) || (low && square < low * low)) {
+        bool ready = _threshold_ready;
+        _threshold_ready = false;
+        return ready;
+    }
+    uint64_t high_rearm = high > _config.hysteresis ? high - _config.hysteresis : 0;
+    uint64_t low_rearm = low + _config.hysteresis;
+    if ((!high || square < high_rearm * high_rearm) && (!low || square > low_rearm * low_rearm)) {
+        _threshold_ready = true;
+    }
+    return false;
+}
+
+size_t TriggerCaptureBase::read(size_t first, int16_t *values, size_t count) const
+{
+    if (_state != CAPTURE_FROZEN || first >= _burst.length) {
+        return 0;
+    }
+    if (count > _burst.length - first) {
+        count = _burst.length - first;
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t index = (_start + first + i) % _capacity;
+        memcpy(values + i * _channels, _values + index * _channels, _channels * sizeof(int16_t));
+    }
+    return count;
+}
+
+int16_t TriggerCaptureBase::value(size_t index, size_t channel) const
+{
+    return _values[((_start + index) % _capacity) * _channels + channel];
+}
+
+uint32_t TriggerCaptureBase::timestamp(size_t index) const
+{
+    return _times[(_start + index) % _capacity];
+}
+
+void TriggerCaptureBase::release()
+{
+    if (_state != CAPTURE_FROZEN) {
+        return;
+    }
+    // samples were dropped meanwhile, the history starts over
+    _state = CAPTURE_ARMED;
+    _head = 0;
+    _filled = 0;
+    _taken = 0;
+}
+
+static void put16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t *out, uint32_t value)
+{
+    put16(out, (uint16_t)value);
+    put16(out + 2, (uint16_t)(value >> 16));
+}
+
+size_t capture_chunk_samples(const TriggerCaptureBase &capture, size_t capacity)
+{
+    return capacity > 2 ? (capacity - 2) / (capture.channels() * sizeof(int16_t)) : 0;
+}
+
+size_t capture_chunk_count(const TriggerCaptureBase &capture, size_t capacity)
+{
+    size_t per_chunk = capture_chunk_samples(capture, capacity);
+    if (capture.state() != CAPTURE_FROZEN || !per_chunk) {
+        return 0;
+    }
+    return 1 + (capture.burst().length + per_chunk - 1) / per_chunk;
+}
+
+int encode_capture_chunk(const TriggerCaptureBase &capture, size_t index, uint8_t *out, size_t capacity)
+{
+    size_t per_chunk = capture_chunk_samples(capture, capacity);
+    if (capacity < CAPTURE_DESCRIPTOR_SIZE || !per_chunk || index >= capture_chunk_count(capture, capacity)) {
+        return -1;
+    }
+    const CaptureBurst &burst = capture.burst();
+    put16(out, (uint16_t)index);
+    if (index == 0) {
+        uint32_t period_ns = 0;
+        if (burst.length > 1) {
+            period_ns = (uint32_t)((uint64_t)(burst.last_us - burst.first_us) * 1000 / (burst.length - 1));
+        }
+        out[2] = (uint8_t)burst.sequence;
+        out[3] = burst.source;
+        out[4] = (uint8_t)capture.channels();
+        out[5] = 0;
+        put16(out + 6, burst.pre);
+        put16(out + 8, burst.length);
+        put32(out + 10, burst.requested_us);
+        put32(out + 14, burst.trigger_us);
+        put32(out + 18, burst.first_us);
+        put32(out + 22, period_ns);
+        return (int)CAPTURE_DESCRIPTOR_SIZE;
+    }
+
+    size_t first = (index - 1) * per_chunk;
+    size_t length = 2;
+    for (size_t i = first; i < first + per_chunk && i < burst.length; i++) {
+        for (size_t channel = 0; channel < capture.channels(); channel++) {
+            put16(out + length, (uint16_t)capture.value(i, channel));
+            length += 2;
+        }
+    }
+    return (int)length;
+}
+
+} // namespace lab
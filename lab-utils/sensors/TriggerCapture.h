@@ -0,0 +1,239 @@
+#ifndef LAB_TRIGGER_CAPTURE_H
+#define LAB_TRIGGER_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/** What started a burst. */
+enum CaptureSource : uint8_t {
+    CAPTURE_NONE = 0,
+    /** The magnitude left the band of CaptureConfig. */
+    CAPTURE_THRESHOLD = 1,
+    CAPTURE_BUTTON = 2,
+    CAPTURE_COMMAND = 3,
+};
+
+const char *capture_source_name(CaptureSource source);
+
+enum CaptureState : uint8_t {
+    /** Keeping the history, waiting for a trigger. */
+    CAPTURE_ARMED = 0,
+    /** Triggered, taking the post-trigger samples. */
+    CAPTURE_RECORDING = 1,
+    /** A burst is complete and kept until release(). */
+    CAPTURE_FROZEN = 2,
+};
+
+struct CaptureConfig {
+    /** Samples kept before the trigger sample. */
+    uint16_t pre_samples;
+    /** Samples from the trigger sample on, at least 1. */
+    uint16_t post_samples;
+    /** First of the three channels the threshold takes the magnitude of. */
+    uint8_t magnitude_channel;
+    /** Trigger above high or below low (free fall), raw units; 0 is off. */
+    uint16_t magnitude_high;
+    uint16_t magnitude_low;
+    /** The magnitude must come this far back into the band before it triggers again. */
+    uint16_t hysteresis;
+};
+
+/** A frozen burst. */
+struct CaptureBurst {
+    /** Bursts frozen since reset(), this one included. */
+    uint32_t sequence;
+    CaptureSource source;
+    /** Samples before the trigger sample: pre_samples, fewer if the history was short. */
+    uint16_t pre;
+    /** pre plus post_samples. */
+    uint16_t length;
+    /** Time of the trigger sample, and the time the trigger was for. */
+    uint32_t trigger_us;
+    uint32_t requested_us;
+    uint32_t first_us;
+    uint32_t last_us;
+};
+
+struct CaptureStats {
+    uint32_t samples;
+    uint32_t bursts;
+    /** Triggers turned down while a burst was recording or frozen. */
+    uint32_t busy;
+    /** Triggers for a time older than the history, started at its oldest sample. */
+    uint32_t late;
+    /** Samples not kept while a burst was frozen. */
+    uint32_t dropped;
+};
+
+/**
+ * Pre/post-trigger capture of a sample stream, as an oscilloscope does.
+ *
+ * Samples of a fixed number of channels go into a ring at the full rate
+ * of the sensor. A trigger picks a trigger sample; the burst is the
+ * pre_samples before it and post_samples from it on, and is frozen in
+ * the ring once they are in, to be read out at leisure (read()) and
+ * handed back with release().
+ *
+ * The threshold trigger looks at every sample pushed. Button presses and
+ * commands come through trigger() with the time they happened: a time
+ * the history already covers picks the first sample at or after it, so
+ * the trigger sample is the one of the event even when the samples
+ * arrive in batches (a FIFO drained every 20 ms) after it; a later time
+ * waits for its sample.
+ *
+ * While a burst is frozen new samples are not kept, and after release()
+ * the history fills again: a trigger that comes before it holds
+ * pre_samples gets fewer (burst().pre). Not for interrupt context; the
+ * owner of the stream calls everything, InputPipeline subscribers and BLE
+ * handlers run on the same event queue.
+ *
+ * Use the TriggerCapture template below for the storage.
+ */
+class TriggerCaptureBase {
+public:
+    /**
+     * @return 0, -1 if pre and post samples do not fit the ring, there is
+     * no post sample, or the magnitude channels are not all there.
+     */
+    int configure(const CaptureConfig &config);
+
+    /** Drop the history and any burst, armed again. */
+    void reset();
+
+    /**
+     * Take one sample of channels() values.
+     *
+     * @return true if it completed a burst, state() is then FROZEN.
+     */
+    bool push(const int16_t *sample, uint32_t timestamp_us);
+
+    /**
+     * Trigger for an event at timestamp_us. The burst may freeze at once
+     * if the history already holds its post-trigger samples.
+     *
+     * @return 0, -1 if a burst is recording or frozen, or another
+     * trigger waits for its sample.
+     */
+    int trigger(CaptureSource source, uint32_t timestamp_us);
+
+    CaptureState state() const
+    {
+        return _state;
+    }
+
+    /** The burst, valid while FROZEN. */
+    const CaptureBurst &burst() const
+    {
+        return _burst;
+    }
+
+    /**
+     * Copy samples first to first + count of the frozen burst, oldest
+     * first, channels() values each.
+     *
+     * @return samples copied, 0 when not FROZEN.
+     */
+    size_t read(size_t first, int16_t *values, size_t count) const;
+
+    /** One value of sample index of the frozen burst. */
+    int16_t value(size_t index, size_t channel) const;
+
+    /** Time of sample index of the frozen burst. */
+    uint32_t timestamp(size_t index) const;
+
+    /** Hand the frozen burst back and arm again. */
+    void release();
+
+    size_t channels() const
+    {
+        return _channels;
+    }
+
+    size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    const CaptureConfig &config() const
+    {
+        return _config;
+    }
+
+    const CaptureStats &stats() const
+    {
+        return _stats;
+    }
+
+protected:
+    TriggerCaptureBase(int16_t *values, uint32_t *times, size_t capacity, size_t channels);
+
+private:
+    size_t slot(size_t back) const;
+    void start(CaptureSource source, size_t back, uint32_t requested_us);
+    void freeze();
+    bool check_threshold(const int16_t *sample);
+
+    int16_t *_values;
+    uint32_t *_times;
+    size_t _capacity;
+    size_t _channels;
+    CaptureConfig _config;
+    CaptureState _state;
+    /** Slot of the next sample, and samples in the ring. */
+    size_t _head;
+    size_t _filled;
+    /** Slot of the first sample of the burst, and samples taken from the trigger sample on. */
+    size_t _start;
+    size_t _taken;
+    /** Magnitude back in the band: the threshold may fire. */
+    bool _threshold_ready;
+    CaptureSource _pending;
+    uint32_t _pending_us;
+    CaptureBurst _burst;
+    CaptureStats _stats;
+};
+
+/**
+ * Capture with its storage, for a static instance.
+ *
+ * @tparam Capacity samples of the ring, at least pre_samples + post_samples.
+ * @tparam Channels values per sample.
+ */
+template<size_t Capacity, size_t Channels>
+class TriggerCapture : public TriggerCaptureBase {
+public:
+    TriggerCapture() : TriggerCaptureBase(_storage, _timestamps, Capacity, Channels) {}
+
+private:
+    int16_t _storage[Capacity * Channels];
+    uint32_t _timestamps[Capacity];
+};
+
+/**
+ * A frozen burst in chunks of capacity bytes, for notifications. Each
+ * chunk starts with its 16 bit index (little endian, as every field).
+ * Chunk 0 describes the burst: sequence (8 bit), source, channels, 0,
+ * pre, length (16 bit), requested_us, trigger_us, first_us and the mean
+ * sample period in ns (32 bit). The others carry samples, as many whole
+ * ones as fit, chunk k from sample (k - 1) * capture_chunk_samples() on;
+ * sample i was taken at first_us + i * period_ns / 1000.
+ */
+static const size_t CAPTURE_DESCRIPTOR_SIZE = 26;
+
+/** Samples in a chunk of capacity bytes. */
+size_t capture_chunk_samples(const TriggerCaptureBase &capture, size_t capacity);
+
+/** Chunks of the frozen burst, the descriptor included; 0 when not FROZEN. */
+size_t capture_chunk_count(const TriggerCaptureBase &capture, size_t capacity);
+
+/**
+ * @return bytes written, -1 when not FROZEN, for an index past the burst
+ * or if capacity does not take the descriptor or a sample.
+ */
+int encode_capture_chunk(const TriggerCaptureBase &capture, size_t index, uint8_t *out, size_t capacity);
+
+} // namespace lab
+
+#endif // LAB_TRIGGER_CAPTURE_H
@@ -0,0 +1,45 @@
+#include "BlockDeviceFlash.h"
+
+namespace lab {
+
+BlockDeviceFlash::BlockDeviceFlash(mbed::BlockDevice &device, size_t page_size) :
+    _device(device),
+    _page_size(page_size)
+{
+}
+
+int BlockDeviceFlash::init()
+{
+    int err = _device.init();
+    if (err) {
+        return err;
+    }
+    return _device.get_program_size() == 1 ? 0 : BD_ERROR_DEVICE_ERROR;
+}
+
+int BlockDeviceFlash::read(uint32_t address, void *data, size_t length)
+{
+    return _device.read(data, address, length);
+}
+
+int BlockDeviceFlash::program(uint32_t address, const void *data, size_t length)
+{
+    return _device.program(data, address, length);
+}
+
+int BlockDeviceFlash::erase(uint32_t address, size_t length)
+{
+    return _device.erase(address, length);
+}
+
+size_t BlockDeviceFlash::sector_size() const
+{
+    return _device.get_erase_size();
+}
+
+uint32_t BlockDeviceFlash::size() const
+{
+    return _device.size();
+}
+
+} // namespace lab
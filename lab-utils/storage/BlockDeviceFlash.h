@@ -0,0 +1,48 @@
+#ifndef LAB_BLOCK_DEVICE_FLASH_H
+#define LAB_BLOCK_DEVICE_FLASH_H
+
+#include "mbed.h"
+#include "blockdevice/BlockDevice.h"
+
+#include "FlashDevice.h"
+
+namespace lab {
+
+/**
+ * FlashDevice on top of an Mbed BlockDevice, e.g. the QSPIF driver of the
+ * MX25R6435F 8 MB NOR on the B-L475E-IOT01A.
+ *
+ * The device must allow programming a byte again (program size 1, as NOR
+ * flashes do); internal STM32L4 flash, with 8-byte ECC words, does not.
+ */
+class BlockDeviceFlash : public FlashDevice {
+public:
+    /**
+     * @param[in] page_size Program page of the device, the unit the log
+     * writes in; 256 bytes for QSPI NOR.
+     */
+    explicit BlockDeviceFlash(mbed::BlockDevice &device, size_t page_size = 256);
+
+    /** Initialise the block device. @return 0, or a BlockDevice error. */
+    int init();
+
+    int read(uint32_t address, void *data, size_t length) override;
+    int program(uint32_t address, const void *data, size_t length) override;
+    int erase(uint32_t address, size_t length) override;
+
+    size_t page_size() const override
+    {
+        return _page_size;
+    }
+
+    size_t sector_size() const override;
+    uint32_t size() const override;
+
+private:
+    mbed::BlockDevice &_device;
+    size_t _page_size;
+};
+
+} // namespace lab
+
+#endif // LAB_BLOCK_DEVICE_FLASH_H
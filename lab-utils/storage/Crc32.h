@@ -0,0 +1,34 @@
+#ifndef LAB_CRC32_H
+#define LAB_CRC32_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * Reflected CRC-32 (IEEE 802.3), nibble table. Start from 0xFFFFFFFF and
+ * invert the result.
+ */
+inline uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t length)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return crc;
+}
+
+inline uint32_t crc32(const void *data, size_t length)
+{
+    return ~crc32_update(0xFFFFFFFF, static_cast<const uint8_t *>(data), length);
+}
+
+} // namespace lab
+
+#endif // LAB_CRC32_H
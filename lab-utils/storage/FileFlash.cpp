@@ -0,0 +1,131 @@
+#include "FileFlash.h"
+
+#include <cstring>
+
+namespace lab {
+
+FileFlash::FileFlash(const char *path, uint32_t size, size_t page_size, size_t sector_size) :
+    _file(nullptr),
+    _size(size),
+    _page_size(page_size),
+    _sector_size(sector_size),
+    _powered(true),
+    _cut_armed(false),
+    _cut_budget(0),
+    _erase_counts(new uint32_t[size / sector_size]())
+{
+    _file = fopen(path, "r+b");
+    if (!_file) {
+        _file = fopen(path, "w+b");
+    }
+    if (!_file) {
+        return;
+    }
+
+    // extend a new or short file with erased cells
+    fseek(_file, 0, SEEK_END);
+    long length = ftell(_file);
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    while (length >= 0 && (uint32_t)length < _size) {
+        size_t chunk = _size - (uint32_t)length < sizeof(erased) ? _size - (uint32_t)length : sizeof(erased);
+        fwrite(erased, 1, chunk, _file);
+        length += chunk;
+    }
+    fflush(_file);
+}
+
+FileFlash::~FileFlash()
+{
+    if (_file) {
+        fclose(_file);
+    }
+    delete[] _erase_counts;
+}
+
+size_t FileFlash::budget(size_t length)
+{
+    if (!_cut_armed) {
+        return length;
+    }
+    if (_cut_budget >= length) {
+        _cut_budget -= length;
+        return length;
+    }
+    size_t allowed = _cut_budget;
+    _cut_budget = 0;
+    _cut_armed = false;
+    _powered = false;
+    return allowed;
+}
+
+int FileFlash::read(uint32_t address, void *data, size_t length)
+{
+    if (!_file || !_powered || address + length > _size) {
+        return -1;
+    }
+    fseek(_file, address, SEEK_SET);
+    return fread(data, 1, length, _file) == length ? 0 : -1;
+}
+
+int FileFlash::program(uint32_t address, const void *data, size_t length)
+{
+    if (!_file || !_powered || address + length > _size) {
+        return -1;
+    }
+    if (length && address / _page_size != (address + length - 1) / _page_size) {
+        return -1;
+    }
+
+    uint8_t cells[256];
+    const uint8_t *src = static_cast<const uint8_t *>(data);
+    size_t allowed = budget(length);
+
+    for (size_t done = 0; done < allowed;) {
+        size_t chunk = allowed - done < sizeof(cells) ? allowed - done : sizeof(cells);
+        fseek(_file, address + done, SEEK_SET);
+        if (fread(cells, 1, chunk, _file) != chunk) {
+            return -1;
+        }
+        for (size_t i = 0; i < chunk; i++) {
+            cells[i] &= src[done + i];
+        }
+        fseek(_file, address + done, SEEK_SET);
+        fwrite(cells, 1, chunk, _file);
+        done += chunk;
+    }
+    fflush(_file);
+    return allowed == length ? 0 : -1;
+}
+
+int FileFlash::erase(uint32_t address, size_t length)
+{
+    if (!_file || !_powered || address + length > _size
+            || address % _sector_size || length % _sector_size) {
+        return -1;
+    }
+
+    uint8_t erased[256];
+    memset(erased, 0xFF, sizeof(erased));
+    size_t allowed = budget(length);
+
+    fseek(_file, address, SEEK_SET);
+    for (size_t done = 0; done < allowed;) {
+        size_t chunk = allowed - done < sizeof(erased) ? allowed - done : sizeof(erased);
+        fwrite(erased, 1, chunk, _file);
+        done += chunk;
+    }
+    fflush(_file);
+
+    for (uint32_t sector = address / _sector_size; sector < (address + length) / _sector_size; sector++) {
+        _erase_counts[sector]++;
+    }
+    return allowed == length ? 0 : -1;
+}
+
+uint32_t FileFlash::erase_count(uint32_t address) const
+{
+    return address < _size ? _erase_counts[address / _sector_size] : 0;
+}
+
+} // namespace lab
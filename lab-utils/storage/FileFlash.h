@@ -0,0 +1,88 @@
+#ifndef LAB_FILE_FLASH_H
+#define LAB_FILE_FLASH_H
+
+#include <cstdio>
+
+#include "FlashDevice.h"
+
+namespace lab {
+
+/**
+ * NOR flash simulated in a host file.
+ *
+ * Programming ANDs the data into the file, like the real cells, and
+ * checks page boundaries and erase alignment. The file keeps its content
+ * between runs, so a log can be remounted after a simulated reset.
+ *
+ * cut_power_after() injects a power cut: once the given number of bytes
+ * has been programmed or erased, the operation in progress stops half
+ * way and every access fails until restore_power().
+ */
+class FileFlash : public FlashDevice {
+public:
+    FileFlash(const char *path, uint32_t size, size_t page_size = 256, size_t sector_size = 4096);
+    ~FileFlash() override;
+
+    /** @return true if the file could be opened. */
+    bool is_open() const
+    {
+        return _file != nullptr;
+    }
+
+    int read(uint32_t address, void *data, size_t length) override;
+    int program(uint32_t address, const void *data, size_t length) override;
+    int erase(uint32_t address, size_t length) override;
+
+    size_t page_size() const override
+    {
+        return _page_size;
+    }
+
+    size_t sector_size() const override
+    {
+        return _sector_size;
+    }
+
+    uint32_t size() const override
+    {
+        return _size;
+    }
+
+    /** Lose power after bytes more bytes were written, 0 cuts at once. */
+    void cut_power_after(size_t bytes)
+    {
+        _cut_armed = true;
+        _cut_budget = bytes;
+    }
+
+    void restore_power()
+    {
+        _powered = true;
+        _cut_armed = false;
+    }
+
+    bool powered() const
+    {
+        return _powered;
+    }
+
+    /** Erase count of the sector holding address, for wear checks. */
+    uint32_t erase_count(uint32_t address) const;
+
+private:
+    /* bytes of the operation that get written before the cut */
+    size_t budget(size_t length);
+
+    FILE *_file;
+    uint32_t _size;
+    size_t _page_size;
+    size_t _sector_size;
+    bool _powered;
+    bool _cut_armed;
+    size_t _cut_budget;
+    uint32_t *_erase_counts;
+};
+
+} // namespace lab
+
+#endif // LAB_FILE_FLASH_H
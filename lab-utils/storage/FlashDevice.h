@@ -0,0 +1,36 @@
+#ifndef LAB_FLASH_DEVICE_H
+#define LAB_FLASH_DEVICE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lab {
+
+/**
+ * NOR flash seen by the storage code.
+ *
+ * Programming can only clear bits, erasing a sector sets it back to 0xFF.
+ * A page that was programmed may be programmed again to clear more bits,
+ * which the ring log uses to mark pages as consumed.
+ */
+class FlashDevice {
+public:
+    virtual ~FlashDevice() {}
+
+    /** @return 0 on success, a negative error otherwise. */
+    virtual int read(uint32_t address, void *data, size_t length) = 0;
+
+    /** Program within one page. @return 0 on success, a negative error otherwise. */
+    virtual int program(uint32_t address, const void *data, size_t length) = 0;
+
+    /** Erase whole sectors. @return 0 on success, a negative error otherwise. */
+    virtual int erase(uint32_t address, size_t length) = 0;
+
+    virtual size_t page_size() const = 0;
+    virtual size_t sector_size() const = 0;
+    virtual uint32_t size() const = 0;
+};
+
+} // namespace lab
+
+#endif // LAB_FLASH_DEVICE_H
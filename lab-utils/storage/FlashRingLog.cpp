@@ -0,0 +1,374 @@
+#include "FlashRingLog.h"
+
+#include <cstring>
+
+#include "Crc32.h"
+
+namespace lab {
+
+/*
+ * Page header, little endian:
+ *   0  u16 magic
+ *   2  u8  state, 0xFF pending, programmed to 0x00 once consumed
+ *   3  u8  record count
+ *   4  u32 sequence number
+ *   8  u16 payload bytes used
+ *   10 u16 reserved, 0xFFFF
+ *   12 u32 CRC-32 of bytes 0-1, 3-11 and the payload used
+ * followed by records, each a u16 length then the data.
+ */
+static const uint16_t PAGE_MAGIC = 0x4C52;
+static const uint8_t STATE_PENDING = 0xFF;
+static const uint8_t STATE_CONSUMED = 0x00;
+static const size_t STATE_OFFSET = 2;
+
+static inline uint16_t get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline void put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+}
+
+static inline void put32(uint8_t *p, uint32_t value)
+{
+    put16(p, value);
+    put16(p + 2, value >> 16);
+}
+
+static uint32_t page_crc(const uint8_t *page, size_t used)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    crc = crc32_update(crc, page, STATE_OFFSET);
+    crc = crc32_update(crc, page + STATE_OFFSET + 1, 12 - STATE_OFFSET - 1);
+    crc = crc32_update(crc, page + FlashRingLogBase::HEADER_SIZE, used);
+    return ~crc;
+}
+
+static bool all_erased(const uint8_t *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+FlashRingLogBase::FlashRingLogBase(FlashDevice &flash, uint32_t start, uint32_t size, size_t page_size,
+                                   uint8_t *buffers) :
+    _flash(flash),
+    _start(start),
+    _page_size(page_size),
+    _page_count(size / page_size),
+    _pages_per_sector(flash.sector_size() / page_size),
+    _write_page(buffers),
+    _read_page(buffers + page_size),
+    _head(0),
+    _head_ready(false),
+    _next_seq(1),
+    _tail(0),
+    _backlog(0),
+    _read_loaded(false),
+    _read_offset(0),
+    _read_records(0)
+{
+    memset(&_stats, 0, sizeof(_stats));
+    reset_write();
+}
+
+void FlashRingLogBase::reset_write()
+{
+    memset(_write_page, 0xFF, _page_size);
+    _write_used = 0;
+    _write_records = 0;
+}
+
+int FlashRingLogBase::format()
+{
+    if (_flash.erase(_start, _page_count * _page_size)) {
+        _stats.flash_errors++;
+        return -1;
+    }
+    _head = 0;
+    _head_ready = true;
+    _next_seq = 1;
+    _tail = 0;
+    _backlog = 0;
+    _read_loaded = false;
+    reset_write();
+    return 0;
+}
+
+int FlashRingLogBase::mount()
+{
+    if (_pages_per_sector == 0 || _page_count < 2 * _pages_per_sector
+            || _flash.sector_size() % _page_size || _page_size % _flash.page_size()) {
+        return -1;
+    }
+
+    uint8_t header[HEADER_SIZE];
+    bool found = false;
+    uint32_t newest = 0;
+    uint32_t newest_seq = 0;
+
+    // the newest page gives the write position
+    for (uint32_t page = 0; page < _page_count; page++) {
+        if (_flash.read(page_address(page), header, sizeof(header))) {
+            _stats.flash_errors++;
+            return -1;
+        }
+        if (get16(header) != PAGE_MAGIC) {
+            continue;
+        }
+        uint32_t seq = get32(header + 4);
+        if (!found || (int32_t)(seq - newest_seq) > 0) {
+            found = true;
+            newest = page;
+            newest_seq = seq;
+        }
+    }
+
+    _read_loaded = false;
+    reset_write();
+
+    if (!found) {
+        _head = 0;
+        _head_ready = false;
+        _next_seq = 1;
+        _tail = 0;
+        _backlog = 0;
+        return 0;
+    }
+
+    // continue after the newest page, past pages torn before their magic
+    // was written; the remainder of a sector is erased in write order
+    _next_seq = newest_seq + 1;
+    _head = next_page(newest);
+    _head_ready = !sector_start(_head);
+    while (_head_ready) {
+        if (_flash.read(page_address(_head), header, sizeof(header))) {
+            _stats.flash_errors++;
+            return -1;
+        }
+        if (all_erased(header, sizeof(header))) {
+            break;
+        }
+        _head = next_page(_head);
+        _head_ready = !sector_start(_head);
+    }
+
+    // consumed pages are a prefix in write order: the replay resumes at
+    // the first pending page after the write position
+    _tail = _head;
+    _backlog = 0;
+    for (uint32_t n = 0, page = _head; n < _page_count; n++, page = next_page(page)) {
+        if (_flash.read(page_address(page), header, sizeof(header))) {
+            _stats.flash_errors++;
+            return -1;
+        }
+        if (get16(header) == PAGE_MAGIC && header[STATE_OFFSET] == STATE_PENDING
+                && (int32_t)(get32(header + 4) - _next_seq) < 0) {
+            _tail = page;
+            _backlog = (_head + _page_count - _tail) % _page_count;
+            // pending data right at the write position: the ring is full
+            _backlog = _backlog ? _backlog : _page_count;
+            break;
+        }
+    }
+    return 0;
+}
+
+int FlashRingLogBase::prepare_sector()
+{
+    // the oldest pages live in the sector about to be erased
+    uint32_t sector = _head / _pages_per_sector;
+    if (_backlog && _tail / _pages_per_sector == sector) {
+        uint32_t next = (sector + 1) * _pages_per_sector % _page_count;
+        uint32_t lost = (next + _page_count - _tail) % _page_count;
+        lost = lost < _backlog ? lost : _backlog;
+        _stats.pages_lost += lost;
+        _backlog -= lost;
+        _tail = _backlog ? next : _head;
+        _read_loaded = false;
+    }
+
+    if (_flash.erase(page_address(_head), _pages_per_sector * _page_size)) {
+        _stats.flash_errors++;
+        return -1;
+    }
+    _stats.sectors_erased++;
+    _head_ready = true;
+    return 0;
+}
+
+int FlashRingLogBase::program_page()
+{
+    if (!_head_ready || sector_start(_head)) {
+        if (prepare_sector()) {
+            return -1;
+        }
+    }
+
+    put16(_write_page, PAGE_MAGIC);
+    _write_page[STATE_OFFSET] = STATE_PENDING;
+    _write_page[3] = _write_records;
+    put32(_write_page + 4, _next_seq);
+    put16(_write_page + 8, _write_used);
+    put16(_write_page + 10, 0xFFFF);
+    put32(_write_page + 12, page_crc(_write_page, _write_used));
+
+    int err = _flash.program(page_address(_head), _write_page, HEADER_SIZE + _write_used);
+
+    // a failed program leaves the page dirty, never program it twice
+    _head = next_page(_head);
+    _head_ready = !sector_start(_head);
+    _next_seq++;
+    _backlog++;
+
+    if (err) {
+        _stats.flash_errors++;
+        return -1;
+    }
+    _stats.pages_written++;
+    _stats.records_appended += _write_records;
+    reset_write();
+    return 0;
+}
+
+int FlashRingLogBase::append(const void *record, size_t length)
+{
+    if (length > max_record_size()) {
+        return -2;
+    }
+
+    if (HEADER_SIZE + _write_used + 2 + length > _page_size || _write_records == 0xFF) {
+        if (program_page()) {
+            return -1;
+        }
+    }
+
+    uint8_t *p = _write_page + HEADER_SIZE + _write_used;
+    put16(p, length);
+    memcpy(p + 2, record, length);
+    _write_used += 2 + length;
+    _write_records++;
+    return 0;
+}
+
+int FlashRingLogBase::flush()
+{
+    return _write_records ? program_page() : 0;
+}
+
+int FlashRingLogBase::load_tail()
+{
+    while (!_read_loaded) {
+        if (!_backlog) {
+            if (!_write_records) {
+                return 0;
+            }
+            if (program_page()) {
+                return -1;
+            }
+            continue;
+        }
+
+        if (_flash.read(page_address(_tail), _read_page, _page_size)) {
+            _stats.flash_errors++;
+            return -1;
+        }
+
+        uint16_t used = get16(_read_page + 8);
+        bool valid = get16(_read_page) == PAGE_MAGIC
+                     && used <= _page_size - HEADER_SIZE
+                     && get32(_read_page + 12) == page_crc(_read_page, used);
+        if (!valid) {
+            // mark a torn page so the next mount does not resume there
+            if (!all_erased(_read_page, HEADER_SIZE)) {
+                _stats.bad_pages++;
+                uint8_t state = STATE_CONSUMED;
+                if (_read_page[STATE_OFFSET] != STATE_CONSUMED
+                        && _flash.program(page_address(_tail) + STATE_OFFSET, &state, 1)) {
+                    _stats.flash_errors++;
+                    return -1;
+                }
+            }
+            _tail = next_page(_tail);
+            _backlog--;
+            continue;
+        }
+
+        _read_loaded = true;
+        _read_offset = HEADER_SIZE;
+        _read_records = _read_page[3];
+        if (_read_page[STATE_OFFSET] != STATE_PENDING || _read_records == 0) {
+            _read_records = 0;
+            if (consume()) {
+                return -1;
+            }
+        }
+    }
+    return 1;
+}
+
+int FlashRingLogBase::peek(void *record, size_t capacity)
+{
+    int loaded = load_tail();
+    if (loaded <= 0) {
+        return loaded;
+    }
+
+    uint16_t length = get16(_read_page + _read_offset);
+    if (_read_offset + 2 + length > _page_size) {
+        // CRC protected, cannot happen unless the writer was different
+        _stats.bad_pages++;
+        _read_records = 0;
+        consume();
+        return peek(record, capacity);
+    }
+    if (length > capacity) {
+        return -2;
+    }
+    memcpy(record, _read_page + _read_offset + 2, length);
+    return length;
+}
+
+int FlashRingLogBase::consume()
+{
+    if (!_read_loaded) {
+        return 0;
+    }
+
+    if (_read_records) {
+        _read_offset += 2 + get16(_read_page + _read_offset);
+        _read_records--;
+    }
+    if (_read_records) {
+        return 0;
+    }
+
+    // the whole page went through: remember it across resets
+    _read_loaded = false;
+    uint32_t page = _tail;
+    _tail = next_page(_tail);
+    _backlog--;
+    if (_read_page[STATE_OFFSET] == STATE_PENDING) {
+        uint8_t state = STATE_CONSUMED;
+        if (_flash.program(page_address(page) + STATE_OFFSET, &state, 1)) {
+            _stats.flash_errors++;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+} // namespace lab
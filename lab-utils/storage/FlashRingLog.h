@@ -0,0 +1,178 @@
+#ifndef LAB_FLASH_RING_LOG_H
+#define LAB_FLASH_RING_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FlashDevice.h"
+
+namespace lab {
+
+struct FlashRingLogStats {
+    uint32_t records_appended;
+    uint32_t pages_written;
+    uint32_t sectors_erased;
+    /** Unconsumed pages overwritten because the log was full. */
+    uint32_t pages_lost;
+    /** Pages skipped on replay: torn by a power cut or corrupted. */
+    uint32_t bad_pages;
+    uint32_t flash_errors;
+};
+
+/**
+ * Append-only record log in a flash region, used as a ring.
+ *
+ * Records are batched in RAM and written one full page at a time, with a
+ * header holding a sequence number and a CRC-32 of the page. Pages are
+ * written strictly in order around the region, so every sector is erased
+ * equally often; when the ring is full the oldest sector is erased and
+ * its unconsumed pages are counted as lost.
+ *
+ * Replay reads the oldest unconsumed record with peek() and acknowledges
+ * it with consume(). A page is marked consumed in flash by programming a
+ * status byte of its header once all its records went through, so the
+ * replay position survives a reset; records of a partly replayed page
+ * are replayed again after a reset (at-least-once delivery).
+ *
+ * mount() rebuilds the positions from the page headers: the newest
+ * sequence number gives the write position, the first unconsumed page
+ * the replay position. A page torn by a power cut fails its CRC and is
+ * skipped, a torn sector erase is redone before the sector is written.
+ *
+ * Records still in the RAM page are lost on a reset; call flush() to
+ * bound that window.
+ *
+ * Use the FlashRingLog template below to get the page buffers.
+ */
+class FlashRingLogBase {
+public:
+    static const size_t HEADER_SIZE = 16;
+
+    /**
+     * @param[in] start First byte of the region, sector aligned.
+     * @param[in] size Region size, at least two sectors.
+     * @param[in] page_size Bytes per log page, a multiple of the device
+     * page dividing the sector size.
+     * @param[in] buffers 2 * page_size bytes of RAM.
+     */
+    FlashRingLogBase(FlashDevice &flash, uint32_t start, uint32_t size, size_t page_size, uint8_t *buffers);
+
+    /** Recover the positions from flash. @return 0, or -1. */
+    int mount();
+
+    /** Erase the whole region. @return 0, or -1. */
+    int format();
+
+    /**
+     * Queue a record, programming the current page when it is full.
+     *
+     * @return 0, -1 on a flash error (the record is not queued) or -2 if
+     * the record can never fit in a page.
+     */
+    int append(const void *record, size_t length);
+
+    /** Program the records queued in RAM, if any. @return 0, or -1. */
+    int flush();
+
+    /**
+     * Oldest unconsumed record. Queued RAM records are flushed once the
+     * replay reaches them.
+     *
+     * @return record length, 0 if there is none, -1 on a flash error or
+     * -2 if capacity is too small.
+     */
+    int peek(void *record, size_t capacity);
+
+    /** Acknowledge the record returned by peek(). @return 0, or -1. */
+    int consume();
+
+    bool empty() const
+    {
+        return _backlog == 0 && _write_used == 0;
+    }
+
+    /** Written pages not consumed yet. */
+    uint32_t backlog_pages() const
+    {
+        return _backlog;
+    }
+
+    /** Largest record that fits in a page. */
+    size_t max_record_size() const
+    {
+        return _page_size - HEADER_SIZE - 2;
+    }
+
+    const FlashRingLogStats &stats() const
+    {
+        return _stats;
+    }
+
+private:
+    uint32_t page_address(uint32_t page) const
+    {
+        return _start + page * _page_size;
+    }
+
+    uint32_t next_page(uint32_t page) const
+    {
+        return page + 1 < _page_count ? page + 1 : 0;
+    }
+
+    bool sector_start(uint32_t page) const
+    {
+        return page % _pages_per_sector == 0;
+    }
+
+    int program_page();
+    int prepare_sector();
+    int load_tail();
+    void reset_write();
+
+    FlashDevice &_flash;
+    uint32_t _start;
+    uint32_t _page_size;
+    uint32_t _page_count;
+    uint32_t _pages_per_sector;
+    uint8_t *_write_page;
+    uint8_t *_read_page;
+
+    uint32_t _head;
+    bool _head_ready;
+    uint32_t _next_seq;
+    size_t _write_used;
+    uint8_t _write_records;
+
+    uint32_t _tail;
+    /* pages from tail to head, the ring may be entirely full */
+    uint32_t _backlog;
+    bool _read_loaded;
+    size_t _read_offset;
+    uint8_t _read_records;
+
+    FlashRingLogStats _stats;
+};
+
+/**
+ * Flash ring log with its page buffers.
+ *
+ * @tparam PageSize bytes per log page, typically the flash page (256 for
+ * the QSPI NOR of the B-L475E-IOT01A).
+ */
+template<size_t PageSize>
+class FlashRingLog : public FlashRingLogBase {
+    static_assert(PageSize >= 64 && PageSize <= 4096, "FlashRingLog pages are 64 to 4096 bytes");
+
+public:
+    FlashRingLog(FlashDevice &flash, uint32_t start, uint32_t size) :
+        FlashRingLogBase(flash, start, size, PageSize, _buffers)
+    {
+    }
+
+private:
+    uint8_t _buffers[2 * PageSize];
+};
+
+} // namespace lab
+
+#endif // LAB_FLASH_RING_LOG_H
@@ -2,6 +2,8 @@
 #include "mbed.h"
 #include "mbed_wait_api.h"
 
+#include "InputPipeline.h"
+
 
 #define LD1_ON {led1 = 1;} 
 #define LD1_OFF {led1 = 0;}
@@ -30,6 +32,8 @@ DigitalOut led2(LED2);
 // Only one of these LEDs can be driven at a time. 
 DigitalInOut led34(LED3);
 InterruptIn button(USER_BUTTON);
+EventQueue input_queue;
+lab::InputPipeline input(input_queue);
 int led_nb = 0;
 int led3_status = 0;
 int led4_status = 0;
@@ -85,13 +89,24 @@ void button_released() {
     ++botton_switch; 
 }
 
+// Debounced events, so a bouncing contact only counts once
+void button_events(const lab::InputEvent *events, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].type == lab::INPUT_PRESS) {
+            button_pressed();
+        } else if (events[i].type == lab::INPUT_RELEASE) {
+            button_released();
+        }
+    }
+}
+
 int main() {
     LD1_OFF;
     LD2_OFF;
     LD3_OFF;
     LD4_OFF;
-    button.fall(&button_pressed); // Change led delay 
-    button.rise(&button_released); // Change led
+    input.attach(button);
+    input.subscribe(button_events);
     const int a1 = 1;
     const int a2 = 2;
     const int a3 = 3; 
@@ -100,5 +115,5 @@ int main() {
     t2.start(callback(led_thread, (void *)&a2)); 
     t3.start(callback(led_thread, (void *)&a3)); 
     t4.start(callback(led_thread, (void *)&a4)); 
-    while (1);
+    input_queue.dispatch_forever();
 }
\ No newline at end of file
@@ -9,6 +9,28 @@ import os
 from datetime import datetime
 import matplotlib.pyplot as plt
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                '..', '..', 'lab-utils', 'metrics'))
+import metrics  # noqa: E402
+
+# LAB_BROADCAST=<name> publishes every message to that shared memory ring
+# of the ingest host, for other consumers (ingest/broadcast/broadcast.py)
+BROADCAST = os.environ.get('LAB_BROADCAST')
+if BROADCAST:
+    sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                    '..', '..', 'ingest', 'broadcast'))
+    import broadcast  # noqa: E402
+
+
+def print_features(data):
+    # one list per axis: rms, kurtosis, peak Hz, peak rms, band energies
+    print(f"window {data['s']} t={data['t']} us anomaly={data['an']:#x}")
+    for name, axis in zip(['X', 'Y', 'Z'], data['f']):
+        rms, kurtosis, peak_hz, peak_rms = axis[:4]
+        bands = ' '.join(f'{b:.1f}' for b in axis[4:])
+        print(f"  {name}: rms {rms:.1f} mg, kurtosis {kurtosis:.2f}, "
+              f"peak {peak_hz:.1f} Hz ({peak_rms:.1f} mg), bands [{bands}] mg^2")
+
 
 def main():
     fig, axes = plt.subplots(nrows=3, ncols=2, sharex=True,
@@ -31,6 +53,8 @@ def main():
     threshold = True
     init_flag = True
     count_flag = False
+    aggregator = metrics.MetricsAggregator()
+    ring = broadcast.Writer(BROADCAST) if BROADCAST else None
 
     with socket.socket(socket.AF_INET, socket.SOCK_STREAM) as s:
         # s.setsockopt(socket.SOL_SOCKET, socket.REUSEADDR, 1)
@@ -81,8 +105,24 @@ def main():
                             datas.append(j)
 
                         for data in datas:
+                            line = json.dumps(data)
+                            file.write(line + '\n')
+                            if ring:
+                                ring.publish(broadcast.JSON, line.encode())
+                            # vibration feature frames and anomaly snippets
+                            # are logged only, the plots are for raw samples
+                            if 'f' in data:
+                                print_features(data)
+                                continue
+                            # runtime metrics snapshot, every 10 s
+                            if 'm' in data:
+                                aggregator.update(data.get('id', addr[0]), data['m'])
+                                print(aggregator.report())
+                                continue
+                            if 'snip' in data:
+                                print(f"anomaly on axis {data['snip']}: {data['v']}")
+                                continue
                             data_count += 1
-                            file.write(json.dumps(data) + '\n')
                             json_data = data
                             # json_data = json.loads(data)
                             array_s.append(json_data['s'] * sample_rate)
@@ -95,11 +135,17 @@ def main():
                                 acce[i].append(acce_data[i])
                                 gyro[i].append(gyro_data[i])
 
+                        if ring:
+                            ring.notify()
+
                     except json.decoder.JSONDecodeError:
                         print("JSONDecodeError: more than one set of data!!!")
                         error_count += 1
                         continue
 
+                    if not array_s:
+                        continue
+
                     # plot acceleration of each direction
                     for i in range(3):
                         ax = axes[i][0]
@@ -17,11 +17,13 @@
 #include "mbed.h"
 // wifi module header
 #include "TCPSocket.h"
+#include "WiFiAccessPoint.h"
 // #include <cstdio>
 
 // sensor module header
 // Sensors drivers present in the BSP library
 #include "mbed_wait_api.h"
+#include "hal/us_ticker_api.h"
 #include "stm32l475e_iot01_tsensor.h"
 #include "stm32l475e_iot01_hsensor.h"
 #include "stm32l475e_iot01_psensor.h"
@@ -29,6 +31,23 @@
 #include "stm32l475e_iot01_gyro.h"
 #include "stm32l475e_iot01_accelero.h"
 
+#include "BlockDeviceFlash.h"
+#include "BootProfile.h"
+#include "DeferredLog.h"
+#include "DiscoL475Sensors.h"
+#include "FlashRingLog.h"
+#include "Int8Model.h"
+#include "LogThread.h"
+#include "Lsm6dslFifo.h"
+#include "Metrics.h"
+#include "MbedAsyncSocket.h"
+#include "MbedWifiRadio.h"
+#include "ParallelInit.h"
+#include "PoolAllocator.h"
+#include "TokenBucket.h"
+#include "VibrationFeatures.h"
+#include "WifiConnector.h"
+
 DigitalOut led(LED1);
 
 static BufferedSerial serial_port(USBTX, USBRX);
@@ -37,8 +56,90 @@ FileHandle *mbed::mbed_override_console(int fd)
     return &serial_port; 
 }
 
+static lab::LogThread log_thread(serial_port);
+
 #define WIFI_IDW0XX1    2
 
+// Maximum number of networks reported by scan_demo()
+#define SCAN_MAX_AP     15
+// Large enough for one JSON telemetry frame
+#define FRAME_SIZE      160
+#define BATCH_SIZE      512
+
+// Fixed-block pools for the network and sensor buffers, nothing below comes
+// from the heap. Frames stay in their block until the socket is done with
+// them, so each size class covers the transmit queue.
+static lab::BlockPool<FRAME_SIZE, 8> frame_pool;
+static lab::BlockPool<BATCH_SIZE, 8> batch_pool;
+static lab::BlockPool<SCAN_MAX_AP * sizeof(WiFiAccessPoint), 1> scan_pool;
+static lab::PoolAllocator buffers;
+
+// Vibration analysis: accelerometer through the LSM6DSL FIFO, one window
+// of 512 samples every 256 samples at 1.66 kHz
+#define VIBRATION_WINDOW    512
+#define VIBRATION_HOP       256
+#define DRAIN_SETS          128
+// Raw samples sent along with an axis flagged as anomalous
+#define SNIPPET_SAMPLES     48
+
+static lab::VibrationAnalyzer<VIBRATION_WINDOW, 3> vibration;
+
+#if MBED_CONF_APP_ACTIVITY_CLASSIFIER
+#include "ActivityModel.h"
+
+// Activity classification: the accelerometer at 50 Hz through the int8
+// model of lab-utils/ml, a window of 64 samples every 32 samples; only
+// the labels go to the host
+#define ACTIVITY_PERIOD     std::chrono::milliseconds(20)
+#define ACTIVITY_HOP        32
+
+static lab::Int8Classifier<lab::ACTIVITY_MODEL_ARENA, lab::ACTIVITY_MODEL_WINDOW> activity;
+static lab::Counter activity_windows("act.windows");
+static lab::Gauge activity_cycles("act.cycles");
+#endif
+
+// Telemetry host
+#define HOST_IP_ADDRESS     "192.168.50.252"
+#define HOST_PORT           30007
+
+// Frames sent while the link is down go to the first megabyte of the QSPI
+// flash and are replayed after reconnecting, at most 2 KB/s so the live
+// stream keeps going
+#define BACKLOG_START       0
+#define BACKLOG_SIZE        (1024 * 1024)
+#define REPLAY_RATE         2048
+#define RECONNECT_PERIOD    std::chrono::seconds(5)
+
+static lab::BlockDeviceFlash backlog_flash(*BlockDevice::get_default_instance());
+static lab::FlashRingLog<256> backlog(backlog_flash, BACKLOG_START, BACKLOG_SIZE);
+static lab::TokenBucket replay_budget(REPLAY_RATE, 512);
+static bool flash_ready = false;
+static bool backlog_ready = false;
+static bool link_up = false;
+static bool connecting = false;
+
+// Up to 8 frames wait for the socket; one send gathers 4 of them plus a
+// stored frame being replayed
+#define TX_DEPTH            8
+#define TX_GATHER           4
+#define CONNECT_TIMEOUT_MS  5000
+#define SEND_TIMEOUT_MS     2000
+
+struct TxFrame {
+    char *data;
+    int length;
+    // goes to the backlog if it cannot be sent
+    bool durable;
+};
+
+static TxFrame tx_frames[TX_DEPTH];
+static size_t tx_head = 0;
+static size_t tx_count = 0;
+static size_t tx_inflight = 0;
+static bool replay_inflight = false;
+static char replay_record[256];
+static lab::AsyncBuffer tx_gather[TX_GATHER + 1];
+
 #if (defined(TARGET_DISCO_L475VG_IOT01A) || defined(TARGET_DISCO_F413ZH))
 #include "ISM43362Interface.h"
 ISM43362Interface wifi(false);
@@ -52,6 +153,49 @@ SpwfSAInterface wifi(MBED_CONF_APP_WIFI_TX, MBED_CONF_APP_WIFI_RX);
 
 #endif
 
+// Sampling, socket events, timeouts and reconnects all run from this one
+// queue, so nothing ever waits on the modem
+static EventQueue app_queue(32 * EVENTS_EVENT_SIZE);
+static lab::MbedAsyncSocket host(&wifi, app_queue);
+
+// The last good AP sits in the flash sector after the backlog, so a reboot
+// goes straight back to it. A low priority thread rescans every minute to
+// rank the other APs of the SSID and moves to one 8 dB stronger; sends
+// hold off meanwhile, the module cannot do both.
+#define AP_CACHE_START      (BACKLOG_START + BACKLOG_SIZE)
+#define ROAM_SCAN_PERIOD    std::chrono::seconds(60)
+#define ROAM_MARGIN_DB      8
+
+static lab::ApCache ap_cache(backlog_flash, AP_CACHE_START);
+static lab::MbedWifiRadio radio(wifi, buffers);
+static lab::WifiConnector connector(radio, ap_cache, MBED_CONF_APP_WIFI_SSID, MBED_CONF_APP_WIFI_PASSWORD);
+static Thread scan_thread(osPriorityBelowNormal, 2048, nullptr, "wifi-scan");
+static EventFlags scan_flags;
+static bool scanning = false;
+static bool first_sample_sent = false;
+
+// Runtime metrics: 'm' on the console prints them, and every 10 s they
+// ride along the telemetry stream for server.py to aggregate per device
+#define METRICS_PERIOD      std::chrono::seconds(10)
+
+static lab::Counter sent_frames("tx.frames");
+static lab::Counter sent_bytes("tx.bytes");
+static lab::Counter send_errors("tx.errors");
+static lab::Counter stored_frames("tx.stored");
+static lab::Counter lost_frames("tx.lost");
+static lab::Counter replayed_frames("tx.replayed");
+static lab::Counter host_connects("net.connects");
+static lab::Gauge tx_queue_depth("tx.queue");
+static lab::Gauge backlog_depth("backlog.pages");
+static lab::Gauge cpu_load("cpu.load_pct");
+static const uint32_t latency_bounds_ms[] = { 10, 20, 50, 100, 200, 500, 1000 };
+static lab::Histogram<7> send_latency("tx.latency_ms", latency_bounds_ms);
+static uint32_t send_started_us;
+
+// Results of the init tasks, see main()
+static int wifi_status = NSAPI_ERROR_NO_CONNECTION;
+static int sensor_status = -1;
+
 const char *sec2str(nsapi_security_t sec)
 {
     switch (sec) {
@@ -73,18 +217,20 @@ const char *sec2str(nsapi_security_t sec)
 
 int scan_demo(WiFiInterface *wifi)
 {
-    WiFiAccessPoint *ap;
-
     printf("Scan:\n");
 
     int count = wifi->scan(NULL,0);
     printf("%d networks available.\n", count);
 
     /* Limit number of network arbitrary to 15 */
-    count = count < 15 ? count : 15;
+    count = count < SCAN_MAX_AP ? count : SCAN_MAX_AP;
 
-    ap = new WiFiAccessPoint[count];
-    count = wifi->scan(ap, count);
+    lab::PoolArray<WiFiAccessPoint> ap(buffers, count);
+    if (!ap) {
+        printf("No buffer for scan results\n");
+        return 0;
+    }
+    count = wifi->scan(ap.data(), count);
     for (int i = 0; i < count; i++)
     {
         printf("Network: %s secured: %s BSSID: %hhX:%hhX:%hhX:%hhx:%hhx:%hhx RSSI: %hhd Ch: %hhd\n", ap[i].get_ssid(),
@@ -92,7 +238,6 @@ int scan_demo(WiFiInterface *wifi)
                ap[i].get_bssid()[3], ap[i].get_bssid()[4], ap[i].get_bssid()[5], ap[i].get_rssi(), ap[i].get_channel());
     }
 
-    delete[] ap;
     return count;
 }
 
@@ -161,39 +306,421 @@ void http_demo(NetworkInterface *net)
     socket.close();
 }
 
-void send_sensor_data(NetworkInterface *net)
+void backlog_init()
 {
-    TCPSocket socket;
-    nsapi_error_t response;
+    if (!flash_ready || backlog.mount()) {
+        printf("No flash backlog, data is lost while the link is down\n");
+        return;
+    }
+    backlog_ready = true;
+    printf("Flash backlog: %lu pages to replay\n", (unsigned long)backlog.backlog_pages());
+}
 
-    printf("Sending data to host computer...\n");
+void tx_pump();
 
-    // Open a socket on the network interface, and create a TCP connection to www.arm.com
+void store_frame(const TxFrame &frame)
+{
+    if (!frame.durable || !backlog_ready) {
+        lost_frames.inc();
+    } else if (backlog.append(frame.data, frame.length)) {
+        LAB_LOG_WARN("Frame of %d bytes not stored", frame.length);
+        lost_frames.inc();
+    } else {
+        stored_frames.inc();
+    }
+}
 
-    // Show the network address
-    SocketAddress a;
-    const char * IP_ADDRESS = "192.168.50.252";
-    // Open a socket on the network interface, and create a TCP connection to //www.arm.com
-    socket.open(net); 
-    if(!a.set_ip_address(IP_ADDRESS)) {
-        printf("Set IP address failed");
-        return ;
+// Release the oldest frames of the queue, optionally keeping them in flash
+void tx_drop(size_t count, bool store)
+{
+    for (size_t i = 0; i < count; i++) {
+        TxFrame &frame = tx_frames[tx_head];
+        if (store) {
+            store_frame(frame);
+        }
+        buffers.free(frame.data);
+        tx_head = (tx_head + 1) % TX_DEPTH;
+        tx_count--;
     }
+    tx_queue_depth.set(tx_count);
+}
 
-    a.set_port(30007);
-    
-    response = socket.connect(a);
+void on_host_connected(void *, int result);
 
-    if(0 != response) {
-        printf("Error connecting: %d\n", response);
-        socket.close();
+void connect_host()
+{
+    // a running scan calls again when it is done
+    if (connecting || link_up || scanning) {
+        return;
+    }
+    connecting = true;
+    host.close();
+    if (host.connect(HOST_IP_ADDRESS, HOST_PORT, CONNECT_TIMEOUT_MS, on_host_connected, nullptr)) {
+        connecting = false;
+        app_queue.call_in(RECONNECT_PERIOD, connect_host);
+    }
+}
+
+void on_host_connected(void *, int result)
+{
+    connecting = false;
+    if (result != lab::ASYNC_OK) {
+        LAB_LOG_WARN("Error connecting: %d", result);
+        host.close();
+        app_queue.call_in(RECONNECT_PERIOD, connect_host);
+        return;
+    }
+    link_up = true;
+    host_connects.inc();
+    LAB_LOG_INFO("Link up, %d pages to replay", backlog_ready ? (int)backlog.backlog_pages() : 0);
+    tx_pump();
+}
+
+void on_tx_done(void *, int result)
+{
+    size_t frames = tx_inflight;
+    bool replayed = replay_inflight;
+    tx_inflight = 0;
+    replay_inflight = false;
+
+    if (result < 0) {
+        // frames of a failed send may have partly arrived, the host sees
+        // them again from the backlog
+        LAB_LOG_WARN("Link lost (%d), storing frames in flash", result);
+        send_errors.inc();
+        link_up = false;
+        host.close();
+        tx_drop(tx_count, true);
+        app_queue.call_in(RECONNECT_PERIOD, connect_host);
+        return;
+    }
+
+    if (!first_sample_sent && frames) {
+        first_sample_sent = true;
+        lab::BootProfile::mark("first-sample");
+        LAB_LOG_INFO("First sample sent %d ms after boot",
+                     (int)std::chrono::duration_cast<std::chrono::milliseconds>(Kernel::Clock::now().time_since_epoch()).count());
+        lab::BootProfile::dump();
+    }
+
+    sent_frames.inc(frames);
+    sent_bytes.inc(result);
+    send_latency.record((us_ticker_read() - send_started_us) / 1000);
+
+    tx_drop(frames, false);
+    if (replayed) {
+        backlog.consume();
+        replayed_frames.inc();
+    }
+    tx_pump();
+}
+
+void roam_scan_done(int result)
+{
+    scanning = false;
+    if (result > 0) {
+        // new association, new address: the host connection is stale
+        LAB_LOG_INFO("Joined AP on channel %d", ap_cache.last_good() ? ap_cache.last_good()->channel : 0);
+        if (link_up) {
+            link_up = false;
+            host.close();
+            tx_drop(tx_count, true);
+        }
+    } else if (result < 0) {
+        LAB_LOG_WARN("No WiFi link: %d", result);
+    }
+    connect_host();
+    tx_pump();
+}
+
+// On app_queue: start a background scan once no send is in flight
+void start_roam_scan()
+{
+    if (scanning) {
+        return;
+    }
+    if (host.sending() || connecting) {
+        app_queue.call_in(std::chrono::milliseconds(100), start_roam_scan);
+        return;
+    }
+    scanning = true;
+    scan_flags.set(1);
+}
+
+void scan_loop()
+{
+    while (true) {
+        scan_flags.wait_any(1);
+        int result = connector.maintain(ROAM_MARGIN_DB);
+        app_queue.call(roam_scan_done, result);
+    }
+}
+
+// Start the next gathered send if the socket is idle
+void tx_pump()
+{
+    if (!link_up || host.sending() || scanning) {
+        return;
+    }
+
+    size_t count = 0;
+    while (count < TX_GATHER && count < tx_count) {
+        const TxFrame &frame = tx_frames[(tx_head + count) % TX_DEPTH];
+        tx_gather[count++] = { frame.data, (size_t)frame.length };
+    }
+    tx_inflight = count;
+
+    // stored frames ride along within the replay budget; a replayed
+    // record completes the next pump, so replay goes on at that rate
+    // even between live frames
+    if (backlog_ready && !backlog.empty()) {
+        int len = backlog.peek(replay_record, sizeof(replay_record));
+        if (len > 0 && replay_budget.take(len, us_ticker_read())) {
+            tx_gather[count++] = { replay_record, (size_t)len };
+            replay_inflight = true;
+        }
+    }
+
+    send_started_us = us_ticker_read();
+    if (count && host.send(tx_gather, count, SEND_TIMEOUT_MS, on_tx_done, nullptr)) {
+        tx_inflight = 0;
+        replay_inflight = false;
+    }
+}
+
+// Queue one telemetry frame; the queue takes the buffer over. Durable
+// frames go to flash while the link is down or the queue is full.
+void telemetry_send(lab::PoolBuffer &buffer, int len, bool durable)
+{
+    TxFrame frame = { static_cast<char *>(buffer.release()), len, durable };
+
+    if (!link_up || tx_count == TX_DEPTH) {
+        store_frame(frame);
+        buffers.free(frame.data);
+        return;
+    }
+
+    tx_frames[(tx_head + tx_count) % TX_DEPTH] = frame;
+    tx_count++;
+    tx_queue_depth.set(tx_count);
+    tx_pump();
+}
+
+void update_gauges()
+{
+    backlog_depth.set(backlog_ready ? backlog.backlog_pages() : 0);
+#if MBED_CPU_STATS_ENABLED
+    static uint64_t last_idle_us = 0;
+    static uint64_t last_uptime_us = 0;
+    mbed_stats_cpu_t stats;
+    mbed_stats_cpu_get(&stats);
+    uint64_t uptime = stats.uptime - last_uptime_us;
+    if (uptime) {
+        cpu_load.set(100 - (int32_t)((stats.idle_time - last_idle_us) * 100 / uptime));
+    }
+    last_idle_us = stats.idle_time;
+    last_uptime_us = stats.uptime;
+#endif
+}
+
+void send_metrics()
+{
+    update_gauges();
+
+    lab::PoolBuffer frame(buffers, BATCH_SIZE);
+    if (!frame) {
+        return;
+    }
+    char *buffer = frame.as<char>();
+    int len = snprintf(buffer, frame.size(), "{\"id\":\"%s\",\"m\":", wifi.get_mac_address());
+    int metrics = lab::MetricsRegistry::format_json(buffer + len, frame.size() - len - 1);
+    if (metrics < 0) {
+        LAB_LOG_WARN("Metrics do not fit a frame");
         return;
     }
+    len += metrics;
+    buffer[len++] = '}';
+    // counters are cumulative, the next snapshot makes up for a lost one
+    telemetry_send(frame, len, false);
+}
+
+// Console commands, polled: the log thread owns the serial port in
+// blocking mode, a read only happens once a byte is waiting
+void console_tick()
+{
+    static char text[512];
+    char command;
+
+    while (serial_port.readable() && serial_port.read(&command, 1) == 1) {
+        if (command == 'm') {
+            update_gauges();
+            if (lab::MetricsRegistry::format_text(text, sizeof(text)) > 0) {
+                printf("%s", text);
+            }
+        }
+    }
+}
+
+#if MBED_CONF_APP_VIBRATION_FEATURES
+int send_vibration_snippet(int axis)
+{
+    int16_t raw[SNIPPET_SAMPLES];
+    size_t count = vibration.snippet(axis, raw, SNIPPET_SAMPLES);
+
+    lab::PoolBuffer frame(buffers, BATCH_SIZE);
+    if (!frame) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    char *buffer = frame.as<char>();
+    int len = snprintf(buffer, frame.size(), "{\"snip\":%d,\"t\":%lu,\"v\":[", axis,
+                       (unsigned long)vibration.features().timestamp_us);
+    for (size_t i = 0; i < count && len < (int)frame.size(); i++) {
+        len += snprintf(buffer + len, frame.size() - len, i ? ",%d" : "%d", raw[i]);
+    }
+    if (len >= (int)frame.size() - 2) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    len += snprintf(buffer + len, frame.size() - len, "]}");
+    // snippets are too large for the backlog, only sent live
+    telemetry_send(frame, len, false);
+    return len;
+}
+
+int send_vibration_features()
+{
+    const lab::VibrationFeatures &features = vibration.features();
 
-    float sensor_value = 0;
+    lab::PoolBuffer frame(buffers, BATCH_SIZE);
+    if (!frame) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    char *buffer = frame.as<char>();
+    int len = snprintf(buffer, frame.size(), "{\"t\":%lu,\"s\":%u,\"an\":%u,\"f\":[",
+                       (unsigned long)features.timestamp_us, features.sequence, features.anomaly);
+    for (int a = 0; a < features.axis_count && len < (int)frame.size(); a++) {
+        const lab::AxisFeatures &axis = features.axis[a];
+        len += snprintf(buffer + len, frame.size() - len, "%s[%.1f,%.2f,%.1f,%.1f",
+                        a ? "," : "", axis.rms, axis.kurtosis, axis.peak_hz, axis.peak_rms);
+        for (int b = 0; b < features.band_count && len < (int)frame.size(); b++) {
+            len += snprintf(buffer + len, frame.size() - len, ",%.1f", axis.band_energy[b]);
+        }
+        if (len < (int)frame.size()) {
+            len += snprintf(buffer + len, frame.size() - len, "]");
+        }
+    }
+    if (len >= (int)frame.size() - 2) {
+        return NSAPI_ERROR_NO_MEMORY;
+    }
+    len += snprintf(buffer + len, frame.size() - len, "]}");
+    telemetry_send(frame, len, true);
+    return len;
+}
+
+static lab::Lsm6dslFifo imu_fifo(lab::disco_l475_imu_bus());
+
+void vibration_tick()
+{
+    static lab::ImuSample samples[DRAIN_SETS];
+    lab::ImuBatch batch;
+
+    int count = imu_fifo.drain(samples, DRAIN_SETS, us_ticker_read(), batch);
+    if (count < 0) {
+        LAB_LOG_WARN("FIFO read error");
+        return;
+    }
+    if (batch.overrun) {
+        LAB_LOG_WARN("FIFO overrun, restarting vibration windows");
+        vibration.reset();
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (!vibration.push(samples[i].accel, batch.timestamp_us(i))) {
+            continue;
+        }
+
+        int response = send_vibration_features();
+        if (0 >= response) {
+            LAB_LOG_WARN("Error sending features %d: %d", vibration.features().sequence, response);
+        }
+        for (int axis = 0; axis < 3 && link_up; axis++) {
+            if (vibration.features().anomaly & (1 << axis)) {
+                send_vibration_snippet(axis);
+            }
+        }
+    }
+}
+
+// Runs on an init thread while the WiFi module connects
+void vibration_init()
+{
+    lab::Lsm6dslFifoConfig fifo_config;
+    fifo_config.odr = lab::LSM6DSL_ODR_1660HZ;
+    fifo_config.watermark = 64;
+    fifo_config.accel_scale = lab::LSM6DSL_ACCEL_4G;
+    fifo_config.gyro_scale = lab::LSM6DSL_GYRO_2000DPS;
+    sensor_status = imu_fifo.configure(fifo_config);
+    if (sensor_status) {
+        printf("LSM6DSL FIFO init failed\n");
+        return;
+    }
+
+    // features in mg; kurtosis above 6 catches impacts and bearing defects
+    lab::VibrationConfig config = {};
+    config.sample_rate_hz = 1660.0f;
+    config.hop = VIBRATION_HOP;
+    config.scale = imu_fifo.accel_mg_per_lsb();
+    config.band_count = 3;
+    config.bands[0] = { 10.0f, 100.0f };
+    config.bands[1] = { 100.0f, 300.0f };
+    config.bands[2] = { 300.0f, 830.0f };
+    config.kurtosis_threshold = 6.0f;
+    vibration.configure(config);
+}
+
+int start_vibration_data()
+{
+    if (sensor_status) {
+        return sensor_status;
+    }
+
+    printf("Sending vibration features to host computer...\n");
+
+    // 1.66 kHz fills about 33 sets in 20 ms, the FIFO holds 340; the first
+    // drain finds it overrun by the connect time and restarts the windows
+    app_queue.call_every(std::chrono::milliseconds(20), vibration_tick);
+    return 0;
+}
+#endif // MBED_CONF_APP_VIBRATION_FEATURES
+
+void sensor_tick()
+{
+    static int count = 0;
     int16_t pDataXYZ[3] = {0};
     float pGyroDataXYZ[3] = {0};
 
+    count++;
+    LAB_LOG_DEBUG("Sending sample %d to the server", count);
+    lab::PoolBuffer frame(buffers, FRAME_SIZE);
+    if (!frame) {
+        LAB_LOG_WARN("No frame buffer for sample %d", count);
+        return;
+    }
+    char *buffer = frame.as<char>();
+
+    // Gyro
+    BSP_GYRO_GetXYZ(pGyroDataXYZ);
+
+    // acceleration
+    BSP_ACCELERO_AccGetXYZ(pDataXYZ);
+    int len = snprintf(buffer, frame.size(), "{\"a_x\":%d,\"a_y\":%d,\"a_z\":%d,\"g_x\":%.2f,\"g_y\":%.2f,\"g_z\":%.2f,\"s\":%d}",
+    pDataXYZ[0], pDataXYZ[1], pDataXYZ[0], pGyroDataXYZ[0], pGyroDataXYZ[1], pGyroDataXYZ[2], count);
+
+    telemetry_send(frame, len, true);
+}
+
+// Runs on an init thread while the WiFi module connects
+void sensor_init()
+{
     printf("Start sensor init\n");
 
     BSP_TSENSOR_Init();
@@ -203,37 +730,90 @@ void send_sensor_data(NetworkInterface *net)
     BSP_MAGNETO_Init();
     BSP_GYRO_Init();
     BSP_ACCELERO_Init();
-    int count = 0;
-
-    while(1) {
-        count++;
-        printf("\nSending data to the server ........\n");
-        char buffer[1024] = {0}; 
+    sensor_status = 0;
+}
 
-        // Gyro
-        BSP_GYRO_GetXYZ(pGyroDataXYZ);
+#if MBED_CONF_APP_ACTIVITY_CLASSIFIER
+void activity_tick()
+{
+    int16_t xyz[3] = {0};
+    BSP_ACCELERO_AccGetXYZ(xyz);
 
-        // acceleration
-        BSP_ACCELERO_AccGetXYZ(pDataXYZ);
-        int len = sprintf(buffer,"{\"a_x\":%d,\"a_y\":%d,\"a_z\":%d,\"g_x\":%.2f,\"g_y\":%.2f,\"g_z\":%.2f,\"s\":%d}",
-        pDataXYZ[0], pDataXYZ[1], pDataXYZ[0], pGyroDataXYZ[0], pGyroDataXYZ[1], pGyroDataXYZ[2], count);
+    uint32_t start = lab::BootProfile::cycles();
+    if (!activity.push(xyz)) {
+        return;
+    }
+    activity_cycles.set((int32_t)(lab::BootProfile::cycles() - start));
+    activity_windows.inc();
 
-        response = socket.send(buffer,len); 
-        if (0 >= response){
-            printf("Error seding: %d\n", response); 
-        }
+    const lab::Int8Classification &result = activity.result();
+    lab::PoolBuffer frame(buffers, FRAME_SIZE);
+    if (!frame) {
+        LAB_LOG_WARN("No frame buffer for window %lu", (unsigned long)result.sequence);
+        return;
+    }
+    int len = snprintf(frame.as<char>(), frame.size(), "{\"act\":\"%s\",\"c\":%u,\"s\":%lu}",
+                       activity.model().label(result.label), result.confidence, (unsigned long)result.sequence);
+    telemetry_send(frame, len, true);
+}
+#endif
 
-        ThisThread::sleep_for(100);
+int start_sensor_data()
+{
+#if MBED_CONF_APP_ACTIVITY_CLASSIFIER
+    if (activity.load(lab::activity_model, sizeof(lab::activity_model), ACTIVITY_HOP)) {
+        printf("Activity model rejected\n");
+        return -1;
     }
+    printf("Sending activity labels to host computer...\n");
 
-    socket.close();
+    app_queue.call_every(ACTIVITY_PERIOD, activity_tick);
+#else
+    printf("Sending data to host computer...\n");
+
+    app_queue.call_every(std::chrono::milliseconds(100), sensor_tick);
+#endif
+    return 0;
 }
 
 
+void wifi_init()
+{
+    // cached AP first, full scan only if it is gone
+    ap_cache.load();
+    wifi_status = connector.connect();
+}
+
 int main() 
 {
+    lab::BootProfile::begin();
+
     // wifi variables
     int count = 0;
+
+    log_thread.start();
+
+    buffers.add(frame_pool);
+    buffers.add(batch_pool);
+    buffers.add(scan_pool);
+
+    {
+        lab::BootPhase phase("qspi");
+        flash_ready = backlog_flash.init() == 0;
+    }
+
+    // The association takes seconds; the sensors (I2C2) and the backlog
+    // scan (QSPI) do not need the module (SPI3) and come up meanwhile
+    lab::ParallelInit init;
+    init.add(0, "wifi", wifi_init);
+#if MBED_CONF_APP_VIBRATION_FEATURES
+    init.add(1, "imu-fifo", vibration_init);
+#else
+    init.add(1, "sensors", sensor_init);
+#endif
+    init.add(2, "backlog", backlog_init);
+    Kernel::Clock::time_point connect_start = Kernel::Clock::now();
+    init.run();
     
     // scan wifi
     // count = scan_demo(&wifi); 
@@ -243,14 +823,17 @@ int main()
     // }
 
     // printf("\nConnecting to %s...\n", MBED_CONF_APP_WIFI_SSID);
-    int ret = wifi.connect(MBED_CONF_APP_WIFI_SSID, MBED_CONF_APP_WIFI_PASSWORD, NSAPI_SECURITY_WPA_WPA2); 
+    int ret = wifi_status;
     
     if (ret != 0) {
         printf("\nConnection error\n");
+        lab::BootProfile::dump();
         return -1; 
     }
 
-    printf("Success\n\n");
+    static const char *const paths[] = { "none", "cached AP", "scan", "module search" };
+    printf("Success via %s in %d ms\n\n", paths[connector.path()],
+           (int)std::chrono::duration_cast<std::chrono::milliseconds>(Kernel::Clock::now() - connect_start).count());
     printf("MAC: %s\n", wifi.get_mac_address()); 
     printf("IP: %s\n", wifi.get_ip_address()); 
     printf("Netmask: %s\n", wifi.get_netmask()); 
@@ -259,7 +842,22 @@ int main()
     
 
     // http_demo(&wifi);
-    send_sensor_data(&wifi);
+
+    // without the host the frames go to flash until it comes back
+    lab::BootProfile::mark("ready");
+    connect_host();
+    scan_thread.start(scan_loop);
+    app_queue.call_every(ROAM_SCAN_PERIOD, start_roam_scan);
+    app_queue.call_every(METRICS_PERIOD, send_metrics);
+    app_queue.call_every(std::chrono::milliseconds(200), console_tick);
+#if MBED_CONF_APP_VIBRATION_FEATURES
+    ret = start_vibration_data();
+#else
+    ret = start_sensor_data();
+#endif
+    if (ret == 0) {
+        app_queue.dispatch_forever();
+    }
     printf("sensor data complete");
     wifi.disconnect();
     printf("\nDone\n"); 